@@ -0,0 +1,99 @@
+#!/usr/bin/env python
+##===--- compare_perf_tests.py --------------------------------------------===##
+##
+## This source file is part of the Swift.org open source project
+##
+## Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+## Licensed under Apache License v2.0 with Runtime Library Exception
+##
+## See http://swift.org/LICENSE.txt for license information
+## See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+##
+##===----------------------------------------------------------------------===##
+
+# Compares two runs of a benchmark driver, as written by `Benchmark_O --json`.
+#
+# A benchmark is compared by its minimum time per iteration, which is the
+# sample least disturbed by other activity on the machine. A change is only
+# reported if it is larger than the threshold and larger than the spread of
+# the samples of both runs, so that noisy benchmarks don't flag spurious
+# regressions.
+#
+# The exit status is 1 if any benchmark regressed.
+
+from __future__ import print_function
+
+import argparse
+import json
+import sys
+
+
+def load_results(path):
+    with open(path) as f:
+        data = json.load(f)
+    return dict((r['name'], r) for r in data['results'])
+
+
+def noise(result):
+    # The spread between the fastest and the median sample, relative to the
+    # fastest one.
+    if result['min'] <= 0:
+        return 0.0
+    return (result['median'] - result['min']) / result['min']
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare two benchmark runs and flag regressions.')
+    parser.add_argument('old', help='JSON results of the baseline run')
+    parser.add_argument('new', help='JSON results of the run to check')
+    parser.add_argument(
+        '--threshold', type=float, default=0.05,
+        help='the relative change below which results are considered equal '
+             '(default: 0.05)')
+    args = parser.parse_args()
+
+    old = load_results(args.old)
+    new = load_results(args.new)
+
+    regressions = []
+    improvements = []
+    unchanged = []
+    for name in sorted(set(old) & set(new)):
+        old_min = old[name]['min']
+        new_min = new[name]['min']
+        ratio = new_min / old_min if old_min > 0 else 1.0
+        margin = max(args.threshold, noise(old[name]), noise(new[name]))
+        row = (name, old_min, new_min, ratio)
+        if ratio > 1 + margin:
+            regressions.append(row)
+        elif ratio < 1 - margin:
+            improvements.append(row)
+        else:
+            unchanged.append(row)
+
+    def print_rows(title, rows):
+        if not rows:
+            return
+        print('%s:' % title)
+        print('%-24s %14s %14s %8s' % ('TEST', 'OLD_MIN(us)', 'NEW_MIN(us)',
+                                       'NEW/OLD'))
+        for name, old_min, new_min, ratio in rows:
+            print('%-24s %14.3f %14.3f %8.3f' % (name, old_min, new_min,
+                                                  ratio))
+        print()
+
+    print_rows('Regressions', regressions)
+    print_rows('Improvements', improvements)
+    print_rows('No significant change', unchanged)
+
+    for name in sorted(set(old) - set(new)):
+        print('Removed: %s' % name)
+    for name in sorted(set(new) - set(old)):
+        print('Added: %s' % name)
+
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,183 @@
+#!/usr/bin/env python
+##===--- compile_time_benchmarks.py ---------------------------------------===##
+##
+## This source file is part of the Swift.org open source project
+##
+## Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+## Licensed under Apache License v2.0 with Runtime Library Exception
+##
+## See http://swift.org/LICENSE.txt for license information
+## See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+##
+##===----------------------------------------------------------------------===##
+
+# Measures how long the frontend takes to compile each input of the
+# compile-time corpus in benchmark/compile-time.
+#
+# Each input is a gyb template, which is expanded with -Dscale=<scale> and
+# then compiled with `swift -frontend -c` a few times. For every input the
+# script reports:
+#   o the wall time of the whole compile, as "min" and "median" over the runs,
+#     so that the output can be read by compare_perf_tests.py;
+#   o the time of each frontend phase, from -trace-events-path;
+#   o the peak resident memory of the frontend process;
+#   o the counters printed by -print-stats, including the constraint solver's
+#     CS_STATISTIC counters. These are only collected by compilers built with
+#     assertions, and are left out otherwise.
+#
+# All times are in microseconds.
+
+from __future__ import print_function
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCHMARK_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CORPUS_DIR = os.path.join(BENCHMARK_DIR, 'compile-time')
+GYB = os.path.join(os.path.dirname(BENCHMARK_DIR), 'utils', 'gyb.py')
+
+# A line of llvm::PrintStatistics output: "<value> <category> - <description>"
+STATISTIC_RE = re.compile(r'^\s*(\d+)\s+(.+?)\s+-\s+(.+?)\s*$')
+
+
+def expand_template(template, scale, output):
+    subprocess.check_call([sys.executable, GYB, '-Dscale=%d' % scale,
+                           '--line-directive=', '-o', output, template])
+
+
+def parse_statistics(text):
+    stats = {}
+    for line in text.splitlines():
+        m = STATISTIC_RE.match(line)
+        if m:
+            stats['%s - %s' % (m.group(2), m.group(3))] = int(m.group(1))
+    return stats
+
+
+def parse_phases(trace_path):
+    phases = {}
+    with open(trace_path) as f:
+        for event in json.load(f):
+            name = event['name']
+            phases[name] = phases.get(name, 0) + event['dur']
+    return phases
+
+
+def max_rss_bytes(usage):
+    # ru_maxrss is in kilobytes on Linux and in bytes on Darwin.
+    if sys.platform == 'darwin':
+        return usage.ru_maxrss
+    return usage.ru_maxrss * 1024
+
+
+def compile_once(args, source, tmpdir):
+    trace_path = os.path.join(tmpdir, 'trace.json')
+    command = [args.swift, '-frontend', '-c', args.opt, '-primary-file',
+               source, '-module-name', 'main', '-o', os.devnull,
+               '-trace-events-path', trace_path, '-print-stats']
+    command += args.frontend_args
+
+    start = time.time()
+    with open(os.path.join(tmpdir, 'stderr.txt'), 'w+') as stderr:
+        process = subprocess.Popen(command, stdout=stderr, stderr=stderr)
+        _, status, usage = os.wait4(process.pid, 0)
+        wall = int((time.time() - start) * 1000000)
+        stderr.seek(0)
+        output = stderr.read()
+
+    if status != 0:
+        sys.stderr.write(output)
+        raise RuntimeError('failed to compile %s' % source)
+
+    return {
+        'wall': wall,
+        'phases': parse_phases(trace_path),
+        'max_rss': max_rss_bytes(usage),
+        'stats': parse_statistics(output),
+    }
+
+
+def run_benchmark(args, template, tmpdir):
+    name = os.path.basename(template)[:-len('.swift.gyb')]
+    source = os.path.join(tmpdir, name + '.swift')
+    expand_template(template, args.scale, source)
+
+    runs = [compile_once(args, source, tmpdir) for _ in range(args.repeat)]
+    walls = sorted(r['wall'] for r in runs)
+    phase_names = set()
+    for r in runs:
+        phase_names.update(r['phases'])
+
+    return {
+        'name': name,
+        'scale': args.scale,
+        'min': walls[0],
+        'median': walls[len(walls) // 2],
+        # Each phase is the fastest of the runs, to filter out noise.
+        'phases': dict((p, min(r['phases'].get(p, 0) for r in runs))
+                       for p in phase_names),
+        'max_rss': max(r['max_rss'] for r in runs),
+        # The counters don't vary between runs.
+        'stats': runs[0]['stats'],
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure frontend time and memory on the compile-time '
+                    'benchmark corpus.')
+    parser.add_argument('--swift', required=True,
+                        help='the swift driver binary to run as a frontend')
+    parser.add_argument('--scale', type=int, default=1,
+                        help='how much to grow each input (default: 1)')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='the number of compiles per input (default: 3)')
+    parser.add_argument('--opt', default='-O', choices=['-Onone', '-O'],
+                        help='the optimization level (default: -O)')
+    parser.add_argument('--output', help='write the JSON results to this file '
+                                         'instead of stdout')
+    parser.add_argument('benchmarks', nargs='*',
+                        help='the inputs to compile (default: all). '
+                             'Arguments after "--" are passed to the '
+                             'frontend.')
+
+    argv = sys.argv[1:]
+    frontend_args = []
+    if '--' in argv:
+        frontend_args = argv[argv.index('--') + 1:]
+        argv = argv[:argv.index('--')]
+    args = parser.parse_args(argv)
+    args.frontend_args = frontend_args
+
+    templates = sorted(glob.glob(os.path.join(CORPUS_DIR, '*.swift.gyb')))
+    if args.benchmarks:
+        templates = [t for t in templates
+                     if os.path.basename(t)[:-len('.swift.gyb')]
+                     in args.benchmarks]
+
+    tmpdir = tempfile.mkdtemp()
+    try:
+        results = [run_benchmark(args, t, tmpdir) for t in templates]
+    finally:
+        shutil.rmtree(tmpdir)
+
+    text = json.dumps({'unit': 'us', 'results': results}, indent=2,
+                      sort_keys=True)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text + '\n')
+    else:
+        print(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,43 @@
+//===--- Ackermann.swift --------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+// The Ackermann function, from the "Great Computer Language Shootout".
+
+func ackermann(M: Int, _ N: Int) -> Int {
+  if M == 0 {
+    return N + 1
+  }
+  if N == 0 {
+    return ackermann(M - 1, 1)
+  }
+  return ackermann(M - 1, ackermann(M, N - 1))
+}
+
+@inline(never)
+func callAckermann(M: Int, _ N: Int) -> Int {
+  return ackermann(M, N)
+}
+
+@inline(never)
+public func run_Ackermann(N: Int) {
+  // ackermann(3, n) is 2^(n+3) - 3.
+  let (m, n) = (3, 7)
+  var result = 0
+  for _ in 1...N {
+    result = callAckermann(m, n)
+    if result != (1 << (n + 3)) - 3 {
+      break
+    }
+  }
+  CheckResults(result == (1 << (n + 3)) - 3,
+               "Incorrect result in Ackermann: \(result)")
+}
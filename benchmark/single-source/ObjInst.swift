@@ -0,0 +1,79 @@
+//===--- ObjInst.swift ----------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+// Object instantiation, from the "Great Computer Language Shootout".
+// http://dada.perl.it/shootout/objinst_allsrc.html
+
+class Toggle {
+  var state: Bool = true
+
+  init(startState: Bool) {
+    state = startState
+  }
+
+  func value() -> Bool {
+    return state
+  }
+
+  func activate() -> Toggle {
+    state = !state
+    return self
+  }
+}
+
+final class NthToggle : Toggle {
+  var countMax: Int = 0
+  var counter: Int = 0
+
+  init(startState: Bool, maxCounter: Int) {
+    super.init(startState: startState)
+    countMax = maxCounter
+    counter = 0
+  }
+
+  override func activate() -> NthToggle {
+    counter += 1
+    if counter >= countMax {
+      state = !state
+      counter = 0
+    }
+    return self
+  }
+}
+
+@inline(never)
+func objInst(n: Int) -> Bool {
+  let toggle1 = Toggle(startState: true)
+  for _ in 0..<5 {
+    toggle1.activate()
+  }
+  for _ in 0..<n {
+    let _ = Toggle(startState: true)
+  }
+
+  let ntoggle1 = NthToggle(startState: true, maxCounter: 3)
+  for _ in 0..<8 {
+    ntoggle1.activate()
+  }
+  for _ in 0..<n {
+    let _ = NthToggle(startState: true, maxCounter: 3)
+  }
+  return toggle1.value() != ntoggle1.value()
+}
+
+@inline(never)
+public func run_ObjInst(N: Int) {
+  for _ in 1...N {
+    // After 5 activations toggle1 is false; after 8, ntoggle1 flipped twice.
+    CheckResults(objInst(100_000), "Incorrect result in ObjInst")
+  }
+}
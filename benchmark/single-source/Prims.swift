@@ -0,0 +1,277 @@
+//===--- Prims.swift ------------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+// Prim's minimum spanning tree algorithm on a random sparse graph, using a
+// binary heap with a decrease-key operation.
+
+struct Node {
+  var id: Int
+  var adjList: [Int]
+
+  init(i: Int) {
+    id = i
+    adjList = [Int]()
+  }
+}
+
+struct NodeCost {
+  var nodeId: Int
+  var cost: Double
+}
+
+func getLeftChildIndex(index: Int) -> Int {
+  return index * 2 + 1
+}
+
+func getRightChildIndex(index: Int) -> Int {
+  return (index + 1) * 2
+}
+
+func getParentIndex(childIndex: Int) -> Int {
+  return (childIndex - 1) / 2
+}
+
+final class PriorityQueue {
+  var heap: [NodeCost]
+  var graphIndexToHeapIndexMap: [Int?]
+
+  init() {
+    heap = [NodeCost]()
+    graphIndexToHeapIndexMap = [Int?]()
+  }
+
+  // This should only be called when initializing an uninitialized queue.
+  func append(n: NodeCost) {
+    graphIndexToHeapIndexMap.append(heap.count)
+    heap.append(n)
+  }
+
+  // Pop off the smallest cost element, updating all data structures along the
+  // way.
+  func popHeap() -> NodeCost {
+    // If we only have one element, just return it.
+    if heap.count == 1 {
+      graphIndexToHeapIndexMap[heap[0].nodeId] = nil
+      return heap.removeLast()
+    }
+
+    // Otherwise swap the heap head with the last element of the heap and pop
+    // the heap.
+    swap(&heap[0], &heap[heap.count - 1])
+    let result = heap.removeLast()
+
+    // Invalidate the graph index of our old head and update the graph index of
+    // the new head value.
+    graphIndexToHeapIndexMap[heap[0].nodeId] = 0
+    graphIndexToHeapIndexMap[result.nodeId] = nil
+
+    // Re-establish the heap property.
+    var heapIndex = 0
+    while true {
+      let smallestIndex = updateHeapAtIndex(heapIndex)
+      if smallestIndex == heapIndex {
+        break
+      }
+      heapIndex = smallestIndex
+    }
+
+    return result
+  }
+
+  func updateCostIfLessThan(graphIndex: Int, _ newCost: Double) -> Bool {
+    // If the graph index is not in the heap, return false.
+    guard var heapIndex = graphIndexToHeapIndexMap[graphIndex] else {
+      return false
+    }
+
+    // If newCost >= the current cost, don't update anything.
+    if newCost >= heap[heapIndex].cost {
+      return false
+    }
+
+    // Otherwise lower the cost and sift the node up.
+    heap[heapIndex].cost = newCost
+    while heapIndex > 0 {
+      heapIndex = getParentIndex(heapIndex)
+      updateHeapAtIndex(heapIndex)
+    }
+
+    return true
+  }
+
+  func updateHeapAtIndex(index: Int) -> Int {
+    let leftChildIndex = getLeftChildIndex(index)
+    let rightChildIndex = getRightChildIndex(index)
+
+    var smallestIndex = index
+    if leftChildIndex < heap.count &&
+       heap[leftChildIndex].cost < heap[smallestIndex].cost {
+      smallestIndex = leftChildIndex
+    }
+
+    if rightChildIndex < heap.count &&
+       heap[rightChildIndex].cost < heap[smallestIndex].cost {
+      smallestIndex = rightChildIndex
+    }
+
+    if smallestIndex != index {
+      graphIndexToHeapIndexMap[heap[index].nodeId] = smallestIndex
+      graphIndexToHeapIndexMap[heap[smallestIndex].nodeId] = index
+      swap(&heap[index], &heap[smallestIndex])
+    }
+
+    return smallestIndex
+  }
+
+  func isEmpty() -> Bool {
+    return heap.isEmpty
+  }
+}
+
+func prim(graph: [Node], _ fun: (Int, Int) -> Double) -> [Int?] {
+  var treeEdges = [Int?]()
+
+  // Create our queue, selecting the first element of the graph as the root of
+  // our tree for simplicity.
+  let queue = PriorityQueue()
+  queue.append(NodeCost(nodeId: 0, cost: 0.0))
+
+  // Make the minimum spanning tree root its own parent for simplicity.
+  treeEdges.append(0)
+
+  for i in 1..<graph.count {
+    queue.append(NodeCost(nodeId: i, cost: Double.infinity))
+    treeEdges.append(nil)
+  }
+
+  while !queue.isEmpty() {
+    let e = queue.popHeap()
+    let nodeId = e.nodeId
+    for adjNodeIndex in graph[nodeId].adjList {
+      if queue.updateCostIfLessThan(adjNodeIndex,
+                                    fun(graph[nodeId].id,
+                                        graph[adjNodeIndex].id)) {
+        treeEdges[adjNodeIndex] = nodeId
+      }
+    }
+  }
+
+  return treeEdges
+}
+
+struct Edge : Hashable {
+  var start: Int
+  var end: Int
+
+  var hashValue: Int {
+    return start.hashValue ^ (end.hashValue << 8)
+  }
+}
+
+func ==(lhs: Edge, rhs: Edge) -> Bool {
+  return lhs.start == rhs.start && lhs.end == rhs.end
+}
+
+let primsNumNodes = 100
+
+/// A connected graph with a few random edges per node. The edges come from a
+/// fixed linear congruential generator, so every run sees the same graph.
+func makePrimsEdges() -> [(Int, Int, Double)] {
+  var seed: UInt32 = 1
+  func random(bound: Int) -> Int {
+    seed = seed &* 1103515245 &+ 12345
+    return Int((seed >> 16) & 0x7fff) % bound
+  }
+
+  var edges = [(Int, Int, Double)]()
+  for i in 1..<primsNumNodes {
+    edges.append((i - 1, i, Double(1000 + random(1000))))
+  }
+  for i in 0..<primsNumNodes {
+    for _ in 0..<5 {
+      let j = random(primsNumNodes)
+      if i != j {
+        edges.append((i, j, Double(1 + random(2000))))
+      }
+    }
+  }
+  return edges
+}
+
+/// The cost of a minimum spanning tree, computed the quadratic way with a
+/// dense adjacency matrix.
+func naivePrimsCost(edges: [(Int, Int, Double)]) -> Double {
+  var cost = [[Double]](count: primsNumNodes,
+    repeatedValue: [Double](count: primsNumNodes,
+                            repeatedValue: Double.infinity))
+  for (a, b, c) in edges {
+    cost[a][b] = min(cost[a][b], c)
+    cost[b][a] = min(cost[b][a], c)
+  }
+  var inTree = [Bool](count: primsNumNodes, repeatedValue: false)
+  var best = [Double](count: primsNumNodes, repeatedValue: Double.infinity)
+  best[0] = 0
+  var total = 0.0
+  for _ in 0..<primsNumNodes {
+    var next = -1
+    for i in 0..<primsNumNodes where !inTree[i] {
+      if next < 0 || best[i] < best[next] {
+        next = i
+      }
+    }
+    inTree[next] = true
+    total += best[next]
+    for i in 0..<primsNumNodes where !inTree[i] {
+      best[i] = min(best[i], cost[next][i])
+    }
+  }
+  return total
+}
+
+@inline(never)
+public func run_Prims(N: Int) {
+  let edges = makePrimsEdges()
+  let expectedCost = naivePrimsCost(edges)
+
+  for _ in 1...N {
+    var graph = [Node]()
+    for i in 0..<primsNumNodes {
+      graph.append(Node(i: i))
+    }
+
+    var map = [Edge: Double]()
+    func addEdge(start: Int, _ end: Int, _ cost: Double) {
+      let edge = Edge(start: start, end: end)
+      if let existing = map[edge] where existing <= cost {
+        return
+      }
+      if map[edge] == nil {
+        graph[start].adjList.append(end)
+      }
+      map[edge] = cost
+    }
+    for (start, end, cost) in edges {
+      addEdge(start, end, cost)
+      addEdge(end, start, cost)
+    }
+
+    let treeEdges = prim(graph) { (start: Int, end: Int) in
+      return map[Edge(start: start, end: end)]!
+    }
+
+    var treeCost = 0.0
+    for i in 1..<primsNumNodes {
+      treeCost += map[Edge(start: treeEdges[i]!, end: i)]!
+    }
+    CheckResults(treeCost == expectedCost, "Incorrect result in Prims")
+  }
+}
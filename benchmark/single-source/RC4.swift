@@ -0,0 +1,95 @@
+//===--- RC4.swift --------------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+// The RC4 stream cipher. Exercises array accesses and wrapping arithmetic on
+// bytes.
+
+struct RC4 {
+  var State: [UInt8]
+  var I: UInt8 = 0
+  var J: UInt8 = 0
+
+  init() {
+    State = [UInt8](count: 256, repeatedValue: 0)
+  }
+
+  mutating
+  func initialize(Key: [UInt8]) {
+    for i in 0..<256 {
+      State[i] = UInt8(i)
+    }
+
+    var j: UInt8 = 0
+    for i in 0..<256 {
+      let K: UInt8 = Key[i % Key.count]
+      let S: UInt8 = State[i]
+      j = j &+ S &+ K
+      swapByIndex(i, y: Int(j))
+    }
+  }
+
+  mutating
+  func swapByIndex(x: Int, y: Int) {
+    let T1: UInt8 = State[x]
+    let T2: UInt8 = State[y]
+    State[x] = T2
+    State[y] = T1
+  }
+
+  mutating
+  func next() -> UInt8 {
+    I = I &+ 1
+    J = J &+ State[Int(I)]
+    swapByIndex(Int(I), y: Int(J))
+    return State[Int(State[Int(I)] &+ State[Int(J)]) & 0xFF]
+  }
+
+  mutating
+  func encrypt(inout Data: [UInt8]) {
+    let cnt = Data.count
+    for i in 0..<cnt {
+      Data[i] = Data[i] ^ next()
+    }
+  }
+}
+
+let RC4Secret = "This is my secret message"
+let RC4Key    = "This is my key"
+
+@inline(never)
+public func run_RC4(N: Int) {
+  let messageLen = 100
+  let iterations = 500
+  let SecretData: [UInt8] = Array(RC4Secret.utf8)
+  let KeyData: [UInt8] = Array(RC4Key.utf8)
+
+  var LongData = [UInt8](count: messageLen, repeatedValue: 0)
+
+  for _ in 1...N {
+    // Generate a long message.
+    for i in 0..<messageLen {
+      LongData[i] = SecretData[i % SecretData.count]
+    }
+
+    // Encrypting and decrypting with the same key stream is the identity.
+    var Enc = RC4()
+    Enc.initialize(KeyData)
+    var Dec = Enc
+
+    for _ in 0..<iterations {
+      Enc.encrypt(&LongData)
+      Dec.encrypt(&LongData)
+    }
+
+    CheckResults(LongData[0] == SecretData[0], "Incorrect result in RC4")
+  }
+}
@@ -0,0 +1,379 @@
+//===--- Richards.swift ---------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+// This is an OS kernel simulator, originally written in BCPL by M. J. Jordan,
+// Cambridge Computer Laboratory, and later modified by M. Richards.
+//
+// This port keeps the state machine of the C version. The task function
+// pointers of the C version are a TaskKind that the scheduler switches over,
+// and the task values are enums with payloads.
+
+let BufSize = 4
+
+final class Packet {
+  enum Kind {
+    case Dev
+    case Work
+  }
+
+  var link: Packet?
+  var id: Int
+  var kind: Kind
+  var a1: Int = 0
+  var a2: [UInt8] = [UInt8](count: BufSize, repeatedValue: 0)
+
+  init(link: Packet?, id: Int, kind: Kind) {
+    self.link = link
+    self.id = id
+    self.kind = kind
+  }
+}
+
+// Task state bitmask.
+let TSPktBit: UInt8     = 1
+let TSWaitBit: UInt8    = 2
+let TSHoldBit: UInt8    = 4
+let TSNotHoldBit: UInt8 = 0xfb
+let TSRun: UInt8         = 0
+let TSRunPkt: UInt8      = 1
+let TSWait: UInt8        = 2
+let TSWaitPkt: UInt8     = 3
+let TSHold: UInt8        = 4
+let TSHoldPkt: UInt8     = 5
+let TSHoldWait: UInt8    = 6
+let TSHoldWaitPkt: UInt8 = 7
+
+// Indices into a task table.
+let TIIdle = 1
+let TIWork = 2
+let TIHandlerA = 3
+let TIHandlerB = 4
+let TIDevA = 5
+let TIDevB = 6
+
+enum TaskKind {
+  case Idle
+  case Work
+  case Handler
+  case Device
+}
+
+enum TaskValue {
+  case None
+  case Number(Int)
+  case Worklist(Packet)
+
+  var number: Int {
+    get {
+      if case .Number(let i) = self {
+        return i
+      }
+      fatalError("Task value is not a number")
+    }
+    set {
+      self = .Number(newValue)
+    }
+  }
+
+  var packet: Packet? {
+    get {
+      switch self {
+      case .Worklist(let wkq):
+        return wkq
+      case .None:
+        return nil
+      case .Number:
+        fatalError("Task value is not a worklist")
+      }
+    }
+    set {
+      if let p = newValue {
+        self = .Worklist(p)
+      } else {
+        self = .None
+      }
+    }
+  }
+}
+
+final class Task {
+  var link: Task?
+  var id: Int
+  var pri: Int
+  var wkq: Packet?
+  var state: UInt8
+  var kind: TaskKind
+  var v1: TaskValue
+  var v2: TaskValue
+
+  init(link: Task?, id: Int, pri: Int, wkq: Packet?, state: UInt8,
+       kind: TaskKind, v1: TaskValue, v2: TaskValue) {
+    self.link = link
+    self.id = id
+    self.pri = pri
+    self.wkq = wkq
+    self.state = state
+    self.kind = kind
+    self.v1 = v1
+    self.v2 = v2
+  }
+}
+
+final class Richards {
+  var tasktab = [Task?](count: 11, repeatedValue: nil)
+  var tasklist: Task? = nil
+
+  var tcb: Task? = nil
+  var taskid = 0
+  var v1: TaskValue = .None
+  var v2: TaskValue = .None
+
+  var holdcount = 0
+  var qpktcount = 0
+
+  let alphabet: [UInt8] = Array("0ABCDEFGHIJKLMNOPQRSTUVWXYZ".utf8)
+
+  func createTask(id: Int, pri: Int, wkq: Packet?, state: UInt8,
+                  kind: TaskKind, v1: TaskValue, v2: TaskValue) {
+    let newtask = Task(link: tasklist, id: id, pri: pri, wkq: wkq,
+                       state: state, kind: kind, v1: v1, v2: v2)
+    tasktab[id] = newtask
+    tasklist = newtask
+  }
+
+  func schedule() {
+    while let t = tcb {
+      var pkt: Packet? = nil
+
+      switch t.state {
+      case TSWaitPkt:
+        pkt = t.wkq
+        t.wkq = pkt!.link
+        t.state = t.wkq == nil ? TSRun : TSRunPkt
+        fallthrough
+      case TSRun, TSRunPkt:
+        taskid = t.id
+        v1 = t.v1
+        v2 = t.v2
+        let newtcb = run(t.kind, pkt)
+        t.v1 = v1
+        t.v2 = v2
+        tcb = newtcb
+      case TSWait, TSHold, TSHoldPkt, TSHoldWait, TSHoldWaitPkt:
+        tcb = t.link
+      default:
+        return
+      }
+    }
+  }
+
+  func run(kind: TaskKind, _ pkt: Packet?) -> Task? {
+    switch kind {
+    case .Idle:
+      return idlefn(pkt)
+    case .Work:
+      return workfn(pkt)
+    case .Handler:
+      return handlerfn(pkt)
+    case .Device:
+      return devfn(pkt)
+    }
+  }
+
+  func wait() -> Task? {
+    tcb!.state |= TSWaitBit
+    return tcb
+  }
+
+  func holdself() -> Task? {
+    holdcount += 1
+    tcb!.state |= TSHoldBit
+    return tcb!.link
+  }
+
+  func findtcb(id: Int) -> Task? {
+    if 1 <= id && id <= 10 {
+      return tasktab[id]
+    }
+    return nil
+  }
+
+  func release(id: Int) -> Task? {
+    guard let t = findtcb(id) else {
+      return nil
+    }
+    t.state &= TSNotHoldBit
+    if t.pri > tcb!.pri {
+      return t
+    }
+    return tcb
+  }
+
+  func qpkt(pkt: Packet) -> Task? {
+    guard let t = findtcb(pkt.id) else {
+      return nil
+    }
+    qpktcount += 1
+    pkt.link = nil
+    pkt.id = taskid
+    if t.wkq == nil {
+      t.wkq = pkt
+      t.state |= TSPktBit
+      if t.pri > tcb!.pri {
+        return t
+      }
+    } else {
+      append(pkt, t.wkq)
+    }
+    return tcb
+  }
+
+  // For the idle task, v1 is a seed and v2 is the number of times it should
+  // be scheduled.
+  func idlefn(pkt: Packet?) -> Task? {
+    v2.number -= 1
+    if v2.number == 0 {
+      return holdself()
+    }
+    if (v1.number & 1) == 0 {
+      v1.number = v1.number >> 1
+      return release(TIDevA)
+    }
+    v1.number = (v1.number >> 1) ^ 0xD008
+    return release(TIDevB)
+  }
+
+  func workfn(pkt: Packet?) -> Task? {
+    guard let pkt = pkt else {
+      return wait()
+    }
+    v1.number = TIHandlerA + TIHandlerB - v1.number
+    pkt.id = v1.number
+    pkt.a1 = 0
+    if case .None = v2 {
+      v2 = .Number(0)
+    }
+    for i in 0..<BufSize {
+      v2.number += 1
+      if v2.number > 26 {
+        v2.number = 1
+      }
+      pkt.a2[i] = alphabet[v2.number]
+    }
+    return qpkt(pkt)
+  }
+
+  func handlerfn(pkt: Packet?) -> Task? {
+    if let pkt = pkt {
+      switch pkt.kind {
+      case .Work:
+        v1.packet = append(pkt, v1.packet)
+      case .Dev:
+        v2.packet = append(pkt, v2.packet)
+      }
+    }
+    if let workpkt = v1.packet {
+      let count = workpkt.a1
+      if count >= BufSize {
+        v1.packet = workpkt.link
+        return qpkt(workpkt)
+      }
+      if let devpkt = v2.packet {
+        v2.packet = devpkt.link
+        devpkt.a1 = Int(workpkt.a2[count])
+        workpkt.a1 = count + 1
+        return qpkt(devpkt)
+      }
+    }
+    return wait()
+  }
+
+  func devfn(pkt: Packet?) -> Task? {
+    guard let pkt = pkt else {
+      guard let queued = v1.packet else {
+        return wait()
+      }
+      v1.packet = nil
+      return qpkt(queued)
+    }
+    v1.packet = pkt
+    return holdself()
+  }
+
+  // The C benchmark passes the address of the queue, assuming that the link
+  // is the first field of a packet. Instead, this returns the new queue.
+  func append(pkt: Packet, _ ptr: Packet?) -> Packet {
+    pkt.link = nil
+    guard let head = ptr else {
+      return pkt
+    }
+    var next = head
+    while let n = next.link {
+      next = n
+    }
+    next.link = pkt
+    return head
+  }
+
+  /// Runs the simulation and returns whether the packet and hold counts are
+  /// the ones the reference implementation gets.
+  func main() -> Bool {
+    let Count = 10000
+    let Qpktcountval = 23246
+    let Holdcountval = 9297
+
+    var wkq: Packet? = nil
+    createTask(TIIdle, pri: 0, wkq: wkq, state: TSRun, kind: .Idle,
+               v1: .Number(1), v2: .Number(Count))
+
+    wkq = Packet(link: nil, id: 0, kind: .Work)
+    wkq = Packet(link: wkq, id: 0, kind: .Work)
+
+    createTask(TIWork, pri: 1000, wkq: wkq, state: TSWaitPkt, kind: .Work,
+               v1: .Number(TIHandlerA), v2: .None)
+
+    wkq = Packet(link: nil, id: TIDevA, kind: .Dev)
+    wkq = Packet(link: wkq, id: TIDevA, kind: .Dev)
+    wkq = Packet(link: wkq, id: TIDevA, kind: .Dev)
+
+    createTask(TIHandlerA, pri: 2000, wkq: wkq, state: TSWaitPkt,
+               kind: .Handler, v1: .None, v2: .None)
+
+    wkq = Packet(link: nil, id: TIDevB, kind: .Dev)
+    wkq = Packet(link: wkq, id: TIDevB, kind: .Dev)
+    wkq = Packet(link: wkq, id: TIDevB, kind: .Dev)
+
+    createTask(TIHandlerB, pri: 3000, wkq: wkq, state: TSWaitPkt,
+               kind: .Handler, v1: .None, v2: .None)
+
+    wkq = nil
+
+    createTask(TIDevA, pri: 4000, wkq: wkq, state: TSWait, kind: .Device,
+               v1: .None, v2: .None)
+    createTask(TIDevB, pri: 5000, wkq: wkq, state: TSWait, kind: .Device,
+               v1: .None, v2: .None)
+
+    tcb = tasklist
+    schedule()
+
+    return qpktcount == Qpktcountval && holdcount == Holdcountval
+  }
+}
+
+@inline(never)
+public func run_Richards(N: Int) {
+  for _ in 1...N {
+    let r = Richards()
+    CheckResults(r.main(), "Incorrect result in Richards: " +
+                 "qpkt count \(r.qpktcount), hold count \(r.holdcount)")
+  }
+}
@@ -0,0 +1,40 @@
+//===--- StringWalk.swift -------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+// Walks the unicode scalars of ASCII and non-ASCII strings.
+
+@inline(never)
+func countScalars(s: String) -> Int {
+  var count = 0
+  for _ in s.unicodeScalars {
+    count += 1
+  }
+  return count
+}
+
+@inline(never)
+public func run_StringWalk(N: Int) {
+  let s = "siebenhundertsiebenundsiebzigtausendsiebenhundertsiebenundsiebzig"
+  for _ in 1...N * 1000 {
+    CheckResults(countScalars(s) == 65, "Incorrect result in StringWalk")
+  }
+}
+
+@inline(never)
+public func run_StringComplexWalk(N: Int) {
+  let s = "निरन्तरान्धकारिता-दिगन्तर-कन्दलदमन्द-सुधारस-बिन्दु-सान्द्रतर-घनाघन-वृन्द-सन्देहकर-स्यन्दमान-मकरन्द-बिन्दु-बन्धुरतर-माकन्द-तरु-कुल-तल्प-कल्प-मृदुल-सिकता-जाल-जटिल-मूल-तल-मरुवक-मिलदलघु-लघु-लय-कलित-रमणीय-पानीय-शालिका-बालिका-करार-विन्द-गलन्तिका-गलदेला-लवङ्ग-पाटल-घनसार-कस्तूरिकातिसौरभ-मेदुर-लघुतर-मधुर-शीतलतर-सलिलधारा-निराकरिष्णु-तदीय-विमल-विलोचन-मयूख-रेखापसारित-पिपासायास-पथिक-लोकान्"
+  let expected = s.unicodeScalars.count
+  for _ in 1...N * 100 {
+    CheckResults(countScalars(s) == expected,
+                 "Incorrect result in StringComplexWalk")
+  }
+}
@@ -0,0 +1,198 @@
+//===--- DriverUtils.swift - Benchmark harness ----------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Runs each benchmark once to warm up and to pick an iteration count, then
+// takes a number of timed samples of that many iterations. Results are
+// reported per iteration, in microseconds, either as CSV or as JSON for
+// scripts/compare_perf_tests.py.
+//
+//===----------------------------------------------------------------------===//
+
+#if os(Linux)
+import Glibc
+#else
+import Darwin
+#endif
+
+/// A benchmark body. It is passed the number of iterations to run.
+public typealias BenchmarkFn = (Int) -> ()
+
+/// Aborts the run if a benchmark computed a wrong result. Benchmarks check
+/// their results so that the optimizer can't make their work disappear.
+public func CheckResults(condition: Bool, _ message: String) {
+  if !condition {
+    print("Benchmark failed: \(message)")
+    exit(1)
+  }
+}
+
+/// A monotonic clock in nanoseconds.
+func getTimeNanoseconds() -> UInt64 {
+#if os(Linux)
+  var ts = timespec()
+  clock_gettime(CLOCK_MONOTONIC, &ts)
+  return UInt64(ts.tv_sec) * 1_000_000_000 + UInt64(ts.tv_nsec)
+#else
+  var info = mach_timebase_info_data_t()
+  mach_timebase_info(&info)
+  return mach_absolute_time() * UInt64(info.numer) / UInt64(info.denom)
+#endif
+}
+
+struct TestConfig {
+  /// The number of timed samples per benchmark.
+  var numSamples = 10
+
+  /// The number of iterations per sample. If 0, it is picked so that one
+  /// sample takes about `sampleTime` nanoseconds.
+  var numIters = 0
+
+  var sampleTime: UInt64 = 20_000_000
+
+  var emitJSON = false
+
+  var listOnly = false
+
+  /// The benchmarks to run. If empty, all of them are run.
+  var filters = [String]()
+
+  init(_ arguments: [String]) {
+    for arg in arguments.dropFirst() {
+      if let value = TestConfig.getValue(arg, "--num-samples=") {
+        numSamples = max(1, Int(value) ?? numSamples)
+      } else if let value = TestConfig.getValue(arg, "--num-iters=") {
+        numIters = max(0, Int(value) ?? numIters)
+      } else if arg == "--json" {
+        emitJSON = true
+      } else if arg == "--list" {
+        listOnly = true
+      } else if arg.hasPrefix("-") {
+        print("usage: \(arguments[0]) [--num-samples=N] [--num-iters=N] " +
+              "[--json] [--list] [benchmark...]")
+        exit(arg == "--help" ? 0 : 1)
+      } else {
+        filters.append(arg)
+      }
+    }
+  }
+
+  static func getValue(arg: String, _ option: String) -> String? {
+    if !arg.hasPrefix(option) {
+      return nil
+    }
+    return String(arg.characters.dropFirst(option.characters.count))
+  }
+}
+
+struct BenchResults {
+  var name: String
+  var iters: Int
+  /// Time per iteration of each sample, in microseconds.
+  var samples: [Double]
+
+  var min: Double { return samples.minElement()! }
+  var max: Double { return samples.maxElement()! }
+  var mean: Double {
+    return samples.reduce(0, combine: +) / Double(samples.count)
+  }
+  var sd: Double {
+    let m = mean
+    let sumSquares = samples.reduce(0) { $0 + ($1 - m) * ($1 - m) }
+    return sqrt(sumSquares / Double(samples.count))
+  }
+  var median: Double {
+    let sorted = samples.sort()
+    let mid = sorted.count / 2
+    if sorted.count % 2 == 0 {
+      return (sorted[mid - 1] + sorted[mid]) / 2
+    }
+    return sorted[mid]
+  }
+}
+
+func runBench(name: String, _ fn: BenchmarkFn, _ c: TestConfig)
+    -> BenchResults {
+  // Warm up caches and lazily initialized globals before timing anything.
+  var start = getTimeNanoseconds()
+  fn(1)
+  let warmupTime = getTimeNanoseconds() - start
+
+  var iters = c.numIters
+  if iters == 0 {
+    iters = Int(c.sampleTime / Swift.max(warmupTime, 1))
+    iters = Swift.max(1, Swift.min(iters, 1_000_000))
+  }
+
+  var samples = [Double]()
+  for _ in 0..<c.numSamples {
+    start = getTimeNanoseconds()
+    fn(iters)
+    let elapsed = getTimeNanoseconds() - start
+    samples.append(Double(elapsed) / Double(iters) / 1000)
+  }
+  return BenchResults(name: name, iters: iters, samples: samples)
+}
+
+func printCSV(results: [BenchResults]) {
+  print("#,TEST,SAMPLES,ITERS,MIN(us),MAX(us),MEAN(us),SD(us),MEDIAN(us)")
+  for (index, r) in results.enumerate() {
+    let fields: [String] = [
+      "\(index + 1)", r.name, "\(r.samples.count)", "\(r.iters)",
+      "\(r.min)", "\(r.max)", "\(r.mean)", "\(r.sd)", "\(r.median)"
+    ]
+    print(fields.joinWithSeparator(","))
+  }
+}
+
+func printJSON(results: [BenchResults]) {
+  // Benchmark names are plain identifiers, so they need no escaping.
+  print("{")
+  print("  \"unit\": \"us\",")
+  print("  \"results\": [")
+  for (index, r) in results.enumerate() {
+    let samples = r.samples.map { "\($0)" }.joinWithSeparator(", ")
+    print("    {\"name\": \"\(r.name)\", \"iters\": \(r.iters), " +
+          "\"min\": \(r.min), \"max\": \(r.max), \"mean\": \(r.mean), " +
+          "\"sd\": \(r.sd), \"median\": \(r.median), " +
+          "\"samples\": [\(samples)]}" +
+          (index + 1 == results.count ? "" : ","))
+  }
+  print("  ]")
+  print("}")
+}
+
+public func main(benchmarks: [(String, BenchmarkFn)]) {
+  let config = TestConfig(Process.arguments)
+
+  var selected = benchmarks
+  if !config.filters.isEmpty {
+    selected = benchmarks.filter { config.filters.contains($0.0) }
+    if selected.count != config.filters.count {
+      print("unknown benchmark in: \(config.filters)")
+      exit(1)
+    }
+  }
+
+  if config.listOnly {
+    for (name, _) in selected {
+      print(name)
+    }
+    return
+  }
+
+  let results = selected.map { runBench($0.0, $0.1, config) }
+  if config.emitJSON {
+    printJSON(results)
+  } else {
+    printCSV(results)
+  }
+}
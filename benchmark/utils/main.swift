@@ -0,0 +1,26 @@
+//===--- main.swift -------------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+// The benchmarks to run, in the order they are reported. To add a benchmark,
+// add its source file to SWIFT_BENCHMARK_SOURCES in benchmark/CMakeLists.txt
+// and register its entry point here.
+
+main([
+  ("Ackermann", run_Ackermann),
+  ("ObjInst", run_ObjInst),
+  ("Phonebook", run_Phonebook),
+  ("Prims", run_Prims),
+  ("RC4", run_RC4),
+  ("Richards", run_Richards),
+  ("StringComplexWalk", run_StringComplexWalk),
+  ("StringWalk", run_StringWalk),
+])
@@ -350,6 +350,9 @@ public:
 
   /// getIdentifier - Return the uniqued and AST-Context-owned version of the
   /// specified string.
+  ///
+  /// Unlike most of ASTContext, this may be called from several threads at
+  /// once.
   Identifier getIdentifier(StringRef Str) const;
 
   /// Retrieve the declaration of Swift.ErrorType.
@@ -743,6 +746,14 @@ public:
   /// \brief Returns memory used exclusively by constraint solver.
   size_t getSolverMemory() const;
 
+  /// \brief Prints a report of the memory used by the AST: how many nodes of
+  /// each kind were created and their size, the sizes of the allocation
+  /// arenas, and the number of identifiers and interned types.
+  ///
+  /// The per-kind counts are only collected while ASTNodeCounts::Enabled is
+  /// set.
+  void printStatistics(raw_ostream &OS) const;
+
   /// Complain if @objc or dynamic is used without importing Foundation.
   void diagnoseAttrsRequiringFoundation(SourceFile &SF);
 
@@ -0,0 +1,52 @@
+//===--- ASTNodeCounts.h - Counts of AST node allocations -------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the counters behind the AST memory report printed by
+// ASTContext::printStatistics().
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_AST_ASTNODECOUNTS_H
+#define SWIFT_AST_ASTNODECOUNTS_H
+
+#include "llvm/Support/DataTypes.h"
+
+namespace swift {
+
+/// Counts of the AST nodes created so far, by node kind.
+///
+/// The counters are only updated while \c Enabled is set, so that the
+/// node constructors only pay for a branch when no report was requested.
+struct ASTNodeCounts {
+  static bool Enabled;
+
+  /// The number of nodes created, indexed by DeclKind, ExprKind, TypeKind and
+  /// TypeReprKind respectively.
+  static unsigned Decls[];
+  static unsigned Exprs[];
+  static unsigned Types[];
+  static unsigned TypeReprs[];
+
+  /// The bytes allocated for types, including any trailing storage, indexed
+  /// by AllocationArena.
+  static uint64_t TypeBytes[];
+
+  /// The total number of nodes created, over all kinds.
+  static uint64_t getTotalDecls();
+  static uint64_t getTotalExprs();
+  static uint64_t getTotalTypes();
+  static uint64_t getTotalTypeReprs();
+};
+
+} // end namespace swift
+
+#endif
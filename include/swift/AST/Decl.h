@@ -17,6 +17,7 @@
 #ifndef SWIFT_DECL_H
 #define SWIFT_DECL_H
 
+#include "swift/AST/ASTNodeCounts.h"
 #include "swift/AST/Attr.h"
 #include "swift/AST/CaptureInfo.h"
 #include "swift/AST/DeclContext.h"
@@ -665,6 +666,8 @@ protected:
     DeclBits.FromClang = false;
     DeclBits.EarlyAttrValidation = false;
     DeclBits.BeingTypeChecked = false;
+    if (ASTNodeCounts::Enabled)
+      ++ASTNodeCounts::Decls[unsigned(kind)];
   }
 
   ClangNode getClangNodeImpl() const {
@@ -2711,6 +2714,12 @@ class NominalTypeDecl : public TypeDecl, public DeclContext,
   /// Prepare the lookup table to make it ready for lookups.
   void prepareLookupTable(bool ignoreNewExtensions);
 
+  /// Add the members of this type and its extensions named \p name to the
+  /// lookup table, without loading any other lazy members.
+  ///
+  /// \returns false if some context can't load its members by name.
+  bool loadNamedMembers(DeclName name);
+
   /// Note that we have added a member into the iterable declaration context,
   /// so that it can also be added to the lookup table (if needed).
   void addedMember(Decl *member);
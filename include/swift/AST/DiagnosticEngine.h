@@ -667,6 +667,26 @@ namespace swift {
              "transactions must be closed LIFO");
     }
   };
+
+  /// \brief Detaches all consumers from a diagnostic engine for the lifetime
+  /// of this object, and restores them on destruction.
+  ///
+  /// While no consumer is attached, the engine still tracks whether errors
+  /// occurred, but drops each diagnostic before resolving its location or
+  /// formatting its arguments.
+  class DiagnosticSuppression {
+    DiagnosticEngine &Engine;
+    std::vector<DiagnosticConsumer *> SuppressedConsumers;
+
+  public:
+    explicit DiagnosticSuppression(DiagnosticEngine &engine)
+      : Engine(engine), SuppressedConsumers(engine.takeConsumers()) {}
+
+    ~DiagnosticSuppression() {
+      for (auto consumer : SuppressedConsumers)
+        Engine.addConsumer(*consumer);
+    }
+  };
 } // end namespace swift
 
 #endif
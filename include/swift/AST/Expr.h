@@ -17,6 +17,7 @@
 #ifndef SWIFT_AST_EXPR_H
 #define SWIFT_AST_EXPR_H
 
+#include "swift/AST/ASTNodeCounts.h"
 #include "swift/AST/CaptureInfo.h"
 #include "swift/AST/ConcreteDeclRef.h"
 #include "swift/AST/DeclContext.h"
@@ -340,6 +341,8 @@ protected:
     ExprBits.Kind = unsigned(Kind);
     ExprBits.Implicit = Implicit;
     ExprBits.LValueAccessKind = 0;
+    if (ASTNodeCounts::Enabled)
+      ++ASTNodeCounts::Exprs[unsigned(Kind)];
   }
 
 public:
@@ -0,0 +1,141 @@
+//===--- FunctionTimeProfile.h - Compile time per function ------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the profile behind -debug-time-functions, which
+// attributes the time of each compiler phase to the source functions it was
+// spent on.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_AST_FUNCTIONTIMEPROFILE_H
+#define SWIFT_AST_FUNCTIONTIMEPROFILE_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace swift {
+
+class DeclContext;
+
+/// The time spent compiling each function, by phase.
+///
+/// Time is attributed to the function or closure in the source which a piece
+/// of work came from: SIL functions and LLVM functions are attributed to the
+/// declaration they were generated for, so that specializations, thunks and
+/// closures add up under their source declaration. Functions without such a
+/// declaration are listed under their symbol name.
+///
+/// Times may be added from several threads at once, but timers can only be
+/// nested on one thread at a time.
+class FunctionTimeProfile {
+public:
+  enum class Phase : unsigned {
+    TypeCheck,
+    SILGen,
+    SILOptimization,
+    IRGen,
+    LLVM,
+  };
+  enum : unsigned { NumPhases = unsigned(Phase::LLVM) + 1 };
+
+  /// Measures the time spent in one function, excluding the time of any
+  /// timer started while this one is running, such as for a closure which is
+  /// type-checked while its enclosing function is.
+  ///
+  /// Does nothing if there is no active profile.
+  class Timer {
+    FunctionTimeProfile *Profile;
+    const DeclContext *DC;
+    StringRef Name;
+    Phase P;
+    uint64_t Start;
+    uint64_t NestedTime = 0;
+    Timer *Parent;
+
+  public:
+    Timer(const DeclContext *DC, StringRef Name, Phase P);
+    ~Timer();
+
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+  };
+
+private:
+  struct Entry {
+    /// The source function, or null if the entry is for a symbol name.
+    const DeclContext *DC = nullptr;
+
+    /// The first symbol seen for this entry.
+    std::string Name;
+
+    uint64_t Times[NumPhases] = {};
+
+    /// The time of each SIL pass, which are part of Phase::SILOptimization.
+    llvm::StringMap<uint64_t> PassTimes;
+
+    uint64_t getTotal() const;
+  };
+
+  std::vector<Entry> Entries;
+  llvm::DenseMap<const DeclContext *, unsigned> EntriesByDC;
+  llvm::StringMap<unsigned> EntriesByName;
+
+  /// The source of the LLVM functions generated by IRGen, by symbol name.
+  llvm::StringMap<const DeclContext *> SymbolSources;
+
+  Timer *CurrentTimer = nullptr;
+  mutable std::mutex Lock;
+
+  Entry &getEntry(const DeclContext *DC, StringRef Name);
+
+public:
+  /// Returns the profile that the compiler's phases should add to, or null
+  /// if functions aren't being profiled.
+  static FunctionTimeProfile *getActive();
+
+  /// Sets the profile returned by getActive().
+  static void setActive(FunctionTimeProfile *Profile);
+
+  /// Returns the current time, in nanoseconds.
+  static uint64_t now();
+
+  /// Attributes \p Nanoseconds of phase \p P to the function \p Name, which
+  /// was generated for \p DC. \p DC may be null, or any kind of context; only
+  /// functions and closures are used as sources.
+  void addTime(const DeclContext *DC, StringRef Name, Phase P,
+               uint64_t Nanoseconds);
+
+  /// Attributes the run of SIL pass \p Pass on the function \p Name, which
+  /// was generated for \p DC, to the SIL optimization phase.
+  void addPassTime(const DeclContext *DC, StringRef Name, StringRef Pass,
+                   uint64_t Nanoseconds);
+
+  /// Remembers that the LLVM function \p Symbol was generated for \p DC.
+  void setSymbolSource(StringRef Symbol, const DeclContext *DC);
+
+  /// Returns the source recorded by setSymbolSource(), or null.
+  const DeclContext *getSymbolSource(StringRef Symbol) const;
+
+  /// Prints the \p Limit functions that took the most time in total, with
+  /// their source locations, the time of each phase, and the most expensive
+  /// SIL passes on them.
+  void print(raw_ostream &os, unsigned Limit) const;
+};
+
+} // end namespace swift
+
+#endif
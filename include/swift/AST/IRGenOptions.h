@@ -99,6 +99,10 @@ public:
   /// \brief Whether we should run LLVM SLP vectorizer.
   unsigned DisableLLVMSLPVectorizer : 1;
 
+  /// \brief Whether we should omit the TBAA metadata of class property
+  /// accesses.
+  unsigned DisableTBAA : 1;
+
   /// Disable frame pointer elimination?
   unsigned DisableFPElim : 1;
   
@@ -109,10 +113,25 @@ public:
   /// objects.
   unsigned EmitStackPromotionChecks : 1;
 
+  /// In multi-threaded compilation, distribute the SIL functions over the LLVM
+  /// modules so that all modules get about the same amount of code, instead of
+  /// putting each function into the module of its source file.
+  unsigned BalanceParallelPartitions : 1;
+
   /// The maximum number of bytes used on a stack frame for stack promotion
   /// (includes alloc_stack allocations).
   unsigned StackPromotionSizeLimit = 1024;
 
+  /// The number of instructions above which a copy or destroy of a struct or
+  /// enum value is outlined into a helper function shared by all the values
+  /// of the type. Zero disables outlining.
+  unsigned OutlinedValueOperationThreshold = 16;
+
+  /// The number of partitions into which the optimized LLVM module of a
+  /// single-threaded compilation is split, so that the object file can be
+  /// generated on that many threads. Zero or one disables splitting.
+  unsigned CodeGenPartitions = 0;
+
   /// Emit code to verify that static and runtime type layout are consistent for
   /// the given type names.
   SmallVector<StringRef, 1> VerifyTypeLayoutNames;
@@ -123,6 +142,16 @@ public:
   /// Instrument code to generate profiling information.
   unsigned GenerateProfile : 1;
 
+  /// Skip the LLVM passes for an object file which was generated from the
+  /// same IR by the previous compilation, and keep the existing file.
+  unsigned IncrementalCodeGen : 1;
+
+  /// Lower the profile counter increments before running the LLVM
+  /// optimization pipeline instead of after it. This lets LICM keep the
+  /// counters of loops in registers and write them back once after the loop,
+  /// which avoids contended counter updates in multi-threaded code.
+  unsigned ProfileCounterPromotion : 1;
+
   /// Whether we should embed the bitcode file.
   IRGenEmbedMode EmbedMode : 2;
 
@@ -133,8 +162,10 @@ public:
                    Optimize(false), DebugInfoKind(IRGenDebugInfoKind::None),
                    UseJIT(false), DisableLLVMOptzns(false),
                    DisableLLVMARCOpts(false), DisableLLVMSLPVectorizer(false),
-                   DisableFPElim(true), Playground(false),
-                   EmitStackPromotionChecks(false), GenerateProfile(false),
+                   DisableTBAA(false), DisableFPElim(true), Playground(false),
+                   EmitStackPromotionChecks(false),
+                   BalanceParallelPartitions(false), GenerateProfile(false),
+                   IncrementalCodeGen(false), ProfileCounterPromotion(false),
                    EmbedMode(IRGenEmbedMode::None) {}
   
   /// Gets the name of the specified output filename.
@@ -17,6 +17,7 @@
 #ifndef SWIFT_AST_LAZYRESOLVER_H
 #define SWIFT_AST_LAZYRESOLVER_H
 
+#include "swift/AST/Identifier.h"
 #include "swift/AST/TypeLoc.h"
 #include "llvm/ADT/Fixnum.h"
 
@@ -138,6 +139,19 @@ public:
     llvm_unreachable("unimplemented");
   }
 
+  /// Populates \p Members with the members of \p D whose base name matches
+  /// \p N, without loading the other members.
+  ///
+  /// The implementation should \em not add the members to \p D.
+  ///
+  /// \returns false if the loader can't look up members by name, in which
+  /// case the caller has to fall back to loading all members.
+  virtual bool
+  loadNamedMembers(const Decl *D, DeclName N, uint64_t contextData,
+                   SmallVectorImpl<ValueDecl *> &Members) {
+    return false;
+  }
+
   /// Populates the given vector with all conformances for \p D.
   ///
   /// The implementation should \em not call setConformances on \p D.
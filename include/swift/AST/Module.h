@@ -881,6 +881,19 @@ private:
   /// this source file so far.
   llvm::MD5 InterfaceHash;
 
+  /// Like InterfaceHash, but leaving out the tokens of members that have
+  /// their own hash in MemberInterfaceHashes.
+  llvm::MD5 InterfaceHashExcludingMembers;
+
+  /// Hashes for the members currently being parsed, innermost last.
+  SmallVector<llvm::MD5, 2> MemberInterfaceHashStack;
+
+  /// The hash of the interface tokens of each member that cannot affect the
+  /// layout of its type.
+  ///
+  /// \sa beginMemberInterfaceHash
+  llvm::DenseMap<const ValueDecl *, std::string> MemberInterfaceHashes;
+
   /// \brief The ID for the memory buffer containing this file's source.
   ///
   /// May be -1, to indicate no association with a buffer.
@@ -897,6 +910,11 @@ public:
   /// The list of local type declarations in the source file.
   TinyPtrVector<TypeDecl*> LocalTypeDecls;
 
+  /// True if the parser has seen an \@available attribute or a #available
+  /// condition in this file. Otherwise the root type refinement context is
+  /// the only one the file needs.
+  bool HasAvailabilityAnnotations = false;
+
   /// A set of special declaration attributes which require the
   /// Foundation module to be imported to work. If the foundation
   /// module is still not imported by the time type checking is
@@ -1077,14 +1095,67 @@ public:
 
   void recordInterfaceToken(StringRef token) {
     assert(!token.empty());
-    InterfaceHash.update(token);
     // Add null byte to separate tokens.
     uint8_t a[1] = {0};
+    InterfaceHash.update(token);
     InterfaceHash.update(a);
+
+    llvm::MD5 &partialHash = MemberInterfaceHashStack.empty()
+                                 ? InterfaceHashExcludingMembers
+                                 : MemberInterfaceHashStack.back();
+    partialHash.update(token);
+    partialHash.update(a);
   }
 
-  const llvm::MD5 &getInterfaceHashState() { return InterfaceHash; }
-  void setInterfaceHashState(const llvm::MD5 &state) { InterfaceHash = state; }
+  using InterfaceHashState = std::pair<llvm::MD5, llvm::MD5>;
+  InterfaceHashState getInterfaceHashState() {
+    assert(MemberInterfaceHashStack.empty());
+    return { InterfaceHash, InterfaceHashExcludingMembers };
+  }
+  void setInterfaceHashState(const InterfaceHashState &state) {
+    assert(MemberInterfaceHashStack.empty());
+    InterfaceHash = state.first;
+    InterfaceHashExcludingMembers = state.second;
+  }
+
+  /// Starts hashing the tokens of a member separately from the rest of the
+  /// file. Must be balanced by a call to endMemberInterfaceHash.
+  void beginMemberInterfaceHash() {
+    MemberInterfaceHashStack.emplace_back();
+  }
+
+  /// Finishes hashing the tokens of a member.
+  ///
+  /// If \p members is empty, the member's hash is folded back into the
+  /// enclosing hash, so that changes to the member still count as changes to
+  /// the enclosing context. Otherwise it is recorded as the hash of each of
+  /// the given declarations.
+  void endMemberInterfaceHash(ArrayRef<const ValueDecl *> members) {
+    llvm::MD5::MD5Result result;
+    MemberInterfaceHashStack.pop_back_val().final(result);
+
+    if (members.empty()) {
+      llvm::MD5 &enclosingHash = MemberInterfaceHashStack.empty()
+                                     ? InterfaceHashExcludingMembers
+                                     : MemberInterfaceHashStack.back();
+      enclosingHash.update(result);
+      return;
+    }
+
+    llvm::SmallString<32> str;
+    llvm::MD5::stringifyResult(result, str);
+    for (auto *member : members)
+      MemberInterfaceHashes[member] = str.str();
+  }
+
+  /// Returns the hash of \p member's interface tokens, or an empty string if
+  /// the member is covered by getInterfaceHashExcludingMembers instead.
+  StringRef getMemberInterfaceHash(const ValueDecl *member) const {
+    auto known = MemberInterfaceHashes.find(member);
+    if (known == MemberInterfaceHashes.end())
+      return StringRef();
+    return known->second;
+  }
 
   void getInterfaceHash(llvm::SmallString<32> &str) {
     llvm::MD5::MD5Result result;
@@ -1092,6 +1163,16 @@ public:
     llvm::MD5::stringifyResult(result, str);
   }
 
+  /// Like getInterfaceHash, but only covering the parts of the interface that
+  /// do not have their own hash.
+  ///
+  /// \sa getMemberInterfaceHash
+  void getInterfaceHashExcludingMembers(llvm::SmallString<32> &str) {
+    llvm::MD5::MD5Result result;
+    InterfaceHashExcludingMembers.final(result);
+    llvm::MD5::stringifyResult(result, str);
+  }
+
   void dumpInterfaceHash(llvm::raw_ostream &out) {
     llvm::SmallString<32> str;
     getInterfaceHash(str);
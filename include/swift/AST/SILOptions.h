@@ -60,12 +60,28 @@ public:
   /// Controls whether the SIL ARC optimizations are run.
   bool EnableARCOptimizations = true;
 
+  /// Pass the ordinary parameters of native functions at +0 (guaranteed)
+  /// instead of +1 (owned). Initializers still take their parameters owned.
+  bool EnableGuaranteedNormalArguments = false;
+
   /// Controls whether or not paranoid verification checks are run.
   bool VerifyAll = false;
 
+  /// When verifying after each pass, only verify the functions whose name
+  /// hashes into one in this many buckets. Zero or one verifies every function.
+  unsigned VerifySampleRate = 0;
+
+  /// When verifying after each pass, only verify the functions which the pass
+  /// has invalidated instead of the whole module.
+  bool VerifyIncremental = false;
+
   /// Are we debugging sil serialization.
   bool DebugSerialization = false;
 
+  /// Hide the symbols of a whole-module executable build which other images
+  /// cannot reference.
+  bool Internalize = false;
+
   /// Whether to dump verbose SIL with scope and location information.
   bool EmitVerboseSIL = false;
 
@@ -97,6 +113,12 @@ public:
 
   /// Should we use a pass pipeline passed in via a json file? Null by default.
   StringRef ExternalPassPipelineFilename;
+
+  /// If set, the SIL parser only parses the body of the function with this
+  /// name, which is either mangled or demangled without its type, such as
+  /// "Swift.Array.append". Every other function becomes an external
+  /// declaration without its body being parsed.
+  std::string ParseOnlyFunctionBody;
 };
 
 } // end namespace swift
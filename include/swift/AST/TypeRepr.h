@@ -17,6 +17,7 @@
 #ifndef SWIFT_AST_TYPEREPR_H
 #define SWIFT_AST_TYPEREPR_H
 
+#include "swift/AST/ASTNodeCounts.h"
 #include "swift/AST/Attr.h"
 #include "swift/AST/DeclContext.h"
 #include "swift/AST/Identifier.h"
@@ -54,7 +55,10 @@ class alignas(8) TypeRepr {
   SourceLoc getLocImpl() const { return getStartLoc(); }
 
 protected:
-  TypeRepr(TypeReprKind K) : Kind(static_cast<unsigned>(K)), Invalid(false) {}
+  TypeRepr(TypeReprKind K) : Kind(static_cast<unsigned>(K)), Invalid(false) {
+    if (ASTNodeCounts::Enabled)
+      ++ASTNodeCounts::TypeReprs[unsigned(K)];
+  }
 
 public:
   TypeReprKind getKind() const { return static_cast<TypeReprKind>(Kind); }
@@ -17,6 +17,7 @@
 #ifndef SWIFT_TYPES_H
 #define SWIFT_TYPES_H
 
+#include "swift/AST/ASTNodeCounts.h"
 #include "swift/AST/DeclContext.h"
 #include "swift/AST/DefaultArgumentKind.h"
 #include "swift/AST/Ownership.h"
@@ -299,6 +300,8 @@ protected:
     if (CanTypeCtx)
       CanonicalType = CanTypeCtx;
     setRecursiveProperties(properties);
+    if (ASTNodeCounts::Enabled)
+      ++ASTNodeCounts::Types[unsigned(kind)];
   }
 
   void setRecursiveProperties(RecursiveTypeProperties properties) {
@@ -1324,7 +1327,7 @@ typedef ArrayRefView<TupleTypeElt,CanType,getCanTupleEltType>
 /// TupleType - A tuple is a parenthesized list of types where each name has an
 /// optional name.
 ///
-class TupleType : public TypeBase, public llvm::FoldingSetNode {
+class TupleType : public TypeBase {
   const ArrayRef<TupleTypeElt> Elements;
   
 public:
@@ -1376,12 +1379,6 @@ public:
     return T->getKind() == TypeKind::Tuple;
   }
 
-  void Profile(llvm::FoldingSetNodeID &ID) {
-    Profile(ID, Elements);
-  }
-  static void Profile(llvm::FoldingSetNodeID &ID, 
-                      ArrayRef<TupleTypeElt> Elements);
-  
 private:
   TupleType(ArrayRef<TupleTypeElt> elements, const ASTContext *CanCtx,
             RecursiveTypeProperties properties)
@@ -1450,7 +1447,7 @@ typedef ArrayRefView<Type,CanType,getAsCanType> CanTypeArrayRef;
 
 /// BoundGenericType - An abstract class for applying a generic
 /// nominal type to the given type arguments.
-class BoundGenericType : public TypeBase, public llvm::FoldingSetNode {
+class BoundGenericType : public TypeBase {
   NominalTypeDecl *TheDecl;
 
   /// \brief The type of the parent, in which this type is nested.
@@ -1504,14 +1501,6 @@ public:
   /// this bound generic type, using the given context if possible.
   DeclContext *getGenericParamContext(DeclContext *gpContext) const;
 
-  void Profile(llvm::FoldingSetNodeID &ID) {
-    RecursiveTypeProperties properties;
-    Profile(ID, TheDecl, Parent, GenericArgs, properties);
-  }
-  static void Profile(llvm::FoldingSetNodeID &ID, NominalTypeDecl *TheDecl,
-                      Type Parent, ArrayRef<Type> GenericArgs,
-                      RecursiveTypeProperties &properties);
-
   // Implement isa/cast/dyncast/etc.
   static bool classof(const TypeBase *T) {
     return T->getKind() >= TypeKind::First_BoundGenericType &&
@@ -24,11 +24,16 @@ namespace swift {
   class SerializedModuleLoader;
 
   /// \brief Povided a memory buffer with an entire Mach-O __apple_ast
-  /// section, this function makes memory buffer copies of all swift
-  /// modules found in it and registers them using
-  /// registerMemoryBuffer() so they can be found by loadModule(). The
-  /// access path of all modules found in the section is appended to
-  /// the vector foundModules.
+  /// section, this function registers memory buffers for all swift
+  /// modules found in it using registerMemoryBuffer() so they can be
+  /// found by loadModule(). The access path of all modules found in the
+  /// section is appended to the vector foundModules.
+  ///
+  /// Only the control block of each module is read here; a module is
+  /// deserialized when loadModule() is first asked for it, so callers
+  /// should import the modules in foundModules as they are needed rather
+  /// than all up front. The buffers refer to \p Data, which must outlive
+  /// them.
   /// \return true if successful.
   bool parseASTSection(SerializedModuleLoader* SML, StringRef Data,
                        SmallVectorImpl<std::string> &foundModules);
@@ -129,6 +129,12 @@ protected:
   /// Invokes \c remove on all keys.
   void removeAll();
 
+  /// Sets the total cost above which the cache starts evicting values.
+  ///
+  /// The default cache implementation evicts the least recently used values
+  /// first; on Darwin this is a hint to libcache.
+  void setCostLimit(size_t Limit);
+
   /// Destroys cache.
   void destroy();
 };
@@ -192,6 +198,11 @@ public:
     removeAll();
   }
 
+  /// Sets the total cost of the values above which the cache evicts them.
+  void setCostLimit(size_t Limit) {
+    CacheImpl::setCostLimit(Limit);
+  }
+
 private:
   static uintptr_t keyHash(void *Key, void *UserData) {
     return KeyInfoT::getHashValue(*static_cast<KeyT*>(Key));
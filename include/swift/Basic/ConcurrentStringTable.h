@@ -0,0 +1,65 @@
+//===--- ConcurrentStringTable.h - Thread-safe string uniquing --*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ConcurrentStringTable, a set of uniqued strings that any
+// number of threads can intern into at the same time.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_CONCURRENTSTRINGTABLE_H
+#define SWIFT_BASIC_CONCURRENTSTRINGTABLE_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+
+namespace swift {
+
+/// A set of strings in which every distinct string is stored exactly once, so
+/// that interned strings can be compared by address.
+///
+/// The table is split into shards, selected by the string's hash, that each
+/// have their own lock and allocator. Looking up a string that is already in
+/// the table, which is by far the most common case, doesn't take any lock:
+/// each shard's buckets are published atomically, and readers that miss
+/// because of a concurrent insertion just retry under the shard's lock.
+class ConcurrentStringTable {
+  struct Entry;
+  struct Buckets;
+  struct Shard;
+
+  enum : unsigned { NumShards = 16 };
+  std::unique_ptr<Shard[]> Shards;
+
+public:
+  ConcurrentStringTable();
+  ~ConcurrentStringTable();
+
+  ConcurrentStringTable(const ConcurrentStringTable &) = delete;
+  ConcurrentStringTable &operator=(const ConcurrentStringTable &) = delete;
+
+  /// Returns the table's copy of \p Str, adding it if necessary.
+  ///
+  /// The copy is NUL-terminated, aligned to at least 4 bytes, and lives as
+  /// long as the table. This may be called from any thread.
+  const char *intern(StringRef Str);
+
+  /// Returns the number of distinct strings in the table.
+  size_t size() const;
+
+  /// Returns the memory used by the table, including the strings.
+  size_t getTotalMemory() const;
+};
+
+} // end namespace swift
+
+#endif
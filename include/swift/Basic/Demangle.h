@@ -158,23 +158,27 @@ private:
   typedef std::vector<NodePointer> NodeVector;
   NodeVector Children;
 
-  Node(Kind k)
+  /// Only NodeFactory can name this type, and so only NodeFactory can create
+  /// nodes, even though the constructors have to be public for
+  /// std::make_shared.
+  struct PrivateTag {};
+  friend struct NodeFactory;
+
+public:
+  Node(PrivateTag, Kind k)
       : NodeKind(k), NodePayloadKind(PayloadKind::None) {
   }
-  Node(Kind k, std::string &&t)
+  Node(PrivateTag, Kind k, std::string &&t)
       : NodeKind(k), NodePayloadKind(PayloadKind::Text) {
     new (&TextPayload) std::string(std::move(t));
   }
-  Node(Kind k, IndexType index)
+  Node(PrivateTag, Kind k, IndexType index)
       : NodeKind(k), NodePayloadKind(PayloadKind::Index) {
     IndexPayload = index;
   }
   Node(const Node &) = delete;
   Node &operator=(const Node &) = delete;
 
-  friend struct NodeFactory;
-
-public:
   ~Node();
 
   Kind getKind() const { return NodeKind; }
@@ -347,22 +351,27 @@ std::string mangleNode(const NodePointer &root);
 std::string nodeToString(NodePointer Root,
                          const DemangleOptions &Options = DemangleOptions());
 
+/// Creates demangler nodes.
+///
+/// Nodes are allocated with std::make_shared, so that each node and its
+/// reference count live in a single heap allocation.
 struct NodeFactory {
   static NodePointer create(Node::Kind K) {
-    return NodePointer(new Node(K));
+    return std::make_shared<Node>(Node::PrivateTag(), K);
   }
   static NodePointer create(Node::Kind K, Node::IndexType Index) {
-    return NodePointer(new Node(K, Index));
+    return std::make_shared<Node>(Node::PrivateTag(), K, Index);
   }
   static NodePointer create(Node::Kind K, llvm::StringRef Text) {
-    return NodePointer(new Node(K, Text));
+    return std::make_shared<Node>(Node::PrivateTag(), K, Text.str());
   }
   static NodePointer create(Node::Kind K, std::string &&Text) {
-    return NodePointer(new Node(K, std::move(Text)));
+    return std::make_shared<Node>(Node::PrivateTag(), K, std::move(Text));
   }
   template <size_t N>
   static NodePointer create(Node::Kind K, const char (&Text)[N]) {
-    return NodePointer(new Node(K, llvm::StringRef(Text)));
+    return std::make_shared<Node>(Node::PrivateTag(), K,
+                                  llvm::StringRef(Text).str());
   }
 };
 
@@ -0,0 +1,92 @@
+//===--- JobStats.h - Statistics of one compiler process --------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Collects the time, memory and counters of one driver or frontend
+/// process, and writes them as one JSON file per process to the directory
+/// given by -stats-output-dir.
+///
+/// The files of a whole build can then be combined by
+/// utils/process-stats-dir.py.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_JOBSTATS_H
+#define SWIFT_BASIC_JOBSTATS_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace swift {
+
+class TraceEventRecorder;
+
+/// The statistics of one compiler process.
+///
+/// Unlike the counters printed by -print-stats, these are collected by
+/// compilers built without assertions too.
+class JobStats {
+public:
+  using NamedValues = std::vector<std::pair<std::string, uint64_t>>;
+
+private:
+  std::string Kind;
+  std::string Name;
+  uint64_t StartTime;
+
+  /// Both lists keep the order in which values were first added, so that
+  /// files from different builds are easy to compare.
+  NamedValues Phases;
+  NamedValues Counters;
+
+public:
+  /// \p Kind is "driver" or "frontend". \p Name tells jobs of the same kind
+  /// apart, such as the module name and primary file of a frontend job.
+  ///
+  /// The wall time of the process is measured from the construction of this
+  /// object.
+  JobStats(StringRef Kind, StringRef Name);
+
+  /// Adds the time, in microseconds, spent in each phase. Phases that were
+  /// entered several times are summed.
+  void addPhase(StringRef Name, uint64_t Microseconds);
+
+  /// Adds every span of \p Events in category \p Category as a phase.
+  void addPhases(const TraceEventRecorder &Events, StringRef Category);
+
+  /// Adds \p Value to the counter \p Name, which starts at 0.
+  void addCounter(StringRef Name, uint64_t Value);
+
+  const NamedValues &getPhases() const { return Phases; }
+  const NamedValues &getCounters() const { return Counters; }
+
+  /// Returns the peak resident set size, in bytes, of this process, or of its
+  /// terminated child processes if \p Children is set. Returns 0 where this
+  /// isn't known.
+  static uint64_t getPeakResidentSetSize(bool Children = false);
+
+  /// Writes the statistics as a JSON object.
+  void write(raw_ostream &os) const;
+
+  /// Writes the statistics to a new file in \p Dir, creating \p Dir if
+  /// needed. The file is named after the kind and name of the job, with a
+  /// unique suffix, so that concurrent jobs never overwrite each other.
+  std::error_code writeToDirectory(StringRef Dir) const;
+};
+
+} // end namespace swift
+
+#endif
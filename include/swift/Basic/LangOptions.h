@@ -140,6 +140,10 @@ namespace swift {
     /// allocated by the constraint solver.
     unsigned SolverMemoryThreshold = 15000000;
 
+    /// \brief The upper bound, in seconds, of the time the constraint solver
+    /// may spend on a single expression, or 0 for no limit.
+    unsigned SolverExpressionTimeThreshold = 0;
+
     /// \brief Perform all dynamic allocations using malloc/free instead of
     /// optimized custom allocator, so that memory debugging tools can be used.
     bool UseMalloc = false;
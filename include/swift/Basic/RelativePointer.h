@@ -75,6 +75,9 @@ public:
 /// A relative reference to a function, intended to reference private metadata
 /// functions for the current executable or dynamic library image from
 /// position-independent constant data.
+///
+/// An offset of zero represents a null pointer. A reference can never point
+/// to itself, so this does not collide with a valid target.
 template<typename T>
 class RelativeDirectPointerImpl {
 private:
@@ -96,6 +99,9 @@ public:
   using PointerTy = T*;
 
   PointerTy get() const & {
+    if (RelativeOffset == 0)
+      return nullptr;
+
     // The function entry point is addressed relative to `this`.
     auto base = reinterpret_cast<intptr_t>(this);
     intptr_t absolute = base + RelativeOffset;
@@ -111,6 +117,8 @@ class RelativeDirectPointer :
 {
   using super = RelativeDirectPointerImpl<T>;
 public:
+  using super::get;
+
   operator typename super::PointerTy() const & {
     return this->get();
   }
@@ -132,11 +140,13 @@ class RelativeDirectPointer<RetTy (ArgTy...)> :
 {
   using super = RelativeDirectPointerImpl<RetTy (ArgTy...)>;
 public:
+  using super::get;
+
   operator typename super::PointerTy() const & {
     return this->get();
   }
 
-  RetTy operator()(ArgTy...arg) {
+  RetTy operator()(ArgTy...arg) const {
     return this->get()(std::forward<ArgTy>(arg)...);
   }
 };
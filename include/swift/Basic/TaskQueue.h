@@ -20,12 +20,14 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <queue>
 
 namespace swift {
 namespace sys {
 
 class Task; // forward declared to allow for platform-specific implementations
+class TaskMonitor;
 
 typedef llvm::sys::ProcessInfo::ProcessId ProcessId;
 
@@ -39,10 +41,30 @@ enum class TaskFinishedResponse {
 };
 
 /// \brief A class encapsulating the execution of multiple tasks in parallel.
+///
+/// On Unix, if MAKEFLAGS names a GNU make-compatible jobserver, each task
+/// beyond the first also needs a token from the jobserver before it begins
+/// execution, so that the number of parallel tasks never exceeds what the
+/// surrounding build allows.
+///
+/// On Unix, tasks are started and their output is collected on a separate
+/// thread, so that a slow callback doesn't keep the next task from starting.
+/// The callbacks are still called one at a time, in the order the events
+/// happened, on the thread which called \ref execute.
 class TaskQueue {
   /// Tasks which have not begun execution.
   std::queue<std::unique_ptr<Task>> QueuedTasks;
 
+  /// Guards QueuedTasks, which the callbacks passed to \ref execute may add
+  /// to while tasks are being started on another thread.
+  std::mutex QueuedTasksLock;
+
+  /// If set, this is called with QueuedTasksLock held whenever a task is
+  /// added, so that an execution which is waiting for tasks can start it.
+  std::function<void()> TaskAdded;
+
+  friend class TaskMonitor;
+
   /// The number of tasks to execute in parallel.
   unsigned NumberOfParallelTasks;
 
@@ -140,6 +162,7 @@ public:
   /// Returns true if there are any tasks that have been queued but have not
   /// yet been executed.
   bool hasRemainingTasks() {
+    std::lock_guard<std::mutex> Guard(QueuedTasksLock);
     return !QueuedTasks.empty();
   }
 };
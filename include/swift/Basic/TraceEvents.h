@@ -0,0 +1,113 @@
+//===--- TraceEvents.h - Timelines in the Chrome trace format ---*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Records spans of time and writes them as Chrome trace events, which
+/// can be loaded into chrome://tracing to see how a build spent its time.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_TRACEEVENTS_H
+#define SWIFT_BASIC_TRACEEVENTS_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace swift {
+
+/// A span of time in a trace.
+///
+/// Times are in microseconds since the Unix epoch, so that spans recorded by
+/// different processes line up.
+struct TraceEvent {
+  std::string Name;
+  std::string Category;
+  uint64_t Start = 0;
+  uint64_t Duration = 0;
+  uint64_t ProcessID = 0;
+  uint64_t ThreadID = 0;
+};
+
+/// Collects trace events and writes them in the Chrome trace-event format.
+///
+/// Spans may be added from several threads at once.
+class TraceEventRecorder {
+  std::vector<TraceEvent> Events;
+  mutable std::mutex Lock;
+
+public:
+  /// Returns the current time, in microseconds since the Unix epoch.
+  static uint64_t now();
+
+  /// Returns the recorder which phases of the compiler deep inside the
+  /// pipeline should add their spans to, or null if nothing is being traced.
+  static TraceEventRecorder *getActive();
+
+  /// Sets the recorder returned by getActive().
+  static void setActive(TraceEventRecorder *Recorder);
+
+  void addSpan(StringRef Name, StringRef Category, uint64_t Start,
+               uint64_t End, uint64_t ProcessID = 0, uint64_t ThreadID = 0);
+
+  /// Returns the recorded events. Must not be called while other threads are
+  /// still adding spans.
+  ArrayRef<TraceEvent> getEvents() const { return Events; }
+
+  /// Adds the events in \p Buffer, which must have been written by write(),
+  /// moving all of them to the given process and thread.
+  ///
+  /// \returns true if \p Buffer couldn't be read.
+  bool addEventsFrom(StringRef Buffer, uint64_t ProcessID, uint64_t ThreadID);
+
+  /// Writes all events as a JSON array.
+  void write(raw_ostream &os) const;
+
+  /// Writes all events to the file at \p Path.
+  std::error_code writeToFile(StringRef Path) const;
+};
+
+/// Records a span in a TraceEventRecorder covering the lifetime of this
+/// object. Does nothing if there is no recorder.
+///
+/// If no recorder is given, the active recorder is used.
+class TraceEventScope {
+  TraceEventRecorder *Recorder;
+  StringRef Name;
+  StringRef Category;
+  uint64_t Start;
+
+public:
+  TraceEventScope(TraceEventRecorder *Recorder, StringRef Name,
+                  StringRef Category)
+      : Recorder(Recorder), Name(Name), Category(Category),
+        Start(Recorder ? TraceEventRecorder::now() : 0) {}
+
+  TraceEventScope(StringRef Name, StringRef Category)
+      : TraceEventScope(TraceEventRecorder::getActive(), Name, Category) {}
+
+  TraceEventScope(const TraceEventScope &) = delete;
+  TraceEventScope &operator=(const TraceEventScope &) = delete;
+
+  ~TraceEventScope() {
+    if (Recorder)
+      Recorder->addSpan(Name, Category, Start, TraceEventRecorder::now());
+  }
+};
+
+} // end namespace swift
+
+#endif
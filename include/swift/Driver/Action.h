@@ -18,6 +18,8 @@
 #include "swift/Driver/Util.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/TimeValue.h"
+#include <string>
+#include <vector>
 
 namespace llvm {
 namespace opt {
@@ -45,9 +47,10 @@ public:
     REPLJob,
     LinkJob,
     GenerateDSYMJob,
+    ClangModulePrebuildJob,
 
     JobFirst=CompileJob,
-    JobLast=GenerateDSYMJob
+    JobLast=ClangModulePrebuildJob
   };
 
   static const char *getClassName(ActionClass AC);
@@ -132,6 +135,12 @@ public:
     };
     Status status = UpToDate;
     llvm::sys::TimeValue previousModTime;
+    /// How long the input took to compile in the previous build, or zero if
+    /// that isn't known.
+    llvm::sys::TimeValue previousCompileTime = llvm::sys::TimeValue::ZeroTime();
+    /// A hash of the input's contents in the previous build, or zero if that
+    /// isn't known.
+    uint64_t previousContentHash = 0;
 
     InputInfo() = default;
     InputInfo(Status stat, llvm::sys::TimeValue time)
@@ -249,6 +258,31 @@ public:
   }
 };
 
+/// Loads the given modules once, so that the Clang modules they need are
+/// built into the module cache before the compile jobs race to build them.
+class ClangModulePrebuildJobAction : public JobAction {
+  virtual void anchor();
+  std::vector<std::string> ModuleNames;
+  bool ImportsBridgingHeader;
+public:
+  ClangModulePrebuildJobAction(ArrayRef<std::string> ModuleNames,
+                               bool ImportsBridgingHeader)
+    : JobAction(Action::ClangModulePrebuildJob, llvm::None, types::TY_Nothing),
+      ModuleNames(ModuleNames.begin(), ModuleNames.end()),
+      ImportsBridgingHeader(ImportsBridgingHeader) {}
+
+  ArrayRef<std::string> getModuleNames() const { return ModuleNames; }
+
+  /// Whether this job also imports the bridging header and the underlying
+  /// module. Only one of the prebuild jobs does, so that they aren't imported
+  /// by several jobs at once.
+  bool importsBridgingHeader() const { return ImportsBridgingHeader; }
+
+  static bool classof(const Action *A) {
+    return A->getKind() == Action::ClangModulePrebuildJob;
+  }
+};
+
 class LinkJobAction : public JobAction {
   virtual void anchor();
   LinkKind Kind;
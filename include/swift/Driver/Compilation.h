@@ -20,6 +20,7 @@
 #include "swift/Driver/Job.h"
 #include "swift/Basic/ArrayRefView.h"
 #include "swift/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/TimeValue.h"
@@ -29,6 +30,7 @@
 
 namespace llvm {
 namespace opt {
+  class Arg;
   class InputArgList;
   class DerivedArgList;
 }
@@ -39,6 +41,7 @@ namespace swift {
 
 namespace driver {
   class Driver;
+  class OutputInfo;
   class ToolChain;
 
 /// An enum providing different levels of output which should be produced
@@ -71,6 +74,12 @@ private:
   /// The Jobs which will be performed by this compilation.
   SmallVector<std::unique_ptr<const Job>, 32> Jobs;
 
+  /// Jobs which build the Clang modules imported by the inputs. They are run
+  /// to completion before any of the other Jobs begin. Their failure doesn't
+  /// fail the compilation; the compile jobs diagnose any problems with the
+  /// imports themselves.
+  SmallVector<std::unique_ptr<const Job>, 4> PrebuildJobs;
+
   /// The original (untranslated) input argument list.
   std::unique_ptr<llvm::opt::InputArgList> InputArgs;
 
@@ -127,6 +136,26 @@ private:
   /// rebuilt.
   bool ShowIncrementalBuildDecisions = false;
 
+  /// If non-empty, a timeline of the jobs this compilation runs is written to
+  /// this file as Chrome trace events.
+  std::string TraceEventsPath;
+
+  /// If non-empty, the driver writes its statistics to a file in this
+  /// directory, named after \c StatsName.
+  std::string StatsOutputDir;
+  std::string StatsName;
+
+  /// Hashes of the current contents of the inputs, which are written to the
+  /// compilation record. Empty unless content hashing is enabled.
+  llvm::DenseMap<const llvm::opt::Arg *, uint64_t> InputContentHashes;
+
+  /// If set, compile jobs which are ready to run at the same time are
+  /// combined into batch jobs, each of which compiles several primary files
+  /// in one frontend invocation.
+  ///
+  /// This is also the OutputInfo which is used to construct the batch jobs.
+  std::unique_ptr<const OutputInfo> BatchModeOutputInfo;
+
   static const Job *unwrap(const std::unique_ptr<const Job> &p) {
     return p.get();
   }
@@ -153,6 +182,14 @@ public:
   }
   Job *addJob(std::unique_ptr<Job> J);
 
+  ArrayRefView<std::unique_ptr<const Job>, const Job *, Compilation::unwrap>
+  getPrebuildJobs() const {
+    return llvm::makeArrayRef(PrebuildJobs);
+  }
+  void addPrebuildJob(std::unique_ptr<Job> J) {
+    PrebuildJobs.push_back(std::move(J));
+  }
+
   void addTemporaryFile(StringRef file) {
     TempFilePaths.push_back(file.str());
   }
@@ -189,6 +226,30 @@ public:
     ShowIncrementalBuildDecisions = value;
   }
 
+  void setTraceEventsPath(StringRef path) {
+    TraceEventsPath = path;
+  }
+
+  void setStatsOutputDir(StringRef dir, StringRef name) {
+    StatsOutputDir = dir;
+    StatsName = name;
+  }
+
+  void setInputContentHashes(
+      llvm::DenseMap<const llvm::opt::Arg *, uint64_t> &&hashes) {
+    InputContentHashes = std::move(hashes);
+  }
+
+  /// Returns a hash of the contents of the file at \p path, or zero if it
+  /// can't be read.
+  static uint64_t computeContentHash(StringRef path);
+
+  bool getBatchModeEnabled() const {
+    return BatchModeOutputInfo != nullptr;
+  }
+  /// Enables batch mode, using \p OI to construct the batch jobs.
+  void enableBatchMode(const OutputInfo &OI);
+
   void setCompilationRecordPath(StringRef path) {
     assert(CompilationRecordPath.empty() && "already set");
     CompilationRecordPath = path;
@@ -210,6 +271,10 @@ private:
   /// value of -2 indicates that a Job crashed during execution.
   int performJobsImpl();
 
+  /// \brief Runs the PrebuildJobs in parallel and waits for all of them to
+  /// finish. Their output is discarded.
+  void performPrebuildJobs();
+
   /// \brief Performs a single Job by executing in place, if possible.
   ///
   /// \param Cmd the Job which should be performed.
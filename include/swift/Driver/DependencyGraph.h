@@ -56,6 +56,10 @@ public:
 
     /// The file was loaded successfully; anything that depends on the node
     /// should be considered out of date.
+    ///
+    /// If the only change to the node's interface is in members that carry
+    /// their own fingerprints, only the nodes that depend on those members
+    /// are affected. DependencyGraph::markTransitive takes this into account.
     AffectsDownstream
   };
 
@@ -90,6 +94,14 @@ private:
   struct ProvidesEntryTy {
     std::string name;
     DependencyMaskTy kindMask;
+    /// For a member, a hash of its declarations in the providing node, or
+    /// empty if changes to the member are covered by the node's
+    /// interface-hash-excluding-members.
+    std::string fingerprint;
+    /// Whether this entry was present in the most recent load of the node.
+    bool isCurrent;
+    /// Whether this entry changed in the most recent load of the node.
+    bool isChanged;
   };
   static_assert(std::is_move_constructible<ProvidesEntryTy>::value, "");
 
@@ -129,7 +141,67 @@ private:
   /// \sa SourceFile::getInterfaceHash
   llvm::DenseMap<const void *, std::string> InterfaceHashes;
 
+  /// The hash of each node's interface, leaving out the members that carry
+  /// their own fingerprints.
+  ///
+  /// \sa SourceFile::getInterfaceHashExcludingMembers
+  llvm::DenseMap<const void *, std::string> InterfaceHashesExcludingMembers;
+
+  /// Nodes whose most recent load only changed members with fingerprints.
+  ///
+  /// Marking one of these nodes only follows its changed "provides" entries.
+  llvm::SmallPtrSet<const void *, 16> ChangedOnlyInMembers;
+
+public:
+  /// One entry of a dependency file.
+  ///
+  /// Clients of DependencyGraph should have no reason to use this type.
+  /// It is only used in the implementation.
+  struct DependencyRecordTy {
+    enum class Type : uint8_t {
+      Provides,
+      Depends,
+      InterfaceHash,
+      InterfaceHashExcludingMembers
+    };
+
+    Type type;
+    DependencyKind kind;
+    bool isCascading;
+    /// The name of the dependency, or the hash for hash records.
+    std::string name;
+    std::string fingerprint;
+  };
+
+private:
+  /// The parsed contents of a dependency file, along with the status of the
+  /// file when it was parsed.
+  struct CachedFileTy {
+    uint64_t modTimeSeconds;
+    uint32_t modTimeNanoseconds;
+    uint64_t size;
+    std::vector<DependencyRecordTy> records;
+    /// Whether the file was loaded since the cache was read.
+    bool isUsed;
+  };
+
+  /// Parsed dependency files, keyed by path.
+  ///
+  /// This is filled in from the cache written by a previous build, so that
+  /// dependency files that haven't changed since then don't need to be
+  /// parsed again.
+  ///
+  /// \sa loadCache
+  llvm::StringMap<CachedFileTy> FileCache;
+
   LoadResult loadFromBuffer(const void *node, llvm::MemoryBuffer &buffer);
+  LoadResult loadFromRecords(const void *node,
+                             ArrayRef<DependencyRecordTy> records);
+
+  /// Marks the entries that are affected by a change to one of the members
+  /// in \p provides: the entry for the member's type as a whole, and the
+  /// dynamic lookup entry for the member's name.
+  void noteChangedMembers(MutableArrayRef<ProvidesEntryTy> provides);
 
   // FIXME: We should be able to use llvm::mapped_iterator for this, but
   // StringMapConstIterator isn't quite an InputIterator (no ->).
@@ -183,6 +255,21 @@ protected:
   }
 
 public:
+  /// Reads the dependency file cache written by #writeCache.
+  ///
+  /// Dependency files that haven't been modified since the cache was written
+  /// are loaded from the cache instead of being parsed again.
+  ///
+  /// \returns true if the cache could not be read. The graph is still usable
+  /// in that case; it just has to parse every dependency file.
+  bool loadCache(StringRef path);
+
+  /// Writes the contents of every dependency file loaded from disk to
+  /// \p path, in a form that's cheaper to load than the files themselves.
+  ///
+  /// \returns true if there was an error writing the cache.
+  bool writeCache(StringRef path) const;
+
   llvm::iterator_range<StringSetIterator> getExternalDependencies() const {
     return llvm::make_range(StringSetIterator(ExternalDependencies.begin()),
                             StringSetIterator(ExternalDependencies.end()));
@@ -243,6 +330,10 @@ public:
   /// ("depends") are not cleared; new dependencies are considered additive.
   ///
   /// If \p node has already been marked, only its outgoing edges are updated.
+  ///
+  /// If the interface of \p node changed in a way that only affects some of
+  /// its members, the next call to markTransitive for \p node only marks
+  /// the nodes that depend on those members.
   LoadResult loadFromPath(T node, StringRef path) {
     return DependencyGraphImpl::loadFromPath(Traits::getAsVoidPointer(node),
                                              path);
@@ -249,6 +249,17 @@ public:
   void buildJobs(const ActionList &Actions, const OutputInfo &OI,
                  const OutputFileMap *OFM, Compilation &C) const;
 
+  /// Add Jobs to Compilation \p C which load the modules imported by the
+  /// Swift files in \p Inputs, so that the Clang modules they need are built
+  /// before the compile jobs start.
+  ///
+  /// \param Inputs The inputs whose imports should be prebuilt
+  /// \param OI The OutputInfo for which Jobs should be generated
+  /// \param[out] C The Compilation to which Jobs should be added
+  void buildClangModulePrebuildJobs(const InputList &Inputs,
+                                    const OutputInfo &OI,
+                                    Compilation &C) const;
+
   /// A map for caching Jobs for a given Action/ToolChain pair
   using JobCacheMap =
     llvm::DenseMap<std::pair<const Action *, const ToolChain *>, Job *>;
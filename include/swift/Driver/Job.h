@@ -108,6 +108,10 @@ private:
   /// The modification time of the main input file, if any.
   llvm::sys::TimeValue InputModTime = llvm::sys::TimeValue::MaxTime();
 
+  /// How long this Job took to run in the previous build, or zero if that
+  /// isn't known.
+  llvm::sys::TimeValue PreviousCompileTime = llvm::sys::TimeValue::ZeroTime();
+
 public:
   Job(const Action &Source,
       SmallVectorImpl<const Job *> &&Inputs,
@@ -141,6 +145,14 @@ public:
     return InputModTime;
   }
 
+  void setPreviousCompileTime(llvm::sys::TimeValue time) {
+    PreviousCompileTime = time;
+  }
+
+  llvm::sys::TimeValue getPreviousCompileTime() const {
+    return PreviousCompileTime;
+  }
+
   /// Print the command line for this Job to the given \p stream,
   /// terminating output with the given \p terminator.
   void printCommandLine(raw_ostream &Stream, StringRef Terminator = "\n") const;
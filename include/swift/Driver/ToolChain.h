@@ -56,6 +56,10 @@ protected:
     ArrayRef<const Action *> InputActions;
     const llvm::opt::ArgList &Args;
     const OutputInfo &OI;
+
+    /// For a batch compile job, the outputs of each compile in the batch, in
+    /// the order of their primary inputs. Empty otherwise.
+    ArrayRef<const CommandOutput *> BatchedOutputs;
   };
 
   virtual std::pair<const char *, llvm::opt::ArgStringList>
@@ -84,6 +88,9 @@ protected:
   virtual std::pair<const char *, llvm::opt::ArgStringList>
   constructInvocation(const LinkJobAction &job,
                       const JobContext &context) const;
+  virtual std::pair<const char *, llvm::opt::ArgStringList>
+  constructInvocation(const ClangModulePrebuildJobAction &job,
+                      const JobContext &context) const;
 
   /// Searches for the given executable in appropriate paths relative to the
   /// Swift binary.
@@ -117,6 +124,14 @@ public:
                                     const llvm::opt::ArgList &args,
                                     const OutputInfo &OI) const;
 
+  /// Construct a single Job which performs all of the given compile jobs in
+  /// one frontend invocation, with each of their inputs as a primary file.
+  ///
+  /// The jobs must be standard compile jobs without any input jobs.
+  std::unique_ptr<Job> constructBatchJob(ArrayRef<const Job *> jobs,
+                                         const llvm::opt::ArgList &args,
+                                         const OutputInfo &OI) const;
+
   /// Return the default langauge type to use for the given extension.
   virtual types::ID lookupTypeForExtension(StringRef Ext) const;
 };
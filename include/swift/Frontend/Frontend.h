@@ -292,11 +292,17 @@ class CompilerInstance {
   std::unique_ptr<SILModule> TheSILModule;
 
   DependencyTracker *DepTracker = nullptr;
-  ReferencedNameTracker *NameTracker = nullptr;
+  /// The trackers for the names referenced by each primary source file, in
+  /// the order of the primary inputs.
+  std::vector<ReferencedNameTracker *> NameTrackers;
 
   Module *MainModule = nullptr;
   SerializedModuleLoader *SML = nullptr;
 
+  /// The parser state kept from performSema(), so that function bodies whose
+  /// parsing was delayed can still be parsed on demand.
+  std::unique_ptr<PersistentParserState> PersistentState;
+
   /// Contains buffer IDs for input source code files.
   std::vector<unsigned> BufferIDs;
 
@@ -313,10 +319,23 @@ class CompilerInstance {
   unsigned MainBufferID = NO_SUCH_BUFFER;
   unsigned PrimaryBufferID = NO_SUCH_BUFFER;
 
-  SourceFile *PrimarySourceFile = nullptr;
+  /// In batch mode, the buffer IDs of the primary inputs after the first.
+  std::vector<unsigned> AdditionalPrimaryBufferIDs;
+
+  /// The primary source files, in the order of the primary inputs. An entry
+  /// is null if its primary input is not a source file.
+  SmallVector<SourceFile *, 1> PrimarySourceFiles;
 
   void createSILModule(bool WholeModule = false);
-  void setPrimarySourceFile(SourceFile *SF);
+  void setPrimarySourceFile(SourceFile *SF, unsigned PrimaryIndex);
+
+  /// Returns the index of the primary input with the given buffer, if any.
+  Optional<unsigned> getPrimaryIndex(unsigned BufferID) const;
+
+  /// Records that the input with the given index and kind was loaded into
+  /// \p BufferID, if it is one of the primary inputs.
+  void recordPrimaryBuffer(unsigned InputIndex, SelectedInput::InputKind Kind,
+                           unsigned BufferID);
 
 public:
   SourceManager &getSourceMgr() { return SourceMgr; }
@@ -344,11 +363,16 @@ public:
   }
 
   void setReferencedNameTracker(ReferencedNameTracker *tracker) {
-    assert(!PrimarySourceFile && "must be called before performSema()");
-    NameTracker = tracker;
+    setReferencedNameTrackers(tracker);
   }
   ReferencedNameTracker *getReferencedNameTracker() {
-    return NameTracker;
+    return NameTrackers.empty() ? nullptr : NameTrackers.front();
+  }
+
+  /// Sets one tracker per primary input, in the order of the primary inputs.
+  void setReferencedNameTrackers(ArrayRef<ReferencedNameTracker *> trackers) {
+    assert(PrimarySourceFiles.empty() && "must be called before performSema()");
+    NameTrackers.assign(trackers.begin(), trackers.end());
   }
 
   /// Set the SIL module for this compilation instance.
@@ -386,7 +410,14 @@ public:
 
   /// Gets the SourceFile which is the primary input for this CompilerInstance.
   /// \returns the primary SourceFile, or nullptr if there is no primary input
-  SourceFile *getPrimarySourceFile() { return PrimarySourceFile; }
+  SourceFile *getPrimarySourceFile() {
+    return PrimarySourceFiles.empty() ? nullptr : PrimarySourceFiles.front();
+  }
+
+  /// Gets the SourceFiles of all primary inputs, in the order in which the
+  /// primary inputs were specified. An entry is null if its primary input is
+  /// not a source file.
+  ArrayRef<SourceFile *> getPrimarySourceFiles() { return PrimarySourceFiles; }
 
   /// \brief Returns true if there was an error during setup.
   bool setup(const CompilerInvocation &Invocation);
@@ -394,6 +425,18 @@ public:
   /// Parses and type-checks all input files.
   void performSema();
 
+  /// Parses the body of \p AFD if its parsing was delayed by performSema(),
+  /// for example because it is in a file other than the primary files.
+  void parseDelayedFunctionBody(AbstractFunctionDecl *AFD);
+
+  /// Makes \p SF, an input source file which is not a primary file, one of
+  /// the primary files after performSema(): its delayed function bodies are
+  /// parsed and the whole file is type-checked.
+  ///
+  /// This lets a client reuse the modules which are already loaded into the
+  /// ASTContext for another file of the same module.
+  void typeCheckAdditionalPrimaryFile(SourceFile &SF);
+
   /// Parses the input file but does no type-checking or module imports.
   /// Note that this only supports parsing an invocation with a single file.
   void performParseOnly();
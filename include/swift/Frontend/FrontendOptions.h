@@ -74,6 +74,14 @@ public:
   /// be generated for the whole module.
   Optional<SelectedInput> PrimaryInput;
 
+  /// In batch mode, the primary inputs after \c PrimaryInput, in command-line
+  /// order.
+  ///
+  /// Every primary input gets its own outputs, as if it had been compiled by
+  /// a separate frontend invocation, but the parsed and type-checked AST of
+  /// the module is shared between them.
+  std::vector<SelectedInput> AdditionalPrimaryInputs;
+
   /// The kind of input on which the frontend should operate.
   InputFileKind InputKind = InputFileKind::IFK_Swift;
 
@@ -115,9 +123,39 @@ public:
   /// The path to which we should output a fixits as source edits.
   std::string FixitsOutputPath;
 
+  /// The path to which we should output the time spent in each compiler
+  /// phase, as Chrome trace events.
+  std::string TraceEventsPath;
+
+  /// The path to which we should output statistics about what was
+  /// deserialized from each imported module, as JSON.
+  std::string ModuleLoadStatsPath;
+
+  /// The path to which we should output the size of each function and the
+  /// source declaration it came from, as JSON.
+  std::string CodeSizeReportPath;
+
+  /// The directory to which we should write a JSON file of the phase times,
+  /// memory use and counters of this job.
+  std::string StatsOutputDir;
+
+  /// In batch mode, the supplementary output paths of each primary input, in
+  /// the same order as the primary inputs. These are either empty or have one
+  /// entry per primary input.
+  struct BatchOutputPaths {
+    std::vector<std::string> ModuleOutputPaths;
+    std::vector<std::string> ModuleDocOutputPaths;
+    std::vector<std::string> DependenciesFilePaths;
+    std::vector<std::string> ReferenceDependenciesFilePaths;
+  } BatchOutputs;
+
   /// Arguments which should be passed in immediate mode.
   std::vector<std::string> ImmediateArgv;
 
+  /// The directory in which immediate mode caches machine code, or empty if
+  /// it shouldn't.
+  std::string ImmediateCachePath;
+
   /// \brief A list of arguments to forward to LLVM's option processing; this
   /// should only be used for debugging and experimental features.
   std::vector<std::string> LLVMArgs;
@@ -136,6 +174,10 @@ public:
     /// Parse, type-check, and dump type refinement context hierarchy
     DumpTypeRefinementContexts,
 
+    /// Load the implicitly imported modules, which builds the Clang modules
+    /// they need into the module cache, and exit
+    LoadImportedModules,
+
     EmitSILGen, ///< Emit raw SIL
     EmitSIL, ///< Emit canonical SIL
 
@@ -163,13 +205,36 @@ public:
   /// debugger to use.
   bool AlwaysSerializeDebuggingOptions = false;
 
+  /// Path prefixes to replace in the paths that are serialized into module
+  /// files, so that modules built in different directories are identical.
+  std::vector<std::pair<std::string, std::string>> SerializedPathPrefixMap;
+
   /// If set, dumps wall time taken to check each function body to llvm::errs().
   bool DebugTimeFunctionBodies = false;
 
+  /// If set, dumps the DebugTimeFunctionsLimit functions that took the most
+  /// time to compile, across all phases, to llvm::errs().
+  bool DebugTimeFunctions = false;
+  unsigned DebugTimeFunctionsLimit = 50;
+
+  /// If set, dumps wall time and solver work taken to check each expression
+  /// to llvm::errs().
+  bool DebugTimeExpressionTypeChecking = false;
+
   /// Indicates whether function body parsing should be delayed
   /// until the end of all files.
   bool DelayedFunctionBodyParsing = false;
 
+  /// Indicates whether function bodies in files other than the primary files
+  /// should be skipped without being parsed. They're never type-checked or
+  /// emitted in that case anyway.
+  bool SkipNonPrimaryFunctionBodies = false;
+
+  /// Indicates whether function bodies in files other than the primary files
+  /// should only be brace-matched and recorded, so that they're parsed later
+  /// only if something needs them.
+  bool DelayNonPrimaryFunctionBodies = true;
+
   /// Indicates whether or not an import statement can pick up a Swift source
   /// file (as opposed to a module file).
   bool EnableSourceImport = false;
@@ -199,6 +264,10 @@ public:
   /// termination.
   bool PrintStats = false;
 
+  /// Indicates whether or not the frontend should print the AST memory
+  /// report, with node counts by kind and arena sizes, upon termination.
+  bool PrintASTStats = false;
+
   /// Indicates whether or not the Clang importer should print statistics upon
   /// termination.
   bool PrintClangStats = false;
@@ -237,6 +306,19 @@ public:
   bool actionIsImmediate() const;
 
   void forAllOutputPaths(std::function<void(const std::string &)> fn) const;
+
+  /// Indicates whether more than one primary input was specified.
+  bool isBatchMode() const { return !AdditionalPrimaryInputs.empty(); }
+
+  /// Returns the number of primary inputs.
+  unsigned getNumPrimaryInputs() const {
+    return PrimaryInput.hasValue() ? 1 + AdditionalPrimaryInputs.size() : 0;
+  }
+
+  /// Returns the options for compiling only the primary input at
+  /// \p PrimaryIndex of a batch, with that input's outputs in the regular
+  /// output fields.
+  FrontendOptions getOptionsForBatchPrimary(unsigned PrimaryIndex) const;
   
   /// Gets the name of the specified output filename.
   /// If multiple files are specified, the last one is returned.
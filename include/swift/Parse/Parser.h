@@ -790,6 +790,9 @@ public:
                                        ParseDeclOptions Flags,
                                        DeclAttributes &Attributes);
   bool parseAbstractFunctionBodyDelayed(AbstractFunctionDecl *AFD);
+  bool parseAbstractFunctionBodyReplacement(AbstractFunctionDecl *AFD,
+                                            SourceLoc LBraceLoc,
+                                            SourceLoc RBraceLoc);
   ParserResult<ProtocolDecl> parseDeclProtocol(ParseDeclOptions Flags,
                                                DeclAttributes &Attributes);
 
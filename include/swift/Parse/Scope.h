@@ -19,8 +19,8 @@
 #define SWIFT_SEMA_SCOPE_H
 
 #include "swift/AST/Identifier.h"
-#include "swift/Basic/TreeScopedHashTable.h"
-#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include <vector>
 
 namespace swift {
   class ValueDecl;
@@ -30,20 +30,65 @@ namespace swift {
 
 /// ScopeInfo - A single instance of this class is maintained by the Parser to
 /// track the current scope.
+///
+/// The names bound in the active scopes are kept on one stack, in the order
+/// they were added, and each binding links to the outer binding of the same
+/// name that it shadows.  Entering and leaving a scope only moves the top of
+/// the stack, and a lookup is a single hash table probe.
 class ScopeInfo {
   friend class Scope;
 public:
-  typedef std::pair<unsigned, ValueDecl*> ValueScopeEntry;
-  
-  typedef TreeScopedHashTable<Identifier, ValueScopeEntry> ScopedHTTy;
-  typedef ScopedHTTy::ScopeTy ScopedHTScopeTy;
-  typedef ScopedHTTy::DetachedScopeTy ScopedHTDetachedScopeTy;
+  struct ValueScopeEntry {
+    Identifier Name;
+    ValueDecl *Decl;
+    /// The depth of the scope the name is bound in.
+    unsigned Depth;
+    /// The index of the binding of the same name this one shadows, or
+    /// \c NoEntry.
+    unsigned Shadowed;
+  };
+
+  enum : unsigned { NoEntry = ~0U };
 
 private:
-  ScopedHTTy HT;
+  /// The bindings of all active scopes, innermost last.
+  std::vector<ValueScopeEntry> Entries;
+
+  /// The index in \c Entries of the innermost binding of each name, or
+  /// \c NoEntry if it isn't bound anymore.
+  llvm::DenseMap<Identifier, unsigned> Innermost;
 
   Scope *CurScope = nullptr;
-  unsigned ResolvableDepth = 0;
+
+  /// Bindings below this index in \c Entries are outside of the innermost
+  /// non-resolvable scope, and are not found by lookups.
+  unsigned ResolvableBegin = 0;
+
+  void pushEntry(Identifier Name, ValueDecl *D, unsigned Depth) {
+    unsigned &Slot = Innermost.insert({Name, NoEntry}).first->second;
+    Entries.push_back({Name, D, Depth, Slot});
+    Slot = Entries.size() - 1;
+  }
+
+  /// Removes the bindings from \p Begin on, making the names they shadow
+  /// visible again.
+  void popEntries(unsigned Begin) {
+    while (Entries.size() > Begin) {
+      const ValueScopeEntry &Entry = Entries.back();
+      Innermost.find(Entry.Name)->second = Entry.Shadowed;
+      Entries.pop_back();
+    }
+  }
+
+  /// Returns the index of the innermost visible binding of \p Name, or
+  /// \c NoEntry.
+  unsigned findVisibleEntry(Identifier Name) const {
+    auto It = Innermost.find(Name);
+    if (It == Innermost.end() || It->second == NoEntry ||
+        It->second < ResolvableBegin)
+      return NoEntry;
+    return It->second;
+  }
 
 public:
   ValueDecl *lookupValueName(Identifier Name);
@@ -85,10 +130,13 @@ enum class ScopeKind {
 
 /// \brief An opaque object that owns the scope frame.  The scope frame can be
 /// re-entered later.
+///
+/// It holds a copy of the bindings that were visible from the scope, since
+/// the scopes they were bound in are usually gone by the time it's re-entered.
 class SavedScope {
   friend class Scope;
 
-  ScopeInfo::ScopedHTDetachedScopeTy HTDetachedScope;
+  std::vector<ScopeInfo::ValueScopeEntry> Entries;
   unsigned Depth;
   ScopeKind Kind;
   bool IsInactiveConfigBlock;
@@ -102,9 +150,9 @@ public:
   SavedScope &operator=(SavedScope &&) = default;
   ~SavedScope() = default;
 
-  SavedScope(ScopeInfo::ScopedHTDetachedScopeTy &&HTDetachedScope,
+  SavedScope(std::vector<ScopeInfo::ValueScopeEntry> &&Entries,
              unsigned Depth, ScopeKind Kind, bool IsInactiveConfigBlock)
-    : HTDetachedScope(std::move(HTDetachedScope)), Depth(Depth), Kind(Kind),
+    : Entries(std::move(Entries)), Depth(Depth), Kind(Kind),
       IsInactiveConfigBlock(IsInactiveConfigBlock) {}
 };
 
@@ -119,18 +167,22 @@ class Scope {
   void operator=(const Scope&) = delete;
 
   ScopeInfo &SI;
-  ScopeInfo::ScopedHTScopeTy HTScope;
 
   Scope *PrevScope;
-  unsigned PrevResolvableDepth;
+  unsigned PrevResolvableBegin;
+  /// The index in \c SI.Entries of the first binding of this scope.
+  unsigned EntriesBegin;
   unsigned Depth;
   ScopeKind Kind;
   bool IsInactiveConfigBlock;
 
-  /// \brief Save this scope so that it can be re-entered later.  Transfers the
-  /// ownership of the scope frame to returned object.
+  /// \brief Save this scope so that it can be re-entered later, together with
+  /// the bindings visible from it.
   SavedScope saveScope() {
-    return SavedScope(HTScope.detach(), Depth, Kind, IsInactiveConfigBlock);
+    assert(SI.CurScope == this && "can only save the current scope");
+    std::vector<ScopeInfo::ValueScopeEntry> Visible(
+        SI.Entries.begin() + SI.ResolvableBegin, SI.Entries.end());
+    return SavedScope(std::move(Visible), Depth, Kind, IsInactiveConfigBlock);
   }
 
   unsigned getDepth() const {
@@ -143,18 +195,17 @@ public:
   /// \brief Create a lexical scope of the specified kind.
   Scope(Parser *P, ScopeKind SC, bool IsInactiveConfigBlock = false);
 
-  /// \brief Re-enter the specified scope, transferring the ownership of the
-  /// scope frame to the new object.
+  /// \brief Re-enter the specified scope, with the bindings that were visible
+  /// when it was saved.
   Scope(Parser *P, SavedScope &&SS);
 
   ScopeKind getKind() const { return Kind; }
 
   ~Scope() {
-    // Active config blocks delegate to the enclosing scope, so there's nothing
-    // to pop off.
     assert(SI.CurScope == this && "Scope mismatch");
+    SI.popEntries(EntriesBegin);
     SI.CurScope = PrevScope;
-    SI.ResolvableDepth = PrevResolvableDepth;
+    SI.ResolvableBegin = PrevResolvableBegin;
   }
 };
 
@@ -168,10 +219,10 @@ inline ValueDecl *ScopeInfo::lookupValueName(Identifier Name) {
   // If we found nothing, or we found a decl at the top-level, return nothing.
   // We ignore results at the top-level because we may have overloading that
   // will be resolved properly by name binding.
-  std::pair<unsigned, ValueDecl *> Res = HT.lookup(CurScope->HTScope, Name);
-  if (Res.first < ResolvableDepth)
-    return 0;
-  return Res.second;
+  unsigned Index = findVisibleEntry(Name);
+  if (Index == NoEntry)
+    return nullptr;
+  return Entries[Index].Decl;
 }
 
 inline bool ScopeInfo::isInactiveConfigBlock() const {
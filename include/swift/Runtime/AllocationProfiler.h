@@ -0,0 +1,60 @@
+//===--- AllocationProfiler.h - Sampling heap profiler ----------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Interface to the runtime's sampling allocation profiler.
+//
+// The profiler samples about one in every N bytes allocated through
+// swift_slowAlloc, which includes every heap object, and records the type of
+// the object and a few frames of the allocating stack. Profiles are written
+// in the legacy heap format of gperftools, which pprof reads.
+//
+// The profiler is built into every runtime and costs one relaxed load per
+// allocation while it is off. It can be turned on from the environment:
+//
+//   SWIFT_ALLOCATION_PROFILE=<N>  Sample one in about N bytes, or one in
+//                                 512 KiB if N is 1.
+//   SWIFT_ALLOCATION_PROFILE_PATH=<prefix>
+//                                 Write profiles to
+//                                 <prefix>.<pid>.<sequence>.heap, when the
+//                                 process exits and whenever it receives
+//                                 the dump signal. Defaults to "swift-alloc".
+//   SWIFT_ALLOCATION_PROFILE_SIGNAL=<signal number>
+//                                 The dump signal; SIGUSR2 by default, or
+//                                 none if 0.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_RUNTIME_ALLOCATIONPROFILER_H
+#define SWIFT_RUNTIME_ALLOCATIONPROFILER_H
+
+#include <cstddef>
+
+namespace swift {
+
+/// Starts sampling one in about \p bytesPerSample allocated bytes. Samples
+/// taken before stay in the profile.
+extern "C" void swift_startAllocationProfiler(size_t bytesPerSample);
+
+/// Stops taking samples. Sampled allocations which are freed later are
+/// still removed from the in-use part of the profile.
+extern "C" void swift_stopAllocationProfiler();
+
+/// Forgets every sample taken so far.
+extern "C" void swift_resetAllocationProfile();
+
+/// Writes the samples taken so far to the file descriptor \p fd, in the
+/// gperftools heap profile format. Returns false if writing failed.
+extern "C" bool swift_writeAllocationProfile(int fd);
+
+} // end namespace swift
+
+#endif
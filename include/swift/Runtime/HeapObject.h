@@ -183,6 +183,14 @@ static inline void _swift_retain_inlined(HeapObject *object) {
   }
 }
 
+/// Increments the retain count of an object without using atomic
+/// operations.  The compiler only emits calls to this when it can prove that
+/// the object is not visible to any other thread.
+///
+/// \param object - may be null, in which case this is a no-op
+extern "C" void swift_nonatomic_retain(HeapObject *object);
+extern "C" void swift_nonatomic_retain_n(HeapObject *object, uint32_t n);
+
 /// Atomically increments the reference count of an object, unless it has
 /// already been destroyed. Returns nil if the object is dead.
 extern "C" HeapObject *swift_tryRetain(HeapObject *object);
@@ -226,6 +234,14 @@ extern "C" void swift_release(HeapObject *object);
 /// count reaches zero, the object is destroyed
 extern "C" void swift_release_n(HeapObject *object, uint32_t n);
 
+/// Decrements the retain count of an object without using atomic
+/// operations, destroying it if the count reaches zero.  The same
+/// restrictions as for swift_nonatomic_retain apply.
+///
+/// \param object - may be null, in which case this is a no-op
+extern "C" void swift_nonatomic_release(HeapObject *object);
+extern "C" void swift_nonatomic_release_n(HeapObject *object, uint32_t n);
+
 /// ObjC compatibility. Never call this.
 extern "C" size_t swift_retainCount(HeapObject *object);
 extern "C" size_t swift_weakRetainCount(HeapObject *object);
@@ -401,6 +417,11 @@ extern "C" void swift_retainUnowned(HeapObject *value);
 extern "C" void swift_checkUnowned(HeapObject *value);
 
 /// A weak reference value object.  This is ABI.
+///
+/// When the runtime is built with SWIFT_RUNTIME_ENABLE_WEAK_SIDE_TABLE,
+/// Value points to the object's weak reference side table entry rather than
+/// to the object itself, and must only be accessed through the functions
+/// below.
 struct WeakReference {
   HeapObject *Value;
 };
@@ -35,17 +35,17 @@
 namespace swift {
 
 /// A bump pointer for metadata allocations. Since metadata is (currently)
-/// never released, it does not support deallocation. This allocator by itself
-/// is not thread-safe; in concurrent uses, allocations must be guarded by
-/// a lock, such as the per-metadata-cache lock used to guard metadata
-/// instantiations. All allocations are pointer-aligned.
+/// never released, it does not support deallocation. The allocator is
+/// thread-safe: the bump pointer is advanced with a compare-and-swap, so
+/// entries for different keys of a metadata cache can be instantiated
+/// concurrently. All allocations are pointer-aligned.
 class MetadataAllocator {
   /// Address of the next available space. The allocator grabs a page at a time,
   /// so the need for a new page can be determined by page alignment.
   ///
   /// Initializing to -1 instead of nullptr ensures that the first allocation
   /// triggers a page allocation since it will always span a "page" boundary.
-  char *next = (char*)(~(uintptr_t)0U);
+  std::atomic<char *> next{(char*)(~(uintptr_t)0U)};
   
 public:
   MetadataAllocator() = default;
@@ -1189,7 +1189,7 @@ struct NominalTypeDescriptor {
   /// The kind of nominal type descriptor.
   NominalTypeKind Kind;
   /// The mangled name of the nominal type, with no generic parameters.
-  const char *Name;
+  RelativeDirectPointer<const char> Name;
   
   /// The following fields are kind-dependent.
   union {
@@ -1209,12 +1209,12 @@ struct NominalTypeDescriptor {
       
       /// The field names. A doubly-null-terminated list of strings, whose
       /// length and order is consistent with that of the field offset vector.
-      const char *FieldNames;
+      RelativeDirectPointer<const char> FieldNames;
       
       /// The field type vector accessor. Returns a pointer to an array of
       /// type metadata references whose order is consistent with that of the
       /// field offset vector.
-      const FieldType *(*GetFieldTypes)(const Metadata *Self);
+      RelativeDirectPointer<const FieldType *(const Metadata *)> GetFieldTypes;
 
       /// True if metadata records for this type have a field offset vector for
       /// its stored properties.
@@ -1233,12 +1233,12 @@ struct NominalTypeDescriptor {
       
       /// The field names. A doubly-null-terminated list of strings, whose
       /// length and order is consistent with that of the field offset vector.
-      const char *FieldNames;
+      RelativeDirectPointer<const char> FieldNames;
       
       /// The field type vector accessor. Returns a pointer to an array of
       /// type metadata references whose order is consistent with that of the
       /// field offset vector.
-      const FieldType *(*GetFieldTypes)(const Metadata *Self);
+      RelativeDirectPointer<const FieldType *(const Metadata *)> GetFieldTypes;
 
       /// True if metadata records for this type have a field offset vector for
       /// its stored properties.
@@ -1256,11 +1256,11 @@ struct NominalTypeDescriptor {
       /// The names of the cases. A doubly-null-terminated list of strings,
       /// whose length is NumNonEmptyCases + NumEmptyCases. Cases are named in
       /// tag order, non-empty cases first, followed by empty cases.
-      const char *CaseNames;
+      RelativeDirectPointer<const char> CaseNames;
       /// The field type vector accessor. Returns a pointer to an array of
       /// type metadata references whose order is consistent with that of the
       /// CaseNames. Only types for payload cases are provided.
-      const FieldType *(*GetCaseTypes)(const Metadata *Self);
+      RelativeDirectPointer<const FieldType *(const Metadata *)> GetCaseTypes;
 
       uint32_t getNumPayloadCases() const {
         return NumPayloadCasesAndPayloadSizeOffset & 0x00FFFFFFU;
@@ -1283,7 +1283,7 @@ struct NominalTypeDescriptor {
   
   /// A pointer to the generic metadata pattern that is used to instantiate
   /// instances of this type. Null if the type is not generic.
-  GenericMetadata *GenericMetadataPattern;
+  RelativeDirectPointer<GenericMetadata> GenericMetadataPattern;
   
   /// The generic parameter descriptor header. This describes how to find and
   /// parse the generic parameter vector in metadata records for this nominal
@@ -1488,7 +1488,7 @@ public:
   /// Get a pointer to the field type vector, if present, or null.
   const FieldType *getFieldTypes() const {
     assert(isTypeMetadata());
-    auto *getter = Description->Class.GetFieldTypes;
+    auto *getter = Description->Class.GetFieldTypes.get();
     if (!getter)
       return nullptr;
     
@@ -1666,7 +1666,7 @@ struct StructMetadata : public Metadata {
   
   /// Get a pointer to the field type vector, if present, or null.
   const FieldType *getFieldTypes() const {
-    auto *getter = Description->Struct.GetFieldTypes;
+    auto *getter = Description->Struct.GetFieldTypes.get();
     if (!getter)
       return nullptr;
     
@@ -2285,6 +2285,19 @@ extern "C" const Metadata *
 swift_getGenericMetadata(GenericMetadata *pattern,
                          const void *arguments);
 
+/// \brief Register metadata that was built ahead of time, such as a
+/// statically-emitted specialization, as the metadata of a generic nominal
+/// type for the given arguments.
+///
+/// Later calls to swift_getGenericMetadata for those arguments return the
+/// registered metadata without instantiating the pattern. If the arguments
+/// already have metadata, it's kept and the new metadata is ignored. Returns
+/// the metadata that ends up in the cache.
+extern "C" const Metadata *
+swift_registerGenericMetadata(GenericMetadata *pattern,
+                              const void *arguments,
+                              const Metadata *metadata);
+
 // Fast entry points for swift_getGenericMetadata with a small number of
 // template arguments.
 extern "C" const Metadata *
@@ -2515,6 +2528,17 @@ swift_dynamicCast(OpaqueValue *dest, OpaqueValue *src,
                   const Metadata *targetType,
                   DynamicCastFlags flags);
 
+/// \brief Report how often swift_dynamicCast could use a cached cast
+/// strategy. The counters are only maintained when the process runs with
+/// SWIFT_DEBUG_DYNAMIC_CAST_CACHE_STATISTICS set.
+///
+/// \param hits Casts performed with a previously cached strategy.
+/// \param misses Casts whose strategy was resolved and added to the cache.
+/// \param uncacheable Casts that had to take the general path.
+extern "C" void
+swift_getDynamicCastCacheStatistics(uint64_t *hits, uint64_t *misses,
+                                    uint64_t *uncacheable);
+
 /// \brief Checked dynamic cast to a Swift class type.
 ///
 /// \param object The object to cast.
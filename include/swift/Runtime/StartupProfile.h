@@ -0,0 +1,43 @@
+//===--- StartupProfile.h - Runtime startup time breakdown ------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Interface to the runtime's startup profile, which times the work the
+// runtime does on behalf of each loaded image:
+//
+//   - registering the image's protocol conformance records,
+//   - running the global initializers of swift_once, and
+//   - laying out classes in swift_initClassMetadata_UniversalStrategy.
+//
+// Each phase is timed without the phases nested in it, and is attributed to
+// the image that contains the conformance records, the initializer or the
+// class. The profile is off until it is enabled, either by setting the
+// environment variable SWIFT_STARTUP_PROFILE=1, which also prints the profile
+// to stderr when the process exits, or by calling
+// swift_setStartupProfileEnabled.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_RUNTIME_STARTUPPROFILE_H
+#define SWIFT_RUNTIME_STARTUPPROFILE_H
+
+namespace swift {
+
+/// Starts or stops timing. Times recorded so far stay in the profile.
+extern "C" void swift_setStartupProfileEnabled(bool enabled);
+
+/// Writes a table of the count and time of each phase, per image, to the
+/// file descriptor \p fd. Returns false if writing failed.
+extern "C" bool swift_writeStartupProfile(int fd);
+
+} // end namespace swift
+
+#endif
@@ -0,0 +1,56 @@
+//===--- Statistics.h - Swift Runtime event counters ------------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Interface for reading the runtime's event counters.
+//
+// Counting is only available if the runtime was built with
+// SWIFT_RUNTIME_ENABLE_STATISTICS. Even then it is off until it is enabled,
+// either by setting the environment variable SWIFT_RUNTIME_STATISTICS=1 or by
+// calling swift_setRuntimeStatisticsEnabled. SWIFT_RUNTIME_STATISTICS=print
+// also prints the totals to stderr at exit.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_RUNTIME_STATISTICS_H
+#define SWIFT_RUNTIME_STATISTICS_H
+
+#include <cstdint>
+
+namespace swift {
+
+/// A snapshot of the runtime's event counters, summed over all threads.
+struct SwiftRuntimeStatistics {
+#define RUNTIME_STATISTIC(Name, Description) uint64_t Name;
+#include "swift/Runtime/RuntimeStatistics.def"
+};
+
+/// Returns true if the runtime was built with statistics support.
+extern "C" bool swift_runtimeStatisticsAvailable();
+
+/// Starts or stops counting. Returns false if the runtime was built without
+/// statistics support.
+extern "C" bool swift_setRuntimeStatisticsEnabled(bool enabled);
+
+/// Fills in the counters accumulated by all live and exited threads.
+/// Counters are updated without synchronization, so a snapshot taken while
+/// other threads are running is approximate.
+///
+/// Returns false and zeroes *stats if the runtime was built without
+/// statistics support.
+extern "C" bool swift_getRuntimeStatistics(SwiftRuntimeStatistics *stats);
+
+/// Resets all counters to zero.
+extern "C" void swift_resetRuntimeStatistics();
+
+} // end namespace swift
+
+#endif
@@ -60,6 +60,24 @@ public:
   bool isValid(SILFunction *F) const {
     return getNode(&F->front()) != nullptr;
   }
+
+  /// Updates the tree for a new edge from \p From to \p To, which is already
+  /// in the CFG. Blocks which the edge makes reachable are added by
+  /// recalculating the tree; new blocks should be added with addNewBlock()
+  /// first.
+  void insertEdge(SILBasicBlock *From, SILBasicBlock *To);
+
+  /// Updates the tree for the removal of the edge from \p From to \p To,
+  /// which is already removed from the CFG. Blocks which are no longer
+  /// reachable are removed from the tree.
+  ///
+  /// When an edge is redirected, first delete the old edge and then insert
+  /// the new one.
+  void deleteEdge(SILBasicBlock *From, SILBasicBlock *To);
+
+  /// Updates the tree after \p Succ, the only successor of \p BB and with
+  /// \p BB as its only predecessor, was merged into \p BB and erased.
+  void mergeBlocks(SILBasicBlock *BB, SILBasicBlock *Succ);
   void reset() {
     llvm::DominatorTreeBase<SILBasicBlock>::reset();
   }
@@ -148,6 +166,18 @@ public:
   bool isValid(SILFunction *F) const { return getNode(&F->front()) != nullptr; }
 
   using DominatorTreeBase::properlyDominates;
+
+  /// Updates the tree for a new edge from \p From to \p To, which is already
+  /// in the CFG. See DominanceInfo::insertEdge().
+  void insertEdge(SILBasicBlock *From, SILBasicBlock *To);
+
+  /// Updates the tree for the removal of the edge from \p From to \p To,
+  /// which is already removed from the CFG. See DominanceInfo::deleteEdge().
+  void deleteEdge(SILBasicBlock *From, SILBasicBlock *To);
+
+  /// Updates the tree after \p Succ, the only successor of \p BB and with
+  /// \p BB as its only predecessor, was merged into \p BB and erased.
+  void mergeBlocks(SILBasicBlock *BB, SILBasicBlock *Succ);
 };
 
 
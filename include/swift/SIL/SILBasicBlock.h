@@ -318,7 +318,7 @@ public:
   SILBasicBlock *provideInitialHead() const { return createSentinel(); }
   SILBasicBlock *ensureHead(SILBasicBlock*) const { return createSentinel(); }
   static void noteHead(SILBasicBlock*, SILBasicBlock*) {}
-  static void deleteNode(SILBasicBlock *BB) { BB->~SILBasicBlock(); }
+  static void deleteNode(SILBasicBlock *BB);
 
   void addNodeToList(SILBasicBlock *BB) {
   }
@@ -988,13 +988,19 @@ public:
     return insert(new (F.getModule())
                       CopyBlockInst(createSILDebugLocation(Loc), Operand));
   }
-  StrongRetainInst *createStrongRetain(SILLocation Loc, SILValue Operand) {
-    return insert(new (F.getModule())
+  StrongRetainInst *createStrongRetain(SILLocation Loc, SILValue Operand,
+                                       bool NonAtomic = false) {
+    auto *RI = insert(new (F.getModule())
                       StrongRetainInst(createSILDebugLocation(Loc), Operand));
+    RI->setNonAtomic(NonAtomic);
+    return RI;
   }
-  StrongReleaseInst *createStrongRelease(SILLocation Loc, SILValue Operand) {
-    return insert(new (F.getModule())
+  StrongReleaseInst *createStrongRelease(SILLocation Loc, SILValue Operand,
+                                         bool NonAtomic = false) {
+    auto *RI = insert(new (F.getModule())
                       StrongReleaseInst(createSILDebugLocation(Loc), Operand));
+    RI->setNonAtomic(NonAtomic);
+    return RI;
   }
   StrongRetainAutoreleasedInst *
   createStrongRetainAutoreleased(SILLocation Loc, SILValue Operand) {
@@ -261,7 +261,10 @@ public:
   /// Invoke an Instruction's destructor. This dispatches to the appropriate
   /// leaf class destructor for the type of the instruction. This does not
   /// deallocate the instruction.
-  static void destroy(SILInstruction *I);
+  ///
+  /// Returns the size of the leaf class, which is a lower bound for the size of
+  /// the instruction's allocation.
+  static size_t destroy(SILInstruction *I);
 
   /// Returns true if the instruction can be duplicated without any special
   /// additional handling. It is important to know this information when
@@ -2072,12 +2075,20 @@ public:
 /// RefCountingInst - An abstract class of instructions which
 /// manipulate the reference count of their object operand.
 class RefCountingInst : public SILInstruction {
+  /// If true, the reference count may be manipulated with non-atomic
+  /// operations because the object is not visible to other threads.
+  bool NonAtomic = false;
+
 protected:
   RefCountingInst(ValueKind Kind, SILDebugLocation *DebugLoc,
                   SILTypeList *TypeList = 0)
       : SILInstruction(Kind, DebugLoc, TypeList) {}
 
 public:
+  bool isNonAtomic() const { return NonAtomic; }
+
+  void setNonAtomic(bool Value = true) { NonAtomic = Value; }
+
   static bool classof(const ValueBase *V) {
     return V->getKind() >= ValueKind::First_RefCountingInst &&
            V->getKind() <= ValueKind::Last_RefCountingInst;
@@ -4433,9 +4444,7 @@ public:
   SILInstruction *provideInitialHead() const { return createSentinel(); }
   SILInstruction *ensureHead(SILInstruction*) const { return createSentinel(); }
   static void noteHead(SILInstruction*, SILInstruction*) {}
-  static void deleteNode(SILInstruction *V) {
-    SILInstruction::destroy(V);
-  }
+  void deleteNode(SILInstruction *V);
 
   void addNodeToList(SILInstruction *I);
   void removeNodeFromList(SILInstruction *I);
@@ -33,6 +33,7 @@
 #include "swift/SIL/SILWitnessTable.h"
 #include "swift/SIL/TypeLowering.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SetVector.h"
@@ -89,6 +90,7 @@ private:
   friend class SILCoverageMap;
   friend class SILFunction;
   friend class SILGlobalVariable;
+  friend class SILLinkerVisitor;
   friend class SILType;
   friend class SILVTable;
   friend class SILUndef;
@@ -99,6 +101,18 @@ private:
 
   /// Allocator that manages the memory of all the pieces of the SILModule.
   mutable llvm::BumpPtrAllocator BPA;
+
+  /// The number of size classes of memory that is recycled by deallocate().
+  /// Class N holds blocks of at least N pointer-sized words; the last class
+  /// also holds all larger blocks.
+  enum { NumFreeListSizeClasses = 32 };
+
+  /// Free lists of memory that was released by deallocate(), for example the
+  /// storage of erased instructions and basic blocks. Each free block stores
+  /// the pointer to the next one.
+  mutable void *FreeLists[NumFreeListSizeClasses + 1] = {};
+
+  void *allocateFromFreeList(unsigned Size, unsigned Align) const;
   void *TypeListUniquing;
 
   /// The swift Module associated with this SILModule.
@@ -123,6 +137,10 @@ private:
   
   /// Stores the names of zombie functions.
   llvm::BumpPtrAllocator zombieFunctionNames;
+
+  /// The mangled names of SILDeclRefs which were requested with
+  /// getMangledName(). The strings are allocated in \p BPA.
+  llvm::DenseMap<SILDeclRef, StringRef> MangledNames;
   
   /// Lookup table for SIL vtables from class decls.
   llvm::DenseMap<const ClassDecl *, SILVTable *> VTableLookupTable;
@@ -137,6 +155,16 @@ private:
   /// The list of SILWitnessTables in the module.
   WitnessTableListType witnessTables;
 
+  /// The vtable root methods which the linker has seen called through a
+  /// class_method instruction. Only these entries of linked vtables get their
+  /// function bodies deserialized, the other entries stay declarations.
+  llvm::DenseSet<SILDeclRef> LinkedClassMethods;
+
+  /// The protocol requirements which the linker has seen called through a
+  /// witness_method instruction. Only these entries of linked witness tables
+  /// get their function bodies deserialized.
+  llvm::DenseSet<SILDeclRef> LinkedWitnessMethods;
+
   /// Lookup table for SIL Global Variables.
   llvm::StringMap<SILGlobalVariable *> GlobalVariableTable;
 
@@ -277,6 +305,14 @@ public:
     return wholeModule;
   }
 
+  /// Returns true if the public symbols of this module are not needed by
+  /// other images, so that they can be given hidden linkage. This is the case
+  /// for whole-module compilations of executables with -internalize.
+  bool canInternalizeSymbols() const {
+    return Options.Internalize && wholeModule &&
+           TheSwiftModule->hasEntryPoint();
+  }
+
   SILOptions &getOptions() const { return Options; }
 
   using iterator = FunctionListType::iterator;
@@ -384,6 +420,12 @@ public:
   /// \return null if this module has no such function
   SILFunction *lookUpFunction(SILDeclRef fnRef);
 
+  /// Returns the mangled name of \p constant.
+  ///
+  /// The name is only mangled the first time it is requested, and lives as
+  /// long as the module.
+  StringRef getMangledName(SILDeclRef constant);
+
   /// Attempt to link the SILFunction. Returns true if linking succeeded, false
   /// otherwise.
   ///
@@ -490,6 +532,11 @@ public:
   /// invariants.
   void verify() const;
 
+  /// \brief Run the SIL verifier on the module, but only verify the bodies
+  /// of the functions for which \p ShouldVerifyFunction returns true.
+  void verify(
+      std::function<bool(const SILFunction &)> ShouldVerifyFunction) const;
+
   /// Pretty-print the module.
   void dump(bool Verbose = false) const;
   
@@ -518,9 +565,17 @@ public:
     if (getASTContext().LangOpts.UseMalloc)
       return AlignedAlloc(Size, Align);
 
+    if (void *Recycled = allocateFromFreeList(Size, Align))
+      return Recycled;
     return BPA.Allocate(Size, Align);
   }
 
+  /// Give memory that was returned by allocate() back to the module, so that
+  /// later allocations can reuse it.
+  ///
+  /// \p Size may be smaller than the size that was allocated, but not larger.
+  void deallocate(void *Ptr, unsigned Size) const;
+
   /// \brief Looks up the llvm intrinsic ID and type for the builtin function.
   ///
   /// \returns Returns llvm::Intrinsic::not_intrinsic if the function is not an
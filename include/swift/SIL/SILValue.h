@@ -123,6 +123,11 @@ public:
   /// (see comment in DebugUtils.h).
   inline bool hasOneUse() const;
 
+  /// Returns the use of this value if it has exactly one use, or null
+  /// otherwise. This avoids walking the use list twice for the common
+  /// "check for a single use, then look at it" pattern.
+  inline Operand *getSingleUse() const;
+
   /// Pretty-print the value.
   void dump() const;
   void print(raw_ostream &OS) const;
@@ -230,6 +235,10 @@ public:
   /// (see comment in DebugUtils.h).
   inline bool hasOneUse() const;
 
+  /// Returns the use of this value if it has exactly one use, or null
+  /// otherwise.
+  inline Operand *getSingleUse() const;
+
   /// Return the underlying SILValue after stripping off all casts from the
   /// current SILValue.
   SILValue stripCasts();
@@ -395,6 +404,7 @@ private:
     TheValue->FirstUse = this;
   }
 
+  friend class ValueBase;
   friend class ValueBaseUseIterator;
   friend class ValueUseIterator;
   template <unsigned N> friend class FixedOperandList;
@@ -507,9 +517,10 @@ inline iterator_range<ValueBase::use_iterator> ValueBase::getUses() const {
   return { use_begin(), use_end() };
 }
 inline bool ValueBase::hasOneUse() const {
-  auto I = use_begin(), E = use_end();
-  if (I == E) return false;
-  return ++I == E;
+  return FirstUse && !FirstUse->NextUse;
+}
+inline Operand *ValueBase::getSingleUse() const {
+  return hasOneUse() ? FirstUse : nullptr;
 }
 
 /// An iterator over all uses of a specific result of a ValueBase.
@@ -573,9 +584,13 @@ inline iterator_range<SILValue::use_iterator> SILValue::getUses() const {
 }
 inline bool SILValue::use_empty() const { return use_begin() == use_end(); }
 inline bool SILValue::hasOneUse() const {
+  return getSingleUse() != nullptr;
+}
+inline Operand *SILValue::getSingleUse() const {
   auto I = use_begin(), E = use_end();
-  if (I == E) return false;
-  return ++I == E;
+  if (I == E) return nullptr;
+  Operand *Use = *I;
+  return ++I == E ? Use : nullptr;
 }
 
 /// A constant-size list of the operands of an instruction.
@@ -430,8 +430,7 @@ class TypeConverter {
   friend class TypeLowering;
 
   llvm::BumpPtrAllocator IndependentBPA;
-  /// BumpPtrAllocator for types dependent on contextual generic parameters,
-  /// which is reset when the generic context is popped.
+  /// BumpPtrAllocator for types dependent on contextual generic parameters.
   llvm::BumpPtrAllocator DependentBPA;
 
   enum : unsigned {
@@ -488,6 +487,10 @@ class TypeConverter {
   };
 
   friend struct llvm::DenseMapInfo<CachingTypeKey>;
+
+  /// A type lowered in a generic context is only valid in contexts with the
+  /// same canonical generic signature.
+  typedef std::pair<GenericSignature *, CachingTypeKey> DependentTypeKey;
   
   TypeKey getTypeKey(AbstractionPattern origTy, CanType substTy,
                      unsigned uncurryLevel) {
@@ -517,12 +520,13 @@ class TypeConverter {
   /// Insert a mapping into the cache.
   void insert(TypeKey k, const TypeLowering *tl);
   
-  /// Mapping for types independent on contextual generic parameters, which is
-  /// cleared when the generic context is popped.
+  /// Mapping for types independent on contextual generic parameters.
   llvm::DenseMap<CachingTypeKey, const TypeLowering *> IndependentTypes;
-  /// Mapping for types dependent on contextual generic parameters, which is
-  /// cleared when the generic context is popped.
-  llvm::DenseMap<CachingTypeKey, const TypeLowering *> DependentTypes;
+  /// Mapping for types dependent on contextual generic parameters, keyed by
+  /// the generic signature of the context. The entries are kept after the
+  /// context is popped, so that all functions with the same signature share
+  /// them.
+  llvm::DenseMap<DependentTypeKey, const TypeLowering *> DependentTypes;
   
   llvm::DenseMap<SILDeclRef, SILConstantInfo> ConstantTypes;
   
@@ -534,7 +538,10 @@ class TypeConverter {
   llvm::DenseSet<NominalTypeDecl *> RecursiveNominalTypes;
   
   /// ArchetypeBuilder used for lowering types in generic function contexts.
-  Optional<ArchetypeBuilder> GenericArchetypes;
+  ///
+  /// This is the builder the ASTContext keeps for the canonical signature, so
+  /// functions that share a signature don't each rebuild it.
+  ArchetypeBuilder *GenericArchetypes = nullptr;
 
   /// The current generic context signature.
   CanGenericSignature CurGenericContext;
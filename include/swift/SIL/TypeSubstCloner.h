@@ -65,11 +65,18 @@ public:
       Inlining(Inlining) { }
 
 protected:
+  // The substitutions only replace archetypes. Inlining a non-generic
+  // function, which is by far the most common case for transparent
+  // functions, substitutes nothing, so don't rebuild every type.
   SILType remapType(SILType Ty) {
+    if (SubsMap.empty() || !Ty.getSwiftRValueType()->hasArchetype())
+      return Ty;
     return SILType::substType(Original.getModule(), SwiftMod, SubsMap, Ty);
   }
 
   CanType remapASTType(CanType ty) {
+    if (SubsMap.empty() || !ty->hasArchetype())
+      return ty;
     return ty.subst(SwiftMod, SubsMap, None)->getCanonicalType();
   }
 
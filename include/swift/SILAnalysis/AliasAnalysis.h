@@ -70,6 +70,39 @@ private:
 
   using MemoryBehavior = SILInstruction::MemoryBehavior;
 
+  /// The values and TBAA types of an alias query.
+  using AliasCacheKey =
+      std::pair<std::pair<size_t, size_t>, std::pair<SILType, SILType>>;
+
+  /// The instruction, value and retain observe kind of a memory behavior
+  /// query.
+  using MemoryBehaviorCacheKey = std::pair<std::pair<size_t, size_t>, unsigned>;
+
+  /// A cache for the results of alias().
+  llvm::DenseMap<AliasCacheKey, AliasResult> AliasCache;
+
+  /// A cache for the results of computeMemoryBehavior().
+  llvm::DenseMap<MemoryBehaviorCacheKey, MemoryBehavior> MemoryBehaviorCache;
+
+  /// The cache keys refer to values by index and not by pointer. When a value
+  /// is deleted it is removed from this map, so that a new value allocated
+  /// at the same address gets a new index and can't hit stale entries.
+  llvm::DenseMap<ValueBase *, size_t> ValueIndices;
+
+  /// The index which is given to the next value added to ValueIndices.
+  size_t NextValueIndex = 0;
+
+  /// Returns the cache index of the result \p ResultNumber of \p V.
+  size_t getValueIndex(ValueBase *V, unsigned ResultNumber = 0) {
+    auto Iter = ValueIndices.insert({V, NextValueIndex});
+    if (Iter.second)
+      ++NextValueIndex;
+    return (Iter.first->second << ValueResultNumberBits) | ResultNumber;
+  }
+  size_t getValueIndex(SILValue V) {
+    return getValueIndex(V.getDef(), V.getResultNumber());
+  }
+
   AliasResult aliasAddressProjection(SILValue V1, SILValue V2,
                                      SILValue O1, SILValue O2);
 
@@ -83,6 +116,7 @@ private:
 
 
   virtual void handleDeleteNotification(SILInstruction *I) override {
+    ValueIndices.erase(I);
   }
 
 public:
@@ -172,7 +206,14 @@ public:
     return MemoryBehavior::MayHaveSideEffects == B;
   }
 
-  virtual void invalidate(SILAnalysis::InvalidationKind K) override { }
+  virtual void invalidate(SILAnalysis::InvalidationKind K) override {
+    // Any change to a function may change the result of a query which looks
+    // through projections or asks the side effect analysis about a call.
+    AliasCache.clear();
+    MemoryBehaviorCache.clear();
+    ValueIndices.clear();
+    NextValueIndex = 0;
+  }
 
   virtual void invalidate(SILFunction *,
                           SILAnalysis::InvalidationKind K) override {
@@ -554,7 +554,13 @@ private:
 
   enum {
     /// A limit for the interprocedural algorithm.
-    MaxGraphMerges = 4
+    MaxGraphMerges = 4,
+
+    /// The number of nodes above which a function's graph does not receive
+    /// any more callee graphs. Its calls are then handled conservatively, which
+    /// keeps the graphs (and the summary graphs derived from them) bounded in
+    /// large modules.
+    MaxGraphNodes = 1000
   };
 
   /// All the information we keep for a function.
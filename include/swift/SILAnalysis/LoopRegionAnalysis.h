@@ -277,11 +277,14 @@ public:
       auto ID = *InnerIter;
       if (!ID.IsLoop)
         return ID.ID;
-      for (auto &p : *Subloops) {
-        if (p.first == ID.ID) {
-          return p.second;
-        }
-      }
+      // The subloops are sorted by the ID of their header.
+      auto Iter = std::lower_bound(
+          Subloops->begin(), Subloops->end(), ID.ID,
+          [](const std::pair<unsigned, unsigned> &p, unsigned HeaderID) {
+            return p.first < HeaderID;
+          });
+      if (Iter != Subloops->end() && Iter->first == ID.ID)
+        return Iter->second;
       llvm_unreachable("Out of sync subloops array?!");
     }
 
@@ -331,7 +334,10 @@ private:
   llvm::Optional<unsigned> ParentID;
 
   /// The IDs of the predecessor regions of this region.
-  llvm::SmallVector<unsigned, 4> Preds;
+  ///
+  /// Most regions are blocks with one or two predecessors, so only that many
+  /// are stored inline.
+  llvm::SmallVector<unsigned, 2> Preds;
 
   /// The IDs of the local and non-local successor regions of this region.
   ///
@@ -352,7 +358,10 @@ private:
   /// of a loop, may have a non-local successor edge pointed at this region's
   /// successor edge. If we were to sort these edges, we would need to update
   /// those subregion edges as well which is strictly not necessary.
-  SmallBlotSetVector<SuccessorID, 8> Succs;
+  ///
+  /// Most regions are blocks with at most two successors. Four inline
+  /// elements keep the set's map from growing for up to three successors.
+  SmallBlotSetVector<SuccessorID, 4> Succs;
 
   /// True if this region the head of an edge that results from control flow
   /// that we do not handle.
@@ -397,6 +406,9 @@ private:
     /// A map from RPO number of a subregion loop's preheader to a subloop
     /// regions id. This is neccessary since we represent a loop in the
     /// Subregions array by the RPO number of its header.
+    ///
+    /// It is sorted by the RPO number by sortSubregions(), so that it can be
+    /// binary searched.
     llvm::SmallVector<std::pair<unsigned, unsigned>, 2> Subloops;
 
     subregion_iterator begin() const {
@@ -435,7 +447,10 @@ private:
     /// TODO: Is this necessary? We visit BBs in RPO order. This means that we
     /// should always add BBs in RPO order to subregion lists, no? For now I am
     /// going to sort just to be careful while bringing this up.
-    void sortSubregions() { std::sort(Subregions.begin(), Subregions.end()); }
+    void sortSubregions() {
+      std::sort(Subregions.begin(), Subregions.end());
+      std::sort(Subloops.begin(), Subloops.end());
+    }
   };
 
 public:
@@ -494,8 +509,9 @@ public:
 
   /// Returns true if \p R is an immediate subregion of this region.
   bool containsSubregion(LoopRegion *R) {
-    auto End = subregion_end();
-    return std::find(subregion_begin(), End, R->getID()) != End;
+    // Adding a subregion sets its parent, so there is no need to search the
+    // subregion list.
+    return R->ParentID.hasValue() && *R->ParentID == ID;
   }
 
   using pred_const_iterator = decltype(Preds)::const_iterator;
@@ -804,6 +820,10 @@ public:
   RegionTy *getTopLevelRegion() const { return getRegion(F); }
   FunctionTy *getFunction() const { return F; }
 
+  /// Returns the approximate number of bytes used by the regions and the maps
+  /// of this data structure.
+  size_t getMemorySize() const;
+
   void dump() const;
   void print(llvm::raw_ostream &os) const;
   void viewLoopRegions() const;
@@ -43,9 +43,12 @@ enum class RetainObserveKind {ObserveRetains, IgnoreRetains};
 /// SIL, there should not be more side-effects on a function than before the
 /// transformation. Therefore optimization passes do not _invalidate_ the
 /// side-effect information, they may only make it more conservative.
-/// For this reason, the invalidate function are no-ops. Instead the
-/// UpdateSideEffects pass does recompute the analysis no certain points in the
-/// optimization pipeline. This avoids updating the analysis too often.
+/// For this reason, the invalidate functions only record what has changed.
+/// Instead the UpdateSideEffects pass does recompute the analysis on certain
+/// points in the optimization pipeline. This avoids updating the analysis too
+/// often. If only some function bodies changed since the last update, only
+/// those functions and the callers whose effects change in turn are
+/// recomputed.
 class SideEffectAnalysis : public SILAnalysis {
 public:
 
@@ -280,8 +283,12 @@ private:
   /// This analysis depends on the call graph.
   CallGraphAnalysis *CGA;
   
-  /// If false, nothing has changed between two recompute() calls.
+  /// If false, nothing has changed between two recompute() calls, except the
+  /// bodies of the InvalidatedFunctions.
   bool shouldRecompute;
+
+  /// Functions whose bodies changed since the last recompute() call.
+  llvm::SetVector<SILFunction *> InvalidatedFunctions;
   
   typedef llvm::SetVector<SILFunction *> WorkListType;
   
@@ -297,8 +304,17 @@ private:
   /// If the side-effects changed, the callers are pushed onto the \a WorkList.
   void analyzeFunction(SILFunction *F, WorkListType &WorkList, CallGraph &CG);
   
+  /// Recomputes the side-effects of the InvalidatedFunctions and propagates
+  /// changes to their callers.
+  /// Returns false if this did not reach a fixpoint within a reasonable number
+  /// of steps, in which case the whole module has to be recomputed.
+  bool recomputeInvalidatedFunctions();
+
   /// Analyise the side-effects of a single SIL instruction.
-  void analyzeInstruction(FunctionEffects &Effects, SILInstruction *I);
+  /// If  isRecomputing is true, callees without side-effect information are
+  /// assumed to have no effects, otherwise the worst effects.
+  void analyzeInstruction(FunctionEffects &Effects, SILInstruction *I,
+                          bool isRecomputing = true);
 
   /// Get the side-effects of a call site.
   void getEffectsOfApply(FunctionEffects &FE, FullApplySite FAS,
@@ -349,7 +365,14 @@ public:
   
   /// No invalidation is needed. See comment for SideEffectAnalysis.
   virtual void invalidate(SILFunction *F, InvalidationKind K) {
-    invalidate(K);
+    // Adding or removing functions changes the call graph, which requires a
+    // full recomputation.
+    if (K & InvalidationKind::Functions) {
+      invalidate(K);
+      return;
+    }
+    if (K != InvalidationKind::Nothing)
+      InvalidatedFunctions.insert(F);
   }
 };
 
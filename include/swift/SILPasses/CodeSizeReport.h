@@ -0,0 +1,120 @@
+//===--- CodeSizeReport.h - Code size per function and origin ---*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the report behind -code-size-report-path, which
+// attributes the size of every function, in SIL instructions and in machine
+// code, to the source declaration it was generated from.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_SILPASSES_CODESIZEREPORT_H
+#define SWIFT_SILPASSES_CODESIZEREPORT_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace swift {
+
+class DeclContext;
+class SILModule;
+
+/// The size of each function of a module, and of each source declaration
+/// that functions were generated from.
+///
+/// Specializations, thunks and closures are attributed to the declaration
+/// they were generated for, and instructions inlined into a function are
+/// additionally attributed to the declaration of the inlined callee, so that
+/// the cost of a generic or a conformance adds up under its source.
+class CodeSizeReport {
+public:
+  enum class FunctionKind {
+    /// A function which was written in the source.
+    Function,
+    /// A closure, or a function nested in another function.
+    Closure,
+    /// A specialization of a generic function for concrete types.
+    GenericSpecialization,
+    /// A function specialized for its arguments.
+    SignatureSpecialization,
+    /// A thunk which implements a protocol requirement for a conformance.
+    WitnessThunk,
+    /// A thunk which converts between the abstraction levels of a function.
+    ReabstractionThunk,
+    /// Any other thunk, such as for @objc entry points or dynamic dispatch.
+    Thunk,
+    /// A function emitted by IRGen with no SIL counterpart, such as a value
+    /// witness or metadata accessor.
+    IRGen,
+  };
+
+  /// The instructions of a function which were inlined from one callee.
+  struct InlinedCallee {
+    std::string Name;
+    /// The source of the callee, or null if it has none.
+    const DeclContext *Origin;
+    unsigned Instructions;
+  };
+
+  struct Function {
+    std::string Name;
+    FunctionKind Kind;
+    /// The source function or closure this function was generated for, or
+    /// null if it has none.
+    const DeclContext *Origin = nullptr;
+    /// The SIL instructions of the function after optimization, including
+    /// the inlined ones.
+    unsigned Instructions = 0;
+    std::vector<InlinedCallee> Inlined;
+    /// The size of the function in the object file, in bytes, or 0 if it
+    /// wasn't emitted or the object file wasn't read.
+    uint64_t MachineCodeSize = 0;
+  };
+
+private:
+  std::vector<Function> Functions;
+  llvm::StringMap<unsigned> FunctionsByName;
+
+  /// The name of the object file symbols were read from, if any.
+  std::string ObjectFile;
+
+public:
+  /// Adds every function with a body in \p M, which should be fully
+  /// optimized.
+  void addSILModule(SILModule &M);
+
+  /// Records the size of the function \p Symbol in the object file. Symbols
+  /// without a SIL function are added as FunctionKind::IRGen.
+  void setMachineCodeSize(StringRef Symbol, uint64_t Size);
+
+  /// Records the object file that setMachineCodeSize() values came from.
+  void setObjectFile(StringRef Path) { ObjectFile = Path; }
+
+  const std::vector<Function> &getFunctions() const { return Functions; }
+
+  /// Writes the report as a JSON object with a list of the functions, and a
+  /// list of the source declarations sorted by how much code each accounts
+  /// for.
+  void write(raw_ostream &os) const;
+
+  /// Writes the report to the file \p Path.
+  std::error_code writeToFile(StringRef Path) const;
+
+  static StringRef getKindName(FunctionKind Kind);
+};
+
+} // end namespace swift
+
+#endif
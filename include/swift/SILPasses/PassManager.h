@@ -10,11 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "swift/SIL/Notifications.h"
 #include "swift/SILAnalysis/Analysis.h"
 #include "swift/SILPasses/Passes.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/ErrorHandling.h"
 
@@ -29,6 +31,28 @@ class SILModule;
 class SILOptions;
 class SILTransform;
 
+/// Receives every run of a pass, in any pass manager, while it is the active
+/// observer. This is how sil-opt's benchmarking mode times the passes of a
+/// pipeline.
+class SILPassRunObserver {
+public:
+  virtual ~SILPassRunObserver() = default;
+
+  /// Called after \p T ran once on a function, or on the module if \p F is
+  /// null. \p Nanoseconds is the time the pass itself took, and the
+  /// instruction counts are of the function or the module.
+  virtual void passDidRun(SILTransform *T, SILFunction *F,
+                          uint64_t Nanoseconds, uint64_t InstructionsBefore,
+                          uint64_t InstructionsAfter) = 0;
+
+  /// Returns the observer passes are reported to, or null if there is none.
+  static SILPassRunObserver *getActive();
+
+  /// Makes \p Observer the observer passes are reported to, or stops
+  /// reporting passes if it is null.
+  static void setActive(SILPassRunObserver *Observer);
+};
+
 /// \brief The SIL pass manager.
 class SILPassManager {
   /// The module that the pass manager will transform.
@@ -59,6 +83,28 @@ class SILPassManager {
 
   /// Set to true when a pass invalidates an analysis.
   bool currentPassHasInvalidated = false;
+
+  /// Set to true when a pass invalidates the analysis of the whole module.
+  bool currentPassHasInvalidatedModule = false;
+
+  /// The functions which the current pass has invalidated or deleted
+  /// instructions from. With incremental verification only these are verified
+  /// after a module pass. The set may contain functions which the pass erased,
+  /// so it is only used to look up functions which are still in the module.
+  llvm::SmallPtrSet<SILFunction *, 16> InvalidatedFunctions;
+
+  /// Adds the function of each instruction deleted by the current pass to
+  /// InvalidatedFunctions.
+  class DeletedInstructionTracker : public DeleteNotificationHandler {
+    SILPassManager &PM;
+
+  public:
+    DeletedInstructionTracker(SILPassManager &PM) : PM(PM) {}
+
+    void handleDeleteNotification(SILInstruction *I) override;
+  };
+
+  DeletedInstructionTracker DeleteTracker;
   
 public:
   /// C'tor. It creates and registers all analysis passes, which are defined
@@ -97,6 +143,7 @@ public:
         AP->invalidate(K);
 
     currentPassHasInvalidated = true;
+    currentPassHasInvalidatedModule = true;
 
     // Assume that all functions have changed. Clear all masks of all functions.
     CompletedPassesMap.clear();
@@ -111,6 +158,7 @@ public:
         AP->invalidate(F, K);
     
     currentPassHasInvalidated = true;
+    InvalidatedFunctions.insert(F);
     // Any change let all passes run again.
     CompletedPassesMap[F].reset();
   }
@@ -28,9 +28,19 @@
 
 namespace swift {
 
+/// Tries to specialize the generic callee of \p Apply for the substitutions of
+/// the apply. If a new specialization is created, it is returned in
+/// \p NewFunction.
+///
+/// If \p SizeBudget is not null, it is the number of instructions which new
+/// specializations may still add to the module. No specialization is created
+/// for a callee which is larger than the remaining budget, and the budget is
+/// reduced by the size of each new specialization. Existing specializations
+/// are always reused.
 ApplySite trySpecializeApplyOfGeneric(ApplySite Apply,
                                       SILFunction *&NewFunction,
-                                      CloneCollector &Collector);
+                                      CloneCollector &Collector,
+                                      unsigned *SizeBudget = nullptr);
 
 /// Checks if a given mangled name could be a name of a whitelisted specialization.
 bool isWhitelistedSpecialization(StringRef SpecName);
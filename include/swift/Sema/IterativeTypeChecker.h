@@ -22,6 +22,7 @@
 #include "swift/Sema/TypeCheckRequest.h"
 #include "swift/AST/DiagnosticEngine.h"
 #include "swift/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/STLExtras.h"
 
@@ -30,6 +31,43 @@ namespace swift {
 class ASTContext;
 class TypeChecker;
 
+/// Records the requests that each satisfied type check request depended on.
+///
+/// The results of satisfied requests live in the AST. This table remembers
+/// how they were computed, so that a client which changes a declaration can
+/// find out which results are now stale and need to be recomputed.
+class TypeCheckRequestDependencies {
+  typedef SmallVector<TypeCheckRequest, 4> RequestList;
+
+  /// The requests each request used the last time it was processed.
+  llvm::DenseMap<TypeCheckRequest, RequestList> Dependencies;
+
+  /// The requests which used each request; the inverse of Dependencies.
+  llvm::DenseMap<TypeCheckRequest, RequestList> Dependents;
+
+public:
+  /// Note that \p request used \p dependency.
+  void addDependency(TypeCheckRequest request, TypeCheckRequest dependency);
+
+  /// Forget the dependencies recorded for \p request, e.g., because it is
+  /// about to be processed again.
+  void clearDependencies(TypeCheckRequest request);
+
+  /// Retrieve the requests that \p request used the last time it was
+  /// processed.
+  ArrayRef<TypeCheckRequest> getDependencies(TypeCheckRequest request) const;
+
+  /// Retrieve the requests that used \p request.
+  ArrayRef<TypeCheckRequest> getDependents(TypeCheckRequest request) const;
+
+  /// Collect every request anchored on \p changed, along with every request
+  /// that depends on one of those, directly or indirectly.
+  ///
+  /// The dependencies of the collected requests are forgotten; they will be
+  /// recorded again when the requests are next satisfied.
+  void invalidate(Decl *changed, SmallVectorImpl<TypeCheckRequest> &affected);
+};
+
 /// An iterative type checker that processes type check requests to
 /// ensure that the AST has the information needed by the client.
 class IterativeTypeChecker {
@@ -43,6 +81,12 @@ class IterativeTypeChecker {
   /// A stack of the currently-active requests.
   SmallVector<TypeCheckRequest, 4> ActiveRequests;
 
+  /// Where to record the dependencies of each processed request.
+  ///
+  /// This outlives the iterative type checker, which is usually created
+  /// just to satisfy a single request.
+  TypeCheckRequestDependencies &Dependencies;
+
   // Declare the is<request kind>Satisfied predicates,
   // enumerateDependenciesOf<request kind> functions, and
   // satisfy<request kind> functions.
@@ -74,7 +118,7 @@ class IterativeTypeChecker {
   bool isSatisfied(TypeCheckRequest request);
 
 public:
-  IterativeTypeChecker(TypeChecker &tc) : TC(tc) { }
+  IterativeTypeChecker(TypeChecker &tc);
 
   ASTContext &getASTContext() const;
 
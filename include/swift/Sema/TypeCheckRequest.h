@@ -21,6 +21,8 @@
 #include "swift/AST/Identifier.h"
 #include "swift/AST/Type.h"
 #include "swift/Basic/LLVM.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/STLExtras.h"
 #include <cassert>
@@ -138,6 +140,7 @@ public:
   Decl *getAnchor() const;
 
   friend bool operator==(const TypeCheckRequest &x, const TypeCheckRequest &y);
+  friend llvm::hash_code hash_value(const TypeCheckRequest &request);
 };
 
 /// A callback used to check whether a particular dependency of this
@@ -160,6 +163,31 @@ inline bool operator!=(const TypeCheckRequest &x, const TypeCheckRequest &y) {
   return !(x == y);
 }
 
+/// Hash a type checking request, consistently with operator==.
+llvm::hash_code hash_value(const TypeCheckRequest &request);
+
+}
+
+namespace llvm {
+  template<> struct DenseMapInfo<swift::TypeCheckRequest> {
+    static swift::TypeCheckRequest getEmptyKey() {
+      return swift::requestTypeCheckSuperclass(
+               static_cast<swift::ClassDecl *>(
+                 DenseMapInfo<void *>::getEmptyKey()));
+    }
+    static swift::TypeCheckRequest getTombstoneKey() {
+      return swift::requestTypeCheckSuperclass(
+               static_cast<swift::ClassDecl *>(
+                 DenseMapInfo<void *>::getTombstoneKey()));
+    }
+    static unsigned getHashValue(const swift::TypeCheckRequest &request) {
+      return hash_value(request);
+    }
+    static bool isEqual(const swift::TypeCheckRequest &lhs,
+                        const swift::TypeCheckRequest &rhs) {
+      return lhs == rhs;
+    }
+  };
 }
 
 #endif /* SWIFT_SEMA_TYPE_CHECK_REQUEST_H */
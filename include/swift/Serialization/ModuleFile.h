@@ -28,7 +28,11 @@
 #include "llvm/ADT/Fixnum.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <map>
+#include <memory>
+#include <vector>
 
 namespace llvm {
   class BitstreamCursor;
@@ -231,21 +235,70 @@ public:
     }
   };
 
+  /// A table of entries which start out as the offsets of their records, and
+  /// are deserialized on demand.
+  ///
+  /// The offsets are used in place in the module buffer, which is normally
+  /// memory-mapped, so every process that loads the same module shares them.
+  /// The entries are only allocated, a chunk at a time, once one of them is
+  /// used, so a process only pays for the parts of the table it needs.
+  template <typename T>
+  class LazyTable {
+    using OffsetArray = ArrayRef<llvm::support::ulittle32_t>;
+
+    static const size_t ChunkSize = 64;
+
+    OffsetArray Offsets;
+    std::vector<std::vector<T>> Chunks;
+
+  public:
+    void init(OffsetArray offsets) {
+      Offsets = offsets;
+      Chunks.clear();
+      Chunks.resize((offsets.size() + ChunkSize - 1) / ChunkSize);
+    }
+
+    size_t size() const { return Offsets.size(); }
+
+    /// Returns the entry at \p index. References to entries remain valid for
+    /// the lifetime of the table.
+    T &operator[](size_t index) {
+      assert(index < size() && "index out of range");
+      std::vector<T> &chunk = Chunks[index / ChunkSize];
+      if (chunk.empty()) {
+        size_t chunkStart = index - index % ChunkSize;
+        size_t chunkSize = std::min(ChunkSize, size() - chunkStart);
+        chunk.reserve(chunkSize);
+        for (uint32_t offset : Offsets.slice(chunkStart, chunkSize))
+          chunk.push_back(serialization::BitOffset(offset));
+      }
+      return chunk[index % ChunkSize];
+    }
+
+    /// Calls \p fn on every entry which has been allocated.
+    template <typename Fn>
+    void forEachAllocated(Fn fn) const {
+      for (const std::vector<T> &chunk : Chunks)
+        for (const T &entry : chunk)
+          fn(entry);
+    }
+  };
+
 private:
   /// Decls referenced by this module.
-  std::vector<Serialized<Decl*>> Decls;
+  LazyTable<Serialized<Decl*>> Decls;
 
   /// DeclContexts referenced by this module.
-  std::vector<Serialized<DeclContext*>> DeclContexts;
+  LazyTable<Serialized<DeclContext*>> DeclContexts;
 
   /// Local DeclContexts referenced by this module.
-  std::vector<Serialized<DeclContext*>> LocalDeclContexts;
+  LazyTable<Serialized<DeclContext*>> LocalDeclContexts;
 
   /// Normal protocol conformances referenced by this module.
-  std::vector<Serialized<NormalProtocolConformance *>> NormalConformances;
+  LazyTable<Serialized<NormalProtocolConformance *>> NormalConformances;
 
   /// Types referenced by this module.
-  std::vector<Serialized<Type>> Types;
+  LazyTable<Serialized<Type>> Types;
 
   /// Represents an identifier that may or may not have been deserialized yet.
   ///
@@ -261,7 +314,7 @@ private:
   };
 
   /// Identifiers referenced by this module.
-  std::vector<SerializedIdentifier> Identifiers;
+  LazyTable<SerializedIdentifier> Identifiers;
 
   class DeclTableInfo;
   using SerializedDeclTable =
@@ -278,6 +331,21 @@ private:
   std::unique_ptr<SerializedDeclTable> OperatorMethodDecls;
   std::unique_ptr<SerializedLocalDeclTable> LocalTypeDecls;
 
+  class DeclMemberTableInfo;
+  using SerializedDeclMemberTable =
+      llvm::OnDiskIterableChainedHashTable<DeclMemberTableInfo>;
+
+  std::unique_ptr<SerializedDeclMemberTable> MembersByContextAndName;
+
+  /// The bits of the Bloom filter over top-level, operator method and class
+  /// member names, or empty if the module doesn't have one.
+  StringRef NameFilterBits;
+  unsigned NameFilterHashCount = 0;
+
+  /// The IDs of nominal types and extensions whose members haven't been
+  /// loaded yet, used to look up their members by name.
+  llvm::DenseMap<const Decl *, serialization::DeclID> LazyMemberContextIDs;
+
   class ObjCMethodTableInfo;
   using SerializedObjCMethodTable =
     llvm::OnDiskIterableChainedHashTable<ObjCMethodTableInfo>;
@@ -372,12 +440,77 @@ public:
     return FileContext;
   }
 
+  /// Counts what has been deserialized from a module file, and how long it
+  /// took.
+  struct Statistics {
+    /// The number of decls deserialized, by kind.
+    std::map<DeclKind, unsigned> NumDecls;
+    unsigned NumCrossReferences = 0;
+    unsigned NumTypes = 0;
+    unsigned NumConformances = 0;
+    unsigned NumSILFunctions = 0;
+
+    /// The number of bits read from the module's bitstream after it was
+    /// loaded.
+    uint64_t NumBitsRead = 0;
+
+    /// Microseconds spent loading the module file and deserializing from it,
+    /// not counting time charged to other module files in the meantime.
+    uint64_t Time = 0;
+  };
+
+  /// Charges the bits read from \p Cursor and the time spent during the
+  /// lifetime of this object to a module file's statistics. Does nothing if
+  /// there are no statistics.
+  ///
+  /// When scopes for different module files nest, the time spent in the inner
+  /// scope is only charged to the inner module file.
+  class StatisticsScope {
+    Statistics *Outer = nullptr;
+    Statistics *Stats;
+    llvm::BitstreamCursor *Cursor;
+    uint64_t StartBit = 0;
+    bool ChargesTime = false;
+
+  public:
+    StatisticsScope(Statistics *Stats, llvm::BitstreamCursor *Cursor);
+    StatisticsScope(ModuleFile &MF, llvm::BitstreamCursor *Cursor)
+      : StatisticsScope(MF.getStatistics(), Cursor) {}
+    ~StatisticsScope();
+
+    StatisticsScope(const StatisticsScope &) = delete;
+    StatisticsScope &operator=(const StatisticsScope &) = delete;
+  };
+
 private:
+  /// Statistics about this module file, if they are being collected.
+  std::unique_ptr<Statistics> Stats;
+
+public:
+  /// Sets the statistics to update as this module file is deserialized.
+  void setStatistics(std::unique_ptr<Statistics> stats) {
+    Stats = std::move(stats);
+  }
+
+  /// Returns the statistics collected for this module file, or null if
+  /// statistics aren't being collected.
+  Statistics *getStatistics() const { return Stats.get(); }
+
+private:
+  /// Returns false if this module's name filter shows that it doesn't define
+  /// a top-level decl, operator method or class member named \p name.
+  bool mayDefineName(Identifier name) const;
+
   /// Read an on-disk decl hash table stored in index_block::DeclListLayout
   /// format.
   std::unique_ptr<SerializedDeclTable>
   readDeclTable(ArrayRef<uint64_t> fields, StringRef blobData);
 
+  /// Read an on-disk member table stored in index_block::DeclListLayout
+  /// format.
+  std::unique_ptr<SerializedDeclMemberTable>
+  readDeclMemberTable(ArrayRef<uint64_t> fields, StringRef blobData);
+
   /// Read an on-disk local decl hash table stored in
   /// index_block::DeclListLayout format.
   std::unique_ptr<SerializedLocalDeclTable>
@@ -592,6 +725,10 @@ public:
                               uint64_t contextData,
                               bool *ignored) override;
 
+  virtual bool loadNamedMembers(const Decl *D, DeclName N,
+                                uint64_t contextData,
+                                SmallVectorImpl<ValueDecl *> &Members) override;
+
   virtual void
   loadAllConformances(const Decl *D, uint64_t contextData,
                       SmallVectorImpl<ProtocolConformance*> &Conforms) override;
@@ -20,6 +20,7 @@
 #define SWIFT_SERIALIZATION_MODULEFORMAT_H
 
 #include "swift/AST/Decl.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/RecordLayout.h"
 #include "llvm/Bitcode/BitCodes.h"
 
@@ -51,7 +52,7 @@ const uint16_t VERSION_MAJOR = 0;
 /// To ensure that two separate changes don't silently get merged into one
 /// in source control, you should also update the comment to briefly
 /// describe what change you made.
-const uint16_t VERSION_MINOR = 222; // Last change: @_fixed_layout
+const uint16_t VERSION_MINOR = 227; // Last change: name filter
 
 using DeclID = Fixnum<31>;
 using DeclIDField = BCFixed<31>;
@@ -1422,11 +1423,22 @@ namespace index_block {
     DECL_CONTEXT_OFFSETS,
     LOCAL_TYPE_DECLS,
     NORMAL_CONFORMANCE_OFFSETS,
+
+    /// The member index, which maps a nominal type or extension and a member
+    /// name to the members of that context with that base name.
+    DECL_MEMBER_NAMES,
+
+    /// A Bloom filter over the names in TOP_LEVEL_DECLS, OPERATOR_METHODS
+    /// and CLASS_MEMBERS, so that lookups of names the module doesn't define
+    /// usually don't have to probe those tables.
+    NAME_FILTER,
   };
 
+  /// The offsets are stored as an array of little-endian 32-bit integers, so
+  /// that they can be used without being decoded.
   using OffsetsLayout = BCGenericRecordLayout<
     BCFixed<4>,  // record ID
-    BCArray<BitOffsetField>
+    BCBlob       // array of BitOffsets
   >;
 
   using DeclListLayout = BCGenericRecordLayout<
@@ -1445,6 +1457,23 @@ namespace index_block {
     ENTRY_POINT,
     DeclIDField  // the ID of the main class; 0 if there was a main source file
   >;
+
+  using NameFilterLayout = BCRecordLayout<
+    NAME_FILTER, // record ID
+    BCVBR<4>,    // number of hash functions
+    BCBlob       // the filter's bits, starting with the low bit of each byte
+  >;
+
+  /// Calls \p body with the index of each bit that is set for \p name in a
+  /// name filter of \p numBits bits.
+  template <typename Fn>
+  static inline void forEachNameFilterBit(StringRef name, unsigned numHashes,
+                                          uint64_t numBits, Fn body) {
+    uint64_t hash1 = llvm::HashString(name);
+    uint64_t hash2 = llvm::HashString(name, hash1) | 1;
+    for (unsigned i = 0; i != numHashes; ++i)
+      body((hash1 + i * hash2) % numBits);
+  }
 }
 
 /// \sa COMMENT_BLOCK_ID
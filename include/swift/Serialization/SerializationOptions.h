@@ -34,6 +34,9 @@ namespace swift {
     StringRef ModuleLinkName;
     ArrayRef<std::string> ExtraClangOptions;
 
+    /// Path prefixes to replace in serialized paths, in order of precedence.
+    ArrayRef<std::pair<std::string, std::string>> PathPrefixMap;
+
     bool AutolinkForceLoad = false;
     bool SerializeAllSIL = false;
     bool SerializeOptionsForDebugging = false;
@@ -29,6 +29,10 @@ private:
   using LoadedModulePair = std::pair<std::unique_ptr<ModuleFile>, unsigned>;
   std::vector<LoadedModulePair> LoadedModuleFiles;
 
+  /// Whether to collect statistics about what is deserialized from each
+  /// module file.
+  bool CollectStatistics = false;
+
   explicit SerializedModuleLoader(ASTContext &ctx, DependencyTracker *tracker);
 
 public:
@@ -91,6 +95,14 @@ public:
                  llvm::TinyPtrVector<AbstractFunctionDecl *> &methods) override;
 
   virtual void verifyAllModules() override;
+
+  /// Collect statistics about what is deserialized from module files loaded
+  /// from now on.
+  void enableStatistics() { CollectStatistics = true; }
+
+  /// Writes the statistics collected for each loaded module file as a JSON
+  /// array.
+  void writeStatistics(raw_ostream &os) const;
 };
 
 /// A file-unit loaded from a serialized AST file.
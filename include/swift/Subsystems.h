@@ -19,6 +19,7 @@
 
 #include "swift/Basic/LLVM.h"
 #include "swift/Basic/OptionSet.h"
+#include "swift/Basic/SourceLoc.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/Optional.h"
@@ -34,6 +35,7 @@ namespace llvm {
 }
 
 namespace swift {
+  class AbstractFunctionDecl;
   class ArchetypeBuilder;
   class ASTContext;
   class CodeCompletionCallbacksFactory;
@@ -118,6 +120,27 @@ namespace swift {
                              PersistentParserState &PersistentState,
                              CodeCompletionCallbacksFactory *Factory);
 
+  /// \brief Parses the body of \p AFD if it was delayed during the first
+  /// parsing pass; does nothing otherwise.
+  ///
+  /// Function bodies parsed this way are not type-checked.
+  void parseDelayedFunctionBody(AbstractFunctionDecl *AFD,
+                                PersistentParserState &PersistentState);
+
+  /// \brief Replaces the existing body of \p AFD by the brace statement
+  /// between \p LBraceLoc and \p RBraceLoc, which may be in a different buffer
+  /// than the rest of the function.
+  ///
+  /// This lets an already type-checked AST be reused after an edit that only
+  /// touched one function body. If \p Factory is not null, the code completion
+  /// callbacks are run on the new body.
+  ///
+  /// \returns true if the new body could not be parsed up to \p RBraceLoc; the
+  /// code completion callbacks are not run in that case.
+  bool reparseFunctionBody(AbstractFunctionDecl *AFD, SourceLoc LBraceLoc,
+                           SourceLoc RBraceLoc,
+                           CodeCompletionCallbacksFactory *Factory);
+
   /// \brief Lex and return a vector of tokens for the given buffer.
   std::vector<Token> tokenize(const LangOptions &LangOpts,
                               const SourceManager &SM, unsigned BufferID,
@@ -151,7 +174,11 @@ namespace swift {
 
     /// Indicates that the type checker is checking code that will be
     /// immediately executed.
-    ForImmediateMode = 1 << 2
+    ForImmediateMode = 1 << 2,
+
+    /// If set, dumps wall time and solver work taken to check each
+    /// expression to llvm::errs(), most expensive first.
+    DebugTimeExpressionTypeChecking = 1 << 3
   };
 
   /// Once parsing and name-binding are complete, this walks the AST to resolve
@@ -236,6 +263,17 @@ namespace swift {
                                                     StringRef ModuleName,
                                                 llvm::LLVMContext &LLVMContext);
 
+  /// Turn the given Swift module into either LLVM IR or native code
+  /// and return the generated LLVM IR module.
+  ///
+  /// IRGen takes ownership of \p SILMod and destroys it once the IR has been
+  /// emitted, so that the SIL module is not resident while LLVM runs.
+  std::unique_ptr<llvm::Module> performIRGeneration(IRGenOptions &Opts,
+                                                    ModuleDecl *M,
+                                          std::unique_ptr<SILModule> SILMod,
+                                                    StringRef ModuleName,
+                                                llvm::LLVMContext &LLVMContext);
+
   /// Turn the given Swift module into either LLVM IR or native code
   /// and return the generated LLVM IR module.
   std::unique_ptr<llvm::Module> performIRGeneration(IRGenOptions &Opts,
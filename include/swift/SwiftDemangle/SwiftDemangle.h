@@ -19,6 +19,8 @@
 #ifndef SWIFT_DEMANGLE_SWIFT_DEMANGLE_H
 #define SWIFT_DEMANGLE_SWIFT_DEMANGLE_H
 
+#include <stddef.h>
+
 /// @{
 /// Version constants for libswiftDemangle library.
 
@@ -27,7 +29,7 @@
 
 /// Minor version changes when new APIs are added in ABI- and source-compatible
 /// way.
-#define SWIFT_DEMANGLE_VERSION_MINOR 2
+#define SWIFT_DEMANGLE_VERSION_MINOR 3
 
 /// @}
 
@@ -53,6 +55,33 @@ size_t swift_demangle_getSimplifiedDemangledName(const char *MangledName,
                                                  char *OutputBuffer,
                                                  size_t Length);
 
+/// \brief A demangling context, which demangles many names more cheaply than
+/// the functions above by remembering recent results.
+///
+/// A context may only be used by one thread at a time.
+typedef struct swift_demangle_context *swift_demangle_context_t;
+
+/// \brief Creates a demangling context.
+///
+/// \param Simplified if nonzero, names are demangled like
+/// swift_demangle_getSimplifiedDemangledName does.
+/// \param CacheSize the number of recently demangled names to remember, or 0
+/// to remember none.
+swift_demangle_context_t swift_demangle_createContext(int Simplified,
+                                                      size_t CacheSize);
+
+/// \brief Destroys a context created by swift_demangle_createContext.
+void swift_demangle_destroyContext(swift_demangle_context_t Context);
+
+/// \brief Demangle Swift function names using \p Context.
+///
+/// \returns the length of the demangled function name (even if greater than the
+/// size of the output buffer) or 0 if the input is not a Swift-mangled function
+/// name (in which cases \p OutputBuffer is left untouched).
+size_t swift_demangle_getDemangledNameWithContext(
+    swift_demangle_context_t Context, const char *MangledName,
+    char *OutputBuffer, size_t Length);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
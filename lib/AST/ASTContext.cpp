@@ -29,12 +29,14 @@
 #include "swift/AST/NameLookup.h"
 #include "swift/AST/RawComment.h"
 #include "swift/AST/TypeCheckerDebugConsumer.h"
+#include "swift/Basic/ConcurrentStringTable.h"
 #include "swift/Basic/SourceManager.h"
 #include "swift/Basic/StringExtras.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/Format.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include <algorithm>
@@ -67,6 +69,119 @@ namespace {
     Import = 1 << 0,
     Framework = 1 << 1
   };
+
+  /// The key under which a tuple type is uniqued.
+  ///
+  /// The hash is computed once from the element types and names, so that
+  /// neither lookups nor rehashing have to profile the elements again.
+  struct TupleTypeKey {
+    ArrayRef<TupleTypeElt> Elements;
+    unsigned Hash;
+
+    TupleTypeKey(ArrayRef<TupleTypeElt> elements, unsigned hash)
+      : Elements(elements), Hash(hash) {}
+
+    explicit TupleTypeKey(ArrayRef<TupleTypeElt> elements)
+      : Elements(elements), Hash(elements.size()) {
+      for (const TupleTypeElt &elt : elements)
+        Hash = llvm::hash_combine(Hash, elt.getType().getPointer(),
+                                  elt.getName().getAsOpaquePointer(),
+                                  unsigned(elt.getDefaultArgKind()),
+                                  elt.isVararg());
+    }
+  };
+
+  /// The key under which a bound generic type is uniqued, with a hash that is
+  /// computed once from the declaration, parent and argument types.
+  struct BoundGenericTypeKey {
+    NominalTypeDecl *TheDecl;
+    TypeBase *Parent;
+    ArrayRef<Type> GenericArgs;
+    unsigned Hash;
+
+    BoundGenericTypeKey(NominalTypeDecl *theDecl, Type parent,
+                        ArrayRef<Type> genericArgs)
+      : TheDecl(theDecl), Parent(parent.getPointer()),
+        GenericArgs(genericArgs),
+        Hash(llvm::hash_combine(theDecl, parent.getPointer())) {
+      for (Type arg : genericArgs)
+        Hash = llvm::hash_combine(Hash, arg.getPointer());
+    }
+
+    BoundGenericTypeKey(NominalTypeDecl *theDecl, unsigned hash)
+      : TheDecl(theDecl), Parent(nullptr), Hash(hash) {}
+  };
+}
+
+namespace llvm {
+  template<> struct DenseMapInfo<TupleTypeKey> {
+    static const TupleTypeElt *getEmptyElements() {
+      return DenseMapInfo<const TupleTypeElt *>::getEmptyKey();
+    }
+    static const TupleTypeElt *getTombstoneElements() {
+      return DenseMapInfo<const TupleTypeElt *>::getTombstoneKey();
+    }
+
+    static TupleTypeKey getEmptyKey() {
+      return TupleTypeKey(ArrayRef<TupleTypeElt>(getEmptyElements(), size_t(0)),
+                          0);
+    }
+    static TupleTypeKey getTombstoneKey() {
+      return TupleTypeKey(ArrayRef<TupleTypeElt>(getTombstoneElements(),
+                                                 size_t(0)),
+                          0);
+    }
+    static unsigned getHashValue(const TupleTypeKey &key) {
+      return key.Hash;
+    }
+    static bool isEqual(const TupleTypeKey &lhs, const TupleTypeKey &rhs) {
+      auto isSentinel = [](const TupleTypeKey &key) {
+        return key.Elements.data() == getEmptyElements() ||
+               key.Elements.data() == getTombstoneElements();
+      };
+      if (isSentinel(lhs) || isSentinel(rhs))
+        return lhs.Elements.data() == rhs.Elements.data();
+      if (lhs.Hash != rhs.Hash || lhs.Elements.size() != rhs.Elements.size())
+        return false;
+      for (unsigned i = 0, e = lhs.Elements.size(); i != e; ++i) {
+        const TupleTypeElt &l = lhs.Elements[i], &r = rhs.Elements[i];
+        if (l.getType().getPointer() != r.getType().getPointer() ||
+            l.getName() != r.getName() ||
+            l.getDefaultArgKind() != r.getDefaultArgKind() ||
+            l.isVararg() != r.isVararg())
+          return false;
+      }
+      return true;
+    }
+  };
+
+  template<> struct DenseMapInfo<BoundGenericTypeKey> {
+    static BoundGenericTypeKey getEmptyKey() {
+      return BoundGenericTypeKey(
+          static_cast<NominalTypeDecl *>(DenseMapInfo<void *>::getEmptyKey()),
+          0);
+    }
+    static BoundGenericTypeKey getTombstoneKey() {
+      return BoundGenericTypeKey(
+          static_cast<NominalTypeDecl *>(
+            DenseMapInfo<void *>::getTombstoneKey()),
+          0);
+    }
+    static unsigned getHashValue(const BoundGenericTypeKey &key) {
+      return key.Hash;
+    }
+    static bool isEqual(const BoundGenericTypeKey &lhs,
+                        const BoundGenericTypeKey &rhs) {
+      return lhs.TheDecl == rhs.TheDecl && lhs.Hash == rhs.Hash &&
+             lhs.Parent == rhs.Parent &&
+             lhs.GenericArgs.size() == rhs.GenericArgs.size() &&
+             std::equal(lhs.GenericArgs.begin(), lhs.GenericArgs.end(),
+                        rhs.GenericArgs.begin(),
+                        [](Type l, Type r) {
+                          return l.getPointer() == r.getPointer();
+                        });
+    }
+  };
 }
 
 struct ASTContext::Implementation {
@@ -81,7 +196,8 @@ struct ASTContext::Implementation {
   /// The last resolver.
   LazyResolver *Resolver = nullptr;
 
-  llvm::StringMap<char, llvm::BumpPtrAllocator&> IdentifierTable;
+  /// The interned identifiers, which may be looked up from any thread.
+  ConcurrentStringTable IdentifierTable;
 
   /// The declaration of Swift.Bool.
   NominalTypeDecl *BoolDecl = nullptr;
@@ -247,7 +363,7 @@ struct ASTContext::Implementation {
   /// \brief Structure that captures data that is segregated into different
   /// arenas.
   struct Arena {
-    llvm::FoldingSet<TupleType> TupleTypes;
+    llvm::DenseMap<TupleTypeKey, TupleType *> TupleTypes;
     llvm::DenseMap<std::pair<Type,char>, MetatypeType*> MetatypeTypes;
     llvm::DenseMap<std::pair<Type,char>,
                    ExistentialMetatypeType*> ExistentialMetatypeTypes;
@@ -269,7 +385,7 @@ struct ASTContext::Implementation {
     llvm::FoldingSet<StructType> StructTypes;
     llvm::FoldingSet<ClassType> ClassTypes;
     llvm::FoldingSet<UnboundGenericType> UnboundGenericTypes;
-    llvm::FoldingSet<BoundGenericType> BoundGenericTypes;
+    llvm::DenseMap<BoundGenericTypeKey, BoundGenericType *> BoundGenericTypes;
 
     llvm::DenseMap<std::pair<BoundGenericType *, DeclContext *>,
                    ArrayRef<Substitution>>
@@ -297,6 +413,9 @@ struct ASTContext::Implementation {
     }
 
     size_t getTotalMemory() const;
+
+    /// Returns the number of types interned in this arena.
+    size_t getNumTypes() const;
   };
 
   llvm::DenseMap<Module*, ModuleType*> ModuleTypes;
@@ -351,6 +470,11 @@ struct ASTContext::Implementation {
   /// \brief The current constraint solver arena, if any.
   std::unique_ptr<ConstraintSolverArena> CurrentConstraintSolverArena;
 
+  /// The largest size any constraint solver arena reached, and the number of
+  /// types interned in it, for printStatistics().
+  size_t PeakSolverArenaMemory = 0;
+  size_t PeakSolverArenaTypes = 0;
+
   Arena &getArena(AllocationArena arena) {
     switch (arena) {
     case AllocationArena::Permanent:
@@ -364,8 +488,7 @@ struct ASTContext::Implementation {
   }
 };
 
-ASTContext::Implementation::Implementation()
- : IdentifierTable(Allocator) {}
+ASTContext::Implementation::Implementation() {}
 ASTContext::Implementation::~Implementation() {
   for (auto &cleanup : Cleanups)
     cleanup();
@@ -383,6 +506,13 @@ ConstraintCheckerArenaRAII(ASTContext &self, llvm::BumpPtrAllocator &allocator,
 }
 
 ConstraintCheckerArenaRAII::~ConstraintCheckerArenaRAII() {
+  auto &Arena = *Self.Impl.CurrentConstraintSolverArena;
+  Self.Impl.PeakSolverArenaMemory =
+    std::max(Self.Impl.PeakSolverArenaMemory,
+             Arena.Allocator.getTotalMemory() + Arena.getTotalMemory());
+  Self.Impl.PeakSolverArenaTypes =
+    std::max(Self.Impl.PeakSolverArenaTypes, Arena.getNumTypes());
+
   Self.Impl.CurrentConstraintSolverArena.reset(
     (ASTContext::Implementation::ConstraintSolverArena *)Data);
 }
@@ -479,8 +609,7 @@ Identifier ASTContext::getIdentifier(StringRef Str) const {
   // Make sure null pointers stay null.
   if (Str.data() == nullptr) return Identifier(0);
 
-  auto I = Impl.IdentifierTable.insert(std::make_pair(Str, char())).first;
-  return Identifier(I->getKeyData());
+  return Identifier(Impl.IdentifierTable.intern(Str));
 }
 
 void ASTContext::lookupInSwiftModule(
@@ -1601,6 +1730,7 @@ size_t ASTContext::getTotalMemory() const {
     // RemappedTypes ?
     sizeof(Impl) +
     Impl.Allocator.getTotalMemory() +
+    Impl.IdentifierTable.getTotalMemory() +
     Impl.Cleanups.capacity() +
     llvm::capacity_in_bytes(Impl.ModuleLoaders) +
     llvm::capacity_in_bytes(Impl.RawComments) +
@@ -1637,7 +1767,7 @@ size_t ASTContext::getSolverMemory() const {
 
 size_t ASTContext::Implementation::Arena::getTotalMemory() const {
   return sizeof(*this) +
-    // TupleTypes ?
+    llvm::capacity_in_bytes(TupleTypes) +
     llvm::capacity_in_bytes(MetatypeTypes) +
     llvm::capacity_in_bytes(ExistentialMetatypeTypes) +
     llvm::capacity_in_bytes(FunctionTypes) +
@@ -1656,8 +1786,173 @@ size_t ASTContext::Implementation::Arena::getTotalMemory() const {
     // StructTypes ?
     // ClassTypes ?
     // UnboundGenericTypes ?
-    // BoundGenericTypes ?
+    llvm::capacity_in_bytes(BoundGenericTypes) +
     llvm::capacity_in_bytes(BoundGenericSubstitutions);
+}
+
+size_t ASTContext::Implementation::Arena::getNumTypes() const {
+  return TupleTypes.size() +
+    MetatypeTypes.size() +
+    ExistentialMetatypeTypes.size() +
+    FunctionTypes.size() +
+    ArraySliceTypes.size() +
+    DictionaryTypes.size() +
+    OptionalTypes.size() +
+    ImplicitlyUnwrappedOptionalTypes.size() +
+    ParenTypes.size() +
+    ReferenceStorageTypes.size() +
+    LValueTypes.size() +
+    InOutTypes.size() +
+    SubstitutedTypes.size() +
+    DependentMemberTypes.size() +
+    DynamicSelfTypes.size() +
+    EnumTypes.size() +
+    StructTypes.size() +
+    ClassTypes.size() +
+    UnboundGenericTypes.size() +
+    BoundGenericTypes.size();
+}
+
+bool ASTNodeCounts::Enabled = false;
+
+unsigned ASTNodeCounts::Decls[] = {
+#define DECL(Id, Parent) 0,
+#include "swift/AST/DeclNodes.def"
+};
+
+unsigned ASTNodeCounts::Exprs[] = {
+#define EXPR(Id, Parent) 0,
+#include "swift/AST/ExprNodes.def"
+};
+
+unsigned ASTNodeCounts::Types[] = {
+#define TYPE(Id, Parent) 0,
+#include "swift/AST/TypeNodes.def"
+};
+
+unsigned ASTNodeCounts::TypeReprs[] = {
+#define TYPEREPR(Id, Parent) 0,
+#include "swift/AST/TypeReprNodes.def"
+};
+
+uint64_t ASTNodeCounts::TypeBytes[] = {
+  0, // AllocationArena::Permanent
+  0, // AllocationArena::ConstraintSolver
+};
+
+template <size_t N>
+static uint64_t sumCounts(const unsigned (&counts)[N]) {
+  uint64_t total = 0;
+  for (unsigned count : counts)
+    total += count;
+  return total;
+}
+
+uint64_t ASTNodeCounts::getTotalDecls() { return sumCounts(Decls); }
+uint64_t ASTNodeCounts::getTotalExprs() { return sumCounts(Exprs); }
+uint64_t ASTNodeCounts::getTotalTypes() { return sumCounts(Types); }
+uint64_t ASTNodeCounts::getTotalTypeReprs() { return sumCounts(TypeReprs); }
+
+namespace {
+  /// The count and size of the nodes of one kind, as printed by
+  /// ASTContext::printStatistics().
+  struct NodeKindStatistics {
+    const char *Name;
+    unsigned Count;
+    size_t Size;
+
+    uint64_t getBytes() const { return uint64_t(Count) * Size; }
+  };
+}
+
+/// Prints the nodes of one category that were created at least once, with the
+/// ones using the most memory first.
+static void printNodeKinds(raw_ostream &OS, StringRef Category,
+                           MutableArrayRef<NodeKindStatistics> Kinds) {
+  std::sort(Kinds.begin(), Kinds.end(),
+            [](const NodeKindStatistics &LHS, const NodeKindStatistics &RHS) {
+    return LHS.getBytes() > RHS.getBytes();
+  });
+
+  unsigned TotalCount = 0;
+  uint64_t TotalBytes = 0;
+  for (auto &Kind : Kinds) {
+    TotalCount += Kind.Count;
+    TotalBytes += Kind.getBytes();
+  }
+
+  OS << "  " << Category << ": " << TotalCount << " nodes, "
+     << TotalBytes << " bytes\n";
+  for (auto &Kind : Kinds) {
+    if (Kind.Count == 0)
+      continue;
+    OS << llvm::format("    %8u x %4u = %10llu bytes  %s\n", Kind.Count,
+                       unsigned(Kind.Size), (unsigned long long)Kind.getBytes(),
+                       Kind.Name);
+  }
+}
+
+void ASTContext::printStatistics(raw_ostream &OS) const {
+  OS << "*** AST Statistics:\n";
+
+  NodeKindStatistics Decls[] = {
+#define DECL(Id, Parent) \
+    { #Id "Decl", ASTNodeCounts::Decls[unsigned(DeclKind::Id)], \
+      sizeof(Id##Decl) },
+#include "swift/AST/DeclNodes.def"
+  };
+  printNodeKinds(OS, "Decls", Decls);
+
+  NodeKindStatistics Exprs[] = {
+#define EXPR(Id, Parent) \
+    { #Id "Expr", ASTNodeCounts::Exprs[unsigned(ExprKind::Id)], \
+      sizeof(Id##Expr) },
+#include "swift/AST/ExprNodes.def"
+  };
+  printNodeKinds(OS, "Exprs", Exprs);
+
+  NodeKindStatistics Types[] = {
+#define TYPE(Id, Parent) \
+    { #Id "Type", ASTNodeCounts::Types[unsigned(TypeKind::Id)], \
+      sizeof(Id##Type) },
+#include "swift/AST/TypeNodes.def"
+  };
+  printNodeKinds(OS, "Types", Types);
+
+  NodeKindStatistics TypeReprs[] = {
+#define TYPEREPR(Id, Parent) \
+    { #Id "TypeRepr", ASTNodeCounts::TypeReprs[unsigned(TypeReprKind::Id)], \
+      sizeof(Id##TypeRepr) },
+#include "swift/AST/TypeReprNodes.def"
+  };
+  printNodeKinds(OS, "TypeReprs", TypeReprs);
+
+  OS << "  Type bytes, including trailing storage: "
+     << ASTNodeCounts::TypeBytes[unsigned(AllocationArena::Permanent)]
+     << " permanent, "
+     << ASTNodeCounts::TypeBytes[unsigned(AllocationArena::ConstraintSolver)]
+     << " constraint solver\n";
+
+  OS << "  Permanent arena: " << Impl.Allocator.getTotalMemory()
+     << " bytes, " << Impl.Allocator.getBytesAllocated()
+     << " bytes allocated\n";
+  OS << "  Peak constraint solver arena: " << Impl.PeakSolverArenaMemory
+     << " bytes, " << Impl.PeakSolverArenaTypes << " interned types\n";
+  OS << "  Total memory: " << getTotalMemory() << " bytes\n";
+
+  size_t NumInternedTypes = Impl.Permanent.getNumTypes() +
+    Impl.ModuleTypes.size() +
+    Impl.GenericParamTypes.size() +
+    Impl.GenericFunctionTypes.size() +
+    Impl.SILFunctionTypes.size() +
+    Impl.SILBlockStorageTypes.size() +
+    Impl.SILBoxTypes.size() +
+    Impl.IntegerTypes.size() +
+    Impl.ProtocolCompositionTypes.size() +
+    Impl.BuiltinVectorTypes.size() +
+    Impl.OpenedExistentialArchetypes.size();
+  OS << "  Identifiers: " << Impl.IdentifierTable.size() << "\n";
+  OS << "  Interned types: " << NumInternedTypes << "\n";
     // NormalConformances ?
     // SpecializedConformances ?
     // InheritedConformances ?
@@ -2320,15 +2615,6 @@ CanTupleType TupleType::getEmpty(const ASTContext &C) {
   return cast<TupleType>(CanType(C.TheEmptyTupleType));
 }
 
-void TupleType::Profile(llvm::FoldingSetNodeID &ID,
-                        ArrayRef<TupleTypeElt> Fields) {
-  ID.AddInteger(Fields.size());
-  for (const TupleTypeElt &Elt : Fields) {
-    ID.AddPointer(Elt.NameAndVariadic.getOpaqueValue());
-    ID.AddPointer(Elt.TyAndDefaultArg.getOpaqueValue());
-  }
-}
-
 /// getTupleType - Return the uniqued tuple type with the specified elements.
 Type TupleType::get(ArrayRef<TupleTypeElt> Fields, const ASTContext &C) {
   if (Fields.size() == 1 && !Fields[0].isVararg() && !Fields[0].hasName()
@@ -2336,42 +2622,35 @@ Type TupleType::get(ArrayRef<TupleTypeElt> Fields, const ASTContext &C) {
     return ParenType::get(C, Fields[0].getType());
 
   RecursiveTypeProperties properties;
+  bool IsCanonical = true;   // All canonical elts means this is canonical.
   for (const TupleTypeElt &Elt : Fields) {
-    if (Elt.getType())
+    if (Elt.getType()) {
       properties |= Elt.getType()->getRecursiveProperties();
+      IsCanonical &= Elt.getType()->isCanonical();
+    } else {
+      IsCanonical = false;
+    }
     if (Elt.getDefaultArgKind() != DefaultArgumentKind::None)
       properties |= RecursiveTypeProperties::HasDefaultParameter;
   }
 
   auto arena = getArena(properties);
+  auto &TupleTypes = C.Impl.getArena(arena).TupleTypes;
 
-
-  void *InsertPos = 0;
   // Check to see if we've already seen this tuple before.
-  llvm::FoldingSetNodeID ID;
-  TupleType::Profile(ID, Fields);
-
-  if (TupleType *TT
-        = C.Impl.getArena(arena).TupleTypes.FindNodeOrInsertPos(ID,InsertPos))
-    return TT;
+  TupleTypeKey Key(Fields);
+  auto Known = TupleTypes.find(Key);
+  if (Known != TupleTypes.end())
+    return Known->second;
 
   // Make a copy of the fields list into ASTContext owned memory.
   TupleTypeElt *FieldsCopy =
     C.AllocateCopy<TupleTypeElt>(Fields.begin(), Fields.end(), arena);
-
-  bool IsCanonical = true;   // All canonical elts means this is canonical.
-  for (const TupleTypeElt &Elt : Fields) {
-    if (Elt.getType().isNull() || !Elt.getType()->isCanonical()) {
-      IsCanonical = false;
-      break;
-    }
-  }
-
   Fields = ArrayRef<TupleTypeElt>(FieldsCopy, Fields.size());
 
   TupleType *New = new (C, arena) TupleType(Fields, IsCanonical ? &C : 0,
                                             properties);
-  C.Impl.getArena(arena).TupleTypes.InsertNode(New, InsertPos);
+  TupleTypes.insert({TupleTypeKey(Fields, Key.Hash), New});
   return New;
 }
 
@@ -2401,20 +2680,6 @@ UnboundGenericType* UnboundGenericType::get(NominalTypeDecl *TheDecl,
   return result;
 }
 
-void BoundGenericType::Profile(llvm::FoldingSetNodeID &ID,
-                               NominalTypeDecl *TheDecl, Type Parent,
-                               ArrayRef<Type> GenericArgs,
-                               RecursiveTypeProperties &properties) {
-  ID.AddPointer(TheDecl);
-  ID.AddPointer(Parent.getPointer());
-  if (Parent) properties |= Parent->getRecursiveProperties();
-  ID.AddInteger(GenericArgs.size());
-  for (Type Arg : GenericArgs) {
-    ID.AddPointer(Arg.getPointer());
-    properties |= Arg->getRecursiveProperties();
-  }
-}
-
 BoundGenericType::BoundGenericType(TypeKind theKind,
                                    NominalTypeDecl *theDecl,
                                    Type parent,
@@ -2430,28 +2695,26 @@ BoundGenericType *BoundGenericType::get(NominalTypeDecl *TheDecl,
                                         Type Parent,
                                         ArrayRef<Type> GenericArgs) {
   ASTContext &C = TheDecl->getDeclContext()->getASTContext();
-  llvm::FoldingSetNodeID ID;
   RecursiveTypeProperties properties;
-  BoundGenericType::Profile(ID, TheDecl, Parent, GenericArgs, properties);
+  bool IsCanonical = true;
+  if (Parent) {
+    properties |= Parent->getRecursiveProperties();
+    IsCanonical = Parent->isCanonical();
+  }
+  for (Type Arg : GenericArgs) {
+    properties |= Arg->getRecursiveProperties();
+    IsCanonical &= Arg->isCanonical();
+  }
 
   auto arena = getArena(properties);
+  auto &BoundGenericTypes = C.Impl.getArena(arena).BoundGenericTypes;
 
-  void *InsertPos = 0;
-  if (BoundGenericType *BGT =
-        C.Impl.getArena(arena).BoundGenericTypes.FindNodeOrInsertPos(ID,
-                                                                     InsertPos))
-    return BGT;
+  BoundGenericTypeKey Key(TheDecl, Parent, GenericArgs);
+  auto Known = BoundGenericTypes.find(Key);
+  if (Known != BoundGenericTypes.end())
+    return Known->second;
 
   ArrayRef<Type> ArgsCopy = C.AllocateCopy(GenericArgs, arena);
-  bool IsCanonical = !Parent || Parent->isCanonical();
-  if (IsCanonical) {
-    for (Type Arg : GenericArgs) {
-      if (!Arg->isCanonical()) {
-        IsCanonical = false;
-        break;
-      }
-    }
-  }
 
   BoundGenericType *newType;
   if (auto theClass = dyn_cast<ClassDecl>(TheDecl)) {
@@ -2468,7 +2731,8 @@ BoundGenericType *BoundGenericType::get(NominalTypeDecl *TheDecl,
                                                    IsCanonical ? &C : 0,
                                                    properties);
   }
-  C.Impl.getArena(arena).BoundGenericTypes.InsertNode(newType, InsertPos);
+  Key.GenericArgs = ArgsCopy;
+  BoundGenericTypes.insert({Key, newType});
 
   return newType;
 }
@@ -451,6 +451,17 @@ bool ConformanceLookupTable::addProtocol(NominalTypeDecl *nominal,
         // An implied conformance is better than a synthesized one.
         if (kind == ConformanceEntryKind::Synthesized)
           return false;
+
+        // If this protocol is already implied by the same explicit
+        // conformance in the same context, we reached it through another
+        // path in the protocol hierarchy. The two entries would be
+        // indistinguishable when resolving conformances, and expanding both
+        // would make the table grow with the number of paths through the
+        // hierarchy rather than the number of protocols in it.
+        if (existingEntry->getDeclContext() == dc &&
+            existingEntry->getDeclaredConformance() ==
+              source.getImpliedSource()->getDeclaredConformance())
+          return false;
         break;
 
       case ConformanceEntryKind::Synthesized:
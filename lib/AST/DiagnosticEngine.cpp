@@ -495,6 +495,11 @@ void DiagnosticEngine::emitDiagnostic(const Diagnostic &diagnostic) {
     break;
   }
 
+  // If nobody is listening, don't bother resolving the location (which may
+  // pretty-print a declaration) or formatting the arguments.
+  if (Consumers.empty())
+    return;
+
   // Figure out the source location.
   SourceLoc loc = diagnostic.getLoc();
   if (loc.isInvalid() && diagnostic.getDecl()) {
@@ -0,0 +1,196 @@
+//===--- FunctionTimeProfile.cpp - Compile time per function --------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/AST/FunctionTimeProfile.h"
+#include "swift/AST/ASTContext.h"
+#include "swift/AST/Decl.h"
+#include "swift/AST/Expr.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace swift;
+
+/// The number of SIL passes listed under each function.
+static const unsigned NumPassesToPrint = 3;
+
+static FunctionTimeProfile *ActiveProfile = nullptr;
+
+FunctionTimeProfile *FunctionTimeProfile::getActive() {
+  return ActiveProfile;
+}
+
+void FunctionTimeProfile::setActive(FunctionTimeProfile *Profile) {
+  ActiveProfile = Profile;
+}
+
+uint64_t FunctionTimeProfile::now() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(
+      steady_clock::now().time_since_epoch()).count();
+}
+
+/// Returns \p DC if it is a function or closure, which are the only contexts
+/// time is attributed to.
+static const DeclContext *getSourceFunction(const DeclContext *DC) {
+  if (DC && (isa<AbstractFunctionDecl>(DC) || isa<AbstractClosureExpr>(DC)))
+    return DC;
+  return nullptr;
+}
+
+uint64_t FunctionTimeProfile::Entry::getTotal() const {
+  uint64_t total = 0;
+  for (uint64_t time : Times)
+    total += time;
+  return total;
+}
+
+FunctionTimeProfile::Entry &
+FunctionTimeProfile::getEntry(const DeclContext *DC, StringRef Name) {
+  DC = getSourceFunction(DC);
+  unsigned index;
+  bool inserted;
+  if (DC) {
+    auto result = EntriesByDC.insert({DC, Entries.size()});
+    index = result.first->second;
+    inserted = result.second;
+  } else {
+    auto result = EntriesByName.insert({Name, Entries.size()});
+    index = result.first->second;
+    inserted = result.second;
+  }
+  if (!inserted)
+    return Entries[index];
+
+  Entries.emplace_back();
+  Entries.back().DC = DC;
+  Entries.back().Name = Name;
+  return Entries.back();
+}
+
+void FunctionTimeProfile::addTime(const DeclContext *DC, StringRef Name,
+                                  Phase P, uint64_t Nanoseconds) {
+  std::lock_guard<std::mutex> guard(Lock);
+  getEntry(DC, Name).Times[unsigned(P)] += Nanoseconds;
+}
+
+void FunctionTimeProfile::addPassTime(const DeclContext *DC, StringRef Name,
+                                      StringRef Pass, uint64_t Nanoseconds) {
+  std::lock_guard<std::mutex> guard(Lock);
+  Entry &entry = getEntry(DC, Name);
+  entry.Times[unsigned(Phase::SILOptimization)] += Nanoseconds;
+  entry.PassTimes[Pass] += Nanoseconds;
+}
+
+void FunctionTimeProfile::setSymbolSource(StringRef Symbol,
+                                          const DeclContext *DC) {
+  std::lock_guard<std::mutex> guard(Lock);
+  SymbolSources[Symbol] = DC;
+}
+
+const DeclContext *
+FunctionTimeProfile::getSymbolSource(StringRef Symbol) const {
+  std::lock_guard<std::mutex> guard(Lock);
+  auto found = SymbolSources.find(Symbol);
+  return found == SymbolSources.end() ? nullptr : found->second;
+}
+
+FunctionTimeProfile::Timer::Timer(const DeclContext *DC, StringRef Name,
+                                  Phase P)
+  : Profile(getActive()), DC(DC), Name(Name), P(P),
+    Start(Profile ? now() : 0), Parent(nullptr) {
+  if (Profile) {
+    Parent = Profile->CurrentTimer;
+    Profile->CurrentTimer = this;
+  }
+}
+
+FunctionTimeProfile::Timer::~Timer() {
+  if (!Profile)
+    return;
+  uint64_t elapsed = now() - Start;
+  Profile->CurrentTimer = Parent;
+  if (Parent)
+    Parent->NestedTime += elapsed;
+  Profile->addTime(DC, Name, P, elapsed - std::min(elapsed, NestedTime));
+}
+
+/// Prints the location and name of a function, or only its symbol name if it
+/// has no source.
+static void printSource(raw_ostream &os, const DeclContext *DC,
+                        StringRef Name) {
+  if (auto *AFD = dyn_cast_or_null<AbstractFunctionDecl>(DC)) {
+    AFD->getLoc().print(os, AFD->getASTContext().SourceMgr);
+    os << "  " << AFD->getFullName();
+    return;
+  }
+
+  if (auto *ACE = dyn_cast_or_null<AbstractClosureExpr>(DC)) {
+    ACE->getLoc().print(os, ACE->getASTContext().SourceMgr);
+    os << "  (closure)";
+    return;
+  }
+
+  os << "<no source>  " << Name;
+}
+
+void FunctionTimeProfile::print(raw_ostream &os, unsigned Limit) const {
+  std::lock_guard<std::mutex> guard(Lock);
+
+  std::vector<const Entry *> sorted;
+  for (const Entry &entry : Entries)
+    sorted.push_back(&entry);
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Entry *lhs, const Entry *rhs) {
+    return lhs->getTotal() > rhs->getTotal();
+  });
+  if (sorted.size() > Limit)
+    sorted.resize(Limit);
+
+  auto ms = [](uint64_t nanoseconds) {
+    return llvm::format("%9.2f", nanoseconds / 1e6);
+  };
+
+  os << "===- Compile time per function (ms) -===\n";
+  for (const char *column : {"total", "sema", "silgen", "silopt", "irgen",
+                             "llvm"})
+    os << llvm::format("%9s", column);
+  os << "  function\n";
+  for (const Entry *entry : sorted) {
+    os << ms(entry->getTotal());
+    for (uint64_t time : entry->Times)
+      os << ms(time);
+    os << "  ";
+    printSource(os, entry->DC, entry->Name);
+    os << "\n";
+
+    if (entry->PassTimes.empty())
+      continue;
+
+    std::vector<std::pair<StringRef, uint64_t>> passes;
+    for (auto &pass : entry->PassTimes)
+      passes.push_back({pass.getKey(), pass.getValue()});
+    std::sort(passes.begin(), passes.end(),
+              [](const std::pair<StringRef, uint64_t> &lhs,
+                 const std::pair<StringRef, uint64_t> &rhs) {
+      return lhs.second > rhs.second;
+    });
+    if (passes.size() > NumPassesToPrint)
+      passes.resize(NumPassesToPrint);
+
+    os << "             SIL passes:";
+    for (auto &pass : passes)
+      os << " " << pass.first << llvm::format(" %.2f", pass.second / 1e6);
+    os << "\n";
+  }
+}
@@ -881,11 +881,9 @@ void ExtensionDecl::addedMember(Decl *member) {
   if (NextExtension.getInt()) {
     auto nominal = getExtendedType()->getAnyNominal();
     if (nominal->LookupTable.getPointer()) {
-      // Make sure we have the complete list of extensions.
-      // FIXME: This is completely unnecessary. We want to determine whether
-      // our own extension has already been included in the lookup table.
-      (void)nominal->getExtensions();
-
+      // Adding the member now is correct whether or not this extension has
+      // been included in the lookup table yet: if it hasn't, the member will
+      // be skipped as already present when the extension is walked.
       nominal->LookupTable.getPointer()->addMember(member);
     }
   }
@@ -923,15 +921,61 @@ void NominalTypeDecl::makeMemberVisible(ValueDecl *member) {
   LookupTable.getPointer()->addMember(member);
 }
 
+/// Add the members of \p IDC whose base name matches \p name to \p members.
+/// Lazy members are only loaded if their loader can't look them up by name.
+static bool collectNamedMembers(const IterableDeclContext *IDC, const Decl *D,
+                                DeclName name,
+                                SmallVectorImpl<ValueDecl *> &members) {
+  for (auto member : IDC->getCurrentMembersWithoutLoading())
+    if (auto VD = dyn_cast<ValueDecl>(member))
+      if (VD->getFullName().getBaseName() == name.getBaseName())
+        members.push_back(VD);
+
+  if (!IDC->isLazy())
+    return true;
+  return IDC->getLoader()->loadNamedMembers(D, name,
+                                            IDC->getLoaderContextData(),
+                                            members);
+}
+
+bool NominalTypeDecl::loadNamedMembers(DeclName name) {
+  SmallVector<ValueDecl *, 4> members;
+  if (!collectNamedMembers(this, this, name, members))
+    return false;
+  for (auto ext : getExtensions())
+    if (!collectNamedMembers(ext, ext, name, members))
+      return false;
+
+  if (!LookupTable.getPointer()) {
+    auto &ctx = getASTContext();
+    LookupTable.setPointer(new (ctx) MemberLookupTable(ctx));
+  }
+  for (auto member : members)
+    LookupTable.getPointer()->addMember(member);
+  return true;
+}
+
 ArrayRef<ValueDecl *> NominalTypeDecl::lookupDirect(DeclName name,
                                                     bool ignoreNewExtensions) {
-  // Make sure we have the complete list of members (in this nominal and in all
-  // extensions).
-  if (!ignoreNewExtensions) {
-    for (auto E : getExtensions())
-      (void)E->getMembers();
+  // If the members haven't been loaded yet, try to only load the members with
+  // the given name. The loaded members are added to the lookup table, which
+  // still gets populated with all members when the member list is loaded.
+  // Protocols need their complete list of requirements, so they are always
+  // loaded completely.
+  if (!ignoreNewExtensions && isLazy() && !LookupTable.getInt() &&
+      !isa<ProtocolDecl>(this) && loadNamedMembers(name)) {
+    auto known = LookupTable.getPointer()->find(name);
+    if (known == LookupTable.getPointer()->end())
+      return { };
+    return { known->second.begin(), known->second.size() };
   }
 
+  // Make sure we have the complete list of extensions. Their members are
+  // loaded as each new extension is added to the lookup table, so there's no
+  // need to walk every extension on every lookup.
+  if (!ignoreNewExtensions)
+    (void)getExtensions();
+
   (void)getMembers();
 
   prepareLookupTable(ignoreNewExtensions);
@@ -150,14 +150,15 @@ RawComment Decl::getRawComment() const {
   if (auto *Unit =
           dyn_cast<FileUnit>(this->getDeclContext()->getModuleScopeContext())) {
     if (Optional<BriefAndRawComment> C = Unit->getCommentForDecl(this)) {
-      llvm::markup::MarkupContext MC;
       Context.setBriefComment(this, C->Brief);
       Context.setRawComment(this, C->Raw);
       return C->Raw;
     }
   }
 
-  // Give up.
+  // Give up, and remember that, so that asking again doesn't have to
+  // compute the decl's USR and search the module's comment table.
+  Context.setRawComment(this, RawComment());
   return RawComment();
 }
 
@@ -196,6 +197,12 @@ StringRef Decl::getBriefComment() const {
 
   StringRef Result;
   auto RC = getRawComment();
+
+  // Serialized modules store the brief comment next to the raw comment, so
+  // the comment doesn't have to be parsed as markup.
+  if (Optional<StringRef> Comment = Context.getBriefComment(this))
+    return Comment.getValue();
+
   if (!RC.isEmpty())
     Result = extractBriefComment(Context, RC, this);
 
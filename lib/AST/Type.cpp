@@ -48,6 +48,8 @@ SourceRange TypeLoc::getSourceRange() const {
 // Only allow allocation of Types using the allocator in ASTContext.
 void *TypeBase::operator new(size_t bytes, const ASTContext &ctx,
                              AllocationArena arena, unsigned alignment) {
+  if (ASTNodeCounts::Enabled)
+    ASTNodeCounts::TypeBytes[unsigned(arena)] += bytes;
   return ctx.Allocate(bytes, alignment, arena);
 }
 
@@ -14,12 +14,19 @@
 #include "Darwin/Cache-Mac.cpp"
 #else
 
-//  This file implements a default caching implementation that never evicts
-//  its entries.
+//  This file implements a default caching implementation. Entries are
+//  evicted in least-recently-used order once their total cost exceeds a
+//  limit, or when the system reports memory pressure.
 
 #include "swift/Basic/Cache.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Mutex.h"
+#include <cstdlib>
+#include <fstream>
+#include <list>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
 
 using namespace swift::sys;
 using llvm::StringRef;
@@ -34,11 +41,72 @@ struct DefaultCacheKey {
 };
 
 struct DefaultCache {
+  struct Entry {
+    void *Key;
+    void *Value;
+    size_t Cost;
+  };
+  typedef std::list<Entry>::iterator EntryIterator;
+
+  /// How often a value handed out by the cache is still retained, and how
+  /// many destroy callbacks were deferred until it is released.
+  struct RetainInfo {
+    unsigned RetainCount = 0;
+    unsigned PendingDestroys = 0;
+  };
+
   llvm::sys::Mutex Mux;
   CacheImpl::CallBacks CBs;
-  llvm::DenseMap<DefaultCacheKey, void *> Entries;
 
-  explicit DefaultCache(CacheImpl::CallBacks CBs) : CBs(std::move(CBs)) { }
+  /// The entries, most recently used first.
+  std::list<Entry> LRU;
+  llvm::DenseMap<DefaultCacheKey, EntryIterator> Entries;
+  llvm::DenseMap<void *, RetainInfo> Retained;
+
+  size_t TotalCost = 0;
+  size_t CostLimit;
+
+  explicit DefaultCache(CacheImpl::CallBacks CBs);
+
+  void retainValue(void *Value) {
+    ++Retained[Value].RetainCount;
+  }
+
+  /// Destroys \p Value, or defers that until it is no longer retained.
+  void destroyValue(void *Value) {
+    auto Found = Retained.find(Value);
+    if (Found != Retained.end()) {
+      ++Found->second.PendingDestroys;
+      return;
+    }
+    CBs.valueDestroyCB(Value, CBs.UserData);
+  }
+
+  void releaseValue(void *Value) {
+    auto Found = Retained.find(Value);
+    assert(Found != Retained.end() && "releasing a value that isn't retained");
+    if (--Found->second.RetainCount != 0)
+      return;
+    unsigned PendingDestroys = Found->second.PendingDestroys;
+    Retained.erase(Found);
+    while (PendingDestroys--)
+      CBs.valueDestroyCB(Value, CBs.UserData);
+  }
+
+  void removeEntry(EntryIterator I) {
+    Entries.erase(DefaultCacheKey(I->Key, &CBs));
+    TotalCost -= I->Cost;
+    CBs.keyDestroyCB(I->Key, CBs.UserData);
+    destroyValue(I->Value);
+    LRU.erase(I);
+  }
+
+  /// Evicts the least recently used entries until the total cost is at most
+  /// \p Limit. The most recently used entry is never evicted.
+  void evictDownTo(size_t Limit) {
+    while (TotalCost > Limit && LRU.size() > 1)
+      removeEntry(std::prev(LRU.end()));
+  }
 };
 } // end anonymous namespace
 
@@ -67,6 +135,69 @@ template<> struct DenseMapInfo<DefaultCacheKey> {
 };
 }
 
+/// Reads a single integer from the file at \p Path.
+static bool readIntegerFromFile(const char *Path, uint64_t &Result) {
+  std::ifstream File(Path);
+  return static_cast<bool>(File >> Result);
+}
+
+/// Returns the amount of memory this process may use: the physical memory,
+/// further limited by the memory cgroup we're running in, if any.
+static uint64_t getAvailableMemory() {
+  uint64_t Memory = UINT64_MAX;
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+  long Pages = sysconf(_SC_PHYS_PAGES);
+  long PageSize = sysconf(_SC_PAGESIZE);
+  if (Pages > 0 && PageSize > 0)
+    Memory = uint64_t(Pages) * uint64_t(PageSize);
+#endif
+#if defined(__linux__)
+  // cgroup v2 reports "max" when there's no limit, which fails to parse.
+  uint64_t Limit;
+  if (readIntegerFromFile("/sys/fs/cgroup/memory.max", Limit) ||
+      readIntegerFromFile("/sys/fs/cgroup/memory/memory.limit_in_bytes",
+                          Limit))
+    Memory = std::min(Memory, Limit);
+#endif
+  return Memory;
+}
+
+/// Returns true if the system reports that tasks are stalling on memory.
+static bool isUnderMemoryPressure() {
+#if defined(__linux__)
+  // The first line has the form "some avg10=1.23 avg60=... total=...".
+  std::ifstream File("/proc/pressure/memory");
+  std::string Kind, Avg10;
+  if (!(File >> Kind >> Avg10) || Kind != "some")
+    return false;
+  StringRef Value = StringRef(Avg10);
+  if (!Value.startswith("avg10="))
+    return false;
+  // Consider 10% of the time stalled on memory to be pressure.
+  return std::atof(Value.substr(6).str().c_str()) >= 10.0;
+#else
+  return false;
+#endif
+}
+
+/// Returns the cost limit for new caches. It can be set in bytes with the
+/// SWIFT_CACHE_COST_LIMIT environment variable, and defaults to half of the
+/// available memory.
+static size_t getDefaultCostLimit() {
+  if (const char *Env = ::getenv("SWIFT_CACHE_COST_LIMIT")) {
+    unsigned long long Limit;
+    if (!StringRef(Env).getAsInteger(0, Limit))
+      return Limit;
+  }
+  uint64_t Memory = getAvailableMemory();
+  if (Memory == UINT64_MAX)
+    return SIZE_MAX;
+  return size_t(std::min<uint64_t>(Memory / 2, SIZE_MAX));
+}
+
+DefaultCache::DefaultCache(CacheImpl::CallBacks CBs)
+  : CBs(std::move(CBs)), CostLimit(getDefaultCostLimit()) {}
+
 CacheImpl::ImplTy CacheImpl::create(StringRef Name, const CallBacks &CBs) {
   return new DefaultCache(CBs);
 }
@@ -77,16 +208,19 @@ void CacheImpl::setAndRetain(void *Key, void *Value, size_t Cost) {
 
   DefaultCacheKey CKey(Key, &DCache.CBs);
   auto Entry = DCache.Entries.find(CKey);
-  if (Entry != DCache.Entries.end()) {
-    DCache.CBs.keyDestroyCB(Entry->first.Key, nullptr);
-    DCache.CBs.valueDestroyCB(Entry->second, nullptr);
-    DCache.Entries.erase(Entry);
-  }
+  if (Entry != DCache.Entries.end())
+    DCache.removeEntry(Entry->second);
 
-  DCache.Entries[CKey] = Value;
+  DCache.LRU.push_front({ Key, Value, Cost });
+  DCache.Entries[CKey] = DCache.LRU.begin();
+  DCache.TotalCost += Cost;
+  DCache.retainValue(Value);
 
-  // FIXME: Not thread-safe! It should avoid deleting the value until
-  // 'releaseValue is called on it.
+  // Under memory pressure, give back half of what we hold.
+  size_t Limit = DCache.CostLimit;
+  if (isUnderMemoryPressure())
+    Limit = std::min(Limit, DCache.TotalCost / 2);
+  DCache.evictDownTo(Limit);
 }
 
 bool CacheImpl::getAndRetain(const void *Key, void **Value_out) {
@@ -95,17 +229,21 @@ bool CacheImpl::getAndRetain(const void *Key, void **Value_out) {
 
   DefaultCacheKey CKey(const_cast<void*>(Key), &DCache.CBs);
   auto Entry = DCache.Entries.find(CKey);
-  if (Entry != DCache.Entries.end()) {
-    // FIXME: Not thread-safe! It should avoid deleting the value until
-    // 'releaseValue is called on it.
-    *Value_out = Entry->second;
-    return true;
-  }
-  return false;
+  if (Entry == DCache.Entries.end())
+    return false;
+
+  // Move the entry to the front of the LRU list.
+  DefaultCache::EntryIterator I = Entry->second;
+  DCache.LRU.splice(DCache.LRU.begin(), DCache.LRU, I);
+  DCache.retainValue(I->Value);
+  *Value_out = I->Value;
+  return true;
 }
 
 void CacheImpl::releaseValue(void *Value) {
-  // FIXME: Implementation.
+  DefaultCache &DCache = *static_cast<DefaultCache*>(Impl);
+  llvm::sys::ScopedLock L(DCache.Mux);
+  DCache.releaseValue(Value);
 }
 
 bool CacheImpl::remove(const void *Key) {
@@ -114,24 +252,27 @@ bool CacheImpl::remove(const void *Key) {
 
   DefaultCacheKey CKey(const_cast<void*>(Key), &DCache.CBs);
   auto Entry = DCache.Entries.find(CKey);
-  if (Entry != DCache.Entries.end()) {
-    DCache.CBs.keyDestroyCB(Entry->first.Key, nullptr);
-    DCache.CBs.valueDestroyCB(Entry->second, nullptr);
-    DCache.Entries.erase(Entry);
-    return true;
-  }
-  return false;
+  if (Entry == DCache.Entries.end())
+    return false;
+
+  DCache.removeEntry(Entry->second);
+  return true;
 }
 
 void CacheImpl::removeAll() {
   DefaultCache &DCache = *static_cast<DefaultCache*>(Impl);
   llvm::sys::ScopedLock L(DCache.Mux);
 
-  for (auto Entry : DCache.Entries) {
-    DCache.CBs.keyDestroyCB(Entry.first.Key, nullptr);
-    DCache.CBs.valueDestroyCB(Entry.second, nullptr);
-  }
-  DCache.Entries.clear();
+  while (!DCache.LRU.empty())
+    DCache.removeEntry(DCache.LRU.begin());
+}
+
+void CacheImpl::setCostLimit(size_t Limit) {
+  DefaultCache &DCache = *static_cast<DefaultCache*>(Impl);
+  llvm::sys::ScopedLock L(DCache.Mux);
+
+  DCache.CostLimit = Limit;
+  DCache.evictDownTo(Limit);
 }
 
 void CacheImpl::destroy() {
@@ -22,15 +22,23 @@
 using namespace swift;
 
 ClusteredBitVector ClusteredBitVector::fromAPInt(const llvm::APInt &bits) {
-  // This is not a very efficient algorithm.
   ClusteredBitVector result;
-  for (unsigned i = 0, e = bits.getBitWidth(); i != e; ++i) {
-    if (bits[i]) {
-      result.appendSetBits(1);
-    } else {
-      result.appendClearBits(1);
-    }
+  auto numBits = bits.getBitWidth();
+  if (numBits == 0)
+    return result;
+
+  // Stay in the inline-and-all-clear representation if we can.
+  if (bits == 0) {
+    result.appendClearBits(numBits);
+    return result;
   }
+
+  // This assumes that the chunk size is the same as APInt's, and relies on
+  // APInt keeping the unused high bits of its last word clear.
+  static_assert(sizeof(ChunkType) == sizeof(*bits.getRawData()),
+                "chunk size doesn't match APInt's word size");
+  result.reserve(numBits);
+  result.appendReserved(numBits, bits.getRawData());
   return result;
 }
 
@@ -122,22 +130,44 @@ void ClusteredBitVector::appendConstantBitsReserved(size_t numBits,
   assert(LengthInBits + numBits <= getCapacityInBits());
   assert(numBits > 0);
 
-  ChunkType pattern = (addOnes ? ~ChunkType(0) : ChunkType(0));
-  appendReserved(numBits, [=](size_t numBitsWanted) -> ChunkType {
-    return (pattern >> (ChunkSizeInBits - numBitsWanted));
-  });
+  // Fill the unused high bits of the current last chunk, if any.
+  auto offset = LengthInBits % ChunkSizeInBits;
+  ChunkType *nextChunk = &getChunksPtr()[LengthInBits / ChunkSizeInBits];
+  LengthInBits += numBits;
+  if (offset) {
+    auto claimedBits = std::min(numBits, size_t(ChunkSizeInBits - offset));
+    if (addOnes)
+      *nextChunk |= (~ChunkType(0) >> (ChunkSizeInBits - claimedBits))
+                      << offset;
+    ++nextChunk;
+    numBits -= claimedBits;
+    if (numBits == 0) return;
+  }
+
+  // Then fill whole chunks at once, and finally the partial tail chunk,
+  // whose unused high bits must be clear.
+  size_t numWholeChunks = numBits / ChunkSizeInBits;
+  memset(nextChunk, addOnes ? 0xFF : 0, numWholeChunks * sizeof(ChunkType));
+  if (auto tailBits = numBits % ChunkSizeInBits) {
+    nextChunk[numWholeChunks] =
+      addOnes ? (~ChunkType(0) >> (ChunkSizeInBits - tailBits)) : 0;
+  }
 }
 
 void ClusteredBitVector::appendReserved(size_t numBits,
                                         const ChunkType *nextChunk) {
-  // This is easy if we're not currently at an offset.
-  // (Note that this special case generator relies on the exact
-  // implementation of the main appendReserved routine.)
+  // This is easy if we're not currently at an offset: copy the whole
+  // chunks directly and mask off the high bits of the last one.
   auto offset = LengthInBits % ChunkSizeInBits;
   if (!offset) {
-    appendReserved(numBits, [&](size_t numBitsWanted) -> ChunkType {
-      return *nextChunk++;
-    });
+    assert(LengthInBits + numBits <= getCapacityInBits());
+    assert(numBits > 0);
+    ChunkType *dest = &getChunksPtr()[LengthInBits / ChunkSizeInBits];
+    LengthInBits += numBits;
+    size_t numChunks = getNumChunksForBits(numBits);
+    memcpy(dest, nextChunk, numChunks * sizeof(ChunkType));
+    if (auto tailBits = numBits % ChunkSizeInBits)
+      dest[numChunks - 1] &= (ChunkType(1) << tailBits) - 1;
     return;
   }
 
@@ -0,0 +1,167 @@
+//===--- ConcurrentStringTable.cpp - Thread-safe string uniquing ----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/ConcurrentStringTable.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/Allocator.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+using namespace swift;
+
+/// An interned string, which is stored immediately after its header.
+struct ConcurrentStringTable::Entry {
+  size_t Hash;
+  size_t Length;
+
+  const char *getData() const {
+    return reinterpret_cast<const char *>(this + 1);
+  }
+
+  bool matches(StringRef Str, size_t StrHash) const {
+    return Hash == StrHash && Length == Str.size() &&
+           memcmp(getData(), Str.data(), Length) == 0;
+  }
+};
+
+/// An open-addressed array of entries whose size is a power of two.
+///
+/// Slots only ever go from null to an entry, and an entry is fully written
+/// before it is stored into a slot, so the slots can be probed without a lock.
+struct ConcurrentStringTable::Buckets {
+  size_t Mask;
+  std::unique_ptr<std::atomic<Entry *>[]> Slots;
+
+  explicit Buckets(size_t NumSlots)
+    : Mask(NumSlots - 1), Slots(new std::atomic<Entry *>[NumSlots]()) {}
+
+  static size_t getFirstSlot(size_t Hash) {
+    // The low bits of the hash select the shard.
+    return Hash / NumShards;
+  }
+
+  const Entry *find(StringRef Str, size_t Hash) const {
+    for (size_t I = getFirstSlot(Hash);; ++I) {
+      const Entry *E = Slots[I & Mask].load(std::memory_order_acquire);
+      if (!E)
+        return nullptr;
+      if (E->matches(Str, Hash))
+        return E;
+    }
+  }
+
+  /// Stores \p E into the first free slot for its hash. Must be called with
+  /// the shard's lock held.
+  void insert(Entry *E) {
+    for (size_t I = getFirstSlot(E->Hash);; ++I) {
+      auto &Slot = Slots[I & Mask];
+      if (!Slot.load(std::memory_order_relaxed)) {
+        Slot.store(E, std::memory_order_release);
+        return;
+      }
+    }
+  }
+};
+
+struct ConcurrentStringTable::Shard {
+  /// The buckets that new entries go into.
+  std::atomic<Buckets *> Current{nullptr};
+
+  /// Guards everything below, as well as insertions into the current buckets.
+  mutable std::mutex Lock;
+
+  llvm::BumpPtrAllocator Allocator;
+  size_t NumEntries = 0;
+
+  /// Every set of buckets this shard ever had, including the current one.
+  /// Buckets replaced by a rehash have to stay alive because lock-free
+  /// readers may still be probing them.
+  std::vector<std::unique_ptr<Buckets>> AllBuckets;
+
+  /// Makes the current buckets big enough for one more entry, and returns
+  /// them.
+  Buckets &reserveOneMore() {
+    Buckets *Old = Current.load(std::memory_order_relaxed);
+    size_t NumSlots = Old ? Old->Mask + 1 : 0;
+    // Keep the load factor at or below 3/4, so that probe sequences stay
+    // short and always end at an empty slot.
+    if (Old && (NumEntries + 1) * 4 <= NumSlots * 3)
+      return *Old;
+
+    auto *New = new Buckets(Old ? NumSlots * 2 : 64);
+    AllBuckets.emplace_back(New);
+    if (Old) {
+      for (size_t I = 0; I != NumSlots; ++I)
+        if (Entry *E = Old->Slots[I].load(std::memory_order_relaxed))
+          New->insert(E);
+    }
+    Current.store(New, std::memory_order_release);
+    return *New;
+  }
+};
+
+ConcurrentStringTable::ConcurrentStringTable() : Shards(new Shard[NumShards]) {}
+
+ConcurrentStringTable::~ConcurrentStringTable() = default;
+
+const char *ConcurrentStringTable::intern(StringRef Str) {
+  size_t Hash = llvm::hash_value(Str);
+  Shard &S = Shards[Hash % NumShards];
+
+  // Fast path: look for an existing entry without taking the lock.
+  if (Buckets *B = S.Current.load(std::memory_order_acquire))
+    if (const Entry *E = B->find(Str, Hash))
+      return E->getData();
+
+  std::lock_guard<std::mutex> Guard(S.Lock);
+
+  // Another thread may have added the string, or rehashed the shard, since
+  // we looked.
+  if (Buckets *B = S.Current.load(std::memory_order_relaxed))
+    if (const Entry *E = B->find(Str, Hash))
+      return E->getData();
+
+  Buckets &B = S.reserveOneMore();
+  void *Mem = S.Allocator.Allocate(sizeof(Entry) + Str.size() + 1,
+                                   alignof(Entry));
+  auto *E = new (Mem) Entry{Hash, Str.size()};
+  char *Data = const_cast<char *>(E->getData());
+  memcpy(Data, Str.data(), Str.size());
+  Data[Str.size()] = '\0';
+
+  B.insert(E);
+  ++S.NumEntries;
+  return E->getData();
+}
+
+size_t ConcurrentStringTable::size() const {
+  size_t Size = 0;
+  for (unsigned I = 0; I != NumShards; ++I) {
+    std::lock_guard<std::mutex> Guard(Shards[I].Lock);
+    Size += Shards[I].NumEntries;
+  }
+  return Size;
+}
+
+size_t ConcurrentStringTable::getTotalMemory() const {
+  size_t Size = sizeof(*this) + NumShards * sizeof(Shard);
+  for (unsigned I = 0; I != NumShards; ++I) {
+    const Shard &S = Shards[I];
+    std::lock_guard<std::mutex> Guard(S.Lock);
+    Size += S.Allocator.getTotalMemory();
+    for (auto &B : S.AllBuckets)
+      Size += sizeof(*B) + (B->Mask + 1) * sizeof(std::atomic<Entry *>);
+  }
+  return Size;
+}
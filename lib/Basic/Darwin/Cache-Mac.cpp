@@ -65,6 +65,10 @@ void CacheImpl::removeAll() {
   cache_remove_all(static_cast<cache_t*>(Impl));
 }
 
+void CacheImpl::setCostLimit(size_t Limit) {
+  cache_set_cost_hint(static_cast<cache_t*>(Impl), Limit);
+}
+
 void CacheImpl::destroy() {
   cache_destroy(static_cast<cache_t*>(Impl));
 }
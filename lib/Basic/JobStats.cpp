@@ -0,0 +1,142 @@
+//===--- JobStats.cpp - Statistics of one compiler process ----------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/JobStats.h"
+#include "swift/Basic/JSONSerialization.h"
+#include "swift/Basic/TraceEvents.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cctype>
+
+#if LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
+
+using namespace swift;
+
+namespace {
+  /// The JSON form of a JobStats.
+  struct JobStatsOutput {
+    std::string Kind;
+    std::string Name;
+    uint64_t WallTime;
+    uint64_t PeakRSS;
+    JobStats::NamedValues Phases;
+    JobStats::NamedValues Counters;
+  };
+} // end anonymous namespace
+
+namespace swift {
+namespace json {
+  /// Writes the values as an object with one key per name.
+  template<>
+  struct ObjectTraits<JobStats::NamedValues> {
+    static void mapping(Output &out, JobStats::NamedValues &values) {
+      for (auto &value : values)
+        out.mapRequired(value.first.c_str(), value.second);
+    }
+  };
+
+  template<>
+  struct ObjectTraits<JobStatsOutput> {
+    static void mapping(Output &out, JobStatsOutput &stats) {
+      out.mapRequired("kind", stats.Kind);
+      out.mapRequired("name", stats.Name);
+      out.mapRequired("wall_time", stats.WallTime);
+      out.mapRequired("max_rss", stats.PeakRSS);
+      out.mapRequired("phases", stats.Phases);
+      out.mapRequired("counters", stats.Counters);
+    }
+  };
+} // end namespace json
+} // end namespace swift
+
+static void addValue(JobStats::NamedValues &values, StringRef name,
+                     uint64_t value) {
+  for (auto &entry : values) {
+    if (entry.first == name) {
+      entry.second += value;
+      return;
+    }
+  }
+  values.push_back({name.str(), value});
+}
+
+JobStats::JobStats(StringRef Kind, StringRef Name)
+  : Kind(Kind), Name(Name), StartTime(TraceEventRecorder::now()) {}
+
+void JobStats::addPhase(StringRef Name, uint64_t Microseconds) {
+  addValue(Phases, Name, Microseconds);
+}
+
+void JobStats::addPhases(const TraceEventRecorder &Events,
+                         StringRef Category) {
+  for (const TraceEvent &event : Events.getEvents())
+    if (event.Category == Category)
+      addPhase(event.Name, event.Duration);
+}
+
+void JobStats::addCounter(StringRef Name, uint64_t Value) {
+  addValue(Counters, Name, Value);
+}
+
+uint64_t JobStats::getPeakResidentSetSize(bool Children) {
+#if LLVM_ON_UNIX
+  struct rusage usage;
+  if (getrusage(Children ? RUSAGE_CHILDREN : RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  // Darwin reports bytes, where everyone else reports kilobytes.
+  return usage.ru_maxrss;
+#else
+  return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+void JobStats::write(raw_ostream &os) const {
+  JobStatsOutput stats = {
+    Kind, Name, TraceEventRecorder::now() - StartTime,
+    getPeakResidentSetSize(), Phases, Counters
+  };
+  json::Output out(os);
+  out << stats;
+  os << "\n";
+}
+
+std::error_code JobStats::writeToDirectory(StringRef Dir) const {
+  if (std::error_code EC = llvm::sys::fs::create_directories(Dir))
+    return EC;
+
+  // Keep the file name readable, whatever the job's name contains.
+  std::string FileName = Kind + "-" + Name;
+  for (char &c : FileName)
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '.')
+      c = '_';
+
+  SmallString<128> Model(Dir);
+  llvm::sys::path::append(Model, FileName + "-%%%%%%%%.json");
+
+  int FD;
+  SmallString<128> Path;
+  if (std::error_code EC = llvm::sys::fs::createUniqueFile(Model, FD, Path))
+    return EC;
+
+  llvm::raw_fd_ostream out(FD, /*shouldClose=*/true);
+  write(out);
+  return std::error_code();
+}
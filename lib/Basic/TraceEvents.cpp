@@ -0,0 +1,168 @@
+//===--- TraceEvents.cpp - Timelines in the Chrome trace format -----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/TraceEvents.h"
+#include "swift/Basic/JSONSerialization.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+
+using namespace swift;
+
+namespace swift {
+namespace json {
+  template<>
+  struct ObjectTraits<TraceEvent> {
+    static void mapping(Output &out, TraceEvent &event) {
+      // Every event is a "complete" event, which has both a start time and a
+      // duration.
+      std::string phase = "X";
+      out.mapRequired("name", event.Name);
+      out.mapRequired("cat", event.Category);
+      out.mapRequired("ph", phase);
+      out.mapRequired("ts", event.Start);
+      out.mapRequired("dur", event.Duration);
+      out.mapRequired("pid", event.ProcessID);
+      out.mapRequired("tid", event.ThreadID);
+    }
+  };
+
+  template<>
+  struct ArrayTraits<std::vector<TraceEvent>> {
+    static size_t size(Output &out, std::vector<TraceEvent> &seq) {
+      return seq.size();
+    }
+
+    static TraceEvent &element(Output &out, std::vector<TraceEvent> &seq,
+                               size_t index) {
+      if (index >= seq.size())
+        seq.resize(index+1);
+      return seq[index];
+    }
+  };
+} // end namespace json
+} // end namespace swift
+
+static TraceEventRecorder *ActiveRecorder = nullptr;
+
+TraceEventRecorder *TraceEventRecorder::getActive() {
+  return ActiveRecorder;
+}
+
+void TraceEventRecorder::setActive(TraceEventRecorder *Recorder) {
+  ActiveRecorder = Recorder;
+}
+
+uint64_t TraceEventRecorder::now() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(
+      system_clock::now().time_since_epoch()).count();
+}
+
+void TraceEventRecorder::addSpan(StringRef Name, StringRef Category,
+                                 uint64_t Start, uint64_t End,
+                                 uint64_t ProcessID, uint64_t ThreadID) {
+  TraceEvent event;
+  event.Name = Name;
+  event.Category = Category;
+  event.Start = Start;
+  event.Duration = End > Start ? End - Start : 0;
+  event.ProcessID = ProcessID;
+  event.ThreadID = ThreadID;
+
+  std::lock_guard<std::mutex> guard(Lock);
+  Events.push_back(std::move(event));
+}
+
+bool TraceEventRecorder::addEventsFrom(StringRef Buffer, uint64_t ProcessID,
+                                       uint64_t ThreadID) {
+  namespace yaml = llvm::yaml;
+
+  // JSON is a subset of YAML, so the YAML parser can read the events.
+  llvm::SourceMgr SM;
+  yaml::Stream stream(Buffer, SM);
+
+  auto I = stream.begin();
+  if (I == stream.end() || !I->getRoot())
+    return true;
+
+  auto *eventList = dyn_cast<yaml::SequenceNode>(I->getRoot());
+  if (!eventList)
+    return true;
+
+  std::vector<TraceEvent> newEvents;
+  SmallString<16> keyScratch;
+  SmallString<64> scratch;
+
+  // FIXME: LLVM's YAML support does incremental parsing in such a way that
+  // for-range loops break.
+  for (auto i = eventList->begin(), e = eventList->end(); i != e; ++i) {
+    auto *fields = dyn_cast<yaml::MappingNode>(&*i);
+    if (!fields)
+      return true;
+
+    TraceEvent event;
+    event.ProcessID = ProcessID;
+    event.ThreadID = ThreadID;
+
+    for (auto j = fields->begin(), je = fields->end(); j != je; ++j) {
+      auto *key = dyn_cast<yaml::ScalarNode>(j->getKey());
+      auto *value = dyn_cast<yaml::ScalarNode>(j->getValue());
+      if (!key || !value)
+        return true;
+
+      StringRef keyStr = key->getValue(keyScratch);
+      if (keyStr == "name") {
+        event.Name = value->getValue(scratch);
+      } else if (keyStr == "cat") {
+        event.Category = value->getValue(scratch);
+      } else if (keyStr == "ts") {
+        if (value->getValue(scratch).getAsInteger(10, event.Start))
+          return true;
+      } else if (keyStr == "dur") {
+        if (value->getValue(scratch).getAsInteger(10, event.Duration))
+          return true;
+      }
+    }
+
+    newEvents.push_back(std::move(event));
+  }
+
+  std::lock_guard<std::mutex> guard(Lock);
+  Events.insert(Events.end(), newEvents.begin(), newEvents.end());
+  return false;
+}
+
+void TraceEventRecorder::write(raw_ostream &os) const {
+  // json::Output needs mutable values.
+  std::vector<TraceEvent> events;
+  {
+    std::lock_guard<std::mutex> guard(Lock);
+    events = Events;
+  }
+  json::Output out(os, /*PrettyPrint=*/false);
+  out << events;
+  os << "\n";
+}
+
+std::error_code TraceEventRecorder::writeToFile(StringRef Path) const {
+  std::error_code error;
+  llvm::raw_fd_ostream out(Path, error, llvm::sys::fs::F_None);
+  if (error)
+    return error;
+
+  write(out);
+  return std::error_code();
+}
@@ -6061,6 +6061,71 @@ ClangImporter::Implementation::loadAllMembers(Decl *D, uint64_t unused,
 
 }
 
+bool
+ClangImporter::Implementation::loadNamedMembers(
+    const Decl *D, DeclName N, uint64_t unused,
+    SmallVectorImpl<ValueDecl *> &Members) {
+  // Only the bridging header has a Swift lookup table.
+  if (!UseSwiftLookupTables)
+    return false;
+
+  assert(D->hasClangNode());
+  auto clangDecl = cast<clang::ObjCContainerDecl>(D->getClangDecl());
+  if (clangDecl->isFromASTFile())
+    return false;
+
+  // Initializers and subscripts are synthesized from members with other
+  // names, and with implicit properties a method may become a property.
+  if (N.getBaseName() == SwiftContext.Id_init ||
+      N.getBaseName() == SwiftContext.Id_subscript ||
+      InferImplicitProperties)
+    return false;
+
+  const DeclContext *DC;
+  if (auto nominal = dyn_cast<NominalTypeDecl>(D))
+    DC = nominal;
+  else
+    DC = cast<ExtensionDecl>(D);
+
+  // Instance methods of root classes are also imported as class methods.
+  auto swiftClass =
+    DC->getDeclaredTypeInContext()->getClassOrBoundGenericClass();
+  if (!swiftClass || !swiftClass->getSuperclass())
+    return false;
+
+  if (auto clangClass = dyn_cast<clang::ObjCInterfaceDecl>(clangDecl))
+    clangDecl = clangClass->getDefinition();
+
+  ImportingEntityRAII Importing(*this);
+
+  SmallVector<clang::NamedDecl *, 4> scratch;
+  for (auto named : BridgingHeaderLookupTable.lookup(N.getBaseName(),
+                                                     /*context=*/nullptr,
+                                                     scratch)) {
+    // Members of protocols may be mirrored into the classes conforming to
+    // them.
+    if (isa<clang::ObjCProtocolDecl>(named->getDeclContext()))
+      return false;
+    if (named->getDeclContext() != clangDecl)
+      continue;
+
+    auto member = dyn_cast_or_null<ValueDecl>(importDecl(named));
+    if (!member)
+      continue;
+
+    // Accessors are only found through their properties, and members may be
+    // imported into a different context than the one being loaded.
+    if (auto func = dyn_cast<FuncDecl>(member))
+      if (func->isAccessor())
+        continue;
+    if (member->getDeclContext() != DC)
+      return false;
+
+    Members.push_back(member);
+  }
+  return true;
+}
+
 void ClangImporter::Implementation::loadAllConformances(
        const Decl *D, uint64_t contextData,
        SmallVectorImpl<ProtocolConformance *> &Conformances) {
@@ -1152,6 +1152,22 @@ Type ClangImporter::Implementation::importType(clang::QualType type,
   if (type.isNull())
     return Type();
 
+  // If we've already imported this type the same way, reuse the result.
+  unsigned generation = SwiftContext.getCurrentGeneration();
+  if (ImportedTypesGeneration != generation) {
+    ImportedTypes.clear();
+    ImportedTypesGeneration = generation;
+  }
+
+  auto key = std::make_pair(type,
+                            static_cast<unsigned>(importKind) << 4 |
+                            static_cast<unsigned>(optionality) << 2 |
+                            static_cast<unsigned>(allowNSUIntegerAsInt) << 1 |
+                            static_cast<unsigned>(canFullyBridgeTypes));
+  auto known = ImportedTypes.find(key);
+  if (known != ImportedTypes.end())
+    return known->second;
+
   // The "built-in" Objective-C types id, Class, and SEL can actually be (and
   // are) defined within the library. Clang tracks the redefinition types
   // separately, so it can provide fallbacks in certain cases. For Swift, we
@@ -1191,11 +1207,19 @@ Type ClangImporter::Implementation::importType(clang::QualType type,
   auto importResult = converter.Visit(type);
 
   // Now fix up the type based on we're concretely using it.
-  return adjustTypeForConcreteImport(*this, type, importResult.AbstractType,
-                                     importKind, importResult.Hint,
-                                     allowNSUIntegerAsInt,
-                                     canFullyBridgeTypes,
-                                     optionality);
+  Type result = adjustTypeForConcreteImport(*this, type,
+                                            importResult.AbstractType,
+                                            importKind, importResult.Hint,
+                                            allowNSUIntegerAsInt,
+                                            canFullyBridgeTypes,
+                                            optionality);
+
+  // Don't remember failures, which may only be due to a declaration that's
+  // still being imported, or results computed before a module was loaded.
+  if (result && ImportedTypesGeneration == SwiftContext.getCurrentGeneration())
+    ImportedTypes[key] = result;
+
+  return result;
 }
 
 bool ClangImporter::Implementation::shouldImportGlobalAsLet(
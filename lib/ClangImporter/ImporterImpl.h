@@ -299,6 +299,16 @@ public:
   /// \brief Mapping of already-imported declarations.
   llvm::DenseMap<const clang::Decl *, Decl *> ImportedDecls;
 
+  /// \brief Mapping of already-imported types.
+  ///
+  /// The key is the Clang type along with the way it was imported, i.e., the
+  /// arguments to importType(). The table is cleared whenever the ASTContext
+  /// generation changes, since loading a module can change how a type imports.
+  llvm::DenseMap<std::pair<clang::QualType, unsigned>, Type> ImportedTypes;
+
+  /// \brief The ASTContext generation for which ImportedTypes is valid.
+  unsigned ImportedTypesGeneration = 0;
+
   /// \brief The set of "special" typedef-name declarations, which are
   /// mapped to specific Swift types.
   ///
@@ -1235,6 +1245,10 @@ public:
   loadAllMembers(Decl *D, uint64_t unused,
                  bool *hasMissingRequiredMembers) override;
 
+  virtual bool
+  loadNamedMembers(const Decl *D, DeclName N, uint64_t unused,
+                   SmallVectorImpl<ValueDecl *> &Members) override;
+
   void
   loadAllConformances(
     const Decl *D, uint64_t contextData,
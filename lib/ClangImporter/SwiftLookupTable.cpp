@@ -91,6 +91,44 @@ void SwiftLookupTable::addEntry(DeclName name, clang::NamedDecl *decl,
   fullEntries.push_back(newEntry);
 }
 
+ArrayRef<clang::NamedDecl *>
+SwiftLookupTable::lookup(Identifier baseName,
+                         clang::DeclContext *context,
+                         SmallVectorImpl<clang::NamedDecl *> &scratch) {
+  scratch.clear();
+
+  // Find all of the full names with this base name.
+  auto knownBase = BaseNameTable.find(baseName);
+  if (knownBase == BaseNameTable.end())
+    return scratch;
+
+  SmallVector<clang::NamedDecl *, 4> fullScratch;
+  for (auto fullName : knownBase->second) {
+    for (auto decl : lookup(fullName, context, fullScratch))
+      scratch.push_back(decl);
+  }
+  return scratch;
+}
+
+ArrayRef<clang::NamedDecl *>
+SwiftLookupTable::lookup(DeclName name,
+                         clang::DeclContext *context,
+                         SmallVectorImpl<clang::NamedDecl *> &scratch) {
+  scratch.clear();
+
+  auto knownFull = FullNameTable.find(name);
+  if (knownFull == FullNameTable.end())
+    return scratch;
+
+  if (context)
+    context = context->getPrimaryContext();
+  for (auto &fullEntry : knownFull->second) {
+    if (matchesContext(fullEntry.Context, context))
+      scratch.append(fullEntry.Decls.begin(), fullEntry.Decls.end());
+  }
+  return scratch;
+}
+
 static void printName(clang::NamedDecl *named, llvm::raw_ostream &out) {
   // If there is a name, print it.
   if (!named->getDeclName().isEmpty()) {
@@ -39,6 +39,16 @@ namespace swift {
 /// entities. This lookup table provides efficient access to the C
 /// entities based on their Swift names, and is used by the Clang
 /// importer to satisfy the Swift compiler's queries.
+///
+/// FIXME: The table is built in memory, by walking the Clang declarations,
+/// in every process that needs it. Tables are currently only built for the
+/// bridging header, which is parsed again in each process anyway, so there
+/// is nothing yet to gain from storing them. Once tables are built for Clang
+/// modules, they should be written into the module files in the module cache
+/// and read back from there. That needs Clang to support storing extra data
+/// in its module files, which the Clang this is built against doesn't do.
+/// Entries would then refer to declarations by their serialized Clang decl
+/// IDs rather than pointers, so that they can be resolved lazily.
 class SwiftLookupTable {
   /// An entry in the table of C entities indexed by full Swift name.
   struct FullTableEntry {
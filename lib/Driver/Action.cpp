@@ -35,6 +35,7 @@ const char *Action::getClassName(ActionClass AC) {
     case REPLJob: return "repl";
     case LinkJob: return "link";
     case GenerateDSYMJob: return "generate-dSYM";
+    case ClangModulePrebuildJob: return "prebuild-clang-modules";
   }
 
   llvm_unreachable("invalid class");
@@ -59,3 +60,5 @@ void REPLJobAction::anchor() {}
 void LinkJobAction::anchor() {}
 
 void GenerateDSYMJobAction::anchor() {}
+
+void ClangModulePrebuildJobAction::anchor() {}
@@ -15,8 +15,10 @@
 #include "swift/AST/DiagnosticEngine.h"
 #include "swift/AST/DiagnosticsDriver.h"
 #include "swift/Basic/Fallthrough.h"
+#include "swift/Basic/JobStats.h"
 #include "swift/Basic/Program.h"
 #include "swift/Basic/TaskQueue.h"
+#include "swift/Basic/TraceEvents.h"
 #include "swift/Basic/Version.h"
 #include "swift/Basic/type_traits.h"
 #include "swift/Driver/Action.h"
@@ -24,13 +26,17 @@
 #include "swift/Driver/Driver.h"
 #include "swift/Driver/Job.h"
 #include "swift/Driver/ParseableOutput.h"
+#include "swift/Driver/ToolChain.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Option/Arg.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/YAMLParser.h"
@@ -83,17 +89,75 @@ namespace {
     ///
     /// Only intended for source files.
     llvm::SmallDenseMap<const Job *, bool, 16> UnfinishedCommands;
+
+    /// A map from compile jobs which finished successfully to how long they
+    /// took to run.
+    ///
+    /// The time taken by a batch job is split evenly among its constituents.
+    llvm::SmallDenseMap<const Job *, llvm::sys::TimeValue, 16> CompileTimes;
   };
 }
 
 Compilation::~Compilation() = default;
 
+void Compilation::enableBatchMode(const OutputInfo &OI) {
+  BatchModeOutputInfo.reset(new OutputInfo(OI));
+}
+
+uint64_t Compilation::computeContentHash(StringRef path) {
+  auto buffer = llvm::MemoryBuffer::getFile(path, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer)
+    return 0;
+
+  llvm::MD5 hash;
+  hash.update(buffer.get()->getBuffer());
+  llvm::MD5::MD5Result hashBuf;
+  hash.final(hashBuf);
+
+  // Half of the digest is plenty to detect accidental changes.
+  uint64_t result = 0;
+  for (unsigned i = 0; i != sizeof(result); ++i)
+    result |= uint64_t(hashBuf[i]) << (8 * i);
+  return result;
+}
+
 Job *Compilation::addJob(std::unique_ptr<Job> J) {
   Job *result = J.get();
   Jobs.emplace_back(std::move(J));
   return result;
 }
 
+/// Returns true if \p Cmd can be performed as part of a batch job.
+///
+/// Only compiles of a single primary file can be batched, and only if they
+/// have no outputs which the frontend can't produce per primary file.
+static bool isBatchableCompile(const Job *Cmd) {
+  auto *Compile = dyn_cast<CompileJobAction>(&Cmd->getSource());
+  if (!Compile || Compile->size() != 1 || !Cmd->getInputs().empty())
+    return false;
+
+  const CommandOutput &Output = Cmd->getOutput();
+  if (Output.getPrimaryOutputFilenames().size() != 1)
+    return false;
+  for (auto Type : {types::TY_SerializedDiagnostics, types::TY_Remapping,
+                    types::TY_ObjCHeader, types::TY_TraceEvents}) {
+    if (!Output.getAdditionalOutputForType(Type).empty())
+      return false;
+  }
+  return true;
+}
+
+/// Returns how long \p Cmd took to run, either in this build or, if it didn't
+/// finish in this build, in the previous one.
+static llvm::sys::TimeValue getCompileTime(const Job *Cmd,
+                                           const PerformJobsState &State) {
+  auto iter = State.CompileTimes.find(Cmd);
+  if (iter != State.CompileTimes.end())
+    return iter->second;
+  return Cmd->getPreviousCompileTime();
+}
+
 static const Job *findUnfinishedJob(ArrayRef<const Job *> JL,
                                     const CommandSet &FinishedCommands) {
   for (const Job *Cmd : JL) {
@@ -117,6 +181,7 @@ static void populateInputInfoMap(InputInfoMap &inputs,
       info.status = entry.second ?
           CompileJobAction::InputInfo::NeedsCascadingBuild :
           CompileJobAction::InputInfo::NeedsNonCascadingBuild;
+      info.previousCompileTime = getCompileTime(entry.first, endState);
       inputs[&inputFile->getInputArg()] = info;
     }
   }
@@ -132,6 +197,7 @@ static void populateInputInfoMap(InputInfoMap &inputs,
       CompileJobAction::InputInfo info;
       info.previousModTime = entry->getInputModTime();
       info.status = CompileJobAction::InputInfo::UpToDate;
+      info.previousCompileTime = getCompileTime(entry, endState);
       inputs[&inputFile->getInputArg()] = info;
     }
   }
@@ -149,8 +215,11 @@ static void populateInputInfoMap(InputInfoMap &inputs,
   });
 }
 
+using InputContentHashMap = llvm::DenseMap<const llvm::opt::Arg *, uint64_t>;
+
 static void checkForOutOfDateInputs(DiagnosticEngine &diags,
-                                    const InputInfoMap &inputs) {
+                                    const InputInfoMap &inputs,
+                                    const InputContentHashMap &contentHashes) {
   for (const auto &inputPair : inputs) {
     auto recordedModTime = inputPair.second.previousModTime;
     if (recordedModTime == llvm::sys::TimeValue::MaxTime())
@@ -166,6 +235,12 @@ static void checkForOutOfDateInputs(DiagnosticEngine &diags,
     }
 
     if (recordedModTime != inputStatus.getLastModificationTime()) {
+      // If the input was only touched, what was built is still up to date.
+      auto hashIter = contentHashes.find(inputPair.first);
+      if (hashIter != contentHashes.end() && hashIter->second != 0 &&
+          hashIter->second == Compilation::computeContentHash(input))
+        continue;
+
       diags.diagnose(SourceLoc(), diag::error_input_changed_during_build,
                      llvm::sys::path::filename(input));
     }
@@ -174,7 +249,8 @@ static void checkForOutOfDateInputs(DiagnosticEngine &diags,
 
 static void writeCompilationRecord(StringRef path, StringRef argsHash,
                                    llvm::sys::TimeValue buildTime,
-                                   const InputInfoMap &inputs) {
+                                   const InputInfoMap &inputs,
+                                   const InputContentHashMap &contentHashes) {
   std::error_code error;
   llvm::raw_fd_ostream out(path, error, llvm::sys::fs::F_None);
   if (out.has_error()) {
@@ -213,6 +289,51 @@ static void writeCompilationRecord(StringRef path, StringRef argsHash,
     writeTimeValue(out, entry.second.previousModTime);
     out << "\n";
   }
+
+  // Only record the inputs whose compile time is known.
+  bool wroteCompileTimesKey = false;
+  for (auto &entry : inputs) {
+    if (entry.second.previousCompileTime == llvm::sys::TimeValue::ZeroTime())
+      continue;
+    if (!wroteCompileTimesKey) {
+      out << "compile_times:\n";
+      wroteCompileTimesKey = true;
+    }
+    out << "  \"" << llvm::yaml::escape(entry.first->getValue()) << "\": ";
+    writeTimeValue(out, entry.second.previousCompileTime);
+    out << "\n";
+  }
+
+  if (!contentHashes.empty()) {
+    out << "content_hashes:\n";
+    for (auto &entry : inputs) {
+      uint64_t hash = contentHashes.lookup(entry.first);
+      if (hash == 0)
+        continue;
+      out << "  \"" << llvm::yaml::escape(entry.first->getValue()) << "\": \""
+          << llvm::utohexstr(hash) << "\"\n";
+    }
+  }
+}
+
+/// Returns the path of the dependency graph cache that goes with the
+/// compilation record at \p recordPath.
+static std::string getDependencyGraphCachePath(StringRef recordPath) {
+  SmallString<128> cachePath{recordPath};
+  llvm::sys::path::replace_extension(cachePath, "depgraph");
+  return cachePath.str();
+}
+
+/// Returns the name under which \p Cmd appears in a trace, such as
+/// "compile main.swift".
+static std::string getTraceEventName(const Job *Cmd) {
+  std::string Name = Cmd->getSource().getClassName();
+  StringRef BaseInput = Cmd->getOutput().getBaseInput(0);
+  if (!BaseInput.empty()) {
+    Name += " ";
+    Name += llvm::sys::path::filename(BaseInput);
+  }
+  return Name;
 }
 
 int Compilation::performJobsImpl() {
@@ -225,6 +346,27 @@ int Compilation::performJobsImpl() {
 
   PerformJobsState State;
 
+  // In a trace, the driver's own work is shown as thread 0 of process 0, and
+  // each job runs on the thread numbered after the slot it was given among
+  // the parallel commands. Jobs waiting to start are shown in process 1, one
+  // thread per job.
+  TraceEventRecorder TraceEvents;
+  bool IsTracing = !TraceEventsPath.empty();
+  Optional<JobStats> Stats;
+  if (!StatsOutputDir.empty())
+    Stats.emplace("driver", StatsName);
+  llvm::SmallDenseMap<const Job *, uint64_t, 16> TaskQueuedTimes;
+  llvm::SmallDenseMap<const Job *, std::pair<unsigned, uint64_t>, 16>
+      TaskSlotsAndStartTimes;
+  SmallVector<bool, 8> SlotsInUse;
+  unsigned NumQueuedTasks = 0;
+
+  // The driver's own phases are also recorded for -stats-output-dir.
+  auto traceDriverPhase = [&](StringRef Name, uint64_t Start) {
+    if (IsTracing || Stats)
+      TraceEvents.addSpan(Name, "driver", Start, TraceEventRecorder::now());
+  };
+
   using DependencyGraph = DependencyGraph<const Job *>;
   DependencyGraph DepGraph;
   SmallPtrSet<const Job *, 16> DeferredCommands;
@@ -249,6 +391,72 @@ int Compilation::performJobsImpl() {
     });
   };
 
+  // In batch mode, compile jobs which are ready to run are collected here
+  // until formBatches() combines them into batch jobs.
+  SmallVector<const Job *, 16> PendingBatchCommands;
+
+  // The batch jobs which have been created, and the jobs each of them
+  // performs.
+  SmallVector<std::unique_ptr<const Job>, 4> BatchJobs;
+  llvm::SmallDenseMap<const Job *, SmallVector<const Job *, 8>, 4>
+      BatchConstituents;
+
+  // Returns the jobs performed by a task: the constituents of a batch job, or
+  // just the job itself.
+  auto getPerformedJobs = [&] (const Job * const &Cmd) -> ArrayRef<const Job *> {
+    auto BatchIter = BatchConstituents.find(Cmd);
+    if (BatchIter != BatchConstituents.end())
+      return BatchIter->second;
+    return Cmd;
+  };
+
+  // Orders jobs so that the ones which took longest in the previous build are
+  // started first, keeping input order among jobs that took equally long.
+  // This keeps a single slow job from starting last and holding up the whole
+  // build. With only one command running at a time the order doesn't matter.
+  auto sortLongestFirst = [&] (MutableArrayRef<const Job *> Cmds) {
+    if (NumberOfParallelCommands <= 1)
+      return;
+    std::stable_sort(Cmds.begin(), Cmds.end(),
+                     [](const Job *lhs, const Job *rhs) {
+      return lhs->getPreviousCompileTime() > rhs->getPreviousCompileTime();
+    });
+  };
+
+  auto addTask = [&] (const Job *Cmd) {
+    if (IsTracing)
+      TaskQueuedTimes[Cmd] = TraceEventRecorder::now();
+    TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
+                (void *)Cmd);
+  };
+
+  // Splits the pending compile jobs into at most one batch per parallel
+  // command, so that batch mode doesn't reduce the available parallelism.
+  auto formBatches = [&] {
+    size_t NumPending = PendingBatchCommands.size();
+    if (NumPending == 0)
+      return;
+    size_t NumBatches = std::min<size_t>(
+        NumPending, std::max(NumberOfParallelCommands, 1U));
+    for (size_t i = 0; i != NumBatches; ++i) {
+      auto Batch = llvm::makeArrayRef(PendingBatchCommands).slice(
+          i * NumPending / NumBatches,
+          (i + 1) * NumPending / NumBatches - i * NumPending / NumBatches);
+      if (Batch.size() == 1) {
+        addTask(Batch.front());
+        continue;
+      }
+
+      std::unique_ptr<const Job> BatchJob =
+          DefaultToolChain.constructBatchJob(Batch, getArgs(),
+                                             *BatchModeOutputInfo);
+      BatchConstituents[BatchJob.get()].append(Batch.begin(), Batch.end());
+      addTask(BatchJob.get());
+      BatchJobs.push_back(std::move(BatchJob));
+    }
+    PendingBatchCommands.clear();
+  };
+
   // Set up scheduleCommandIfNecessaryAndPossible.
   // This will only schedule the given command if it has not been scheduled
   // and if all of its inputs are in FinishedCommands.
@@ -263,8 +471,11 @@ int Compilation::performJobsImpl() {
     }
 
     State.ScheduledCommands.insert(Cmd);
-    TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
-                (void *)Cmd);
+    if (getBatchModeEnabled() && isBatchableCompile(Cmd)) {
+      PendingBatchCommands.push_back(Cmd);
+      return;
+    }
+    addTask(Cmd);
   };
 
   // When a task finishes, we need to reevaluate the other commands that
@@ -281,8 +492,20 @@ int Compilation::performJobsImpl() {
     }
   };
 
+  uint64_t LoadStart = TraceEventRecorder::now();
+
+  // Dependency files that haven't changed since the last build can be loaded
+  // from the cache instead of being parsed again.
+  if (getIncrementalBuildEnabled() && !CompilationRecordPath.empty())
+    DepGraph.loadCache(getDependencyGraphCachePath(CompilationRecordPath));
+
+  SmallVector<const Job *, 16> JobsInScheduleOrder;
+  for (const Job *Cmd : getJobs())
+    JobsInScheduleOrder.push_back(Cmd);
+  sortLongestFirst(JobsInScheduleOrder);
+
   // Schedule all jobs we can.
-  for (const Job *Cmd : getJobs()) {
+  for (const Job *Cmd : JobsInScheduleOrder) {
     if (!getIncrementalBuildEnabled()) {
       scheduleCommandIfNecessaryAndPossible(Cmd);
       continue;
@@ -303,8 +526,8 @@ int Compilation::performJobsImpl() {
         switch (DepGraph.loadFromPath(Cmd, DependenciesFile)) {
         case DependencyGraphImpl::LoadResult::HadError:
           disableIncrementalBuild();
-          for (const Job *Cmd : DeferredCommands)
-            scheduleCommandIfNecessaryAndPossible(Cmd);
+          for (const Job *DeferredCmd : DeferredCommands)
+            scheduleCommandIfNecessaryAndPossible(DeferredCmd);
           DeferredCommands.clear();
           break;
         case DependencyGraphImpl::LoadResult::UpToDate:
@@ -335,7 +558,10 @@ int Compilation::performJobsImpl() {
     }
   }
 
+  traceDriverPhase("Load dependencies and schedule jobs", LoadStart);
+
   if (getIncrementalBuildEnabled()) {
+    uint64_t MarkStart = TraceEventRecorder::now();
     SmallVector<const Job *, 16> AdditionalOutOfDateCommands;
 
     // We scheduled all of the files that have actually changed. Now add the
@@ -368,28 +594,98 @@ int Compilation::performJobsImpl() {
       noteBuilding(externalCmd, "because of external dependencies");
     }
 
+    sortLongestFirst(AdditionalOutOfDateCommands);
     for (auto *AdditionalCmd : AdditionalOutOfDateCommands) {
       if (!DeferredCommands.count(AdditionalCmd))
         continue;
       scheduleCommandIfNecessaryAndPossible(AdditionalCmd);
       DeferredCommands.erase(AdditionalCmd);
     }
+
+    traceDriverPhase("Find dependent jobs", MarkStart);
   }
 
   int Result = EXIT_SUCCESS;
 
+  // The time at which each task was started.
+  llvm::SmallDenseMap<const Job *, llvm::sys::TimeValue, 16> TaskStartTimes;
+
   // Set up a callback which will be called immediately after a task has
   // started. This callback may be used to provide output indicating that the
   // task began.
-  auto taskBegan = [this] (ProcessId Pid, void *Context) {
+  auto taskBegan = [&] (ProcessId Pid, void *Context) {
     // TODO: properly handle task began.
     const Job *BeganCmd = (const Job *)Context;
+    TaskStartTimes[BeganCmd] = llvm::sys::TimeValue::now();
+
+    if (IsTracing) {
+      uint64_t Now = TraceEventRecorder::now();
+      auto QueuedIter = TaskQueuedTimes.find(BeganCmd);
+      if (QueuedIter != TaskQueuedTimes.end()) {
+        TraceEvents.addSpan("wait for " + getTraceEventName(BeganCmd), "job",
+                            QueuedIter->second, Now, 1, ++NumQueuedTasks);
+      }
+
+      auto FreeSlot = std::find(SlotsInUse.begin(), SlotsInUse.end(), false);
+      unsigned Slot = FreeSlot - SlotsInUse.begin();
+      if (FreeSlot == SlotsInUse.end())
+        SlotsInUse.push_back(true);
+      else
+        *FreeSlot = true;
+      TaskSlotsAndStartTimes[BeganCmd] = { Slot, Now };
+    }
 
     // For verbose output, print out each command as it begins execution.
-    if (Level == OutputLevel::Verbose)
+    if (Level == OutputLevel::Verbose) {
       BeganCmd->printCommandLine(llvm::errs());
-    else if (Level == OutputLevel::Parseable)
-      parseable_output::emitBeganMessage(llvm::errs(), *BeganCmd, Pid);
+    } else if (Level == OutputLevel::Parseable) {
+      for (const Job *Cmd : getPerformedJobs(BeganCmd))
+        parseable_output::emitBeganMessage(llvm::errs(), *Cmd, Pid);
+    }
+  };
+
+  // Handles the successful completion of a single job, which may have been
+  // performed as part of a batch.
+  auto handleFinishedCommand = [&] (const Job *Cmd) {
+    // When a task finishes, we need to reevaluate the other commands that
+    // might have been blocked.
+    markFinished(Cmd);
+
+    // In order to handle both old dependencies that have disappeared and new
+    // dependencies that have arisen, we need to reload the dependency file.
+    if (getIncrementalBuildEnabled()) {
+      const CommandOutput &Output = Cmd->getOutput();
+      StringRef DependenciesFile =
+        Output.getAdditionalOutputForType(types::TY_SwiftDeps);
+      if (!DependenciesFile.empty()) {
+        SmallVector<const Job *, 16> Dependents;
+        bool wasCascading = DepGraph.isMarked(Cmd);
+
+        switch (DepGraph.loadFromPath(Cmd, DependenciesFile)) {
+        case DependencyGraphImpl::LoadResult::HadError:
+          disableIncrementalBuild();
+          for (const Job *Cmd : DeferredCommands)
+            scheduleCommandIfNecessaryAndPossible(Cmd);
+          DeferredCommands.clear();
+          Dependents.clear();
+          break;
+        case DependencyGraphImpl::LoadResult::UpToDate:
+          if (!wasCascading)
+            break;
+          SWIFT_FALLTHROUGH;
+        case DependencyGraphImpl::LoadResult::AffectsDownstream:
+          DepGraph.markTransitive(Dependents, Cmd);
+          break;
+        }
+
+        sortLongestFirst(Dependents);
+        for (const Job *Dependent : Dependents) {
+          DeferredCommands.erase(Dependent);
+          noteBuilding(Dependent, "because of dependencies discovered later");
+          scheduleCommandIfNecessaryAndPossible(Dependent);
+        }
+      }
+    }
   };
 
   // Set up a callback which will be called immediately after a task has
@@ -397,14 +693,45 @@ int Compilation::performJobsImpl() {
   // continue (if execution should stop, this callback should return true), and
   // it should also schedule any additional commands which we now know need
   // to run.
+  // Records the run of a finished task in the trace, together with the
+  // phases its frontend job recorded, and frees up its slot.
+  auto traceFinishedTask = [&] (const Job *Cmd) {
+    if (!IsTracing)
+      return;
+    auto SlotIter = TaskSlotsAndStartTimes.find(Cmd);
+    if (SlotIter == TaskSlotsAndStartTimes.end())
+      return;
+
+    unsigned Slot = SlotIter->second.first;
+    SlotsInUse[Slot] = false;
+    TraceEvents.addSpan(getTraceEventName(Cmd), "job", SlotIter->second.second,
+                        TraceEventRecorder::now(), 0, Slot + 1);
+
+    StringRef FrontendTrace =
+        Cmd->getOutput().getAdditionalOutputForType(types::TY_TraceEvents);
+    if (FrontendTrace.empty())
+      return;
+    // The frontend may have failed before it wrote its trace.
+    auto Buffer = llvm::MemoryBuffer::getFile(FrontendTrace);
+    if (Buffer)
+      (void)TraceEvents.addEventsFrom(Buffer.get()->getBuffer(), 0, Slot + 1);
+  };
+
   auto taskFinished = [&] (ProcessId Pid, int ReturnCode, StringRef Output,
                            void *Context) -> TaskFinishedResponse {
     const Job *FinishedCmd = (const Job *)Context;
+    ArrayRef<const Job *> FinishedJobs = getPerformedJobs(FinishedCmd);
+    traceFinishedTask(FinishedCmd);
+    uint64_t HandleStart = TraceEventRecorder::now();
 
     if (Level == OutputLevel::Parseable) {
-      // Parseable output was requested.
-      parseable_output::emitFinishedMessage(llvm::errs(), *FinishedCmd, Pid,
-                                            ReturnCode, Output);
+      // Parseable output was requested. The output of a batch job is only
+      // reported once, with its first constituent.
+      for (const Job *Cmd : FinishedJobs) {
+        StringRef CmdOutput = (Cmd == FinishedJobs.front()) ? Output : "";
+        parseable_output::emitFinishedMessage(llvm::errs(), *Cmd, Pid,
+                                              ReturnCode, CmdOutput);
+      }
     } else {
       // Otherwise, send the buffered output to stderr, though only if we
       // support getting buffered output.
@@ -433,44 +760,35 @@ int Compilation::performJobsImpl() {
           TaskFinishedResponse::StopExecution;
     }
 
-    // When a task finishes, we need to reevaluate the other commands that
-    // might have been blocked.
-    markFinished(FinishedCmd);
+    // Record how long the compile jobs took, so that the next build can start
+    // the slowest ones first.
+    auto StartIter = TaskStartTimes.find(FinishedCmd);
+    if (StartIter != TaskStartTimes.end()) {
+      llvm::sys::TimeValue Elapsed =
+          llvm::sys::TimeValue::now() - StartIter->second;
+      if (FinishedJobs.size() > 1) {
+        Elapsed = llvm::sys::TimeValue(
+            (Elapsed.seconds() + Elapsed.nanoseconds() / 1e9) /
+            FinishedJobs.size());
+      }
+      for (const Job *Cmd : FinishedJobs)
+        if (isa<CompileJobAction>(Cmd->getSource()))
+          State.CompileTimes[Cmd] = Elapsed;
+    }
 
-    // In order to handle both old dependencies that have disappeared and new
-    // dependencies that have arisen, we need to reload the dependency file.
-    if (getIncrementalBuildEnabled()) {
-      const CommandOutput &Output = FinishedCmd->getOutput();
-      StringRef DependenciesFile =
-        Output.getAdditionalOutputForType(types::TY_SwiftDeps);
-      if (!DependenciesFile.empty()) {
-        SmallVector<const Job *, 16> Dependents;
-        bool wasCascading = DepGraph.isMarked(FinishedCmd);
+    for (const Job *Cmd : FinishedJobs)
+      handleFinishedCommand(Cmd);
 
-        switch (DepGraph.loadFromPath(FinishedCmd, DependenciesFile)) {
-        case DependencyGraphImpl::LoadResult::HadError:
-          disableIncrementalBuild();
-          for (const Job *Cmd : DeferredCommands)
-            scheduleCommandIfNecessaryAndPossible(Cmd);
-          DeferredCommands.clear();
-          Dependents.clear();
-          break;
-        case DependencyGraphImpl::LoadResult::UpToDate:
-          if (!wasCascading)
-            break;
-          SWIFT_FALLTHROUGH;
-        case DependencyGraphImpl::LoadResult::AffectsDownstream:
-          DepGraph.markTransitive(Dependents, FinishedCmd);
-          break;
-        }
+    // Batch up any compile jobs which were unblocked by this task.
+    formBatches();
 
-        for (const Job *Cmd : Dependents) {
-          DeferredCommands.erase(Cmd);
-          noteBuilding(Cmd, "because of dependencies discovered later");
-          scheduleCommandIfNecessaryAndPossible(Cmd);
-        }
-      }
-    }
+    // Each job's output gets its own span in a trace, but all of it is one
+    // phase in the statistics.
+    if (IsTracing)
+      traceDriverPhase("handle output of " + getTraceEventName(FinishedCmd),
+                       HandleStart);
+    else if (Stats)
+      traceDriverPhase("Handle job output", HandleStart);
 
     return TaskFinishedResponse::ContinueExecution;
   };
@@ -478,11 +796,16 @@ int Compilation::performJobsImpl() {
   auto taskSignalled = [&] (ProcessId Pid, StringRef ErrorMsg, StringRef Output,
                             void *Context) -> TaskFinishedResponse {
     const Job *SignalledCmd = (const Job *)Context;
+    traceFinishedTask(SignalledCmd);
 
     if (Level == OutputLevel::Parseable) {
       // Parseable output was requested.
-      parseable_output::emitSignalledMessage(llvm::errs(), *SignalledCmd, Pid,
-                                             ErrorMsg, Output);
+      ArrayRef<const Job *> SignalledJobs = getPerformedJobs(SignalledCmd);
+      for (const Job *Cmd : SignalledJobs) {
+        StringRef CmdOutput = (Cmd == SignalledJobs.front()) ? Output : "";
+        parseable_output::emitSignalledMessage(llvm::errs(), *Cmd, Pid,
+                                               ErrorMsg, CmdOutput);
+      }
     } else {
       // Otherwise, send the buffered output to stderr, though only if we
       // support getting buffered output.
@@ -504,6 +827,9 @@ int Compilation::performJobsImpl() {
   };
 
   do {
+    // Batch up the compile jobs which have been scheduled so far.
+    formBatches();
+
     // Ask the TaskQueue to execute.
     TQ->execute(taskBegan, taskFinished, taskSignalled);
 
@@ -550,9 +876,30 @@ int Compilation::performJobsImpl() {
   if (!CompilationRecordPath.empty() && !SkipTaskExecution) {
     InputInfoMap InputInfo;
     populateInputInfoMap(InputInfo, State);
-    checkForOutOfDateInputs(Diags, InputInfo);
+    checkForOutOfDateInputs(Diags, InputInfo, InputContentHashes);
     writeCompilationRecord(CompilationRecordPath, ArgsHash, BuildStartTime,
-                           InputInfo);
+                           InputInfo, InputContentHashes);
+    if (getIncrementalBuildEnabled())
+      DepGraph.writeCache(getDependencyGraphCachePath(CompilationRecordPath));
+  }
+
+  if (IsTracing) {
+    if (std::error_code EC = TraceEvents.writeToFile(TraceEventsPath)) {
+      Diags.diagnose(SourceLoc(), diag::warn_cannot_write_trace_events,
+                     TraceEventsPath, EC.message());
+    }
+  }
+
+  if (Stats) {
+    Stats->addPhases(TraceEvents, "driver");
+    Stats->addCounter("driver.jobs", Jobs.size());
+    Stats->addCounter("driver.jobs_run", State.FinishedCommands.size());
+    Stats->addCounter("driver.children_max_rss",
+                      JobStats::getPeakResidentSetSize(/*Children=*/true));
+    if (std::error_code EC = Stats->writeToDirectory(StatsOutputDir)) {
+      Diags.diagnose(SourceLoc(), diag::warn_cannot_write_stats,
+                     StatsOutputDir, EC.message());
+    }
   }
 
   if (Result == 0)
@@ -560,6 +907,37 @@ int Compilation::performJobsImpl() {
   return Result;
 }
 
+void Compilation::performPrebuildJobs() {
+  if (PrebuildJobs.empty())
+    return;
+
+  std::unique_ptr<TaskQueue> TQ;
+  if (SkipTaskExecution)
+    TQ.reset(new DummyTaskQueue(NumberOfParallelCommands));
+  else
+    TQ.reset(new TaskQueue(NumberOfParallelCommands));
+
+  for (const auto &Cmd : PrebuildJobs)
+    TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
+                (void *)Cmd.get());
+
+  // Parseable output only describes the jobs which produce the compilation's
+  // outputs, so the prebuild jobs are only shown in verbose output.
+  auto taskBegan = [&] (ProcessId Pid, void *Context) {
+    if (Level == OutputLevel::Verbose)
+      ((const Job *)Context)->printCommandLine(llvm::errs());
+  };
+  auto taskFinished = [] (ProcessId Pid, int ReturnCode, StringRef Output,
+                          void *Context) {
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  auto taskSignalled = [] (ProcessId Pid, StringRef ErrorMsg, StringRef Output,
+                           void *Context) {
+    return TaskFinishedResponse::ContinueExecution;
+  };
+  TQ->execute(taskBegan, taskFinished, taskSignalled);
+}
+
 int Compilation::performSingleCommand(const Job *Cmd) {
   assert(Cmd->getInputs().empty() &&
          "This can only be used to run a single command with no inputs");
@@ -592,6 +970,9 @@ int Compilation::performJobs() {
   if (Level < OutputLevel::Parseable &&
       (SaveTemps || TempFilePaths.empty()) &&
       CompilationRecordPath.empty() &&
+      TraceEventsPath.empty() &&
+      StatsOutputDir.empty() &&
+      PrebuildJobs.empty() &&
       Jobs.size() == 1) {
     return performSingleCommand(Jobs.front().get());
   }
@@ -600,6 +981,8 @@ int Compilation::performJobs() {
     Diags.diagnose(SourceLoc(), diag::warning_parallel_execution_not_supported);
   }
 
+  performPrebuildJobs();
+
   int result = performJobsImpl();
 
   if (!SaveTemps) {
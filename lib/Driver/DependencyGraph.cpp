@@ -16,6 +16,8 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
@@ -46,14 +48,17 @@ DependencyGraphImpl::MarkTracerImpl::~MarkTracerImpl() = default;
 
 using LoadResult = DependencyGraphImpl::LoadResult;
 using DependencyKind = DependencyGraphImpl::DependencyKind;
-using DependencyCallbackTy = LoadResult(StringRef, DependencyKind, bool);
+using DependencyCallbackTy = LoadResult(StringRef, DependencyKind, bool,
+                                        StringRef);
 using InterfaceHashCallbackTy = LoadResult(StringRef);
 
 static LoadResult
 parseDependencyFile(llvm::MemoryBuffer &buffer,
                     llvm::function_ref<DependencyCallbackTy> providesCallback,
                     llvm::function_ref<DependencyCallbackTy> dependsCallback,
-                    llvm::function_ref<InterfaceHashCallbackTy> interfaceHashCallback) {
+                    llvm::function_ref<InterfaceHashCallbackTy> interfaceHashCallback,
+                    llvm::function_ref<InterfaceHashCallbackTy>
+                      interfaceHashExcludingMembersCallback) {
   namespace yaml = llvm::yaml;
 
   // FIXME: Switch to a format other than YAML.
@@ -72,6 +77,7 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
 
   LoadResult result = LoadResult::UpToDate;
   SmallString<64> scratch;
+  SmallString<32> fingerprintScratch;
 
   // FIXME: LLVM's YAML support does incremental parsing in such a way that
   // for-range loops break.
@@ -93,6 +99,14 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
       StringRef valueString = value->getValue(scratch);
       resultUpdate = interfaceHashCallback(valueString);
 
+    } else if (keyString == "interface-hash-excluding-members") {
+      auto *value = dyn_cast<yaml::ScalarNode>(i->getValue());
+      if (!value)
+        return LoadResult::HadError;
+
+      StringRef valueString = value->getValue(scratch);
+      resultUpdate = interfaceHashExcludingMembersCallback(valueString);
+
     } else {
       enum class DependencyDirection : bool {
         Depends,
@@ -140,6 +154,7 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
       if (dirAndKind.first == DependencyKind::NominalTypeMember) {
         // Handle member dependencies specially. Rather than being a single
         // string, they come in the form ["{MangledBaseName}", "memberName"].
+        // Provided members may also carry a fingerprint as a third element.
         for (yaml::Node &rawEntry : *entries) {
           bool isCascading = rawEntry.getRawTag() != "!private";
 
@@ -158,13 +173,21 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
             return LoadResult::HadError;
           ++iter;
 
+          bool isDepends = dirAndKind.second == DependencyDirection::Depends;
+          auto &callback = isDepends ? dependsCallback : providesCallback;
+
+          StringRef fingerprint;
           // FIXME: LLVM's YAML support doesn't implement == correctly for end
           // iterators.
+          if (!isDepends && iter != entry->end()) {
+            auto *fingerprintNode = dyn_cast<yaml::ScalarNode>(&*iter);
+            if (!fingerprintNode)
+              return LoadResult::HadError;
+            fingerprint = fingerprintNode->getValue(fingerprintScratch);
+            ++iter;
+          }
           assert(!(iter != entry->end()));
 
-          bool isDepends = dirAndKind.second == DependencyDirection::Depends;
-          auto &callback = isDepends ? dependsCallback : providesCallback;
-
           // Smash the type and member names together so we can continue using
           // StringMap.
           SmallString<64> appended;
@@ -173,7 +196,7 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
           appended += member->getValue(scratch);
 
           resultUpdate = callback(appended.str(), dirAndKind.first,
-                                  isCascading);
+                                  isCascading, fingerprint);
         }
       } else {
         for (const yaml::Node &rawEntry : *entries) {
@@ -185,7 +208,8 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
           auto &callback = isDepends ? dependsCallback : providesCallback;
 
           resultUpdate = callback(entry->getValue(scratch), dirAndKind.first,
-                                  entry->getRawTag() != "!private");
+                                  entry->getRawTag() != "!private",
+                                  StringRef());
         }
       }
     }
@@ -205,11 +229,73 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
   return result;
 }
 
+using RecordType = DependencyGraphImpl::DependencyRecordTy::Type;
+
+/// Parses \p buffer as a dependency file, appending its entries to
+/// \p records.
+static LoadResult
+parseDependencyFile(llvm::MemoryBuffer &buffer,
+                    std::vector<DependencyGraphImpl::DependencyRecordTy> &records) {
+  auto recordDependency = [&records](RecordType type) {
+    return [&records, type](StringRef name, DependencyKind kind,
+                            bool isCascading,
+                            StringRef fingerprint) -> LoadResult {
+      records.push_back({type, kind, isCascading, name, fingerprint});
+      return LoadResult::UpToDate;
+    };
+  };
+  auto recordHash = [&records](RecordType type) {
+    return [&records, type](StringRef hash) -> LoadResult {
+      records.push_back({type, DependencyKind(), true, hash, ""});
+      return LoadResult::UpToDate;
+    };
+  };
+
+  return parseDependencyFile(buffer,
+                             recordDependency(RecordType::Provides),
+                             recordDependency(RecordType::Depends),
+                             recordHash(RecordType::InterfaceHash),
+                             recordHash(
+                               RecordType::InterfaceHashExcludingMembers));
+}
+
 LoadResult DependencyGraphImpl::loadFromPath(const void *node, StringRef path) {
+  llvm::sys::fs::file_status status;
+  bool haveStatus = !llvm::sys::fs::status(path, status);
+  llvm::sys::TimeValue modTime;
+  if (haveStatus) {
+    modTime = status.getLastModificationTime();
+
+    auto cached = FileCache.find(path);
+    if (cached != FileCache.end()) {
+      CachedFileTy &file = cached->getValue();
+      if (file.modTimeSeconds == uint64_t(modTime.seconds()) &&
+          file.modTimeNanoseconds == uint32_t(modTime.nanoseconds()) &&
+          file.size == status.getSize()) {
+        file.isUsed = true;
+        return loadFromRecords(node, file.records);
+      }
+    }
+  }
+
   auto buffer = llvm::MemoryBuffer::getFile(path);
   if (!buffer)
     return LoadResult::HadError;
-  return loadFromBuffer(node, *buffer.get());
+
+  std::vector<DependencyRecordTy> records;
+  if (parseDependencyFile(*buffer.get(), records) == LoadResult::HadError)
+    return LoadResult::HadError;
+
+  if (!haveStatus)
+    return loadFromRecords(node, records);
+
+  CachedFileTy &file = FileCache[path];
+  file.modTimeSeconds = modTime.seconds();
+  file.modTimeNanoseconds = modTime.nanoseconds();
+  file.size = status.getSize();
+  file.records = std::move(records);
+  file.isUsed = true;
+  return loadFromRecords(node, file.records);
 }
 
 LoadResult
@@ -220,10 +306,31 @@ DependencyGraphImpl::loadFromString(const void *node, StringRef data) {
 
 LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
                                                llvm::MemoryBuffer &buffer) {
+  std::vector<DependencyRecordTy> records;
+  if (parseDependencyFile(buffer, records) == LoadResult::HadError)
+    return LoadResult::HadError;
+  return loadFromRecords(node, records);
+}
+
+LoadResult
+DependencyGraphImpl::loadFromRecords(const void *node,
+                                     ArrayRef<DependencyRecordTy> records) {
   auto &provides = Provides[node];
 
-  auto dependsCallback = [this, node](StringRef name, DependencyKind kind,
-                                      bool isCascading) -> LoadResult {
+  // Remember which entries the previous load provided, so that members that
+  // disappear count as changed.
+  SmallVector<bool, 32> wasCurrent;
+  wasCurrent.reserve(provides.size());
+  for (auto &entry : provides) {
+    wasCurrent.push_back(entry.isCurrent);
+    entry.isCurrent = false;
+    entry.isChanged = false;
+  }
+
+  bool dependsOnMarkedName = false;
+  auto dependsCallback = [this, node, &dependsOnMarkedName](
+      StringRef name, DependencyKind kind, bool isCascading,
+      StringRef fingerprint) -> LoadResult {
     if (kind == DependencyKind::ExternalFile)
       ExternalDependencies.insert(name);
 
@@ -244,24 +351,36 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
       iter->flags |= flags;
     }
 
-    if (isCascading && (entries.second & kind))
+    if (isCascading && (entries.second & kind)) {
+      dependsOnMarkedName = true;
       return LoadResult::AffectsDownstream;
+    }
     return LoadResult::UpToDate;
   };
 
   auto providesCallback =
-      [this, node, &provides](StringRef name, DependencyKind kind,
-                              bool isCascading) -> LoadResult {
+      [this, node, &provides, &wasCurrent](StringRef name, DependencyKind kind,
+                                           bool isCascading,
+                                           StringRef fingerprint) -> LoadResult {
     assert(isCascading);
     auto iter = std::find_if(provides.begin(), provides.end(),
                              [name](const ProvidesEntryTy &entry) -> bool {
       return name == entry.name;
     });
 
-    if (iter == provides.end())
-      provides.push_back({name, kind});
-    else
+    if (iter == provides.end()) {
+      provides.push_back({name, kind, fingerprint, /*isCurrent=*/true,
+                          /*isChanged=*/true});
+    } else {
       iter->kindMask |= kind;
+      if (!iter->isCurrent) {
+        size_t index = iter - provides.begin();
+        bool isNew = index >= wasCurrent.size() || !wasCurrent[index];
+        iter->isChanged = isNew || iter->fingerprint != fingerprint;
+        iter->fingerprint = fingerprint.str();
+        iter->isCurrent = true;
+      }
+    }
 
     return LoadResult::UpToDate;
   };
@@ -284,8 +403,291 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
     return LoadResult::UpToDate;
   };
 
-  return parseDependencyFile(buffer, providesCallback, dependsCallback,
-                             interfaceHashCallback);
+  bool hashExcludingMembersIsUnchanged = false;
+  auto interfaceHashExcludingMembersCallback =
+      [this, node, &hashExcludingMembersIsUnchanged](StringRef hash)
+        -> LoadResult {
+    auto insertResult =
+      InterfaceHashesExcludingMembers.insert(std::make_pair(node, hash));
+    if (!insertResult.second) {
+      auto iter = insertResult.first;
+      hashExcludingMembersIsUnchanged = (hash == iter->second);
+      iter->second = hash;
+    }
+    // Whether the interface changed at all is up to the full interface hash.
+    return LoadResult::UpToDate;
+  };
+
+  LoadResult result = LoadResult::UpToDate;
+  for (const DependencyRecordTy &record : records) {
+    LoadResult resultUpdate;
+    switch (record.type) {
+    case RecordType::Provides:
+      resultUpdate = providesCallback(record.name, record.kind,
+                                      record.isCascading, record.fingerprint);
+      break;
+    case RecordType::Depends:
+      resultUpdate = dependsCallback(record.name, record.kind,
+                                     record.isCascading, record.fingerprint);
+      break;
+    case RecordType::InterfaceHash:
+      resultUpdate = interfaceHashCallback(record.name);
+      break;
+    case RecordType::InterfaceHashExcludingMembers:
+      resultUpdate = interfaceHashExcludingMembersCallback(record.name);
+      break;
+    }
+
+    // After processing this entry, we now know more about the node as a whole.
+    assert(resultUpdate != LoadResult::HadError);
+    if (resultUpdate == LoadResult::AffectsDownstream)
+      result = LoadResult::AffectsDownstream;
+  }
+
+  for (size_t i = 0, e = wasCurrent.size(); i != e; ++i)
+    if (wasCurrent[i] && !provides[i].isCurrent)
+      provides[i].isChanged = true;
+
+  ChangedOnlyInMembers.erase(node);
+  if (result == LoadResult::AffectsDownstream && !dependsOnMarkedName &&
+      hashExcludingMembersIsUnchanged) {
+    noteChangedMembers(provides);
+    ChangedOnlyInMembers.insert(node);
+  }
+
+  return result;
+}
+
+/// The magic number at the start of a dependency graph cache: "SDGC".
+static constexpr uint32_t DependencyCacheSignature = 0x43474453;
+
+/// The version of the dependency graph cache format. Bump this whenever the
+/// format changes, or when DependencyKind or the record types change.
+static constexpr uint32_t DependencyCacheVersion = 1;
+
+/// Writes the cache in the following format. All integers are little-endian.
+///
+///   HEADER
+///     * The signature and format version.
+///     * The number of files.
+///
+///   FILES
+///     * The length-prefixed path of the dependency file.
+///     * The modification time (seconds and nanoseconds) and size of the file
+///       when it was parsed.
+///     * A length-prefixed array of records. Each record is its type, kind,
+///       and whether it is cascading, one byte each, followed by its
+///       length-prefixed name and fingerprint.
+bool DependencyGraphImpl::writeCache(StringRef path) const {
+  using namespace llvm::support;
+
+  // Create a temporary file to write the cache into.
+  SmallString<128> tmpName(path);
+  tmpName += "-%%%%%%";
+  int tmpFD;
+  if (llvm::sys::fs::createUniqueFile(tmpName.str(), tmpFD, tmpName))
+    return true;
+
+  {
+    llvm::raw_fd_ostream out(tmpFD, /*shouldClose=*/true);
+    endian::Writer<little> LE(out);
+
+    auto writeString = [&](StringRef str) {
+      LE.write(static_cast<uint32_t>(str.size()));
+      out << str;
+    };
+
+    uint32_t numFiles = 0;
+    for (auto &entry : FileCache)
+      if (entry.getValue().isUsed)
+        ++numFiles;
+
+    LE.write(DependencyCacheSignature);
+    LE.write(DependencyCacheVersion);
+    LE.write(numFiles);
+
+    for (auto &entry : FileCache) {
+      const CachedFileTy &file = entry.getValue();
+      if (!file.isUsed)
+        continue;
+
+      writeString(entry.getKey());
+      LE.write(file.modTimeSeconds);
+      LE.write(file.modTimeNanoseconds);
+      LE.write(file.size);
+      LE.write(static_cast<uint32_t>(file.records.size()));
+      for (const DependencyRecordTy &record : file.records) {
+        LE.write(static_cast<uint8_t>(record.type));
+        LE.write(static_cast<uint8_t>(record.kind));
+        LE.write(static_cast<uint8_t>(record.isCascading));
+        writeString(record.name);
+        writeString(record.fingerprint);
+      }
+    }
+
+    out.flush();
+    if (out.has_error()) {
+      out.clear_error();
+      llvm::sys::fs::remove(tmpName.str());
+      return true;
+    }
+  }
+
+  // Atomically rename the file into its final location.
+  if (llvm::sys::fs::rename(tmpName.str(), path)) {
+    llvm::sys::fs::remove(tmpName.str());
+    return true;
+  }
+  return false;
+}
+
+/// Returns true if \p type and \p kind could have come from
+/// parseDependencyFile, to reject caches that are corrupted.
+static bool isValidRecord(RecordType type, DependencyKind kind) {
+  switch (type) {
+  case RecordType::Provides:
+  case RecordType::Depends:
+    switch (kind) {
+    case DependencyKind::TopLevelName:
+    case DependencyKind::DynamicLookupName:
+    case DependencyKind::NominalType:
+    case DependencyKind::NominalTypeMember:
+    case DependencyKind::ExternalFile:
+      return true;
+    }
+    return false;
+  case RecordType::InterfaceHash:
+  case RecordType::InterfaceHashExcludingMembers:
+    return kind == DependencyKind();
+  }
+  return false;
+}
+
+bool DependencyGraphImpl::loadCache(StringRef path) {
+  using namespace llvm::support;
+
+  auto buffer = llvm::MemoryBuffer::getFile(path, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer)
+    return true;
+
+  const char *cursor = buffer.get()->getBufferStart();
+  const char *end = buffer.get()->getBufferEnd();
+  bool hadError = false;
+
+  // Each read checks that it stays within the buffer; after the first
+  // failure, all reads return zero and hadError stays set.
+  auto checkSize = [&](size_t size) -> bool {
+    if (hadError || size_t(end - cursor) < size) {
+      hadError = true;
+      return false;
+    }
+    return true;
+  };
+  auto read8 = [&]() -> uint8_t {
+    if (!checkSize(1))
+      return 0;
+    return static_cast<uint8_t>(*cursor++);
+  };
+  auto read32 = [&]() -> uint32_t {
+    if (!checkSize(sizeof(uint32_t)))
+      return 0;
+    auto result = endian::read32le(cursor);
+    cursor += sizeof(result);
+    return result;
+  };
+  auto read64 = [&]() -> uint64_t {
+    if (!checkSize(sizeof(uint64_t)))
+      return 0;
+    auto result = endian::read64le(cursor);
+    cursor += sizeof(result);
+    return result;
+  };
+  auto readString = [&]() -> StringRef {
+    uint32_t size = read32();
+    if (!checkSize(size))
+      return StringRef();
+    StringRef result(cursor, size);
+    cursor += size;
+    return result;
+  };
+
+  if (read32() != DependencyCacheSignature ||
+      read32() != DependencyCacheVersion) {
+    return true;
+  }
+
+  llvm::StringMap<CachedFileTy> newCache;
+  uint32_t numFiles = read32();
+  for (uint32_t i = 0; i != numFiles && !hadError; ++i) {
+    StringRef filePath = readString();
+    CachedFileTy file;
+    file.modTimeSeconds = read64();
+    file.modTimeNanoseconds = read32();
+    file.size = read64();
+    file.isUsed = false;
+
+    uint32_t numRecords = read32();
+    // Don't trust the count for the allocation; each record takes at least
+    // eleven bytes.
+    if (!checkSize(size_t(numRecords) * 11))
+      break;
+    file.records.reserve(numRecords);
+    for (uint32_t j = 0; j != numRecords && !hadError; ++j) {
+      auto type = static_cast<RecordType>(read8());
+      auto kind = static_cast<DependencyKind>(read8());
+      bool isCascading = read8();
+      if (!isValidRecord(type, kind)) {
+        hadError = true;
+        break;
+      }
+      StringRef name = readString();
+      StringRef fingerprint = readString();
+      file.records.push_back({type, kind, isCascading, name, fingerprint});
+    }
+
+    newCache[filePath] = std::move(file);
+  }
+
+  if (hadError || cursor != end)
+    return true;
+
+  FileCache = std::move(newCache);
+  return false;
+}
+
+void DependencyGraphImpl::noteChangedMembers(
+    MutableArrayRef<ProvidesEntryTy> provides) {
+  llvm::StringMap<ProvidesEntryTy *> entriesByName;
+  for (auto &entry : provides)
+    entriesByName[entry.name] = &entry;
+
+  for (const auto &entry : provides) {
+    if (!entry.isChanged ||
+        !entry.kindMask.contains(DependencyKind::NominalTypeMember)) {
+      continue;
+    }
+
+    size_t splitPoint = entry.name.find('\0');
+    assert(splitPoint != std::string::npos);
+    StringRef typeEntryName = StringRef(entry.name).slice(0, splitPoint+1);
+    StringRef memberName = StringRef(entry.name).substr(splitPoint+1);
+    if (memberName.empty())
+      continue;
+
+    // Anything that depends on every member of the type is affected too...
+    auto typeEntry = entriesByName.find(typeEntryName);
+    if (typeEntry != entriesByName.end())
+      typeEntry->getValue()->isChanged = true;
+
+    // ...as is anything that looks up the member through AnyObject.
+    auto dynamicEntry = entriesByName.find(memberName);
+    if (dynamicEntry != entriesByName.end() &&
+        dynamicEntry->getValue()->kindMask.contains(
+          DependencyKind::DynamicLookupName)) {
+      dynamicEntry->getValue()->isChanged = true;
+    }
+  }
 }
 
 void DependencyGraphImpl::markExternal(SmallVectorImpl<const void *> &visited,
@@ -321,12 +723,16 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
   SmallPtrSet<const void *, 16> visitedSet;
 
   auto addDependentsToWorklist = [&](const void *next,
-                                     ArrayRef<MarkTracerImpl::Entry> reason) {
+                                     ArrayRef<MarkTracerImpl::Entry> reason,
+                                     bool onlyChangedEntries) {
     auto allProvided = Provides.find(next);
     if (allProvided == Provides.end())
       return;
 
     for (const auto &provided : allProvided->second) {
+      if (onlyChangedEntries && !provided.isChanged)
+        continue;
+
       auto allDependents = Dependencies.find(provided.name);
       if (allDependents == Dependencies.end())
         continue;
@@ -372,8 +778,11 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
   };
 
   // Always mark through the starting node, even if it's already marked.
+  // If its last load only changed some of its members, just follow the
+  // entries for those members.
   markIntransitive(node);
-  addDependentsToWorklist(node, {});
+  bool onlyChangedEntries = ChangedOnlyInMembers.erase(node);
+  addDependentsToWorklist(node, {}, onlyChangedEntries);
 
   while (!worklist.empty()) {
     auto next = worklist.pop_back_val();
@@ -385,7 +794,8 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
       continue;
     }
 
-    addDependentsToWorklist(next.Node, next.Reason);
+    addDependentsToWorklist(next.Node, next.Reason,
+                            /*onlyChangedEntries=*/false);
     if (!markIntransitive(next.Node))
       continue;
     record(next);
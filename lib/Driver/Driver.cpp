@@ -36,6 +36,7 @@
 #include "swift/Config.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Config/config.h"
@@ -51,7 +52,9 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <atomic>
 #include <memory>
+#include <thread>
 
 using namespace swift;
 using namespace swift::driver;
@@ -207,6 +210,8 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
   SmallString<64> scratch;
 
   llvm::StringMap<InputInfo> previousInputs;
+  llvm::StringMap<llvm::sys::TimeValue> previousCompileTimes;
+  llvm::StringMap<uint64_t> previousContentHashes;
   bool versionValid = false;
   bool optionsMatch = true;
 
@@ -310,9 +315,62 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
         auto inputName = key->getValue(scratch);
         previousInputs[inputName] = { *previousBuildState, timeValue };
       }
+
+    } else if (keyStr == "compile_times") {
+      auto *timeMap = dyn_cast<yaml::MappingNode>(i->getValue());
+      if (!timeMap)
+        return true;
+
+      // FIXME: LLVM's YAML support does incremental parsing in such a way that
+      // for-range loops break.
+      for (auto i = timeMap->begin(), e = timeMap->end(); i != e; ++i) {
+        auto *key = dyn_cast<yaml::ScalarNode>(i->getKey());
+        if (!key)
+          return true;
+
+        llvm::sys::TimeValue compileTime;
+        if (readTimeValue(i->getValue(), compileTime))
+          return true;
+
+        previousCompileTimes[key->getValue(scratch)] = compileTime;
+      }
+
+    } else if (keyStr == "content_hashes") {
+      auto *hashMap = dyn_cast<yaml::MappingNode>(i->getValue());
+      if (!hashMap)
+        return true;
+
+      // FIXME: LLVM's YAML support does incremental parsing in such a way that
+      // for-range loops break.
+      for (auto i = hashMap->begin(), e = hashMap->end(); i != e; ++i) {
+        auto *key = dyn_cast<yaml::ScalarNode>(i->getKey());
+        auto *value = dyn_cast<yaml::ScalarNode>(i->getValue());
+        if (!key || !value)
+          return true;
+
+        uint64_t contentHash;
+        if (value->getValue(scratch).getAsInteger(16, contentHash))
+          return true;
+
+        previousContentHashes[key->getValue(scratch)] = contentHash;
+      }
     }
   }
 
+  // Compile times are only used to order jobs, so an input without a
+  // recorded time is simply assumed to be fast.
+  for (auto &entry : previousCompileTimes) {
+    auto iter = previousInputs.find(entry.getKey());
+    if (iter != previousInputs.end())
+      iter->getValue().previousCompileTime = entry.getValue();
+  }
+
+  for (auto &entry : previousContentHashes) {
+    auto iter = previousInputs.find(entry.getKey());
+    if (iter != previousInputs.end())
+      iter->getValue().previousContentHash = entry.getValue();
+  }
+
   if (!versionValid || !optionsMatch)
     return true;
 
@@ -332,6 +390,82 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
   return numInputsFromPrevious != previousInputs.size();
 }
 
+/// Computes a hash of the current contents of each source input.
+///
+/// Inputs whose modification time matches the one in \p outOfDateMap keep
+/// their recorded hash; the rest are read and hashed in parallel. An input
+/// whose contents still match its recorded hash has only been touched, so its
+/// entry in \p outOfDateMap is given the new modification time. The rest of
+/// the driver then treats it as unmodified.
+static void
+computeInputContentHashes(const Driver::InputList &inputs,
+                          InputInfoMap *outOfDateMap,
+                          llvm::DenseMap<const Arg *, uint64_t> &hashes) {
+  struct PendingInput {
+    const Arg *input;
+    llvm::sys::TimeValue modTime;
+    uint64_t hash;
+  };
+  std::vector<PendingInput> pending;
+
+  for (auto &inputPair : inputs) {
+    switch (inputPair.first) {
+    case types::TY_Swift:
+    case types::TY_SIL:
+    case types::TY_SIB:
+      break;
+    default:
+      continue;
+    }
+    const Arg *input = inputPair.second;
+
+    llvm::sys::fs::file_status inputStatus;
+    if (llvm::sys::fs::status(input->getValue(), inputStatus))
+      continue;
+    llvm::sys::TimeValue modTime = inputStatus.getLastModificationTime();
+
+    if (outOfDateMap) {
+      auto iter = outOfDateMap->find(input);
+      if (iter != outOfDateMap->end() &&
+          iter->second.previousContentHash != 0 &&
+          iter->second.previousModTime == modTime) {
+        hashes[input] = iter->second.previousContentHash;
+        continue;
+      }
+    }
+    pending.push_back({input, modTime, 0});
+  }
+
+  std::atomic<size_t> nextIndex(0);
+  auto hashPendingInputs = [&] {
+    for (size_t i = nextIndex++; i < pending.size(); i = nextIndex++)
+      pending[i].hash =
+          Compilation::computeContentHash(pending[i].input->getValue());
+  };
+
+  size_t numThreads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                       pending.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i)
+    threads.emplace_back(hashPendingInputs);
+  hashPendingInputs();
+  for (std::thread &thread : threads)
+    thread.join();
+
+  for (const PendingInput &entry : pending) {
+    if (entry.hash == 0)
+      continue;
+    hashes[entry.input] = entry.hash;
+
+    if (!outOfDateMap)
+      continue;
+    auto iter = outOfDateMap->find(entry.input);
+    if (iter != outOfDateMap->end() &&
+        iter->second.previousContentHash == entry.hash)
+      iter->second.previousModTime = entry.modTime;
+  }
+}
+
 std::unique_ptr<Compilation> Driver::buildCompilation(
     ArrayRef<const char *> Args) {
   llvm::PrettyStackTraceString CrashInfo("Compilation construction");
@@ -453,6 +587,14 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
     }
   }
 
+  llvm::DenseMap<const Arg *, uint64_t> InputContentHashes;
+  if (Incremental &&
+      ArgList->hasArg(options::OPT_enable_incremental_file_hashing)) {
+    computeInputContentHashes(Inputs,
+                              rebuildEverything ? nullptr : &outOfDateMap,
+                              InputContentHashes);
+  }
+
   // Construct the graph of Actions.
   ActionList Actions;
   buildActions(*TC, *TranslatedArgList, Inputs, OI, OFM.get(),
@@ -497,6 +639,13 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
 
   buildJobs(Actions, OI, OFM.get(), *C);
 
+  // Without a build record every compile job runs, and they would all race
+  // to build the same Clang modules.
+  if (rebuildEverything &&
+      OI.CompilerMode == OutputInfo::Mode::StandardCompile &&
+      C->getArgs().hasArg(options::OPT_prebuild_clang_modules))
+    buildClangModulePrebuildJobs(Inputs, OI, *C);
+
   // For updating code we need to go through all the files and pick up changes,
   // even if they have compiler errors.
   // Also for getting bulk fixits.
@@ -507,6 +656,22 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
   if (ShowIncrementalBuildDecisions)
     C->setShowsIncrementalBuildDecisions();
 
+  C->setInputContentHashes(std::move(InputContentHashes));
+
+  if (const Arg *A =
+          C->getArgs().getLastArg(options::OPT_driver_trace_events_path))
+    C->setTraceEventsPath(A->getValue());
+
+  if (const Arg *A = C->getArgs().getLastArg(options::OPT_stats_output_dir))
+    C->setStatsOutputDir(A->getValue(), OI.ModuleName);
+
+  // Batching only applies to frontend jobs with a single primary file and a
+  // single output for it.
+  if (C->getArgs().hasArg(options::OPT_enable_batch_mode) &&
+      OI.CompilerMode == OutputInfo::Mode::StandardCompile &&
+      !OI.isMultiThreading())
+    C->enableBatchMode(OI);
+
   // This has to happen after building jobs, because otherwise we won't even
   // emit .swiftdeps files for the next build.
   if (rebuildEverything)
@@ -1173,6 +1338,7 @@ void Driver::buildActions(const ToolChain &TC,
       case types::TY_ClangModuleFile:
       case types::TY_SwiftDeps:
       case types::TY_Remapping:
+      case types::TY_TraceEvents:
         // We could in theory handle assembly or LLVM input, but let's not.
         // FIXME: What about LTO?
         Diags.diagnose(SourceLoc(), diag::error_unexpected_input_file,
@@ -1414,6 +1580,100 @@ void Driver::buildJobs(const ActionList &Actions, const OutputInfo &OI,
   }
 }
 
+/// Adds the names of the top-level modules which the Swift file at \p Path
+/// imports to \p Names, except for \p ThisModuleName.
+///
+/// This is done by looking at the text of each line rather than by parsing,
+/// so it may miss unusually written imports. That only means that the Clang
+/// modules they need aren't prebuilt.
+static void collectImportedModuleNames(StringRef Path,
+                                       StringRef ThisModuleName,
+                                       llvm::SetVector<std::string> &Names) {
+  auto Buffer = llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return;
+
+  StringRef Contents = Buffer.get()->getBuffer();
+  while (!Contents.empty()) {
+    StringRef Line;
+    std::tie(Line, Contents) = Contents.split('\n');
+
+    // A module name ends at the first '.' of a submodule or declaration path.
+    auto takeWord = [&Line]() -> StringRef {
+      Line = Line.ltrim();
+      StringRef Word = Line.substr(0, Line.find_first_of(" \t\r."));
+      Line = Line.substr(Word.size());
+      return Word;
+    };
+
+    // Skip attributes like @testable.
+    StringRef Word = takeWord();
+    while (Word.startswith("@"))
+      Word = takeWord();
+    if (Word != "import")
+      continue;
+
+    Word = takeWord();
+    bool IsImportKind = llvm::StringSwitch<bool>(Word)
+      .Cases("typealias", "struct", "class", "enum", "protocol", true)
+      .Cases("let", "var", "func", true)
+      .Default(false);
+    if (IsImportKind)
+      Word = takeWord();
+
+    if (Lexer::isIdentifier(Word) && Word != ThisModuleName)
+      Names.insert(Word);
+  }
+}
+
+void Driver::buildClangModulePrebuildJobs(const InputList &Inputs,
+                                          const OutputInfo &OI,
+                                          Compilation &C) const {
+  // With a single Swift input there is a single compile job, which doesn't
+  // race with anything.
+  unsigned NumSwiftInputs = 0;
+  llvm::SetVector<std::string> ModuleNames;
+  for (const InputPair &Input : Inputs) {
+    if (Input.first != types::TY_Swift)
+      continue;
+    ++NumSwiftInputs;
+    collectImportedModuleNames(Input.second->getValue(), OI.ModuleName,
+                               ModuleNames);
+  }
+  if (NumSwiftInputs < 2)
+    return;
+
+  const ArgList &Args = C.getArgs();
+  bool HasBridgingHeader = Args.hasArg(options::OPT_import_objc_header,
+                                       options::OPT_import_underlying_module);
+  if (ModuleNames.empty() && !HasBridgingHeader)
+    return;
+
+  // Spread the modules round-robin over one job per parallel command. If
+  // modules in different jobs depend on the same Clang module, one job waits
+  // for the other on the module cache lock, which is no worse than before.
+  size_t NumJobs = std::min<size_t>(ModuleNames.size(),
+                                    C.getNumberOfParallelCommands());
+  NumJobs = std::max<size_t>(NumJobs, 1);
+  std::vector<std::vector<std::string>> Partitions(NumJobs);
+  for (size_t i = 0, e = ModuleNames.size(); i != e; ++i)
+    Partitions[i % NumJobs].push_back(ModuleNames[i]);
+
+  for (size_t i = 0; i != NumJobs; ++i) {
+    // Like the Actions built by buildActions, this lives as long as the
+    // Compilation.
+    auto *JA = new ClangModulePrebuildJobAction(Partitions[i], i == 0);
+    std::unique_ptr<CommandOutput> Output(new CommandOutput(JA->getType()));
+    Output->addPrimaryOutput(StringRef(), StringRef());
+    SmallVector<const Job *, 1> NoInputJobs;
+    C.addPrebuildJob(C.getDefaultToolChain().constructJob(*JA,
+                                                          std::move(NoInputJobs),
+                                                          std::move(Output),
+                                                          ActionList(), Args,
+                                                          OI));
+  }
+}
+
 static StringRef getOutputFilename(Compilation &C,
                                    const JobAction *JA,
                                    const OutputInfo &OI,
@@ -1815,6 +2075,21 @@ Job *Driver::buildJobsForAction(Compilation &C, const Action *A,
     if (C.getIncrementalBuildEnabled()) {
       addAuxiliaryOutput(C, *Output, types::TY_SwiftDeps, OI, OutputMap);
     }
+
+    // The frontend's trace events are merged into the driver's trace, so they
+    // never need to be kept.
+    if (C.getArgs().hasArg(options::OPT_driver_trace_events_path)) {
+      addAuxiliaryOutput(C, *Output, types::TY_TraceEvents, OI, nullptr);
+      StringRef OutputPath =
+        Output->getAdditionalOutputForType(types::TY_TraceEvents);
+      if (!C.isTemporaryFile(OutputPath))
+        C.addTemporaryFile(OutputPath);
+
+      // Remove any stale file, so that a frontend job which fails before
+      // writing its trace doesn't contribute old events.
+      if (llvm::sys::fs::is_regular_file(OutputPath))
+        llvm::sys::fs::remove(OutputPath);
+    }
   }
 
   // Choose the Objective-C header output path.
@@ -1867,6 +2142,7 @@ Job *Driver::buildJobsForAction(Compilation &C, const Action *A,
   if (!J->getOutput().getAdditionalOutputForType(types::TY_SwiftDeps).empty()) {
     if (InputActions.size() == 1) {
       auto compileJob = cast<CompileJobAction>(A);
+      J->setPreviousCompileTime(compileJob->getInputInfo().previousCompileTime);
       bool alwaysRebuildDependents =
           C.getArgs().hasArg(options::OPT_driver_always_rebuild_dependents);
       handleCompileJobCondition(J, compileJob->getInputInfo(), BaseInput,
@@ -1979,6 +2255,8 @@ void Driver::printActions(const ActionList &Actions) const {
 }
 
 void Driver::printJobs(const Compilation &C) const {
+  for (const Job *J : C.getPrebuildJobs())
+    J->printCommandLine(llvm::outs());
   for (const Job *J : C.getJobs())
     J->printCommandLine(llvm::outs());
 }
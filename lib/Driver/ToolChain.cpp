@@ -19,6 +19,7 @@
 
 #include "swift/Driver/ToolChain.h"
 
+#include "swift/Driver/Action.h"
 #include "swift/Driver/Driver.h"
 #include "swift/Driver/Job.h"
 #include "llvm/Option/ArgList.h"
@@ -40,7 +41,7 @@ ToolChain::constructJob(const JobAction &JA,
                         const ActionList &inputActions,
                         const llvm::opt::ArgList &args,
                         const OutputInfo &OI) const {
-  JobContext context{inputs, *output, inputActions, args, OI};
+  JobContext context{inputs, *output, inputActions, args, OI, {}};
 
   const char *executableName;
   llvm::opt::ArgStringList arguments;
@@ -57,6 +58,7 @@ ToolChain::constructJob(const JobAction &JA,
   CASE(GenerateDSYMJob)
   CASE(AutolinkExtractJob)
   CASE(REPLJob)
+  CASE(ClangModulePrebuildJob)
 #undef CASE
   case Action::Input:
     llvm_unreachable("not a JobAction");
@@ -85,6 +87,56 @@ ToolChain::constructJob(const JobAction &JA,
                                 executablePath, std::move(arguments));
 }
 
+std::unique_ptr<Job>
+ToolChain::constructBatchJob(ArrayRef<const Job *> jobs,
+                             const llvm::opt::ArgList &args,
+                             const OutputInfo &OI) const {
+  assert(jobs.size() > 1 && "a batch needs more than one job");
+
+  // The frontend matches the outputs to the primary files by position, so
+  // keep the jobs in the order of their inputs on the command line.
+  SmallVector<const Job *, 8> sortedJobs(jobs.begin(), jobs.end());
+  auto getInputIndex = [](const Job *job) {
+    auto *input = cast<InputAction>(*job->getSource().begin());
+    return input->getInputArg().getIndex();
+  };
+  std::sort(sortedJobs.begin(), sortedJobs.end(),
+            [&](const Job *lhs, const Job *rhs) {
+    return getInputIndex(lhs) < getInputIndex(rhs);
+  });
+
+  const CommandOutput &firstOutput = sortedJobs.front()->getOutput();
+  auto output =
+    llvm::make_unique<CommandOutput>(firstOutput.getPrimaryOutputType());
+  ActionList inputActions;
+  SmallVector<const CommandOutput *, 8> batchedOutputs;
+  for (const Job *job : sortedJobs) {
+    assert(isa<CompileJobAction>(job->getSource()) && job->getInputs().empty());
+    const CommandOutput &jobOutput = job->getOutput();
+    assert(jobOutput.getPrimaryOutputType() == output->getPrimaryOutputType());
+    auto filenames = jobOutput.getPrimaryOutputFilenames();
+    for (unsigned i = 0, e = filenames.size(); i != e; ++i)
+      output->addPrimaryOutput(filenames[i], jobOutput.getBaseInput(i));
+    inputActions.append(job->getSource().begin(), job->getSource().end());
+    batchedOutputs.push_back(&jobOutput);
+  }
+
+  SmallVector<const Job *, 1> inputs;
+  JobContext context{inputs, *output, inputActions, args, OI, batchedOutputs};
+  const Action &source = sortedJobs.front()->getSource();
+  const char *executableName;
+  llvm::opt::ArgStringList arguments;
+  std::tie(executableName, arguments) =
+      constructInvocation(cast<CompileJobAction>(source), context);
+  assert(StringRef(SWIFT_EXECUTABLE_NAME) == executableName &&
+         "batch jobs must run the Swift frontend");
+  (void)executableName;
+
+  return llvm::make_unique<Job>(source, std::move(inputs), std::move(output),
+                                sortedJobs.front()->getExecutable(),
+                                std::move(arguments));
+}
+
 std::string
 ToolChain::findProgramRelativeToSwift(StringRef executableName) const {
   auto insertionResult =
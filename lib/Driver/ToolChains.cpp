@@ -25,6 +25,7 @@
 #include "swift/Config.h"
 #include "clang/Basic/Version.h"
 #include "clang/Driver/Util.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Option/Arg.h"
 #include "llvm/Option/ArgList.h"
@@ -124,6 +125,9 @@ static void addCommonFrontendArgs(const ToolChain &TC,
   inputArgs.AddLastArg(arguments, options::OPT_parse_stdlib);
   inputArgs.AddLastArg(arguments, options::OPT_resource_dir);
   inputArgs.AddLastArg(arguments, options::OPT_solver_memory_threshold);
+  inputArgs.AddLastArg(arguments, options::OPT_stats_output_dir);
+  inputArgs.AddLastArg(arguments,
+                       options::OPT_solver_expression_time_threshold);
   inputArgs.AddLastArg(arguments, options::OPT_profile_generate);
   inputArgs.AddLastArg(arguments, options::OPT_profile_coverage_mapping);
 
@@ -209,6 +213,7 @@ ToolChain::constructInvocation(const CompileJobAction &job,
     case types::TY_Image:
     case types::TY_SwiftDeps:
     case types::TY_Remapping:
+    case types::TY_TraceEvents:
       llvm_unreachable("Output type can never be primary output.");
     case types::TY_INVALID:
       llvm_unreachable("Invalid type ID");
@@ -238,21 +243,24 @@ ToolChain::constructInvocation(const CompileJobAction &job,
   switch (context.OI.CompilerMode) {
   case OutputInfo::Mode::StandardCompile:
   case OutputInfo::Mode::UpdateCode: {
-    assert(context.InputActions.size() == 1 &&
-           "The Swift frontend expects exactly one input (the primary file)!");
+    assert((context.InputActions.size() == 1 ||
+            context.InputActions.size() == context.BatchedOutputs.size()) &&
+           "The Swift frontend expects exactly one input (the primary file) "
+           "for each compile!");
 
-    auto *IA = cast<InputAction>(context.InputActions[0]);
-    const Arg &PrimaryInputArg = IA->getInputArg();
-    bool FoundPrimaryInput = false;
+    // In batch mode, every input of the batch is a primary file.
+    llvm::SmallDenseSet<unsigned, 8> PrimaryInputIndices;
+    for (const Action *A : context.InputActions) {
+      auto *IA = cast<InputAction>(A);
+      PrimaryInputIndices.insert(IA->getInputArg().getIndex());
+    }
 
     for (auto *A : make_range(context.Args.filtered_begin(options::OPT_INPUT),
                               context.Args.filtered_end())) {
       // See if this input should be passed with -primary-file.
       // FIXME: This will pick up non-source inputs too, like .o files.
-      if (!FoundPrimaryInput && PrimaryInputArg.getIndex() == A->getIndex()) {
+      if (PrimaryInputIndices.erase(A->getIndex()))
         Arguments.push_back("-primary-file");
-        FoundPrimaryInput = true;
-      }
       Arguments.push_back(A->getValue());
     }
     break;
@@ -297,15 +305,31 @@ ToolChain::constructInvocation(const CompileJobAction &job,
   case OutputInfo::Mode::REPL:
     context.Args.AddAllArgs(Arguments, options::OPT_l, options::OPT_framework,
                             options::OPT_L);
+    context.Args.AddLastArg(Arguments, options::OPT_immediate_cache_path);
     break;
   }
 
-  const std::string &ModuleOutputPath =
-    context.Output.getAdditionalOutputForType(types::ID::TY_SwiftModuleFile);
-  if (!ModuleOutputPath.empty()) {
-    Arguments.push_back("-emit-module-path");
-    Arguments.push_back(ModuleOutputPath.c_str());
-  }
+  // Adds the supplementary output of the given type. A batch job passes one
+  // path per primary file, in the same order as the primary files.
+  ArrayRef<const CommandOutput *> Outputs = context.BatchedOutputs;
+  const CommandOutput *SingleOutput = &context.Output;
+  if (Outputs.empty())
+    Outputs = llvm::makeArrayRef(SingleOutput);
+  auto addOutputsOfType = [&](types::ID Type, const char *Option) {
+    for (const CommandOutput *Output : Outputs) {
+      const std::string &Path = Output->getAdditionalOutputForType(Type);
+      if (!Path.empty()) {
+        Arguments.push_back(Option);
+        Arguments.push_back(Path.c_str());
+      }
+    }
+  };
+
+  addOutputsOfType(types::TY_SwiftModuleFile, "-emit-module-path");
+  // The common frontend arguments include the module doc path of a single
+  // compile, but the merged output of a batch has no supplementary outputs.
+  if (!context.BatchedOutputs.empty())
+    addOutputsOfType(types::TY_SwiftModuleDocFile, "-emit-module-doc-path");
 
   const std::string &ObjCHeaderOutputPath =
     context.Output.getAdditionalOutputForType(types::ID::TY_ObjCHeader);
@@ -318,33 +342,12 @@ ToolChain::constructInvocation(const CompileJobAction &job,
     Arguments.push_back(ObjCHeaderOutputPath.c_str());
   }
 
-  const std::string &SerializedDiagnosticsPath =
-    context.Output.getAdditionalOutputForType(types::TY_SerializedDiagnostics);
-  if (!SerializedDiagnosticsPath.empty()) {
-    Arguments.push_back("-serialize-diagnostics-path");
-    Arguments.push_back(SerializedDiagnosticsPath.c_str());
-  }
-
-  const std::string &DependenciesPath =
-    context.Output.getAdditionalOutputForType(types::TY_Dependencies);
-  if (!DependenciesPath.empty()) {
-    Arguments.push_back("-emit-dependencies-path");
-    Arguments.push_back(DependenciesPath.c_str());
-  }
-
-  const std::string &ReferenceDependenciesPath =
-    context.Output.getAdditionalOutputForType(types::TY_SwiftDeps);
-  if (!ReferenceDependenciesPath.empty()) {
-    Arguments.push_back("-emit-reference-dependencies-path");
-    Arguments.push_back(ReferenceDependenciesPath.c_str());
-  }
-
-  const std::string &FixitsPath =
-    context.Output.getAdditionalOutputForType(types::TY_Remapping);
-  if (!FixitsPath.empty()) {
-    Arguments.push_back("-emit-fixits-path");
-    Arguments.push_back(FixitsPath.c_str());
-  }
+  addOutputsOfType(types::TY_SerializedDiagnostics,
+                   "-serialize-diagnostics-path");
+  addOutputsOfType(types::TY_Dependencies, "-emit-dependencies-path");
+  addOutputsOfType(types::TY_SwiftDeps, "-emit-reference-dependencies-path");
+  addOutputsOfType(types::TY_Remapping, "-emit-fixits-path");
+  addOutputsOfType(types::TY_TraceEvents, "-trace-events-path");
 
   if (context.OI.numThreads > 0) {
     Arguments.push_back("-num-threads");
@@ -426,6 +429,7 @@ ToolChain::constructInvocation(const BackendJobAction &job,
     case types::TY_Image:
     case types::TY_SwiftDeps:
     case types::TY_Remapping:
+    case types::TY_TraceEvents:
       llvm_unreachable("Output type can never be primary output.");
     case types::TY_INVALID:
       llvm_unreachable("Invalid type ID");
@@ -649,6 +653,44 @@ ToolChain::constructInvocation(const GenerateDSYMJobAction &job,
   return std::make_pair("dsymutil", Arguments);
 }
 
+std::pair<const char *, llvm::opt::ArgStringList>
+ToolChain::constructInvocation(const ClangModulePrebuildJobAction &job,
+                               const JobContext &context) const {
+  assert(context.Inputs.empty());
+  assert(context.InputActions.empty());
+
+  ArgStringList Arguments;
+  Arguments.push_back("-frontend");
+  Arguments.push_back("-load-imported-modules");
+
+  addCommonFrontendArgs(*this, context.OI, context.Output, context.Args,
+                        Arguments);
+
+  // Only one of the prebuild jobs imports the bridging header and the
+  // underlying module. The others would just wait for it on the module cache
+  // lock.
+  if (!job.importsBridgingHeader()) {
+    auto HeaderArg = std::find(Arguments.begin(), Arguments.end(),
+                               StringRef("-import-objc-header"));
+    if (HeaderArg != Arguments.end())
+      Arguments.erase(HeaderArg, HeaderArg + 2);
+    auto UnderlyingArg = std::find(Arguments.begin(), Arguments.end(),
+                                   StringRef("-import-underlying-module"));
+    if (UnderlyingArg != Arguments.end())
+      Arguments.erase(UnderlyingArg);
+  }
+
+  for (const std::string &Name : job.getModuleNames()) {
+    Arguments.push_back("-import-module");
+    Arguments.push_back(context.Args.MakeArgString(Name));
+  }
+
+  Arguments.push_back("-module-name");
+  Arguments.push_back(context.Args.MakeArgString(context.OI.ModuleName));
+
+  return std::make_pair(SWIFT_EXECUTABLE_NAME, Arguments);
+}
+
 std::pair<const char *, llvm::opt::ArgStringList>
 ToolChain::constructInvocation(const AutolinkExtractJobAction &job,
                                const JobContext &context) const {
@@ -74,6 +74,7 @@ bool types::isTextual(ID Id) {
   case types::TY_LLVM_IR:
   case types::TY_ObjCHeader:
   case types::TY_AutolinkFile:
+  case types::TY_TraceEvents:
     return true;
   case types::TY_Image:
   case types::TY_Object:
@@ -118,6 +119,7 @@ bool types::isAfterLLVM(ID Id) {
   case types::TY_SwiftDeps:
   case types::TY_Nothing:
   case types::TY_Remapping:
+  case types::TY_TraceEvents:
     return false;
   case types::TY_INVALID:
     llvm_unreachable("Invalid type ID.");
@@ -119,11 +119,28 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.EmitSortedSIL |= Args.hasArg(OPT_emit_sorted_sil);
 
   Opts.DelayedFunctionBodyParsing |= Args.hasArg(OPT_delayed_function_body_parsing);
+  Opts.SkipNonPrimaryFunctionBodies |=
+    Args.hasArg(OPT_skip_non_primary_function_bodies);
+  Opts.DelayNonPrimaryFunctionBodies &=
+    !Args.hasArg(OPT_disable_delayed_non_primary_function_bodies);
   Opts.EnableTesting |= Args.hasArg(OPT_enable_testing);
 
   Opts.PrintStats |= Args.hasArg(OPT_print_stats);
+  Opts.PrintASTStats |= Args.hasArg(OPT_print_ast_stats);
   Opts.PrintClangStats |= Args.hasArg(OPT_print_clang_stats);
   Opts.DebugTimeFunctionBodies |= Args.hasArg(OPT_debug_time_function_bodies);
+  Opts.DebugTimeFunctions |= Args.hasArg(OPT_debug_time_functions);
+  if (const Arg *A = Args.getLastArg(OPT_debug_time_functions_limit)) {
+    unsigned limit;
+    if (StringRef(A->getValue()).getAsInteger(10, limit)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+    Opts.DebugTimeFunctionsLimit = limit;
+  }
+  Opts.DebugTimeExpressionTypeChecking |=
+    Args.hasArg(OPT_debug_time_expression_type_checking);
 
   Opts.PlaygroundTransform |= Args.hasArg(OPT_playground);
   if (Args.hasArg(OPT_disable_playground_transform))
@@ -147,7 +164,12 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     if (A->getOption().matches(OPT_INPUT)) {
       Opts.InputFilenames.push_back(A->getValue());
     } else if (A->getOption().matches(OPT_primary_file)) {
-      Opts.PrimaryInput = SelectedInput(Opts.InputFilenames.size());
+      // Every -primary-file after the first puts the frontend in batch mode.
+      SelectedInput Primary(Opts.InputFilenames.size());
+      if (Opts.PrimaryInput.hasValue())
+        Opts.AdditionalPrimaryInputs.push_back(Primary);
+      else
+        Opts.PrimaryInput = Primary;
       Opts.InputFilenames.push_back(A->getValue());
     } else {
       llvm_unreachable("Unknown input-related argument!");
@@ -193,6 +215,8 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Action = FrontendOptions::REPL;
     } else if (Opt.matches(OPT_interpret)) {
       Action = FrontendOptions::Immediate;
+    } else if (Opt.matches(OPT_load_imported_modules)) {
+      Action = FrontendOptions::LoadImportedModules;
     } else {
       llvm_unreachable("Unhandled mode option");
     }
@@ -240,6 +264,8 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Diags.diagnose(SourceLoc(), diag::error_repl_requires_no_input_files);
       return true;
     }
+  } else if (Opts.RequestedAction == FrontendOptions::LoadImportedModules) {
+    // The modules to load are given by options, not by input files.
   } else if (TreatAsSIL && Opts.PrimaryInput.hasValue()) {
     // If we have the SIL as our primary input, we can waive the one file
     // requirement as long as all the other inputs are SIBs.
@@ -276,6 +302,8 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
         Opts.ImmediateArgv.push_back(A->getValue(i));
       }
     }
+    if (const Arg *A = Args.getLastArg(OPT_immediate_cache_path))
+      Opts.ImmediateCachePath = A->getValue();
   }
 
   if (TreatAsSIL)
@@ -291,6 +319,61 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
 
   Opts.OutputFilenames = Args.getAllArgValues(OPT_o);
 
+  if (Opts.isBatchMode()) {
+    switch (Opts.RequestedAction) {
+    case FrontendOptions::Parse:
+    case FrontendOptions::EmitModuleOnly:
+    case FrontendOptions::EmitSILGen:
+    case FrontendOptions::EmitSIL:
+    case FrontendOptions::EmitSIBGen:
+    case FrontendOptions::EmitSIB:
+    case FrontendOptions::EmitIR:
+    case FrontendOptions::EmitBC:
+    case FrontendOptions::EmitAssembly:
+    case FrontendOptions::EmitObject:
+      break;
+    case FrontendOptions::NoneAction:
+    case FrontendOptions::DumpParse:
+    case FrontendOptions::DumpInterfaceHash:
+    case FrontendOptions::DumpAST:
+    case FrontendOptions::PrintAST:
+    case FrontendOptions::DumpTypeRefinementContexts:
+    case FrontendOptions::LoadImportedModules:
+    case FrontendOptions::Immediate:
+    case FrontendOptions::REPL:
+      Diags.diagnose(SourceLoc(), diag::error_mode_cannot_batch);
+      return true;
+    }
+
+    // Each primary input needs its own, explicitly specified, main output.
+    unsigned NumPrimaries = Opts.getNumPrimaryInputs();
+    if (Opts.actionHasOutput() && Opts.OutputFilenames.size() != NumPrimaries) {
+      Diags.diagnose(SourceLoc(), diag::error_batch_output_count,
+                     "-o", Opts.OutputFilenames.size(), NumPrimaries);
+      return true;
+    }
+
+    auto getBatchPaths = [&](std::vector<std::string> &Paths,
+                             OptSpecifier Opt) -> bool {
+      Paths = Args.getAllArgValues(Opt);
+      if (Paths.empty() || Paths.size() == NumPrimaries)
+        return false;
+      Diags.diagnose(SourceLoc(), diag::error_batch_output_count,
+                     Args.getLastArg(Opt)->getSpelling(), Paths.size(),
+                     NumPrimaries);
+      return true;
+    };
+    if (getBatchPaths(Opts.BatchOutputs.ModuleOutputPaths,
+                      OPT_emit_module_path) ||
+        getBatchPaths(Opts.BatchOutputs.ModuleDocOutputPaths,
+                      OPT_emit_module_doc_path) ||
+        getBatchPaths(Opts.BatchOutputs.DependenciesFilePaths,
+                      OPT_emit_dependencies_path) ||
+        getBatchPaths(Opts.BatchOutputs.ReferenceDependenciesFilePaths,
+                      OPT_emit_reference_dependencies_path))
+      return true;
+  }
+
   bool UserSpecifiedModuleName = false;
   {
     const Arg *A = Args.getLastArg(OPT_module_name);
@@ -338,8 +421,8 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     Opts.ModuleName = ModuleName;
   }
 
-  if (Opts.OutputFilenames.empty() ||
-      llvm::sys::fs::is_directory(Opts.getSingleOutputFilename())) {
+  if (!Opts.isBatchMode() && (Opts.OutputFilenames.empty() ||
+      llvm::sys::fs::is_directory(Opts.getSingleOutputFilename()))) {
     // No output filename was specified, or an output directory was specified.
     // Determine the correct output filename.
 
@@ -380,6 +463,7 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Suffix = SERIALIZED_MODULE_EXTENSION;
       break;
 
+    case FrontendOptions::LoadImportedModules:
     case FrontendOptions::Immediate:
     case FrontendOptions::REPL:
       // These modes have no frontend-generated output.
@@ -519,6 +603,22 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     Opts.FixitsOutputPath = A->getValue();
   }
 
+  if (const Arg *A = Args.getLastArg(OPT_trace_events_path)) {
+    Opts.TraceEventsPath = A->getValue();
+  }
+
+  if (const Arg *A = Args.getLastArg(OPT_module_load_stats_path)) {
+    Opts.ModuleLoadStatsPath = A->getValue();
+  }
+
+  if (const Arg *A = Args.getLastArg(OPT_code_size_report_path)) {
+    Opts.CodeSizeReportPath = A->getValue();
+  }
+
+  if (const Arg *A = Args.getLastArg(OPT_stats_output_dir)) {
+    Opts.StatsOutputDir = A->getValue();
+  }
+
   bool IsSIB =
     Opts.RequestedAction == FrontendOptions::EmitSIB ||
     Opts.RequestedAction == FrontendOptions::EmitSIBGen;
@@ -547,6 +647,7 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     case FrontendOptions::DumpAST:
     case FrontendOptions::PrintAST:
     case FrontendOptions::DumpTypeRefinementContexts:
+    case FrontendOptions::LoadImportedModules:
     case FrontendOptions::Immediate:
     case FrontendOptions::REPL:
       Diags.diagnose(SourceLoc(), diag::error_mode_cannot_emit_dependencies);
@@ -573,6 +674,7 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     case FrontendOptions::DumpAST:
     case FrontendOptions::PrintAST:
     case FrontendOptions::DumpTypeRefinementContexts:
+    case FrontendOptions::LoadImportedModules:
     case FrontendOptions::Immediate:
     case FrontendOptions::REPL:
       Diags.diagnose(SourceLoc(), diag::error_mode_cannot_emit_header);
@@ -601,6 +703,7 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
     case FrontendOptions::DumpAST:
     case FrontendOptions::PrintAST:
     case FrontendOptions::DumpTypeRefinementContexts:
+    case FrontendOptions::LoadImportedModules:
     case FrontendOptions::EmitSILGen:
     case FrontendOptions::Immediate:
     case FrontendOptions::REPL:
@@ -627,6 +730,18 @@ static bool ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
 
   Opts.AlwaysSerializeDebuggingOptions |=
       Args.hasArg(OPT_serialize_debugging_options);
+  for (const Arg *A : make_range(Args.filtered_begin(
+                                   OPT_serialized_path_prefix_map),
+                                 Args.filtered_end())) {
+    StringRef oldPrefix, newPrefix;
+    std::tie(oldPrefix, newPrefix) = StringRef(A->getValue()).split('=');
+    if (oldPrefix.empty() || !StringRef(A->getValue()).count('=')) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+    Opts.SerializedPathPrefixMap.push_back({oldPrefix, newPrefix});
+  }
   Opts.EnableSourceImport |= Args.hasArg(OPT_enable_source_import);
   Opts.ImportUnderlyingModule |= Args.hasArg(OPT_import_underlying_module);
   Opts.SILSerializeAll |= Args.hasArg(OPT_sil_serialize_all);
@@ -738,6 +853,17 @@ static bool ParseLangArgs(LangOptions &Opts, ArgList &Args,
     
     Opts.SolverMemoryThreshold = threshold;
   }
+
+  if (const Arg *A = Args.getLastArg(OPT_solver_expression_time_threshold)) {
+    unsigned threshold;
+    if (StringRef(A->getValue()).getAsInteger(10, threshold)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+
+    Opts.SolverExpressionTimeThreshold = threshold;
+  }
   
   for (const Arg *A : make_range(Args.filtered_begin(OPT_D),
                                  Args.filtered_end())) {
@@ -813,6 +939,7 @@ static bool ParseClangImporterArgs(ClangImporterOptions &Opts,
 
   Opts.OmitNeedlessWords |= Args.hasArg(OPT_enable_omit_needless_words);
   Opts.InferDefaultArguments |= Args.hasArg(OPT_enable_infer_default_arguments);
+  Opts.UseSwiftLookupTables |= Args.hasArg(OPT_enable_swift_name_lookup_tables);
 
   Opts.DumpClangDiagnostics |= Args.hasArg(OPT_dump_clang_diagnostics);
 
@@ -993,8 +1120,21 @@ static bool ParseSILArgs(SILOptions &Opts, ArgList &Args,
   Opts.RemoveRuntimeAsserts |= Args.hasArg(OPT_remove_runtime_asserts);
 
   Opts.EnableARCOptimizations |= !Args.hasArg(OPT_disable_arc_opts);
+  Opts.EnableGuaranteedNormalArguments |=
+    Args.hasArg(OPT_enable_guaranteed_normal_arguments);
   Opts.VerifyAll |= Args.hasArg(OPT_sil_verify_all);
+  Opts.VerifyIncremental |= Args.hasArg(OPT_sil_verify_incremental);
+  if (const Arg *A = Args.getLastArg(OPT_sil_verify_sample_rate)) {
+    unsigned rate;
+    if (StringRef(A->getValue()).getAsInteger(10, rate)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+    Opts.VerifySampleRate = rate;
+  }
   Opts.DebugSerialization |= Args.hasArg(OPT_sil_debug_serialization);
+  Opts.Internalize |= Args.hasArg(OPT_internalize);
   Opts.EmitVerboseSIL |= Args.hasArg(OPT_emit_verbose_sil);
   Opts.PrintInstCounts |= Args.hasArg(OPT_print_inst_counts);
   if (const Arg *A = Args.getLastArg(OPT_external_pass_pipeline_filename))
@@ -1083,10 +1223,13 @@ static bool ParseIRGenArgs(IRGenOptions &Opts, ArgList &Args,
   Opts.DisableLLVMOptzns |= Args.hasArg(OPT_disable_llvm_optzns);
   Opts.DisableLLVMARCOpts |= Args.hasArg(OPT_disable_llvm_arc_opts);
   Opts.DisableLLVMSLPVectorizer |= Args.hasArg(OPT_disable_llvm_slp_vectorizer);
+  Opts.DisableTBAA |= Args.hasArg(OPT_disable_tbaa);
   if (Args.hasArg(OPT_disable_llvm_verify))
     Opts.Verify = false;
 
   Opts.EmitStackPromotionChecks |= Args.hasArg(OPT_stack_promotion_checks);
+  Opts.BalanceParallelPartitions |= Args.hasArg(OPT_balance_irgen_partitions);
+  Opts.IncrementalCodeGen |= Args.hasArg(OPT_incremental_codegen);
   if (const Arg *A = Args.getLastArg(OPT_stack_promotion_limit)) {
     unsigned limit;
     if (StringRef(A->getValue()).getAsInteger(10, limit)) {
@@ -1096,6 +1239,24 @@ static bool ParseIRGenArgs(IRGenOptions &Opts, ArgList &Args,
     }
     Opts.StackPromotionSizeLimit = limit;
   }
+  if (const Arg *A = Args.getLastArg(OPT_outline_value_operations_threshold)) {
+    unsigned threshold;
+    if (StringRef(A->getValue()).getAsInteger(10, threshold)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+    Opts.OutlinedValueOperationThreshold = threshold;
+  }
+  if (const Arg *A = Args.getLastArg(OPT_llvm_codegen_partitions)) {
+    unsigned partitions;
+    if (StringRef(A->getValue()).getAsInteger(10, partitions)) {
+      Diags.diagnose(SourceLoc(), diag::error_invalid_arg_value,
+                     A->getAsString(Args), A->getValue());
+      return true;
+    }
+    Opts.CodeGenPartitions = partitions;
+  }
 
   if (Args.hasArg(OPT_autolink_force_load))
     Opts.ForceLoadSymbolName = Args.getLastArgValue(OPT_module_link_name);
@@ -1126,6 +1287,7 @@ static bool ParseIRGenArgs(IRGenOptions &Opts, ArgList &Args,
   }
 
   Opts.GenerateProfile |= Args.hasArg(OPT_profile_generate);
+  Opts.ProfileCounterPromotion |= Args.hasArg(OPT_profile_counter_promotion);
 
   if (Args.hasArg(OPT_embed_bitcode))
     Opts.EmbedMode = IRGenEmbedMode::EmbedBitcode;
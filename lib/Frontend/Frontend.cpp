@@ -23,6 +23,7 @@
 #include "swift/AST/DiagnosticsSema.h"
 #include "swift/AST/Module.h"
 #include "swift/Basic/SourceManager.h"
+#include "swift/Basic/TraceEvents.h"
 #include "swift/Parse/DelayedParsingCallbacks.h"
 #include "swift/Parse/Lexer.h"
 #include "swift/SIL/SILModule.h"
@@ -32,9 +33,47 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include <atomic>
+#include <thread>
 
 using namespace swift;
 
+/// Reads the given input files into \p Buffers, using several threads if
+/// there are many of them. If a file can't be read, its buffer is left null
+/// and the error is stored in \p Errors. Files in \p Skip are not read.
+///
+/// Whole-module and -emit-module jobs can have hundreds of inputs, and
+/// opening and reading them doesn't touch any compiler state.
+static void
+loadInputFiles(ArrayRef<std::string> Files, ArrayRef<bool> Skip,
+               std::vector<std::unique_ptr<llvm::MemoryBuffer>> &Buffers,
+               std::vector<std::error_code> &Errors) {
+  Buffers.resize(Files.size());
+  Errors.resize(Files.size());
+
+  std::atomic<size_t> NextIndex(0);
+  auto LoadPendingInputs = [&] {
+    for (size_t i = NextIndex++; i < Files.size(); i = NextIndex++) {
+      if (Skip[i])
+        continue;
+      auto FileOrErr = llvm::MemoryBuffer::getFileOrSTDIN(Files[i]);
+      if (FileOrErr)
+        Buffers[i] = std::move(FileOrErr.get());
+      else
+        Errors[i] = FileOrErr.getError();
+    }
+  };
+
+  size_t NumThreads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                       Files.size() / 8);
+  std::vector<std::thread> Threads;
+  for (size_t i = 1; i < NumThreads; ++i)
+    Threads.emplace_back(LoadPendingInputs);
+  LoadPendingInputs();
+  for (std::thread &Thread : Threads)
+    Thread.join();
+}
+
 void CompilerInstance::createSILModule(bool WholeModule) {
   assert(MainModule && "main module not created yet");
   TheSILModule = SILModule::createEmptyModule(getMainModule(),
@@ -42,14 +81,46 @@ void CompilerInstance::createSILModule(bool WholeModule) {
                                               WholeModule);
 }
 
-void CompilerInstance::setPrimarySourceFile(SourceFile *SF) {
+void CompilerInstance::setPrimarySourceFile(SourceFile *SF,
+                                            unsigned PrimaryIndex) {
   assert(SF);
   assert(MainModule && "main module not created yet");
-  assert(!PrimarySourceFile && "already has a primary source file");
+  if (PrimarySourceFiles.size() <= PrimaryIndex)
+    PrimarySourceFiles.resize(PrimaryIndex + 1);
+  assert(!PrimarySourceFiles[PrimaryIndex] &&
+         "already has a primary source file");
   assert(PrimaryBufferID == NO_SUCH_BUFFER || !SF->getBufferID().hasValue() ||
-         SF->getBufferID().getValue() == PrimaryBufferID);
-  PrimarySourceFile = SF;
-  PrimarySourceFile->setReferencedNameTracker(NameTracker);
+         getPrimaryIndex(SF->getBufferID().getValue()).getValueOr(~0U) ==
+           PrimaryIndex);
+  PrimarySourceFiles[PrimaryIndex] = SF;
+  if (PrimaryIndex < NameTrackers.size())
+    SF->setReferencedNameTracker(NameTrackers[PrimaryIndex]);
+}
+
+Optional<unsigned> CompilerInstance::getPrimaryIndex(unsigned BufferID) const {
+  if (PrimaryBufferID == NO_SUCH_BUFFER)
+    return None;
+  if (BufferID == PrimaryBufferID)
+    return 0;
+  auto I = std::find(AdditionalPrimaryBufferIDs.begin(),
+                     AdditionalPrimaryBufferIDs.end(), BufferID);
+  if (I == AdditionalPrimaryBufferIDs.end())
+    return None;
+  return 1 + (I - AdditionalPrimaryBufferIDs.begin());
+}
+
+void CompilerInstance::recordPrimaryBuffer(unsigned InputIndex,
+                                           SelectedInput::InputKind Kind,
+                                           unsigned BufferID) {
+  const FrontendOptions &Opts = Invocation.getFrontendOptions();
+  auto matches = [&](const SelectedInput &Input) {
+    return Input.Kind == Kind && Input.Index == InputIndex;
+  };
+  if (Opts.PrimaryInput && matches(*Opts.PrimaryInput))
+    PrimaryBufferID = BufferID;
+  for (unsigned i = 0, e = Opts.AdditionalPrimaryInputs.size(); i != e; ++i)
+    if (matches(Opts.AdditionalPrimaryInputs[i]))
+      AdditionalPrimaryBufferIDs[i] = BufferID;
 }
 
 bool CompilerInstance::setup(const CompilerInvocation &Invok) {
@@ -86,6 +157,8 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
   }
   
   auto SML = SerializedModuleLoader::create(*Context, DepTracker);
+  if (!Invocation.getFrontendOptions().ModuleLoadStatsPath.empty())
+    SML->enableStatistics();
   this->SML = SML.get();
   Context->addModuleLoader(std::move(SML));
 
@@ -121,8 +194,9 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
   if (SILMode)
     Invocation.getLangOptions().EnableAccessControl = false;
 
-  const Optional<SelectedInput> &PrimaryInput =
-    Invocation.getFrontendOptions().PrimaryInput;
+  AdditionalPrimaryBufferIDs.assign(
+    Invocation.getFrontendOptions().AdditionalPrimaryInputs.size(),
+    NO_SUCH_BUFFER);
 
   // Add the memory buffers first, these will be associated with a filename
   // and they can replace the contents of an input filename.
@@ -141,13 +215,22 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
       if (SILMode)
         MainBufferID = BufferID;
 
-      if (PrimaryInput && PrimaryInput->isBuffer() && PrimaryInput->Index == i)
-        PrimaryBufferID = BufferID;
+      recordPrimaryBuffer(i, SelectedInput::InputKind::Buffer, BufferID);
     }
   }
 
-  for (unsigned i = 0, e = Invocation.getInputFilenames().size(); i != e; ++i) {
-    auto &File = Invocation.getInputFilenames()[i];
+  // Files that were replaced by a memory buffer don't need to be read.
+  const auto &InputFilenames = Invocation.getInputFilenames();
+  SmallVector<bool, 32> ReplacedByBuffer;
+  for (auto &File : InputFilenames)
+    ReplacedByBuffer.push_back(
+        SourceMgr.getIDForBufferIdentifier(File).hasValue());
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> InputBuffers;
+  std::vector<std::error_code> InputErrors;
+  loadInputFiles(InputFilenames, ReplacedByBuffer, InputBuffers, InputErrors);
+
+  for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i) {
+    auto &File = InputFilenames[i];
 
     // FIXME: Working with filenames is fragile, maybe use the real path
     // or have some kind of FileManager.
@@ -157,26 +240,24 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
       if (SILMode || (MainMode && filename(File) == "main.swift"))
         MainBufferID = ExistingBufferID.getValue();
 
-      if (PrimaryInput && PrimaryInput->isFilename() &&
-          PrimaryInput->Index == i)
-        PrimaryBufferID = ExistingBufferID.getValue();
+      recordPrimaryBuffer(i, SelectedInput::InputKind::Filename,
+                          ExistingBufferID.getValue());
 
       continue; // replaced by a memory buffer.
     }
 
-    // Open the input file.
-    using FileOrError = llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>;
-    FileOrError InputFileOrErr = llvm::MemoryBuffer::getFileOrSTDIN(File);
-    if (!InputFileOrErr) {
+    std::unique_ptr<llvm::MemoryBuffer> &InputFile = InputBuffers[i];
+    if (!InputFile) {
       Diagnostics.diagnose(SourceLoc(), diag::error_open_input_file,
-                           File, InputFileOrErr.getError().message());
+                           File, InputErrors[i].message());
       return true;
     }
 
-    if (serialization::isSerializedAST(InputFileOrErr.get()->getBuffer())) {
+    if (serialization::isSerializedAST(InputFile->getBuffer())) {
       llvm::SmallString<128> ModuleDocFilePath(File);
       llvm::sys::path::replace_extension(ModuleDocFilePath,
                                          SERIALIZED_MODULE_DOC_EXTENSION);
+      using FileOrError = llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>;
       FileOrError ModuleDocOrErr =
         llvm::MemoryBuffer::getFileOrSTDIN(ModuleDocFilePath.str());
       if (!ModuleDocOrErr &&
@@ -185,7 +266,7 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
                              File, ModuleDocOrErr.getError().message());
         return true;
       }
-      PartialModules.push_back({ std::move(InputFileOrErr.get()),
+      PartialModules.push_back({ std::move(InputFile),
                                  ModuleDocOrErr? std::move(ModuleDocOrErr.get())
                                                : nullptr });
       continue;
@@ -193,15 +274,14 @@ bool CompilerInstance::setup(const CompilerInvocation &Invok) {
 
     // Transfer ownership of the MemoryBuffer to the SourceMgr.
     unsigned BufferID =
-      SourceMgr.addNewSourceBuffer(std::move(InputFileOrErr.get()));
+      SourceMgr.addNewSourceBuffer(std::move(InputFile));
 
     BufferIDs.push_back(BufferID);
 
     if (SILMode || (MainMode && filename(File) == "main.swift"))
       MainBufferID = BufferID;
 
-    if (PrimaryInput && PrimaryInput->isFilename() && PrimaryInput->Index == i)
-      PrimaryBufferID = BufferID;
+    recordPrimaryBuffer(i, SelectedInput::InputKind::Filename, BufferID);
   }
 
   // Set the primary file to the code-completion point if one exists.
@@ -224,6 +304,22 @@ Module *CompilerInstance::getMainModule() {
   return MainModule;
 }
 
+/// Returns the type checking options which the frontend options request.
+static OptionSet<TypeCheckingFlags>
+getTypeCheckingOptions(const FrontendOptions &Opts) {
+  OptionSet<TypeCheckingFlags> TypeCheckOptions;
+  if (Opts.DebugTimeFunctionBodies) {
+    TypeCheckOptions |= TypeCheckingFlags::DebugTimeFunctionBodies;
+  }
+  if (Opts.DebugTimeExpressionTypeChecking) {
+    TypeCheckOptions |= TypeCheckingFlags::DebugTimeExpressionTypeChecking;
+  }
+  if (Opts.actionIsImmediate()) {
+    TypeCheckOptions |= TypeCheckingFlags::ForImmediateMode;
+  }
+  return TypeCheckOptions;
+}
+
 void CompilerInstance::performSema() {
   const FrontendOptions &options = Invocation.getFrontendOptions();
   const InputFileKind Kind = Invocation.getInputKind();
@@ -355,7 +451,24 @@ void CompilerInstance::performSema() {
     DelayedCB.reset(new AlwaysDelayedCallbacks);
   }
 
-  PersistentParserState PersistentState;
+  // Bodies in files other than the primary files are never type-checked, so
+  // when only the primary files are compiled they're either skipped entirely
+  // or just brace-matched and parsed later if something needs them.
+  std::unique_ptr<DelayedParsingCallbacks> SecondaryCB;
+  if (PrimaryBufferID != NO_SUCH_BUFFER && !DelayedCB) {
+    const FrontendOptions &FrontendOpts = Invocation.getFrontendOptions();
+    if (FrontendOpts.SkipNonPrimaryFunctionBodies)
+      SecondaryCB.reset(new SkipFunctionBodiesCallbacks);
+    else if (FrontendOpts.DelayNonPrimaryFunctionBodies)
+      SecondaryCB.reset(new AlwaysDelayedCallbacks);
+  }
+  auto getDelayedCallbacks = [&](unsigned BufferID) {
+    if (SecondaryCB && !getPrimaryIndex(BufferID))
+      return SecondaryCB.get();
+    return DelayedCB.get();
+  };
+
+  PersistentState.reset(new PersistentParserState());
 
   // Make sure the main file is the first file in the module. This may only be
   // a source file, or it may be a SIL file, which requires pumping the parser.
@@ -373,8 +486,8 @@ void CompilerInstance::performSema() {
     MainModule->addFile(*MainFile);
     addAdditionalInitialImports(MainFile);
 
-    if (MainBufferID == PrimaryBufferID)
-      setPrimarySourceFile(MainFile);
+    if (auto PrimaryIndex = getPrimaryIndex(MainBufferID))
+      setPrimarySourceFile(MainFile, *PrimaryIndex);
   }
 
   bool hadLoadError = false;
@@ -388,29 +501,33 @@ void CompilerInstance::performSema() {
   }
 
   // Then parse all the library files.
-  for (auto BufferID : BufferIDs) {
-    if (BufferID == MainBufferID)
-      continue;
-
-    auto *NextInput = new (*Context) SourceFile(*MainModule,
-                                                SourceFileKind::Library,
-                                                BufferID,
-                                                modImpKind);
-    MainModule->addFile(*NextInput);
-    addAdditionalInitialImports(NextInput);
-
-    if (BufferID == PrimaryBufferID)
-      setPrimarySourceFile(NextInput);
-
-    bool Done;
-    do {
-      // Parser may stop at some erroneous constructions like #else, #endif
-      // or '}' in some cases, continue parsing until we are done
-      parseIntoSourceFile(*NextInput, BufferID, &Done, nullptr,
-                          &PersistentState, DelayedCB.get());
-    } while (!Done);
-
-    performNameBinding(*NextInput);
+  {
+    TraceEventScope TraceParse("Parse", "frontend");
+    for (auto BufferID : BufferIDs) {
+      if (BufferID == MainBufferID)
+        continue;
+
+      auto *NextInput = new (*Context) SourceFile(*MainModule,
+                                                  SourceFileKind::Library,
+                                                  BufferID,
+                                                  modImpKind);
+      MainModule->addFile(*NextInput);
+      addAdditionalInitialImports(NextInput);
+
+      if (auto PrimaryIndex = getPrimaryIndex(BufferID))
+        setPrimarySourceFile(NextInput, *PrimaryIndex);
+
+      bool Done;
+      do {
+        // Parser may stop at some erroneous constructions like #else, #endif
+        // or '}' in some cases, continue parsing until we are done
+        parseIntoSourceFile(*NextInput, BufferID, &Done, nullptr,
+                            PersistentState.get(),
+                            getDelayedCallbacks(BufferID));
+      } while (!Done);
+
+      performNameBinding(*NextInput);
+    }
   }
 
   if (Invocation.isCodeCompletion()) {
@@ -425,21 +542,21 @@ void CompilerInstance::performSema() {
     return;
 
   // Compute the options we want to use for type checking.
-  OptionSet<TypeCheckingFlags> TypeCheckOptions;
+  OptionSet<TypeCheckingFlags> TypeCheckOptions =
+    getTypeCheckingOptions(Invocation.getFrontendOptions());
   if (PrimaryBufferID == NO_SUCH_BUFFER) {
     TypeCheckOptions |= TypeCheckingFlags::DelayWholeModuleChecking;
   }
-  if (Invocation.getFrontendOptions().DebugTimeFunctionBodies) {
-    TypeCheckOptions |= TypeCheckingFlags::DebugTimeFunctionBodies;
-  }
-  if (Invocation.getFrontendOptions().actionIsImmediate()) {
-    TypeCheckOptions |= TypeCheckingFlags::ForImmediateMode;
-  }
+
+  // The main file is parsed and type-checked piece by piece, so its parsing is
+  // counted as type checking.
+  TraceEventScope TraceTypeCheck("Type-check", "frontend");
 
   // Parse the main file last.
   if (MainBufferID != NO_SUCH_BUFFER) {
     bool mainIsPrimary =
-      (PrimaryBufferID == NO_SUCH_BUFFER || MainBufferID == PrimaryBufferID);
+      (PrimaryBufferID == NO_SUCH_BUFFER ||
+       getPrimaryIndex(MainBufferID).hasValue());
 
     SourceFile &MainFile =
       MainModule->getMainSourceFile(Invocation.getSourceFileKind());
@@ -453,9 +570,10 @@ void CompilerInstance::performSema() {
       // with 'sil' definitions.
       parseIntoSourceFile(MainFile, MainFile.getBufferID().getValue(), &Done,
                           TheSILModule ? &SILContext : nullptr,
-                          &PersistentState, DelayedCB.get());
+                          PersistentState.get(),
+                          getDelayedCallbacks(MainBufferID));
       if (mainIsPrimary) {
-        performTypeChecking(MainFile, PersistentState.getTopLevelContext(),
+        performTypeChecking(MainFile, PersistentState->getTopLevelContext(),
                             TypeCheckOptions, CurTUElem);
       }
       CurTUElem = MainFile.Decls.size();
@@ -471,8 +589,9 @@ void CompilerInstance::performSema() {
   // Type-check each top-level input besides the main source file.
   for (auto File : MainModule->getFiles())
     if (auto SF = dyn_cast<SourceFile>(File))
-      if (PrimaryBufferID == NO_SUCH_BUFFER || SF == PrimarySourceFile)
-        performTypeChecking(*SF, PersistentState.getTopLevelContext(),
+      if (PrimaryBufferID == NO_SUCH_BUFFER ||
+          std::count(PrimarySourceFiles.begin(), PrimarySourceFiles.end(), SF))
+        performTypeChecking(*SF, PersistentState->getTopLevelContext(),
                             TypeCheckOptions);
 
   // Even if there were no source files, we should still record known
@@ -481,7 +600,7 @@ void CompilerInstance::performSema() {
     Context->recordKnownProtocols(stdlib);
 
   if (DelayedCB) {
-    performDelayedParsing(MainModule, PersistentState,
+    performDelayedParsing(MainModule, *PersistentState,
                           Invocation.getCodeCompletionFactory());
   }
 
@@ -493,6 +612,27 @@ void CompilerInstance::performSema() {
   }
 }
 
+void CompilerInstance::parseDelayedFunctionBody(AbstractFunctionDecl *AFD) {
+  if (PersistentState)
+    swift::parseDelayedFunctionBody(AFD, *PersistentState);
+}
+
+void CompilerInstance::typeCheckAdditionalPrimaryFile(SourceFile &SF) {
+  assert(PersistentState && "must be called after performSema()");
+  assert(PrimaryBufferID != NO_SUCH_BUFFER &&
+         "all files are type-checked without a primary file");
+  assert(SF.getBufferID().hasValue() && "not an input source file");
+  unsigned BufferID = SF.getBufferID().getValue();
+  assert(!getPrimaryIndex(BufferID) && "already a primary file");
+
+  AdditionalPrimaryBufferIDs.push_back(BufferID);
+  setPrimarySourceFile(&SF, AdditionalPrimaryBufferIDs.size());
+
+  performDelayedParsing(&SF, *PersistentState, nullptr);
+  performTypeChecking(SF, PersistentState->getTopLevelContext(),
+                      getTypeCheckingOptions(Invocation.getFrontendOptions()));
+}
+
 void CompilerInstance::performParseOnly() {
   const InputFileKind Kind = Invocation.getInputKind();
   Module *MainModule = getMainModule();
@@ -509,7 +649,7 @@ void CompilerInstance::performParseOnly() {
                                           BufferIDs[0],
                                     SourceFile::ImplicitModuleImportKind::None);
   MainModule->addFile(*Input);
-  setPrimarySourceFile(Input);
+  setPrimarySourceFile(Input, 0);
 
   PersistentParserState PersistentState;
   bool Done;
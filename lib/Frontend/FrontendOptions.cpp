@@ -25,6 +25,7 @@ bool FrontendOptions::actionHasOutput() const {
   case DumpInterfaceHash:
   case PrintAST:
   case DumpTypeRefinementContexts:
+  case LoadImportedModules:
     return false;
   case EmitSILGen:
   case EmitSIL:
@@ -53,6 +54,7 @@ bool FrontendOptions::actionIsImmediate() const {
   case DumpInterfaceHash:
   case PrintAST:
   case DumpTypeRefinementContexts:
+  case LoadImportedModules:
   case EmitSILGen:
   case EmitSIL:
   case EmitSIBGen:
@@ -88,3 +90,27 @@ void FrontendOptions::forAllOutputPaths(
       fn(*next);
   }
 }
+
+FrontendOptions
+FrontendOptions::getOptionsForBatchPrimary(unsigned PrimaryIndex) const {
+  assert(PrimaryIndex < getNumPrimaryInputs() && "primary input out of range");
+  FrontendOptions Result = *this;
+  Result.AdditionalPrimaryInputs.clear();
+  Result.BatchOutputs = BatchOutputPaths();
+  if (PrimaryIndex != 0)
+    Result.PrimaryInput = AdditionalPrimaryInputs[PrimaryIndex - 1];
+  if (OutputFilenames.size() == getNumPrimaryInputs())
+    Result.setSingleOutputFilename(OutputFilenames[PrimaryIndex]);
+
+  auto select = [PrimaryIndex](std::string &Output,
+                               const std::vector<std::string> &Paths) {
+    if (!Paths.empty())
+      Output = Paths[PrimaryIndex];
+  };
+  select(Result.ModuleOutputPath, BatchOutputs.ModuleOutputPaths);
+  select(Result.ModuleDocOutputPath, BatchOutputs.ModuleDocOutputPaths);
+  select(Result.DependenciesFilePath, BatchOutputs.DependenciesFilePaths);
+  select(Result.ReferenceDependenciesFilePath,
+         BatchOutputs.ReferenceDependenciesFilePaths);
+  return Result;
+}
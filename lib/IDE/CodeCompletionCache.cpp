@@ -2,6 +2,7 @@
 #include "swift/Basic/Cache.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -90,12 +91,6 @@ CodeCompletionCache::~CodeCompletionCache() {}
 /// cached results. This isn't expected to change very often.
 static constexpr uint32_t onDiskCompletionCacheVersion = 0;
 
-static StringRef copyString(llvm::BumpPtrAllocator &Allocator, StringRef Str) {
-  char *Mem = Allocator.Allocate<char>(Str.size());
-  std::copy(Str.begin(), Str.end(), Mem);
-  return StringRef(Mem, Str.size());
-}
-
 static ArrayRef<StringRef> copyStringArray(llvm::BumpPtrAllocator &Allocator,
                                            ArrayRef<StringRef> Arr) {
   StringRef *Buff = Allocator.Allocate<StringRef>(Arr.size());
@@ -158,16 +153,22 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
   const char *strings = chunks + chunkSize;
   auto stringCount = read32le(strings);
   assert(strings + stringCount == end && "incorrect file size");
-  (void)stringCount; // so it is not seen as "unused" in release builds.
-  
+
   // STRINGS
+  // Copy the whole section into the sink's allocator at once, and hand out
+  // references into it, rather than allocating each string separately.
+  char *stringsCopy = V.Sink.Allocator->Allocate<char>(stringCount);
+  memcpy(stringsCopy, strings, stringCount);
+  strings = stringsCopy;
+
   auto getString = [&](uint32_t index) -> StringRef {
     if (index == ~0u)
       return "";
 
     const char *p = strings + index;
-    auto size = read32le(p);
-    return copyString(*V.Sink.Allocator, StringRef(p, size));
+    auto size = llvm::support::endian::read32le(p);
+    p += sizeof(size);
+    return StringRef(p, size);
   };
 
   // CHUNKS
@@ -270,6 +271,9 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
 ///
 ///   STRINGS
 ///     * A blob of length-prefixed strings referred to in CHUNKS or RESULTS.
+///     * Chunk texts, module names and brief doc comments are uniqued. The
+///       associated USRs and decl keywords of a result are stored
+///       consecutively and so are never uniqued.
 static void writeCachedModule(llvm::raw_ostream &out,
                               const CodeCompletionCache::Key &K,
                               CodeCompletionCache::Value &V) {
@@ -318,6 +322,16 @@ static void writeCachedModule(llvm::raw_ostream &out,
     return static_cast<uint32_t>(size);
   };
 
+  llvm::StringMap<uint32_t> uniquedStrings;
+  auto addUniquedString = [&](StringRef str) {
+    if (str.empty())
+      return ~0u;
+    auto &index = uniquedStrings[str];
+    if (!index)
+      index = addString(str) + 1;
+    return index - 1;
+  };
+
   auto addCompletionString = [&](const CodeCompletionString *str) {
     auto size = chunks.tell();
     chunksLE.write(static_cast<uint32_t>(str->getChunks().size()));
@@ -326,7 +340,7 @@ static void writeCachedModule(llvm::raw_ostream &out,
       chunksLE.write(static_cast<uint8_t>(chunk.getNestingLevel()));
       chunksLE.write(static_cast<uint8_t>(chunk.isAnnotation()));
       if (chunk.hasText()) {
-        chunksLE.write(addString(chunk.getText()));
+        chunksLE.write(addUniquedString(chunk.getText()));
       } else {
         chunksLE.write(static_cast<uint32_t>(~0u));
       }
@@ -349,8 +363,8 @@ static void writeCachedModule(llvm::raw_ostream &out,
       LE.write(static_cast<uint8_t>(R->getNumBytesToErase()));
       LE.write(
           static_cast<uint32_t>(addCompletionString(R->getCompletionString())));
-      LE.write(addString(R->getModuleName()));      // index into strings
-      LE.write(addString(R->getBriefDocComment())); // index into strings
+      LE.write(addUniquedString(R->getModuleName()));      // index into strings
+      LE.write(addUniquedString(R->getBriefDocComment())); // index into strings
       LE.write(static_cast<uint32_t>(R->getAssociatedUSRs().size()));
       if (R->getAssociatedUSRs().empty()) {
         LE.write(static_cast<uint32_t>(~0u));
@@ -130,8 +130,72 @@ FailableCastResult irgen::emitClassIdenticalCast(IRGenFunction &IGF,
 }
 
 /// Emit a checked unconditional downcast of a class value.
+/// Returns true if a cast of an object of type \p fromType to \p destClass can
+/// be decided by comparing the object's isa pointer with the class metadata.
+static bool canCompareIsaForCast(IRGenModule &IGM, SILType fromType,
+                                 ClassDecl *destClass) {
+  if (!fromType)
+    return false;
+  // The isa pointer can only be loaded if the object is not a tagged pointer.
+  auto fromClass = fromType.getSwiftRValueType().getClassOrBoundGenericClass();
+  if (!fromClass || !isKnownNotTaggedPointer(IGM, fromClass))
+    return false;
+  // Only an instance of the class itself can be cast to a class without
+  // subclasses.
+  return IGM.isLeafClass(destClass);
+}
+
+/// Emit a cast to a class without subclasses as a comparison of the object's
+/// isa pointer with \p metadataRef. \p object is the object with its own
+/// type, and \p from is the object as an i8*. The runtime is only called if
+/// the pointers differ and the object could still be an instance of the
+/// class, because the Objective-C runtime may have replaced its isa pointer.
+static llvm::Value *emitClassDowncastByIsaCompare(IRGenFunction &IGF,
+                                                  llvm::Value *object,
+                                                  llvm::Value *from,
+                                                  SILType fromType,
+                                                  llvm::Value *metadataRef,
+                                                  llvm::Constant *castFn,
+                                                  CheckedCastMode mode) {
+  auto &IGM = IGF.IGM;
+  llvm::Value *isa =
+    emitHeapMetadataRefForHeapObject(IGF, object, fromType,
+                                     /*suppressCast*/ true);
+  isa = IGF.Builder.CreateBitCast(isa, IGM.Int8PtrTy);
+
+  auto isMatch = IGF.Builder.CreateICmpEQ(isa, metadataRef);
+  auto origBB = IGF.Builder.GetInsertBlock();
+  auto slowBB = IGF.createBasicBlock("cast.slow");
+  auto contBB = IGF.createBasicBlock("cast.cont");
+  IGF.Builder.CreateCondBr(isMatch, contBB, slowBB);
+
+  // Without the Objective-C runtime, a different isa pointer means that the
+  // object is not an instance, so a conditional cast just fails. An
+  // unconditional cast still calls the runtime to report the failure.
+  IGF.Builder.emitBlock(slowBB);
+  llvm::Value *slowResult;
+  if (mode == CheckedCastMode::Conditional && !IGM.ObjCInterop) {
+    slowResult = llvm::ConstantPointerNull::get(IGM.Int8PtrTy);
+  } else {
+    auto call = IGF.Builder.CreateCall(castFn, {from, metadataRef});
+    call->setDoesNotThrow();
+    slowResult = call;
+  }
+  auto slowEndBB = IGF.Builder.GetInsertBlock();
+  IGF.Builder.CreateBr(contBB);
+
+  IGF.Builder.emitBlock(contBB);
+  auto phi = IGF.Builder.CreatePHI(IGM.Int8PtrTy, 2);
+  phi->addIncoming(from, origBB);
+  phi->addIncoming(slowResult, slowEndBB);
+  return phi;
+}
+
 llvm::Value *irgen::emitClassDowncast(IRGenFunction &IGF, llvm::Value *from,
-                                      SILType toType, CheckedCastMode mode) {
+                                      SILType toType, CheckedCastMode mode,
+                                      SILType fromType) {
+  llvm::Value *object = from;
+
   // Emit the value we're casting from.
   if (from->getType() != IGF.IGM.Int8PtrTy)
     from = IGF.Builder.CreateBitOrPointerCast(from, IGF.IGM.Int8PtrTy);
@@ -190,13 +254,22 @@ llvm::Value *irgen::emitClassDowncast(IRGenFunction &IGF, llvm::Value *from,
   if (metadataRef->getType() != IGF.IGM.Int8PtrTy)
     metadataRef = IGF.Builder.CreateBitCast(metadataRef, IGF.IGM.Int8PtrTy);
 
+  llvm::Type *subTy = IGF.getTypeInfo(toType).StorageType;
+
+  if (destClass && hasKnownSwiftImplementation(IGF.IGM, destClass) &&
+      canCompareIsaForCast(IGF.IGM, fromType, destClass)) {
+    llvm::Value *result = emitClassDowncastByIsaCompare(IGF, object, from,
+                                                        fromType, metadataRef,
+                                                        castFn, mode);
+    return IGF.Builder.CreateBitCast(result, subTy);
+  }
+
   // Call the (unconditional) dynamic cast.
   auto call
     = IGF.Builder.CreateCall(castFn, {from, metadataRef});
   // FIXME: Eventually, we may want to throw.
   call->setDoesNotThrow();
 
-  llvm::Type *subTy = IGF.getTypeInfo(toType).StorageType;
   return IGF.Builder.CreateBitCast(call, subTy);
 }
 
@@ -50,11 +50,16 @@ namespace irgen {
   /// \brief Convert a class object to the given destination type,
   /// using a runtime-checked cast.
   ///
+  /// If \p fromType, the static type of \p from, is a class type, casts to a
+  /// class without subclasses compare the object's isa pointer inline and
+  /// only call the runtime if it does not match.
+  ///
   /// FIXME: toType should be an AST CanType.
   llvm::Value *emitClassDowncast(IRGenFunction &IGF,
                                  llvm::Value *from,
                                  SILType toType,
-                                 CheckedCastMode mode);
+                                 CheckedCastMode mode,
+                                 SILType fromType = SILType());
 
   /// A result of a cast generation function.
   struct FailableCastResult {
@@ -1848,6 +1848,28 @@ const TypeInfo *TypeConverter::convertClassType(ClassDecl *D) {
                            D, refcount);
 }
 
+bool IRGenModule::isLeafClass(ClassDecl *theClass) {
+  if (theClass->isFinal())
+    return true;
+
+  // Other modules may subclass public classes, and Objective-C code may
+  // subclass any class it can see.
+  if (!SILMod->isWholeModule() ||
+      theClass->getEffectiveAccess() == Accessibility::Public ||
+      theClass->isObjC())
+    return false;
+
+  // Every class defined in the module has a vtable.
+  if (!ComputedSuperclassesInModule) {
+    for (SILVTable &vtable : SILMod->getVTables()) {
+      if (Type superclass = vtable.getClass()->getSuperclass())
+        SuperclassesInModule.insert(superclass->getClassOrBoundGenericClass());
+    }
+    ComputedSuperclassesInModule = true;
+  }
+  return !SuperclassesInModule.count(theClass);
+}
+
 /// Lazily declare a fake-looking class to represent an ObjC runtime base class.
 ClassDecl *IRGenModule::getObjCRuntimeBaseClass(Identifier name) {
   auto found = SwiftRootClasses.find(name);
@@ -960,13 +960,25 @@ static SILLinkage getConformanceLinkage(IRGenModule &IGM,
   }
 }
 
+/// Get SIL-linkage for a symbol which is derived from a declaration or a
+/// type. The public symbols of an internalized module are hidden.
+static SILLinkage getInternalizedSILLinkage(IRGenModule &IGM,
+                                            FormalLinkage linkage,
+                                            ForDefinition_t forDefinition) {
+  SILLinkage result = getSILLinkage(linkage, forDefinition);
+  if (result == SILLinkage::Public && IGM.SILMod->canInternalizeSymbols())
+    return SILLinkage::Hidden;
+  return result;
+}
+
 SILLinkage LinkEntity::getLinkage(IRGenModule &IGM,
                                   ForDefinition_t forDefinition) const {
   switch (getKind()) {
   // Most type metadata depend on the formal linkage of their type.
   case Kind::ValueWitnessTable:
   case Kind::TypeMangling:
-    return getSILLinkage(getTypeLinkage(getType()), forDefinition);
+    return getInternalizedSILLinkage(IGM, getTypeLinkage(getType()),
+                                     forDefinition);
 
   case Kind::TypeMetadata:
     switch (getMetadataAddress()) {
@@ -974,7 +986,8 @@ SILLinkage LinkEntity::getLinkage(IRGenModule &IGM,
       // The full metadata object is private to the containing module.
       return SILLinkage::Private;
     case TypeMetadataAddress::AddressPoint:
-      return getSILLinkage(getTypeLinkage(getType()), forDefinition);
+      return getInternalizedSILLinkage(IGM, getTypeLinkage(getType()),
+                                     forDefinition);
     }
 
   // ...but we don't actually expose individual value witnesses (right now).
@@ -991,7 +1004,8 @@ SILLinkage LinkEntity::getLinkage(IRGenModule &IGM,
     switch (getTypeMetadataAccessStrategy(IGM, getType(),
                                           /*preferDirectAccess=*/false)) {
     case MetadataAccessStrategy::PublicUniqueAccessor:
-      return getSILLinkage(FormalLinkage::PublicUnique, forDefinition);
+      return getInternalizedSILLinkage(IGM, FormalLinkage::PublicUnique,
+                                       forDefinition);
     case MetadataAccessStrategy::HiddenUniqueAccessor:
       return getSILLinkage(FormalLinkage::HiddenUnique, forDefinition);
     case MetadataAccessStrategy::PrivateAccessor:
@@ -1012,7 +1026,8 @@ SILLinkage LinkEntity::getLinkage(IRGenModule &IGM,
   case Kind::FieldOffset:
   case Kind::NominalTypeDescriptor:
   case Kind::ProtocolDescriptor:
-    return getSILLinkage(getDeclLinkage(getDecl()), forDefinition);
+    return getInternalizedSILLinkage(IGM, getDeclLinkage(getDecl()),
+                                     forDefinition);
 
   case Kind::DirectProtocolWitnessTable:
   case Kind::ProtocolWitnessTableAccessFunction:
@@ -1162,7 +1177,7 @@ LinkInfo LinkInfo::get(IRGenModule &IGM, const LinkEntity &entity,
                        ForDefinition_t isDefinition) {
   LinkInfo result;
 
-  entity.mangle(result.Name);
+  result.Name = IGM.getMangledName(entity);
 
   std::tie(result.Linkage, result.Visibility) =
     getIRLinkage(IGM, entity.getLinkage(IGM, isDefinition),
@@ -1175,6 +1190,19 @@ LinkInfo LinkInfo::get(IRGenModule &IGM, const LinkEntity &entity,
   return result;
 }
 
+StringRef IRGenModule::getMangledName(const LinkEntity &entity) {
+  auto &name = MangledNames[entity];
+  if (name.data())
+    return name;
+
+  llvm::SmallString<128> buffer;
+  entity.mangle(buffer);
+  char *copy = MangledNameAllocator.Allocate<char>(buffer.size());
+  std::copy(buffer.begin(), buffer.end(), copy);
+  name = StringRef(copy, buffer.size());
+  return name;
+}
+
 static bool isPointerTo(llvm::Type *ptrTy, llvm::Type *objTy) {
   return cast<llvm::PointerType>(ptrTy)->getElementType() == objTy;
 }
@@ -1513,6 +1541,10 @@ llvm::Function *IRGenModule::getAddrOfSILFunction(SILFunction *f,
     attrs = attrs.addAttribute(fnType->getContext(),
                 llvm::AttributeSet::FunctionIndex, llvm::Attribute::NoInline);
   }
+  if (f->hasSemanticsString("cold")) {
+    attrs = attrs.addAttribute(fnType->getContext(),
+                llvm::AttributeSet::FunctionIndex, llvm::Attribute::Cold);
+  }
   if (isReadOnlyFunction(f)) {
     attrs = attrs.addAttribute(fnType->getContext(),
                 llvm::AttributeSet::FunctionIndex, llvm::Attribute::ReadOnly);
@@ -1709,9 +1741,8 @@ IRGenModule::getAddrOfLLVMVariableOrGOTEquivalent(LinkEntity entity,
   auto global = cast<llvm::GlobalValue>(GlobalVars[entity]);
   // Use it as the initializer for an anonymous constant. LLVM can treat this as
   // equivalent to the global's GOT entry.
-  llvm::SmallString<64> name;
-  entity.mangle(name);
-  auto gotEquivalent = createGOTEquivalent(*this, global, name);
+  auto gotEquivalent = createGOTEquivalent(*this, global,
+                                           getMangledName(entity));
   gotEntry = gotEquivalent;
   return {gotEquivalent, DirectOrGOT::GOT};
 }
@@ -2721,3 +2752,119 @@ IRGenModule::getOrCreateHelperFunction(StringRef fnName, llvm::Type *resultTy,
   return fn;
 }
 
+static StringRef getOutlinedValueOperationName(OutlinedValueOperation op) {
+  switch (op) {
+  case OutlinedValueOperation::Retain: return "retain";
+  case OutlinedValueOperation::Release: return "release";
+  case OutlinedValueOperation::Destroy: return "destroy";
+  case OutlinedValueOperation::InitializeWithCopy: return "initializeWithCopy";
+  case OutlinedValueOperation::AssignWithCopy: return "assignWithCopy";
+  }
+  llvm_unreachable("bad value operation");
+}
+
+/// Emit the body of an outlined value operation, which is the same code
+/// the operation would expand to inline.
+static void emitOutlinedValueOperation(IRGenFunction &IGF,
+                                       OutlinedValueOperation op,
+                                       SILType T, const TypeInfo &ti) {
+  Explosion params = IGF.collectParameters();
+  switch (op) {
+  case OutlinedValueOperation::Retain: {
+    Explosion out;
+    cast<LoadableTypeInfo>(ti).copy(IGF, params, out);
+    out.claimAll();
+    break;
+  }
+  case OutlinedValueOperation::Release:
+    cast<LoadableTypeInfo>(ti).consume(IGF, params);
+    break;
+  case OutlinedValueOperation::Destroy:
+    ti.destroy(IGF, ti.getAddressForPointer(params.claimNext()), T);
+    break;
+  case OutlinedValueOperation::InitializeWithCopy: {
+    Address dest = ti.getAddressForPointer(params.claimNext());
+    Address src = ti.getAddressForPointer(params.claimNext());
+    ti.initializeWithCopy(IGF, dest, src, T);
+    break;
+  }
+  case OutlinedValueOperation::AssignWithCopy: {
+    Address dest = ti.getAddressForPointer(params.claimNext());
+    Address src = ti.getAddressForPointer(params.claimNext());
+    ti.assignWithCopy(IGF, dest, src, T);
+    break;
+  }
+  }
+  IGF.Builder.CreateRetVoid();
+}
+
+/// Get the helper function which performs the given copy or destroy on a
+/// value of type \p T, or null if the operation should be emitted inline
+/// because its expansion is not bigger than a call.
+///
+/// A retain or release takes the exploded value, the other operations take
+/// the addresses of the values.
+///
+/// The helpers are named after the mangling of the type and shared between
+/// translation units like the other helper functions, so only nominal types
+/// whose layout is fixed in this resilience domain and which do not depend
+/// on archetypes of the current context are outlined.
+llvm::Function *
+IRGenModule::getOutlinedValueOperation(OutlinedValueOperation op, SILType T,
+                                       const TypeInfo &ti) {
+  unsigned threshold = Opts.OutlinedValueOperationThreshold;
+  if (threshold == 0 || !ti.isFixedSize() ||
+      ti.isPOD(ResilienceScope::Component) || T.hasArchetype())
+    return nullptr;
+  if (!T.getStructOrBoundGenericStruct() && !T.getEnumOrBoundGenericEnum())
+    return nullptr;
+
+  auto key = std::make_pair(T.getSwiftRValueType().getPointer(),
+                            unsigned(op));
+  auto found = OutlinedValueOperations.find(key);
+  if (found != OutlinedValueOperations.end())
+    return found->second;
+
+  SmallVector<llvm::Type*, 4> paramTys;
+  switch (op) {
+  case OutlinedValueOperation::Retain:
+  case OutlinedValueOperation::Release:
+    for (auto &elt : ti.getSchema())
+      paramTys.push_back(elt.getScalarType());
+    break;
+  case OutlinedValueOperation::Destroy:
+    paramTys.push_back(ti.getStorageType()->getPointerTo());
+    break;
+  case OutlinedValueOperation::InitializeWithCopy:
+  case OutlinedValueOperation::AssignWithCopy:
+    paramTys.push_back(ti.getStorageType()->getPointerTo());
+    paramTys.push_back(ti.getStorageType()->getPointerTo());
+    break;
+  }
+
+  llvm::SmallString<64> buffer;
+  buffer += "__swift_outlined_";
+  buffer += getOutlinedValueOperationName(op);
+  buffer += '_';
+  StringRef fnName = mangleType(T.getSwiftRValueType(), buffer);
+
+  auto fn = cast<llvm::Function>(
+    getOrCreateHelperFunction(fnName, VoidTy, paramTys,
+                              [&](IRGenFunction &IGF) {
+      emitOutlinedValueOperation(IGF, op, T, ti);
+    }));
+
+  // Count the instructions of the expansion, not including the return. If
+  // it is not bigger than the threshold, emit the operation inline.
+  unsigned size = 0;
+  for (auto &BB : *fn)
+    size += BB.size();
+  if (size <= threshold + 1) {
+    fn->eraseFromParent();
+    fn = nullptr;
+  }
+
+  OutlinedValueOperations[key] = fn;
+  return fn;
+}
+
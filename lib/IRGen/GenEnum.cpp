@@ -3955,39 +3955,57 @@ namespace {
 
     /// \group Extra inhabitants
 
-    // TODO
+    // The common spare bits not needed for the tag, and the unused bits of
+    // the extra tag byte, are clear in every valid value, so patterns with
+    // any of them set are extra inhabitants. This lets an enclosing
+    // single-payload enum, such as an Optional of the enum, store its empty
+    // cases without adding another tag byte.
+    //
+    // The runtime does not track spare bits when it lays out an enum
+    // dynamically, so only enums that always have fixed size expose them.
 
-    bool mayHaveExtraInhabitants(IRGenModule &) const override { return false; }
+    bool hasSpareBitExtraInhabitants() const {
+      return TIK >= Fixed && AlwaysFixedSize;
+    }
+
+    bool mayHaveExtraInhabitants(IRGenModule &IGM) const override {
+      return getFixedExtraInhabitantCount(IGM) > 0;
+    }
 
     llvm::Value *getExtraInhabitantIndex(IRGenFunction &IGF,
                                          Address src,
                                          SILType T) const override {
-      llvm_unreachable("extra inhabitants for multi-payload enums not implemented");
+      assert(hasSpareBitExtraInhabitants());
+      return cast<FixedTypeInfo>(TI)->getSpareBitExtraInhabitantIndex(IGF, src);
     }
 
     void storeExtraInhabitant(IRGenFunction &IGF,
                               llvm::Value *index,
                               Address dest,
                               SILType T) const override {
-      llvm_unreachable("extra inhabitants for multi-payload enums not implemented");
+      assert(hasSpareBitExtraInhabitants());
+      cast<FixedTypeInfo>(TI)->storeSpareBitExtraInhabitant(IGF, index, dest);
     }
     
     APInt
     getFixedExtraInhabitantMask(IRGenModule &IGM) const override {
-      // TODO may not always be all-ones
       return APInt::getAllOnesValue(
                       cast<FixedTypeInfo>(TI)->getFixedSize().getValueInBits());
     }
     
     unsigned getFixedExtraInhabitantCount(IRGenModule &IGM) const override {
-      return 0;
+      if (!hasSpareBitExtraInhabitants())
+        return 0;
+      return cast<FixedTypeInfo>(TI)->getSpareBitExtraInhabitantCount();
     }
 
     APInt
     getFixedExtraInhabitantValue(IRGenModule &IGM,
                                  unsigned bits,
                                  unsigned index) const override {
-      llvm_unreachable("extra inhabitants for multi-payload enums not implemented");
+      assert(hasSpareBitExtraInhabitants());
+      return cast<FixedTypeInfo>(TI)
+        ->getSpareBitFixedExtraInhabitantValue(IGM, bits, index);
     }
 
     ClusteredBitVector
@@ -4675,6 +4693,22 @@ irgen::getEnumImplStrategy(IRGenModule &IGM, CanType ty) {
   return getEnumImplStrategy(IGM, SILType::getPrimitiveAddressType(ty));
 }
 
+llvm::Constant *
+EnumImplStrategy::getConstantNoPayloadValue(EnumElementDecl *elt) const {
+  assert(ElementsWithPayload.empty() && "enum has payload cases");
+  llvm::StructType *storageTy = getStorageType();
+
+  // A single case takes no storage.
+  if (storageTy->getNumElements() == 0)
+    return llvm::ConstantStruct::get(storageTy, {});
+
+  int64_t index = getDiscriminatorIndex(elt);
+  assert(index >= 0 && "no discriminator for a no-payload enum?!");
+  auto discriminatorTy = cast<llvm::IntegerType>(storageTy->getElementType(0));
+  return llvm::ConstantStruct::get(storageTy,
+                          llvm::ConstantInt::get(discriminatorTy, index));
+}
+
 TypeInfo *
 EnumImplStrategy::getFixedEnumTypeInfo(llvm::StructType *T, Size S,
                                        SpareBitVector SB,
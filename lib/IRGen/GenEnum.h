@@ -202,6 +202,10 @@ public:
     return -1;
   }
 
+  /// Return the constant value of the given case of an enum which has no
+  /// payload cases, for use in a static initializer.
+  llvm::Constant *getConstantNoPayloadValue(EnumElementDecl *elt) const;
+
   /// Emit field names for enum reflection.
   virtual llvm::Constant *emitCaseNames() const;
 
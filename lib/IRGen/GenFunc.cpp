@@ -1338,13 +1338,17 @@ void SignatureExpansion::expand(SILParameterInfo param) {
   case ParameterConvention::Direct_Owned:
   case ParameterConvention::Direct_Unowned:
   case ParameterConvention::Direct_Guaranteed:
-    // Go ahead and further decompose tuples.
+    // Go ahead and further decompose tuples, unless the tuple is too big to
+    // be passed in registers. Then it's passed indirectly as a whole, which
+    // is what addNativeArgument and bindParameter expect.
     if (auto tuple = dyn_cast<TupleType>(param.getType())) {
-      for (auto elt : tuple.getElementTypes()) {
-        // Propagate the same ownedness down to the element.
-        expand(SILParameterInfo(elt, param.getConvention()));
+      if (!ti.getSchema().requiresIndirectParameter(IGM)) {
+        for (auto elt : tuple.getElementTypes()) {
+          // Propagate the same ownedness down to the element.
+          expand(SILParameterInfo(elt, param.getConvention()));
+        }
+        return;
       }
-      return;
     }
     SWIFT_FALLTHROUGH;
   case ParameterConvention::Direct_Deallocating:
@@ -1458,9 +1462,13 @@ void SignatureExpansion::expandParameters() {
   // if we set the right attribute.
   if (FnType->hasErrorResult()) {
     // TODO: 'swift_error' IR attribute
-    llvm::Type *errorType =
-      IGM.getStorageType(FnType->getErrorResult().getSILType());
-    ParamIRTypes.push_back(errorType->getPointerTo());
+    SILType errorType = FnType->getErrorResult().getSILType();
+    // The slot is private to the caller and only ever accessed through this
+    // pointer, so LLVM can keep its value in a register across the stores
+    // and calls of the callee.
+    addIndirectValueParameterAttributes(IGM, Attrs, IGM.getTypeInfo(errorType),
+                                        ParamIRTypes.size());
+    ParamIRTypes.push_back(IGM.getStorageType(errorType)->getPointerTo());
   }
 
   // Witness methods have some extra parameter types.
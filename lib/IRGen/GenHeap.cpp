@@ -912,6 +912,20 @@ void IRGenFunction::emitRelease(llvm::Value *value) {
   emitUnaryRefCountCall(*this, IGM.getReleaseFn(), value);
 }
 
+/// Emit a call to swift_nonatomic_retain.  This must only be used for objects
+/// which are known not to be visible to other threads.
+void IRGenFunction::emitNonAtomicRetainCall(llvm::Value *value) {
+  if (doesNotRequireRefCounting(value)) return;
+  emitUnaryRefCountCall(*this, IGM.getNonAtomicRetainFn(), value);
+}
+
+/// Emit a non-atomic release of a live value.  This must only be used for
+/// objects which are known not to be visible to other threads.
+void IRGenFunction::emitNonAtomicRelease(llvm::Value *value) {
+  if (doesNotRequireRefCounting(value)) return;
+  emitUnaryRefCountCall(*this, IGM.getNonAtomicReleaseFn(), value);
+}
+
 /// Fix the lifetime of a live value. This communicates to the LLVM level ARC
 /// optimizer not to touch this value.
 void IRGenFunction::emitFixLifetime(llvm::Value *value) {
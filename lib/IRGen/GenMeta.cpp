@@ -81,9 +81,7 @@ static Address createPointerSizedGEP(IRGenFunction &IGF,
 
 static llvm::Constant *getMangledTypeName(IRGenModule &IGM, CanType type) {
   auto name = LinkEntity::forTypeMangling(type);
-  llvm::SmallString<32> mangling;
-  name.mangle(mangling);
-  return IGM.getAddrOfGlobalString(mangling);
+  return IGM.getAddrOfGlobalString(IGM.getMangledName(name));
 }
 
 llvm::Value *irgen::emitObjCMetadataRefForMetadata(IRGenFunction &IGF,
@@ -1793,9 +1791,50 @@ namespace {
     llvm::SmallVector<llvm::Constant*, 16> Fields;
     Size NextOffset = Size(0);
 
+    /// The relative references added with addRelativeAddress: the index of
+    /// the placeholder field and the referenced target.
+    llvm::SmallVector<std::pair<unsigned, llvm::Constant*>, 4>
+      RelativeAddresses;
+
   protected:
     Size getNextOffset() const { return NextOffset; }
 
+    /// Add a 32-bit reference to the given target, relative to the address of
+    /// the field. A null target is encoded as zero. The field is a placeholder
+    /// until resolveRelativeAddresses is called.
+    void addRelativeAddress(llvm::Constant *target) {
+      if (target->isNullValue()) {
+        addInt32(llvm::ConstantInt::get(IGM.RelativeAddressTy, 0));
+        return;
+      }
+      RelativeAddresses.push_back({unsigned(Fields.size()), target});
+      addInt32(llvm::ConstantInt::get(IGM.RelativeAddressTy, 0));
+    }
+
+    /// Replace the placeholders of relative references with the distance
+    /// between the target and the field, given the variable \p base which will
+    /// be initialized with getInit().
+    void resolveRelativeAddresses(llvm::GlobalVariable *base) {
+      for (auto &entry : RelativeAddresses) {
+        llvm::Constant *indexes[] = {
+          llvm::ConstantInt::get(IGM.Int32Ty, 0),
+          llvm::ConstantInt::get(IGM.Int32Ty, entry.first),
+        };
+        auto fieldAddr = llvm::ConstantExpr::getInBoundsGetElementPtr(
+                                       base->getValueType(), base, indexes);
+        auto relativeAddr = llvm::ConstantExpr::getSub(
+              llvm::ConstantExpr::getPtrToInt(entry.second, IGM.SizeTy),
+              llvm::ConstantExpr::getPtrToInt(fieldAddr, IGM.SizeTy));
+
+        // Relative addresses can be 32-bit even on 64-bit platforms.
+        if (IGM.SizeTy != IGM.RelativeAddressTy)
+          relativeAddr = llvm::ConstantExpr::getTrunc(relativeAddr,
+                                                      IGM.RelativeAddressTy);
+        Fields[entry.first] = relativeAddr;
+      }
+      RelativeAddresses.clear();
+    }
+
     /// Add a uintptr_t value that represents the given offset, but
     /// scaled to a number of words.
     void addConstantWordInWords(Size value) {
@@ -1913,7 +1952,7 @@ namespace {
     
     void addName() {
       NominalTypeDecl *ntd = asImpl().getTarget();
-      addWord(getMangledTypeName(IGM,
+      addRelativeAddress(getMangledTypeName(IGM,
                                  ntd->getDeclaredType()->getCanonicalType()));
     }
     
@@ -1921,13 +1960,13 @@ namespace {
       NominalTypeDecl *ntd = asImpl().getTarget();
       if (!ntd->getGenericParams()) {
         // If there are no generic parameters, there's no pattern to link.
-        addWord(llvm::ConstantPointerNull::get(IGM.TypeMetadataPatternPtrTy));
+        addConstantInt32(0);
         return;
       }
       
-      addWord(IGM.getAddrOfTypeMetadata(ntd->getDeclaredType()
-                                          ->getCanonicalType(),
-                                        /*pattern*/ true));
+      addRelativeAddress(IGM.getAddrOfTypeMetadata(ntd->getDeclaredType()
+                                                     ->getCanonicalType(),
+                                                   /*pattern*/ true));
     }
     
     void addGenericParams() {
@@ -1982,8 +2021,11 @@ namespace {
       auto var = cast<llvm::GlobalVariable>(
                       IGM.getAddrOfNominalTypeDescriptor(asImpl().getTarget(),
                                                          init->getType()));
+      // The relative references are relative to the descriptor itself, so we
+      // can only resolve them once we have its address.
+      resolveRelativeAddresses(var);
       var->setConstant(true);
-      var->setInitializer(init);
+      var->setInitializer(getInit());
       return var;
     }
     
@@ -2304,14 +2346,14 @@ namespace {
       
       addConstantInt32(numFields);
       addConstantInt32InWords(FieldVectorOffset);
-      addWord(IGM.getAddrOfGlobalString(fieldNames));
+      addRelativeAddress(IGM.getAddrOfGlobalString(fieldNames));
       
       // Build the field type accessor function.
       llvm::Function *fieldTypeVectorAccessor
         = getFieldTypeAccessorFn(IGM, Target,
                                    Target->getStoredProperties());
       
-      addWord(fieldTypeVectorAccessor);
+      addRelativeAddress(fieldTypeVectorAccessor);
     }
   };
   
@@ -2388,14 +2430,14 @@ namespace {
       
       addConstantInt32(numFields);
       addConstantInt32InWords(FieldVectorOffset);
-      addWord(IGM.getAddrOfGlobalString(fieldNames));
+      addRelativeAddress(IGM.getAddrOfGlobalString(fieldNames));
       
       // Build the field type accessor function.
       llvm::Function *fieldTypeVectorAccessor
         = getFieldTypeAccessorFn(IGM, Target,
                                    Target->getStoredProperties());
       
-      addWord(fieldTypeVectorAccessor);
+      addRelativeAddress(fieldTypeVectorAccessor);
     }
   };
   
@@ -2478,14 +2520,14 @@ namespace {
       // # empty cases
       addConstantInt32(strategy.getElementsWithNoPayload().size());
 
-      addWord(strategy.emitCaseNames());
+      addRelativeAddress(strategy.emitCaseNames());
 
       // Build the case type accessor.
       llvm::Function *caseTypeVectorAccessor
         = getFieldTypeAccessorFn(IGM, Target,
                                  strategy.getElementsWithPayload());
       
-      addWord(caseTypeVectorAccessor);
+      addRelativeAddress(caseTypeVectorAccessor);
     }
   };
 }
@@ -3326,8 +3368,10 @@ namespace {
 
       if (whichClass == Target) {
         // If the metadata contains a field offset vector for the class itself,
-        // then we need to initialize it at runtime.
-        HasDependentFieldOffsetVector = true;
+        // then we need to initialize it at runtime, unless the layout doesn't
+        // depend on the generic arguments. In that case the template already
+        // has the field offsets, instance size and alignment.
+        HasDependentFieldOffsetVector = !Layout.isFixedLayout();
         return;
       }
       
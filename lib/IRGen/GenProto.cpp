@@ -56,6 +56,7 @@
 #include "GenMeta.h"
 #include "GenOpaque.h"
 #include "GenPoly.h"
+#include "GenStruct.h"
 #include "GenType.h"
 #include "IRGenDebugInfo.h"
 #include "IRGenFunction.h"
@@ -1377,6 +1378,122 @@ static llvm::Constant *getMemCpyArrayFunction(IRGenModule &IGM,
   return getMemOpArrayFunction(IGM, objectTI, MemMoveOrCpy::MemCpy);
 }
 
+/// Return a value witness which is shared by all inline, bitwise-takable
+/// struct types with the same size, alignment and native strong reference
+/// offsets, or null if there is no such witness for the type.  Value types
+/// with the same layout and ownership profile, like "one strong reference
+/// and an Int", are common, and there is no need for each of them to have
+/// its own copy of the same code.
+static llvm::Constant *getSharedLayoutValueWitness(IRGenModule &IGM,
+                                                   ValueWitness index,
+                                                   FixedPacking packing,
+                                                   SILType concreteType,
+                                                const TypeInfo &concreteTI) {
+  if (packing != FixedPacking::OffsetZero ||
+      !concreteType.getStructOrBoundGenericStruct())
+    return nullptr;
+  auto *fixedTI = dyn_cast<FixedTypeInfo>(&concreteTI);
+  if (!fixedTI || !fixedTI->isBitwiseTakable(ResilienceScope::Component))
+    return nullptr;
+
+  enum class Operation { Destroy, InitWithCopy, AssignWithCopy, AssignWithTake };
+  Operation op;
+  StringRef opName;
+  switch (index) {
+  case ValueWitness::DestroyBuffer:
+  case ValueWitness::Destroy:
+    op = Operation::Destroy;
+    opName = "destroy";
+    break;
+  case ValueWitness::InitializeBufferWithCopyOfBuffer:
+  case ValueWitness::InitializeBufferWithCopy:
+  case ValueWitness::InitializeWithCopy:
+    op = Operation::InitWithCopy;
+    opName = "initWithCopy";
+    break;
+  case ValueWitness::AssignWithCopy:
+    op = Operation::AssignWithCopy;
+    opName = "assignWithCopy";
+    break;
+  case ValueWitness::AssignWithTake:
+    op = Operation::AssignWithTake;
+    opName = "assignWithTake";
+    break;
+  default:
+    return nullptr;
+  }
+
+  SmallVector<Size, 4> refOffsets;
+  if (!collectNativeReferenceOffsets(IGM, concreteType, concreteTI, Size(0),
+                                     refOffsets) ||
+      refOffsets.empty())
+    return nullptr;
+
+  Size size = fixedTI->getFixedSize();
+  Alignment align = fixedTI->getFixedAlignment();
+
+  // The helper is uniqued by everything its behavior depends on.
+  llvm::SmallString<64> name;
+  {
+    llvm::raw_svector_ostream nameStream(name);
+    nameStream << "__swift_" << opName << '_' << size.getValue() << '_'
+               << align.getValue() << "_strong";
+    for (auto offset : refOffsets)
+      nameStream << '_' << offset.getValue();
+  }
+
+  auto loadReferences = [&](IRGenFunction &IGF, Address base,
+                            SmallVectorImpl<llvm::Value *> &refs) {
+    for (auto offset : refOffsets) {
+      auto addr = base;
+      if (!offset.isZero())
+        addr = IGF.Builder.CreateConstByteArrayGEP(base, offset);
+      addr = IGF.Builder.CreateBitCast(addr,
+                                       IGM.RefCountedPtrTy->getPointerTo());
+      refs.push_back(IGF.Builder.CreateLoad(addr));
+    }
+  };
+
+  if (op == Operation::Destroy) {
+    llvm::Type *argTys[] = { IGM.Int8PtrTy, IGM.TypeMetadataPtrTy };
+    return IGM.getOrCreateHelperFunction(name, IGM.VoidTy, argTys,
+                                         [&](IRGenFunction &IGF) {
+      Address object(IGF.CurFn->arg_begin(), align);
+      SmallVector<llvm::Value *, 4> refs;
+      loadReferences(IGF, object, refs);
+      for (auto ref : refs)
+        IGF.emitRelease(ref);
+      IGF.Builder.CreateRetVoid();
+    });
+  }
+
+  llvm::Type *argTys[] = { IGM.Int8PtrTy, IGM.Int8PtrTy,
+                           IGM.TypeMetadataPtrTy };
+  return IGM.getOrCreateHelperFunction(name, IGM.Int8PtrTy, argTys,
+                                       [&](IRGenFunction &IGF) {
+    auto it = IGF.CurFn->arg_begin();
+    Address dest(it++, align);
+    Address src(it++, align);
+
+    SmallVector<llvm::Value *, 4> newRefs, oldRefs;
+    if (op != Operation::AssignWithTake)
+      loadReferences(IGF, src, newRefs);
+    if (op != Operation::InitWithCopy)
+      loadReferences(IGF, dest, oldRefs);
+
+    // Retain the new references before releasing the old ones, in case
+    // they are the same objects.
+    if (op != Operation::AssignWithTake)
+      for (auto ref : newRefs)
+        IGF.emitRetainCall(ref);
+    IGF.emitMemCpy(dest, src, size);
+    for (auto ref : oldRefs)
+      IGF.emitRelease(ref);
+
+    IGF.Builder.CreateRet(dest.getAddress());
+  });
+}
+
 /// Find a witness to the fact that a type is a value type.
 /// Always returns an i8*.
 static llvm::Constant *getValueWitness(IRGenModule &IGM,
@@ -1582,6 +1699,10 @@ static llvm::Constant *getValueWitness(IRGenModule &IGM,
   llvm_unreachable("bad value witness kind");
 
  standard:
+  if (auto shared = getSharedLayoutValueWitness(IGM, index, packing,
+                                                concreteType, concreteTI))
+    return asOpaquePtr(IGM, shared);
+
   llvm::Function *fn =
     IGM.getAddrOfValueWitness(abstractType, index, ForDefinition);
   if (fn->empty())
@@ -492,7 +492,19 @@ namespace {
 
     StructLayout performLayout(ArrayRef<const TypeInfo *> fieldTypes) {
       return StructLayout(IGM, TheStruct, LayoutKind::NonHeapObject,
-                          LayoutStrategy::Optimal, fieldTypes, StructTy);
+                          getLayoutStrategy(), fieldTypes, StructTy);
+    }
+
+    /// Structs marked @_compact_layout may have their fields reordered.
+    /// Generic and resilient structs are laid out by the runtime in
+    /// declaration order, so they have to keep it.
+    LayoutStrategy getLayoutStrategy() const {
+      auto decl = TheStruct->getStructOrBoundGenericStruct();
+      if (decl->getAttrs().hasAttribute<CompactLayoutAttr>() &&
+          !decl->isGenericContext() &&
+          !IGM.isResilient(decl, ResilienceScope::Universal))
+        return LayoutStrategy::Compact;
+      return LayoutStrategy::Optimal;
     }
   };
 
@@ -746,6 +758,41 @@ llvm::Constant *irgen::emitPhysicalStructMemberFixedOffset(IRGenModule &IGM,
   FOR_STRUCT_IMPL(IGM, baseType, getConstantFieldOffset, field);
 }
 
+bool irgen::collectNativeReferenceOffsets(IRGenModule &IGM, SILType T,
+                                          const TypeInfo &TI, Size offset,
+                                     SmallVectorImpl<Size> &refOffsets) {
+  if (TI.isPOD(ResilienceScope::Component))
+    return true;
+
+  if (TI.isSingleSwiftRetainablePointer(ResilienceScope::Component)) {
+    refOffsets.push_back(offset);
+    return true;
+  }
+
+  // Otherwise, look through the fields of loadable structs.
+  if (!T.getStructOrBoundGenericStruct() || !TI.isLoadable() ||
+      getStructTypeInfoKind(TI) != StructTypeInfoKind::LoadableStructTypeInfo)
+    return false;
+  for (auto &field : TI.as<LoadableStructTypeInfo>().getFields()) {
+    switch (field.getKind()) {
+    case ElementLayout::Kind::Empty:
+      continue;
+    case ElementLayout::Kind::Fixed:
+      if (!collectNativeReferenceOffsets(IGM, field.getType(IGM, T),
+                                         field.getTypeInfo(),
+                                         offset + field.getFixedByteOffset(),
+                                         refOffsets))
+        return false;
+      continue;
+    case ElementLayout::Kind::InitialNonFixedSize:
+    case ElementLayout::Kind::NonFixed:
+      return false;
+    }
+    llvm_unreachable("bad element layout kind");
+  }
+  return true;
+}
+
 void IRGenModule::emitStructDecl(StructDecl *st) {
   emitStructMetadata(*this, st);
   emitNestedTypeDecls(st->getMembers());
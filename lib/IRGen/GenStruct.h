@@ -19,6 +19,7 @@
 
 namespace llvm {
   class Constant;
+  template <typename T> class SmallVectorImpl;
 }
 
 namespace swift {
@@ -31,6 +32,8 @@ namespace irgen {
   class Explosion;
   class IRGenFunction;
   class IRGenModule;
+  class Size;
+  class TypeInfo;
   
   Address projectPhysicalStructMemberAddress(IRGenFunction &IGF,
                                              Address base,
@@ -48,6 +51,16 @@ namespace irgen {
                                                       SILType baseType,
                                                       VarDecl *field);
 
+  /// If a value of the given type consists of nothing but POD data and
+  /// native Swift strong references, add the byte offset (relative to
+  /// \p offset) of each strong reference to \p refOffsets and return true.
+  /// Value operations on such a type depend only on its size, alignment
+  /// and the reference offsets, which lets layout-equivalent types share
+  /// value witnesses.
+  bool collectNativeReferenceOffsets(IRGenModule &IGM, SILType T,
+                                     const TypeInfo &TI, Size offset,
+                               llvm::SmallVectorImpl<Size> &refOffsets);
+
 } // end namespace irgen
 } // end namespace swift
 
@@ -18,11 +18,14 @@
 #include "swift/Subsystems.h"
 #include "swift/AST/AST.h"
 #include "swift/AST/DiagnosticsIRGen.h"
+#include "swift/AST/FunctionTimeProfile.h"
 #include "swift/AST/IRGenOptions.h"
 #include "swift/AST/LinkLibrary.h"
 #include "swift/SIL/SILModule.h"
 #include "swift/Basic/Dwarf.h"
 #include "swift/Basic/Platform.h"
+#include "swift/Basic/TraceEvents.h"
+#include "swift/Basic/Version.h"
 #include "swift/ClangImporter/ClangImporter.h"
 #include "swift/LLVMPasses/PassesFwd.h"
 #include "swift/LLVMPasses/Passes.h"
@@ -43,6 +46,9 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Mutex.h"
@@ -54,6 +60,8 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/ObjCARC.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "IRGenModule.h"
 
 #include <thread>
@@ -114,8 +122,70 @@ void setModuleFlags(IRGenModule &IGM) {
                         IRGenModule::swiftVersion);
 }
 
+/// Attributes time the LLVM passes spent on \p F to the function it was
+/// generated for.
+static void addLLVMTime(FunctionTimeProfile &Profile, const llvm::Function &F,
+                        uint64_t Nanoseconds) {
+  Profile.addTime(Profile.getSymbolSource(F.getName()), F.getName(),
+                  FunctionTimeProfile::Phase::LLVM, Nanoseconds);
+}
+
+namespace {
+  /// Measures the time of the code generator on each function, for
+  /// -debug-time-functions.
+  ///
+  /// The code generator's passes all run on one function before moving on to
+  /// the next, so a pass added before them and one added after them bracket
+  /// the work on each function.
+  class CodeGenTimerPass : public llvm::FunctionPass {
+    FunctionTimeProfile &Profile;
+    llvm::DenseMap<const llvm::Function *, uint64_t> &StartTimes;
+    bool IsEnd;
+
+  public:
+    static char ID;
+    CodeGenTimerPass(FunctionTimeProfile &Profile,
+                     llvm::DenseMap<const llvm::Function *, uint64_t> &Starts,
+                     bool IsEnd)
+      : llvm::FunctionPass(ID), Profile(Profile), StartTimes(Starts),
+        IsEnd(IsEnd) {}
+
+    const char *getPassName() const override {
+      return IsEnd ? "Swift code generation timer end"
+                   : "Swift code generation timer start";
+    }
+
+    void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
+      AU.setPreservesAll();
+    }
+
+    bool runOnFunction(llvm::Function &F) override {
+      if (!IsEnd) {
+        StartTimes[&F] = FunctionTimeProfile::now();
+        return false;
+      }
+      auto found = StartTimes.find(&F);
+      if (found != StartTimes.end())
+        addLLVMTime(Profile, F, FunctionTimeProfile::now() - found->second);
+      return false;
+    }
+  };
+  char CodeGenTimerPass::ID = 0;
+} // end anonymous namespace
+
 void swift::performLLVMOptimizations(IRGenOptions &Opts, llvm::Module *Module,
                                      llvm::TargetMachine *TargetMachine) {
+  // If requested, lower the profile counter increments up front. The
+  // optimizer then sees the counter updates as plain loads and stores and can
+  // promote the counters of loops to registers.
+  bool LowerProfileCountersEarly =
+    Opts.GenerateProfile && Opts.ProfileCounterPromotion;
+  if (LowerProfileCountersEarly) {
+    legacy::PassManager LoweringPasses;
+    LoweringPasses.add(createInstrProfilingPass());
+    LoweringPasses.run(*Module);
+  }
+
   // Set up a pipeline.
   PassManagerBuilder PMBuilder;
 
@@ -163,10 +233,16 @@ void swift::performLLVMOptimizations(IRGenOptions &Opts, llvm::Module *Module,
   }
 
   // Run the function passes.
+  FunctionTimeProfile *Profile = FunctionTimeProfile::getActive();
   FunctionPasses.doInitialization();
-  for (auto I = Module->begin(), E = Module->end(); I != E; ++I)
-    if (!I->isDeclaration())
-      FunctionPasses.run(*I);
+  for (auto I = Module->begin(), E = Module->end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    uint64_t StartTime = Profile ? FunctionTimeProfile::now() : 0;
+    FunctionPasses.run(*I);
+    if (Profile)
+      addLLVMTime(*Profile, *I, FunctionTimeProfile::now() - StartTime);
+  }
   FunctionPasses.doFinalization();
 
   // Configure the module passes.
@@ -187,7 +263,7 @@ void swift::performLLVMOptimizations(IRGenOptions &Opts, llvm::Module *Module,
   }
 
   // If we're generating a profile, add the lowering pass now.
-  if (Opts.GenerateProfile)
+  if (Opts.GenerateProfile && !LowerProfileCountersEarly)
     ModulePasses.add(createInstrProfilingPass());
 
   if (Opts.Verify)
@@ -197,6 +273,227 @@ void swift::performLLVMOptimizations(IRGenOptions &Opts, llvm::Module *Module,
   ModulePasses.run(*Module);
 }
 
+/// Compute a hash of the IR of \p Module and of everything else which
+/// determines the object file that LLVM generates from it.
+static void computeIRHash(IRGenOptions &Opts, llvm::Module *Module,
+                          llvm::TargetMachine *TargetMachine,
+                          llvm::SmallString<32> &Result) {
+  llvm::SmallString<0> Bitcode;
+  {
+    llvm::raw_svector_ostream OS(Bitcode);
+    llvm::WriteBitcodeToFile(Module, OS);
+  }
+
+  llvm::MD5 Hash;
+  Hash.update(Bitcode);
+  Hash.update(version::getSwiftFullVersion());
+  Hash.update(TargetMachine->getTargetCPU());
+  Hash.update(TargetMachine->getTargetFeatureString());
+  uint8_t Flags[] = {
+    uint8_t(Opts.Optimize), uint8_t(Opts.DisableLLVMOptzns),
+    uint8_t(Opts.DisableLLVMARCOpts), uint8_t(Opts.DisableLLVMSLPVectorizer),
+    uint8_t(Opts.DisableFPElim), uint8_t(Opts.Verify)
+  };
+  Hash.update(Flags);
+  llvm::MD5::MD5Result HashResult;
+  Hash.final(HashResult);
+  llvm::MD5::stringifyResult(HashResult, Result);
+}
+
+/// Returns true if \p OutputFilename was generated from IR with the hash
+/// \p IRHash by a previous compilation.
+static bool isOutputUpToDate(StringRef OutputFilename, StringRef HashFilename,
+                             StringRef IRHash) {
+  if (!llvm::sys::fs::exists(OutputFilename))
+    return false;
+  auto Buffer = llvm::MemoryBuffer::getFile(HashFilename);
+  if (!Buffer)
+    return false;
+  return Buffer.get()->getBuffer() == IRHash;
+}
+
+/// Records that the object file next to \p HashFilename was generated from
+/// IR with the hash \p IRHash. Failing to write the hash only means that the
+/// next compilation can't reuse the object file.
+static void writeIRHash(StringRef HashFilename, StringRef IRHash) {
+  std::error_code EC;
+  llvm::raw_fd_ostream HashOS(HashFilename, EC, llvm::sys::fs::F_None);
+  if (!EC)
+    HashOS << IRHash;
+}
+
+/// Gives the local symbols of \p Module names which are unique to the object
+/// file \p OutputFilename.
+///
+/// Splitting a module turns its local symbols into hidden ones, so that the
+/// partitions can refer to each other's symbols. Hidden symbols of different
+/// object files of the same image must not collide, and they can't be
+/// assembler temporaries.
+static void makeLocalNamesUnique(llvm::Module &Module,
+                                 StringRef OutputFilename) {
+  llvm::MD5 Hash;
+  Hash.update(OutputFilename);
+  llvm::MD5::MD5Result HashResult;
+  Hash.final(HashResult);
+  llvm::SmallString<32> HashString;
+  llvm::MD5::stringifyResult(HashResult, HashString);
+  std::string Suffix = ("." + HashString.str().substr(0, 8)).str();
+
+  auto rename = [&](GlobalValue &GV) {
+    if (!GV.hasLocalLinkage())
+      return;
+    StringRef Name = GV.getName();
+    if (Name.startswith("\01L") || Name.startswith("\01l"))
+      Name = Name.drop_front(2);
+    if (Name.empty())
+      Name = "__unnamed";
+    GV.setName(Name + Suffix);
+  };
+  for (Function &F : Module)
+    rename(F);
+  for (GlobalVariable &G : Module.globals())
+    rename(G);
+  for (GlobalAlias &A : Module.aliases())
+    rename(A);
+}
+
+/// Generates an object file from the bitcode of one partition of a split
+/// module into \p Path. Returns true on failure.
+static bool emitPartition(IRGenOptions &Opts, StringRef Bitcode,
+                          llvm::TargetMachine *TargetMachine,
+                          StringRef Path) {
+  // Each thread gets its own context and target machine; neither is
+  // thread-safe.
+  LLVMContext Context;
+  auto PartitionOrErr =
+      parseBitcodeFile(llvm::MemoryBufferRef(Bitcode, Path), Context);
+  if (!PartitionOrErr)
+    return true;
+  std::unique_ptr<llvm::Module> Partition = std::move(PartitionOrErr.get());
+
+  std::unique_ptr<llvm::TargetMachine> PartitionTM(
+      TargetMachine->getTarget().createTargetMachine(
+          TargetMachine->getTargetTriple().str(),
+          TargetMachine->getTargetCPU(),
+          TargetMachine->getTargetFeatureString(), TargetMachine->Options,
+          Reloc::PIC_, CodeModel::Default, TargetMachine->getOptLevel()));
+  if (!PartitionTM)
+    return true;
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_None);
+  if (EC)
+    return true;
+
+  legacy::PassManager EmitPasses;
+  EmitPasses.add(createTargetTransformInfoWrapperPass(
+      PartitionTM->getTargetIRAnalysis()));
+  if (Opts.Optimize)
+    EmitPasses.add(createObjCARCContractPass());
+  if (PartitionTM->addPassesToEmitFile(EmitPasses, OS,
+                                       llvm::TargetMachine::CGFT_ObjectFile,
+                                       !Opts.Verify))
+    return true;
+  EmitPasses.run(*Partition);
+  return OS.has_error();
+}
+
+/// Generates the object file for the optimized \p Module by splitting it into
+/// Opts.CodeGenPartitions partitions, generating code for them in parallel
+/// and merging the resulting object files with a relocatable link.
+///
+/// Returns false without writing anything to \p OS if this isn't possible,
+/// in which case the caller generates the object file itself.
+static bool performSplitCodeGen(IRGenOptions &Opts, llvm::Module *Module,
+                                llvm::TargetMachine *TargetMachine,
+                                StringRef OutputFilename,
+                                raw_pwrite_stream &OS) {
+  const llvm::Triple &Triple = TargetMachine->getTargetTriple();
+  if (!Triple.isOSBinFormatMachO() && !Triple.isOSBinFormatELF())
+    return false;
+  auto LinkerPath = llvm::sys::findProgramByName("ld");
+  if (!LinkerPath)
+    return false;
+
+  // Split a copy of the module, so that the caller still gets the module it
+  // passed in.
+  std::unique_ptr<llvm::Module> Clone = llvm::CloneModule(Module);
+  makeLocalNamesUnique(*Clone, OutputFilename);
+
+  // The partitions share the context of the module, so they are serialized
+  // here and read into a context of their own by the thread which compiles
+  // them.
+  std::vector<llvm::SmallString<0>> Bitcodes;
+  llvm::SplitModule(std::move(Clone), Opts.CodeGenPartitions,
+                    [&](std::unique_ptr<llvm::Module> Partition) {
+    Bitcodes.emplace_back();
+    llvm::raw_svector_ostream BitcodeOS(Bitcodes.back());
+    llvm::WriteBitcodeToFile(Partition.get(), BitcodeOS);
+  });
+
+  unsigned NumPartitions = Bitcodes.size();
+  std::vector<std::string> PartitionFiles(NumPartitions);
+  std::unique_ptr<bool[]> Failed(new bool[NumPartitions]());
+  bool CreatedFiles = true;
+  for (unsigned i = 0; i < NumPartitions; ++i) {
+    llvm::SmallString<128> Path;
+    if (llvm::sys::fs::createTemporaryFile("partition", "o", Path)) {
+      CreatedFiles = false;
+      break;
+    }
+    PartitionFiles[i] = Path.str();
+  }
+
+  llvm::SmallString<128> MergedFile;
+  bool Success = CreatedFiles &&
+      !llvm::sys::fs::createTemporaryFile("merged", "o", MergedFile);
+  if (Success) {
+    std::vector<std::thread> Threads;
+    for (unsigned i = 1; i < NumPartitions; ++i) {
+      Threads.push_back(std::thread([&, i] {
+        Failed[i] = emitPartition(Opts, Bitcodes[i], TargetMachine,
+                                  PartitionFiles[i]);
+      }));
+    }
+    Failed[0] = emitPartition(Opts, Bitcodes[0], TargetMachine,
+                              PartitionFiles[0]);
+    for (std::thread &Thread : Threads)
+      Thread.join();
+    Success = std::none_of(Failed.get(), Failed.get() + NumPartitions,
+                           [](bool F) { return F; });
+  }
+
+  if (Success) {
+    // The linker keeps hidden symbols hidden, so that the other object files
+    // of the module can still reference them.
+    std::vector<const char *> Args;
+    Args.push_back(LinkerPath->c_str());
+    Args.push_back("-r");
+    if (Triple.isOSBinFormatMachO())
+      Args.push_back("-keep_private_externs");
+    Args.push_back("-o");
+    Args.push_back(MergedFile.c_str());
+    for (const std::string &File : PartitionFiles)
+      Args.push_back(File.c_str());
+    Args.push_back(nullptr);
+    Success = llvm::sys::ExecuteAndWait(*LinkerPath, Args.data()) == 0;
+  }
+
+  if (Success) {
+    auto Merged = llvm::MemoryBuffer::getFile(MergedFile);
+    Success = bool(Merged);
+    if (Success)
+      OS << Merged.get()->getBuffer();
+  }
+
+  for (const std::string &File : PartitionFiles)
+    if (!File.empty())
+      llvm::sys::fs::remove(File);
+  if (!MergedFile.empty())
+    llvm::sys::fs::remove(MergedFile);
+  return Success;
+}
+
 /// Run the LLVM passes. In multi-threaded compilation this will be done for
 /// multiple LLVM modules in parallel.
 static bool performLLVM(IRGenOptions &Opts, DiagnosticEngine &Diags,
@@ -204,6 +501,24 @@ static bool performLLVM(IRGenOptions &Opts, DiagnosticEngine &Diags,
                         llvm::Module *Module,
                         llvm::TargetMachine *TargetMachine,
                         StringRef OutputFilename) {
+  TraceEventScope TraceLLVM("LLVM", "frontend");
+
+  // With incremental code generation, keep the object file of the previous
+  // compilation if it was generated from the same IR. The hash is stored
+  // next to the object file and removed before the object file is rewritten,
+  // so that an interrupted compilation is never mistaken for a finished one.
+  llvm::SmallString<32> IRHash;
+  std::string HashFilename;
+  if (Opts.IncrementalCodeGen &&
+      Opts.OutputKind == IRGenOutputKind::ObjectFile &&
+      !OutputFilename.empty() && OutputFilename != "-") {
+    computeIRHash(Opts, Module, TargetMachine, IRHash);
+    HashFilename = (OutputFilename + ".irhash").str();
+    if (isOutputUpToDate(OutputFilename, HashFilename, IRHash))
+      return false;
+    llvm::sys::fs::remove(HashFilename);
+  }
+
   llvm::SmallString<0> Buffer;
   std::unique_ptr<raw_pwrite_stream> RawOS;
   if (!OutputFilename.empty()) {
@@ -234,6 +549,21 @@ static bool performLLVM(IRGenOptions &Opts, DiagnosticEngine &Diags,
 
   performLLVMOptimizations(Opts, Module, TargetMachine);
 
+  // Generate the object file on several threads if requested. This is only
+  // done if the module isn't already compiled in parallel with others.
+  if (!DiagMutex && Opts.CodeGenPartitions > 1 &&
+      Opts.OutputKind == IRGenOutputKind::ObjectFile &&
+      !OutputFilename.empty() && OutputFilename != "-" &&
+      performSplitCodeGen(Opts, Module, TargetMachine, OutputFilename,
+                          *RawOS)) {
+    if (!HashFilename.empty()) {
+      RawOS.reset();
+      writeIRHash(HashFilename, IRHash);
+    }
+    return false;
+  }
+
+  llvm::DenseMap<const llvm::Function *, uint64_t> CodeGenStartTimes;
   legacy::PassManager EmitPasses;
 
   // Set up the final emission passes.
@@ -263,6 +593,11 @@ static bool performLLVM(IRGenOptions &Opts, DiagnosticEngine &Diags,
     if (Opts.Optimize)
       EmitPasses.add(createObjCARCContractPass());
 
+    auto *Profile = FunctionTimeProfile::getActive();
+    if (Profile)
+      EmitPasses.add(new CodeGenTimerPass(*Profile, CodeGenStartTimes,
+                                          /*IsEnd=*/false));
+
     bool fail = TargetMachine->addPassesToEmitFile(EmitPasses, *RawOS,
                                                    FileType, !Opts.Verify);
     if (fail) {
@@ -273,11 +608,21 @@ static bool performLLVM(IRGenOptions &Opts, DiagnosticEngine &Diags,
         DiagMutex->unlock();
       return true;
     }
+
+    if (Profile)
+      EmitPasses.add(new CodeGenTimerPass(*Profile, CodeGenStartTimes,
+                                          /*IsEnd=*/true));
     break;
   }
   }
 
   EmitPasses.run(*Module);
+
+  if (!HashFilename.empty()) {
+    // Close the object file before recording the hash of its IR.
+    RawOS.reset();
+    writeIRHash(HashFilename, IRHash);
+  }
   return false;
 }
 
@@ -383,13 +728,26 @@ static void initLLVMModule(const IRGenModule &IGM) {
 
 /// Generates LLVM IR, runs the LLVM passes and produces the output file.
 /// All this is done in a single thread.
+/// Destroy the SIL module once all the IR has been emitted. In whole-module
+/// builds the LLVM passes are the peak of the memory usage, and the SIL
+/// module of a large module takes a good share of it.
+static void releaseSILModule(IRGenModuleDispatcher &dispatcher,
+                             std::unique_ptr<SILModule> SILMod) {
+  if (!SILMod)
+    return;
+  for (auto &entry : dispatcher)
+    entry.second->SILMod = nullptr;
+  SILMod.reset();
+}
+
 static std::unique_ptr<llvm::Module> performIRGeneration(IRGenOptions &Opts,
                                                          swift::Module *M,
                                                          SILModule *SILMod,
                                                          StringRef ModuleName,
                                                  llvm::LLVMContext &LLVMContext,
                                                        SourceFile *SF = nullptr,
-                                                       unsigned StartElem = 0) {
+                                                       unsigned StartElem = 0,
+                            std::unique_ptr<SILModule> OwnedSILMod = nullptr) {
   auto &Ctx = M->getASTContext();
   assert(!Ctx.hadError());
 
@@ -471,6 +829,9 @@ static std::unique_ptr<llvm::Module> performIRGeneration(IRGenOptions &Opts,
 
   setModuleFlags(IGM);
 
+  // Nothing needs the SIL anymore. Free it before the LLVM passes run.
+  releaseSILModule(dispatcher, std::move(OwnedSILMod));
+
   // Bail out if there are any errors.
   if (Ctx.hadError()) return nullptr;
 
@@ -508,7 +869,8 @@ static void ThreadEntryPoint(IRGenModuleDispatcher *dispatcher,
 static void performParallelIRGeneration(IRGenOptions &Opts,
                                         swift::Module *M,
                                         SILModule *SILMod,
-                                        StringRef ModuleName, int numThreads) {
+                                        StringRef ModuleName, int numThreads,
+                            std::unique_ptr<SILModule> OwnedSILMod = nullptr) {
 
   IRGenModuleDispatcher dispatcher;
   
@@ -553,6 +915,9 @@ static void performParallelIRGeneration(IRGenOptions &Opts,
     return;
   }
 
+  if (Opts.BalanceParallelPartitions)
+    dispatcher.partitionFunctionsBySize();
+
   // Emit the module contents.
   dispatcher.emitGlobalTopLevel();
   
@@ -649,6 +1014,9 @@ static void performParallelIRGeneration(IRGenOptions &Opts,
     setModuleFlags(*IGM);
   }
 
+  // Nothing needs the SIL anymore. Free it before the LLVM threads start.
+  releaseSILModule(dispatcher, std::move(OwnedSILMod));
+
   // Bail out if there are any errors.
   if (Ctx.hadError()) return;
 
@@ -691,6 +1059,21 @@ performIRGeneration(IRGenOptions &Opts, swift::Module *M, SILModule *SILMod,
   return ::performIRGeneration(Opts, M, SILMod, ModuleName, LLVMContext);
 }
 
+std::unique_ptr<llvm::Module> swift::
+performIRGeneration(IRGenOptions &Opts, swift::Module *M,
+                    std::unique_ptr<SILModule> SILMod,
+                    StringRef ModuleName, llvm::LLVMContext &LLVMContext) {
+  SILModule *SILModPtr = SILMod.get();
+  int numThreads = SILModPtr->getOptions().NumThreads;
+  if (numThreads != 0) {
+    ::performParallelIRGeneration(Opts, M, SILModPtr, ModuleName, numThreads,
+                                  std::move(SILMod));
+    return nullptr;
+  }
+  return ::performIRGeneration(Opts, M, SILModPtr, ModuleName, LLVMContext,
+                               nullptr, 0, std::move(SILMod));
+}
+
 std::unique_ptr<llvm::Module> swift::
 performIRGeneration(IRGenOptions &Opts, SourceFile &SF, SILModule *SILMod,
                     StringRef ModuleName, llvm::LLVMContext &LLVMContext,
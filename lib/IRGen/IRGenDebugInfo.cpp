@@ -17,6 +17,7 @@
 #define DEBUG_TYPE "debug-info"
 #include "IRGenDebugInfo.h"
 #include "GenOpaque.h"
+#include "GenStruct.h"
 #include "GenType.h"
 #include "Linking.h"
 #include "swift/AST/Expr.h"
@@ -1190,12 +1191,23 @@ IRGenDebugInfo::getStructMembers(NominalTypeDecl *D, Type BaseTy,
                                  unsigned Flags, unsigned &SizeInBits) {
   SmallVector<llvm::Metadata *, 16> Elements;
   unsigned OffsetInBits = 0;
+  // The fields of a struct with a compact layout are not necessarily stored
+  // in declaration order, so ask the struct layout where they are.
+  bool HasReorderedFields =
+      isa<StructDecl>(D) && D->getAttrs().hasAttribute<CompactLayoutAttr>();
   for (VarDecl *VD : D->getStoredProperties()) {
     auto memberTy =
         BaseTy->getTypeOfMember(IGM.SILMod->getSwiftModule(), VD, nullptr);
     DebugTypeInfo DbgTy(VD, IGM.getTypeInfoForUnlowered(
                                 IGM.SILMod->Types.getAbstractionPattern(VD),
                                 memberTy));
+    if (HasReorderedFields) {
+      auto StructTy = IGM.SILMod->Types.getLoweredType(BaseTy);
+      if (auto Offset = dyn_cast_or_null<llvm::ConstantInt>(
+              emitPhysicalStructMemberFixedOffset(IGM, StructTy, VD)))
+        OffsetInBits =
+            Offset->getZExtValue() * CI.getTargetInfo().getCharWidth();
+    }
     Elements.push_back(createMemberType(DbgTy, VD->getName().str(),
                                         OffsetInBits, Scope, File, Flags));
   }
@@ -1329,6 +1341,23 @@ uint64_t IRGenDebugInfo::getSizeOfBasicType(DebugTypeInfo DbgTy) {
   return BitWidth;
 }
 
+/// In multi-threaded compilation, returns a declaration of the type
+/// \p MangledName if another IRGenModule already emitted its definition, or
+/// null if this one should emit it. The object files of one module are
+/// linked together, and types are looked up by their mangled name, so one
+/// definition of each type is enough.
+llvm::DIType *IRGenDebugInfo::getDeclarationIfDefinedElsewhere(
+    unsigned Tag, StringRef Name, llvm::DIScope *Scope, llvm::DIFile *File,
+    unsigned Line, unsigned SizeInBits, unsigned AlignInBits,
+    StringRef MangledName) {
+  if (MangledName.empty() ||
+      IGM.dispatcher.claimDebugTypeDefinition(MangledName, &IGM))
+    return nullptr;
+  return DBuilder.createForwardDecl(Tag, Name, Scope, File, Line,
+                                    llvm::dwarf::DW_LANG_Swift, SizeInBits,
+                                    AlignInBits, MangledName);
+}
+
 /// Convenience function that creates a forward declaration for PointeeTy.
 llvm::DIType *IRGenDebugInfo::createPointerSizedStruct(
     llvm::DIScope *Scope, StringRef Name, llvm::DIFile *File, unsigned Line,
@@ -1471,6 +1500,11 @@ llvm::DIType *IRGenDebugInfo::createType(DebugTypeInfo DbgTy,
     auto *StructTy = BaseTy->castTo<StructType>();
     auto *Decl = StructTy->getDecl();
     Location L = getLoc(SM, Decl);
+    if (auto *Declaration = getDeclarationIfDefinedElsewhere(
+            llvm::dwarf::DW_TAG_structure_type, Decl->getName().str(), Scope,
+            getOrCreateFile(L.Filename), L.Line, SizeInBits, AlignInBits,
+            MangledName))
+      return Declaration;
     return createStructType(DbgTy, Decl, StructTy, Scope,
                             getOrCreateFile(L.Filename), L.Line, SizeInBits,
                             AlignInBits, Flags,
@@ -1696,6 +1730,11 @@ llvm::DIType *IRGenDebugInfo::createType(DebugTypeInfo DbgTy,
     auto *EnumTy = BaseTy->castTo<EnumType>();
     auto *Decl = EnumTy->getDecl();
     Location L = getLoc(SM, Decl);
+    if (auto *Declaration = getDeclarationIfDefinedElsewhere(
+            llvm::dwarf::DW_TAG_union_type, Decl->getName().str(), Scope,
+            getOrCreateFile(L.Filename), L.Line, SizeInBits, AlignInBits,
+            MangledName))
+      return Declaration;
     return createEnumType(DbgTy, Decl, MangledName, Scope,
                           getOrCreateFile(L.Filename), L.Line, Flags);
   }
@@ -1704,6 +1743,11 @@ llvm::DIType *IRGenDebugInfo::createType(DebugTypeInfo DbgTy,
     auto *EnumTy = BaseTy->castTo<BoundGenericEnumType>();
     auto *Decl = EnumTy->getDecl();
     Location L = getLoc(SM, Decl);
+    if (auto *Declaration = getDeclarationIfDefinedElsewhere(
+            llvm::dwarf::DW_TAG_union_type, Decl->getName().str(), Scope,
+            getOrCreateFile(L.Filename), L.Line, SizeInBits, AlignInBits,
+            MangledName))
+      return Declaration;
     return createEnumType(DbgTy, Decl, MangledName, Scope,
                           getOrCreateFile(L.Filename), L.Line, Flags);
   }
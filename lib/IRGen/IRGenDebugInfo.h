@@ -277,6 +277,13 @@ private:
                                         llvm::DIScope *Scope,
                                         llvm::DIFile *File, unsigned Line,
                                         unsigned Flags);
+  llvm::DIType *getDeclarationIfDefinedElsewhere(unsigned Tag, StringRef Name,
+                                                 llvm::DIScope *Scope,
+                                                 llvm::DIFile *File,
+                                                 unsigned Line,
+                                                 unsigned SizeInBits,
+                                                 unsigned AlignInBits,
+                                                 StringRef MangledName);
   llvm::DIType *createPointerSizedStruct(llvm::DIScope *Scope, StringRef Name,
                                          llvm::DIFile *File, unsigned Line,
                                          unsigned Flags, StringRef MangledName);
@@ -228,11 +228,12 @@ llvm::Value *IRGenFunction::lookupTypeDataMap(CanType type, LocalTypeData index,
     return nullptr;
   
   if (auto *I = dyn_cast<llvm::Instruction>(it2->second)) {
-    // This is a very very simple dominance check: either the definition is in the
-    // entry block or in the current block.
-    // TODO: do a better dominance check.
+    // This is a simple dominance check: the definition is in the entry block,
+    // in the current block or in a block which is known to dominate the
+    // current block.
     if (I->getParent() == &CurFn->getEntryBlock() ||
-        I->getParent() == Builder.GetInsertBlock()) {
+        I->getParent() == Builder.GetInsertBlock() ||
+        DominatingBlocks.count(I->getParent())) {
       return I;
     }
     return nullptr;
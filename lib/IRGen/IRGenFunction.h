@@ -23,6 +23,7 @@
 #include "swift/SIL/SILLocation.h"
 #include "swift/SIL/SILType.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/CallingConv.h"
 #include "IRBuilder.h"
 
@@ -261,6 +262,8 @@ public:
   void emitRetain(llvm::Value *value, Explosion &explosion);
   void emitRetainCall(llvm::Value *value);
   void emitRelease(llvm::Value *value);
+  void emitNonAtomicRetainCall(llvm::Value *value);
+  void emitNonAtomicRelease(llvm::Value *value);
   void emitRetainUnowned(llvm::Value *value);
   llvm::Value *emitTryPin(llvm::Value *object);
   void emitUnpin(llvm::Value *handle);
@@ -422,6 +425,14 @@ private:
   TypeDataMap ScopedTypeDataMap;
 
   TypeDataMap ScopedTypeDataMapForLayout;
+
+public:
+  /// Blocks, in addition to the entry block and the current insert block,
+  /// which dominate the current insertion point. Scoped local type data
+  /// defined in these blocks can be reused.
+  llvm::SmallPtrSet<llvm::BasicBlock *, 8> DominatingBlocks;
+
+private:
   
   /// The value that satisfies metadata lookups for dynamic Self.
   llvm::Value *LocalSelf = nullptr;
@@ -20,6 +20,7 @@
 #include "swift/AST/IRGenOptions.h"
 #include "swift/Basic/Dwarf.h"
 #include "swift/ClangImporter/ClangImporter.h"
+#include "swift/SIL/SILModule.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/Basic/CharInfo.h"
 #include "clang/Basic/TargetInfo.h"
@@ -34,6 +35,7 @@
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/ADT/PointerUnion.h"
@@ -504,6 +506,32 @@ llvm::AttributeSet IRGenModule::getAllocAttrs() {
   return AllocAttrs;
 }
 
+llvm::MDNode *IRGenModule::getClassFieldTBAATag(VarDecl *Field) {
+  if (!Opts.Optimize || Opts.DisableTBAA)
+    return nullptr;
+
+  llvm::MDNode *&Tag = ClassFieldTBAATags[Field];
+  if (Tag)
+    return Tag;
+
+  llvm::MDBuilder MDB(LLVMContext);
+  if (!TBAARoot)
+    TBAARoot = MDB.createTBAARoot("Swift class properties");
+
+  // Properties whose names collide share a node, which is just conservative.
+  std::string Name;
+  llvm::raw_string_ostream OS(Name);
+  auto *Class = Field->getDeclContext()->isClassOrClassExtensionContext();
+  OS << Field->getModuleContext()->getName() << '.';
+  if (Class)
+    OS << Class->getName() << '.';
+  OS << Field->getName();
+
+  llvm::MDNode *Node = MDB.createTBAAScalarTypeNode(OS.str(), TBAARoot);
+  Tag = MDB.createTBAAStructTagNode(Node, Node, 0);
+  return Tag;
+}
+
 /// Construct initial attributes from options.
 llvm::AttributeSet IRGenModule::constructInitialAttributes() {
   llvm::AttributeSet attrsUpdated;
@@ -810,6 +838,42 @@ void IRGenModuleDispatcher::addGenModule(SourceFile *SF, IRGenModule *IGM) {
   Queue.push_back(IGM);
 }
 
+void IRGenModuleDispatcher::partitionFunctionsBySize() {
+  if (!hasMultipleIGMs())
+    return;
+
+  // Use the number of SIL instructions as an estimate of the time which LLVM
+  // spends on a function.
+  llvm::SmallVector<std::pair<SILFunction *, unsigned>, 64> Functions;
+  for (SILFunction &F : *PrimaryIGM->SILMod) {
+    if (!F.isDefinition())
+      continue;
+    unsigned Size = 0;
+    for (SILBasicBlock &BB : F)
+      Size += std::distance(BB.begin(), BB.end());
+    Functions.push_back({&F, Size});
+  }
+
+  // Assign the largest functions first, each to the module with the smallest
+  // total size so far. A stable sort keeps the output deterministic.
+  std::stable_sort(Functions.begin(), Functions.end(),
+                   [](const std::pair<SILFunction *, unsigned> &LHS,
+                      const std::pair<SILFunction *, unsigned> &RHS) {
+                     return LHS.second > RHS.second;
+                   });
+
+  llvm::SmallVector<unsigned, 8> PartitionSizes(Queue.size(), 0);
+  for (auto &FuncAndSize : Functions) {
+    unsigned MinIdx = 0;
+    for (unsigned Idx = 1, E = PartitionSizes.size(); Idx != E; ++Idx) {
+      if (PartitionSizes[Idx] < PartitionSizes[MinIdx])
+        MinIdx = Idx;
+    }
+    PartitionSizes[MinIdx] += FuncAndSize.second;
+    FunctionPartition[FuncAndSize.first] = Queue[MinIdx];
+  }
+}
+
 IRGenModule *IRGenModuleDispatcher::getGenModule(DeclContext *ctxt) {
   if (GenModules.size() == 1 || !ctxt) {
     return getPrimaryIGM();
@@ -828,6 +892,10 @@ IRGenModule *IRGenModuleDispatcher::getGenModule(SILFunction *f) {
     return getPrimaryIGM();
   }
 
+  auto PartitionIter = FunctionPartition.find(f);
+  if (PartitionIter != FunctionPartition.end())
+    return PartitionIter->second;
+
   if (DeclContext *ctxt = f->getDeclContext()) {
     if (SourceFile *SF = ctxt->getParentSourceFile()) {
       IRGenModule *IGM = GenModules[SF];
@@ -31,6 +31,7 @@
 #include "llvm/IR/CallingConv.h"
 #include "llvm/IR/ValueHandle.h"
 #include "llvm/IR/Attributes.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Target/TargetMachine.h"
 #include "IRGen.h"
 #include "SwiftTargetInfo.h"
@@ -97,6 +98,7 @@ namespace swift {
   class StructDecl;
   class Type;
   class TypeAliasDecl;
+  class TypeBase;
   class TypeDecl;
   class ValueDecl;
   class VarDecl;
@@ -119,6 +121,16 @@ namespace irgen {
   enum class ValueWitness : unsigned;
   enum class ReferenceCounting : unsigned char;
 
+/// A copy or destroy of a value which IRGen may outline into a helper
+/// function shared by all the values of its type.
+enum class OutlinedValueOperation : unsigned {
+  Retain,
+  Release,
+  Destroy,
+  InitializeWithCopy,
+  AssignWithCopy,
+};
+
 class IRGenModule;
 
 /// A type descriptor for a field type accessor.
@@ -188,6 +200,15 @@ public:
   }
   
   bool hasMultipleIGMs() const { return GenModules.size() >= 2; }
+
+  /// Distribute the SIL function definitions over the IRGenModules, so that
+  /// each module gets about the same number of SIL instructions, independent
+  /// of the source files the functions are defined in.
+  ///
+  /// References across modules need no special handling. In multi-threaded
+  /// compilation private symbols already get hidden linkage and shared symbols
+  /// which are referenced from other modules get weak linkage.
+  void partitionFunctionsBySize();
   
   llvm::DenseMap<SourceFile *, IRGenModule *>::iterator begin() {
     return GenModules.begin();
@@ -237,6 +258,16 @@ public:
     return it->second;
   }
   
+  /// Returns true if \p IGM should emit the full debug info definition of
+  /// the type with the mangled name \p MangledName, which is the case if no
+  /// other IRGenModule emitted it before. The others only emit a declaration
+  /// with the mangled name as its unique identifier, which is all debuggers
+  /// and dsymutil need to find the definition.
+  bool claimDebugTypeDefinition(StringRef MangledName, IRGenModule *IGM) {
+    auto Owner = DebugTypeDefinitions.insert({MangledName, IGM}).first;
+    return Owner->second == IGM;
+  }
+
   /// In multi-threaded compilation fetch the next IRGenModule from the queue.
   IRGenModule *fetchFromQueue() {
     int idx = QueueIndex++;
@@ -252,6 +283,10 @@ private:
   // Stores the IGM from which a function is referenced the first time.
   // It is used if a function has no source-file association.
   llvm::DenseMap<SILFunction *, IRGenModule *> DefaultIGMForFunction;
+
+  // The IGMs of the function definitions if functions are partitioned by size.
+  // If not empty, it overrides the source-file association.
+  llvm::DenseMap<SILFunction *, IRGenModule *> FunctionPartition;
   
   // The IGM of the first source file.
   IRGenModule *PrimaryIGM = nullptr;
@@ -284,6 +319,10 @@ private:
   /// appear in the translation unit.
   llvm::DenseMap<SILFunction*, unsigned> FunctionOrder;
 
+  /// The IRGenModule which emitted the debug info definition of each type,
+  /// by mangled name.
+  llvm::StringMap<IRGenModule *> DebugTypeDefinitions;
+
   /// The queue of IRGenModules for multi-threaded compilation.
   SmallVector<IRGenModule *, 8> Queue;
 
@@ -388,6 +427,14 @@ public:
   unsigned InvariantMetadataID; /// !invariant.load
   unsigned DereferenceableID;   /// !dereferenceable
   llvm::MDNode *InvariantNode;
+
+  /// Returns the TBAA access tag for loads and stores of the class stored
+  /// property \p Field, or null if no TBAA metadata should be emitted.
+  ///
+  /// Every property gets its own type node under a common root, so accesses
+  /// of different properties don't alias. The nodes are named after the
+  /// property, so that they agree between LLVM modules.
+  llvm::MDNode *getClassFieldTBAATag(VarDecl *Field);
   
   llvm::CallingConv::ID RuntimeCC;     /// lightweight calling convention
 
@@ -519,10 +566,30 @@ public:
                                             ArrayRef<llvm::Type*> paramTypes,
                         llvm::function_ref<void(IRGenFunction &IGF)> generate);
 
+  llvm::Function *getOutlinedValueOperation(OutlinedValueOperation op,
+                                            SILType T, const TypeInfo &ti);
+
+  /// Returns the mangled name of \p entity. Each entity is only mangled
+  /// once per IRGenModule.
+  StringRef getMangledName(const LinkEntity &entity);
+
+  /// Returns true if \p theClass cannot have subclasses: it is final, or this
+  /// is a whole-module build which other modules cannot subclass it from and
+  /// no class in the module inherits from it.
+  bool isLeafClass(ClassDecl *theClass);
+
 private:
   llvm::DenseMap<LinkEntity, llvm::Constant*> GlobalVars;
   llvm::DenseMap<LinkEntity, llvm::Constant*> GlobalGOTEquivalents;
   llvm::DenseMap<LinkEntity, llvm::Function*> GlobalFuncs;
+  llvm::DenseMap<LinkEntity, StringRef> MangledNames;
+  llvm::DenseMap<std::pair<TypeBase *, unsigned>, llvm::Function *>
+    OutlinedValueOperations;
+  /// The superclasses of the classes in the SIL module, computed by the first
+  /// call to isLeafClass.
+  llvm::DenseSet<ClassDecl *> SuperclassesInModule;
+  bool ComputedSuperclassesInModule = false;
+  llvm::BumpPtrAllocator MangledNameAllocator;
   llvm::DenseSet<const clang::Decl *> GlobalClangDecls;
   llvm::StringMap<llvm::Constant*> GlobalStrings;
   llvm::StringMap<llvm::Constant*> GlobalUTF16Strings;
@@ -610,6 +677,8 @@ private:
   Optional<llvm::Value*> ObjCRetainAutoreleasedReturnValueMarker;
   llvm::DenseMap<Identifier, ClassDecl*> SwiftRootClasses;
   llvm::AttributeSet AllocAttrs;
+  llvm::MDNode *TBAARoot = nullptr;
+  llvm::DenseMap<VarDecl *, llvm::MDNode *> ClassFieldTBAATags;
 
 #define FUNCTION_ID(Id)             \
 public:                             \
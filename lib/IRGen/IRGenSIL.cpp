@@ -20,6 +20,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/TinyPtrVector.h"
@@ -29,9 +30,11 @@
 #include "swift/Basic/Range.h"
 #include "swift/Basic/STLExtras.h"
 #include "swift/AST/ASTContext.h"
+#include "swift/AST/FunctionTimeProfile.h"
 #include "swift/AST/IRGenOptions.h"
 #include "swift/AST/Pattern.h"
 #include "swift/AST/Types.h"
+#include "swift/SIL/Dominance.h"
 #include "swift/SIL/PrettyStackTrace.h"
 #include "swift/SIL/SILDebugScope.h"
 #include "swift/SIL/SILDeclRef.h"
@@ -300,6 +303,10 @@ public:
   int EstimatedStackSize = -1;
 
   llvm::MapVector<SILBasicBlock *, LoweredBB> LoweredBBs;
+
+  /// The dominator tree of CurSILFn. It is used to reuse type metadata which
+  /// was emitted in a dominating block.
+  std::unique_ptr<DominanceInfo> Dominance;
   
   // Destination basic blocks for condfail traps.
   llvm::SmallVector<llvm::BasicBlock *, 8> FailBBs;
@@ -1238,6 +1245,11 @@ void IRGenModule::emitSILFunction(SILFunction *f) {
     return;
 
   PrettyStackTraceSILFunction stackTrace("emitting IR", f);
+  FunctionTimeProfile::Timer timer(f->getDeclContext(), f->getName(),
+                                   FunctionTimeProfile::Phase::IRGen);
+  // The LLVM passes find the source of the function by its name.
+  if (auto *profile = FunctionTimeProfile::getActive())
+    profile->setSymbolSource(f->getName(), f->getDeclContext());
   IRGenSILFunction(*this, f).emitSILFunction();
 }
 
@@ -1306,6 +1318,10 @@ void IRGenSILFunction::emitSILFunction() {
   llvm::SmallPtrSet<SILBasicBlock*, 8> visitedBlocks;
   SmallVector<SILBasicBlock*, 8> workQueue; // really a stack
 
+  // The dominator tree is only useful if there is more than one block.
+  if (std::next(CurSILFn->begin()) != CurSILFn->end())
+    Dominance.reset(new DominanceInfo(CurSILFn));
+
   // Queue up the entry block, for which the invariant trivially holds.
   visitedBlocks.insert(&*CurSILFn->begin());
   workQueue.push_back(&*CurSILFn->begin());
@@ -1416,6 +1432,16 @@ void IRGenSILFunction::visitSILBasicBlock(SILBasicBlock *BB) {
   llvm::BasicBlock *llBB = getLoweredBB(BB).bb;
   Builder.SetInsertPoint(llBB);
 
+  // All control flow into the IR of a SIL block goes through its first LLVM
+  // block. So type metadata emitted in the first LLVM block of a dominating
+  // SIL block is available in all of the IR of BB.
+  DominatingBlocks.clear();
+  if (Dominance) {
+    auto *Node = Dominance->getNode(BB);
+    for (Node = Node ? Node->getIDom() : nullptr; Node; Node = Node->getIDom())
+      DominatingBlocks.insert(getLoweredBB(Node->getBlock()).bb);
+  }
+
   bool InEntryBlock = BB->pred_empty();
   bool ArgsEmitted = false;
 
@@ -2774,11 +2800,35 @@ void IRGenSILFunction::visitCondBranchInst(swift::CondBranchInst *i) {
   Builder.CreateCondBr(condValue, trueBB.bb, falseBB.bb);
 }
 
+/// Emit a call to the outlined function which performs \p op on a value of
+/// type \p T. Returns false if the operation should be emitted inline.
+static bool emitOutlinedValueOperation(IRGenFunction &IGF,
+                                       OutlinedValueOperation op,
+                                       SILType T, const TypeInfo &ti,
+                                       ArrayRef<llvm::Value*> args) {
+  llvm::Function *fn = IGF.IGM.getOutlinedValueOperation(op, T, ti);
+  if (!fn)
+    return false;
+
+  SmallVector<llvm::Value*, 8> castArgs;
+  auto paramTy = fn->getFunctionType()->param_begin();
+  for (llvm::Value *arg : args)
+    castArgs.push_back(IGF.Builder.CreateBitCast(arg, *paramTy++));
+  llvm::CallInst *call = IGF.Builder.CreateCall(fn, castArgs);
+  call->setCallingConv(fn->getCallingConv());
+  call->setDoesNotThrow();
+  return true;
+}
+
 void IRGenSILFunction::visitRetainValueInst(swift::RetainValueInst *i) {
+  SILType T = i->getOperand().getType();
+  auto &ti = cast<LoadableTypeInfo>(getTypeInfo(T));
   Explosion in = getLoweredExplosion(i->getOperand());
+  if (emitOutlinedValueOperation(*this, OutlinedValueOperation::Retain, T, ti,
+                                 in.getAll()))
+    return;
   Explosion out;
-  cast<LoadableTypeInfo>(getTypeInfo(i->getOperand().getType()))
-    .copy(*this, in, out);
+  ti.copy(*this, in, out);
   out.claimAll();
 }
 
@@ -2793,9 +2843,13 @@ void IRGenSILFunction::visitAutoreleaseValueInst(swift::AutoreleaseValueInst *i)
 }
 
 void IRGenSILFunction::visitReleaseValueInst(swift::ReleaseValueInst *i) {
+  SILType T = i->getOperand().getType();
+  auto &ti = cast<LoadableTypeInfo>(getTypeInfo(T));
   Explosion in = getLoweredExplosion(i->getOperand());
-  cast<LoadableTypeInfo>(getTypeInfo(i->getOperand().getType()))
-    .consume(*this, in);
+  if (emitOutlinedValueOperation(*this, OutlinedValueOperation::Release, T, ti,
+                                 in.getAll()))
+    return;
+  ti.consume(*this, in);
 }
 
 void IRGenSILFunction::visitStructInst(swift::StructInst *i) {
@@ -2918,10 +2972,73 @@ void IRGenSILFunction::visitRefElementAddrInst(swift::RefElementAddrInst *i) {
   setLoweredAddress(SILValue(i, 0), field);
 }
 
+namespace {
+/// Attaches the TBAA tag of a class property to the loads and stores which
+/// are emitted for a SIL load or store of the property while this object is
+/// alive.
+///
+/// Only accesses directly based on the address of the property are tagged.
+/// Everything else is left untagged, which LLVM treats as aliasing anything.
+class ClassFieldTBAAScope {
+  IRGenSILFunction &IGF;
+  llvm::MDNode *Tag = nullptr;
+  llvm::Value *FieldAddr = nullptr;
+  llvm::BasicBlock *BB = nullptr;
+  /// The instruction before the first emitted instruction, or null if the
+  /// emitted instructions start the block.
+  llvm::Instruction *Before = nullptr;
+
+  bool isBasedOnFieldAddr(llvm::Value *Ptr) const {
+    while (Ptr != FieldAddr) {
+      if (auto *GEP = dyn_cast<llvm::GEPOperator>(Ptr))
+        Ptr = GEP->getPointerOperand();
+      else if (auto *BC = dyn_cast<llvm::BitCastOperator>(Ptr))
+        Ptr = BC->getOperand(0);
+      else
+        return false;
+    }
+    return true;
+  }
+
+public:
+  ClassFieldTBAAScope(IRGenSILFunction &IGF, SILValue Addr, Address Lowered)
+      : IGF(IGF) {
+    auto *REAI = dyn_cast<RefElementAddrInst>(Addr);
+    if (!REAI || !IGF.Builder.hasValidIP())
+      return;
+    Tag = IGF.IGM.getClassFieldTBAATag(REAI->getField());
+    if (!Tag)
+      return;
+    FieldAddr = Lowered.getAddress();
+    BB = IGF.Builder.GetInsertBlock();
+    auto IP = IGF.Builder.GetInsertPoint();
+    if (IP != BB->begin())
+      Before = &*std::prev(IP);
+  }
+
+  ~ClassFieldTBAAScope() {
+    // Give up if the access was split into several blocks.
+    if (!Tag || IGF.Builder.GetInsertBlock() != BB)
+      return;
+    auto I = Before ? std::next(Before->getIterator()) : BB->begin();
+    for (auto E = IGF.Builder.GetInsertPoint(); I != E; ++I) {
+      llvm::Value *Ptr = nullptr;
+      if (auto *LI = dyn_cast<llvm::LoadInst>(&*I))
+        Ptr = LI->getPointerOperand();
+      else if (auto *SI = dyn_cast<llvm::StoreInst>(&*I))
+        Ptr = SI->getPointerOperand();
+      if (Ptr && isBasedOnFieldAddr(Ptr))
+        I->setMetadata(llvm::LLVMContext::MD_tbaa, Tag);
+    }
+  }
+};
+} // end anonymous namespace
+
 void IRGenSILFunction::visitLoadInst(swift::LoadInst *i) {
   Explosion lowered;
   Address source = getLoweredAddress(i->getOperand());
   const TypeInfo &type = getTypeInfo(i->getType().getObjectType());
+  ClassFieldTBAAScope TBAA(*this, i->getOperand(), source);
   cast<LoadableTypeInfo>(type).loadAsTake(*this, source, lowered);
   setLoweredExplosion(SILValue(i, 0), lowered);
 }
@@ -2930,6 +3047,7 @@ void IRGenSILFunction::visitStoreInst(swift::StoreInst *i) {
   Explosion source = getLoweredExplosion(i->getSrc());
   Address dest = getLoweredAddress(i->getDest());
   auto &type = getTypeInfo(i->getSrc().getType().getObjectType());
+  ClassFieldTBAAScope TBAA(*this, i->getDest(), dest);
   cast<LoadableTypeInfo>(type).initialize(*this, source, dest);
 }
 
@@ -3069,15 +3187,36 @@ void IRGenSILFunction::visitStrongUnpinInst(swift::StrongUnpinInst *i) {
   emitUnpin(pinHandle);
 }
 
+/// Returns true if the non-atomic runtime entry points can be used for a
+/// reference counting instruction.  Only native Swift reference counting has
+/// non-atomic variants.
+static bool canUseNonAtomicRefCounting(RefCountingInst *i,
+                                       const ReferenceTypeInfo &ti) {
+  if (!i->isNonAtomic())
+    return false;
+  ReferenceCounting refcounting;
+  return ti.isSingleRetainablePointer(ResilienceScope::Component,
+                                      &refcounting) &&
+         refcounting == ReferenceCounting::Native;
+}
+
 void IRGenSILFunction::visitStrongRetainInst(swift::StrongRetainInst *i) {
   Explosion lowered = getLoweredExplosion(i->getOperand());
   auto &ti = cast<ReferenceTypeInfo>(getTypeInfo(i->getOperand().getType()));
+  if (canUseNonAtomicRefCounting(i, ti)) {
+    emitNonAtomicRetainCall(lowered.claimNext());
+    return;
+  }
   ti.retain(*this, lowered);
 }
 
 void IRGenSILFunction::visitStrongReleaseInst(swift::StrongReleaseInst *i) {
   Explosion lowered = getLoweredExplosion(i->getOperand());
   auto &ti = cast<ReferenceTypeInfo>(getTypeInfo(i->getOperand().getType()));
+  if (canUseNonAtomicRefCounting(i, ti)) {
+    emitNonAtomicRelease(lowered.claimNext());
+    return;
+  }
   ti.release(*this, lowered);
 }
 
@@ -3810,7 +3949,8 @@ void emitValueCheckedCast(IRGenSILFunction &IGF,
   Explosion from = IGF.getLoweredExplosion(operand);
   llvm::Value *fromValue = from.claimNext();
   llvm::Value *cast
-    = emitClassDowncast(IGF, fromValue, loweredTargetType, mode);
+    = emitClassDowncast(IGF, fromValue, loweredTargetType, mode,
+                        operand.getType());
   ex.add(cast);
 }
 
@@ -4361,6 +4501,7 @@ void IRGenSILFunction::visitCopyAddrInst(swift::CopyAddrInst *i) {
   }
   
   const TypeInfo &addrTI = getTypeInfo(addrTy);
+  llvm::Value *addresses[] = { dest.getAddress(), src.getAddress() };
 
   unsigned takeAndOrInitialize =
     (i->isTakeOfSrc() << 1U) | i->isInitializationOfDest();
@@ -4370,13 +4511,18 @@ void IRGenSILFunction::visitCopyAddrInst(swift::CopyAddrInst *i) {
   case ASSIGN | COPY:
     assert(!isFixedBufferInitialization
            && "can't assign into an unallocated buffer");
-    addrTI.assignWithCopy(*this, dest, src, addrTy);
+    if (!emitOutlinedValueOperation(*this,
+                                    OutlinedValueOperation::AssignWithCopy,
+                                    addrTy, addrTI, addresses))
+      addrTI.assignWithCopy(*this, dest, src, addrTy);
     break;
   case INITIALIZE | COPY:
     if (isFixedBufferInitialization) {
       Address addr = addrTI.initializeBufferWithCopy(*this, dest, src, addrTy);
       setAllocatedAddressForBuffer(i->getDest(), addr);
-    } else
+    } else if (!emitOutlinedValueOperation(*this,
+                                     OutlinedValueOperation::InitializeWithCopy,
+                                           addrTy, addrTI, addresses))
       addrTI.initializeWithCopy(*this, dest, src, addrTy);
     break;
   case ASSIGN | TAKE:
@@ -4400,6 +4546,9 @@ void IRGenSILFunction::visitDestroyAddrInst(swift::DestroyAddrInst *i) {
   SILType addrTy = i->getOperand().getType();
   Address base = getLoweredAddress(i->getOperand());
   const TypeInfo &addrTI = getTypeInfo(addrTy);
+  if (emitOutlinedValueOperation(*this, OutlinedValueOperation::Destroy,
+                                 addrTy, addrTI, base.getAddress()))
+    return;
   addrTI.destroy(*this, base, addrTy);
 }
 
@@ -4472,58 +4621,50 @@ void IRGenSILFunction::visitClassMethodInst(swift::ClassMethodInst *i) {
   setLoweredExplosion(SILValue(i, 0), e);
 }
 
-static llvm::Constant *getConstantValue(IRGenModule &IGM, llvm::StructType *STy,
-                                        TupleInst *TI);
+/// Generate the constant for a value in a static initializer, which was
+/// accepted by SILGlobalVariable::canBeStaticInitializer.
+static llvm::Constant *getConstantValue(IRGenModule &IGM, llvm::Type *Ty,
+                                        SILValue V);
 
-/// Generate ConstantStruct for StructInst.
-static llvm::Constant *getConstantValue(IRGenModule &IGM, llvm::StructType *STy,
-                                        StructInst *SI) {
+/// Generate a ConstantStruct for a StructInst or TupleInst.
+static llvm::Constant *getConstantAggregate(IRGenModule &IGM,
+                                            llvm::StructType *STy,
+                                            OperandValueArrayRef Operands) {
   SmallVector<llvm::Constant*, 32> Elts;
-  assert(SI->getNumOperands() == STy->getNumElements() &&
-         "mismatch StructInst with its lowered StructType!");
-  for (unsigned i = 0, e = STy->getNumElements(); i != e; ++i) {
-    if (auto *Elem = dyn_cast<StructInst>(SI->getOperand(i)))
-      Elts.push_back(getConstantValue(IGM,
-                     cast<llvm::StructType>(STy->getElementType(i)), Elem));
-    else if (auto *Elem = dyn_cast<TupleInst>(SI->getOperand(i)))
-      Elts.push_back(getConstantValue(IGM,
-                     cast<llvm::StructType>(STy->getElementType(i)), Elem));
-    else if (auto *ILI = dyn_cast<IntegerLiteralInst>(SI->getOperand(i)))
-      Elts.push_back(getConstantInt(IGM, ILI));
-    else if (auto *FLI = dyn_cast<FloatLiteralInst>(SI->getOperand(i)))
-      Elts.push_back(getConstantFP(IGM, FLI));
-    else if (auto *SLI = dyn_cast<StringLiteralInst>(SI->getOperand(i)))
-      Elts.push_back(getAddrOfString(IGM, SLI->getValue(), SLI->getEncoding()));
-    else
-      llvm_unreachable("Unexpected SILInstruction in static initializer!");
-  }
+  assert(Operands.size() == STy->getNumElements() &&
+         "mismatch aggregate with its lowered StructType!");
+  for (unsigned i = 0, e = STy->getNumElements(); i != e; ++i)
+    Elts.push_back(getConstantValue(IGM, STy->getElementType(i),
+                                    Operands[i]));
   return llvm::ConstantStruct::get(STy, Elts);
 }
 
-
-/// Generate ConstantStruct for StructInst.
-static llvm::Constant *getConstantValue(IRGenModule &IGM, llvm::StructType *STy,
-                                        TupleInst *TI) {
-  SmallVector<llvm::Constant*, 32> Elts;
-  assert(TI->getNumOperands() == STy->getNumElements() &&
-         "mismatch StructInst with its lowered StructType!");
-  for (unsigned i = 0, e = STy->getNumElements(); i != e; ++i) {
-    if (auto *Elem = dyn_cast<StructInst>(TI->getOperand(i)))
-      Elts.push_back(getConstantValue(IGM,
-                     cast<llvm::StructType>(STy->getElementType(i)), Elem));
-    else if (auto *Elem = dyn_cast<TupleInst>(TI->getOperand(i)))
-      Elts.push_back(getConstantValue(IGM,
-                     cast<llvm::StructType>(STy->getElementType(i)), Elem));
-    else if (auto *ILI = dyn_cast<IntegerLiteralInst>(TI->getOperand(i)))
-      Elts.push_back(getConstantInt(IGM, ILI));
-    else if (auto *FLI = dyn_cast<FloatLiteralInst>(TI->getOperand(i)))
-      Elts.push_back(getConstantFP(IGM, FLI));
-    else if (auto *SLI = dyn_cast<StringLiteralInst>(TI->getOperand(i)))
-      Elts.push_back(getAddrOfString(IGM, SLI->getValue(), SLI->getEncoding()));
-    else
-      llvm_unreachable("Unexpected SILInstruction in static initializer!");
-  }
-  return llvm::ConstantStruct::get(STy, Elts);
+static llvm::Constant *getConstantValue(IRGenModule &IGM, llvm::Type *Ty,
+                                        SILValue V) {
+  if (auto *SI = dyn_cast<StructInst>(V))
+    return getConstantAggregate(IGM, cast<llvm::StructType>(Ty),
+                                SI->getElements());
+  if (auto *TI = dyn_cast<TupleInst>(V))
+    return getConstantAggregate(IGM, cast<llvm::StructType>(Ty),
+                                TI->getElements());
+  if (auto *EI = dyn_cast<EnumInst>(V)) {
+    assert(!EI->hasOperand() && "enum payloads are not static initializers");
+    return getEnumImplStrategy(IGM, EI->getType())
+      .getConstantNoPayloadValue(EI->getElement());
+  }
+  if (auto *ILI = dyn_cast<IntegerLiteralInst>(V))
+    return getConstantInt(IGM, ILI);
+  if (auto *FLI = dyn_cast<FloatLiteralInst>(V))
+    return getConstantFP(IGM, FLI);
+  if (auto *SLI = dyn_cast<StringLiteralInst>(V))
+    return getAddrOfString(IGM, SLI->getValue(), SLI->getEncoding());
+  if (auto *BI = dyn_cast<BuiltinInst>(V)) {
+    assert(BI->getBuiltinInfo().ID == BuiltinValueKind::FPTrunc &&
+           "unexpected builtin in static initializer!");
+    auto *FLI = cast<FloatLiteralInst>(BI->getArguments()[0]);
+    return llvm::ConstantExpr::getFPTrunc(getConstantFP(IGM, FLI), Ty);
+  }
+  llvm_unreachable("Unexpected SILInstruction in static initializer!");
 }
 
 void IRGenModule::emitSILStaticInitializer() {
@@ -4542,21 +4683,11 @@ void IRGenModule::emitSILStaticInitializer() {
       continue;
 
     if (auto *STy = dyn_cast<llvm::StructType>(gvar->getInitializer()->getType())) {
+      // Get the StructInst, TupleInst or EnumInst that we write to the
+      // SILGlobalVariable.
       auto *InitValue = v.getValueOfStaticInitializer();
-
-      // Get the StructInst that we write to the SILGlobalVariable.
-      if (auto *SI = dyn_cast<StructInst>(InitValue)) {
-        gvar->setInitializer(getConstantValue(*this, STy, SI));
-        continue;
-      }
-
-      // Get the TupleInst that we write to the SILGlobalVariable.
-      if (auto *TI = dyn_cast<TupleInst>(InitValue)) {
-        gvar->setInitializer(getConstantValue(*this, STy, TI));
-        continue;
-      }
-
-      llvm_unreachable("We only handle StructInst and TupleInst for now!");
+      gvar->setInitializer(getConstantValue(*this, STy, InitValue));
+      continue;
     }
 
     llvm_unreachable("We only handle StructType for now!");
@@ -14,6 +14,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -204,9 +205,27 @@ bool StructLayoutBuilder::addFields(llvm::MutableArrayRef<ElementLayout> elts,
   // Track whether we've added any storage to our layout.
   bool addedStorage = false;
 
+  // Decide the order in which the elements are placed in memory.  The
+  // elements themselves stay in declaration order, so projections,
+  // explosions and field offset vectors are unaffected.
+  SmallVector<ElementLayout *, 8> order;
+  for (auto &elt : elts)
+    order.push_back(&elt);
+  if (strategy == LayoutStrategy::Compact &&
+      std::all_of(elts.begin(), elts.end(), [](const ElementLayout &elt) {
+        return isa<FixedTypeInfo>(elt.getType());
+      })) {
+    std::stable_sort(order.begin(), order.end(),
+                     [](ElementLayout *lhs, ElementLayout *rhs) {
+      return cast<FixedTypeInfo>(lhs->getType()).getFixedAlignment()
+               > cast<FixedTypeInfo>(rhs->getType()).getFixedAlignment();
+    });
+  }
+
   // Loop through the elements.  The only valid field in each element
   // is Type; StructIndex and ByteOffset need to be laid out.
-  for (auto &elt : elts) {
+  for (auto *eltPtr : order) {
+    auto &elt = *eltPtr;
     auto &eltTI = elt.getType();
     IsKnownPOD &= eltTI.isPOD(ResilienceScope::Component);
     IsKnownBitwiseTakable &= eltTI.isBitwiseTakable(ResilienceScope::Component);
@@ -219,10 +238,8 @@ bool StructLayoutBuilder::addFields(llvm::MutableArrayRef<ElementLayout> elts,
       // Anything else we do at least potentially adds storage requirements.
       addedStorage = true;
 
-      // TODO: consider using different layout rules.
-      // If the rules are changed so that fields aren't necessarily laid
-      // out sequentially, the computation of InstanceStart in the
-      // RO-data will need to be fixed.
+      // Classes are always laid out sequentially; if that changes, the
+      // computation of InstanceStart in the RO-data will need to be fixed.
 
       // If this element is resiliently- or dependently-sized, record
       // that and configure the ElementLayout appropriately.
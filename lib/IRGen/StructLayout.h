@@ -44,7 +44,13 @@ enum class LayoutStrategy {
   Optimal,
 
   /// The 'universal' strategy: all modules must agree on the layout.
-  Universal
+  Universal,
+
+  /// Like the universal strategy, but if all the fields have fixed size,
+  /// lay them out by decreasing alignment instead of in declaration order
+  /// to minimize padding.  The order only depends on the field types, so
+  /// all modules still agree on the layout.
+  Compact
 };
 
 /// The kind of object being laid out.
@@ -27,14 +27,21 @@
 #include "swift/Frontend/Frontend.h"
 #include "swift/SILPasses/Passes.h"
 #include "swift/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/Config/config.h"
 #include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 
 #include <dlfcn.h>
@@ -185,6 +192,12 @@ bool swift::immediate::linkLLVMModules(llvm::Module *Module,
   return !Failed;
 }
 
+void swift::immediate::removeUnusedCode(llvm::Module &Module) {
+  llvm::legacy::PassManager PM;
+  PM.add(llvm::createGlobalDCEPass());
+  PM.run(Module);
+}
+
 bool swift::immediate::IRGenImportedModules(
     CompilerInstance &CI,
     llvm::Module &Module,
@@ -273,6 +286,88 @@ bool swift::immediate::IRGenImportedModules(
   return hadError;
 }
 
+namespace {
+/// Keeps the machine code MCJIT generates in a directory, keyed by a hash
+/// of the module's IR and the target, so that running an unchanged script
+/// again skips code generation.
+///
+/// The script is still parsed, type-checked and lowered to IR on every run,
+/// because its imports are only known after that; the IR already reflects
+/// any change to the source, the imported modules or the options.
+class ImmediateObjectCache : public llvm::ObjectCache {
+  std::string Directory;
+  std::string TargetKey;
+  /// The cache file of each module looked up, since code generation may
+  /// change the module before notifyObjectCompiled sees it again.
+  llvm::DenseMap<const llvm::Module *, std::string> Paths;
+
+public:
+  ImmediateObjectCache(StringRef directory, StringRef CPU,
+                       ArrayRef<std::string> features)
+      : Directory(directory), TargetKey(CPU) {
+    for (auto &feature : features) {
+      TargetKey += ',';
+      TargetKey += feature;
+    }
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer>
+  getObject(const llvm::Module *M) override {
+    SmallString<0> bitcode;
+    {
+      llvm::raw_svector_ostream out(bitcode);
+      llvm::WriteBitcodeToFile(M, out);
+    }
+
+    llvm::MD5 hash;
+    hash.update(TargetKey);
+    hash.update(bitcode);
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    SmallString<32> key;
+    llvm::MD5::stringifyResult(result, key);
+
+    SmallString<128> path(Directory);
+    llvm::sys::path::append(path, key.str() + ".o");
+    Paths[M] = path.str();
+
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer)
+      return nullptr;
+    DEBUG(llvm::dbgs() << "Using cached object " << path << '\n');
+    return std::move(buffer.get());
+  }
+
+  void notifyObjectCompiled(const llvm::Module *M,
+                            llvm::MemoryBufferRef object) override {
+    auto found = Paths.find(M);
+    if (found == Paths.end())
+      return;
+    StringRef path = found->second;
+
+    // Write to a temporary file first, so that concurrent runs never see a
+    // partial object. Failing to cache isn't an error.
+    if (llvm::sys::fs::create_directories(Directory))
+      return;
+    int fd;
+    SmallString<128> tempPath;
+    if (llvm::sys::fs::createUniqueFile(path + "-%%%%%%%%.tmp", fd, tempPath))
+      return;
+    {
+      llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+      out << object.getBuffer();
+      if (out.has_error()) {
+        out.clear_error();
+        llvm::sys::fs::remove(tempPath);
+        return;
+      }
+    }
+    if (llvm::sys::fs::rename(tempPath, path))
+      llvm::sys::fs::remove(tempPath);
+  }
+};
+} // end anonymous namespace
+
 int swift::RunImmediately(CompilerInstance &CI, const ProcessCmdLine &CmdLine,
                           IRGenOptions &IRGenOpts, const SILOptions &SILOpts) {
   ASTContext &Context = CI.getASTContext();
@@ -305,6 +400,11 @@ int swift::RunImmediately(CompilerInstance &CI, const ProcessCmdLine &CmdLine,
     return -1;
   }
 
+  // MCJIT generates code for every function it's given, so drop the ones
+  // nothing can call first, such as unused specializations and the
+  // transparent functions linked in from imported modules.
+  removeUnusedCode(*Module);
+
   // Build the ExecutionEngine.
   llvm::EngineBuilder builder(std::move(ModuleOwner));
   std::string ErrorMsg;
@@ -325,6 +425,12 @@ int swift::RunImmediately(CompilerInstance &CI, const ProcessCmdLine &CmdLine,
     return -1;
   }
 
+  const std::string &CachePath =
+    CI.getInvocation().getFrontendOptions().ImmediateCachePath;
+  ImmediateObjectCache Cache(CachePath, CPU, Features);
+  if (!CachePath.empty())
+    EE->setObjectCache(&Cache);
+
   DEBUG(llvm::dbgs() << "Module to be executed:\n";
         Module->dump());
 
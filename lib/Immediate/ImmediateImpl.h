@@ -39,6 +39,12 @@ bool tryLoadLibraries(ArrayRef<LinkLibrary> LinkLibraries,
                       SearchPathOptions SearchPathOpts,
                       DiagnosticEngine &Diags);
 bool linkLLVMModules(llvm::Module *Module, llvm::Module *SubModule);
+
+/// Removes the functions and globals of \p Module which are neither
+/// externally visible nor referenced, so that the JIT doesn't generate code
+/// for them.
+void removeUnusedCode(llvm::Module &Module);
+
 bool IRGenImportedModules(
     CompilerInstance &CI,
     llvm::Module &Module,
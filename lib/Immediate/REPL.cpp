@@ -881,6 +881,11 @@ private:
 
     Module->getFunction("main")->eraseFromParent();
 
+    // Only generate code for what this line can reach. This must happen
+    // before stripPreviouslyGenerated marks the functions as generated; the
+    // ones removed here stay in Module and are generated by the first line
+    // which uses them.
+    removeUnusedCode(*NewModule);
     stripPreviouslyGenerated(*NewModule);
 
     if (!linkLLVMModules(&DumpModule, SaveLineModule.get()
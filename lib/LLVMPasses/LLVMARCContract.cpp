@@ -15,6 +15,7 @@
 #include "ARCEntryPointBuilder.h"
 #include "LLVMARCOpts.h"
 #include "swift/Basic/Fallthrough.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Verifier.h"
@@ -58,6 +59,12 @@ struct LocalState {
 ///   - Merging together retain and release calls into retain_n, release_n
 ///   - calls.
 ///
+/// Merging is done over extended straight-line regions: a chain of blocks in
+/// which each block unconditionally branches to a successor which has no
+/// other predecessors. Every block in such a chain is executed whenever the
+/// first is, so merging across the block boundaries is as safe as merging
+/// within one block.
+///
 /// Coming into this function, we assume that the code is in canonical form:
 /// none of these calls have any uses of their return values.
 class SwiftARCContractImpl {
@@ -80,6 +87,12 @@ public:
   bool run();
 
 private:
+  /// Collect the retains and releases of \p BB into \p PtrToLocalStateMap,
+  /// flushing the state at unknown calls.
+  void
+  processBlock(BasicBlock &BB,
+               DenseMap<Value *, LocalState> &PtrToLocalStateMap);
+
   /// Perform the RRN Optimization given the current state that we are
   /// tracking. This is called at the end of BBs and if we run into an unknown
   /// call.
@@ -212,121 +225,156 @@ performRRNOptimization(DenseMap<Value *, LocalState> &PtrToLocalStateMap) {
 }
 
 
-bool SwiftARCContractImpl::run() {
-  // intra-BB retain/release merging.
-  DenseMap<Value *, LocalState> PtrToLocalStateMap;
-  for (BasicBlock &BB : F) {
-    for (auto II = BB.begin(), IE = BB.end(); II != IE; ) {
-      // Preincrement iterator to avoid iteration issues in the loop.
-      Instruction &Inst = *II++;
-
-      auto Kind = classifyInstruction(Inst);
-      switch (Kind) {
-      // These instructions should not reach here based on the pass ordering.
-      // i.e. LLVMARCOpt -> LLVMContractOpt.
-      case RT_RetainN:
-      case RT_UnknownRetainN:
-      case RT_BridgeRetainN:
-      case RT_ReleaseN:
-      case RT_UnknownReleaseN:
-      case RT_BridgeReleaseN:
-        llvm_unreachable("These are only created by LLVMARCContract !");
-      // Delete all fix lifetime instructions. After llvm-ir they have no use
-      // and show up as calls in the final binary.
-      case RT_FixLifetime:
-        Inst.eraseFromParent();
-        ++NumNoopDeleted;
-        continue;
-      case RT_Retain: {
-        auto *CI = cast<CallInst>(&Inst);
-        auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
-
-        LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
-        LocalEntry.RetainList.push_back(CI);
-        continue;
-      }
-      case RT_UnknownRetain: {
-        auto *CI = cast<CallInst>(&Inst);
-        auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
+/// If \p BB always falls through to a successor which can only be reached
+/// from \p BB, return that successor.
+static BasicBlock *getStraightLineSuccessor(BasicBlock *BB) {
+  auto *TI = BB->getTerminator();
+  if (!TI || TI->getNumSuccessors() != 1)
+    return nullptr;
+  BasicBlock *Succ = TI->getSuccessor(0);
+  if (Succ == BB || Succ->getSinglePredecessor() != BB)
+    return nullptr;
+  return Succ;
+}
 
-        LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
-        LocalEntry.UnknownRetainList.push_back(CI);
-        continue;
-      }
-      case RT_Release: {
-        // Stash any releases that we see.
-        auto *CI = cast<CallInst>(&Inst);
-        auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
-
-        LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
-        LocalEntry.ReleaseList.push_back(CI);
-        continue;
-      }
-      case RT_UnknownRelease: {
-        // Stash any releases that we see.
-        auto *CI = cast<CallInst>(&Inst);
-        auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
-
-        LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
-        LocalEntry.UnknownReleaseList.push_back(CI);
-        continue;
-      }
-      case RT_BridgeRetain: {
-        auto *CI = cast<CallInst>(&Inst);
-        auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
+void SwiftARCContractImpl::
+processBlock(BasicBlock &BB,
+             DenseMap<Value *, LocalState> &PtrToLocalStateMap) {
+  for (auto II = BB.begin(), IE = BB.end(); II != IE; ) {
+    // Preincrement iterator to avoid iteration issues in the loop.
+    Instruction &Inst = *II++;
+
+    auto Kind = classifyInstruction(Inst);
+    switch (Kind) {
+    // These instructions should not reach here based on the pass ordering.
+    // i.e. LLVMARCOpt -> LLVMContractOpt.
+    case RT_RetainN:
+    case RT_UnknownRetainN:
+    case RT_BridgeRetainN:
+    case RT_ReleaseN:
+    case RT_UnknownReleaseN:
+    case RT_BridgeReleaseN:
+      llvm_unreachable("These are only created by LLVMARCContract !");
+    // Delete all fix lifetime instructions. After llvm-ir they have no use
+    // and show up as calls in the final binary.
+    case RT_FixLifetime:
+      Inst.eraseFromParent();
+      ++NumNoopDeleted;
+      continue;
+    case RT_Retain: {
+      auto *CI = cast<CallInst>(&Inst);
+      auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
+
+      LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
+      LocalEntry.RetainList.push_back(CI);
+      continue;
+    }
+    case RT_UnknownRetain: {
+      auto *CI = cast<CallInst>(&Inst);
+      auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
 
-        LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
-        LocalEntry.BridgeRetainList.push_back(CI);
-        continue;
-      }
-      case RT_BridgeRelease: {
-        auto *CI = cast<CallInst>(&Inst);
-        auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
+      LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
+      LocalEntry.UnknownRetainList.push_back(CI);
+      continue;
+    }
+    case RT_Release: {
+      // Stash any releases that we see.
+      auto *CI = cast<CallInst>(&Inst);
+      auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
+
+      LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
+      LocalEntry.ReleaseList.push_back(CI);
+      continue;
+    }
+    case RT_UnknownRelease: {
+      // Stash any releases that we see.
+      auto *CI = cast<CallInst>(&Inst);
+      auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
+
+      LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
+      LocalEntry.UnknownReleaseList.push_back(CI);
+      continue;
+    }
+    case RT_BridgeRetain: {
+      auto *CI = cast<CallInst>(&Inst);
+      auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
 
-        LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
-        LocalEntry.BridgeReleaseList.push_back(CI);
-        continue;
-      }
-      case RT_Unknown:
-      case RT_AllocObject:
-      case RT_NoMemoryAccessed:
-      case RT_RetainUnowned:
-      case RT_CheckUnowned:
-      case RT_ObjCRelease:
-      case RT_ObjCRetain:
-        break;
-      }
+      LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
+      LocalEntry.BridgeRetainList.push_back(CI);
+      continue;
+    }
+    case RT_BridgeRelease: {
+      auto *CI = cast<CallInst>(&Inst);
+      auto *ArgVal = RC->getSwiftRCIdentityRoot(CI->getArgOperand(0));
 
-      if (Kind != RT_Unknown)
-        continue;
-      
-      // If we have an unknown call, we need to create any retainN calls we
-      // have seen. The reason why is that we do not want to move retains,
-      // releases over isUniquelyReferenced calls. Specifically imagine this:
-      //
-      // retain(x); unknown(x); release(x); isUniquelyReferenced(x); retain(x);
-      //
-      // In this case we would with this optimization merge the last retain
-      // with the first. This would then create an additional copy. The
-      // release side of this is:
-      //
-      // retain(x); unknown(x); release(x); isUniquelyReferenced(x); release(x);
-      //
-      // Again in such a case by merging the first release with the second
-      // release, we would be introducing an additional copy.
-      //
-      // Thus if we see an unknown call we merge together all retains and
-      // releases before. This could be made more aggressive through
-      // appropriate alias analysis and usage of LLVM's function attributes to
-      // determine that a function does not touch globals.
-      performRRNOptimization(PtrToLocalStateMap);
+      LocalState &LocalEntry = PtrToLocalStateMap[ArgVal];
+      LocalEntry.BridgeReleaseList.push_back(CI);
+      continue;
+    }
+    case RT_Unknown:
+    case RT_AllocObject:
+    case RT_NoMemoryAccessed:
+    case RT_RetainUnowned:
+    case RT_CheckUnowned:
+    case RT_ObjCRelease:
+    case RT_ObjCRetain:
+      break;
     }
 
+    if (Kind != RT_Unknown)
+      continue;
+    
+    // If we have an unknown call, we need to create any retainN calls we
+    // have seen. The reason why is that we do not want to move retains,
+    // releases over isUniquelyReferenced calls. Specifically imagine this:
+    //
+    // retain(x); unknown(x); release(x); isUniquelyReferenced(x); retain(x);
+    //
+    // In this case we would with this optimization merge the last retain
+    // with the first. This would then create an additional copy. The
+    // release side of this is:
+    //
+    // retain(x); unknown(x); release(x); isUniquelyReferenced(x); release(x);
+    //
+    // Again in such a case by merging the first release with the second
+    // release, we would be introducing an additional copy.
+    //
+    // Thus if we see an unknown call we merge together all retains and
+    // releases before. This could be made more aggressive through
+    // appropriate alias analysis and usage of LLVM's function attributes to
+    // determine that a function does not touch globals.
+    performRRNOptimization(PtrToLocalStateMap);
+  }
+}
+
+bool SwiftARCContractImpl::run() {
+  // Retain/release merging over straight-line regions of blocks.
+  DenseMap<Value *, LocalState> PtrToLocalStateMap;
+  SmallPtrSet<BasicBlock *, 32> Visited;
+  for (BasicBlock &BB : F) {
+    // Blocks in the middle of a region are handled together with the head of
+    // the region. Unreachable cycles of such blocks are handled below.
+    BasicBlock *Pred = BB.getSinglePredecessor();
+    if (Pred && getStraightLineSuccessor(Pred) == &BB)
+      continue;
+
+    for (BasicBlock *Cur = &BB; Cur && Visited.insert(Cur).second;
+         Cur = getStraightLineSuccessor(Cur))
+      processBlock(*Cur, PtrToLocalStateMap);
+
     // Perform the RRNOptimization.
     performRRNOptimization(PtrToLocalStateMap);
     PtrToLocalStateMap.clear();
   }
 
+  for (BasicBlock &BB : F) {
+    if (!Visited.insert(&BB).second)
+      continue;
+    processBlock(BB, PtrToLocalStateMap);
+    performRRNOptimization(PtrToLocalStateMap);
+    PtrToLocalStateMap.clear();
+  }
+
   return Changed;
 }
 
@@ -28,6 +28,8 @@
 // FIXME: Figure out if this can be migrated to LLVM.
 #include "clang/Basic/CharInfo.h"
 
+#include <cstring>
+
 using namespace swift;
 
 // clang::isIdentifierHead and clang::isIdentifierBody are deliberately not in
@@ -281,6 +283,53 @@ Lexer::State Lexer::getStateForBeginningOfTokenLoc(SourceLoc Loc) const {
   return State(SourceLoc(llvm::SMLoc::getFromPointer(Ptr)));
 }
 
+//===----------------------------------------------------------------------===//
+// Word-at-a-time scanning helpers
+//===----------------------------------------------------------------------===//
+
+// The bodies of comments and string literals are mostly plain ASCII that the
+// lexer only needs to step over.  These helpers test eight bytes at a time so
+// those runs can be skipped without going through the per-character switch;
+// any word with a byte that needs a closer look is left to the slow path.
+
+static const uint64_t OnesPerByte = ~0ULL / 0xFF;
+static const uint64_t HighBitPerByte = OnesPerByte * 0x80;
+
+/// Returns true if there are at least eight bytes between \p Ptr and the end
+/// of the buffer, so that a whole word can be loaded from \p Ptr.
+static bool canLoadWord(const char *Ptr, const char *BufferEnd) {
+  return BufferEnd - Ptr >= (ptrdiff_t)sizeof(uint64_t);
+}
+
+static uint64_t loadWord(const char *Ptr) {
+  uint64_t Word;
+  memcpy(&Word, Ptr, sizeof(Word));
+  return Word;
+}
+
+/// Returns true if any byte of \p Word is less than \p N (which must be at
+/// most 0x80) or has its high bit set.
+static bool hasByteLessThanOrHigh(uint64_t Word, unsigned char N) {
+  return (((Word - OnesPerByte * N) | Word) & HighBitPerByte) != 0;
+}
+
+/// Returns true if any byte of \p Word is equal to \p C.
+static bool hasByte(uint64_t Word, unsigned char C) {
+  uint64_t Xor = Word ^ (OnesPerByte * C);
+  return ((Xor - OnesPerByte) & ~Xor & HighBitPerByte) != 0;
+}
+
+/// Skips a run of spaces and tabs, such as the indentation at the start of a
+/// line.
+static const char *skipHorizontalSpace(const char *Ptr,
+                                       const char *BufferEnd) {
+  while (canLoadWord(Ptr, BufferEnd) && loadWord(Ptr) == OnesPerByte * ' ')
+    Ptr += sizeof(uint64_t);
+  while (*Ptr == ' ' || *Ptr == '\t')
+    ++Ptr;
+  return Ptr;
+}
+
 //===----------------------------------------------------------------------===//
 // Lexer Subroutines
 //===----------------------------------------------------------------------===//
@@ -300,6 +349,11 @@ static void diagnoseEmbeddedNul(DiagnosticEngine *Diags, const char *Ptr) {
 
 void Lexer::skipToEndOfLine() {
   while (1) {
+    // Skip runs of ASCII that can't end the line a word at a time.
+    while (canLoadWord(CurPtr, BufferEnd) &&
+           !hasByteLessThanOrHigh(loadWord(CurPtr), '\r' + 1))
+      CurPtr += sizeof(uint64_t);
+
     switch (*CurPtr++) {
     case '\n':
     case '\r':
@@ -353,6 +407,16 @@ void Lexer::skipSlashStarComment() {
   unsigned Depth = 1;
   
   while (1) {
+    // Skip runs of ASCII that can't open or close a comment, or end a line,
+    // a word at a time.
+    while (canLoadWord(CurPtr, BufferEnd)) {
+      uint64_t Word = loadWord(CurPtr);
+      if (hasByteLessThanOrHigh(Word, '\r' + 1) || hasByte(Word, '*') ||
+          hasByte(Word, '/'))
+        break;
+      CurPtr += sizeof(uint64_t);
+    }
+
     switch (*CurPtr++) {
     case '*':
       // Check for a '*/'
@@ -549,7 +613,15 @@ void Lexer::lexIdentifier() {
   (void) didStart;
 
   // Lex [a-zA-Z_$0-9[[:XID_Continue:]]]*
-  while (advanceIfValidContinuationOfIdentifier(CurPtr, BufferEnd));
+  while (true) {
+    // ASCII continuation characters don't need to be decoded.
+    if (clang::isIdentifierBody(*CurPtr, /*dollar*/true)) {
+      ++CurPtr;
+      continue;
+    }
+    if (!advanceIfValidContinuationOfIdentifier(CurPtr, BufferEnd))
+      break;
+  }
 
   tok Kind = kindOfIdentifier(StringRef(TokStart, CurPtr-TokStart), InSILMode);
   return formToken(Kind, TokStart);
@@ -1129,6 +1201,16 @@ void Lexer::lexStringLiteral() {
   bool wasErroneous = false;
   
   while (true) {
+    // Skip runs of printable ASCII that can't end the literal or start an
+    // escape a word at a time.
+    while (canLoadWord(CurPtr, BufferEnd)) {
+      uint64_t Word = loadWord(CurPtr);
+      if (hasByteLessThanOrHigh(Word, ' ') || hasByte(Word, 0x7F) ||
+          hasByte(Word, '"') || hasByte(Word, '\'') || hasByte(Word, '\\'))
+        break;
+      CurPtr += sizeof(uint64_t);
+    }
+
     if (*CurPtr == '\\' && *(CurPtr + 1) == '(') {
       // Consume tokens until we hit the corresponding ')'.
       CurPtr += 2;
@@ -1461,10 +1543,14 @@ Restart:
   case '\n':
   case '\r':
     NextToken.setAtStartOfLine(true);
+    CurPtr = skipHorizontalSpace(CurPtr, BufferEnd);
     goto Restart;  // Skip whitespace.
 
   case ' ':
   case '\t':
+    CurPtr = skipHorizontalSpace(CurPtr, BufferEnd);
+    goto Restart;  // Skip whitespace.
+
   case '\f':
   case '\v':
     goto Restart;  // Skip whitespace.
@@ -184,7 +184,7 @@ namespace {
   struct IgnorePrivateDeclTokens {
     Parser &TheParser;
     DeclAttributes &Attributes;
-    Optional<llvm::MD5> SavedHashState;
+    Optional<SourceFile::InterfaceHashState> SavedHashState;
 
     IgnorePrivateDeclTokens(Parser &P, DeclAttributes &Attrs)
       : TheParser(P), Attributes(Attrs) {
@@ -208,6 +208,73 @@ namespace {
       }
     }
   };
+
+  /// An RAII type to hash the tokens of a member of a struct, enum, or
+  /// extension separately from the rest of the source file. On destruct, it
+  /// checks whether the parsed declarations can affect the layout of the
+  /// type; if not, the hash is recorded for those declarations, so that the
+  /// dependency information can tell edits to these members apart from edits
+  /// to the rest of the interface. Otherwise the hash is folded back into the
+  /// enclosing one.
+  ///
+  /// Class and protocol members are never hashed separately: adding or
+  /// removing one changes the class's vtable or the protocol's witness tables.
+  struct HashMemberTokens {
+    Parser &TheParser;
+    SmallVectorImpl<Decl *> &Entries;
+    size_t FirstEntry;
+    bool IsActive = false;
+
+    HashMemberTokens(Parser &P, SmallVectorImpl<Decl *> &Entries)
+      : TheParser(P), Entries(Entries), FirstEntry(Entries.size()) {
+      DeclContext *DC = TheParser.CurDeclContext;
+      if (TheParser.IsParsingInterfaceTokens &&
+          (isa<ExtensionDecl>(DC) || isa<StructDecl>(DC) ||
+           isa<EnumDecl>(DC))) {
+        TheParser.SF.beginMemberInterfaceHash();
+        IsActive = true;
+      }
+    }
+
+    /// Returns true if adding or removing \p D can change the layout of the
+    /// type it is a member of.
+    bool canAffectLayout(const Decl *D) const {
+      switch (D->getKind()) {
+      case DeclKind::Func:
+      case DeclKind::Constructor:
+      case DeclKind::Subscript:
+      case DeclKind::TypeAlias:
+        return false;
+      case DeclKind::PatternBinding:
+        // The individual variables are checked instead.
+        return false;
+      case DeclKind::Var: {
+        if (isa<ExtensionDecl>(TheParser.CurDeclContext))
+          return false;
+        auto *VD = cast<VarDecl>(D);
+        return !VD->isStatic() && VD->hasStorage();
+      }
+      default:
+        return true;
+      }
+    }
+
+    ~HashMemberTokens() {
+      if (!IsActive)
+        return;
+
+      SmallVector<const ValueDecl *, 4> Members;
+      for (const Decl *D : llvm::makeArrayRef(Entries).slice(FirstEntry)) {
+        if (canAffectLayout(D)) {
+          Members.clear();
+          break;
+        }
+        if (auto *VD = dyn_cast<ValueDecl>(D))
+          Members.push_back(VD);
+      }
+      TheParser.SF.endMemberInterfaceHash(Members);
+    }
+  };
 }
 
 /// \brief Main entrypoint for the parser.
@@ -711,6 +778,7 @@ bool Parser::parseNewDeclAttribute(DeclAttributes &Attributes, SourceLoc AtLoc,
   }
 
   case DAK_Available: {
+    SF.HasAvailabilityAnnotations = true;
     if (!consumeIf(tok::l_paren)) {
       diagnose(Loc, diag::attr_expected_lparen, AttrName,
                DeclAttribute::isDeclModifier(DK));
@@ -1780,6 +1848,7 @@ ParserStatus Parser::parseDecl(SmallVectorImpl<Decl*> &Entries,
 
   DeclAttributes Attributes;
   IgnorePrivateDeclTokens IgnoreTokens(*this, Attributes);
+  HashMemberTokens HashMember(*this, Entries);
   if (Tok.hasComment())
     Attributes.add(new (Context) RawDocCommentAttr(Tok.getCommentRange()));
   bool FoundCCTokenInAttr;
@@ -4123,6 +4192,58 @@ bool Parser::parseAbstractFunctionBodyDelayed(AbstractFunctionDecl *AFD) {
   return false;
 }
 
+/// \brief Parse the brace statement between \p LBraceLoc and \p RBraceLoc as
+/// the new body of \p AFD, which already has a body that might have been
+/// type-checked.
+///
+/// \returns true on error, or if the new body does not end at \p RBraceLoc.
+bool Parser::parseAbstractFunctionBodyReplacement(AbstractFunctionDecl *AFD,
+                                                   SourceLoc LBraceLoc,
+                                                   SourceLoc RBraceLoc) {
+  auto BeginLexerState = L->getStateForBeginningOfTokenLoc(LBraceLoc);
+  auto EndLexerState = L->getStateForEndOfTokenLoc(RBraceLoc);
+
+  // ParserPositionRAII needs a primed parser to restore to.
+  if (Tok.is(tok::NUM_TOKENS))
+    consumeToken();
+
+  // Ensure that we restore the parser state at exit.
+  ParserPositionRAII PPR(*this);
+
+  // Create a lexer that can not go past the end state.
+  Lexer LocalLex(*L, BeginLexerState, EndLexerState);
+
+  // Temporarily swap out the parser's current lexer with our new one.
+  llvm::SaveAndRestore<Lexer *> T(L, &LocalLex);
+
+  // Rewind to '{' of the function body.
+  restoreParserPosition(ParserPosition(BeginLexerState, SourceLoc()));
+
+  // The lexical scope of the original body is gone, so rebuild it from the
+  // signature. Names declared outside of the function are found by name
+  // binding, as they would be from a non-resolvable scope anyway.
+  Scope TopLevel(this, ScopeKind::TopLevel);
+  ScopeKind Kind = ScopeKind::FunctionBody;
+  if (isa<ConstructorDecl>(AFD))
+    Kind = ScopeKind::ConstructorBody;
+  else if (isa<DestructorDecl>(AFD))
+    Kind = ScopeKind::DestructorBody;
+  Scope S(this, Kind);
+  if (auto *GenericParams = AFD->getGenericParams())
+    for (auto *Param : *GenericParams)
+      addToScope(Param);
+  addPatternVariablesToScope(AFD->getBodyParamPatterns());
+  ParseFunctionBody CC(*this, AFD);
+
+  ParserResult<BraceStmt> Body =
+      parseBraceItemList(diag::func_decl_without_brace);
+  if (Body.isNull() || Body.get()->getRBraceLoc() != RBraceLoc)
+    return true;
+
+  AFD->setBody(Body.get());
+  return false;
+}
+
 /// \brief Parse a 'enum' declaration, returning true (and doing no token
 /// skipping) on error.
 ///
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "swift/Basic/Demangle.h"
 #include "swift/Basic/Fallthrough.h"
 #include "swift/AST/ArchetypeBuilder.h"
 #include "swift/AST/NameLookup.h"
@@ -1929,8 +1930,6 @@ bool SILParser::parseSILInstruction(SILBasicBlock *BB) {
   UNARY_INSTRUCTION(FixLifetime)
   UNARY_INSTRUCTION(CopyBlock)
   UNARY_INSTRUCTION(StrongPin)
-  UNARY_INSTRUCTION(StrongRetain)
-  UNARY_INSTRUCTION(StrongRelease)
   UNARY_INSTRUCTION(StrongRetainAutoreleased)
   UNARY_INSTRUCTION(StrongUnpin)
   UNARY_INSTRUCTION(AutoreleaseReturn)
@@ -1949,6 +1948,20 @@ bool SILParser::parseSILInstruction(SILBasicBlock *BB) {
   UNARY_INSTRUCTION(DebugValueAddr)
 #undef UNARY_INSTRUCTION
 
+  case ValueKind::StrongRetainInst:
+  case ValueKind::StrongReleaseInst: {
+    bool NonAtomic = false;
+    if (parseSILOptional(NonAtomic, *this, "nonatomic") ||
+        parseTypedValueRef(Val, B))
+      return true;
+
+    if (Opcode == ValueKind::StrongRetainInst)
+      ResultVal = B.createStrongRetain(InstLoc, Val, NonAtomic);
+    else
+      ResultVal = B.createStrongRelease(InstLoc, Val, NonAtomic);
+    break;
+  }
+
   case ValueKind::LoadWeakInst: {
     bool isTake = false;
     if (parseSILOptional(isTake, *this, "take") ||
@@ -3553,6 +3566,16 @@ bool SILParser::parseSILBasicBlock() {
 ///     'sil' sil-linkage '@' identifier ':' sil-type decl-sil-body?
 ///   decl-sil-body:
 ///     '{' sil-basic-block+ '}'
+/// Returns true if the body of the function \p FnName should be parsed
+/// rather than skipped, per SILOptions::ParseOnlyFunctionBody.
+static bool shouldParseFunctionBody(const SILOptions &Opts, StringRef FnName) {
+  StringRef Wanted = Opts.ParseOnlyFunctionBody;
+  if (Wanted.empty() || Wanted.startswith("_T"))
+    return Wanted.empty() || Wanted == FnName;
+  std::string Demangled = Demangle::demangleSymbolAsString(FnName);
+  return Wanted == StringRef(Demangled).substr(0, Demangled.find(' '));
+}
+
 bool Parser::parseDeclSIL() {
   // Inform the lexer that we're lexing the body of the SIL declaration.  Do
   // this before we consume the 'sil' token so that all later tokens are
@@ -3612,7 +3635,18 @@ bool Parser::parseDeclSIL() {
 
     bool isDefinition = false;
     SourceLoc LBraceLoc = Tok.getLoc();
-    if (consumeIf(tok::l_brace)) {
+    if (Tok.is(tok::l_brace) &&
+        !shouldParseFunctionBody(FunctionState.SILMod.getOptions(),
+                                 FnName.str())) {
+      // Skip the body, and make the function an external declaration.
+      consumeToken(tok::l_brace);
+      while (Tok.isNot(tok::r_brace) && Tok.isNot(tok::eof))
+        skipSingle();
+      SourceLoc RBraceLoc;
+      parseMatchingToken(tok::r_brace, RBraceLoc, diag::expected_sil_rbrace,
+                         LBraceLoc);
+      FnLinkage = SILLinkage::PublicExternal;
+    } else if (consumeIf(tok::l_brace)) {
       isDefinition = true;
       
       // FIXME: Get the generic parameters from the function type. We'll want
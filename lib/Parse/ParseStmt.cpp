@@ -1013,6 +1013,7 @@ static void validateAvailabilitySpecList(Parser &P,
 // #available(...)
 ParserResult<PoundAvailableInfo> Parser::parseStmtConditionPoundAvailable() {
   SourceLoc PoundLoc = consumeToken(tok::pound_available);
+  SF.HasAvailabilityAnnotations = true;
 
   if (!Tok.isFollowingLParen()) {
     diagnose(Tok, diag::avail_query_expected_condition);
@@ -47,6 +47,35 @@ namespace {
     }
   };
 
+/// Parses the delayed body of \p AFD.
+static void parseFunctionBody(AbstractFunctionDecl *AFD,
+                              PersistentParserState &ParserState,
+                              CodeCompletionCallbacksFactory *Factory) {
+  assert(AFD->getBodyKind() == FuncDecl::BodyKind::Unparsed);
+
+  SourceFile &SF = *AFD->getDeclContext()->getParentSourceFile();
+  SourceManager &SourceMgr = SF.getASTContext().SourceMgr;
+  unsigned BufferID = SourceMgr.findBufferContainingLoc(AFD->getLoc());
+  Parser TheParser(BufferID, SF, nullptr, &ParserState);
+
+  std::unique_ptr<CodeCompletionCallbacks> CodeCompletion;
+  if (Factory) {
+    CodeCompletion.reset(Factory->createCodeCompletionCallbacks(TheParser));
+    TheParser.setCodeCompletionCallbacks(CodeCompletion.get());
+  }
+  bool Parsed = false;
+  if (auto FD = dyn_cast<FuncDecl>(AFD)) {
+    if (FD->isAccessor()) {
+      TheParser.parseAccessorBodyDelayed(AFD);
+      Parsed = true;
+    }
+  }
+  if (!Parsed && ParserState.hasFunctionBodyState(AFD))
+    TheParser.parseAbstractFunctionBodyDelayed(AFD);
+  if (CodeCompletion)
+    CodeCompletion->doneParsing();
+}
+
 /// A visitor that does delayed parsing of function bodies.
 class ParseDelayedFunctionBodies : public ASTWalker {
   PersistentParserState &ParserState;
@@ -61,39 +90,11 @@ public:
     if (auto AFD = dyn_cast<AbstractFunctionDecl>(D)) {
       if (AFD->getBodyKind() != FuncDecl::BodyKind::Unparsed)
         return false;
-      parseFunctionBody(AFD);
+      parseFunctionBody(AFD, ParserState, CodeCompletionFactory);
       return true;
     }
     return true;
   }
-
-private:
-  void parseFunctionBody(AbstractFunctionDecl *AFD) {
-    assert(AFD->getBodyKind() == FuncDecl::BodyKind::Unparsed);
-
-    SourceFile &SF = *AFD->getDeclContext()->getParentSourceFile();
-    SourceManager &SourceMgr = SF.getASTContext().SourceMgr;
-    unsigned BufferID = SourceMgr.findBufferContainingLoc(AFD->getLoc());
-    Parser TheParser(BufferID, SF, nullptr, &ParserState);
-
-    std::unique_ptr<CodeCompletionCallbacks> CodeCompletion;
-    if (CodeCompletionFactory) {
-      CodeCompletion.reset(
-          CodeCompletionFactory->createCodeCompletionCallbacks(TheParser));
-      TheParser.setCodeCompletionCallbacks(CodeCompletion.get());
-    }
-    bool Parsed = false;
-    if (auto FD = dyn_cast<FuncDecl>(AFD)) {
-      if (FD->isAccessor()) {
-        TheParser.parseAccessorBodyDelayed(AFD);
-        Parsed = true;
-      }
-    }
-    if (!Parsed && ParserState.hasFunctionBodyState(AFD))
-      TheParser.parseAbstractFunctionBodyDelayed(AFD);
-    if (CodeCompletion)
-      CodeCompletion->doneParsing();
-  }
 };
 
 static void parseDelayedDecl(
@@ -161,6 +162,38 @@ void swift::performDelayedParsing(
     parseDelayedDecl(PersistentState, CodeCompletionFactory);
 }
 
+void swift::parseDelayedFunctionBody(AbstractFunctionDecl *AFD,
+                                     PersistentParserState &PersistentState) {
+  if (AFD->getBodyKind() == FuncDecl::BodyKind::Unparsed)
+    parseFunctionBody(AFD, PersistentState, nullptr);
+}
+
+bool swift::reparseFunctionBody(AbstractFunctionDecl *AFD,
+                                SourceLoc LBraceLoc, SourceLoc RBraceLoc,
+                                CodeCompletionCallbacksFactory *Factory) {
+  assert(AFD->getBody() && "function should already have a body");
+
+  SourceFile &SF = *AFD->getDeclContext()->getParentSourceFile();
+  SourceManager &SourceMgr = SF.getASTContext().SourceMgr;
+  unsigned BufferID = SourceMgr.findBufferContainingLoc(LBraceLoc);
+  assert(BufferID == SourceMgr.findBufferContainingLoc(RBraceLoc) &&
+         "body should be in one buffer");
+  Parser TheParser(BufferID, SF, nullptr, nullptr);
+  PrettyStackTraceParser StackTrace(TheParser);
+
+  std::unique_ptr<CodeCompletionCallbacks> CodeCompletion;
+  if (Factory) {
+    CodeCompletion.reset(Factory->createCodeCompletionCallbacks(TheParser));
+    TheParser.setCodeCompletionCallbacks(CodeCompletion.get());
+  }
+  if (TheParser.parseAbstractFunctionBodyReplacement(AFD, LBraceLoc,
+                                                      RBraceLoc))
+    return true;
+  if (CodeCompletion)
+    CodeCompletion->doneParsing();
+  return false;
+}
+
 /// \brief Tokenizes a string literal, taking into account string interpolation.
 static void getStringPartTokens(const Token &Tok, const LangOptions &LangOpts,
                                 const SourceManager &SM,
@@ -53,9 +53,9 @@ static bool isResolvableScope(ScopeKind SK) {
 
 Scope::Scope(Parser *P, ScopeKind SC, bool InactiveConfigBlock)
   : SI(P->getScopeInfo()),
-    HTScope(SI.HT, SI.CurScope ? &SI.CurScope->HTScope : 0),
     PrevScope(SI.CurScope),
-    PrevResolvableDepth(SI.ResolvableDepth),
+    PrevResolvableBegin(SI.ResolvableBegin),
+    EntriesBegin(SI.Entries.size()),
     Kind(SC), IsInactiveConfigBlock(InactiveConfigBlock) {
   assert(PrevScope || Kind == ScopeKind::TopLevel);
   
@@ -67,20 +67,26 @@ Scope::Scope(Parser *P, ScopeKind SC, bool InactiveConfigBlock)
   }
   SI.CurScope = this;
   if (!isResolvableScope(Kind))
-    SI.ResolvableDepth = Depth + 1;
+    SI.ResolvableBegin = EntriesBegin;
 }
 
 Scope::Scope(Parser *P, SavedScope &&SS):
     SI(P->getScopeInfo()),
-    HTScope(std::move(SS.HTDetachedScope)),
     PrevScope(SI.CurScope),
-    PrevResolvableDepth(SI.ResolvableDepth),
+    PrevResolvableBegin(SI.ResolvableBegin),
+    EntriesBegin(SI.Entries.size()),
     Depth(SS.Depth),
     Kind(SS.Kind), IsInactiveConfigBlock(SS.IsInactiveConfigBlock) {
-    
+
+    // Only the saved bindings are visible from the re-entered scope, not those
+    // of the scopes that happen to be active now.
+    SI.ResolvableBegin = EntriesBegin;
+    for (auto &Entry : SS.Entries)
+      SI.pushEntry(Entry.Name, Entry.Decl, Entry.Depth);
+
     SI.CurScope = this;
     if (!isResolvableScope(Kind))
-      SI.ResolvableDepth = Depth + 1;
+      SI.ResolvableBegin = SI.Entries.size();
 }
 
 bool Scope::isResolvable() const {
@@ -91,51 +97,24 @@ bool Scope::isResolvable() const {
 // ScopeInfo Implementation
 //===----------------------------------------------------------------------===//
 
-/// checkValidOverload - Check whether it is ok for D1 and D2 to be declared at
-/// the same scope.  This check is a transitive relationship, so if "D1 is a
-/// valid overload of D2" and "D2 is a valid overload of D3" then we know that
-/// D1/D3 are valid overloads and we don't have to check all permutations.
-static bool checkValidOverload(const ValueDecl *D1, const ValueDecl *D2,
-                               Parser &P) {
-  // Currently, there is no restriction on overloading.
-  return false;
-}
-
-
 /// addToScope - Register the specified decl as being in the current lexical
 /// scope.
 void ScopeInfo::addToScope(ValueDecl *D, Parser &TheParser) {
   if (!CurScope->isResolvable())
     return;
 
-  assert(CurScope->getDepth() >= ResolvableDepth &&
+  assert(CurScope->EntriesBegin >= ResolvableBegin &&
          "inserting names into a non-resolvable scope");
 
   // If we have a shadowed variable definition, check to see if we have a
   // redefinition: two definitions in the same scope with the same name.
-  ScopedHTTy::iterator EntryI = HT.begin(CurScope->HTScope, D->getName());
+  // Only resolvable scopes get here; later phases will handle scopes like
+  // module-scope, etc.
+  unsigned Index = findVisibleEntry(D->getName());
 
-  // A redefinition is a hit in the scoped table at the same depth.
-  if (EntryI != HT.end() && EntryI->first == CurScope->getDepth()) {
-    ValueDecl *PrevDecl = EntryI->second;
-    
-    // If this is in a resolvable scope, diagnose redefinitions.  Later
-    // phases will handle scopes like module-scope, etc.
-    if (CurScope->getDepth() >= ResolvableDepth)
-      return TheParser.diagnoseRedefinition(PrevDecl, D);
-    
-    // If this is at top-level scope, validate that the members of the overload
-    // set all agree.
-    
-    // Check to see if D and PrevDecl are valid in the same overload set.
-    if (checkValidOverload(D, PrevDecl, TheParser))
-      return;
-    
-    // Note: we don't check whether all of the elements of the overload set have
-    // different argument types.  This is checked later.
-  }
+  // A redefinition is a visible binding at the same depth.
+  if (Index != NoEntry && Entries[Index].Depth == CurScope->getDepth())
+    return TheParser.diagnoseRedefinition(Entries[Index].Decl, D);
 
-  HT.insertIntoScope(CurScope->HTScope,
-                     D->getName(),
-                     std::make_pair(CurScope->getDepth(), D));
+  pushEntry(D->getName(), D, CurScope->getDepth());
 }
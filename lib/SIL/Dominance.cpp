@@ -13,8 +13,12 @@
 #include "swift/SIL/SILFunction.h"
 #include "swift/SIL/SILBasicBlock.h"
 #include "swift/SIL/Dominance.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/GenericDomTree.h"
 #include "llvm/Support/GenericDomTreeConstruction.h"
+#include <algorithm>
+#include <queue>
 
 using namespace swift;
 
@@ -22,6 +26,131 @@ template class llvm::DominatorTreeBase<SILBasicBlock>;
 template class llvm::DominatorBase<SILBasicBlock>;
 template class llvm::DomTreeNodeBase<SILBasicBlock>;
 
+using DomTree = llvm::DominatorTreeBase<SILBasicBlock>;
+
+namespace {
+/// The depths of the nodes of a dominator tree, computed on demand.
+class NodeLevels {
+  llvm::DenseMap<DominanceInfoNode *, unsigned> Levels;
+
+public:
+  unsigned get(DominanceInfoNode *Node) {
+    SmallVector<DominanceInfoNode *, 16> Path;
+    unsigned Level = 0;
+    for (; Node; Node = Node->getIDom()) {
+      auto It = Levels.find(Node);
+      if (It != Levels.end()) {
+        Level = It->second + 1;
+        break;
+      }
+      Path.push_back(Node);
+    }
+    for (auto I = Path.rbegin(), E = Path.rend(); I != E; ++I)
+      Levels[*I] = Level++;
+    return Level - 1;
+  }
+};
+} // end anonymous namespace
+
+static DominanceInfoNode *findNearestCommonDominator(DominanceInfoNode *A,
+                                                     DominanceInfoNode *B,
+                                                     NodeLevels &Levels) {
+  unsigned LevelA = Levels.get(A), LevelB = Levels.get(B);
+  for (; LevelA > LevelB; --LevelA)
+    A = A->getIDom();
+  for (; LevelB > LevelA; --LevelB)
+    B = B->getIDom();
+  while (A != B) {
+    A = A->getIDom();
+    B = B->getIDom();
+  }
+  return A;
+}
+
+/// Returns the successors of \p BB in the graph the tree is built for, which
+/// is the reversed CFG for post-dominators.
+static void getGraphSuccessors(SILBasicBlock *BB, bool Reverse,
+                               SmallVectorImpl<SILBasicBlock *> &Succs) {
+  if (Reverse) {
+    Succs.append(BB->pred_begin(), BB->pred_end());
+    return;
+  }
+  for (auto &Succ : BB->getSuccessors())
+    Succs.push_back(Succ.getBB());
+}
+
+/// Updates \p DT for a new edge from \p FromNode to \p ToNode in the graph
+/// it is built for.
+///
+/// Only nodes deeper than the nearest common dominator D of the edge's ends
+/// which can be reached from \p ToNode can change their immediate dominator,
+/// and all of those which do get D as their new one. They are found by the
+/// depth-based search of Georgiadis et al., which visits the nodes from the
+/// deepest level up and every node once.
+static void insertReachableEdge(DomTree &DT, DominanceInfoNode *FromNode,
+                                DominanceInfoNode *ToNode, bool Reverse) {
+  NodeLevels Levels;
+  DominanceInfoNode *NCD = findNearestCommonDominator(FromNode, ToNode, Levels);
+  unsigned NCDLevel = Levels.get(NCD);
+  if (Levels.get(ToNode) <= NCDLevel + 1)
+    return;
+
+  // The candidates for a new immediate dominator, deepest first.
+  std::priority_queue<std::pair<unsigned, DominanceInfoNode *>> Bucket;
+  llvm::SmallPtrSet<DominanceInfoNode *, 32> Visited;
+  SmallVector<DominanceInfoNode *, 32> Affected;
+  SmallVector<DominanceInfoNode *, 32> Deeper;
+  SmallVector<SILBasicBlock *, 8> Succs;
+
+  Bucket.push({Levels.get(ToNode), ToNode});
+  Visited.insert(ToNode);
+  while (!Bucket.empty()) {
+    DominanceInfoNode *Node = Bucket.top().second;
+    Bucket.pop();
+    Affected.push_back(Node);
+
+    // Successors deeper than Node keep their dominator but lead to more
+    // candidates; the others are candidates themselves.
+    unsigned Level = Levels.get(Node);
+    while (true) {
+      Succs.clear();
+      getGraphSuccessors(Node->getBlock(), Reverse, Succs);
+      for (SILBasicBlock *Succ : Succs) {
+        DominanceInfoNode *SuccNode = DT.getNode(Succ);
+        if (!SuccNode)
+          continue;
+        unsigned SuccLevel = Levels.get(SuccNode);
+        if (SuccLevel <= NCDLevel + 1 || !Visited.insert(SuccNode).second)
+          continue;
+        if (SuccLevel > Level)
+          Deeper.push_back(SuccNode);
+        else
+          Bucket.push({SuccLevel, SuccNode});
+      }
+      if (Deeper.empty())
+        break;
+      Node = Deeper.pop_back_val();
+    }
+  }
+
+  for (DominanceInfoNode *Node : Affected)
+    DT.changeImmediateDominator(Node, NCD);
+}
+
+/// Removes \p Root and every node it dominates from \p DT.
+static void eraseSubtree(DomTree &DT, DominanceInfoNode *Root) {
+  SmallVector<DominanceInfoNode *, 16> Worklist(1, Root);
+  SmallVector<SILBasicBlock *, 16> Subtree;
+  while (!Worklist.empty()) {
+    DominanceInfoNode *Node = Worklist.pop_back_val();
+    Subtree.push_back(Node->getBlock());
+    Worklist.append(Node->begin(), Node->end());
+  }
+  // Children come after their parents; erase them first.
+  for (auto I = Subtree.rbegin(), E = Subtree.rend(); I != E; ++I)
+    DT.eraseNode(*I);
+}
+
 /// Compute the immmediate-dominators map.
 DominanceInfo::DominanceInfo(SILFunction *F)
     : DominatorTreeBase(/*isPostDom*/ false) {
@@ -64,6 +193,58 @@ void DominanceInfo::verify() const {
   }
 }
 
+void DominanceInfo::insertEdge(SILBasicBlock *From, SILBasicBlock *To) {
+  auto *FromNode = getNode(From);
+  // An edge out of an unreachable block changes nothing.
+  if (!FromNode)
+    return;
+  auto *ToNode = getNode(To);
+  if (!ToNode) {
+    recalculate(*From->getParent());
+    return;
+  }
+  insertReachableEdge(*this, FromNode, ToNode, /*Reverse*/ false);
+}
+
+void DominanceInfo::deleteEdge(SILBasicBlock *From, SILBasicBlock *To) {
+  auto *FromNode = getNode(From);
+  auto *ToNode = getNode(To);
+  // Paths over an edge back to a dominator never lead anywhere new.
+  if (!FromNode || !ToNode || dominates(ToNode, FromNode))
+    return;
+
+  // If To can only be reached through itself, it is unreachable now, and so
+  // is everything it dominated.
+  bool IsReachable = std::any_of(To->pred_begin(), To->pred_end(),
+                                 [&](SILBasicBlock *Pred) {
+    auto *PredNode = getNode(Pred);
+    return PredNode && !dominates(ToNode, PredNode);
+  });
+  if (!IsReachable) {
+    eraseSubtree(*this, ToNode);
+    return;
+  }
+
+  // Otherwise any block below the nearest common dominator of the edge may
+  // now be dominated by a deeper block. Finding those needs the construction
+  // algorithm, so rebuild the tree.
+  recalculate(*From->getParent());
+}
+
+void DominanceInfo::mergeBlocks(SILBasicBlock *BB, SILBasicBlock *Succ) {
+  auto *SuccNode = getNode(Succ);
+  if (!SuccNode)
+    return;
+
+  // The blocks Succ dominated are now dominated by BB.
+  auto *BBNode = getNode(BB);
+  SmallVector<DominanceInfoNode *, 8> Children(SuccNode->begin(),
+                                               SuccNode->end());
+  for (auto *Child : Children)
+    changeImmediateDominator(Child, BBNode);
+  eraseNode(Succ);
+}
+
 /// Compute the immmediate-post-dominators map.
 PostDominanceInfo::PostDominanceInfo(SILFunction *F)
   : DominatorTreeBase(/*isPostDom*/ true) {
@@ -110,3 +291,77 @@ void PostDominanceInfo::verify() const {
     abort();
   }
 }
+
+void PostDominanceInfo::insertEdge(SILBasicBlock *From, SILBasicBlock *To) {
+  // Rebuild if the edge lets From reach an exit for the first time, or if
+  // From was an exit itself.
+  auto *FromNode = getNode(From);
+  if (!FromNode ||
+      std::find(Roots.begin(), Roots.end(), From) != Roots.end()) {
+    recalculate(*From->getParent());
+    return;
+  }
+  // An edge to a block which doesn't reach an exit changes nothing.
+  auto *ToNode = getNode(To);
+  if (!ToNode)
+    return;
+  // In the reversed CFG the edge goes from To to From.
+  insertReachableEdge(*this, ToNode, FromNode, /*Reverse*/ true);
+}
+
+void PostDominanceInfo::deleteEdge(SILBasicBlock *From, SILBasicBlock *To) {
+  // A block without successors is a new exit.
+  if (From->getSuccessors().empty()) {
+    recalculate(*From->getParent());
+    return;
+  }
+
+  // In the reversed CFG the edge goes from To to From.
+  auto *FromNode = getNode(From);
+  auto *ToNode = getNode(To);
+  if (!FromNode || !ToNode || dominates(FromNode, ToNode))
+    return;
+
+  // If From can only reach an exit through itself, it doesn't reach one now,
+  // and neither does anything it post-dominated.
+  bool ReachesExit = false;
+  for (auto &Succ : From->getSuccessors()) {
+    auto *SuccNode = getNode(Succ.getBB());
+    if (SuccNode && !dominates(FromNode, SuccNode)) {
+      ReachesExit = true;
+      break;
+    }
+  }
+  if (!ReachesExit) {
+    eraseSubtree(*this, FromNode);
+    return;
+  }
+
+  recalculate(*From->getParent());
+}
+
+void PostDominanceInfo::mergeBlocks(SILBasicBlock *BB, SILBasicBlock *Succ) {
+  // BB can only reach an exit through Succ.
+  auto *SuccNode = getNode(Succ);
+  if (!SuccNode)
+    return;
+
+  auto Root = std::find(Roots.begin(), Roots.end(), Succ);
+  if (Root != Roots.end()) {
+    // The single exit is the root node itself, which can't be replaced.
+    if (!SuccNode->getIDom()) {
+      recalculate(*BB->getParent());
+      return;
+    }
+    *Root = BB;
+  }
+
+  // BB takes the place of Succ, which post-dominated it.
+  auto *BBNode = getNode(BB);
+  changeImmediateDominator(BBNode, SuccNode->getIDom());
+  SmallVector<DominanceInfoNode *, 8> Children(SuccNode->begin(),
+                                               SuccNode->end());
+  for (auto *Child : Children)
+    changeImmediateDominator(Child, BBNode);
+  eraseNode(Succ);
+}
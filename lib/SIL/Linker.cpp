@@ -45,6 +45,13 @@ static bool shouldImportFunction(SILFunction *F) {
   return true;
 }
 
+/// \return The method which introduced the vtable slot of \p Method.
+static SILDeclRef getVTableRoot(SILDeclRef Method) {
+  while (SILDeclRef Overridden = Method.getOverriddenVTableEntry())
+    Method = Overridden;
+  return Method;
+}
+
 //===----------------------------------------------------------------------===//
 //                               Linker Helpers
 //===----------------------------------------------------------------------===//
@@ -175,12 +182,13 @@ bool SILLinkerVisitor::linkInVTable(ClassDecl *D) {
   if (!Vtbl || !(Vtbl = Loader->lookupVTable(D->getName())))
     return false;
 
-  // Ok we found our VTable. Visit each function referenced by the VTable. If
-  // any of the functions are external declarations, add them to the worklist
-  // for processing.
+  // Ok we found our VTable. Only link in the functions of entries which may be
+  // called through a class_method instruction we have already seen. The
+  // other entries stay declarations until visitClassMethodInst finds a use of
+  // them.
   bool Result = false;
   for (auto P : Vtbl->getEntries()) {
-    if (P.second->isExternalDeclaration()) {
+    if (P.second->isExternalDeclaration() && isVTableEntryNeeded(P)) {
       Result = true;
       addFunctionToWorklist(P.second);
     }
@@ -188,6 +196,20 @@ bool SILLinkerVisitor::linkInVTable(ClassDecl *D) {
   return Result;
 }
 
+bool SILLinkerVisitor::isVTableEntryNeeded(const SILVTable::Pair &Entry) {
+  // Shared functions must be emitted into every module which references them.
+  if (hasSharedVisibility(Entry.second->getLinkage()))
+    return true;
+  return Mod.LinkedClassMethods.count(getVTableRoot(Entry.first));
+}
+
+bool SILLinkerVisitor::isWitnessNeeded(
+    const SILWitnessTable::MethodWitness &Witness) {
+  if (hasSharedVisibility(Witness.Witness->getLinkage()))
+    return true;
+  return Mod.LinkedWitnessMethods.count(Witness.Requirement);
+}
+
 //===----------------------------------------------------------------------===//
 //                                  Visitors
 //===----------------------------------------------------------------------===//
@@ -263,26 +285,80 @@ bool SILLinkerVisitor::visitProtocolConformance(
   for (auto &E : WT->getEntries()) {
     // If the entry is a witness method...
     if (E.getKind() == SILWitnessTable::WitnessKind::Method) {
-      // And we are only interested in deserializing a specific requirement
-      // and don't have that requirement, don't deserialize this method.
-      if (Member.hasValue() && E.getMethodWitness().Requirement != *Member)
-        continue;
+      auto &MW = E.getMethodWitness();
 
       // The witness could be removed by dead function elimination.
-      if (!E.getMethodWitness().Witness)
+      if (!MW.Witness)
         continue;
 
-      // Otherwise if it is the requirement we are looking for or we just want
-      // to deserialize everything, add the function to the list of functions
-      // to deserialize.
+      // If we are only interested in deserializing a specific requirement
+      // and don't have that requirement, don't deserialize this method. If
+      // we are linking in the whole table, skip the witnesses which no
+      // witness_method instruction we have seen so far may call. They stay
+      // declarations until visitWitnessMethodInst finds a use of them.
+      if (Member.hasValue() ? MW.Requirement != *Member : !isWitnessNeeded(MW))
+        continue;
+
+      // Otherwise add the function to the list of functions to deserialize.
       performFuncDeserialization = true;
-      addFunctionToWorklist(E.getMethodWitness().Witness);
+      addFunctionToWorklist(MW.Witness);
+    }
+  }
+
+  return performFuncDeserialization;
+}
+
+bool SILLinkerVisitor::visitWitnessMethodInst(WitnessMethodInst *WMI) {
+  SILDeclRef Member = WMI->getMember();
+  bool performFuncDeserialization = false;
+
+  // If this is the first use of the requirement, link in its witnesses in the
+  // witness tables which were linked before. The conformance which is used
+  // here may be unknown, e.g. if the method is called on an opened
+  // existential.
+  if (Mod.LinkedWitnessMethods.insert(Member).second) {
+    for (auto &WT : Mod.getWitnessTableList()) {
+      if (WT.isDeclaration())
+        continue;
+      for (auto &E : WT.getEntries()) {
+        if (E.getKind() != SILWitnessTable::WitnessKind::Method)
+          continue;
+        auto &MW = E.getMethodWitness();
+        if (MW.Requirement != Member || !MW.Witness ||
+            !MW.Witness->isExternalDeclaration())
+          continue;
+        performFuncDeserialization = true;
+        addFunctionToWorklist(MW.Witness);
+      }
     }
   }
 
+  performFuncDeserialization |=
+      visitProtocolConformance(WMI->getConformance(), Member);
   return performFuncDeserialization;
 }
 
+bool SILLinkerVisitor::visitClassMethodInst(ClassMethodInst *CMI) {
+  // If this is the first use of the vtable slot, link in the implementations
+  // of the slot in the vtables which were linked before. Vtables which are
+  // linked later pick it up in linkInVTable.
+  SILDeclRef Root = getVTableRoot(CMI->getMember());
+  if (!Mod.LinkedClassMethods.insert(Root).second)
+    return false;
+
+  bool Result = false;
+  for (auto &Vtbl : Mod.getVTableList()) {
+    for (auto P : Vtbl.getEntries()) {
+      if (P.second->isExternalDeclaration() &&
+          getVTableRoot(P.first) == Root) {
+        Result = true;
+        addFunctionToWorklist(P.second);
+      }
+    }
+  }
+  return Result;
+}
+
 bool SILLinkerVisitor::visitInitExistentialAddrInst(
     InitExistentialAddrInst *IEI) {
   // Link in all protocol conformances that this touches.
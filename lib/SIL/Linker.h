@@ -84,9 +84,8 @@ public:
   bool visitFunctionRefInst(FunctionRefInst *FRI);
   bool visitProtocolConformance(ProtocolConformance *C,
                                 const Optional<SILDeclRef> &Member);
-  bool visitWitnessMethodInst(WitnessMethodInst *WMI) {
-    return visitProtocolConformance(WMI->getConformance(), WMI->getMember());
-  }
+  bool visitWitnessMethodInst(WitnessMethodInst *WMI);
+  bool visitClassMethodInst(ClassMethodInst *CMI);
   bool visitInitExistentialAddrInst(InitExistentialAddrInst *IEI);
   bool visitInitExistentialRefInst(InitExistentialRefInst *IERI);
   bool visitAllocRefInst(AllocRefInst *ARI);
@@ -104,6 +103,13 @@ private:
 
   bool linkInVTable(ClassDecl *D);
 
+  /// Returns true if the function of the vtable entry \p Entry may be called
+  /// and should be linked in.
+  bool isVTableEntryNeeded(const SILVTable::Pair &Entry);
+
+  /// Returns true if \p Witness may be called and should be linked in.
+  bool isWitnessNeeded(const SILWitnessTable::MethodWitness &Witness);
+
   // Main loop of the visitor. Called by one of the other *visit* methods.
   bool process();
 };
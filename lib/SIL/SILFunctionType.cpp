@@ -633,17 +633,24 @@ struct DeallocatorConventions : Conventions {
 namespace {
   /// The default Swift conventions.
   struct DefaultConventions : Conventions {
+    /// Whether ordinary parameters are passed at +0.
+    bool GuaranteedParameters;
 
-    DefaultConventions()
-      : Conventions(ConventionsKind::Default) {}
+    DefaultConventions(bool GuaranteedParameters = false)
+      : Conventions(ConventionsKind::Default),
+        GuaranteedParameters(GuaranteedParameters) {}
 
     ParameterConvention getIndirectParameter(unsigned index,
                               const AbstractionPattern &type) const override {
+      if (GuaranteedParameters)
+        return ParameterConvention::Indirect_In_Guaranteed;
       return ParameterConvention::Indirect_In;
     }
 
     ParameterConvention getDirectParameter(unsigned index,
                               const AbstractionPattern &type) const override {
+      if (GuaranteedParameters)
+        return ParameterConvention::Direct_Guaranteed;
       return ParameterConvention::Direct_Owned;
     }
 
@@ -671,6 +678,9 @@ namespace {
   };
   
   /// The default conventions for Swift initializing constructors.
+  ///
+  /// Initializers usually store their parameters into the new instance, so
+  /// they always take them at +1.
   struct DefaultInitializerConventions : DefaultConventions {
     using DefaultConventions::DefaultConventions;
   
@@ -744,6 +754,7 @@ static CanSILFunctionType getNativeSILFunctionType(SILModule &M,
   case SILFunctionType::Representation::Thick:
   case SILFunctionType::Representation::Method:
   case SILFunctionType::Representation::WitnessMethod: {
+    bool guaranteedParams = M.getOptions().EnableGuaranteedNormalArguments;
     switch (kind) {
     case SILDeclRef::Kind::Initializer:
       return getSILFunctionType(M, origType, substType, substInterfaceType,
@@ -760,7 +771,7 @@ static CanSILFunctionType getNativeSILFunctionType(SILModule &M,
     case SILDeclRef::Kind::IVarDestroyer:
     case SILDeclRef::Kind::EnumElement:
       return getSILFunctionType(M, origType, substType, substInterfaceType,
-                                extInfo, DefaultConventions(),
+                                extInfo, DefaultConventions(guaranteedParams),
                                 None);
     case SILDeclRef::Kind::Deallocator:
       return getSILFunctionType(M, origType, substType, substInterfaceType,
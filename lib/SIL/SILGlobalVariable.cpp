@@ -67,6 +67,16 @@ SILGlobalVariable::~SILGlobalVariable() {
   getModule().GlobalVariableTable.erase(Name);
 }
 
+/// Returns true if \p I is a case of an enum which has no payload cases,
+/// which IRGen can emit as a constant discriminator.
+static bool isPayloadFreeEnumCase(SILInstruction *I) {
+  auto *EI = dyn_cast<EnumInst>(I);
+  if (!EI || EI->hasOperand())
+    return false;
+  auto *ED = EI->getType().getEnumOrBoundGenericEnum();
+  return ED && ED->hasOnlyCasesWithoutAssociatedValues();
+}
+
 static bool analyzeStaticInitializer(SILFunction *F, SILInstruction *&Val,
                                      SILGlobalVariable *&GVar) {
   Val = nullptr;
@@ -92,9 +102,10 @@ static bool analyzeStaticInitializer(SILFunction *F, SILInstruction *&Val,
       HasStore = true;
       Val = dyn_cast<SILInstruction>(SI->getSrc().getDef());
 
-      // We only handle StructInst and TupleInst being stored to a
-      // global variable for now.
-      if (!isa<StructInst>(Val) && !isa<TupleInst>(Val))
+      // We only handle StructInst, TupleInst and payload-free EnumInst
+      // being stored to a global variable for now.
+      if (!Val || (!isa<StructInst>(Val) && !isa<TupleInst>(Val) &&
+                   !isPayloadFreeEnumCase(Val)))
         return false;
     } else {
 
@@ -109,6 +120,9 @@ static bool analyzeStaticInitializer(SILFunction *F, SILInstruction *&Val,
         }
       }
 
+      if (isPayloadFreeEnumCase(&I))
+        continue;
+
       if (I.getKind() != ValueKind::ReturnInst &&
           I.getKind() != ValueKind::StructInst &&
           I.getKind() != ValueKind::TupleInst &&
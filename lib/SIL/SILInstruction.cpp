@@ -84,6 +84,14 @@ void llvm::ilist_traits<SILInstruction>::removeNodeFromList(SILInstruction *I) {
   I->ParentBB = 0;
 }
 
+void llvm::ilist_traits<SILInstruction>::deleteNode(SILInstruction *V) {
+  // Give the memory back to the module, so that optimizations which keep
+  // erasing and creating instructions don't grow the module's memory.
+  SILModule &M = getContainingBlock()->getModule();
+  size_t Size = SILInstruction::destroy(V);
+  M.deallocate(V, Size);
+}
+
 void llvm::ilist_traits<SILInstruction>::
 transferNodesFromList(llvm::ilist_traits<SILInstruction> &L2,
                       llvm::ilist_iterator<SILInstruction> first,
@@ -177,15 +185,17 @@ void SILInstruction::replaceAllUsesWithUndef() {
 }
 
 namespace {
-  class InstructionDestroyer : public SILVisitor<InstructionDestroyer> {
+  class InstructionDestroyer
+    : public SILVisitor<InstructionDestroyer, size_t> {
   public:
-#define VALUE(CLASS, PARENT) void visit##CLASS(CLASS *I) { I->~CLASS(); }
+#define VALUE(CLASS, PARENT)                                                   \
+    size_t visit##CLASS(CLASS *I) { I->~CLASS(); return sizeof(CLASS); }
 #include "swift/SIL/SILNodes.def"
   };
 } // end anonymous namespace
 
-void SILInstruction::destroy(SILInstruction *I) {
-  InstructionDestroyer().visit(I);
+size_t SILInstruction::destroy(SILInstruction *I) {
+  return InstructionDestroyer().visit(I);
 }
 
 namespace {
@@ -262,11 +272,11 @@ namespace {
     }
 
     bool visitStrongReleaseInst(const StrongReleaseInst *RHS) {
-      return true;
+      return cast<StrongReleaseInst>(LHS)->isNonAtomic() == RHS->isNonAtomic();
     }
 
     bool visitStrongRetainInst(const StrongRetainInst *RHS) {
-      return true;
+      return cast<StrongRetainInst>(LHS)->isNonAtomic() == RHS->isNonAtomic();
     }
 
     bool visitStrongRetainUnownedInst(const StrongRetainUnownedInst *RHS) {
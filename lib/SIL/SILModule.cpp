@@ -23,6 +23,7 @@
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Debug.h"
+#include <algorithm>
 #include <functional>
 using namespace swift;
 using namespace Lowering;
@@ -124,6 +125,40 @@ SILModule::~SILModule() {
   delete (SILTypeListUniquingType*)TypeListUniquing;
 }
 
+void *SILModule::allocateFromFreeList(unsigned Size, unsigned Align) const {
+  if (Align > alignof(void *))
+    return nullptr;
+
+  // Round up, so that every block in the class is large enough.
+  unsigned SizeClass = (Size + sizeof(void *) - 1) / sizeof(void *);
+  if (SizeClass == 0 || SizeClass > NumFreeListSizeClasses)
+    return nullptr;
+
+  void *Block = FreeLists[SizeClass];
+  if (Block)
+    FreeLists[SizeClass] = *reinterpret_cast<void **>(Block);
+  return Block;
+}
+
+void SILModule::deallocate(void *Ptr, unsigned Size) const {
+  // With -use-malloc nothing is recycled, so that memory tools can still
+  // catch uses of deleted objects.
+  if (getASTContext().LangOpts.UseMalloc)
+    return;
+
+  assert(reinterpret_cast<uintptr_t>(Ptr) % alignof(void *) == 0 &&
+         "memory from the module allocator is pointer aligned");
+
+  // Round down, so that the block fits every allocation from its class.
+  unsigned SizeClass = std::min<unsigned>(Size / sizeof(void *),
+                                          NumFreeListSizeClasses);
+  if (SizeClass == 0)
+    return;
+
+  *reinterpret_cast<void **>(Ptr) = FreeLists[SizeClass];
+  FreeLists[SizeClass] = Ptr;
+}
+
 SILWitnessTable *
 SILModule::createWitnessTableDeclaration(ProtocolConformance *C,
                                          SILLinkage linkage) {
@@ -313,8 +348,7 @@ SILFunction *SILModule::getOrCreateFunction(SILLocation loc,
                                             SILDeclRef constant,
                                             ForDefinition_t forDefinition) {
 
-  SmallVector<char, 128> buffer;
-  auto name = constant.mangle(buffer);
+  auto name = getMangledName(constant);
   auto constantType = Types.getConstantType(constant).castTo<SILFunctionType>();
   SILLinkage linkage = constant.getLinkage(forDefinition);
 
@@ -493,9 +527,20 @@ const BuiltinInfo &SILModule::getBuiltinInfo(Identifier ID) {
 }
 
 SILFunction *SILModule::lookUpFunction(SILDeclRef fnRef) {
-  llvm::SmallString<32> name;
-  fnRef.mangle(name);
-  return lookUpFunction(name);
+  return lookUpFunction(getMangledName(fnRef));
+}
+
+StringRef SILModule::getMangledName(SILDeclRef constant) {
+  auto &name = MangledNames[constant];
+  if (name.data())
+    return name;
+
+  llvm::SmallString<128> buffer;
+  constant.mangle(buffer);
+  char *copy = static_cast<char *>(BPA.Allocate(buffer.size(), 1));
+  std::copy(buffer.begin(), buffer.end(), copy);
+  name = StringRef(copy, buffer.size());
+  return name;
 }
 
 bool SILModule::linkFunction(SILFunction *Fun, SILModule::LinkingMode Mode,
@@ -29,6 +29,7 @@
 #include "swift/SIL/SILModule.h"
 #include "swift/SIL/TypeLowering.h"
 #include "clang/AST/Type.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Debug.h"
 
 using namespace swift;
@@ -1193,12 +1194,21 @@ namespace {
   };
 }
 
+STATISTIC(NumIndependentLoweringHits,
+          "Number of lowerings of non-generic types found in the cache");
+STATISTIC(NumIndependentLoweringMisses,
+          "Number of lowerings of non-generic types not found in the cache");
+STATISTIC(NumDependentLoweringHits,
+          "Number of lowerings of generic types found in the cache");
+STATISTIC(NumDependentLoweringMisses,
+          "Number of lowerings of generic types not found in the cache");
+
 TypeConverter::TypeConverter(SILModule &m)
   : M(m), Context(m.getASTContext()) {
 }
 
 TypeConverter::~TypeConverter() {
-  assert(!GenericArchetypes.hasValue() && "generic context was never popped?!");
+  assert(!GenericArchetypes && "generic context was never popped?!");
 
   // The bump pointer allocator destructor will deallocate but not destroy all
   // our independent TypeLowerings.
@@ -1210,6 +1220,16 @@ TypeConverter::~TypeConverter() {
     if (srcType == mappedType || isa<InOutType>(srcType))
       ti.second->~TypeLowering();
   }
+
+  // Likewise for the dependent TypeLowerings, of all generic contexts.
+  for (auto &ti : DependentTypes) {
+    // Destroy only the unique entries.
+    CanType srcType = ti.first.second.OrigType;
+    if (!srcType) continue;
+    CanType mappedType = ti.second->getLoweredType().getSwiftRValueType();
+    if (srcType == mappedType || isa<LValueType>(srcType))
+      ti.second->~TypeLowering();
+  }
 }
 
 void *TypeLowering::operator new(size_t size, TypeConverter &tc,
@@ -1219,14 +1239,35 @@ void *TypeLowering::operator new(size_t size, TypeConverter &tc,
     : tc.IndependentBPA.Allocate(size, alignof(TypeLowering));
 }
 
+/// Returns the entry of \p Key in \p Types, or null if there is none.
+template <typename MapTy, typename KeyTy>
+static const TypeLowering **findEntry(MapTy &Types, const KeyTy &Key) {
+  auto found = Types.find(Key);
+  if (found == Types.end())
+    return nullptr;
+  return &found->second;
+}
+
 const TypeLowering *TypeConverter::find(TypeKey k) {
   if (!k.isCacheable()) return nullptr;
 
-  auto &Types = k.isDependent() ? DependentTypes : IndependentTypes;
   auto ck = k.getCachingKey();
-  auto found = Types.find(ck);
-  if (found == Types.end())
-    return nullptr;
+  const TypeLowering **entry;
+  if (k.isDependent()) {
+    entry = findEntry(DependentTypes, DependentTypeKey(CurGenericContext, ck));
+    if (!entry) {
+      ++NumDependentLoweringMisses;
+      return nullptr;
+    }
+    ++NumDependentLoweringHits;
+  } else {
+    entry = findEntry(IndependentTypes, ck);
+    if (!entry) {
+      ++NumIndependentLoweringMisses;
+      return nullptr;
+    }
+    ++NumIndependentLoweringHits;
+  }
   // We place a null placeholder in the hashtable to catch
   // reentrancy, which arises as a result of improper recursion.
   // TODO: We should diagnose nonterminating recursion in Sema, and implement
@@ -1234,7 +1275,7 @@ const TypeLowering *TypeConverter::find(TypeKey k) {
   // When that Sema check is in place, we should reinstate the early-exit
   // behavior for address-only types (marked by other TODO: items throughout
   // this file).
-  if (auto elt = found->second)
+  if (auto elt = *entry)
     return elt;
     
   // Try to complain about a nominal type.
@@ -1256,19 +1297,21 @@ const TypeLowering *TypeConverter::find(TypeKey k) {
   }
   auto result = new (*this, k.isDependent()) RecursiveErrorTypeLowering(
                             SILType::getPrimitiveAddressType(k.SubstType));
-  found->second = result;
+  *entry = result;
   return result;
 }
 
 void TypeConverter::insert(TypeKey k, const TypeLowering *tl) {
   if (!k.isCacheable()) return;
 
-  auto &Types = k.isDependent() ? DependentTypes : IndependentTypes;
-  // TODO: Types[k] should always be null at this point, except that we
+  // TODO: The entry should always be null at this point, except that we
   // rely on type lowering to discover recursive value types right now.
   auto ck = k.getCachingKey();
-  if (!Types[ck])
-    Types[ck] = tl;
+  auto &entry = k.isDependent()
+    ? DependentTypes[DependentTypeKey(CurGenericContext, ck)]
+    : IndependentTypes[ck];
+  if (!entry)
+    entry = tl;
 }
 
 #ifndef NDEBUG
@@ -1353,7 +1396,7 @@ TypeConverter::getTypeLowering(AbstractionPattern origType,
   CanType substType = origSubstType->getCanonicalType();
   auto key = getTypeKey(origType, substType, uncurryLevel);
   
-  assert(!key.isDependent() || GenericArchetypes.hasValue()
+  assert(!key.isDependent() || GenericArchetypes
          && "dependent type outside of generic context?!");
   
   if (auto existing = find(key))
@@ -2296,16 +2339,13 @@ void TypeConverter::pushGenericContext(CanGenericSignature sig) {
     return;
   
   // GenericFunctionTypes shouldn't nest.
-  assert(!GenericArchetypes.hasValue() && "already in generic context?!");
-  assert(DependentTypes.empty() && "already in generic context?!");
+  assert(!GenericArchetypes && "already in generic context?!");
   assert(!CurGenericContext && "already in generic context!");
 
   CurGenericContext = sig;
   
-  // Prepare the ArchetypeBuilder with the generic signature.
-  GenericArchetypes.emplace(*M.getSwiftModule(), M.getASTContext().Diags);
-  if (GenericArchetypes->addGenericSignature(sig, false))
-    llvm_unreachable("error adding generic signature to archetype builder?!");
+  // Use the ArchetypeBuilder for the generic signature.
+  GenericArchetypes = sig->getArchetypeBuilder(*M.getSwiftModule());
 }
 
 void TypeConverter::popGenericContext(CanGenericSignature sig) {
@@ -2313,24 +2353,12 @@ void TypeConverter::popGenericContext(CanGenericSignature sig) {
   if (!sig)
     return;
 
-  assert(GenericArchetypes.hasValue() && "not in generic context?!");
+  assert(GenericArchetypes && "not in generic context?!");
   assert(CurGenericContext == sig && "unpaired push/pop");
-  
-  // Erase our cached TypeLowering objects and associated mappings for dependent
-  // types.
-  // Resetting the DependentBPA will deallocate but not run the destructor of
-  // the dependent TypeLowerings.
-  for (auto &ti : DependentTypes) {
-    // Destroy only the unique entries.
-    CanType srcType = ti.first.OrigType;
-    if (!srcType) continue;
-    CanType mappedType = ti.second->getLoweredType().getSwiftRValueType();
-    if (srcType == mappedType || isa<LValueType>(srcType))
-      ti.second->~TypeLowering();
-  }
-  DependentTypes.clear();
-  DependentBPA.Reset();
-  GenericArchetypes.reset();
+
+  // The TypeLowerings of dependent types stay cached for the next context
+  // with the same signature.
+  GenericArchetypes = nullptr;
   CurGenericContext = nullptr;
 }
 
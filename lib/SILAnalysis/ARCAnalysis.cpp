@@ -638,54 +638,69 @@ static bool ignoreableBuiltinInstInUnreachableBlock(BuiltinInst *BI) {
   return false;
 }
 
-/// Match a call to a trap BB with no ARC relevant side effects.
-bool swift::isARCInertTrapBB(SILBasicBlock *BB) {
-  // Do a quick check at the beginning to make sure that our terminator is
-  // actually an unreachable. This ensures that in many cases this function will
-  // exit early and quickly.
-  auto II = BB->rbegin();
-  if (!isa<UnreachableInst>(*II))
-    return false;
-
-  auto IE = BB->rend();
-  while (II != IE) {
+/// Returns true if all instructions in \p BB, except the terminator, are inert
+/// from an ARC perspective in a block which leads to a trap.
+static bool hasOnlyARCInertInstsBeforeTrap(SILBasicBlock *BB) {
+  for (auto II = std::next(BB->rbegin()), IE = BB->rend(); II != IE; ++II) {
     // Ignore any instructions without side effects.
-    if (!II->mayHaveSideEffects()) {
-      ++II;
+    if (!II->mayHaveSideEffects())
       continue;
-    }
 
     // Ignore cond fail.
-    if (isa<CondFailInst>(*II)) {
-      ++II;
+    if (isa<CondFailInst>(*II))
       continue;
-    }
 
     // Check for apply insts that we can ignore.
-    if (auto *AI = dyn_cast<ApplyInst>(&*II)) {
-      if (ignoreableApplyInstInUnreachableBlock(AI)) {
-        ++II;
+    if (auto *AI = dyn_cast<ApplyInst>(&*II))
+      if (ignoreableApplyInstInUnreachableBlock(AI))
         continue;
-      }
-    }
 
     // Check for builtins that we can ignore.
-    if (auto *BI = dyn_cast<BuiltinInst>(&*II)) {
-      if (ignoreableBuiltinInstInUnreachableBlock(BI)) {
-        ++II;
+    if (auto *BI = dyn_cast<BuiltinInst>(&*II))
+      if (ignoreableBuiltinInstInUnreachableBlock(BI))
         continue;
-      }
-    }
 
     // If we can't ignore the instruction, return false.
     return false;
   }
-
-  // Otherwise, we have an unreachable and every instruction is inert from an
-  // ARC perspective in an unreachable BB.
   return true;
 }
 
+/// The maximum number of unconditional branches followed to find the trap.
+static const unsigned MaxTrapBranchChain = 4;
+
+/// Match a call to a trap BB with no ARC relevant side effects.
+///
+/// A block which unconditionally branches to such a trap BB, and has no ARC
+/// relevant side effects itself, is a trap BB, too. This catches the shared
+/// trap blocks that early exits from loops branch to.
+bool swift::isARCInertTrapBB(SILBasicBlock *BB) {
+  for (unsigned i = 0; i <= MaxTrapBranchChain; ++i) {
+    // Do a quick check at the beginning to make sure that our terminator is
+    // actually an unreachable or a branch. This ensures that in many cases
+    // this function will exit early and quickly.
+    auto *Term = BB->getTerminator();
+    if (!isa<UnreachableInst>(Term) && !isa<BranchInst>(Term))
+      return false;
+
+    if (!hasOnlyARCInertInstsBeforeTrap(BB))
+      return false;
+
+    // Otherwise, we have an unreachable and every instruction is inert from an
+    // ARC perspective in an unreachable BB.
+    if (isa<UnreachableInst>(Term))
+      return true;
+
+    // Follow the branch. Arguments passed to the trap block are not
+    // released there, so they are leaked, too.
+    SILBasicBlock *Dest = cast<BranchInst>(Term)->getDestBB();
+    if (Dest == BB)
+      return false;
+    BB = Dest;
+  }
+  return false;
+}
+
 //===----------------------------------------------------------------------===//
 //                          Owned Argument Utilities
 //===----------------------------------------------------------------------===//
@@ -22,12 +22,16 @@
 #include "swift/SIL/SILArgument.h"
 #include "swift/SIL/SILFunction.h"
 #include "swift/SIL/SILModule.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace swift;
 
+STATISTIC(NumAliasCacheHits, "Number of alias queries answered by the cache");
+STATISTIC(NumAliasCacheMisses, "Number of alias queries not in the cache");
+
 //===----------------------------------------------------------------------===//
 //                                AA Debugging
 //===----------------------------------------------------------------------===//
@@ -572,7 +576,18 @@ bool AliasAnalysis::typesMayAlias(SILType T1, SILType T2) {
 AliasResult AliasAnalysis::alias(SILValue V1, SILValue V2,
                                  SILType TBAAType1,
                                  SILType TBAAType2) {
-  return aliasInner(V1, V2, TBAAType1, TBAAType2);
+  AliasCacheKey Key = {{getValueIndex(V1), getValueIndex(V2)},
+                       {TBAAType1, TBAAType2}};
+  auto Iter = AliasCache.find(Key);
+  if (Iter != AliasCache.end()) {
+    ++NumAliasCacheHits;
+    return Iter->second;
+  }
+  ++NumAliasCacheMisses;
+
+  AliasResult Result = aliasInner(V1, V2, TBAAType1, TBAAType2);
+  AliasCache[Key] = Result;
+  return Result;
 }
 
 /// The main AA entry point. Performs various analyses on V1, V2 in an attempt
@@ -1287,7 +1287,10 @@ void EscapeAnalysis::recompute() {
       // Limit the total number of iterations. First to limit compile time,
       // second to make sure that the loop terminates. Theoretically this
       // should always be the case, but who knows?
-      if (Iteration >= MaxGraphMerges) {
+      // Also stop merging into graphs which already got too large, because
+      // the merge cost grows with the graph size.
+      if (Iteration >= MaxGraphMerges ||
+          FInfo->Graph.Nodes.size() > MaxGraphNodes) {
         DEBUG(llvm::dbgs() << "  finalize " <<
               FInfo->Graph.F->getName() << '\n');
         finalizeGraphsConservatively(FInfo);
@@ -13,12 +13,16 @@
 #define DEBUG_TYPE "sil-loop-region-analysis"
 #include "swift/SILAnalysis/LoopRegionAnalysis.h"
 #include "swift/Basic/Range.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/DOTGraphTraits.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/GraphWriter.h"
 
 using namespace swift;
 
+STATISTIC(NumLoopRegions, "Number of loop regions created");
+STATISTIC(NumLoopRegionBytes, "Number of bytes used by loop regions");
+
 //===----------------------------------------------------------------------===//
 //                                 LoopRegion
 //===----------------------------------------------------------------------===//
@@ -147,6 +151,14 @@ LoopRegionFunctionInfo::LoopRegionFunctionInfo(FunctionTy *F,
 #ifndef NDEBUG
   verify();
 #endif
+  NumLoopRegions += IDToRegionMap.size();
+  NumLoopRegionBytes += getMemorySize();
+}
+
+size_t LoopRegionFunctionInfo::getMemorySize() const {
+  return Allocator.getTotalMemory() + BBToIDMap.getMemorySize() +
+         LoopToIDMap.getMemorySize() +
+         IDToRegionMap.capacity() * sizeof(RegionTy *);
 }
 
 LoopRegionFunctionInfo::~LoopRegionFunctionInfo() {
@@ -16,10 +16,16 @@
 #include "swift/SILAnalysis/SideEffectAnalysis.h"
 #include "swift/SILAnalysis/ValueTracking.h"
 #include "swift/SIL/SILVisitor.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Debug.h"
 
 using namespace swift;
 
+STATISTIC(NumMemoryBehaviorCacheHits,
+          "Number of memory behavior queries answered by the cache");
+STATISTIC(NumMemoryBehaviorCacheMisses,
+          "Number of memory behavior queries not in the cache");
+
 //===----------------------------------------------------------------------===//
 //                       Memory Behavior Implementation
 //===----------------------------------------------------------------------===//
@@ -87,6 +93,10 @@ public:
   MemBehavior visitLoadInst(LoadInst *LI);
   MemBehavior visitStoreInst(StoreInst *SI);
   MemBehavior visitApplyInst(ApplyInst *AI);
+
+  /// Returns true if the effects which a callee has on its argument \p Arg
+  /// may affect the memory at V.
+  bool mayAccessThroughArgument(SILValue Arg);
   MemBehavior visitTryApplyInst(TryApplyInst *AI);
   MemBehavior visitBuiltinInst(BuiltinInst *BI);
   MemBehavior visitStrongReleaseInst(StrongReleaseInst *BI);
@@ -226,6 +236,23 @@ MemBehavior MemoryBehaviorVisitor::visitTryApplyInst(TryApplyInst *AI) {
   return Behavior;
 }
 
+bool MemoryBehaviorVisitor::mayAccessThroughArgument(SILValue Arg) {
+  if (Arg.getType().isAddress())
+    return !AA->isNoAlias(Arg, V, computeTBAAType(Arg), getValueTBAAType());
+
+  // The side effect analysis attributes an access to a reference argument only
+  // if the accessed address is projected from the reference itself, e.g. with
+  // ref_element_addr. Accesses through references which are loaded from the
+  // object are global effects. So if V is projected from an object which
+  // does not alias the reference, the argument effects don't matter.
+  if (!Arg.getType().hasReferenceSemantics())
+    return true;
+  SILValue Object = getUnderlyingObject(V);
+  if (Object.getType().isAddress() || !Object.getType().hasReferenceSemantics())
+    return true;
+  return !AA->isNoAlias(Arg, Object);
+}
+
 MemBehavior MemoryBehaviorVisitor::visitApplyInst(ApplyInst *AI) {
 
   SideEffectAnalysis::FunctionEffects ApplyEffects;
@@ -250,10 +277,8 @@ MemBehavior MemoryBehaviorVisitor::visitApplyInst(ApplyInst *AI) {
       if (ArgBehavior > Behavior) {
         SILValue Arg = AI->getArgument(Idx);
         // We only consider the argument effects if the argument aliases V.
-        if (!Arg.getType().isAddress() ||
-            !AA->isNoAlias(Arg, V, computeTBAAType(Arg), getValueTBAAType())) {
+        if (mayAccessThroughArgument(Arg))
           Behavior = ArgBehavior;
-        }
       }
     }
   }
@@ -309,8 +334,20 @@ MemBehavior MemoryBehaviorVisitor::visitReleaseValueInst(ReleaseValueInst *SI) {
 MemBehavior
 AliasAnalysis::computeMemoryBehavior(SILInstruction *Inst, SILValue V,
                                  RetainObserveKind InspectionMode) {
+  MemoryBehaviorCacheKey Key = {{getValueIndex(Inst), getValueIndex(V)},
+                                unsigned(InspectionMode)};
+  auto Iter = MemoryBehaviorCache.find(Key);
+  if (Iter != MemoryBehaviorCache.end()) {
+    ++NumMemoryBehaviorCacheHits;
+    return Iter->second;
+  }
+  ++NumMemoryBehaviorCacheMisses;
+
   DEBUG(llvm::dbgs() << "GET MEMORY BEHAVIOR FOR:\n    " << *Inst << "    "
                      << *V.getDef());
   assert(SEA && "SideEffectsAnalysis must be initialized!");
-  return MemoryBehaviorVisitor(this, SEA, V, InspectionMode).visit(Inst);
+  MemBehavior Result =
+      MemoryBehaviorVisitor(this, SEA, V, InspectionMode).visit(Inst);
+  MemoryBehaviorCache[Key] = Result;
+  return Result;
 }
@@ -279,10 +279,11 @@ void SideEffectAnalysis::analyzeFunction(SILFunction *F,
 }
 
 void SideEffectAnalysis::analyzeInstruction(FunctionEffects &FE,
-                                            SILInstruction *I) {
+                                            SILInstruction *I,
+                                            bool isRecomputing) {
   if (FullApplySite FAS = FullApplySite::isa(I)) {
     FunctionEffects ApplyEffects;
-    getEffectsOfApply(ApplyEffects, FAS, true);
+    getEffectsOfApply(ApplyEffects, FAS, isRecomputing);
     FE.mergeFromApply(ApplyEffects, FAS);
     return;
   }
@@ -395,8 +396,71 @@ void SideEffectAnalysis::initialize(SILPassManager *PM) {
   CGA = PM->getAnalysis<CallGraphAnalysis>();
 }
 
+/// Returns true if \p LHS and \p RHS describe the same effects.
+static bool isSameEffects(const FunctionEffects &LHS,
+                          const FunctionEffects &RHS) {
+  if (LHS.getParameterEffects().size() != RHS.getParameterEffects().size())
+    return false;
+  FunctionEffects L = LHS, R = RHS;
+  return !L.mergeFrom(RHS) && !R.mergeFrom(LHS);
+}
+
+bool SideEffectAnalysis::recomputeInvalidatedFunctions() {
+  CallGraph &CG = CGA->getOrBuildCallGraph();
+
+  WorkListType WorkList;
+  for (SILFunction *F : InvalidatedFunctions)
+    WorkList.insert(F);
+  InvalidatedFunctions.clear();
+
+  // Usually the effects only get smaller, and this terminates quickly. But
+  // this is not guaranteed (e.g. for recursive functions), so bail out if
+  // it takes too long.
+  unsigned MaxSteps = 4 * M.getFunctionList().size();
+  unsigned Steps = 0;
+  while (!WorkList.empty()) {
+    if (++Steps > MaxSteps)
+      return false;
+
+    SILFunction *F = WorkList.pop_back_val();
+    DEBUG(llvm::dbgs() << "reanalyze " << F->getName() << "\n");
+
+    // In contrast to analyzeFunction, compute the effects from scratch so that
+    // they can get smaller. Callees which were not analyzed yet, e.g. because
+    // they were just created, get the worst effects.
+    FunctionEffects NewEffects(F->empty() ? 0 : F->getArguments().size());
+    if (!getDefinedEffects(NewEffects, F)) {
+      if (!F->isDefinition()) {
+        NewEffects.setWorstEffects();
+      } else {
+        for (auto &BB : *F) {
+          for (auto &I : BB) {
+            analyzeInstruction(NewEffects, &I, /*isRecomputing*/ false);
+          }
+        }
+      }
+    }
+
+    auto *FE = getFunctionEffects(F, true);
+    if (isSameEffects(*FE, NewEffects))
+      continue;
+    *FE = NewEffects;
+
+    for (auto *CallerEdge : CG.getCallerEdges(F)) {
+      SILFunction *Caller = CallerEdge->getInstruction()->getFunction();
+      WorkList.insert(Caller);
+    }
+  }
+  return true;
+}
+
 void SideEffectAnalysis::recompute() {
 
+  // If only some function bodies changed, try to update just their effects.
+  if (!shouldRecompute && !InvalidatedFunctions.empty() &&
+      !recomputeInvalidatedFunctions())
+    shouldRecompute = true;
+
   // Did anything change since the last recompuation? (Probably yes)
   if (!shouldRecompute)
     return;
@@ -404,6 +468,7 @@ void SideEffectAnalysis::recompute() {
   Function2Effects.clear();
   Allocator.DestroyAll();
   shouldRecompute = false;
+  InvalidatedFunctions.clear();
 
   WorkListType WorkList;
 
@@ -383,6 +383,10 @@ void SILGenModule::preEmitFunction(SILDeclRef constant,
 
   F->setDeclContext(astNode);
 
+  if (FunctionTimeProfile::getActive())
+    FunctionTimers.emplace_back(new FunctionTimeProfile::Timer(
+      F->getDeclContext(), F->getName(), FunctionTimeProfile::Phase::SILGen));
+
   DEBUG(llvm::dbgs() << "lowering ";
         F->printName(llvm::dbgs());
         llvm::dbgs() << " : $";
@@ -400,6 +404,9 @@ void SILGenModule::postEmitFunction(SILDeclRef constant,
   DEBUG(llvm::dbgs() << "lowered sil:\n";
         F->print(llvm::dbgs()));
   F->verify();
+
+  if (!FunctionTimers.empty())
+    FunctionTimers.pop_back();
 }
 
 void SILGenModule::emitAbstractFuncDecl(AbstractFunctionDecl *AFD) {
@@ -18,6 +18,7 @@
 #include "SILGenProfiling.h"
 #include "swift/AST/ASTContext.h"
 #include "swift/AST/DiagnosticEngine.h"
+#include "swift/AST/FunctionTimeProfile.h"
 #include "swift/SIL/SILDebugScope.h"
 #include "swift/SIL/SILFunction.h"
 #include "swift/SIL/SILModule.h"
@@ -81,6 +82,10 @@ public:
   /// The most recent declaration we considered for emission.
   SILDeclRef lastEmittedFunction;
 
+  /// For -debug-time-functions, a timer for each function that is being
+  /// emitted, innermost last.
+  std::vector<std::unique_ptr<FunctionTimeProfile::Timer>> FunctionTimers;
+
   /// Set of used conformances for which witness tables need to be emitted.
   llvm::DenseSet<NormalProtocolConformance *> usedConformances;
 
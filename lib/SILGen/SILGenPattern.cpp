@@ -18,9 +18,11 @@
 #include "Initialization.h"
 #include "RValue.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallSet.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FormattedStream.h"
 #include "swift/AST/DiagnosticsSIL.h"
+#include "swift/AST/Expr.h"
 #include "swift/AST/Pattern.h"
 #include "swift/AST/SILOptions.h"
 #include "swift/AST/Types.h"
@@ -253,6 +255,105 @@ Pattern *getSpecializingPattern(Pattern *p) {
   return (isWildcardPattern(p) ? nullptr : p);
 }
 
+/// The smallest number of consecutive integer literal patterns which are
+/// dispatched with a switch_value instead of a chain of '~=' calls.
+static const unsigned MinIntegerLiteralSwitchRows = 4;
+
+namespace {
+/// An expression pattern which matches an integer literal.
+struct IntegerLiteralMatch {
+  /// The Builtin integer property of the standard library integer type.
+  VarDecl *ValueField;
+  /// The literal, at the width of ValueField.
+  APInt Value;
+};
+} // end anonymous namespace
+
+/// If \p p is an expression pattern which compares a value of a standard
+/// library integer type with an integer literal using the standard library's
+/// '~=', return the literal's value. Other patterns may have a user-defined
+/// notion of matching and must be tested by calling '~='.
+static Optional<IntegerLiteralMatch> getIntegerLiteralMatch(Pattern *p) {
+  if (!p) return None;
+  auto *exprPattern = dyn_cast<ExprPattern>(p->getSemanticsProvidingPattern());
+  if (!exprPattern || !exprPattern->getMatchExpr() || !exprPattern->hasType())
+    return None;
+
+  // The value must be one of the standard integer types, which store a single
+  // Builtin integer.
+  auto *structDecl = exprPattern->getType()->getStructOrBoundGenericStruct();
+  if (!structDecl || !structDecl->getModuleContext()->isStdlibModule())
+    return None;
+  StringRef typeName = structDecl->getName().str();
+  bool isSigned = typeName.startswith("Int");
+  if (!isSigned && !typeName.startswith("UInt"))
+    return None;
+  if (typeName.drop_front(isSigned ? 3 : 4).find_first_not_of("0123456789")
+        != StringRef::npos)
+    return None;
+  VarDecl *field = nullptr;
+  for (VarDecl *stored : structDecl->getStoredProperties()) {
+    if (field)
+      return None;
+    field = stored;
+  }
+  if (!field)
+    return None;
+  auto intTy = field->getType()->getAs<BuiltinIntegerType>();
+  if (!intTy || intTy->getGreatestWidth() > 64)
+    return None;
+
+  // Find the '~=' call, which is wrapped in the conversion to a condition.
+  BinaryExpr *matchCall = nullptr;
+  exprPattern->getMatchExpr()->forEachChildExpr([&](Expr *e) -> Expr * {
+    if (!matchCall)
+      matchCall = dyn_cast<BinaryExpr>(e);
+    return e;
+  });
+  if (!matchCall)
+    return None;
+  auto *matchOp = matchCall->getCalledValue();
+  if (!matchOp || !matchOp->getModuleContext()->isStdlibModule() ||
+      matchOp->getName() != structDecl->getASTContext().Id_MatchOperator)
+    return None;
+  auto *matchArgs = dyn_cast<TupleExpr>(matchCall->getArg());
+  if (!matchArgs || matchArgs->getNumElements() != 2)
+    return None;
+
+  // The pattern side must be the literal converted by the type's own
+  // initializer.
+  auto *literalCall =
+    dyn_cast<CallExpr>(matchArgs->getElement(0)->getSemanticsProvidingExpr());
+  if (!literalCall)
+    return None;
+  auto *ctorRef = dyn_cast<ConstructorRefCallExpr>(
+                    literalCall->getFn()->getSemanticsProvidingExpr());
+  if (!ctorRef || !ctorRef->getCalledValue() ||
+      ctorRef->getCalledValue()->getDeclContext()
+        ->getDeclaredTypeOfContext()->getAnyNominal() != structDecl)
+    return None;
+  Expr *literalArg = literalCall->getArg()->getSemanticsProvidingExpr();
+  if (auto *argTuple = dyn_cast<TupleExpr>(literalArg)) {
+    if (argTuple->getNumElements() != 1)
+      return None;
+    literalArg = argTuple->getElement(0)->getSemanticsProvidingExpr();
+  }
+  auto *literal = dyn_cast<IntegerLiteralExpr>(literalArg);
+  if (!literal || !literal->getType()->is<BuiltinIntegerType>())
+    return None;
+
+  // Leave literals which do not fit the type to the conversion, which
+  // diagnoses them.
+  APInt value = literal->getValue();
+  unsigned width = intTy->getLeastWidth();
+  if (isSigned ? !value.isSignedIntN(width)
+               : (value.isNegative() || !value.isIntN(width)))
+    return None;
+
+  return IntegerLiteralMatch{field,
+                             value.trunc(intTy->getGreatestWidth())};
+}
+
 /// Given a pattern stored in a clause matrix, check to see whether it
 /// can be specialized the same way as the first one.
 static Pattern *getSimilarSpecializingPattern(Pattern *p, Pattern *first) {
@@ -428,6 +529,11 @@ public:
   void emitCaseBody(CaseStmt *caseBlock);
 
 private:
+  unsigned getIntegerLiteralRowsEnd(const ClauseMatrix &matrix,
+                                    ArgArray args, unsigned firstRow);
+  void emitIntegerLiteralDispatch(ClauseMatrix &matrix, ArgArray args,
+                                  unsigned firstRow, unsigned endRow,
+                                  const FailureHandler &failure);
   void emitWildcardDispatch(ClauseMatrix &matrix, ArgArray args, unsigned row,
                             const FailureHandler &failure);
 
@@ -970,8 +1076,17 @@ void PatternMatchEmission::emitDispatch(ClauseMatrix &clauses, ArgArray args,
       SGF.Cleanups.emitBranchAndCleanups(scope.getExitDest(), loc);
     };
 
-    // If there is no necessary column, just emit the first row.
-    if (!column) {
+    // A run of integer literal patterns can be dispatched with one switch.
+    unsigned literalRowsEnd =
+      column ? firstRow : getIntegerLiteralRowsEnd(clauses, args, firstRow);
+
+    if (literalRowsEnd - firstRow >= MinIntegerLiteralSwitchRows) {
+      unsigned literalRow = firstRow;
+      firstRow = literalRowsEnd;
+      emitIntegerLiteralDispatch(clauses, args, literalRow, literalRowsEnd,
+                                 innerFailure);
+    } else if (!column) {
+      // If there is no necessary column, just emit the first row.
       unsigned wildcardRow = firstRow++;
       emitWildcardDispatch(clauses, args, wildcardRow, innerFailure);
     } else {
@@ -1010,6 +1125,73 @@ void PatternMatchEmission::emitDispatch(ClauseMatrix &clauses, ArgArray args,
   }
 }
 
+/// Return the end of the run of rows starting at \p firstRow which match a
+/// single trivial value against integer literals of the same type, without
+/// guards.
+unsigned PatternMatchEmission::getIntegerLiteralRowsEnd(
+    const ClauseMatrix &clauses, ArgArray args, unsigned firstRow) {
+  if (args.size() != 1 || !args[0].getType().isObject() ||
+      !SGF.getTypeLowering(args[0].getType()).isTrivial())
+    return firstRow;
+
+  VarDecl *valueField = nullptr;
+  unsigned row = firstRow;
+  for (unsigned e = clauses.rows(); row != e; ++row) {
+    if (clauses[row].getCaseGuardExpr())
+      break;
+    auto match = getIntegerLiteralMatch(clauses[row][0]);
+    if (!match)
+      break;
+    if (valueField && match->ValueField != valueField)
+      break;
+    valueField = match->ValueField;
+  }
+  return row;
+}
+
+/// Emit the rows from \p firstRow to \p endRow, which all match against
+/// integer literals, as a single switch_value on the Builtin integer. If a
+/// literal appears more than once, only its first row can match.
+void PatternMatchEmission::emitIntegerLiteralDispatch(ClauseMatrix &clauses,
+                                                      ArgArray args,
+                                                      unsigned firstRow,
+                                                      unsigned endRow,
+                                                const FailureHandler &failure) {
+  SILLocation loc = PatternMatchStmt;
+  loc.setDebugLoc(clauses[firstRow].getCasePattern());
+
+  VarDecl *valueField = getIntegerLiteralMatch(clauses[firstRow][0])
+                          ->ValueField;
+  SILValue value = SGF.B.createStructExtract(loc, args[0].getValue(),
+                                             valueField);
+
+  SmallVector<std::pair<SILValue, SILBasicBlock *>, 16> caseBBs;
+  SmallVector<unsigned, 16> caseRows;
+  llvm::SmallSet<uint64_t, 16> seenValues;
+  for (unsigned row = firstRow; row != endRow; ++row) {
+    APInt literal = getIntegerLiteralMatch(clauses[row][0])->Value;
+    if (!seenValues.insert(literal.getZExtValue()).second)
+      continue;
+    auto *caseValue = SGF.B.createIntegerLiteral(loc, value.getType(), literal);
+    caseBBs.push_back({SILValue(caseValue, 0), SGF.createBasicBlock()});
+    caseRows.push_back(row);
+  }
+
+  SILBasicBlock *defaultBB = SGF.createBasicBlock();
+  SGF.B.createSwitchValue(loc, value, defaultBB, caseBBs);
+
+  // The literal patterns have no bindings, so a matching row is entered
+  // directly.
+  for (unsigned i = 0, e = caseBBs.size(); i != e; ++i) {
+    SGF.B.setInsertionPoint(caseBBs[i].second);
+    CompletionHandler(*this, clauses[caseRows[i]]);
+    assert(!SGF.B.hasValidInsertionPoint() && "did not end block");
+  }
+
+  SGF.B.setInsertionPoint(defaultBB);
+  failure(loc);
+}
+
 /// Emit the decision tree for a row containing only non-specializing
 /// patterns.
 ///
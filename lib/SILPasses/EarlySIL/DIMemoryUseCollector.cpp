@@ -903,10 +903,11 @@ void ElementUseCollector::recordFailableInitCall(SILInstruction *I) {
       if (!isa<SelectEnumInst>(User) && !isa<SelectEnumAddrInst>(User))
         continue;
       
-      if (!User->hasOneUse())
+      Operand *SingleUse = User->getSingleUse();
+      if (!SingleUse)
         continue;
-      
-      User = User->use_begin()->getUser();
+
+      User = SingleUse->getUser();
       if (auto *CBI = dyn_cast<CondBranchInst>(User)) {
         recordFailureBB(CBI, CBI->getTrueBB());
         return;
@@ -171,75 +171,113 @@ static Optional<DIKind> mergeKinds(Optional<DIKind> OK1, Optional<DIKind> OK2) {
 namespace {
   /// AvailabilitySet - This class stores an array of lattice values for tuple
   /// elements being analyzed for liveness computations.  Each element is
-  /// represented with two bits in a bitvector, allowing this to represent the
-  /// lattice values corresponding to "Unknown" (bottom), "Live" or "Not Live",
-  /// which are the middle elements of the lattice, and "Partial" which is the
-  /// top element.
+  /// represented with two bits, allowing this to represent the lattice values
+  /// corresponding to "Unknown" (bottom), "Live" or "Not Live", which are the
+  /// middle elements of the lattice, and "Partial" which is the top element.
+  ///
+  /// The bits of all elements are kept in two dense arrays of words, one
+  /// saying which elements are initialized on some path and one saying which
+  /// are uninitialized on some path, so that merging sets is a bitwise or and
+  /// costs one operation per 64 elements:
+  ///   neither -> Nothing/Unknown
+  ///   uninitialized -> No
+  ///   initialized -> Yes
+  ///   both -> Partial
   class AvailabilitySet {
-    // We store two bits per element, encoded in the following form:
-    //   T,T -> Nothing/Unknown
-    //   F,F -> No
-    //   F,T -> Yes
-    //   T,F -> Partial
-    llvm::SmallBitVector Data;
+    typedef uint64_t WordType;
+    enum { BitsPerWord = 64 };
+
+    unsigned NumElts;
+    /// The words of the initialized bits, followed by the words of the
+    /// uninitialized bits.
+    SmallVector<WordType, 2> Words;
+
+    unsigned getNumWords() const {
+      return (NumElts + BitsPerWord - 1) / BitsPerWord;
+    }
+    WordType *yesWords() { return Words.data(); }
+    WordType *noWords() { return Words.data() + getNumWords(); }
+    const WordType *yesWords() const { return Words.data(); }
+    const WordType *noWords() const { return Words.data() + getNumWords(); }
+
+    /// The bits of the elements in the word \p W.
+    WordType getWordMask(unsigned W) const {
+      unsigned Rest = NumElts - W * BitsPerWord;
+      return Rest >= BitsPerWord ? ~WordType(0) : (WordType(1) << Rest) - 1;
+    }
+
+    bool getBit(const WordType *Bits, unsigned Elt) const {
+      return (Bits[Elt / BitsPerWord] >> (Elt % BitsPerWord)) & 1;
+    }
+    void setBit(WordType *Bits, unsigned Elt, bool V) {
+      WordType Bit = WordType(1) << (Elt % BitsPerWord);
+      if (V)
+        Bits[Elt / BitsPerWord] |= Bit;
+      else
+        Bits[Elt / BitsPerWord] &= ~Bit;
+    }
+
   public:
-    AvailabilitySet(unsigned NumElts) {
-      Data.resize(NumElts*2, true);
+    AvailabilitySet(unsigned NumElts) : NumElts(NumElts) {
+      Words.resize(getNumWords() * 2, 0);
     }
 
-    bool empty() const { return Data.empty(); }
-    unsigned size() const { return Data.size()/2; }
+    bool empty() const { return NumElts == 0; }
+    unsigned size() const { return NumElts; }
 
     DIKind get(unsigned Elt) const {
       return getConditional(Elt).getValue();
     }
 
     Optional<DIKind> getConditional(unsigned Elt) const {
-      bool V1 = Data[Elt*2], V2 = Data[Elt*2+1];
-      if (V1 == V2)
-        return V1 ? Optional<DIKind>(None) : DIKind::No;
-      return V2 ? DIKind::Yes : DIKind::Partial;
+      bool Yes = getBit(yesWords(), Elt), No = getBit(noWords(), Elt);
+      if (Yes == No)
+        return Yes ? DIKind::Partial : Optional<DIKind>(None);
+      return Yes ? DIKind::Yes : DIKind::No;
     }
 
     void set(unsigned Elt, DIKind K) {
-      switch (K) {
-      case DIKind::No:      Data[Elt*2] = false; Data[Elt*2+1] = false; break;
-      case DIKind::Yes:     Data[Elt*2] = false, Data[Elt*2+1] = true; break;
-      case DIKind::Partial: Data[Elt*2] = true,  Data[Elt*2+1] = false; break;
-      }
+      setBit(yesWords(), Elt, K != DIKind::No);
+      setBit(noWords(), Elt, K != DIKind::Yes);
     }
     
     void set(unsigned Elt, Optional<DIKind> K) {
-      if (!K.hasValue())
-        Data[Elt*2] = true, Data[Elt*2+1] = true;
-      else
+      if (!K.hasValue()) {
+        setBit(yesWords(), Elt, false);
+        setBit(noWords(), Elt, false);
+      } else {
         set(Elt, K.getValue());
+      }
     }
 
     /// containsUnknownElements - Return true if there are any elements that are
     /// unknown.
     bool containsUnknownElements() const {
-      // Check that we didn't get any unknown values.
-      for (unsigned i = 0, e = size(); i != e; ++i)
-        if (!getConditional(i).hasValue())
+      for (unsigned W = 0, E = getNumWords(); W != E; ++W)
+        if ((yesWords()[W] | noWords()[W]) != getWordMask(W))
           return true;
       return false;
     }
 
     bool isAll(DIKind K) const {
-      for (unsigned i = 0, e = size(); i != e; ++i) {
-        auto Elt = getConditional(i);
-        if (!Elt.hasValue() || Elt.getValue() != K)
+      bool WantYes = K != DIKind::No, WantNo = K != DIKind::Yes;
+      for (unsigned W = 0, E = getNumWords(); W != E; ++W) {
+        WordType Mask = getWordMask(W);
+        if (yesWords()[W] != (WantYes ? Mask : 0) ||
+            noWords()[W] != (WantNo ? Mask : 0))
           return false;
       }
       return true;
     }
     
     bool hasAny(DIKind K) const {
-      for (unsigned i = 0, e = size(); i != e; ++i) {
-        auto Elt = getConditional(i);
-        if (Elt.hasValue() && Elt.getValue() == K)
-          return true;
+      for (unsigned W = 0, E = getNumWords(); W != E; ++W) {
+        WordType Yes = yesWords()[W], No = noWords()[W];
+        switch (K) {
+        case DIKind::No:      if (No & ~Yes) return true; break;
+        case DIKind::Yes:     if (Yes & ~No) return true; break;
+        case DIKind::Partial: if (Yes & No) return true; break;
+        }
       }
       return false;
     }
@@ -250,16 +288,38 @@ namespace {
     /// changeUnsetElementsTo - If any elements of this availability set are not
     /// known yet, switch them to the specified value.
     void changeUnsetElementsTo(DIKind K) {
-      for (unsigned i = 0, e = size(); i != e; ++i)
-        if (!getConditional(i).hasValue())
-          set(i, K);
+      for (unsigned W = 0, E = getNumWords(); W != E; ++W) {
+        WordType Unset = ~(yesWords()[W] | noWords()[W]) & getWordMask(W);
+        if (K != DIKind::No)
+          yesWords()[W] |= Unset;
+        if (K != DIKind::Yes)
+          noWords()[W] |= Unset;
+      }
     }
     
     void mergeIn(const AvailabilitySet &RHS) {
       // Logically, this is an elementwise "this = merge(this, RHS)" operation,
       // using the lattice merge operation for each element.
-      for (unsigned i = 0, e = size(); i != e; ++i)
-        set(i, mergeKinds(getConditional(i), RHS.getConditional(i)));
+      for (unsigned i = 0, e = Words.size(); i != e; ++i)
+        Words[i] |= RHS.Words[i];
+    }
+
+    /// Merges \p RHS into the elements which are unknown in \p Local.
+    /// Returns true if any element changed.
+    bool mergeInExcept(const AvailabilitySet &RHS,
+                       const AvailabilitySet &Local) {
+      bool Changed = false;
+      for (unsigned W = 0, E = getNumWords(); W != E; ++W) {
+        WordType Unknown = ~(Local.yesWords()[W] | Local.noWords()[W]);
+        WordType Yes = yesWords()[W] | (RHS.yesWords()[W] & Unknown);
+        WordType No = noWords()[W] | (RHS.noWords()[W] & Unknown);
+        if (Yes != yesWords()[W] || No != noWords()[W]) {
+          yesWords()[W] = Yes;
+          noWords()[W] = No;
+          Changed = true;
+        }
+      }
+      return Changed;
     }
 
     void dump(llvm::raw_ostream &OS) const {
@@ -363,17 +423,11 @@ namespace {
     /// Merge the state from a predecessor block into the OutAvailability.
     /// Returns true if the live out set changed.
     bool mergeFromPred(const LiveOutBlockState &Pred) {
-      bool changed = false;
-      for (unsigned i = 0, e = OutAvailability.size(); i != e; ++i) {
-        Optional<DIKind> result;
-        if (transferAvailability(Pred.OutAvailability.getConditional(i),
-                                 OutAvailability.getConditional(i),
-                                 LocalAvailability.getConditional(i),
-                                 result)) {
-          changed = true;
-          OutAvailability.set(i, result);
-        }
-      }
+      // The elements known locally are the same in OutAvailability and
+      // override the predecessor. For the others, the transfer function is
+      // the lattice merge.
+      bool changed = OutAvailability.mergeInExcept(Pred.OutAvailability,
+                                                   LocalAvailability);
 
       Optional<DIKind> result;
       if (transferAvailability(Pred.OutSelfConsumed,
@@ -1117,13 +1171,14 @@ static bool isFailableInitReturnUseOfEnum(EnumInst *EI) {
   if (!EI->getType().getSwiftRValueType()->getOptionalObjectType())
     return false;
 
-  if (!EI->hasOneUse()) return false;
-  auto *BI = dyn_cast<BranchInst>(EI->use_begin()->getUser());
+  Operand *Use = EI->getSingleUse();
+  if (!Use) return false;
+  auto *BI = dyn_cast<BranchInst>(Use->getUser());
   if (!BI || BI->getNumArgs() != 1) return false;
 
   auto *TargetArg = BI->getDestBB()->getBBArg(0);
-  if (!TargetArg->hasOneUse()) return false;
-  return isa<ReturnInst>(TargetArg->use_begin()->getUser());
+  Operand *ArgUse = TargetArg->getSingleUse();
+  return ArgUse && isa<ReturnInst>(ArgUse->getUser());
 }
 
 enum BadSelfUseKind {
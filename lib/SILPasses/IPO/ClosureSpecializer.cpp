@@ -52,6 +52,12 @@
 /// 3. Handling addresses. We currently do not handle address types. We can in
 ///    the future by introducing alloc_stacks.
 ///
+/// 4. Generic callees. Higher-order functions like map and filter are usually
+///    generic. We can only clone non-generic callees, so if a closure is passed
+///    to a generic function, we first specialize the callee for the
+///    substitutions of the call site and then specialize the closure in the
+///    specialized callee.
+///
 //===----------------------------------------------------------------------===//
 
 #define DEBUG_TYPE "closure-specialization"
@@ -66,6 +72,7 @@
 #include "swift/SILAnalysis/FunctionOrder.h"
 #include "swift/SILAnalysis/ValueTracking.h"
 #include "swift/SILPasses/Transforms.h"
+#include "swift/SILPasses/Utils/Generics.h"
 #include "swift/SILPasses/Utils/SILInliner.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/SmallString.h"
@@ -80,6 +87,8 @@ STATISTIC(NumPropagatedClosuresEliminated,
           "Number of closures propagated and then eliminated");
 STATISTIC(NumPropagatedClosuresNotEliminated,
           "Number of closures propagated but not eliminated");
+STATISTIC(NumGenericClosureUsersSpecialized,
+          "Number of generic closure users specialized");
 
 llvm::cl::opt<bool> EliminateDeadClosures(
     "closure-specialize-eliminate-dead-closures", llvm::cl::init(true),
@@ -478,6 +487,18 @@ static bool isSupportedClosure(const SILInstruction *Closure) {
   return true;
 }
 
+/// Returns true if the argument of \p Callee at \p ArgIdx is invoked in
+/// \p Callee. We only want to perform closure specialization if we know that
+/// we will be able to change a partial_apply into an apply.
+static bool isClosureArgumentApplied(SILFunction *Callee, unsigned ArgIdx) {
+  SILValue Arg = Callee->getArgument(ArgIdx);
+  return std::any_of(Arg->use_begin(), Arg->use_end(),
+                     [&Arg](Operand *Op) -> bool {
+                       auto UserAI = FullApplySite::isa(Op->getUser());
+                       return UserAI && UserAI.getCallee() == Arg;
+                     });
+}
+
 //===----------------------------------------------------------------------===//
 //                     Closure Spec Cloner Implementation
 //===----------------------------------------------------------------------===//
@@ -679,6 +700,7 @@ public:
   void gatherCallSites(SILFunction *Caller,
                        llvm::SmallVectorImpl<ClosureInfo*> &ClosureCandidates,
                        llvm::DenseSet<FullApplySite> &MultipleClosureAI);
+  bool specializeGenericClosureUsers(SILFunction *Caller);
   bool specialize(SILFunction *Caller);
 
   ArrayRef<SILInstruction *> getPropagatedClosures() {
@@ -755,20 +777,12 @@ void ClosureSpecializer::gatherCallSites(
         if (!ClosureIndex.hasValue())
           continue;
 
-        // Make sure that the Closure is invoked in the Apply's callee. We only
-        // want to perform closure specialization if we know that we will be
-        // able to change a partial_apply into an apply.
+        // Make sure that the Closure is invoked in the Apply's callee.
         //
         // TODO: Maybe just call the function directly instead of moving the
         // partial apply?
-        SILValue Arg = ApplyCallee->getArgument(ClosureIndex.getValue());
-        if (std::none_of(Arg->use_begin(), Arg->use_end(),
-                         [&Arg](Operand *Op) -> bool {
-                           auto UserAI = FullApplySite::isa(Op->getUser());
-                           return UserAI && UserAI.getCallee() == Arg;
-                         })) {
+        if (!isClosureArgumentApplied(ApplyCallee, ClosureIndex.getValue()))
           continue;
-        }
 
         auto ParamInfo = AI.getSubstCalleeType()->getParameters();
         SILParameterInfo ClosureParamInfo = ParamInfo[ClosureIndex.getValue()];
@@ -804,17 +818,63 @@ void ClosureSpecializer::gatherCallSites(
   }
 }
 
+/// Specialize generic callees which are passed a closure that we support and
+/// invoke it. The calls to the specializations have no substitutions and can
+/// then be handled by gatherCallSites.
+bool ClosureSpecializer::specializeGenericClosureUsers(SILFunction *Caller) {
+  llvm::SmallVector<FullApplySite, 8> GenericApplies;
+  for (auto &BB : *Caller) {
+    for (auto &II : BB) {
+      auto AI = FullApplySite::isa(&II);
+      if (!AI || !AI.hasSubstitutions())
+        continue;
+
+      SILFunction *ApplyCallee = AI.getCalleeFunction();
+      if (!ApplyCallee || ApplyCallee->isExternalDeclaration())
+        continue;
+
+      for (unsigned i = 0, e = AI.getNumArguments(); i != e; ++i) {
+        auto *Closure = dyn_cast<SILInstruction>(AI.getArgument(i));
+        if (Closure && isSupportedClosure(Closure) &&
+            isClosureArgumentApplied(ApplyCallee, i)) {
+          GenericApplies.push_back(AI);
+          break;
+        }
+      }
+    }
+  }
+
+  bool Changed = false;
+  for (FullApplySite AI : GenericApplies) {
+    // We don't need to track the cloned instructions.
+    CloneCollector Collector([](SILInstruction *) { return false; });
+    SILFunction *SpecializedFunction;
+    auto Specialized =
+        trySpecializeApplyOfGeneric(AI, SpecializedFunction, Collector);
+    if (!Specialized)
+      continue;
+
+    DEBUG(llvm::dbgs() << "    Specialized generic closure user: "
+                       << *Specialized.getInstruction());
+    replaceDeadApply(AI, Specialized.getInstruction());
+    ++NumGenericClosureUsersSpecialized;
+    Changed = true;
+  }
+  return Changed;
+}
+
 bool ClosureSpecializer::specialize(SILFunction *Caller) {
   DEBUG(llvm::dbgs() << "Optimizing callsites that take closure argument in "
                      << Caller->getName() << '\n');
 
+  bool Changed = specializeGenericClosureUsers(Caller);
+
   // Collect all of the PartialApplyInsts that are used as arguments to
   // ApplyInsts. Check the profitability of specializing the closure argument.
   llvm::SmallVector<ClosureInfo*, 8> ClosureCandidates;
   llvm::DenseSet<FullApplySite> MultipleClosureAI;
   gatherCallSites(Caller, ClosureCandidates, MultipleClosureAI);
 
-  bool Changed = false;
   for (auto *CInfo : ClosureCandidates) {
     for (auto &CSDesc : CInfo->CallSites) {
       // Do not specialize apply insts that take in multiple closures. This pass
@@ -0,0 +1,447 @@
+//===--- ColdBlockOutliner.cpp - Move cold regions out of line ------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Outline cold regions of a function into separate functions, so that the
+// hot code is denser in the instruction cache.
+//
+// A region is a block together with all the blocks it dominates. It is cold
+// if it cannot reach a return, like the paths which report a fatal error, or
+// if its entry is cold according to ColdBlockInfo, like the paths gated by a
+// _slowPath branch hint. Only regions which do not branch back into the rest
+// of the function are outlined, so the outlined function either does not
+// return or returns the result of the original function.
+//
+// The outlined functions are marked noinline and with the "cold" semantics,
+// which IRGen turns into the LLVM cold attribute. LLVM then treats the blocks
+// which call them as unlikely.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "cold-block-outliner"
+#include "swift/SILPasses/Passes.h"
+#include "swift/SIL/SILCloner.h"
+#include "swift/SIL/SILInstruction.h"
+#include "swift/SILAnalysis/ColdBlockInfo.h"
+#include "swift/SILAnalysis/DominanceAnalysis.h"
+#include "swift/SILPasses/Transforms.h"
+#include "swift/SILPasses/Utils/Local.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+
+using namespace swift;
+
+STATISTIC(NumRegionsOutlined, "Number of cold regions outlined");
+
+static llvm::cl::opt<unsigned> ColdRegionThreshold(
+    "sil-cold-region-threshold", llvm::cl::init(12),
+    llvm::cl::desc("The minimum number of instructions in a cold region "
+                   "which is outlined"));
+
+/// A region with more live-in values than this is not worth a call.
+static const unsigned MaxColdRegionArguments = 8;
+
+/// The semantics of outlined functions. IRGen marks them as cold.
+static const char *const ColdSemantics = "cold";
+
+namespace {
+typedef llvm::DomTreeNodeBase<SILBasicBlock> DomTreeNode;
+
+/// A cold region and the values it uses from the rest of the function.
+struct ColdRegion {
+  /// The block which dominates the region. It stays in the original function
+  /// and calls the outlined function.
+  SILBasicBlock *Entry = nullptr;
+
+  /// The blocks of the region, starting with the entry.
+  llvm::SmallVector<SILBasicBlock *, 8> Blocks;
+  llvm::SmallPtrSet<SILBasicBlock *, 8> BlockSet;
+
+  /// The values defined outside the region which are passed to the outlined
+  /// function, after the arguments of the entry block.
+  llvm::SetVector<SILValue> LiveIns;
+
+  /// Literals defined outside of the region, which are cloned into the
+  /// outlined function instead of being passed to it.
+  llvm::SetVector<SILInstruction *> Rematerialized;
+
+  /// A return in the region, if there is one.
+  ReturnInst *Return = nullptr;
+
+  bool contains(SILValue V) const {
+    if (auto *I = dyn_cast<SILInstruction>(V))
+      return BlockSet.count(I->getParent());
+    if (auto *Arg = dyn_cast<SILArgument>(V))
+      return BlockSet.count(Arg->getParent());
+    return false;
+  }
+};
+
+/// Clone a cold region into the body of an outlined function.
+class ColdRegionCloner : public SILCloner<ColdRegionCloner> {
+  friend class SILVisitor<ColdRegionCloner>;
+  friend class SILCloner<ColdRegionCloner>;
+
+public:
+  ColdRegionCloner(SILFunction *NewF) : SILCloner<ColdRegionCloner>(*NewF) {}
+
+  void cloneRegion(const ColdRegion &Region);
+
+protected:
+  /// The cloned instructions take on the outlined function's debug scope.
+  const SILDebugScope *remapScope(const SILDebugScope *DS) {
+    return getBuilder().getFunction().getDebugScope();
+  }
+};
+
+class ColdBlockOutliner : public SILModuleTransform {
+public:
+  void run() override;
+
+  StringRef getName() override { return "Cold Block Outliner"; }
+
+protected:
+  void findColdRegions(SILFunction *F, llvm::SmallVectorImpl<ColdRegion> &Regions);
+  void outlineRegion(SILFunction *F, ColdRegion &Region, unsigned Index);
+};
+} // end anonymous namespace
+
+/// Literals are cheaper to clone into the outlined function than to pass.
+static bool isRematerializable(SILValue V) {
+  auto *I = dyn_cast<SILInstruction>(V);
+  if (!I || I->getNumOperands() != 0)
+    return false;
+  return isa<LiteralInst>(I) || isa<MetatypeInst>(I) ||
+         isa<WitnessMethodInst>(I);
+}
+
+/// Opened archetypes are bound to the instruction which opened them, so code
+/// using them cannot move to another function.
+static bool hasOpenedArchetypes(SILInstruction &I) {
+  for (SILType Ty : I.getTypes())
+    if (Ty.getSwiftRValueType()->hasArchetype())
+      return true;
+  for (auto &Op : I.getAllOperands())
+    if (Op.get().getType().getSwiftRValueType()->hasArchetype())
+      return true;
+  if (auto AS = ApplySite::isa(&I)) {
+    for (auto &Sub : AS.getSubstitutions())
+      if (Sub.getReplacement()->hasArchetype())
+        return true;
+  }
+  if (auto *BI = dyn_cast<BuiltinInst>(&I)) {
+    for (auto &Sub : BI->getSubstitutions())
+      if (Sub.getReplacement()->hasArchetype())
+        return true;
+  }
+  if (auto *WMI = dyn_cast<WitnessMethodInst>(&I))
+    return WMI->getLookupType()->hasArchetype();
+  return false;
+}
+
+/// Returns true if \p V can be passed to the outlined function.
+static bool isPassable(SILValue V) {
+  SILType Ty = V.getType();
+  if (Ty.isLocalStorage())
+    return false;
+  if (auto FnTy = Ty.getAs<SILFunctionType>())
+    return !FnTy->isPolymorphic();
+  return true;
+}
+
+/// Collect the blocks dominated by \p Node into \p Region and the values they
+/// use from the rest of the function. Returns false if the region is not
+/// worth outlining or cannot be outlined.
+static bool collectRegion(DomTreeNode *Node, ColdRegion &Region) {
+  Region.Entry = Node->getBlock();
+  llvm::SmallVector<DomTreeNode *, 8> Worklist;
+  Worklist.push_back(Node);
+  while (!Worklist.empty()) {
+    DomTreeNode *N = Worklist.pop_back_val();
+    Region.Blocks.push_back(N->getBlock());
+    Region.BlockSet.insert(N->getBlock());
+    for (auto *Child : *N)
+      Worklist.push_back(Child);
+  }
+
+  unsigned NumInsts = 0;
+  for (SILBasicBlock *BB : Region.Blocks) {
+    // The entry block of the outlined function cannot have predecessors, and
+    // the other blocks are removed from the original function.
+    for (SILBasicBlock *Pred : BB->getPreds())
+      if ((BB == Region.Entry) == (Region.BlockSet.count(Pred) != 0))
+        return false;
+
+    // The region may only be left through a return or an unreachable.
+    TermInst *Term = BB->getTerminator();
+    if (auto *RI = dyn_cast<ReturnInst>(Term)) {
+      Region.Return = RI;
+    } else if (!isa<UnreachableInst>(Term)) {
+      if (Term->getSuccessors().empty())
+        return false;
+      for (auto &Succ : Term->getSuccessors())
+        if (!Region.BlockSet.count(Succ.getBB()))
+          return false;
+    }
+
+    for (auto &I : *BB) {
+      if (!isa<DebugValueInst>(I) && !isa<DebugValueAddrInst>(I))
+        ++NumInsts;
+      if (hasOpenedArchetypes(I))
+        return false;
+      // Objects which were allocated on the stack of the original function
+      // must be deallocated there.
+      if (auto *DRI = dyn_cast<DeallocRefInst>(&I))
+        if (DRI->canAllocOnStack() && !Region.contains(DRI->getOperand()))
+          return false;
+
+      for (auto &Op : I.getAllOperands()) {
+        SILValue V = Op.get();
+        if (isa<SILUndef>(V) || Region.contains(V))
+          continue;
+        if (isRematerializable(V)) {
+          Region.Rematerialized.insert(cast<SILInstruction>(V));
+          continue;
+        }
+        if (!isPassable(V))
+          return false;
+        Region.LiveIns.insert(V);
+      }
+    }
+  }
+
+  if (NumInsts < ColdRegionThreshold)
+    return false;
+  for (SILArgument *Arg : Region.Entry->getBBArgs())
+    if (!isPassable(Arg))
+      return false;
+  return Region.Entry->getBBArgs().size() + Region.LiveIns.size() <=
+         MaxColdRegionArguments;
+}
+
+void ColdBlockOutliner::findColdRegions(
+    SILFunction *F, llvm::SmallVectorImpl<ColdRegion> &Regions) {
+  // Find the blocks which cannot reach a return: the unreachable blocks and
+  // the blocks whose successors all cannot reach a return.
+  llvm::SmallPtrSet<SILBasicBlock *, 16> NoReturnBlocks;
+  llvm::SmallVector<SILBasicBlock *, 16> Worklist;
+  for (auto &BB : *F)
+    if (isa<UnreachableInst>(BB.getTerminator()) &&
+        NoReturnBlocks.insert(&BB).second)
+      Worklist.push_back(&BB);
+  while (!Worklist.empty()) {
+    SILBasicBlock *BB = Worklist.pop_back_val();
+    for (SILBasicBlock *Pred : BB->getPreds()) {
+      if (NoReturnBlocks.count(Pred))
+        continue;
+      bool AllSuccsNoReturn = true;
+      for (auto &Succ : Pred->getSuccessors())
+        AllSuccsNoReturn &= NoReturnBlocks.count(Succ.getBB()) != 0;
+      if (AllSuccsNoReturn) {
+        NoReturnBlocks.insert(Pred);
+        Worklist.push_back(Pred);
+      }
+    }
+  }
+
+  DominanceAnalysis *DA = PM->getAnalysis<DominanceAnalysis>();
+  DominanceInfo *DT = DA->get(F);
+  ColdBlockInfo ColdBlocks(DA);
+
+  // Look for the outermost regions; a region which is outlined is not
+  // searched for nested regions.
+  llvm::SmallVector<DomTreeNode *, 16> Nodes;
+  for (auto *Child : *DT->getRootNode())
+    Nodes.push_back(Child);
+  while (!Nodes.empty()) {
+    DomTreeNode *Node = Nodes.pop_back_val();
+    SILBasicBlock *BB = Node->getBlock();
+    SILBasicBlock *IDom = Node->getIDom()->getBlock();
+
+    bool IsEntry = (NoReturnBlocks.count(BB) && !NoReturnBlocks.count(IDom)) ||
+                   (ColdBlocks.isCold(BB) && !ColdBlocks.isCold(IDom));
+    if (IsEntry) {
+      ColdRegion Region;
+      if (collectRegion(Node, Region)) {
+        Regions.push_back(std::move(Region));
+        continue;
+      }
+    }
+    for (auto *Child : *Node)
+      Nodes.push_back(Child);
+  }
+}
+
+void ColdRegionCloner::cloneRegion(const ColdRegion &Region) {
+  SILFunction &NewF = getBuilder().getFunction();
+  SILModule &M = NewF.getModule();
+  auto Loc = RegularLocation::getAutoGeneratedLocation();
+  SILType RawPointerTy = SILType::getRawPointerType(M.getASTContext());
+
+  SILBasicBlock *EntryBB = NewF.createBasicBlock();
+  getBuilder().setInsertionPoint(EntryBB);
+  getBuilder().setCurrentDebugScope(NewF.getDebugScope());
+
+  // Addresses are passed as raw pointers: they may alias each other, which an
+  // inout parameter may not.
+  auto mapParameter = [&](SILValue V) {
+    SILType Ty = V.getType();
+    if (!Ty.isAddress()) {
+      SILValue Arg = new (M) SILArgument(EntryBB, Ty);
+      ValueMap.insert(std::make_pair(V, Arg));
+      return;
+    }
+    auto *Arg = new (M) SILArgument(EntryBB, RawPointerTy);
+    SILValue Addr = getBuilder().createPointerToAddress(Loc, Arg, Ty);
+    ValueMap.insert(std::make_pair(V, Addr));
+  };
+  for (SILArgument *Arg : Region.Entry->getBBArgs())
+    mapParameter(Arg);
+  for (SILValue V : Region.LiveIns)
+    mapParameter(V);
+
+  for (SILInstruction *I : Region.Rematerialized)
+    visit(I);
+
+  // The region's entry block becomes the entry block of the outlined
+  // function. Its successors are all in the region.
+  BBMap.insert(std::make_pair(Region.Entry, EntryBB));
+  visitSILBasicBlock(Region.Entry);
+
+  for (auto BI = BBMap.begin(), BE = BBMap.end(); BI != BE; ++BI) {
+    getBuilder().setInsertionPoint(BI->second);
+    visit(BI->first->getTerminator());
+  }
+}
+
+void ColdBlockOutliner::outlineRegion(SILFunction *F, ColdRegion &Region,
+                                      unsigned Index) {
+  SILModule &M = F->getModule();
+  ASTContext &Ctx = M.getASTContext();
+  SILType RawPointerTy = SILType::getRawPointerType(Ctx);
+
+  // Create the outlined function. It returns the result of the original
+  // function if the region contains a return, and does not return otherwise.
+  llvm::SmallVector<SILParameterInfo, 8> Params;
+  auto addParameter = [&](SILValue V) {
+    SILType Ty = V.getType().isAddress() ? RawPointerTy : V.getType();
+    Params.push_back(SILParameterInfo(Ty.getSwiftRValueType(),
+                                      ParameterConvention::Direct_Unowned));
+  };
+  for (SILArgument *Arg : Region.Entry->getBBArgs())
+    addParameter(Arg);
+  for (SILValue V : Region.LiveIns)
+    addParameter(V);
+
+  auto ExtInfo = SILFunctionType::ExtInfo()
+                     .withRepresentation(SILFunctionType::Representation::Thin)
+                     .withIsNoReturn(Region.Return == nullptr);
+  SILResultInfo Result =
+      Region.Return ? F->getLoweredFunctionType()->getResult()
+                    : SILResultInfo(TupleType::getEmpty(Ctx),
+                                    ResultConvention::Unowned);
+  auto FnTy = SILFunctionType::get(nullptr, ExtInfo,
+                                   ParameterConvention::Direct_Owned, Params,
+                                   Result, None, Ctx);
+
+  std::string Name;
+  do {
+    Name = (F->getName() + "_cold" + llvm::Twine(Index++)).str();
+  } while (M.lookUpFunction(Name));
+
+  SILFunction *NewF = SILFunction::create(
+      M, SILLinkage::Private, Name, FnTy, /*contextGenericParams*/ nullptr,
+      F->getLocation(), IsBare, IsNotTransparent, IsNotFragile, IsNotThunk,
+      SILFunction::NotRelevant, NoInline, EffectsKind::Unspecified,
+      /*InsertBefore*/ nullptr, /*DebugScope*/ nullptr, F->getDeclContext());
+  NewF->setDebugScope(new (M) SILDebugScope(F->getLocation(), *NewF));
+  NewF->setSemanticsAttr(ColdSemantics);
+
+  DEBUG(llvm::dbgs() << "  Outline cold region " << Region.Entry->getDebugID()
+                     << " of " << F->getName() << " into " << Name << "\n");
+
+  ColdRegionCloner Cloner(NewF);
+  Cloner.cloneRegion(Region);
+
+  // Replace the region by a call of the outlined function.
+  SILBasicBlock *EntryBB = Region.Entry;
+  const SILDebugScope *Scope = EntryBB->begin()->getDebugScope();
+  Optional<SILLocation> ReturnLoc;
+  if (Region.Return)
+    ReturnLoc = Region.Return->getLoc();
+
+  for (SILBasicBlock *BB : Region.Blocks)
+    clearBlockBody(BB);
+  for (SILBasicBlock *BB : Region.Blocks)
+    if (BB != EntryBB)
+      BB->eraseFromParent();
+
+  SILBuilder B(EntryBB);
+  B.setCurrentDebugScope(Scope ? Scope : F->getDebugScope());
+  auto Loc = RegularLocation::getAutoGeneratedLocation();
+  llvm::SmallVector<SILValue, 8> Args;
+  auto addArgument = [&](SILValue V) {
+    if (V.getType().isAddress())
+      V = B.createAddressToPointer(Loc, V, RawPointerTy);
+    Args.push_back(V);
+  };
+  for (SILArgument *Arg : EntryBB->getBBArgs())
+    addArgument(Arg);
+  for (SILValue V : Region.LiveIns)
+    addArgument(V);
+
+  auto *FRI = B.createFunctionRef(Loc, NewF);
+  auto *AI = B.createApply(Loc, FRI, Args, /*isNonThrowing*/ false);
+  if (ReturnLoc)
+    B.createReturn(*ReturnLoc, AI);
+  else
+    B.createUnreachable(Loc);
+
+  // The rematerialized literals may not be used anymore.
+  for (SILInstruction *I : Region.Rematerialized)
+    recursivelyDeleteTriviallyDeadInstructions(I, true);
+  ++NumRegionsOutlined;
+}
+
+void ColdBlockOutliner::run() {
+  // Outlining adds functions to the module; only visit the existing ones.
+  llvm::SmallVector<SILFunction *, 32> Functions;
+  for (auto &F : *getModule())
+    Functions.push_back(&F);
+
+  bool Changed = false;
+  for (SILFunction *F : Functions) {
+    if (F->isExternalDeclaration() || !F->shouldOptimize())
+      continue;
+    // Transparent and fragile functions are inlined into other functions,
+    // possibly in other modules, which cannot reference a private function.
+    if (F->isTransparent() || F->isFragile() || F->isThunk())
+      continue;
+    if (F->getContextGenericParams() || F->hasSemanticsString(ColdSemantics))
+      continue;
+
+    llvm::SmallVector<ColdRegion, 4> Regions;
+    findColdRegions(F, Regions);
+    unsigned Index = 0;
+    for (ColdRegion &Region : Regions)
+      outlineRegion(F, Region, Index++);
+    Changed |= !Regions.empty();
+  }
+
+  if (Changed)
+    invalidateAnalysis(SILAnalysis::InvalidationKind::Everything);
+}
+
+SILTransform *swift::createColdBlockOutliner() {
+  return new ColdBlockOutliner();
+}
@@ -41,8 +41,9 @@ protected:
 
     /// All functions which implement the method. Together with the class for
     /// which the function implements the method. In case of a witness method,
-    /// the class pointer is null.
-    SmallVector<std::pair<SILFunction *, ClassDecl *>, 8> implementingFunctions;
+    /// it's the conforming type of the witness table.
+    SmallVector<std::pair<SILFunction *, NominalTypeDecl *>, 8>
+      implementingFunctions;
 
     /// True, if the whole method is alive, e.g. because it's class is visible
     /// from outside. This implies that all implementing functions are alive.
@@ -97,12 +98,13 @@ protected:
   }
 
   /// Adds a function which implements a vtable or witness method. If it's a
-  /// vtable method, \p C is the class for which the function implements the
-  /// method. For witness methods \C is null.
-  void addImplementingFunction(MethodInfo *mi, SILFunction *F, ClassDecl *C) {
+  /// vtable method, \p N is the class for which the function implements the
+  /// method. For witness methods \p N is the conforming type.
+  void addImplementingFunction(MethodInfo *mi, SILFunction *F,
+                               NominalTypeDecl *N) {
     if (mi->isAnchor)
       ensureAlive(F);
-    mi->implementingFunctions.push_back(std::make_pair(F, C));
+    mi->implementingFunctions.push_back(std::make_pair(F, N));
   }
 
   /// Returns true if a function is marked as alive.
@@ -163,12 +165,56 @@ protected:
     for (auto &Pair : mi->implementingFunctions) {
       SILFunction *FImpl = Pair.first;
       if (!isAlive(FImpl) &&
-          canHaveSameImplementation(FD, MethodCl, Pair.second)) {
+          canHaveSameImplementation(FD, MethodCl,
+                                    cast_or_null<ClassDecl>(Pair.second))) {
         makeAlive(FImpl);
       }
     }
   }
 
+  /// Returns true if a witness_method instruction with the lookup type
+  /// \p LookupType may use the witness table of the conforming type
+  /// \p ConformingType.
+  static bool mayUseWitnessTableOf(CanType LookupType,
+                                   NominalTypeDecl *ConformingType) {
+    // Archetypes and existentials can be bound to any conforming type.
+    if (LookupType->hasArchetype())
+      return true;
+    NominalTypeDecl *LookupDecl = LookupType.getAnyNominal();
+    if (!LookupDecl || isa<ProtocolDecl>(LookupDecl) || !ConformingType)
+      return true;
+
+    if (LookupDecl == ConformingType)
+      return true;
+
+    // A class inherits the conformances of its superclasses.
+    auto *LookupCl = dyn_cast<ClassDecl>(LookupDecl);
+    auto *ConformingCl = dyn_cast<ClassDecl>(ConformingType);
+    return LookupCl && ConformingCl && isDerivedOrEqual(LookupCl, ConformingCl);
+  }
+
+  /// Marks the witnesses of a protocol requirement as alive which may be
+  /// called by a witness_method instruction for \p LookupType.
+  void ensureAliveWitnesses(MethodInfo *mi, CanType LookupType) {
+    for (auto &Pair : mi->implementingFunctions) {
+      SILFunction *FImpl = Pair.first;
+      if (!isAlive(FImpl) && mayUseWitnessTableOf(LookupType, Pair.second))
+        makeAlive(FImpl);
+    }
+  }
+
+  /// Returns the class of the operand of a class_method instruction, or null
+  /// if it is not known. For class methods with a metatype operand it's the
+  /// instance type of the metatype.
+  static ClassDecl *getMethodClass(MethodInst *MI) {
+    if (MI->getNumOperands() != 1)
+      return nullptr;
+    CanType OpTy = MI->getOperand(0)->getType(0).getSwiftRValueType();
+    if (auto MetaTy = dyn_cast<AnyMetatypeType>(OpTy))
+      OpTy = MetaTy.getInstanceType();
+    return OpTy.getClassOrBoundGenericClass();
+  }
+
   /// Gets the base implementation of a method.
   /// We always use the most overridden function to describe a method.
   AbstractFunctionDecl *getBase(AbstractFunctionDecl *FD) {
@@ -186,10 +232,11 @@ protected:
           auto *funcDecl = getBase(
               cast<AbstractFunctionDecl>(MI->getMember().getDecl()));
           MethodInfo *mi = getMethodInfo(funcDecl);
-          ClassDecl *MethodCl = nullptr;
-          if (MI->getNumOperands() == 1)
-            MethodCl = MI->getOperand(0)->getType(0).getClassOrBoundGenericClass();
-          ensureAlive(mi, dyn_cast<FuncDecl>(funcDecl), MethodCl);
+          if (auto *WMI = dyn_cast<WitnessMethodInst>(MI)) {
+            ensureAliveWitnesses(mi, WMI->getLookupType());
+            continue;
+          }
+          ensureAlive(mi, dyn_cast<FuncDecl>(funcDecl), getMethodClass(MI));
         } else if (auto *FRI = dyn_cast<FunctionRefInst>(&I)) {
           ensureAlive(FRI->getReferencedFunction());
         }
@@ -335,7 +382,8 @@ class DeadFunctionElimination : FunctionLivenessComputation {
           continue;
 
         MethodInfo *mi = getMethodInfo(fd);
-        addImplementingFunction(mi, F, nullptr);
+        addImplementingFunction(mi, F,
+                                WT.getConformance()->getType()->getAnyNominal());
         if (tableIsAlive || !F->isDefinition())
           ensureAlive(mi, nullptr, nullptr);
       }
@@ -0,0 +1,346 @@
+//===--- FunctionMerging.cpp - Merge identical functions ------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Finds functions with the same lowered type and structurally identical bodies
+// and keeps only one of the bodies. The other functions become thunks which
+// call the remaining function, and all function_refs to them are redirected.
+// Functions which are not referenced anymore are then removed by dead function
+// elimination. Thunks remain for functions which are visible from outside or
+// referenced by vtables and witness tables.
+//
+// Two bodies are identical if, after mapping blocks and values, all
+// instructions have the same kind, types, operands and state. Debug value
+// instructions are ignored.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "sil-function-merging"
+#include "swift/SILPasses/Passes.h"
+#include "swift/SILPasses/Transforms.h"
+#include "swift/SIL/SILArgument.h"
+#include "swift/SIL/SILBuilder.h"
+#include "swift/SIL/SILFunction.h"
+#include "swift/SIL/SILModule.h"
+#include "swift/SIL/SILUndef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+using namespace swift;
+
+STATISTIC(NumFunctionsMerged, "Number of functions merged");
+
+/// Returns true if \p F may be merged with another function.
+static bool isMergeCandidate(SILFunction &F) {
+  if (F.isExternalDeclaration() || isAvailableExternally(F.getLinkage()))
+    return false;
+
+  // The optimizer recognizes these functions by name or attribute.
+  if (F.isTransparent() || F.hasDefinedSemantics() || F.isGlobalInit())
+    return false;
+
+  // Generic functions would need forwarding substitutions in the thunk.
+  if (F.getContextGenericParams())
+    return false;
+
+  switch (F.getRepresentation()) {
+  case SILFunctionTypeRepresentation::Thin:
+  case SILFunctionTypeRepresentation::Method:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Returns true if \p I is ignored when comparing function bodies.
+static bool isIgnoredInst(const SILInstruction &I) {
+  return isa<DebugValueInst>(I) || isa<DebugValueAddrInst>(I);
+}
+
+/// Computes a hash of the function's type and the shape of its body, which is
+/// the same for identical functions.
+static size_t hashFunction(SILFunction &F) {
+  llvm::hash_code Hash = llvm::hash_value(
+      F.getLoweredFunctionType().getPointer());
+  for (auto &BB : F) {
+    Hash = llvm::hash_combine(Hash, BB.getNumBBArg());
+    for (auto &I : BB) {
+      if (isIgnoredInst(I))
+        continue;
+      Hash = llvm::hash_combine(Hash, unsigned(I.getKind()),
+                                I.getNumOperands());
+      if (I.getNumTypes() > 0)
+        Hash = llvm::hash_combine(Hash, I.getType(0).getOpaqueValue());
+    }
+  }
+  return Hash;
+}
+
+namespace {
+
+/// Compares the bodies of two functions.
+class FunctionComparator {
+  SILFunction *LHS;
+  SILFunction *RHS;
+  llvm::DenseMap<SILBasicBlock *, SILBasicBlock *> BlockMap;
+  llvm::DenseMap<ValueBase *, ValueBase *> ValueMap;
+
+public:
+  FunctionComparator(SILFunction *L, SILFunction *R) : LHS(L), RHS(R) {}
+
+  bool isIdentical() {
+    if (LHS->getLoweredFunctionType() != RHS->getLoweredFunctionType() ||
+        LHS->isFragile() != RHS->isFragile() ||
+        LHS->getInlineStrategy() != RHS->getInlineStrategy() ||
+        LHS->getEffectsKind() != RHS->getEffectsKind() ||
+        LHS->size() != RHS->size())
+      return false;
+
+    // Map the blocks in layout order.
+    for (auto LI = LHS->begin(), RI = RHS->begin(), E = LHS->end(); LI != E;
+         ++LI, ++RI) {
+      if (LI->getNumBBArg() != RI->getNumBBArg())
+        return false;
+      BlockMap[&*LI] = &*RI;
+      for (unsigned i = 0, e = LI->getNumBBArg(); i != e; ++i) {
+        if (LI->getBBArg(i)->getType() != RI->getBBArg(i)->getType())
+          return false;
+        ValueMap[LI->getBBArg(i)] = RI->getBBArg(i);
+      }
+    }
+
+    for (auto &LBB : *LHS)
+      if (!isIdenticalBlock(&LBB, BlockMap[&LBB]))
+        return false;
+    return true;
+  }
+
+private:
+  bool isIdenticalValue(SILValue L, SILValue R) {
+    if (L.getResultNumber() != R.getResultNumber())
+      return false;
+    // Values which are not defined in the function, like undef.
+    if (L.getDef() == R.getDef())
+      return isa<SILUndef>(L.getDef());
+    return ValueMap.lookup(L.getDef()) == R.getDef();
+  }
+
+  bool isIdenticalOperands(SILInstruction *L, SILInstruction *R) {
+    if (L->getNumOperands() != R->getNumOperands())
+      return false;
+    for (unsigned i = 0, e = L->getNumOperands(); i != e; ++i)
+      if (!isIdenticalValue(L->getOperand(i), R->getOperand(i)))
+        return false;
+    return true;
+  }
+
+  bool isIdenticalInst(SILInstruction *L, SILInstruction *R) {
+    if (L->getKind() != R->getKind())
+      return false;
+
+    // The identity comparer checks the operands of these instructions by
+    // pointer, which only works within one function.
+    if (isa<StoreInst>(L))
+      return isIdenticalOperands(L, R);
+    if (auto *LCM = dyn_cast<ClassMethodInst>(L)) {
+      auto *RCM = cast<ClassMethodInst>(R);
+      return LCM->getMember() == RCM->getMember() &&
+             LCM->isVolatile() == RCM->isVolatile() &&
+             LCM->getType() == RCM->getType() && isIdenticalOperands(L, R);
+    }
+
+    if (auto *LT = dyn_cast<TermInst>(L))
+      return isIdenticalTerminator(LT, cast<TermInst>(R));
+
+    return L->isIdenticalTo(R, [&](SILValue LOp, SILValue ROp) -> bool {
+      return isIdenticalValue(LOp, ROp);
+    });
+  }
+
+  bool isIdenticalTerminator(TermInst *L, TermInst *R) {
+    switch (L->getKind()) {
+    case ValueKind::BranchInst:
+    case ValueKind::ReturnInst:
+    case ValueKind::ThrowInst:
+    case ValueKind::UnreachableInst:
+      break;
+    case ValueKind::CondBranchInst:
+      if (cast<CondBranchInst>(L)->getTrueArgs().size() !=
+          cast<CondBranchInst>(R)->getTrueArgs().size())
+        return false;
+      break;
+    default:
+      return false;
+    }
+    if (!isIdenticalOperands(L, R))
+      return false;
+
+    auto LSuccs = L->getSuccessors();
+    auto RSuccs = R->getSuccessors();
+    if (LSuccs.size() != RSuccs.size())
+      return false;
+    for (unsigned i = 0, e = LSuccs.size(); i != e; ++i)
+      if (BlockMap.lookup(LSuccs[i].getBB()) != RSuccs[i].getBB())
+        return false;
+    return true;
+  }
+
+  bool isIdenticalBlock(SILBasicBlock *L, SILBasicBlock *R) {
+    auto LI = L->begin(), LE = L->end();
+    auto RI = R->begin(), RE = R->end();
+    while (true) {
+      while (LI != LE && isIgnoredInst(*LI))
+        ++LI;
+      while (RI != RE && isIgnoredInst(*RI))
+        ++RI;
+      if (LI == LE || RI == RE)
+        return LI == LE && RI == RE;
+
+      if (!isIdenticalInst(&*LI, &*RI))
+        return false;
+      ValueMap[&*LI] = &*RI;
+      ++LI;
+      ++RI;
+    }
+  }
+};
+
+class FunctionMerging : public SILModuleTransform {
+
+  /// Replaces the body of \p F by a call to \p Target, which has the same
+  /// type.
+  void createThunk(SILFunction *F, SILFunction *Target) {
+    SmallVector<SILType, 8> ArgTypes;
+    for (auto *Arg : F->begin()->getBBArgs())
+      ArgTypes.push_back(Arg->getType());
+
+    F->dropAllReferences();
+    F->getBlocks().clear();
+
+    SILBasicBlock *Entry = F->createBasicBlock();
+    SmallVector<SILValue, 8> Args;
+    for (SILType Ty : ArgTypes)
+      Args.push_back(Entry->createBBArg(Ty));
+
+    SILLocation Loc = F->hasLocation()
+                          ? F->getLocation()
+                          : RegularLocation::getAutoGeneratedLocation();
+    SILBuilder Builder(Entry);
+    Builder.setCurrentDebugScope(F->getDebugScope());
+    auto *FRI = Builder.createFunctionRef(Loc, Target);
+
+    SILType LoweredType = Target->getLoweredType();
+    SILType ResultType = LoweredType.getFunctionInterfaceResultType();
+    auto FunctionTy = LoweredType.castTo<SILFunctionType>();
+    SILValue ReturnValue;
+    if (FunctionTy->hasErrorResult()) {
+      SILBasicBlock *NormalBlock = F->createBasicBlock();
+      ReturnValue = NormalBlock->createBBArg(ResultType);
+      SILBasicBlock *ErrorBlock = F->createBasicBlock();
+      SILType ErrorType = SILType::getPrimitiveObjectType(
+          FunctionTy->getErrorResult().getType());
+      auto *ErrorArg = ErrorBlock->createBBArg(ErrorType);
+      Builder.createTryApply(Loc, FRI, LoweredType, ArrayRef<Substitution>(),
+                             Args, NormalBlock, ErrorBlock);
+      Builder.setInsertionPoint(ErrorBlock);
+      Builder.createThrow(Loc, ErrorArg);
+      Builder.setInsertionPoint(NormalBlock);
+    } else {
+      ReturnValue = Builder.createApply(Loc, FRI, LoweredType, ResultType,
+                                        ArrayRef<Substitution>(), Args, false);
+    }
+
+    if (FunctionTy->isNoReturn())
+      Builder.createUnreachable(Loc);
+    else
+      Builder.createReturn(Loc, ReturnValue);
+
+    F->setThunk(IsThunk);
+  }
+
+  /// Redirects all function_refs to merged functions.
+  void replaceReferences(
+      const llvm::DenseMap<SILFunction *, SILFunction *> &Replacements) {
+    for (auto &F : *getModule()) {
+      bool Changed = false;
+      for (auto &BB : F) {
+        for (auto II = BB.begin(), IE = BB.end(); II != IE;) {
+          auto *FRI = dyn_cast<FunctionRefInst>(&*II);
+          ++II;
+          if (!FRI)
+            continue;
+          SILFunction *Target =
+              Replacements.lookup(FRI->getReferencedFunction());
+          if (!Target)
+            continue;
+          SILBuilderWithScope Builder(FRI);
+          auto *NewFRI = Builder.createFunctionRef(FRI->getLoc(), Target);
+          FRI->replaceAllUsesWith(NewFRI);
+          FRI->eraseFromParent();
+          Changed = true;
+        }
+      }
+      if (Changed)
+        invalidateAnalysis(&F,
+                           SILAnalysis::InvalidationKind::CallsAndInstructions);
+    }
+  }
+
+  void run() override {
+    // Group the candidates by hash, in module order.
+    llvm::MapVector<size_t, SmallVector<SILFunction *, 2>> Buckets;
+    for (auto &F : *getModule())
+      if (isMergeCandidate(F))
+        Buckets[hashFunction(F)].push_back(&F);
+
+    // Find the duplicates of the first function in each bucket. A bucket may
+    // contain several sets of identical functions in case of hash collisions.
+    llvm::DenseMap<SILFunction *, SILFunction *> Replacements;
+    for (auto &Bucket : Buckets) {
+      auto &Functions = Bucket.second;
+      while (Functions.size() > 1) {
+        SILFunction *Canonical = Functions.front();
+        SmallVector<SILFunction *, 2> Remaining;
+        for (auto *F : make_range(Functions.begin() + 1, Functions.end())) {
+          if (FunctionComparator(Canonical, F).isIdentical()) {
+            DEBUG(llvm::dbgs() << "  merging " << F->getName() << " into "
+                               << Canonical->getName() << "\n");
+            Replacements[F] = Canonical;
+          } else {
+            Remaining.push_back(F);
+          }
+        }
+        Functions = std::move(Remaining);
+      }
+    }
+    if (Replacements.empty())
+      return;
+
+    for (auto &Pair : Replacements) {
+      createThunk(Pair.first, Pair.second);
+      invalidateAnalysis(Pair.first,
+                         SILAnalysis::InvalidationKind::FunctionBody);
+      ++NumFunctionsMerged;
+    }
+    replaceReferences(Replacements);
+  }
+
+  StringRef getName() override { return "Function Merging"; }
+};
+
+} // end anonymous namespace
+
+SILTransform *swift::createFunctionMerging() {
+  return new FunctionMerging();
+}
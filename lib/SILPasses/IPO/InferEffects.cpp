@@ -0,0 +1,99 @@
+//===---------- InferEffects.cpp - Infer @effects from side effects -------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Sets the effects kind of function definitions which are proven to be
+// readnone or readonly by the side-effect analysis. IRGen maps these effects
+// to LLVM function attributes, so that LLVM can optimize calls to such
+// functions, e.g. hoist them out of loops or eliminate redundant calls.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "infer-effects"
+#include "swift/SILPasses/Passes.h"
+#include "swift/SILAnalysis/SideEffectAnalysis.h"
+#include "swift/SILPasses/Transforms.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+
+using namespace swift;
+
+STATISTIC(NumReadNone, "Number of functions inferred to be readnone");
+STATISTIC(NumReadOnly, "Number of functions inferred to be readonly");
+
+namespace {
+
+using FunctionEffects = SideEffectAnalysis::FunctionEffects;
+using Effects = SideEffectAnalysis::Effects;
+
+/// Returns true if \p E only contains memory reads.
+static bool hasOnlyReads(const Effects &E) {
+  return !E.mayWrite() && !E.mayRetain() && !E.mayRelease();
+}
+
+/// Computes the effects kind which can be set for a function with the side
+/// effects \p FE. Retains and releases are not allowed, because they write
+/// to the reference count and a release may call an arbitrary deinit.
+static EffectsKind getInferredEffectsKind(const FunctionEffects &FE) {
+  if (FE.mayAllocObjects() || FE.mayTrap() || FE.mayReadRC())
+    return EffectsKind::Unspecified;
+
+  bool Reads = false;
+  auto &Global = FE.getGlobalEffects();
+  if (!hasOnlyReads(Global))
+    return EffectsKind::Unspecified;
+  Reads |= Global.mayRead();
+
+  for (auto &ParamEffects : FE.getParameterEffects()) {
+    if (!hasOnlyReads(ParamEffects))
+      return EffectsKind::Unspecified;
+    Reads |= ParamEffects.mayRead();
+  }
+  return Reads ? EffectsKind::ReadOnly : EffectsKind::ReadNone;
+}
+
+class InferEffects : public SILModuleTransform {
+
+  void run() override {
+    DEBUG(llvm::dbgs() << "** InferEffects **\n");
+
+    auto *SEA = PM->getAnalysis<SideEffectAnalysis>();
+    SEA->recompute();
+
+    for (auto &F : *getModule()) {
+      // Don't override explicit @effects attributes.
+      if (!F.isDefinition() || F.getEffectsKind() != EffectsKind::Unspecified)
+        continue;
+
+      EffectsKind Kind = getInferredEffectsKind(SEA->getEffects(&F));
+      if (Kind == EffectsKind::Unspecified)
+        continue;
+
+      DEBUG(llvm::dbgs() << "  inferred "
+                         << (Kind == EffectsKind::ReadNone ? "readnone"
+                                                           : "readonly")
+                         << " for " << F.getName() << '\n');
+      if (Kind == EffectsKind::ReadNone)
+        ++NumReadNone;
+      else
+        ++NumReadOnly;
+      F.setEffectsKind(Kind);
+    }
+  }
+
+  StringRef getName() override { return "Infer Effects"; }
+};
+
+} // end anonymous namespace
+
+SILTransform *swift::createInferEffects() {
+  return new InferEffects();
+}
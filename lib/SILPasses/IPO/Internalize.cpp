@@ -0,0 +1,100 @@
+//===--- Internalize.cpp - Hide the public symbols of an executable -------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// In a whole-module compilation of an executable, no other image references
+// the public functions, globals and witness tables of the module. Giving
+// them hidden linkage keeps them out of the dynamic symbol table, lets calls
+// to them bind directly instead of through the PLT, and lets dead function
+// elimination remove the ones which are not used.
+//
+// Symbols whose names are not Swift-mangled, like main and functions with an
+// explicit @_silgen_name, may be referenced by name from C code or from the
+// runtime and keep their linkage. The runtime finds type metadata and
+// conformances through the image's metadata sections, not by name, so
+// reflection is not affected.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "internalize"
+#include "swift/SILPasses/Passes.h"
+#include "swift/SIL/SILModule.h"
+#include "swift/SILPasses/Transforms.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+
+using namespace swift;
+
+STATISTIC(NumFunctionsInternalized, "Number of functions internalized");
+STATISTIC(NumGlobalsInternalized, "Number of globals internalized");
+STATISTIC(NumWitnessTablesInternalized,
+          "Number of witness tables internalized");
+
+/// Returns true if a public definition can be hidden.
+static bool canInternalize(SILLinkage Linkage, bool IsFragile) {
+  // Fragile definitions may be referenced by code inlined into other modules.
+  return Linkage == SILLinkage::Public && !IsFragile;
+}
+
+/// Returns true if \p Name may only be referenced by Swift code.
+static bool isSwiftMangledName(StringRef Name) {
+  return Name.startswith("_T");
+}
+
+namespace {
+class Internalize : public SILModuleTransform {
+  void run() override {
+    SILModule *M = getModule();
+    bool Changed = false;
+
+    for (SILFunction &F : *M) {
+      if (F.isExternalDeclaration() || F.isKeepAsPublic() ||
+          !canInternalize(F.getLinkage(), F.isFragile()) ||
+          !isSwiftMangledName(F.getName()))
+        continue;
+      DEBUG(llvm::dbgs() << "  internalize function " << F.getName() << "\n");
+      F.setLinkage(SILLinkage::Hidden);
+      ++NumFunctionsInternalized;
+      Changed = true;
+    }
+
+    for (SILGlobalVariable &G : M->getSILGlobalList()) {
+      if (!G.isDefinition() ||
+          !canInternalize(G.getLinkage(), G.isFragile()) ||
+          !isSwiftMangledName(G.getName()))
+        continue;
+      DEBUG(llvm::dbgs() << "  internalize global " << G.getName() << "\n");
+      G.setLinkage(SILLinkage::Hidden);
+      ++NumGlobalsInternalized;
+      Changed = true;
+    }
+
+    // Witness tables are only referenced by their mangled names.
+    for (SILWitnessTable &WT : M->getWitnessTableList()) {
+      if (WT.isDeclaration() ||
+          !canInternalize(WT.getLinkage(), WT.isFragile()))
+        continue;
+      WT.setLinkage(SILLinkage::Hidden);
+      ++NumWitnessTablesInternalized;
+      Changed = true;
+    }
+
+    if (Changed)
+      invalidateAnalysis(SILAnalysis::InvalidationKind::Everything);
+  }
+
+  StringRef getName() override { return "Internalize"; }
+};
+} // end anonymous namespace
+
+SILTransform *swift::createInternalize() {
+  return new Internalize();
+}
@@ -63,6 +63,7 @@ protected:
                                  SmallVectorImpl<SILInstruction *> &Init);
   bool getInitializer(NominalTypeDecl *NTD, VarDecl *Property,
                       SmallVectorImpl<SILInstruction *> &Init);
+  bool isInitializerInModule(ConstructorDecl *Ctor);
 };
 
 /// Helper class to copy only a set of SIL instructions providing in the
@@ -307,26 +308,47 @@ LetPropertiesOpt::getInitializer(NominalTypeDecl *NTD, VarDecl *Property,
                                        SILDeclRef::Kind::Allocator:
                                        SILDeclRef::Kind::Initializer;
 
-  for (auto *Member: NTD->getMembers()) {
-    if (auto *FD = dyn_cast<ConstructorDecl>(Member)) {
-        // Find the SIL body of this initializer.
-        auto SDR = SILDeclRef(FD, InitializerKind);
-        Init = Module->lookUpFunction(SDR);
-        if (!Init)
-          continue;
-        // Analyze the body of the constructor.
-        SmallVector<SILInstruction *, 8> Insns;
-        if (!findStoredValue(Init, Property, Insns))
-          return false;
-        // Remember the set of instructions initializing
-        // this Property inside this constructor.
-        DEBUG(llvm::dbgs() << "Found initializer insns: \n";
-              for (auto I: Insns) {
-                I->dump();
-              });
-        ConstrPropertyInit.push_back(Insns);
+  auto analyzeMembers = [&](DeclRange Members) -> bool {
+    for (auto *Member: Members) {
+      auto *FD = dyn_cast<ConstructorDecl>(Member);
+      if (!FD)
+        continue;
+      // An initializer which is compiled elsewhere may initialize the
+      // property with anything.
+      if (!isInitializerInModule(FD)) {
+        DEBUG(llvm::dbgs() << "Initializer of " << NTD->getName()
+                           << " is not in this module\n");
+        return false;
+      }
+      // Find the SIL body of this initializer.
+      auto SDR = SILDeclRef(FD, InitializerKind);
+      Init = Module->lookUpFunction(SDR);
+      if (!Init)
+        continue;
+      // Analyze the body of the constructor.
+      SmallVector<SILInstruction *, 8> Insns;
+      if (!findStoredValue(Init, Property, Insns))
+        return false;
+      // Remember the set of instructions initializing
+      // this Property inside this constructor.
+      DEBUG(llvm::dbgs() << "Found initializer insns: \n";
+            for (auto I: Insns) {
+              I->dump();
+            });
+      ConstrPropertyInit.push_back(Insns);
     }
-  }
+    return true;
+  };
+
+  if (!analyzeMembers(NTD->getMembers()))
+    return false;
+
+  // Initializers of structs may also be declared in extensions. Initializers
+  // in extensions of classes are convenience initializers, which delegate to
+  // the initializers of the class and have no initializing entry point.
+  for (ExtensionDecl *Ext : NTD->getExtensions())
+    if (!analyzeMembers(Ext->getMembers()))
+      return false;
 
   // Check that all collected instruction sequences are equivalent.
   for(int i = 1, e = ConstrPropertyInit.size(); i < e; i++) {
@@ -347,6 +369,20 @@ LetPropertiesOpt::getInitializer(NominalTypeDecl *NTD, VarDecl *Property,
   return true;
 }
 
+/// Returns true if the body of \p Ctor, if it is emitted at all, is part of
+/// this module. Without whole-module optimization, only the initializers of
+/// the file which is compiled are.
+bool LetPropertiesOpt::isInitializerInModule(ConstructorDecl *Ctor) {
+  if (Module->isWholeModule())
+    return true;
+  const DeclContext *AssocDC = Module->getAssociatedContext();
+  if (!AssocDC)
+    return false;
+  if (AssocDC->isModuleContext())
+    return true;
+  return Ctor->getDeclContext()->getParentSourceFile() == AssocDC;
+}
+
 /// Check if a given property is a non-static let property
 /// with known constant value.
 bool LetPropertiesOpt::isConstantLetProperty(VarDecl *Property) {
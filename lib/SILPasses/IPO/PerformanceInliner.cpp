@@ -52,6 +52,14 @@ namespace {
 
   llvm::cl::opt<int> TestOpt("sil-inline-test",
                                    llvm::cl::init(0), llvm::cl::Hidden);
+
+  // The number of instructions which new generic specializations may add to
+  // the module in one run of the inliner. A negative value means no limit.
+  llvm::cl::opt<int> SpecializationBudget(
+      "sil-generic-specialization-budget", llvm::cl::init(-1),
+      llvm::cl::Hidden,
+      llvm::cl::desc("Limit the size of new generic specializations created "
+                     "by the performance inliner"));
   
   // The following constants define the cost model for inlining.
   
@@ -230,6 +238,20 @@ namespace {
     /// B into A.
     llvm::DenseSet<std::pair<StringRef, StringRef>> InlinedFunctions;
 
+    /// The remaining size budget for new generic specializations, if it is
+    /// limited by -sil-generic-specialization-budget.
+    unsigned RemainingSpecializationBudget = 0;
+    bool HasSpecializationBudget = false;
+
+    /// The inline cost of all instructions of a callee, without taking any
+    /// call site into account. It is computed on demand and an entry is
+    /// dropped whenever the inliner changes the body of its function.
+    llvm::DenseMap<SILFunction *, unsigned> FullCalleeCosts;
+
+    unsigned getFullCalleeCost(SILFunction *Callee);
+
+    void invalidateCalleeCost(SILFunction *F) { FullCalleeCosts.erase(F); }
+
     SILFunction *getEligibleFunction(FullApplySite AI);
 
     bool isProfitableToInline(FullApplySite AI, unsigned loopDepthOfAI,
@@ -237,6 +259,8 @@ namespace {
                               SILLoopAnalysis *LA,
                               ConstantTracker &constTracker);
 
+    bool isProfitableInColdBlock(SILFunction *Callee);
+
     void visitColdBlocks(SmallVectorImpl<FullApplySite> &AppliesToInline,
                          SILBasicBlock *root, DominanceInfo *DT);
 
@@ -271,7 +295,12 @@ namespace {
     SILPerformanceInliner(int threshold,
                           InlineSelection WhatToInline)
       : InlineCostThreshold(threshold),
-    WhatToInline(WhatToInline) {}
+    WhatToInline(WhatToInline) {
+      if (SpecializationBudget >= 0) {
+        RemainingSpecializationBudget = SpecializationBudget;
+        HasSpecializationBudget = true;
+      }
+    }
 
     void inlineDevirtualizeAndSpecialize(SILFunction *WorkItem,
                                          SILModuleTransform *MT,
@@ -709,7 +738,25 @@ bool SILPerformanceInliner::isProfitableToInline(FullApplySite AI,
   
   if (Callee->getInlineStrategy() == AlwaysInline)
     return true;
-  
+
+  // The cost of the whole callee is an upper bound of the cost computed
+  // below, which skips dead blocks, and the threshold only grows from the
+  // base benefit. If the whole callee fits already, don't walk it again.
+  if (TestThreshold < 0) {
+    unsigned BaseThreshold = TrivialFunctionThreshold;
+    if (!AI.getFunction()->isThunk()) {
+      BaseThreshold = InlineCostThreshold > 0 ? InlineCostThreshold :
+                                                RemovedCallBenefit;
+      BaseThreshold += loopDepthOfAI * LoopBenefitFactor;
+    }
+    unsigned FullCost = getFullCalleeCost(Callee);
+    if (FullCost <= BaseThreshold) {
+      DEBUG(llvm::dbgs() << "        YES: ready to inline, full cost: "
+            << FullCost << ", threshold: " << BaseThreshold << "\n");
+      return true;
+    }
+  }
+
   ConstantTracker constTracker(Callee, &callerTracker, AI);
   
   DominanceInfo *DT = DA->get(Callee);
@@ -788,26 +835,33 @@ bool SILPerformanceInliner::isProfitableToInline(FullApplySite AI,
   return true;
 }
 
+/// Return the inline cost of all instructions of \p Callee.
+unsigned SILPerformanceInliner::getFullCalleeCost(SILFunction *Callee) {
+  auto Found = FullCalleeCosts.find(Callee);
+  if (Found != FullCalleeCosts.end())
+    return Found->second;
+
+  unsigned CalleeCost = 0;
+  for (SILBasicBlock &Block : *Callee)
+    for (SILInstruction &I : Block)
+      CalleeCost += unsigned(instructionInlineCost(I));
+
+  FullCalleeCosts[Callee] = CalleeCost;
+  return CalleeCost;
+}
+
 /// Return true if inlining this call site into a cold block is profitable.
-static bool isProfitableInColdBlock(SILFunction *Callee) {
+bool SILPerformanceInliner::isProfitableInColdBlock(SILFunction *Callee) {
   if (Callee->getInlineStrategy() == AlwaysInline)
     return true;
 
   // Testing with the TestThreshold disables inlining into cold blocks.
   if (TestThreshold >= 0)
     return false;
-  
-  unsigned CalleeCost = 0;
-  
-  for (SILBasicBlock &Block : *Callee) {
-    for (SILInstruction &I : Block) {
-      auto ICost = instructionInlineCost(I);
-      CalleeCost += (unsigned)ICost;
 
-      if (CalleeCost > TrivialFunctionThreshold)
-        return false;
-    }
-  }
+  unsigned CalleeCost = getFullCalleeCost(Callee);
+  if (CalleeCost > TrivialFunctionThreshold)
+    return false;
 
   DEBUG(llvm::dbgs() << "        YES: ready to inline into cold block, cost:"
         << CalleeCost << "\n");
@@ -855,9 +909,9 @@ ApplySite SILPerformanceInliner::specializeGenericUpdatingCallGraph(
   CloneCollector Collector(Filter);
 
   SILFunction *SpecializedFunction;
-  auto Specialized = trySpecializeApplyOfGeneric(Apply,
-                                                 SpecializedFunction,
-                                                 Collector);
+  auto Specialized = trySpecializeApplyOfGeneric(
+      Apply, SpecializedFunction, Collector,
+      HasSpecializationBudget ? &RemainingSpecializationBudget : nullptr);
 
   if (!Specialized)
     return ApplySite();
@@ -969,6 +1023,7 @@ bool SILPerformanceInliner::devirtualizeAndSpecializeApplies(
       MT->invalidateAnalysis(Apply.getFunction(),
                              SILAnalysis::InvalidationKind::Everything);
       CGA->unlockInvalidation();
+      invalidateCalleeCost(Apply.getFunction());
     }
   }
 
@@ -1128,6 +1183,7 @@ bool SILPerformanceInliner::inlineCallsIntoFunction(SILFunction *Caller,
     NewApplies.insert(NewApplies.end(), AppliesFromInlinee.begin(),
                       AppliesFromInlinee.end());
     DA->invalidate(Caller, SILAnalysis::InvalidationKind::Everything);
+    invalidateCalleeCost(Caller);
     NumFunctionsInlined++;
   }
 
@@ -707,6 +707,72 @@ static SILValue getSub(SILLocation Loc, SILValue Val, unsigned SubVal,
   return B.createTupleExtract(Loc, AI, 0);
 }
 
+/// Apply an overflow checked binary operation to two builtin integer values.
+/// A cond_fail on the overflow bit is inserted.
+static SILValue getCheckedBinaryOp(SILLocation Loc, StringRef Name,
+                                   SILValue LHS, SILValue RHS, SILBuilder &B) {
+  SmallVector<SILValue, 4> Args;
+  Args.push_back(LHS);
+  Args.push_back(RHS);
+  Args.push_back(B.createIntegerLiteral(
+      Loc, SILType::getBuiltinIntegerType(1, B.getASTContext()), -1));
+
+  auto *AI = B.createBuiltinBinaryFunctionWithOverflow(Loc, Name, Args);
+  B.createCondFail(Loc, B.createTupleExtract(Loc, AI, 1));
+  return B.createTupleExtract(Loc, AI, 0);
+}
+
+/// Returns true if \p V is available in the preheader or can be recomputed
+/// there, because it only depends on integer literals and values which are
+/// available in the preheader.
+static bool isHoistableInvariant(SILValue V, SILBasicBlock *Preheader,
+                                 DominanceInfo *DT, unsigned Depth = 0) {
+  if (dominates(DT, V, Preheader))
+    return true;
+  if (Depth > 4)
+    return false;
+
+  auto *I = dyn_cast<SILInstruction>(V.getDef());
+  if (!I)
+    return false;
+  if (isa<IntegerLiteralInst>(I))
+    return true;
+  if (auto *TEI = dyn_cast<TupleExtractInst>(I))
+    return isHoistableInvariant(TEI->getOperand(), Preheader, DT, Depth + 1);
+  if (auto *BI = dyn_cast<BuiltinInst>(I)) {
+    switch (BI->getBuiltinInfo().ID) {
+    case BuiltinValueKind::SAddOver:
+    case BuiltinValueKind::SSubOver:
+    case BuiltinValueKind::SMulOver:
+      for (auto &Op : BI->getAllOperands())
+        if (!isHoistableInvariant(Op.get(), Preheader, DT, Depth + 1))
+          return false;
+      return true;
+    default:
+      return false;
+    }
+  }
+  return false;
+}
+
+/// Makes the value \p V available in the preheader. Instructions which do not
+/// dominate the preheader are cloned to its end.
+/// The value must satisfy isHoistableInvariant. The overflow bits of cloned
+/// arithmetic are not checked again: the value is the same as in the loop, so
+/// it is checked exactly as often as the original.
+static SILValue getInvariantInPreheader(SILValue V, SILBasicBlock *Preheader,
+                                        DominanceInfo *DT) {
+  if (dominates(DT, V, Preheader))
+    return V;
+
+  auto *I = cast<SILInstruction>(V.getDef());
+  auto *Clone = I->clone(Preheader->getTerminator());
+  for (unsigned i = 0, e = Clone->getNumOperands(); i != e; ++i)
+    Clone->setOperand(
+        i, getInvariantInPreheader(Clone->getOperand(i), Preheader, DT));
+  return SILValue(Clone, V.getResultNumber());
+}
+
 /// A cannonical induction variable incremented by one from Start to End-1.
 struct InductionInfo {
   SILArgument *HeaderVal;
@@ -884,17 +950,68 @@ static bool isGuaranteedToBeExecuted(DominanceInfo *DT, SILBasicBlock *Block,
 }
 
 /// Describes the access function "a[f(i)]" that is based on a cannonical
-/// induction variable.
+/// induction variable. The function is affine: f(i) = i * Scale + Offset,
+/// where Scale and Offset are loop invariant and may be missing.
+///
+/// All arithmetic in the access function must be overflow checked, so f is
+/// monotonic. Checking the first and the last index therefore covers all
+/// indices accessed in the loop. This also handles the "i * width + j" index of
+/// a flattened two dimensional array in the loop over j: "i * width" is
+/// invariant in the inner loop. After the checks are hoisted to the inner
+/// preheader, the check on the outer loop's induction variable "i" can be
+/// hoisted again to the outer preheader.
 class AccessFunction {
   InductionInfo *Ind;
+  SILValue Scale;
+  SILValue Offset;
+
+  AccessFunction(InductionInfo *I, SILValue Scale = SILValue(),
+                 SILValue Offset = SILValue())
+      : Ind(I), Scale(Scale), Offset(Offset) {}
+
+  /// Matches an overflow checked builtin binary operation "Op" with the result
+  /// \p V. On success the operands are returned in \p LHS and \p RHS.
+  static bool matchCheckedOp(SILValue V, BuiltinValueKind Op, SILValue &LHS,
+                             SILValue &RHS) {
+    BuiltinInst *AI;
+    if (!match(V, m_TupleExtractInst(m_BuiltinInst(AI), 0)))
+      return false;
+    if (!match(AI, m_ApplyInst(Op, m_SILValue(LHS), m_SILValue(RHS))))
+      return false;
+    return isOverflowChecked(AI) != nullptr;
+  }
+
+  /// Matches "i" or "i * Scale", where "i" is an induction variable.
+  static InductionInfo *matchScaledIndVar(SILValue V, SILValue &Scale,
+                                          InductionAnalysis &IndVars,
+                                          SILBasicBlock *Preheader,
+                                          DominanceInfo *DT) {
+    if (auto *Arg = dyn_cast<SILArgument>(V.getDef()))
+      return IndVars[Arg];
+
+    SILValue LHS, RHS;
+    if (!matchCheckedOp(V, BuiltinValueKind::SMulOver, LHS, RHS))
+      return nullptr;
+    for (int i = 0; i < 2; ++i, std::swap(LHS, RHS)) {
+      auto *Arg = dyn_cast<SILArgument>(LHS.getDef());
+      if (!Arg || !isHoistableInvariant(RHS, Preheader, DT))
+        continue;
+      if (auto *Ind = IndVars[Arg]) {
+        Scale = RHS;
+        return Ind;
+      }
+    }
+    return nullptr;
+  }
 
-  AccessFunction(InductionInfo *I) { Ind = I; }
 public:
 
   operator bool() { return Ind != nullptr; }
 
   static AccessFunction getLinearFunction(SILValue Idx,
-                                          InductionAnalysis &IndVars) {
+                                          InductionAnalysis &IndVars,
+                                          SILBasicBlock *Preheader,
+                                          DominanceInfo *DT) {
     // Match the actual induction variable burried in the integer struct.
     // %2 = struct $Int(%1 : $Builtin.Word)
     //    = apply %check_bounds(%array, %2) : $@convention(thin) (Int, ArrayInt) -> ()
@@ -902,19 +1019,28 @@ public:
     if (!ArrayIndexStruct)
       return nullptr;
 
-    auto AsArg =
-        dyn_cast<SILArgument>(ArrayIndexStruct->getElements()[0].getDef());
-    if (!AsArg)
-      return nullptr;
-
-    if (auto *Ind = IndVars[AsArg])
-      return AccessFunction(Ind);
+    SILValue Elt = ArrayIndexStruct->getElements()[0];
+    SILValue Scale;
+    if (auto *Ind = matchScaledIndVar(Elt, Scale, IndVars, Preheader, DT))
+      return AccessFunction(Ind, Scale);
 
+    // Match "i * Scale + Offset" and "Offset + i * Scale".
+    SILValue LHS, RHS;
+    if (!matchCheckedOp(Elt, BuiltinValueKind::SAddOver, LHS, RHS))
+      return nullptr;
+    for (int i = 0; i < 2; ++i, std::swap(LHS, RHS)) {
+      if (!isHoistableInvariant(RHS, Preheader, DT))
+        continue;
+      if (auto *Ind = matchScaledIndVar(LHS, Scale, IndVars, Preheader, DT))
+        return AccessFunction(Ind, Scale, RHS);
+    }
     return nullptr;
   }
 
   /// Returns true if the loop iterates from 0 until count of \p Array.
   bool isZeroToCount(SILValue Array) {
+    if (Scale || Offset)
+      return false;
     return getZeroToCountArray(Ind->Start, Ind->End) == Array;
   }
 
@@ -928,7 +1054,7 @@ public:
     SILBuilderWithScope Builder(Preheader->getTerminator(), AI);
 
     // Get the first induction value.
-    auto FirstVal = Ind->getFirstValue();
+    auto FirstVal = getIndex(Ind->getFirstValue(), Loc, Builder, Preheader, DT);
     // Clone the struct for the start index.
     auto Start = cast<SILInstruction>(CheckToHoist.getIndex())
                      ->clone(Preheader->getTerminator());
@@ -940,7 +1066,8 @@ public:
     NewCheck->setOperand(1, Start);
 
     // Get the last induction value.
-    auto LastVal = Ind->getLastValue(Loc, Builder);
+    auto LastVal = getIndex(Ind->getLastValue(Loc, Builder), Loc, Builder,
+                            Preheader, DT);
     // Clone the struct for the end index.
     auto End = cast<SILInstruction>(CheckToHoist.getIndex())
                    ->clone(Preheader->getTerminator());
@@ -950,6 +1077,23 @@ public:
     NewCheck = CheckToHoist.copyTo(Preheader->getTerminator(), DT);
     NewCheck->setOperand(1, End);
   }
+
+private:
+  /// Computes the index "IndVal * Scale + Offset" in the preheader.
+  /// The loop would trap if any of the operations overflowed for the first or
+  /// last value of the induction variable, so this traps, too.
+  SILValue getIndex(SILValue IndVal, SILLocation Loc, SILBuilder &Builder,
+                    SILBasicBlock *Preheader, DominanceInfo *DT) {
+    if (Scale)
+      IndVal = getCheckedBinaryOp(
+          Loc, "smul_with_overflow", IndVal,
+          getInvariantInPreheader(Scale, Preheader, DT), Builder);
+    if (Offset)
+      IndVal = getCheckedBinaryOp(
+          Loc, "sadd_with_overflow", IndVal,
+          getInvariantInPreheader(Offset, Preheader, DT), Builder);
+    return IndVal;
+  }
 };
 
 static bool hasArrayType(SILValue Value, SILModule &M) {
@@ -1012,9 +1156,10 @@ static bool hoistChecksInLoop(DominanceInfo *DT, DominanceInfoNode *DTNode,
       continue;
     }
 
-    // Get the access function "a[f(i)]". At the moment this handles only the
-    // identity function.
-    auto F = AccessFunction::getLinearFunction(ArrayIndex, IndVars);
+    // Get the access function "a[f(i)]". At the moment this handles affine
+    // functions of a single induction variable.
+    auto F = AccessFunction::getLinearFunction(ArrayIndex, IndVars, Preheader,
+                                               DT);
     if (!F) {
       DEBUG(llvm::dbgs() << " not a linear function " << *Inst);
       continue;
@@ -1059,6 +1204,88 @@ static bool hoistChecksInLoop(DominanceInfo *DT, DominanceInfoNode *DTNode,
   return Changed;
 }
 
+/// Returns the name of an overflow checked builtin which is monotonic in each
+/// of its operands, if the other operand is loop invariant.
+static StringRef getMonotonicOverflowOpName(BuiltinValueKind ID) {
+  switch (ID) {
+  case BuiltinValueKind::SAddOver:
+    return "sadd_with_overflow";
+  case BuiltinValueKind::SSubOver:
+    return "ssub_with_overflow";
+  case BuiltinValueKind::SMulOver:
+    return "smul_with_overflow";
+  default:
+    return StringRef();
+  }
+}
+
+/// Replace the overflow checks of arithmetic on induction variables by checks
+/// in the preheader.
+///
+/// "i + c", "i - c", "c - i" and "i * c" are monotonic in "i" if "c" is loop
+/// invariant. If the operation does not overflow for the first and the last
+/// value of the induction variable, it does not overflow for any value in
+/// between. This requires that the operation is executed in every iteration
+/// and that the induction variable's overflow check was already hoisted, so
+/// that the loop is known to iterate from start to end - 1.
+static bool hoistOverflowChecksInLoop(DominanceInfo *DT,
+                                      DominanceInfoNode *DTNode,
+                                      InductionAnalysis &IndVars,
+                                      SILBasicBlock *Preheader,
+                                      SILBasicBlock *ExitingBlk) {
+  bool Changed = false;
+  auto *CurBB = DTNode->getBlock();
+
+  if (isGuaranteedToBeExecuted(DT, CurBB, ExitingBlk)) {
+    for (auto &Inst : *CurBB) {
+      auto *BI = dyn_cast<BuiltinInst>(&Inst);
+      if (!BI)
+        continue;
+      StringRef Name = getMonotonicOverflowOpName(BI->getBuiltinInfo().ID);
+      if (Name.empty())
+        continue;
+      CondFailInst *CondFail = isOverflowChecked(BI);
+      if (!CondFail)
+        continue;
+
+      // Find the induction variable operand.
+      SILValue IndVal, Invariant;
+      InductionInfo *Ind = nullptr;
+      unsigned IndIdx = 0;
+      for (; IndIdx < 2; ++IndIdx) {
+        auto *Arg = dyn_cast<SILArgument>(BI->getArguments()[IndIdx].getDef());
+        if (Arg && (Ind = IndVars[Arg]))
+          break;
+      }
+      if (!Ind || !Ind->IsOverflowCheckInserted || Ind->Inc == BI)
+        continue;
+      Invariant = BI->getArguments()[1 - IndIdx];
+      if (!isHoistableInvariant(Invariant, Preheader, DT))
+        continue;
+
+      SILLocation Loc = BI->getLoc();
+      SILBuilderWithScope Builder(Preheader->getTerminator(), BI);
+      Invariant = getInvariantInPreheader(Invariant, Preheader, DT);
+      SILValue Bounds[] = {Ind->getFirstValue(),
+                           Ind->getLastValue(Loc, Builder)};
+      for (SILValue Bound : Bounds) {
+        if (IndIdx == 0)
+          getCheckedBinaryOp(Loc, Name, Bound, Invariant, Builder);
+        else
+          getCheckedBinaryOp(Loc, Name, Invariant, Bound, Builder);
+      }
+      DEBUG(llvm::dbgs() << "  Overflow check hoisted: " << *BI);
+      CondFail->eraseFromParent();
+      Changed = true;
+    }
+  }
+
+  for (auto Child : *DTNode)
+    Changed |= hoistOverflowChecksInLoop(DT, Child, IndVars, Preheader,
+                                         ExitingBlk);
+  return Changed;
+}
+
 /// Analyse the loop for arrays that are not modified and perform dominator tree
 /// based redundant bounds check removal.
 static bool hoistBoundsChecks(SILLoop *Loop, DominanceInfo *DT, SILLoopInfo *LI,
@@ -1073,10 +1300,6 @@ static bool hoistBoundsChecks(SILLoop *Loop, DominanceInfo *DT, SILLoopInfo *LI,
     return false;
   }
 
-  // Only handle innermost loops for now.
-  if (!Loop->getSubLoops().empty())
-    return false;
-
   DEBUG(llvm::dbgs() << "Attempting to remove redundant checks in " << *Loop);
   DEBUG(Header->getParent()->dump());
 
@@ -1128,6 +1351,12 @@ static bool hoistBoundsChecks(SILLoop *Loop, DominanceInfo *DT, SILLoopInfo *LI,
         IV->checkOverflow(B);
       }
 
+  // Hoist the overflow checks of arithmetic on induction variables. Adjacent
+  // cond_fails in the preheader are merged later by MergeCondFail.
+  if (IVarsFound)
+    Changed |= hoistOverflowChecksInLoop(DT, DT->getNode(Header), IndVars,
+                                         Preheader, ExitingBlk);
+
   DEBUG(Preheader->getParent()->dump());
 
   // Hoist bounds checks.
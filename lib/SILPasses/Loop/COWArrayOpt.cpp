@@ -423,6 +423,10 @@ protected:
 /// need to check how it is initialized here, because that will show up as a
 /// store to the local's address. checkSafeArrayAddressUses will check that the
 /// store is a simple initialization outside the loop.
+///
+/// (3) A stored property of an object allocated in this function. The object
+/// is only unique if it doesn't escape before or within the loop, which
+/// checkSafeArrayAddressUses checks along with the other uses of the object.
 bool COWArrayOpt::checkUniqueArrayContainer(SILValue ArrayContainer) {
   if (SILArgument *Arg = dyn_cast<SILArgument>(ArrayContainer)) {
     // Check that the argument is passed as an inout type. This means there are
@@ -441,11 +445,13 @@ bool COWArrayOpt::checkUniqueArrayContainer(SILValue ArrayContainer) {
     }
     return true;
   }
-  else if (isa<AllocStackInst>(ArrayContainer))
+  else if (isa<AllocStackInst>(ArrayContainer) ||
+           isa<AllocRefInst>(ArrayContainer))
     return true;
 
   DEBUG(llvm::dbgs()
-        << "    Skipping Array: Not an argument or local variable!\n");
+        << "    Skipping Array: Not an argument, local variable or local "
+           "object!\n");
   return false;
 }
 
@@ -609,6 +615,19 @@ bool COWArrayOpt::checkSafeArrayAddressUses(UserList &AddressUsers) {
       continue;
     }
 
+    if (isa<StrongRetainInst>(UseInst) || isa<StrongReleaseInst>(UseInst) ||
+        isa<DeallocRefInst>(UseInst)) {
+      // Retaining a local object which contains the array doesn't retain the
+      // array. A release inside the loop might run a deinit which copies the
+      // array, though.
+      if (!Loop->contains(UseInst->getParent()))
+        continue;
+
+      DEBUG(llvm::dbgs() << "    Skipping Array: container object released "
+            "inside loop!\n    " << *UseInst);
+      return false;
+    }
+
     if (isa<MarkDependenceInst>(UseInst)) {
       continue;
     }
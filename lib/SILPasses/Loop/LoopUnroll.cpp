@@ -0,0 +1,322 @@
+//===--------- LoopUnroll.cpp - Loop unrolling ------------------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Fully unrolls small innermost loops with a constant trip count.
+//
+// The loop must be in rotated form: the latch is the only exiting block and
+// ends in a cond_br which compares the incremented induction variable against
+// an integer literal. The induction variable must start at an integer literal.
+// For example:
+//
+//   preheader:
+//     %start = integer_literal $Builtin.Int64, 0
+//     br header(%start)
+//   header(%iv):
+//     ...
+//     %inc = builtin "sadd_with_overflow_Int64"(%iv, %one, ...)
+//     %next = tuple_extract %inc, 0
+//     %cmp = builtin "cmp_eq_Int64"(%next, %end)
+//     cond_br %cmp, exit, header(%next)
+//
+// The loop body is cloned once for every additional iteration, and the latches
+// are connected with unconditional branches.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "sil-loopunroll"
+
+#include "swift/SIL/PatternMatch.h"
+#include "swift/SIL/SILArgument.h"
+#include "swift/SIL/SILBuilder.h"
+#include "swift/SIL/SILCloner.h"
+#include "swift/SILAnalysis/IVAnalysis.h"
+#include "swift/SILAnalysis/LoopAnalysis.h"
+#include "swift/SILPasses/Passes.h"
+#include "swift/SILPasses/Transforms.h"
+#include "swift/SILPasses/Utils/Local.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+
+using namespace swift;
+using namespace swift::PatternMatch;
+
+STATISTIC(NumLoopsUnrolled, "Number of loops fully unrolled");
+
+static llvm::cl::opt<unsigned> UnrollThreshold(
+    "sil-loop-unroll-threshold", llvm::cl::init(250),
+    llvm::cl::desc("The number of instructions which fully unrolling a loop "
+                   "may add to a function"));
+
+namespace {
+
+/// Clones all blocks of a loop. The exit blocks are not cloned, so the cloned
+/// loop exits to the same blocks as the original loop.
+class LoopCloner : public SILCloner<LoopCloner> {
+  SILLoop *Loop;
+
+  friend class SILVisitor<LoopCloner>;
+  friend class SILCloner<LoopCloner>;
+
+public:
+  LoopCloner(SILLoop *Loop)
+      : SILCloner<LoopCloner>(*Loop->getHeader()->getParent()), Loop(Loop) {}
+
+  /// Clones the loop and returns the cloned header. The back edges of the
+  /// cloned loop branch to the cloned header.
+  SILBasicBlock *cloneLoop() {
+    SILBasicBlock *Header = Loop->getHeader();
+    SILFunction *F = Header->getParent();
+    SILModule &M = F->getModule();
+
+    // The exit blocks are mapped to themselves, so that visitSILBasicBlock
+    // does not clone them.
+    SmallVector<SILBasicBlock *, 4> ExitBlocks;
+    Loop->getExitBlocks(ExitBlocks);
+    for (auto *BB : ExitBlocks)
+      BBMap[BB] = BB;
+
+    auto *ClonedHeader = new (M) SILBasicBlock(F);
+    BBMap[Header] = ClonedHeader;
+    for (auto *Arg : Header->getBBArgs()) {
+      SILValue MappedArg =
+          new (M) SILArgument(ClonedHeader, getOpType(Arg->getType()));
+      ValueMap.insert(std::make_pair(Arg, MappedArg));
+    }
+
+    getBuilder().setInsertionPoint(ClonedHeader);
+    visitSILBasicBlock(Header);
+
+    // Clone the terminators, now that all blocks are mapped.
+    for (auto BBPair : BBMap) {
+      if (BBPair.first == BBPair.second)
+        continue;
+      getBuilder().setInsertionPoint(BBPair.second);
+      visit(BBPair.first->getTerminator());
+    }
+    return ClonedHeader;
+  }
+
+  SILBasicBlock *getMappedBlock(SILBasicBlock *BB) { return BBMap[BB]; }
+
+protected:
+  SILValue remapValue(SILValue V) {
+    // Values which are defined outside the loop are not cloned.
+    if (auto *BB = V.getDef()->getParentBB())
+      if (!Loop->contains(BB))
+        return V;
+    return SILCloner<LoopCloner>::remapValue(V);
+  }
+};
+
+} // end anonymous namespace
+
+/// Returns the number of times the body of \p Loop is executed, or 0 if it is
+/// not a known constant.
+static uint64_t getConstantTripCount(SILLoop *Loop, SILBasicBlock *Preheader,
+                                     SILBasicBlock *Latch, IVInfo &IVs) {
+  auto *CondBr = dyn_cast<CondBranchInst>(Latch->getTerminator());
+  if (!CondBr)
+    return 0;
+  bool ExitOnTrue = !Loop->contains(CondBr->getTrueBB());
+
+  SILValue Next, End;
+  if (ExitOnTrue) {
+    if (!match(CondBr->getCondition(),
+               m_ApplyInst(BuiltinValueKind::ICMP_EQ, m_SILValue(Next),
+                           m_SILValue(End))))
+      return 0;
+  } else {
+    if (!match(CondBr->getCondition(),
+               m_ApplyInst(BuiltinValueKind::ICMP_NE, m_SILValue(Next),
+                           m_SILValue(End))))
+      return 0;
+  }
+  if (isa<IntegerLiteralInst>(Next))
+    std::swap(Next, End);
+  auto *EndLit = dyn_cast<IntegerLiteralInst>(End);
+  if (!EndLit)
+    return 0;
+
+  // The compared value must be the incremented induction variable.
+  if (!IVs.isInductionVariable(Next.getDef()))
+    return 0;
+  SILArgument *IVArg = IVs.getInductionVariableHeader(Next.getDef());
+  if (IVArg->getParent() != Loop->getHeader())
+    return 0;
+  IVInfo::IVDesc Desc = IVs.getInductionDesc(IVArg);
+  auto *TEI = dyn_cast<TupleExtractInst>(Next);
+  if (!Desc || !TEI || TEI->getOperand().getDef() != Desc.Inc ||
+      TEI->getFieldNo() != 0)
+    return 0;
+
+  // The induction variable must start at a literal.
+  auto *PreheaderBr = dyn_cast<BranchInst>(Preheader->getTerminator());
+  if (!PreheaderBr)
+    return 0;
+  auto *StartLit =
+      dyn_cast<IntegerLiteralInst>(PreheaderBr->getArg(IVArg->getIndex()));
+  if (!StartLit)
+    return 0;
+
+  APInt Start = StartLit->getValue();
+  APInt Step = Desc.IncVal->getValue();
+  APInt EndVal = EndLit->getValue();
+  if (Start.getBitWidth() != EndVal.getBitWidth() ||
+      Start.getBitWidth() != Step.getBitWidth() || Step == 0)
+    return 0;
+
+  // The induction variable must hit the end value exactly, without
+  // overflowing on the way.
+  bool Overflow = false;
+  APInt Distance = EndVal.ssub_ov(Start, Overflow);
+  if (Overflow || Distance.srem(Step) != 0)
+    return 0;
+  APInt TripCount = Distance.sdiv(Step);
+  if (!TripCount.isStrictlyPositive() || TripCount.getActiveBits() > 32)
+    return 0;
+  return TripCount.getZExtValue();
+}
+
+/// Replaces the conditional branch at the end of \p Latch by an unconditional
+/// branch to \p Dest, passing the arguments of the edge to \p OrigDest.
+static void replaceLatchBranch(SILBasicBlock *Latch, SILBasicBlock *OrigDest,
+                               SILBasicBlock *Dest) {
+  auto *CondBr = cast<CondBranchInst>(Latch->getTerminator());
+  SmallVector<SILValue, 8> Args;
+  if (CondBr->getTrueBB() == OrigDest) {
+    for (SILValue Arg : CondBr->getTrueArgs())
+      Args.push_back(Arg);
+  } else {
+    for (SILValue Arg : CondBr->getFalseArgs())
+      Args.push_back(Arg);
+  }
+  SILValue Cond = CondBr->getCondition();
+  SILBuilder(CondBr).createBranch(CondBr->getLoc(), Dest, Args);
+  CondBr->eraseFromParent();
+  if (auto *CondInst = dyn_cast<SILInstruction>(Cond))
+    recursivelyDeleteTriviallyDeadInstructions(CondInst);
+}
+
+/// Tries to fully unroll \p Loop. Returns true if the loop was unrolled.
+static bool tryToUnrollLoop(SILLoop *Loop, IVInfo &IVs) {
+  assert(Loop->empty() && "Only innermost loops are unrolled");
+
+  SILBasicBlock *Preheader = Loop->getLoopPreheader();
+  SILBasicBlock *Header = Loop->getHeader();
+  SILBasicBlock *Latch = Loop->getLoopLatch();
+  SILBasicBlock *Exit = Loop->getExitBlock();
+  if (!Preheader || !Latch || !Exit || Loop->getExitingBlock() != Latch)
+    return false;
+
+  uint64_t TripCount = getConstantTripCount(Loop, Preheader, Latch, IVs);
+  if (TripCount < 2)
+    return false;
+
+  // Check the size of the loop and whether we can clone it. Values defined in
+  // the loop must not be used outside of it (except by the branch to the exit
+  // block), because we don't update SSA form.
+  uint64_t LoopSize = 0;
+  for (auto *BB : Loop->getBlocks()) {
+    for (auto *Arg : BB->getBBArgs())
+      for (auto *Use : Arg->getUses())
+        if (!Loop->contains(Use->getUser()->getParent()))
+          return false;
+    for (auto &I : *BB) {
+      if (!I.isTriviallyDuplicatable())
+        return false;
+      for (auto *Use : I.getUses())
+        if (!Loop->contains(Use->getUser()->getParent()))
+          return false;
+      ++LoopSize;
+    }
+  }
+  if (LoopSize * (TripCount - 1) > UnrollThreshold) {
+    DEBUG(llvm::dbgs() << "  not unrolling loop with " << LoopSize
+                       << " instructions and trip count " << TripCount
+                       << ": too large\n");
+    return false;
+  }
+
+  DEBUG(llvm::dbgs() << "  unrolling loop in "
+                     << Header->getParent()->getName() << " with trip count "
+                     << TripCount << '\n');
+
+  // Clone the original loop once for each additional iteration. All copies
+  // are made before any branch is changed, so that they are identical.
+  SmallVector<std::pair<SILBasicBlock *, SILBasicBlock *>, 8> Iterations;
+  Iterations.push_back({Header, Latch});
+  for (uint64_t i = 1; i < TripCount; ++i) {
+    LoopCloner Cloner(Loop);
+    SILBasicBlock *ClonedHeader = Cloner.cloneLoop();
+    Iterations.push_back({ClonedHeader, Cloner.getMappedBlock(Latch)});
+  }
+
+  // Chain the iterations: each latch branches to the header of the next
+  // iteration, and the last latch leaves the loop.
+  for (unsigned i = 0, e = Iterations.size(); i != e; ++i) {
+    SILBasicBlock *IterHeader = Iterations[i].first;
+    SILBasicBlock *IterLatch = Iterations[i].second;
+    if (i + 1 < e)
+      replaceLatchBranch(IterLatch, IterHeader, Iterations[i + 1].first);
+    else
+      replaceLatchBranch(IterLatch, Exit, Exit);
+  }
+  ++NumLoopsUnrolled;
+  return true;
+}
+
+namespace {
+
+class LoopUnrolling : public SILFunctionTransform {
+
+  void run() override {
+    SILFunction *F = getFunction();
+    auto *LA = PM->getAnalysis<SILLoopAnalysis>();
+    auto *IVA = PM->getAnalysis<IVAnalysis>();
+    SILLoopInfo *LI = LA->get(F);
+    if (LI->empty())
+      return;
+
+    DEBUG(llvm::dbgs() << "Loop unroll running on " << F->getName() << '\n');
+
+    // Collect the innermost loops first. Unrolling one of them does not change
+    // the blocks of the others.
+    SmallVector<SILLoop *, 16> Worklist;
+    SmallVector<SILLoop *, 16> InnermostLoops;
+    for (auto *L : *LI)
+      Worklist.push_back(L);
+    while (!Worklist.empty()) {
+      SILLoop *L = Worklist.pop_back_val();
+      if (L->empty())
+        InnermostLoops.push_back(L);
+      for (auto *SubLoop : *L)
+        Worklist.push_back(SubLoop);
+    }
+
+    IVInfo &IVs = *IVA->get(F);
+    bool Changed = false;
+    for (auto *L : InnermostLoops)
+      Changed |= tryToUnrollLoop(L, IVs);
+
+    if (Changed)
+      invalidateAnalysis(SILAnalysis::InvalidationKind::FunctionBody);
+  }
+
+  StringRef getName() override { return "SIL Loop Unroll"; }
+};
+
+} // end anonymous namespace
+
+SILTransform *swift::createLoopUnroll() {
+  return new LoopUnrolling();
+}
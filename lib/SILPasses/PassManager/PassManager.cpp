@@ -13,15 +13,25 @@
 #define DEBUG_TYPE "sil-passmanager"
 
 #include "swift/SILPasses/PassManager.h"
+#include "swift/AST/FunctionTimeProfile.h"
 #include "swift/SIL/SILFunction.h"
 #include "swift/SIL/SILModule.h"
+#include "swift/SILAnalysis/BasicCalleeAnalysis.h"
+#include "swift/SILAnalysis/FunctionOrder.h"
 #include "swift/SILPasses/PrettyStackTrace.h"
 #include "swift/SILPasses/Transforms.h"
+#include "swift/Basic/JSONSerialization.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace swift;
 
@@ -39,6 +49,16 @@ llvm::cl::opt<bool> SILPrintPassTime(
     "sil-print-pass-time", llvm::cl::init(false),
     llvm::cl::desc("Print the execution time of each SIL pass"));
 
+llvm::cl::opt<std::string> SILPassStats(
+    "sil-pass-stats", llvm::cl::init(""),
+    llvm::cl::desc("Write statistics about the runs of each SIL pass to this "
+                   "file, as JSON"));
+
+llvm::cl::opt<unsigned> SILPassStatsTopFunctions(
+    "sil-pass-stats-top-functions", llvm::cl::init(5),
+    llvm::cl::desc("The number of most expensive runs of each pass to list "
+                   "with -sil-pass-stats"));
+
 llvm::cl::opt<unsigned> SILNumOptPassesToRun(
     "sil-opt-pass-count", llvm::cl::init(UINT_MAX),
     llvm::cl::desc("Stop optimizing after <N> optimization passes"));
@@ -75,6 +95,15 @@ llvm::cl::opt<bool> SILVerifyWithoutInvalidation(
     "sil-verify-without-invalidation", llvm::cl::init(false),
     llvm::cl::desc("Verify after passes even if the pass has not invalidated"));
 
+/// Returns true if the sampling verifier selects \p F. Functions are selected
+/// by a hash of their name, so the same functions are verified after every
+/// pass and in every compilation.
+static bool isSampledForVerification(const SILFunction &F,
+                                     const SILOptions &Options) {
+  return Options.VerifySampleRate <= 1 ||
+         llvm::HashString(F.getName()) % Options.VerifySampleRate == 0;
+}
+
 static bool doPrintBefore(SILTransform *T, SILFunction *F) {
   if (!SILPrintOnlyFun.empty() && F && F->getName() != SILPrintOnlyFun)
     return false;
@@ -129,6 +158,154 @@ static bool isDisabled(SILTransform *T) {
   return false;
 }
 
+namespace {
+  /// One run of a pass, for -sil-pass-stats.
+  struct PassRun {
+    std::string Function;
+    uint64_t Time = 0;
+  };
+
+  /// The runs of one pass over the whole compilation, for -sil-pass-stats.
+  struct PassStats {
+    std::string Name;
+    uint64_t TotalTime = 0;
+    uint64_t Runs = 0;
+    uint64_t RunsWithChanges = 0;
+    uint64_t InstructionsAdded = 0;
+    uint64_t InstructionsRemoved = 0;
+
+    /// The most expensive runs, most expensive first.
+    std::vector<PassRun> SlowestRuns;
+  };
+}
+
+namespace swift {
+namespace json {
+  template<>
+  struct ObjectTraits<PassRun> {
+    static void mapping(Output &out, PassRun &run) {
+      out.mapRequired("function", run.Function);
+      out.mapRequired("time_ns", run.Time);
+    }
+  };
+
+  template<>
+  struct ObjectTraits<PassStats> {
+    static void mapping(Output &out, PassStats &stats) {
+      out.mapRequired("pass", stats.Name);
+      out.mapRequired("time_ns", stats.TotalTime);
+      out.mapRequired("runs", stats.Runs);
+      out.mapRequired("runs_with_changes", stats.RunsWithChanges);
+      out.mapRequired("instructions_added", stats.InstructionsAdded);
+      out.mapRequired("instructions_removed", stats.InstructionsRemoved);
+      out.mapRequired("slowest_runs", stats.SlowestRuns);
+    }
+  };
+
+  template<typename T>
+  struct ArrayTraits<std::vector<T>> {
+    static size_t size(Output &out, std::vector<T> &seq) {
+      return seq.size();
+    }
+
+    static T &element(Output &out, std::vector<T> &seq, size_t index) {
+      if (index >= seq.size())
+        seq.resize(index+1);
+      return seq[index];
+    }
+  };
+} // end namespace json
+} // end namespace swift
+
+/// The statistics for each pass, accumulated across all the pass managers
+/// in this process.
+static llvm::StringMap<PassStats> &getPassStats() {
+  static llvm::StringMap<PassStats> Stats;
+  return Stats;
+}
+
+static uint64_t countInstructions(SILFunction &F) {
+  uint64_t Count = 0;
+  for (auto &BB : F)
+    Count += std::distance(BB.begin(), BB.end());
+  return Count;
+}
+
+static uint64_t countInstructions(SILModule &M) {
+  uint64_t Count = 0;
+  for (auto &F : M)
+    Count += countInstructions(F);
+  return Count;
+}
+
+static SILPassRunObserver *ActiveObserver = nullptr;
+
+SILPassRunObserver *SILPassRunObserver::getActive() {
+  return ActiveObserver;
+}
+
+void SILPassRunObserver::setActive(SILPassRunObserver *Observer) {
+  ActiveObserver = Observer;
+}
+
+static void recordPassRun(SILTransform *T, StringRef Function, uint64_t Time,
+                          bool Changed, uint64_t InstructionsBefore,
+                          uint64_t InstructionsAfter) {
+  PassStats &Stats = getPassStats()[T->getName()];
+  Stats.Name = T->getName();
+  Stats.TotalTime += Time;
+  ++Stats.Runs;
+  if (Changed)
+    ++Stats.RunsWithChanges;
+  if (InstructionsAfter > InstructionsBefore)
+    Stats.InstructionsAdded += InstructionsAfter - InstructionsBefore;
+  else
+    Stats.InstructionsRemoved += InstructionsBefore - InstructionsAfter;
+
+  // Keep the slowest runs, in order.
+  auto &Slowest = Stats.SlowestRuns;
+  if (Slowest.size() == SILPassStatsTopFunctions &&
+      (Slowest.empty() || Slowest.back().Time >= Time))
+    return;
+
+  PassRun Run;
+  Run.Function = Function;
+  Run.Time = Time;
+  auto Pos = std::upper_bound(Slowest.begin(), Slowest.end(), Time,
+                              [](uint64_t Time, const PassRun &Other) {
+                                return Time > Other.Time;
+                              });
+  Slowest.insert(Pos, std::move(Run));
+  if (Slowest.size() > SILPassStatsTopFunctions)
+    Slowest.pop_back();
+}
+
+/// Write the statistics gathered so far to the -sil-pass-stats file, most
+/// expensive pass first.
+static void writePassStats() {
+  std::vector<PassStats> AllStats;
+  for (auto &Entry : getPassStats())
+    AllStats.push_back(Entry.getValue());
+  std::sort(AllStats.begin(), AllStats.end(),
+            [](const PassStats &LHS, const PassStats &RHS) {
+              if (LHS.TotalTime != RHS.TotalTime)
+                return LHS.TotalTime > RHS.TotalTime;
+              return LHS.Name < RHS.Name;
+            });
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(SILPassStats, EC, llvm::sys::fs::F_None);
+  if (EC) {
+    llvm::errs() << "error: cannot write SIL pass statistics to '"
+                 << SILPassStats << "': " << EC.message() << "\n";
+    return;
+  }
+
+  json::Output Out(OS);
+  Out << AllStats;
+  OS << "\n";
+}
+
 static void printModule(SILModule *Mod, bool EmitVerboseSIL) {
   if (SILPrintOnlyFun.empty() && SILPrintOnlyFuns.empty()) {
     Mod->dump();
@@ -144,8 +321,14 @@ static void printModule(SILModule *Mod, bool EmitVerboseSIL) {
   }
 }
 
+void SILPassManager::DeletedInstructionTracker::handleDeleteNotification(
+    SILInstruction *I) {
+  if (SILBasicBlock *BB = I->getParent())
+    PM.InvalidatedFunctions.insert(BB->getParent());
+}
+
 SILPassManager::SILPassManager(SILModule *M, llvm::StringRef Stage) :
-  Mod(M), StageName(Stage) {
+  Mod(M), StageName(Stage), DeleteTracker(*this) {
   
 #define ANALYSIS(NAME) \
   Analysis.push_back(create##NAME##Analysis(Mod));
@@ -160,7 +343,35 @@ SILPassManager::SILPassManager(SILModule *M, llvm::StringRef Stage) :
 bool SILPassManager::runFunctionPasses(PassList FuncTransforms) {
   const SILOptions &Options = getOptions();
 
-  for (auto &F : *Mod) {
+  // Run the whole pipeline on each function. When optimizing, visit the
+  // functions bottom-up in the call graph so that callees are optimized
+  // before their callers: the inliner and other interprocedural decisions
+  // then see optimized callee bodies rather than waiting for another
+  // iteration. The diagnostic passes keep module order, so that diagnostics
+  // come out in source order.
+  llvm::SmallVector<SILFunction *, 32> Worklist;
+  if (Mod->getStage() == SILStage::Canonical) {
+    BottomUpFunctionOrder BottomUpOrder(*Mod,
+                                        getAnalysis<BasicCalleeAnalysis>());
+    auto BottomUpFunctions = BottomUpOrder.getFunctions();
+    Worklist.append(BottomUpFunctions.begin(), BottomUpFunctions.end());
+  }
+  llvm::SmallPtrSet<SILFunction *, 32> Scheduled(Worklist.begin(),
+                                                 Worklist.end());
+
+  for (unsigned Idx = 0;; ++Idx) {
+    // Once the ordered functions are done, pick up any functions the passes
+    // created along the way.
+    if (Idx == Worklist.size()) {
+      for (auto &NewF : *Mod)
+        if (Scheduled.insert(&NewF).second)
+          Worklist.push_back(&NewF);
+
+      if (Idx == Worklist.size())
+        break;
+    }
+
+    SILFunction &F = *Worklist[Idx];
     if (F.empty())
       continue;
 
@@ -197,16 +408,37 @@ bool SILPassManager::runFunctionPasses(PassList FuncTransforms) {
         F.dump(Options.EmitVerboseSIL);
       }
 
+      bool CollectStats = !SILPassStats.empty();
+      SILPassRunObserver *Observer = SILPassRunObserver::getActive();
+      uint64_t InstructionsBefore =
+        (CollectStats || Observer) ? countInstructions(F) : 0;
+      FunctionTimeProfile *Profile = FunctionTimeProfile::getActive();
+      uint64_t ProfileStart =
+        (Profile || Observer) ? FunctionTimeProfile::now() : 0;
+
       llvm::sys::TimeValue StartTime = llvm::sys::TimeValue::now();
       Mod->registerDeleteNotificationHandler(SFT);
       SFT->run();
       Mod->removeDeleteNotificationHandler(SFT);
 
-      if (SILPrintPassTime) {
+      uint64_t ProfileTime =
+        (Profile || Observer) ? FunctionTimeProfile::now() - ProfileStart : 0;
+      if (Profile)
+        Profile->addPassTime(F.getDeclContext(), F.getName(), SFT->getName(),
+                             ProfileTime);
+      if (Observer)
+        Observer->passDidRun(SFT, &F, ProfileTime, InstructionsBefore,
+                             countInstructions(F));
+
+      if (SILPrintPassTime || CollectStats) {
         auto Delta = llvm::sys::TimeValue::now().nanoseconds() -
           StartTime.nanoseconds();
-        llvm::dbgs() << Delta << " (" << SFT->getName() << "," << F.getName()
-                     << ")\n";
+        if (SILPrintPassTime)
+          llvm::dbgs() << Delta << " (" << SFT->getName() << ","
+                       << F.getName() << ")\n";
+        if (CollectStats)
+          recordPassRun(SFT, F.getName(), Delta, currentPassHasInvalidated,
+                        InstructionsBefore, countInstructions(F));
       }
 
       // If this pass invalidated anything, print and verify.
@@ -223,7 +455,8 @@ bool SILPassManager::runFunctionPasses(PassList FuncTransforms) {
         completedPasses.set((size_t)SFT->getPassKind());
 
       if (Options.VerifyAll &&
-          (currentPassHasInvalidated || SILVerifyWithoutInvalidation)) {
+          (currentPassHasInvalidated || SILVerifyWithoutInvalidation) &&
+          isSampledForVerification(F, Options)) {
         F.verify();
         verifyAnalyses(&F);
       }
@@ -288,6 +521,8 @@ void SILPassManager::runOneIteration() {
       SMT->injectModule(Mod);
 
       currentPassHasInvalidated = false;
+      currentPassHasInvalidatedModule = false;
+      InvalidatedFunctions.clear();
 
       if (SILPrintPassName)
         llvm::dbgs() << "#" << NumPassesRun << " Stage: " << StageName
@@ -300,15 +535,33 @@ void SILPassManager::runOneIteration() {
         printModule(Mod, Options.EmitVerboseSIL);
       }
 
+      bool CollectStats = !SILPassStats.empty();
+      SILPassRunObserver *Observer = SILPassRunObserver::getActive();
+      uint64_t InstructionsBefore =
+        (CollectStats || Observer) ? countInstructions(*Mod) : 0;
+      uint64_t ObserverStart = Observer ? FunctionTimeProfile::now() : 0;
+
       llvm::sys::TimeValue StartTime = llvm::sys::TimeValue::now();
       Mod->registerDeleteNotificationHandler(SMT);
+      if (Options.VerifyIncremental)
+        Mod->registerDeleteNotificationHandler(&DeleteTracker);
       SMT->run();
+      Mod->removeDeleteNotificationHandler(&DeleteTracker);
       Mod->removeDeleteNotificationHandler(SMT);
 
-      if (SILPrintPassTime) {
+      if (Observer)
+        Observer->passDidRun(SMT, nullptr,
+                             FunctionTimeProfile::now() - ObserverStart,
+                             InstructionsBefore, countInstructions(*Mod));
+
+      if (SILPrintPassTime || CollectStats) {
         auto Delta = llvm::sys::TimeValue::now().nanoseconds() -
           StartTime.nanoseconds();
-        llvm::dbgs() << Delta << " (" << SMT->getName() << ",Module)\n";
+        if (SILPrintPassTime)
+          llvm::dbgs() << Delta << " (" << SMT->getName() << ",Module)\n";
+        if (CollectStats)
+          recordPassRun(SMT, "<module>", Delta, currentPassHasInvalidated,
+                        InstructionsBefore, countInstructions(*Mod));
       }
 
       // If this pass invalidated anything, print and verify.
@@ -322,7 +575,17 @@ void SILPassManager::runOneIteration() {
 
       if (Options.VerifyAll &&
           (currentPassHasInvalidated || !SILVerifyWithoutInvalidation)) {
-        Mod->verify();
+        // With incremental verification, a pass which only invalidated some
+        // functions only needs those functions to be verified again.
+        bool VerifyChangedOnly = Options.VerifyIncremental &&
+                                 !currentPassHasInvalidatedModule &&
+                                 !SILVerifyWithoutInvalidation;
+        Mod->verify([&](const SILFunction &F) -> bool {
+          if (VerifyChangedOnly &&
+              !InvalidatedFunctions.count(const_cast<SILFunction *>(&F)))
+            return false;
+          return isSampledForVerification(F, Options);
+        });
         verifyAnalyses();
       }
 
@@ -377,6 +640,11 @@ void SILPassManager::run() {
 
 /// D'tor.
 SILPassManager::~SILPassManager() {
+  // The statistics cover every pass manager run so far, so the file is
+  // complete once the last one is destroyed.
+  if (!SILPassStats.empty())
+    writePassStats();
+
   // Free all transformations.
   for (auto T : Transformations)
     delete T;
@@ -144,6 +144,7 @@ void AddHighLevelLoopOptPasses(SILPassManager &PM) {
 
   // Run high-level loop opts.
   PM.addLoopRotate();
+  PM.addLoopUnroll();
 
   // Cleanup.
   PM.addDCE();
@@ -238,6 +239,13 @@ void swift::runSILOptimizationPasses(SILModule &Module) {
 
   // Start by cloning functions from stdlib.
   PM.addSILLinker();
+
+  // In a whole-module build of an executable, hide the public symbols so
+  // that the unused ones can be removed.
+  if (Module.canInternalizeSymbols()) {
+    PM.addInternalize();
+    PM.addDeadFunctionElimination();
+  }
   PM.run();
   PM.resetAndRemoveTransformations();
 
@@ -344,6 +352,9 @@ void swift::runSILOptimizationPasses(SILModule &Module) {
 
   // Perform the final lowering transformations.
   PM.addExternalFunctionDefinitionsElimination();
+  // Merge identical functions, and let dead function elimination remove the
+  // ones which are not referenced anymore.
+  PM.addFunctionMerging();
   PM.addDeadFunctionElimination();
 
   // Optimize overflow checks:
@@ -354,6 +365,18 @@ void swift::runSILOptimizationPasses(SILModule &Module) {
   PM.addDCE();
   // Clean-up after DCE.
   PM.addSimplifyCFG();
+
+  // Use non-atomic reference counting for objects which don't escape. This
+  // must run after the last ARC optimization.
+  PM.addUpdateEscapeAnalysis();
+  PM.addNonAtomicRefCounting();
+
+  // Move the cold paths out of the hot code. This must run after the last
+  // inliner, which would otherwise inline them back.
+  PM.addColdBlockOutliner();
+
+  // Make the side effects of functions available to IRGen and LLVM.
+  PM.addInferEffects();
   PM.runOneIteration();
 
   // Call the CFG viewer.
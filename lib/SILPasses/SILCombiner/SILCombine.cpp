@@ -31,7 +31,12 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace swift;
 
@@ -39,6 +44,53 @@ STATISTIC(NumSimplified, "Number of instructions simplified");
 STATISTIC(NumCombined, "Number of instructions combined");
 STATISTIC(NumDeadInst, "Number of dead insts eliminated");
 
+static llvm::cl::opt<bool> PrintCombineStats(
+    "sil-combine-stats", llvm::cl::init(false),
+    llvm::cl::desc("Print how often SILCombine visited each kind of "
+                   "instruction and how often it changed something, when the "
+                   "process exits"));
+
+namespace {
+/// The counts printed by -sil-combine-stats, per instruction kind.
+struct CombineStats {
+  static constexpr const char *KindNames[] = {
+#define VALUE(Id, Parent) #Id,
+#include "swift/SIL/SILNodes.def"
+  };
+  static constexpr unsigned NumKinds =
+      sizeof(KindNames) / sizeof(KindNames[0]);
+
+  unsigned Visited[NumKinds] = {};
+  unsigned Combined[NumKinds] = {};
+
+  ~CombineStats() {
+    std::vector<unsigned> Kinds;
+    for (unsigned K = 0; K != NumKinds; ++K)
+      if (Visited[K])
+        Kinds.push_back(K);
+    if (Kinds.empty())
+      return;
+
+    // The kinds combined most often come first. Kinds with a visitor which
+    // never fires are candidates for pruning.
+    std::stable_sort(Kinds.begin(), Kinds.end(), [&](unsigned A, unsigned B) {
+      return Combined[A] > Combined[B];
+    });
+    auto &OS = llvm::errs();
+    OS << "===- SILCombine statistics -===\n";
+    OS << llvm::format("%10s %10s  %s\n", "combined", "visited",
+                       "instruction");
+    for (unsigned K : Kinds)
+      OS << llvm::format("%10u %10u  %s\n", Combined[K], Visited[K],
+                         KindNames[K]);
+  }
+};
+} // end anonymous namespace
+
+constexpr const char *CombineStats::KindNames[];
+
+static llvm::ManagedStatic<CombineStats> Stats;
+
 //===----------------------------------------------------------------------===//
 //                              Utility Methods
 //===----------------------------------------------------------------------===//
@@ -170,8 +222,14 @@ bool SILCombiner::doOneIteration(SILFunction &F, unsigned Iteration) {
     DEBUG(llvm::raw_string_ostream SS(OrigI); I->print(SS); OrigI = SS.str(););
     DEBUG(llvm::dbgs() << "SC: Visiting: " << OrigI << '\n');
 
+    unsigned Kind = unsigned(I->getKind());
+    if (PrintCombineStats)
+      ++Stats->Visited[Kind];
+
     if (SILInstruction *Result = visit(I)) {
       ++NumCombined;
+      if (PrintCombineStats)
+        ++Stats->Combined[Kind];
       // Should we replace the old instruction with a new one?
       if (Result != I) {
         assert(&*std::prev(SILBasicBlock::iterator(I)) == Result &&
@@ -333,6 +391,18 @@ SILInstruction *SILCombiner::eraseInstFromFunction(SILInstruction &I,
 //                                Entry Points
 //===----------------------------------------------------------------------===//
 
+/// Records the blocks of a function together with their terminators and
+/// successors, so that we can tell whether a SILCombine run changed the CFG.
+static void recordCFG(SILFunction &F, llvm::SmallVectorImpl<void *> &CFG) {
+  CFG.clear();
+  for (auto &BB : F) {
+    CFG.push_back(&BB);
+    CFG.push_back(BB.getTerminator());
+    for (SILBasicBlock *Succ : BB.getSuccessors())
+      CFG.push_back(Succ);
+  }
+}
+
 namespace {
 
 class SILCombine : public SILFunctionTransform {
@@ -345,13 +415,23 @@ class SILCombine : public SILFunctionTransform {
     // instructions, which we will periodically move to our worklist.
     llvm::SmallVector<SILInstruction *, 64> TrackingList;
 
+    // Most runs only rewrite instructions inside blocks. Remember the CFG so
+    // that analyses which only depend on branches, like dominance and loop
+    // info, survive those runs.
+    llvm::SmallVector<void *, 64> CFGBefore, CFGAfter;
+    recordCFG(*getFunction(), CFGBefore);
+
     SILBuilder B(*getFunction(), &TrackingList);
     SILCombiner Combiner(B, AA, getOptions().RemoveRuntimeAsserts);
     bool Changed = Combiner.runOnFunction(*getFunction());
 
     if (Changed) {
-      // Invalidate everything.
-      invalidateAnalysis(SILAnalysis::InvalidationKind::FunctionBody);
+      recordCFG(*getFunction(), CFGAfter);
+      if (CFGBefore == CFGAfter)
+        invalidateAnalysis(
+            SILAnalysis::InvalidationKind::CallsAndInstructions);
+      else
+        invalidateAnalysis(SILAnalysis::InvalidationKind::FunctionBody);
     }
   }
 
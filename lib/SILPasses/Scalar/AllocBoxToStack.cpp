@@ -645,9 +645,9 @@ class LifetimeTracker {
 
 LifetimeTracker::EndpointRange LifetimeTracker::getEndpoints() {
   if (!Lifetime) {
-    if (TheValue->hasOneUse()) {
+    if (Operand *SingleUse = TheValue->getSingleUse()) {
       Lifetime = ValueLifetime();
-      Lifetime->LastUsers.insert(TheValue->use_begin().getUser());
+      Lifetime->LastUsers.insert(SingleUse->getUser());
     }
     else {
       ValueLifetimeAnalysis VLA(TheValue);
@@ -13,6 +13,12 @@
 // This pass performs a simple dominator tree walk that eliminates trivially
 // redundant instructions.
 //
+// With -enable-cse-loads it also eliminates loads which are redundant with a
+// dominating load of the same address. The writes to memory on the dominator
+// path between the two loads are checked with alias analysis; a block with
+// several predecessors hides the writes on its incoming paths, so loads are
+// not reused across merges.
+//
 //===----------------------------------------------------------------------===//
 
 #define DEBUG_TYPE "sil-cse"
@@ -25,6 +31,7 @@
 #include "swift/SIL/DebugUtils.h"
 #include "swift/SILPasses/Utils/Local.h"
 #include "swift/SILPasses/Transforms.h"
+#include "swift/SILAnalysis/AliasAnalysis.h"
 #include "swift/SILAnalysis/ArraySemantic.h"
 #include "swift/SILAnalysis/DominanceAnalysis.h"
 #include "swift/SILAnalysis/SimplifyInstruction.h"
@@ -33,11 +40,19 @@
 #include "llvm/ADT/ScopedHashTable.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/RecyclingAllocator.h"
 
 STATISTIC(NumSimplify, "Number of instructions simplified or DCE'd");
 STATISTIC(NumCSE,      "Number of instructions CSE'd");
+STATISTIC(NumCSELoads, "Number of loads CSE'd");
+
+static llvm::cl::opt<bool> EnableCSELoads("enable-cse-loads",
+                                          llvm::cl::init(false));
+
+/// The most writes between two loads which are checked for aliasing.
+static const unsigned MaxMemoryDefsToCheck = 64;
 
 using namespace swift;
 
@@ -125,6 +140,10 @@ public:
     return llvm::hash_combine(X->getKind(), X->getType(), X->getBits());
   }
 
+  hash_code visitLoadInst(LoadInst *X) {
+    return llvm::hash_combine(X->getKind(), X->getType(), X->getOperand());
+  }
+
   hash_code visitRefElementAddrInst(RefElementAddrInst *X) {
     return llvm::hash_combine(X->getKind(), X->getOperand(), X->getField());
   }
@@ -396,10 +415,30 @@ public:
   /// their lookup.
   ScopedHTType *AvailableValues;
 
+  /// A load and the number of MemoryDefs when it was executed.
+  typedef std::pair<LoadInst *, unsigned> AvailableLoad;
+  typedef llvm::ScopedHashTableVal<SimpleValue, AvailableLoad> LoadHTValType;
+  typedef llvm::RecyclingAllocator<llvm::BumpPtrAllocator, LoadHTValType>
+  LoadAllocatorTy;
+  typedef llvm::ScopedHashTable<SimpleValue, AvailableLoad,
+                                llvm::DenseMapInfo<SimpleValue>,
+                                LoadAllocatorTy> LoadHTType;
+
+  /// AvailableLoads - The loads executed on the path from the root of the
+  /// domtree, if loads are CSE'd.
+  LoadHTType *AvailableLoads;
+
+  /// MemoryDefs - The instructions which may write to memory on the path from
+  /// the root of the domtree, in order. A null entry stands for the unknown
+  /// writes on the paths into a block with several predecessors.
+  SmallVector<SILInstruction *, 32> MemoryDefs;
+
   SideEffectAnalysis *SEA;
 
-  CSE(bool RunsOnHighLevelSil, SideEffectAnalysis *SEA)
-      : SEA(SEA), RunsOnHighLevelSil(RunsOnHighLevelSil) {}
+  AliasAnalysis *AA;
+
+  CSE(bool RunsOnHighLevelSil, SideEffectAnalysis *SEA, AliasAnalysis *AA)
+      : SEA(SEA), AA(AA), RunsOnHighLevelSil(RunsOnHighLevelSil) {}
 
   bool processFunction(SILFunction &F, DominanceInfo *DT);
   
@@ -416,13 +455,15 @@ private:
   // that the scope gets popped when the NodeScope is destroyed.
   class NodeScope {
    public:
-    NodeScope(ScopedHTType *availableValues) : Scope(*availableValues) {}
+    NodeScope(ScopedHTType *availableValues, LoadHTType *availableLoads)
+        : Scope(*availableValues), LoadScope(*availableLoads) {}
 
    private:
     NodeScope(const NodeScope &) = delete;
     void operator=(const NodeScope &) = delete;
 
     ScopedHTType::ScopeTy Scope;
+    LoadHTType::ScopeTy LoadScope;
   };
 
   // StackNode - contains all the needed information to create a stack for doing
@@ -431,11 +472,13 @@ private:
   // children do not need to be store spearately.
   class StackNode {
    public:
-    StackNode(ScopedHTType *availableValues, DominanceInfoNode *n,
+    StackNode(ScopedHTType *availableValues, LoadHTType *availableLoads,
+              unsigned numMemoryDefs, DominanceInfoNode *n,
               DominanceInfoNode::iterator child,
               DominanceInfoNode::iterator end)
-        : Node(n), ChildIter(child), EndIter(end), Scopes(availableValues),
-      Processed(false) {}
+        : Node(n), ChildIter(child), EndIter(end),
+          Scopes(availableValues, availableLoads),
+          NumMemoryDefs(numMemoryDefs), Processed(false) {}
 
     // Accessors.
     DominanceInfoNode *node() { return Node; }
@@ -446,6 +489,7 @@ private:
       return child;
     }
     DominanceInfoNode::iterator end() { return EndIter; }
+    unsigned numMemoryDefs() { return NumMemoryDefs; }
     bool isProcessed() { return Processed; }
     void process() { Processed = true; }
 
@@ -458,10 +502,18 @@ private:
     DominanceInfoNode::iterator ChildIter;
     DominanceInfoNode::iterator EndIter;
     NodeScope Scopes;
+    unsigned NumMemoryDefs;
     bool Processed;
   };
 
   bool processNode(DominanceInfoNode *Node);
+
+  bool processLoad(LoadInst *LI);
+
+  void recordMemoryDef(SILInstruction *Inst) {
+    if (EnableCSELoads && Inst->mayWriteToMemory())
+      MemoryDefs.push_back(Inst);
+  }
 };
 }  // end anonymous namespace
 
@@ -475,11 +527,15 @@ bool CSE::processFunction(SILFunction &Fm, DominanceInfo *DT) {
   // Tables that the pass uses when walking the domtree.
   ScopedHTType AVTable;
   AvailableValues = &AVTable;
+  LoadHTType LoadTable;
+  AvailableLoads = &LoadTable;
+  MemoryDefs.clear();
 
   bool Changed = false;
 
   // Process the root node.
-  nodesToProcess.push_back(new StackNode(AvailableValues, DT->getRootNode(),
+  nodesToProcess.push_back(new StackNode(AvailableValues, AvailableLoads, 0,
+                  DT->getRootNode(),
                   DT->getRootNode()->begin(),
                   DT->getRootNode()->end()));
 
@@ -499,10 +555,12 @@ bool CSE::processFunction(SILFunction &Fm, DominanceInfo *DT) {
       // Push the next child onto the stack.
       DominanceInfoNode *child = NodeToProcess->nextChild();
       nodesToProcess.push_back(
-          new StackNode(AvailableValues, child, child->begin(), child->end()));
+          new StackNode(AvailableValues, AvailableLoads, MemoryDefs.size(),
+                        child, child->begin(), child->end()));
     } else {
       // It has been processed, and there are no more children to process,
       // so delete it and pop it off the stack.
+      MemoryDefs.resize(NodeToProcess->numMemoryDefs());
       delete NodeToProcess;
       nodesToProcess.pop_back();
     }
@@ -515,6 +573,10 @@ bool CSE::processNode(DominanceInfoNode *Node) {
   SILBasicBlock *BB = Node->getBlock();
   bool Changed = false;
 
+  // The writes on the other paths into a merge aren't on the domtree path.
+  if (Node->getIDom() && !BB->getSinglePredecessor())
+    MemoryDefs.push_back(nullptr);
+
   // See if any instructions in the block can be eliminated.  If so, do it.  If
   // not, add them to AvailableValues.
   for (SILBasicBlock::iterator I = BB->begin(), E = BB->end(); I != E;) {
@@ -544,9 +606,21 @@ bool CSE::processNode(DominanceInfoNode *Node) {
       continue;
     }
 
+    if (EnableCSELoads) {
+      if (auto *LI = dyn_cast<LoadInst>(Inst)) {
+        if (processLoad(LI)) {
+          Changed = true;
+          ++NumCSELoads;
+        }
+        continue;
+      }
+    }
+
     // If this is not a simple instruction that we can value number, skip it.
-    if (!canHandle(Inst))
+    if (!canHandle(Inst)) {
+      recordMemoryDef(Inst);
       continue;
+    }
 
     // If an instruction can be handled here, then it must also be handled
     // in isIdenticalTo, otherwise looking up a key in the map with fail to
@@ -567,6 +641,7 @@ bool CSE::processNode(DominanceInfoNode *Node) {
 
     // Otherwise, just remember that this value is available.
     AvailableValues->insert(Inst, Inst);
+    recordMemoryDef(Inst);
     DEBUG(llvm::dbgs() << "SILCSE Adding to value table: " << *Inst << " -> "
                        << *Inst << "\n");
   }
@@ -574,6 +649,31 @@ bool CSE::processNode(DominanceInfoNode *Node) {
   return Changed;
 }
 
+/// Replaces \p LI with a dominating load of the same address if no write in
+/// between may change the loaded value, or else makes it available. Returns
+/// true if \p LI was replaced.
+bool CSE::processLoad(LoadInst *LI) {
+  AvailableLoad Available = AvailableLoads->lookup(LI);
+  if (Available.first) {
+    unsigned First = Available.second;
+    bool IsClobbered = MemoryDefs.size() - First > MaxMemoryDefsToCheck ||
+      std::any_of(MemoryDefs.begin() + First, MemoryDefs.end(),
+                  [&](SILInstruction *Def) {
+        return !Def || AA->mayWriteToMemory(Def, LI->getOperand());
+      });
+    if (!IsClobbered) {
+      DEBUG(llvm::dbgs() << "SILCSE CSE load: " << *LI << "  to: "
+                         << *Available.first << '\n');
+      LI->replaceAllUsesWith(Available.first);
+      LI->eraseFromParent();
+      return true;
+    }
+  }
+
+  AvailableLoads->insert(LI, {LI, unsigned(MemoryDefs.size())});
+  return false;
+}
+
 bool CSE::canHandle(SILInstruction *Inst) {
   if (auto *AI = dyn_cast<ApplyInst>(Inst)) {
     if (!AI->mayReadOrWriteMemory())
@@ -689,8 +789,9 @@ class SILCSE : public SILFunctionTransform {
     DominanceAnalysis* DA = getAnalysis<DominanceAnalysis>();
 
     auto *SEA = PM->getAnalysis<SideEffectAnalysis>();
+    auto *AA = PM->getAnalysis<AliasAnalysis>();
 
-    CSE C(RunsOnHighLevelSil, SEA);
+    CSE C(RunsOnHighLevelSil, SEA, AA);
     if (C.processFunction(*getFunction(), DA->get(getFunction()))) {
       invalidateAnalysis(SILAnalysis::InvalidationKind::CallsAndInstructions);
     }
@@ -650,12 +650,13 @@ bool CopyForwarding::forwardPropagateCopy(
   SILInstruction *DefDealloc = nullptr;
   if (isa<AllocStackInst>(CurrentDef)) {
     SILValue StackAddr(CurrentDef.getDef(), 0);
-    if (!StackAddr.hasOneUse()) {
+    Operand *StackAddrUse = StackAddr.getSingleUse();
+    if (!StackAddrUse) {
       DEBUG(llvm::dbgs() << "  Skipping copy" << *CopyInst
             << "  stack address has multiple uses.\n");
       return false;
     }
-    DefDealloc = StackAddr.use_begin()->getUser();
+    DefDealloc = StackAddrUse->getUser();
   }
 
   // Scan forward recording all operands that use CopyDest until we see the
@@ -0,0 +1,86 @@
+//===------- NonAtomicRC.cpp - Use non-atomic reference counting ----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "nonatomic-rc"
+#include "swift/SILPasses/Passes.h"
+#include "swift/SILPasses/Transforms.h"
+#include "swift/SILAnalysis/EscapeAnalysis.h"
+#include "swift/SIL/SILInstruction.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+
+STATISTIC(NumNonAtomicRC, "Number of reference counting instructions made "
+                          "non-atomic");
+
+using namespace swift;
+
+namespace {
+
+/// Marks strong_retain and strong_release instructions as [nonatomic] if the
+/// referenced object does not escape the current function.
+///
+/// An object which does not escape can only be reached from the thread which
+/// executes the function, so its reference count does not need to be updated
+/// with atomic read-modify-write operations. IRGen lowers such instructions to
+/// swift_nonatomic_retain and swift_nonatomic_release.
+///
+/// This pass should run late in the pipeline, because the ARC optimizations
+/// don't distinguish between atomic and non-atomic reference counting
+/// instructions.
+class NonAtomicRefCounting : public SILFunctionTransform {
+
+public:
+  NonAtomicRefCounting() {}
+
+private:
+  /// The entry point to the transformation.
+  void run() override {
+    DEBUG(llvm::dbgs() << "** NonAtomicRefCounting **\n");
+
+    auto *EA = PM->getAnalysis<EscapeAnalysis>();
+    SILFunction *F = getFunction();
+    auto *ConGraph = EA->getConnectionGraph(F);
+    if (!ConGraph)
+      return;
+
+    bool Changed = false;
+    for (auto &BB : *F) {
+      for (auto &I : BB) {
+        if (!isa<StrongRetainInst>(&I) && !isa<StrongReleaseInst>(&I))
+          continue;
+
+        auto *RCI = cast<RefCountingInst>(&I);
+        if (RCI->isNonAtomic())
+          continue;
+
+        auto *Node = ConGraph->getNode(RCI->getOperand(0), EA);
+        if (!Node || Node->escapes())
+          continue;
+
+        DEBUG(llvm::dbgs() << "    make non-atomic: " << *RCI);
+        RCI->setNonAtomic();
+        NumNonAtomicRC++;
+        Changed = true;
+      }
+    }
+    if (Changed)
+      invalidateAnalysis(SILAnalysis::InvalidationKind::Instructions);
+  }
+
+  StringRef getName() override { return "NonAtomicRefCounting"; }
+};
+
+} // end anonymous namespace
+
+SILTransform *swift::createNonAtomicRefCounting() {
+  return new NonAtomicRefCounting();
+}
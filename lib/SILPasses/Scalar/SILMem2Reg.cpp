@@ -82,6 +82,11 @@ class StackAllocationPromoter {
   /// Records the last store instruction in each block for a specific
   /// AllocStackInst.
   BlockToInstMap LastStoreInBlock;
+
+  /// The values flowing out of the blocks which getLiveOutValue() has
+  /// visited, so that each walk up the dominator tree stops at the first
+  /// block whose value is known.
+  llvm::DenseMap<SILBasicBlock *, SILValue> LiveOutValues;
 public:
   /// C'tor.
   StackAllocationPromoter(AllocStackInst *Asi, DominanceInfo *Di,
@@ -529,32 +534,50 @@ SILValue
 StackAllocationPromoter::getLiveOutValue(BlockSet &PhiBlocks,
                                          SILBasicBlock *StartBB) {
   DEBUG(llvm::dbgs() << "*** Searching for a value definition.\n");
+  // The blocks walked, which all share the value found.
+  SmallVector<SILBasicBlock *, 8> Walked;
+  SILValue Def;
+
   // Walk the Dom tree in search of a defining value:
   for (DomTreeNode *Node = DT->getNode(StartBB); Node; Node = Node->getIDom()) {
     SILBasicBlock *BB = Node->getBlock();
 
+    auto Known = LiveOutValues.find(BB);
+    if (Known != LiveOutValues.end()) {
+      Def = Known->second;
+      break;
+    }
+    Walked.push_back(BB);
+
     // If there is a store (that must come after the phi), use its value.
     BlockToInstMap::iterator it = LastStoreInBlock.find(BB);
     if (it != LastStoreInBlock.end())
       if (StoreInst *St = dyn_cast_or_null<StoreInst>(it->second)) {
         DEBUG(llvm::dbgs() << "*** Found Store def " << *St->getSrc());
-        return St->getSrc();
+        Def = St->getSrc();
+        break;
       }
 
     // If there is a Phi definition in this block:
     if (PhiBlocks.count(BB)) {
       // Return the dummy instruction that represents the new value that we will
       // add to the basic block.
-      SILValue Phi = BB->getBBArg(BB->getNumBBArg()-1);
-      DEBUG(llvm::dbgs() << "*** Found a dummy Phi def " << *Phi);
-      return Phi;
+      Def = BB->getBBArg(BB->getNumBBArg()-1);
+      DEBUG(llvm::dbgs() << "*** Found a dummy Phi def " << *Def);
+      break;
     }
 
     // Move to the next dominating block.
     DEBUG(llvm::dbgs() << "*** Walking up the iDOM.\n");
   }
-  DEBUG(llvm::dbgs() << "*** Could not find a Def. Using Undef.\n");
-  return SILUndef::get(ASI->getElementType(), ASI->getModule());
+  if (!Def) {
+    DEBUG(llvm::dbgs() << "*** Could not find a Def. Using Undef.\n");
+    Def = SILUndef::get(ASI->getElementType(), ASI->getModule());
+  }
+
+  for (SILBasicBlock *BB : Walked)
+    LiveOutValues[BB] = Def;
+  return Def;
 }
 
 SILValue
@@ -729,6 +752,13 @@ void StackAllocationPromoter::promoteAllocationToPhi() {
   // A list of nodes for which we already calculated the dominator frontier.
   llvm::SmallPtrSet<DomTreeNode *, 32> Visited;
 
+  // The nodes whose successors were already inspected. A node inspected from
+  // one root doesn't need to be inspected again from a later root, which has
+  // the same or a smaller level and thus accepts a subset of the J-edges.
+  // With this, every node is inspected once and the placement is linear in
+  // the size of the function.
+  llvm::SmallPtrSet<DomTreeNode *, 32> Explored;
+
   SmallVector<DomTreeNode *, 32> Worklist;
 
   // Scan all of the definitions in the function bottom-up using the priority
@@ -744,6 +774,7 @@ void StackAllocationPromoter::promoteAllocationToPhi() {
     // dominance frontier.
     Worklist.clear();
     Worklist.push_back(Root);
+    Explored.insert(Root);
 
     while (!Worklist.empty()) {
       DomTreeNode *Node = Worklist.pop_back_val();
@@ -785,7 +816,7 @@ void StackAllocationPromoter::promoteAllocationToPhi() {
 
       // Add the children in the dom-tree to the worklist.
       for (auto CI = Node->begin(), CE = Node->end(); CI != CE; ++CI)
-        if (!Visited.count(*CI))
+        if (Explored.insert(*CI).second)
           Worklist.push_back(*CI);
     }
   }
@@ -3257,10 +3257,10 @@ bool SimplifyCFG::simplifyArgument(SILBasicBlock *BB, unsigned i) {
     return simplifySwitchEnumToSelectEnum(BB, i, A, DT, PDT);
 
   // For now, just focus on cases where there is a single use.
-  if (!A->hasOneUse())
+  auto *Use = A->getSingleUse();
+  if (!Use)
     return false;
 
-  auto *Use = *A->use_begin();
   auto *User = cast<SILInstruction>(Use->getUser());
   if (!dyn_cast<StructExtractInst>(User) &&
       !dyn_cast<TupleExtractInst>(User))
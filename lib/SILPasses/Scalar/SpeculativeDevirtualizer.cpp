@@ -41,7 +41,17 @@ using namespace swift;
 
 // This is the limit for the number of subclasses (jump targets) that the
 // speculative devirtualizer will try to predict.
-static const int MaxNumSpeculativeTargets = 6;
+//
+// There is no receiver profile to choose the targets from: the only
+// instrumentation SILGen emits is for coverage counters, and neither IRGen nor
+// the runtime records the dynamic classes seen at a class_method site. Without
+// such a profile, the subclasses are predicted in the order in which the class
+// hierarchy analysis lists them. The limit can be lowered to keep more calls
+// virtual when most of the predictions are not taken.
+static llvm::cl::opt<unsigned> MaxNumSpeculativeTargets(
+    "sil-max-speculative-devirt-targets", llvm::cl::init(6),
+    llvm::cl::desc("The maximum number of subclasses to speculatively "
+                   "devirtualize a class method call for"));
 
 STATISTIC(NumTargetsPredicted, "Number of monomorphic functions predicted");
 
@@ -41,6 +41,13 @@ using namespace swift;
 ///    The solution to this problem is that we need native support for tail-
 ///    allocated arrays in SIL so that we can do the array buffer allocations
 ///    with alloc_ref instructions.
+///
+/// Boxes (alloc_box) which are captured by non-escaping closures are not
+/// handled here. They are promoted to alloc_stack by AllocBoxToStack, which
+/// specializes the closure to take the address instead of the box.
+/// The context of a partial_apply itself is always allocated on the heap by
+/// IRGen. Promoting it would need a stack-allocated form of partial_apply in
+/// SIL and the corresponding lowering in IRGen.
 class StackPromoter {
 
   // Some analysis we need.
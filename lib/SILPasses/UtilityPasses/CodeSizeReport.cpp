@@ -0,0 +1,341 @@
+//===--- CodeSizeReport.cpp - Code size per function and origin -----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// The SIL side of the report is collected by InstCount.cpp. This file adds
+// the sizes from the object file and sums them up per source declaration.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/SILPasses/CodeSizeReport.h"
+#include "swift/AST/ASTContext.h"
+#include "swift/AST/Decl.h"
+#include "swift/AST/Expr.h"
+#include "swift/AST/Module.h"
+#include "swift/Basic/JSONSerialization.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace swift;
+
+namespace {
+  /// The JSON form of a CodeSizeReport::InlinedCallee.
+  struct InlinedOutput {
+    std::string Name;
+    std::string Origin;
+    uint64_t Instructions;
+  };
+
+  /// The JSON form of a CodeSizeReport::Function.
+  struct FunctionOutput {
+    std::string Name;
+    std::string Kind;
+    std::string Origin;
+    std::string Location;
+    uint64_t Instructions;
+    uint64_t MachineCodeSize;
+    std::vector<InlinedOutput> Inlined;
+  };
+
+  /// The functions generated for one source declaration.
+  struct OriginOutput {
+    std::string Origin;
+    std::string Location;
+    uint64_t Functions = 0;
+    uint64_t Instructions = 0;
+    uint64_t InlinedInstructions = 0;
+    uint64_t MachineCodeSize = 0;
+  };
+
+  /// The functions of one kind.
+  struct KindOutput {
+    uint64_t Functions = 0;
+    uint64_t Instructions = 0;
+    uint64_t MachineCodeSize = 0;
+  };
+
+  using KindOutputs = std::vector<std::pair<std::string, KindOutput>>;
+
+  struct ReportOutput {
+    std::string ObjectFile;
+    KindOutputs Kinds;
+    std::vector<OriginOutput> Origins;
+    std::vector<FunctionOutput> Functions;
+  };
+} // end anonymous namespace
+
+namespace swift {
+namespace json {
+  template<typename T>
+  struct ArrayTraits<std::vector<T>> {
+    static size_t size(Output &out, std::vector<T> &seq) {
+      return seq.size();
+    }
+
+    static T &element(Output &out, std::vector<T> &seq, size_t index) {
+      if (index >= seq.size())
+        seq.resize(index+1);
+      return seq[index];
+    }
+  };
+
+  template<>
+  struct ObjectTraits<InlinedOutput> {
+    static void mapping(Output &out, InlinedOutput &callee) {
+      out.mapRequired("name", callee.Name);
+      out.mapRequired("origin", callee.Origin);
+      out.mapRequired("sil_instructions", callee.Instructions);
+    }
+  };
+
+  template<>
+  struct ObjectTraits<FunctionOutput> {
+    static void mapping(Output &out, FunctionOutput &function) {
+      out.mapRequired("name", function.Name);
+      out.mapRequired("kind", function.Kind);
+      out.mapRequired("origin", function.Origin);
+      out.mapRequired("location", function.Location);
+      out.mapRequired("sil_instructions", function.Instructions);
+      out.mapRequired("machine_code_size", function.MachineCodeSize);
+      out.mapRequired("inlined", function.Inlined);
+    }
+  };
+
+  template<>
+  struct ObjectTraits<OriginOutput> {
+    static void mapping(Output &out, OriginOutput &origin) {
+      out.mapRequired("origin", origin.Origin);
+      out.mapRequired("location", origin.Location);
+      out.mapRequired("functions", origin.Functions);
+      out.mapRequired("sil_instructions", origin.Instructions);
+      out.mapRequired("inlined_instructions", origin.InlinedInstructions);
+      out.mapRequired("machine_code_size", origin.MachineCodeSize);
+    }
+  };
+
+  template<>
+  struct ObjectTraits<KindOutput> {
+    static void mapping(Output &out, KindOutput &kind) {
+      out.mapRequired("functions", kind.Functions);
+      out.mapRequired("sil_instructions", kind.Instructions);
+      out.mapRequired("machine_code_size", kind.MachineCodeSize);
+    }
+  };
+
+  /// Writes the kinds as an object with one key per kind.
+  template<>
+  struct ObjectTraits<KindOutputs> {
+    static void mapping(Output &out, KindOutputs &kinds) {
+      for (auto &kind : kinds)
+        out.mapRequired(kind.first.c_str(), kind.second);
+    }
+  };
+
+  template<>
+  struct ObjectTraits<ReportOutput> {
+    static void mapping(Output &out, ReportOutput &report) {
+      out.mapRequired("object_file", report.ObjectFile);
+      out.mapRequired("kinds", report.Kinds);
+      out.mapRequired("origins", report.Origins);
+      out.mapRequired("functions", report.Functions);
+    }
+  };
+} // end namespace json
+} // end namespace swift
+
+StringRef CodeSizeReport::getKindName(FunctionKind Kind) {
+  switch (Kind) {
+  case FunctionKind::Function: return "function";
+  case FunctionKind::Closure: return "closure";
+  case FunctionKind::GenericSpecialization: return "generic_specialization";
+  case FunctionKind::SignatureSpecialization: return "signature_specialization";
+  case FunctionKind::WitnessThunk: return "witness_thunk";
+  case FunctionKind::ReabstractionThunk: return "reabstraction_thunk";
+  case FunctionKind::Thunk: return "thunk";
+  case FunctionKind::IRGen: return "irgen";
+  }
+  llvm_unreachable("bad function kind");
+}
+
+void CodeSizeReport::setMachineCodeSize(StringRef Symbol, uint64_t Size) {
+  auto found = FunctionsByName.find(Symbol);
+  if (found != FunctionsByName.end()) {
+    Functions[found->second].MachineCodeSize = Size;
+    return;
+  }
+
+  FunctionsByName[Symbol] = Functions.size();
+  Functions.emplace_back();
+  Functions.back().Name = Symbol.str();
+  Functions.back().Kind = FunctionKind::IRGen;
+  Functions.back().MachineCodeSize = Size;
+}
+
+/// Returns the outermost function or closure that the function or closure
+/// \p DC is nested in, which is the declaration that closures and local
+/// functions are summed up under.
+static const DeclContext *getSourceDecl(const DeclContext *DC) {
+  while (const DeclContext *Parent = DC->getParent()) {
+    if (!isa<AbstractFunctionDecl>(Parent) && !isa<AbstractClosureExpr>(Parent))
+      break;
+    DC = Parent;
+  }
+  return DC;
+}
+
+/// Returns the qualified name of the function or closure \p DC, such as
+/// "Swift.Array.append(_:)".
+static std::string getOriginName(const DeclContext *DC) {
+  std::string Name;
+  llvm::raw_string_ostream os(Name);
+  if (auto *ACE = dyn_cast<AbstractClosureExpr>(DC)) {
+    os << "closure in ";
+    const DeclContext *Source = getSourceDecl(ACE);
+    if (Source == ACE) {
+      os << ACE->getParentModule()->getName();
+      return os.str();
+    }
+    DC = Source;
+  }
+
+  auto *AFD = cast<AbstractFunctionDecl>(DC);
+  os << AFD->getModuleContext()->getName() << ".";
+  if (auto *Nominal =
+        AFD->getDeclContext()->isNominalTypeOrNominalTypeExtensionContext())
+    os << Nominal->getName() << ".";
+  os << AFD->getFullName();
+  return os.str();
+}
+
+/// Returns the source location of the function or closure \p DC, or an empty
+/// string if it wasn't parsed from source, such as a function from another
+/// module.
+static std::string getOriginLocation(const DeclContext *DC) {
+  SourceLoc Loc;
+  if (auto *AFD = dyn_cast<AbstractFunctionDecl>(DC))
+    Loc = AFD->getLoc();
+  else
+    Loc = cast<AbstractClosureExpr>(DC)->getLoc();
+  if (Loc.isInvalid())
+    return std::string();
+
+  std::string Location;
+  llvm::raw_string_ostream os(Location);
+  Loc.print(os, DC->getASTContext().SourceMgr);
+  return os.str();
+}
+
+void CodeSizeReport::write(raw_ostream &os) const {
+  ReportOutput report;
+  report.ObjectFile = ObjectFile;
+
+  // Functions without a source are their own origin.
+  llvm::DenseMap<const DeclContext *, unsigned> originsByDecl;
+  llvm::StringMap<unsigned> originsByName;
+  auto getOrigin = [&](const DeclContext *DC,
+                       StringRef Symbol) -> OriginOutput & {
+    unsigned index = report.Origins.size();
+    bool inserted;
+    if (DC) {
+      DC = getSourceDecl(DC);
+      auto result = originsByDecl.insert({DC, index});
+      index = result.first->second;
+      inserted = result.second;
+    } else {
+      auto result = originsByName.insert({Symbol, index});
+      index = result.first->second;
+      inserted = result.second;
+    }
+    if (inserted) {
+      report.Origins.emplace_back();
+      report.Origins.back().Origin = DC ? getOriginName(DC) : Symbol.str();
+      if (DC)
+        report.Origins.back().Location = getOriginLocation(DC);
+    }
+    return report.Origins[index];
+  };
+
+  for (const Function &function : Functions) {
+    StringRef kindName = getKindName(function.Kind);
+    auto kind = std::find_if(report.Kinds.begin(), report.Kinds.end(),
+                             [&](const std::pair<std::string, KindOutput> &k) {
+      return k.first == kindName;
+    });
+    if (kind == report.Kinds.end()) {
+      report.Kinds.push_back({kindName.str(), KindOutput()});
+      kind = report.Kinds.end() - 1;
+    }
+    kind->second.Functions += 1;
+    kind->second.Instructions += function.Instructions;
+    kind->second.MachineCodeSize += function.MachineCodeSize;
+
+    OriginOutput &origin = getOrigin(function.Origin, function.Name);
+    origin.Functions += 1;
+    origin.Instructions += function.Instructions;
+    origin.MachineCodeSize += function.MachineCodeSize;
+
+    FunctionOutput output;
+    output.Name = function.Name;
+    output.Kind = kindName.str();
+    if (function.Origin) {
+      output.Origin = getOriginName(function.Origin);
+      output.Location = getOriginLocation(function.Origin);
+    }
+    output.Instructions = function.Instructions;
+    output.MachineCodeSize = function.MachineCodeSize;
+    for (const InlinedCallee &callee : function.Inlined) {
+      getOrigin(callee.Origin, callee.Name).InlinedInstructions +=
+        callee.Instructions;
+      output.Inlined.push_back({
+        callee.Name, callee.Origin ? getOriginName(callee.Origin) : "",
+        callee.Instructions
+      });
+    }
+    report.Functions.push_back(std::move(output));
+  }
+
+  // Put the biggest contributors first. Sizes from the object file win over
+  // instruction counts, which are all there is without one.
+  auto isBigger = [](uint64_t lhsSize, uint64_t lhsInstructions,
+                     uint64_t rhsSize, uint64_t rhsInstructions) {
+    if (lhsSize != rhsSize)
+      return lhsSize > rhsSize;
+    return lhsInstructions > rhsInstructions;
+  };
+  std::stable_sort(report.Origins.begin(), report.Origins.end(),
+                   [&](const OriginOutput &lhs, const OriginOutput &rhs) {
+    return isBigger(lhs.MachineCodeSize,
+                    lhs.Instructions + lhs.InlinedInstructions,
+                    rhs.MachineCodeSize,
+                    rhs.Instructions + rhs.InlinedInstructions);
+  });
+  std::stable_sort(report.Functions.begin(), report.Functions.end(),
+                   [&](const FunctionOutput &lhs, const FunctionOutput &rhs) {
+    return isBigger(lhs.MachineCodeSize, lhs.Instructions,
+                    rhs.MachineCodeSize, rhs.Instructions);
+  });
+
+  json::Output out(os);
+  out << report;
+  os << "\n";
+}
+
+std::error_code CodeSizeReport::writeToFile(StringRef Path) const {
+  std::error_code EC;
+  llvm::raw_fd_ostream out(Path, EC, llvm::sys::fs::F_None);
+  if (EC)
+    return EC;
+  write(out);
+  return std::error_code();
+}
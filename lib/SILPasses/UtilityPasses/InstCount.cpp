@@ -15,11 +15,16 @@
 //===----------------------------------------------------------------------===//
 
 #define DEBUG_TYPE "sil-instcount"
+#include "swift/SILPasses/CodeSizeReport.h"
 #include "swift/SILPasses/Passes.h"
 #include "swift/SILPasses/PassManager.h"
 #include "swift/SILPasses/Transforms.h"
+#include "swift/AST/Decl.h"
+#include "swift/AST/Expr.h"
+#include "swift/SIL/SILDebugScope.h"
 #include "swift/SIL/SILModule.h"
 #include "swift/SIL/SILVisitor.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Statistic.h"
 
 using namespace swift;
@@ -163,3 +168,75 @@ void swift::performSILInstCount(SILModule *M) {
   PrinterPM.addInstCount();
   PrinterPM.runOneIteration();
 }
+
+//===----------------------------------------------------------------------===//
+//                              Code Size Report
+//===----------------------------------------------------------------------===//
+
+/// Classifies \p F by how it was generated. The outermost part of the name of
+/// a specialization of a specialization says how it was generated last.
+static CodeSizeReport::FunctionKind getFunctionKind(SILFunction *F) {
+  using FunctionKind = CodeSizeReport::FunctionKind;
+  StringRef Name = F->getName();
+  if (Name.startswith("_TTSg"))
+    return FunctionKind::GenericSpecialization;
+  if (Name.startswith("_TTSf"))
+    return FunctionKind::SignatureSpecialization;
+  if (Name.startswith("_TTW"))
+    return FunctionKind::WitnessThunk;
+  if (F->isThunk() == IsReabstractionThunk || Name.startswith("_TTR"))
+    return FunctionKind::ReabstractionThunk;
+  if (F->isThunk())
+    return FunctionKind::Thunk;
+
+  const DeclContext *DC = F->getDeclContext();
+  if (DC && (isa<AbstractClosureExpr>(DC) ||
+             (DC->getParent() && DC->getParent()->isLocalContext())))
+    return FunctionKind::Closure;
+  return FunctionKind::Function;
+}
+
+/// Returns the function or closure in the source which \p F was generated
+/// for, or null if there is none.
+static const DeclContext *getOrigin(SILFunction *F) {
+  const DeclContext *DC = F->getDeclContext();
+  // Witness thunks have no context, but are located at the witness.
+  if (!DC && F->hasLocation())
+    DC = F->getLocation().getAsASTNode<AbstractFunctionDecl>();
+  if (DC && (isa<AbstractFunctionDecl>(DC) || isa<AbstractClosureExpr>(DC)))
+    return DC;
+  return nullptr;
+}
+
+void CodeSizeReport::addSILModule(SILModule &M) {
+  for (SILFunction &F : M) {
+    if (F.empty())
+      continue;
+
+    Function Entry;
+    Entry.Name = F.getName().str();
+    Entry.Kind = getFunctionKind(&F);
+    Entry.Origin = getOrigin(&F);
+
+    // Attribute each inlined instruction to the innermost function it was
+    // inlined from, whose scope is kept even if the function was deleted.
+    llvm::SmallDenseMap<SILFunction *, unsigned, 8> InlinedCounts;
+    std::vector<SILFunction *> InlinedOrder;
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        ++Entry.Instructions;
+        const SILDebugScope *DS = I.getDebugScope();
+        if (!DS || !DS->InlinedCallSite || !DS->SILFn || DS->SILFn == &F)
+          continue;
+        if (InlinedCounts[DS->SILFn]++ == 0)
+          InlinedOrder.push_back(DS->SILFn);
+      }
+    }
+    for (SILFunction *Callee : InlinedOrder)
+      Entry.Inlined.push_back({Callee->getName().str(), getOrigin(Callee),
+                               InlinedCounts[Callee]});
+
+    FunctionsByName[Entry.Name] = Functions.size();
+    Functions.push_back(std::move(Entry));
+  }
+}
@@ -169,8 +169,8 @@ SILBasicBlock *replaceSwitchDest(SwitchEnumTy *S,
     return DefaultBB;
 }
 
-void swift::changeBranchTarget(TermInst *T, unsigned EdgeIdx,
-                               SILBasicBlock *NewDest, bool PreserveArgs) {
+static void changeBranchTargetImpl(TermInst *T, unsigned EdgeIdx,
+                                   SILBasicBlock *NewDest, bool PreserveArgs) {
   SILBuilderWithScope B(T);
 
   switch (T->getKind()) {
@@ -322,14 +322,8 @@ SILBasicBlock *replaceSwitchDest(SwitchEnumTy *S,
     return DefaultBB;
 }
 
-/// \brief Replace a branch target.
-///
-/// \param T The terminating instruction to modify.
-/// \param OldDest The successor block that will be replaced.
-/// \param NewDest The new target block.
-/// \param PreserveArgs If set, preserve arguments on the replaced edge.
-void swift::replaceBranchTarget(TermInst *T, SILBasicBlock *OldDest,
-                               SILBasicBlock *NewDest, bool PreserveArgs) {
+static void replaceBranchTargetImpl(TermInst *T, SILBasicBlock *OldDest,
+                                    SILBasicBlock *NewDest, bool PreserveArgs) {
   SILBuilderWithScope B(T);
 
   switch (T->getKind()) {
@@ -450,6 +444,46 @@ void swift::replaceBranchTarget(TermInst *T, SILBasicBlock *OldDest,
 }
 
 /// \brief Check if the edge from the terminator is critical.
+/// Updates \p DT after an edge from \p BB to \p OldDest was redirected to
+/// \p NewDest.
+static void updateDominatorsForNewTarget(SILBasicBlock *BB,
+                                         SILBasicBlock *OldDest,
+                                         SILBasicBlock *NewDest,
+                                         DominanceInfo *DT) {
+  if (!DT || OldDest == NewDest)
+    return;
+  auto Succs = BB->getSuccessors();
+  if (std::none_of(Succs.begin(), Succs.end(), [&](const SILSuccessor &Succ) {
+        return Succ.getBB() == OldDest;
+      }))
+    DT->deleteEdge(BB, OldDest);
+  DT->insertEdge(BB, NewDest);
+}
+
+void swift::changeBranchTarget(TermInst *T, unsigned EdgeIdx,
+                               SILBasicBlock *NewDest, bool PreserveArgs,
+                               DominanceInfo *DT) {
+  SILBasicBlock *BB = T->getParent();
+  SILBasicBlock *OldDest = T->getSuccessors()[EdgeIdx];
+  changeBranchTargetImpl(T, EdgeIdx, NewDest, PreserveArgs);
+  updateDominatorsForNewTarget(BB, OldDest, NewDest, DT);
+}
+
+/// \brief Replace a branch target.
+///
+/// \param T The terminating instruction to modify.
+/// \param OldDest The successor block that will be replaced.
+/// \param NewDest The new target block.
+/// \param PreserveArgs If set, preserve arguments on the replaced edge.
+/// \param DT If non-null, the dominator tree to update.
+void swift::replaceBranchTarget(TermInst *T, SILBasicBlock *OldDest,
+                                SILBasicBlock *NewDest, bool PreserveArgs,
+                                DominanceInfo *DT) {
+  SILBasicBlock *BB = T->getParent();
+  replaceBranchTargetImpl(T, OldDest, NewDest, PreserveArgs);
+  updateDominatorsForNewTarget(BB, OldDest, NewDest, DT);
+}
+
 bool swift::isCriticalEdge(TermInst *T, unsigned EdgeIdx) {
   assert(T->getSuccessors().size() > EdgeIdx && "Not enough successors");
 
@@ -752,24 +786,14 @@ bool swift::mergeBasicBlockWithSuccessor(SILBasicBlock *BB, DominanceInfo *DT,
   // Move the instruction from the successor block to the current block.
   BB->spliceAtEnd(SuccBB);
 
-  if (DT)
-    if (auto *SuccBBNode = DT->getNode(SuccBB)) {
-      // Change the immediate dominator for children of the successor to be the
-      // current block.
-      auto *BBNode = DT->getNode(BB);
-      SmallVector<DominanceInfoNode *, 8> Children(SuccBBNode->begin(),
-                                                   SuccBBNode->end());
-      for (auto *ChildNode : *SuccBBNode)
-        DT->changeImmediateDominator(ChildNode, BBNode);
-
-      DT->eraseNode(SuccBB);
-    }
-
   if (LI)
     LI->removeBlock(SuccBB);
 
   SuccBB->eraseFromParent();
 
+  if (DT)
+    DT->mergeBlocks(BB, SuccBB);
+
   return true;
 }
 
@@ -230,9 +230,18 @@ SILFunction *swift::getExistingSpecialization(SILModule &M,
   return Specialization;
 }
 
+/// Returns the number of instructions in \p F.
+static unsigned getFunctionSize(SILFunction *F) {
+  unsigned Size = 0;
+  for (auto &BB : *F)
+    Size += std::distance(BB.begin(), BB.end());
+  return Size;
+}
+
 ApplySite swift::trySpecializeApplyOfGeneric(ApplySite Apply,
                                              SILFunction *&NewFunction,
-                                             CloneCollector &Collector) {
+                                             CloneCollector &Collector,
+                                             unsigned *SizeBudget) {
   NewFunction = nullptr;
 
   assert(Apply.hasSubstitutions() && "Expected an apply with substitutions!");
@@ -302,6 +311,20 @@ ApplySite swift::trySpecializeApplyOfGeneric(ApplySite Apply,
     if (M.getOptions().Optimization <= SILOptions::SILOptMode::None)
       return ApplySite();
 
+    // Respect the code size budget of the caller.
+    if (SizeBudget) {
+      unsigned Size = getFunctionSize(F);
+      if (Size > *SizeBudget) {
+        DEBUG(llvm::dbgs() << "    Not specializing: " << Size
+                           << " instructions exceed the remaining budget of "
+                           << *SizeBudget << ".\n");
+        return ApplySite();
+      }
+      *SizeBudget -= Size;
+      DEBUG(llvm::dbgs() << "    Specializing " << Size << " instructions, "
+                         << *SizeBudget << " left in the budget.\n");
+    }
+
     DEBUG(
       if (M.getOptions().Optimization <= SILOptions::SILOptMode::Debug) {
         llvm::dbgs() << "Creating a specialization: " << ClonedName << "\n"; });
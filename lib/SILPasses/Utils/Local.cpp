@@ -2275,6 +2275,16 @@ swift::analyzeStaticInitializer(SILValue V,
           return false;
       }
       return true;
+    } if (auto *EI = dyn_cast<EnumInst>(I)) {
+      // If it is not an enum which is a simple type, bail.
+      if (!isSimpleType(EI->getType(), I->getModule()))
+        return false;
+      if (!EI->hasOperand())
+        return true;
+      I = dyn_cast<SILInstruction>(EI->getOperand());
+      if (!I)
+        return false;
+      continue;
     } else {
       if (auto *bi = dyn_cast<BuiltinInst>(I)) {
         switch (bi->getBuiltinInfo().ID) {
@@ -18,6 +18,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include <algorithm>
 #include <memory>
 #include <tuple>
 using namespace swift;
@@ -251,6 +252,70 @@ void ConstraintSystem::applySolution(const Solution &solution) {
   Fixes.append(solution.Fixes.begin(), solution.Fixes.end());
 }
 
+Solution ConstraintSystem::extractComponentSolution(
+           const Solution &solution,
+           const llvm::SmallPtrSetImpl<TypeVariableType *> &otherTypeVars) {
+  Solution result(*this, solution.getFixedScore());
+
+  for (auto binding : solution.typeBindings) {
+    if (!otherTypeVars.count(binding.first))
+      result.typeBindings.insert(binding);
+  }
+
+  // Leave out the overload choices, restrictions, disjunction choices and
+  // opened types which were made before the component was split off.
+  llvm::SmallPtrSet<ConstraintLocator *, 4> resolvedLocators;
+  for (auto resolved = resolvedOverloadSets;
+       resolved; resolved = resolved->Previous)
+    resolvedLocators.insert(resolved->Locator);
+  for (auto overload : solution.overloadChoices) {
+    if (!resolvedLocators.count(overload.first))
+      result.overloadChoices.insert(overload);
+  }
+
+  llvm::SmallDenseMap<std::pair<CanType, CanType>, ConversionRestrictionKind>
+    knownRestrictions;
+  for (auto &restriction : ConstraintRestrictions) {
+    using std::get;
+    CanType first = simplifyType(get<0>(restriction))->getCanonicalType();
+    CanType second = simplifyType(get<1>(restriction))->getCanonicalType();
+    knownRestrictions[{first, second}] = get<2>(restriction);
+  }
+  for (auto restriction : solution.ConstraintRestrictions) {
+    if (!knownRestrictions.count(restriction.first))
+      result.ConstraintRestrictions.insert(restriction);
+  }
+
+  // The fixes are already only those made while solving the component.
+  result.Fixes = solution.Fixes;
+
+  llvm::SmallPtrSet<ConstraintLocator *, 4> knownLocators;
+  for (auto &choice : DisjunctionChoices)
+    knownLocators.insert(choice.first);
+  for (auto &choice : solution.DisjunctionChoices) {
+    if (!knownLocators.count(choice.first))
+      result.DisjunctionChoices.insert(choice);
+  }
+
+  knownLocators.clear();
+  for (const auto &opened : OpenedTypes)
+    knownLocators.insert(opened.first);
+  for (const auto &opened : solution.OpenedTypes) {
+    if (!knownLocators.count(opened.first))
+      result.OpenedTypes.insert(opened);
+  }
+
+  knownLocators.clear();
+  for (const auto &openedExistential : OpenedExistentialTypes)
+    knownLocators.insert(openedExistential.first);
+  for (const auto &openedExistential : solution.OpenedExistentialTypes) {
+    if (!knownLocators.count(openedExistential.first))
+      result.OpenedExistentialTypes.insert(openedExistential);
+  }
+
+  return std::move(result);
+}
+
 /// \brief Restore the type variable bindings to what they were before
 /// we attempted to solve this constraint system.
 void ConstraintSystem::restoreTypeVariableBindings(unsigned numBindings) {
@@ -389,6 +454,17 @@ void truncate(SmallVectorImpl<T> &vec, unsigned newSize) {
 
 } // end anonymous namespace
 
+ExpressionTimer::ExpressionTimer(Expr *E, TypeChecker &TC)
+  : Loc(E->getLoc()), TC(TC) {}
+
+ExpressionTimer::~ExpressionTimer() {
+  if (!TC.getDebugTimeExpressions())
+    return;
+
+  TC.recordExpressionTiming({Loc, getElapsedTime(), NumStatesExplored,
+                             NumDisjunctions, SolverMemory});
+}
+
 ConstraintSystem::SolverState::SolverState(ConstraintSystem &cs) : CS(cs) {
   ++NumSolutionAttempts;
   SolutionAttempt = NumSolutionAttempts;
@@ -412,6 +488,14 @@ ConstraintSystem::SolverState::~SolverState() {
   LangOptions &langOpts = CS.getTypeChecker().Context.LangOpts;
   langOpts.DebugConstraintSolver = OldDebugConstraintSolver;
 
+  // Charge this attempt to the expression being timed.
+  if (auto timer = CS.Timer) {
+    timer->NumStatesExplored += NumStatesExplored;
+    timer->NumDisjunctions += NumDisjunctions;
+    timer->SolverMemory = std::max(timer->SolverMemory,
+                                   CS.getASTContext().getSolverMemory());
+  }
+
   // Write our local statistics back to the overall statistics.
   #define CS_STATISTIC(Name, Description) JOIN2(Overall,Name) += Name;
   #include "ConstraintSolverStats.def"
@@ -1032,6 +1116,10 @@ static bool tryTypeVariableBindings(
     return true;
   }
 
+  // Likewise if it has spent too long on this expression.
+  if (cs.getExpressionTooComplex())
+    return true;
+
   for (unsigned tryCount = 0; !anySolved && !bindings.empty(); ++tryCount) {
     // Try each of the bindings in turn.
     ++cs.solverState->NumTypeVariableBindings;
@@ -1317,29 +1405,93 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
     // substituted all of those other type variables through.
     llvm::SmallVector<TypeVariableType *, 16> allTypeVariables 
       = std::move(TypeVariables);
+    llvm::SmallPtrSet<TypeVariableType *, 16> otherTypeVars;
     for (auto typeVar : allTypeVariables) {
       auto known = typeVarComponent.find(typeVar);
+      if (known == typeVarComponent.end() || known->second != component)
+        otherTypeVars.insert(typeVar);
       if (known != typeVarComponent.end() && known->second != component)
         continue;
 
       TypeVariables.push_back(typeVar);
     }
-    
+
+    // Identify the component by its constraints and the current bindings of
+    // its type variables. If a different choice in an enclosing disjunction
+    // produced the same component, its solutions can be reused.
+    std::vector<void *> cacheKey;
+    for (auto &constraint : InactiveConstraints)
+      cacheKey.push_back(&constraint);
+    std::sort(cacheKey.begin(), cacheKey.end());
+    cacheKey.push_back(nullptr);
+    for (unsigned i = 0, n = typeVars.size(); i != n; ++i) {
+      if (components[i] != component)
+        continue;
+      cacheKey.push_back(typeVars[i]);
+      cacheKey.push_back(simplifyType(typeVars[i]).getPointer());
+    }
+
+    // The solutions found depend on which ones were pruned, so an entry can
+    // only be used if nothing was pruned or the scores are the same.
+    auto &cache = solverState->ComponentCache;
+    auto cached = cache.find(cacheKey);
+    if (cached != cache.end() && cached->second.BestScore &&
+        (cached->second.PreviousScore != CurrentScore ||
+         !solverState->BestScore ||
+         *cached->second.BestScore != *solverState->BestScore))
+      cached = cache.end();
+
     // Solve for this component. If it fails, we're done.
     bool failed;
     if (TC.getLangOpts().DebugConstraintSolver) {
       auto &log = getASTContext().TypeCheckerDebug->getStream();
       log.indent(solverState->depth * 2) << "(solving component #" 
-                                         << component << "\n";
+                                         << component;
+      if (cached != cache.end())
+        log << " from cache";
+      log << "\n";
     }
-    {
-      // Introduce a scope for this partial solution.
-      SolverScope scope(*this);
-      llvm::SaveAndRestore<SolverScope *> 
-        partialSolutionScope(solverState->PartialSolutionScope, &scope);
-
-      failed = solveSimplified(partialSolutions[component], 
-                               allowFreeTypeVariables);
+    if (cached != cache.end()) {
+      ++solverState->NumComponentCacheHits;
+      for (auto &solution : cached->second.Solutions) {
+        partialSolutions[component].push_back(
+          extractComponentSolution(solution, otherTypeVars));
+      }
+      failed = partialSolutions[component].empty();
+    } else {
+      {
+        // Introduce a scope for this partial solution.
+        SolverScope scope(*this);
+        llvm::SaveAndRestore<SolverScope *> 
+          partialSolutionScope(solverState->PartialSolutionScope, &scope);
+
+        failed = solveSimplified(partialSolutions[component], 
+                                 allowFreeTypeVariables);
+      }
+
+      // For each of the partial solutions, substract off the current score.
+      // It doesn't contribute.
+      for (auto &solution : partialSolutions[component])
+        solution.getFixedScore() -= CurrentScore;
+
+      // Remember what was decided for this component, unless solving it was
+      // cut short.
+      if (!getExpressionTooComplex()) {
+        SolverState::CachedComponent entry;
+        entry.PreviousScore = CurrentScore;
+        entry.BestScore = PreviousBestScore;
+        if (!failed) {
+          for (auto &solution : partialSolutions[component]) {
+            entry.Solutions.push_back(
+              extractComponentSolution(solution, otherTypeVars));
+          }
+        }
+        auto inserted = cache.insert({std::move(cacheKey),
+                                      SolverState::CachedComponent()});
+        // Prefer an entry for which nothing was pruned.
+        if (inserted.second || inserted.first->second.BestScore)
+          inserted.first->second = std::move(entry);
+      }
     }
 
     // Put the constraints back into their original bucket.
@@ -1370,11 +1522,6 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
     // ready for the next component.
     TypeVariables = std::move(allTypeVariables);
 
-    // For each of the partial solutions, substract off the current score.
-    // It doesn't contribute.
-    for (auto &solution : partialSolutions[component])
-      solution.getFixedScore() -= CurrentScore;
-
     // Restore the previous best score.
     solverState->BestScore = PreviousBestScore;
   }
@@ -1397,16 +1544,32 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
     }
   }
 
-  // Produce all combinations of partial solutions.
-  SmallVector<unsigned, 2> indices(numComponents, 0);
+  // Apply the partial solutions of the components which have a single best
+  // solution once, rather than once per combination.
+  SolverScope scope(*this);
+  SmallVector<unsigned, 2> ambiguousComponents;
+  for (unsigned component = 0; component != numComponents; ++component) {
+    if (partialSolutions[component].size() == 1)
+      applySolution(partialSolutions[component][0]);
+    else
+      ambiguousComponents.push_back(component);
+  }
+
+  // Partial solutions never lower the score, so if these alone are worse than
+  // the best solution found so far, so is every combination.
+  if (worseThanBestSolution())
+    return true;
+
+  // Produce all combinations of the remaining partial solutions.
+  SmallVector<unsigned, 2> indices(ambiguousComponents.size(), 0);
   bool done = false;
   bool anySolutions = false;
   do {
-    // Create a new solver scope in which we apply all of the partial
+    // Create a new solver scope in which we apply the chosen partial
     // solutions.
-    SolverScope scope(*this);
-    for (unsigned i = 0; i != numComponents; ++i)
-      applySolution(partialSolutions[i][indices[i]]);
+    SolverScope combinationScope(*this);
+    for (unsigned i = 0, n = ambiguousComponents.size(); i != n; ++i)
+      applySolution(partialSolutions[ambiguousComponents[i]][indices[i]]);
 
     // This solution might be worse than the best solution found so far. If so,
     // skip it.
@@ -1425,23 +1588,17 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
       anySolutions = true;
     }
     
-    // Find the next combination.
-    for (unsigned n = numComponents; n > 0; --n) {
-      ++indices[n-1];
-
-      // If we haven't run out of solutions yet, we're done.
-      if (indices[n-1] < partialSolutions[n-1].size())
+    // Find the next combination. If we ran out of solutions at every
+    // position, we're done.
+    done = true;
+    for (unsigned n = ambiguousComponents.size(); n > 0; --n) {
+      if (++indices[n-1] < partialSolutions[ambiguousComponents[n-1]].size()) {
+        done = false;
         break;
+      }
 
-      // If we ran out of solutions at the first position, we're done.
-      if (n == 1) {
-        done = true;
-        break;
-      } 
-
-      // Zero out the indices from here to the end.
-      for (unsigned i = n-1; i != numComponents; ++i)
-        indices[i] = 0;
+      // Zero out this index and move on to the previous one.
+      indices[n-1] = 0;
     }
   } while (!done);
 
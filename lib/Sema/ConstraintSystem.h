@@ -36,8 +36,11 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
+#include <chrono>
 #include <cstddef>
 #include <functional>
+#include <map>
+#include <vector>
 
 namespace swift {
 
@@ -1129,6 +1132,32 @@ struct MemberLookupResult {
 };
   
   
+/// Measures the time and solver work spent type-checking an expression, for
+/// -debug-time-expression-type-checking and -solver-expression-time-threshold.
+class ExpressionTimer {
+  SourceLoc Loc;
+  TypeChecker &TC;
+  std::chrono::steady_clock::time_point StartTime
+    = std::chrono::steady_clock::now();
+
+public:
+  unsigned NumStatesExplored = 0;
+  unsigned NumDisjunctions = 0;
+  size_t SolverMemory = 0;
+
+  ExpressionTimer(Expr *E, TypeChecker &TC);
+  ~ExpressionTimer();
+
+  ExpressionTimer(const ExpressionTimer &) = delete;
+  ExpressionTimer &operator=(const ExpressionTimer &) = delete;
+
+  /// Returns the wall time spent so far, in seconds.
+  double getElapsedTime() const {
+    return std::chrono::duration<double>(
+             std::chrono::steady_clock::now() - StartTime).count();
+  }
+};
+
 /// \brief Describes a system of constraints on type variables, the
 /// solution of which assigns concrete types to each of the type variables.
 /// Constraint systems are typically generated given an (untyped) expression.
@@ -1166,7 +1195,7 @@ private:
   unsigned TypeCounter = 0;
   
   /// \brief The expression being solved has exceeded the solver's memory
-  /// threshold.
+  /// or time threshold.
   bool expressionExceededThreshold = false;
 
   /// \brief Cached member lookups.
@@ -1297,6 +1326,29 @@ private:
     /// Refers to the innermost partial solution scope.
     SolverScope *PartialSolutionScope = nullptr;
 
+    /// The partial solutions computed for a connected component of the
+    /// constraint graph.
+    struct CachedComponent {
+      /// The score when the component was solved.
+      Score PreviousScore;
+
+      /// The best score when the component was solved. Solutions were only
+      /// pruned if there was one.
+      Optional<Score> BestScore;
+
+      /// The solutions for the component, holding only what was decided
+      /// while solving it. Empty if the component could not be solved.
+      SmallVector<Solution, 4> Solutions;
+    };
+
+    /// Partial solutions for connected components, so that a component
+    /// which is left unchanged by the choice made in a disjunction is only
+    /// solved once across the disjunction's branches.
+    ///
+    /// The key is the component's constraints followed by each of its type
+    /// variables and what that type variable currently simplifies to.
+    std::map<std::vector<void *>, CachedComponent> ComponentCache;
+
     // Statistics
     #define CS_STATISTIC(Name, Description) unsigned Name = 0;
     #include "ConstraintSolverStats.def"
@@ -1310,6 +1362,10 @@ public:
   /// we're exploring. 
   SolverState *solverState = nullptr;
 
+  /// Measures the work spent on the expression being solved, if it is being
+  /// timed.
+  ExpressionTimer *Timer = nullptr;
+
   /// A mapping from the constraint locators for references to various
   /// names (e.g., member references, normal name references, possible
   /// constructions) to the argument labels provided in the call to
@@ -2297,6 +2353,18 @@ private:
   /// \returns true if an error occurred, false otherwise.
   bool solveSimplified(SmallVectorImpl<Solution> &solutions,
                        FreeTypeVariableBinding allowFreeTypeVariables);
+
+  /// \brief Copy the parts of a partial solution for a connected component
+  /// that were not already decided in the current state of the system.
+  ///
+  /// \param solution A partial solution for the component.
+  ///
+  /// \param otherTypeVars The type variables which don't belong to the
+  /// component, whose bindings are left out of the copy.
+  Solution
+  extractComponentSolution(const Solution &solution,
+                           const llvm::SmallPtrSetImpl<TypeVariableType *>
+                             &otherTypeVars);
  public:
   /// \brief Solve the system of constraints.
   ///
@@ -2411,8 +2479,13 @@ public:
   void optimizeConstraints(Expr *e);
   
   /// \brief Determine if the expression being solved has exceeded the solver's
-  /// memory threshold.
+  /// memory or time threshold.
   bool getExpressionTooComplex() {
+    if (!expressionExceededThreshold && Timer) {
+      unsigned threshold = TC.getLangOpts().SolverExpressionTimeThreshold;
+      if (threshold && Timer->getElapsedTime() > threshold)
+        expressionExceededThreshold = true;
+    }
     return expressionExceededThreshold;
   }
 
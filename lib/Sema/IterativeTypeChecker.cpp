@@ -21,8 +21,80 @@
 #include "swift/AST/Decl.h"
 #include "swift/AST/DiagnosticsSema.h"
 #include "swift/Basic/Defer.h"
+#include <algorithm>
 using namespace swift;
 
+void TypeCheckRequestDependencies::addDependency(TypeCheckRequest request,
+                                                 TypeCheckRequest dependency) {
+  auto &known = Dependencies[request];
+  if (std::find(known.begin(), known.end(), dependency) != known.end())
+    return;
+
+  known.push_back(dependency);
+  Dependents[dependency].push_back(request);
+}
+
+void TypeCheckRequestDependencies::clearDependencies(
+       TypeCheckRequest request) {
+  auto known = Dependencies.find(request);
+  if (known == Dependencies.end()) return;
+
+  for (auto dependency : known->second) {
+    auto &users = Dependents[dependency];
+    users.erase(std::remove(users.begin(), users.end(), request),
+                users.end());
+    if (users.empty())
+      Dependents.erase(dependency);
+  }
+
+  Dependencies.erase(known);
+}
+
+ArrayRef<TypeCheckRequest>
+TypeCheckRequestDependencies::getDependencies(TypeCheckRequest request) const {
+  auto known = Dependencies.find(request);
+  if (known == Dependencies.end()) return { };
+  return known->second;
+}
+
+ArrayRef<TypeCheckRequest>
+TypeCheckRequestDependencies::getDependents(TypeCheckRequest request) const {
+  auto known = Dependents.find(request);
+  if (known == Dependents.end()) return { };
+  return known->second;
+}
+
+void TypeCheckRequestDependencies::invalidate(
+       Decl *changed,
+       SmallVectorImpl<TypeCheckRequest> &affected) {
+  unsigned firstAffected = affected.size();
+  auto addAffected = [&](TypeCheckRequest request) {
+    if (std::find(affected.begin() + firstAffected, affected.end(), request)
+          == affected.end())
+      affected.push_back(request);
+  };
+
+  // Find the requests about the changed declaration.
+  for (const auto &entry : Dependencies)
+    if (entry.first.getAnchor() == changed)
+      addAffected(entry.first);
+  for (const auto &entry : Dependents)
+    if (entry.first.getAnchor() == changed)
+      addAffected(entry.first);
+
+  // Walk out to everything that used them.
+  for (unsigned i = firstAffected; i != affected.size(); ++i) {
+    for (auto user : getDependents(affected[i]))
+      addAffected(user);
+  }
+
+  for (unsigned i = firstAffected, n = affected.size(); i != n; ++i)
+    clearDependencies(affected[i]);
+}
+
+IterativeTypeChecker::IterativeTypeChecker(TypeChecker &tc)
+  : TC(tc), Dependencies(tc.getRequestDependencies()) { }
+
 ASTContext &IterativeTypeChecker::getASTContext() const {
   return TC.Context;
 }
@@ -88,9 +160,12 @@ void IterativeTypeChecker::satisfy(TypeCheckRequest request) {
 
   while (true) {
     // Process this requirement, enumerating dependencies if anything else needs
-    // to be handled first.
+    // to be handled first. Only the dependencies enumerated by the final pass
+    // are kept.
     SmallVector<TypeCheckRequest, 4> unsatisfied;
+    Dependencies.clearDependencies(request);
     process(request, [&](TypeCheckRequest dependency) -> bool {
+      Dependencies.addDependency(request, dependency);
       if (isSatisfied(dependency)) return false;
 
       // Record the unsatisfied dependency.
@@ -49,6 +49,7 @@ public:
 #define IGNORED_ATTR(X) void visit##X##Attr(X##Attr *) {}
   IGNORED_ATTR(SILGenName)
   IGNORED_ATTR(Available)
+  IGNORED_ATTR(CompactLayout)
   IGNORED_ATTR(Convenience)
   IGNORED_ATTR(Effects)
   IGNORED_ATTR(Exported)
@@ -613,6 +614,7 @@ public:
     IGNORED_ATTR(AutoClosure)
     IGNORED_ATTR(Alignment)
     IGNORED_ATTR(SILGenName)
+    IGNORED_ATTR(CompactLayout)
     IGNORED_ATTR(Dynamic)
     IGNORED_ATTR(Exported)
     IGNORED_ATTR(Convenience)
@@ -985,6 +985,12 @@ solveForExpression(Expr *&expr, DeclContext *dc, Type convertType,
                    ExprTypeCheckListener *listener, ConstraintSystem &cs,
                    SmallVectorImpl<Solution> &viable,
                    TypeCheckExprOptions options) {
+  // Time the expression if asked to report it or to give up after a while.
+  Optional<ExpressionTimer> timer;
+  if (DebugTimeExpressions || getLangOpts().SolverExpressionTimeThreshold)
+    timer.emplace(expr, *this);
+  llvm::SaveAndRestore<ExpressionTimer *>
+    setTimer(cs.Timer, timer ? timer.getPointer() : nullptr);
 
   // First, pre-check the expression, validating any types that occur in the
   // expression and folding sequence expressions.
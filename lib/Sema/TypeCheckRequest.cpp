@@ -103,3 +103,39 @@ bool swift::operator==(const TypeCheckRequest &x, const TypeCheckRequest &y) {
 #include "swift/Sema/TypeCheckRequestPayloads.def"
   }
 }
+
+llvm::hash_code swift::hash_value(const TypeCheckRequest &request) {
+  auto kind = static_cast<unsigned>(request.getKind());
+  switch (TypeCheckRequest::getPayloadKind(request.getKind())) {
+  case TypeCheckRequest::PayloadKind::Class:
+    return llvm::hash_combine(kind, request.getClassPayload());
+
+  case TypeCheckRequest::PayloadKind::Enum:
+    return llvm::hash_combine(kind, request.getEnumPayload());
+
+  case TypeCheckRequest::PayloadKind::InheritedClauseEntry: {
+    auto payload = request.getInheritedClauseEntryPayload();
+    return llvm::hash_combine(kind, payload.first.getOpaqueValue(),
+                              payload.second);
+  }
+
+  case TypeCheckRequest::PayloadKind::Protocol:
+    return llvm::hash_combine(kind, request.getProtocolPayload());
+
+  case TypeCheckRequest::PayloadKind::DeclContextLookup: {
+    // The location isn't part of the request's identity.
+    auto payload = request.getDeclContextLookupPayload();
+    return llvm::hash_combine(kind, payload.DC,
+                              payload.Name.getOpaqueValue());
+  }
+
+  case TypeCheckRequest::PayloadKind::TypeResolution: {
+    auto payload = request.getTypeResolutionPayload();
+    return llvm::hash_combine(kind, std::get<0>(payload),
+                              std::get<1>(payload), std::get<2>(payload));
+  }
+
+  case TypeCheckRequest::PayloadKind::TypeDeclResolution:
+    return llvm::hash_combine(kind, request.getTypeDeclResolutionPayload());
+  }
+}
@@ -21,6 +21,7 @@
 #include "swift/AST/ASTVisitor.h"
 #include "swift/AST/Attr.h"
 #include "swift/AST/ExprHandle.h"
+#include "swift/AST/FunctionTimeProfile.h"
 #include "swift/AST/Identifier.h"
 #include "swift/AST/NameLookup.h"
 #include "swift/AST/PrettyStackTrace.h"
@@ -1208,6 +1209,8 @@ bool TypeChecker::typeCheckAbstractFunctionBody(AbstractFunctionDecl *AFD) {
   Optional<FunctionBodyTimer> timer;
   if (DebugTimeFunctionBodies)
     timer.emplace(AFD);
+  FunctionTimeProfile::Timer profileTimer(AFD, StringRef(),
+                                          FunctionTimeProfile::Phase::TypeCheck);
 
   if (typeCheckAbstractFunctionBodyUntil(AFD, SourceLoc()))
     return true;
@@ -1452,6 +1455,8 @@ void TypeChecker::typeCheckClosureBody(ClosureExpr *closure) {
   Optional<FunctionBodyTimer> timer;
   if (DebugTimeFunctionBodies)
     timer.emplace(closure);
+  FunctionTimeProfile::Timer profileTimer(closure, StringRef(),
+                                          FunctionTimeProfile::Phase::TypeCheck);
 
   StmtChecker(*this, closure).typeCheckBody(body);
   if (body) {
@@ -38,6 +38,8 @@
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 
 using namespace swift;
@@ -53,6 +55,22 @@ TypeChecker::TypeChecker(ASTContext &Ctx, DiagnosticEngine &Diags)
 }
 
 TypeChecker::~TypeChecker() {
+  if (!ExpressionTimings.empty()) {
+    std::stable_sort(ExpressionTimings.begin(), ExpressionTimings.end(),
+                     [](const ExpressionTiming &lhs,
+                        const ExpressionTiming &rhs) {
+      return lhs.Time > rhs.Time;
+    });
+
+    for (auto &timing : ExpressionTimings) {
+      llvm::errs() << llvm::format("%0.1f", timing.Time * 1000) << "ms\t";
+      timing.Loc.print(llvm::errs(), Context.SourceMgr);
+      llvm::errs() << "\t" << timing.NumStatesExplored << " states\t"
+                   << timing.NumDisjunctions << " disjunctions\t"
+                   << timing.SolverMemory << " bytes\n";
+    }
+  }
+
   auto clangImporter =
     static_cast<ClangImporter *>(Context.getClangModuleLoader());
   clangImporter->clearTypeResolver();
@@ -522,6 +540,9 @@ void swift::performTypeChecking(SourceFile &SF, TopLevelContext &TLC,
     if (Options.contains(TypeCheckingFlags::DebugTimeFunctionBodies))
       TC.enableDebugTimeFunctionBodies();
 
+    if (Options.contains(TypeCheckingFlags::DebugTimeExpressionTypeChecking))
+      TC.enableDebugTimeExpressions();
+
     if (Options.contains(TypeCheckingFlags::ForImmediateMode))
       TC.setInImmediateMode(true);
     
@@ -1361,6 +1382,11 @@ void TypeChecker::buildTypeRefinementContextHierarchy(SourceFile &SF,
     SF.setTypeRefinementContext(RootTRC);
   }
 
+  // Only availability annotations introduce refinement contexts, so there is
+  // no need to walk a file without any.
+  if (!SF.HasAvailabilityAnnotations)
+    return;
+
   // Build refinement contexts, if necessary, for all declarations starting
   // with StartElem.
   TypeRefinementContextBuilder Builder(RootTRC, *this);
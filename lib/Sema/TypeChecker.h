@@ -17,6 +17,7 @@
 #ifndef TYPECHECKING_H
 #define TYPECHECKING_H
 
+#include "swift/Sema/IterativeTypeChecker.h"
 #include "swift/Sema/TypeCheckRequest.h"
 #include "swift/AST/AST.h"
 #include "swift/AST/AnyFunctionRef.h"
@@ -31,6 +32,7 @@
 #include "swift/Config.h"
 #include "llvm/ADT/SetVector.h"
 #include <functional>
+#include <vector>
 
 namespace swift {
 
@@ -425,6 +427,22 @@ inline ConformanceCheckOptions operator|(ConformanceCheckFlags lhs,
   return ConformanceCheckOptions(lhs) | rhs;
 }
 
+/// The time and solver work spent type-checking one expression, as reported
+/// by -debug-time-expression-type-checking.
+struct ExpressionTiming {
+  SourceLoc Loc;
+
+  /// Wall time, in seconds.
+  double Time;
+
+  unsigned NumStatesExplored;
+  unsigned NumDisjunctions;
+
+  /// The largest amount of memory, in bytes, allocated by the constraint
+  /// solver while solving the expression.
+  size_t SolverMemory;
+};
+
 /// The Swift type checker, which takes a parsed AST and performs name binding,
 /// type checking, and semantic analysis to produce a type-annotated AST.
 class TypeChecker final : public LazyResolver {
@@ -542,6 +560,18 @@ private:
   /// to llvm::errs().
   bool DebugTimeFunctionBodies = false;
 
+  /// If true, the time and solver work it takes to type-check each
+  /// expression will be dumped to llvm::errs() when the type checker is torn
+  /// down.
+  bool DebugTimeExpressions = false;
+
+  /// The expressions type-checked so far, if DebugTimeExpressions is set.
+  std::vector<ExpressionTiming> ExpressionTimings;
+
+  /// The dependencies of the requests satisfied by the iterative type
+  /// checker.
+  TypeCheckRequestDependencies RequestDependencies;
+
   /// Indicate that the type checker is checking code that will be
   /// immediately executed. This will suppress certain warnings
   /// when executing scripts.
@@ -564,6 +594,27 @@ public:
     DebugTimeFunctionBodies = true;
   }
 
+  /// Dump the time and solver work it takes to type-check each expression
+  /// to llvm::errs(), most expensive first.
+  void enableDebugTimeExpressions() {
+    DebugTimeExpressions = true;
+  }
+
+  bool getDebugTimeExpressions() const {
+    return DebugTimeExpressions;
+  }
+
+  /// Record the cost of type-checking an expression, to be reported when
+  /// the type checker is torn down.
+  void recordExpressionTiming(const ExpressionTiming &timing) {
+    ExpressionTimings.push_back(timing);
+  }
+
+  /// Retrieve the dependencies recorded for satisfied type check requests.
+  TypeCheckRequestDependencies &getRequestDependencies() {
+    return RequestDependencies;
+  }
+
   bool getInImmediateMode() {
     return InImmediateMode;
   }
@@ -496,6 +496,9 @@ NormalProtocolConformance *ModuleFile::readNormalConformance(
   // Find the conformance record.
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(conformanceEntry);
+  StatisticsScope recordStatistics(*this, &DeclTypeCursor);
+  if (Stats)
+    ++Stats->NumConformances;
   auto entry = DeclTypeCursor.advance();
   if (entry.Kind != llvm::BitstreamEntry::Record) {
     error();
@@ -1706,6 +1709,7 @@ Decl *ModuleFile::getDecl(DeclID DID, Optional<DeclContext *> ForcedContext) {
 
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(declOrOffset);
+  StatisticsScope recordStatistics(*this, &DeclTypeCursor);
   auto entry = DeclTypeCursor.advance();
 
   if (entry.Kind != llvm::BitstreamEntry::Record) {
@@ -3080,6 +3084,19 @@ Decl *ModuleFile::getDecl(DeclID DID, Optional<DeclContext *> ForcedContext) {
   if (DAttrs)
     declOrOffset.get()->getAttrs().setRawAttributeChain(DAttrs);
 
+  // Remember the IDs of contexts with lazy members, so that their members can
+  // be looked up by name.
+  if (auto IDC = dyn_cast<IterableDeclContext>(declOrOffset.get()))
+    if (IDC->isLazy())
+      LazyMemberContextIDs[declOrOffset.get()] = DID;
+
+  if (Stats) {
+    if (recordID == decls_block::XREF)
+      ++Stats->NumCrossReferences;
+    else
+      ++Stats->NumDecls[declOrOffset.get()->getKind()];
+  }
+
   return declOrOffset;
 }
 
@@ -3190,6 +3207,9 @@ Type ModuleFile::getType(TypeID TID) {
 
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(typeOrOffset);
+  StatisticsScope recordStatistics(*this, &DeclTypeCursor);
+  if (Stats)
+    ++Stats->NumTypes;
   auto entry = DeclTypeCursor.advance();
 
   if (entry.Kind != llvm::BitstreamEntry::Record) {
@@ -3914,6 +3934,29 @@ void ModuleFile::loadAllMembers(Decl *D,
     IDC->addMember(member);
 }
 
+bool ModuleFile::loadNamedMembers(const Decl *D, DeclName N,
+                                  uint64_t contextData,
+                                  SmallVectorImpl<ValueDecl *> &Members) {
+  if (!MembersByContextAndName)
+    return false;
+
+  auto contextID = LazyMemberContextIDs.find(D);
+  if (contextID == LazyMemberContextIDs.end())
+    return false;
+
+  PrettyStackTraceDecl trace("loading members by name for", D);
+
+  auto iter = MembersByContextAndName->find({contextID->second,
+                                             N.getBaseName()});
+  if (iter == MembersByContextAndName->end())
+    return true;
+
+  for (DeclID memberID : *iter)
+    if (auto member = dyn_cast_or_null<ValueDecl>(getDecl(memberID)))
+      Members.push_back(member);
+  return true;
+}
+
 void
 ModuleFile::loadAllConformances(const Decl *D, uint64_t contextData,
                          SmallVectorImpl<ProtocolConformance *> &conformances) {
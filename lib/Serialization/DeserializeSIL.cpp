@@ -367,6 +367,7 @@ SILFunction *SILDeserializer::readSILFunction(DeclID FID,
 
   BCOffsetRAII restoreOffset(SILCursor);
   SILCursor.JumpToBit(cacheEntry.getOffset());
+  ModuleFile::StatisticsScope recordStatistics(*MF, &SILCursor);
 
   auto entry = SILCursor.advance(AF_DontPopBlockAtEnd);
   if (entry.Kind == llvm::BitstreamEntry::Error) {
@@ -430,6 +431,11 @@ SILFunction *SILDeserializer::readSILFunction(DeclID FID,
     if (isFragile)
       fn->setFragile(IsFragile);
 
+    // Pick up the effects which were inferred when the function was
+    // compiled, unless the declaration has explicit effects.
+    if (fn->getEffectsKind() == EffectsKind::Unspecified)
+      fn->setEffectsKind((EffectsKind)effect);
+
     // Don't override the transparency or linkage of a function with
     // an existing declaration.
 
@@ -507,6 +513,8 @@ SILFunction *SILDeserializer::readSILFunction(DeclID FID,
   }
 
   NumDeserializedFunc++;
+  if (auto *Stats = MF->getStatistics())
+    ++Stats->NumSILFunctions;
   scratch.clear();
 
   assert(!(fn->getContextGenericParams() && !fn->empty())
@@ -1193,8 +1201,6 @@ bool SILDeserializer::readSILInstruction(SILFunction *Fn, SILBasicBlock *BB,
   UNARY_INSTRUCTION(CopyBlock)
   UNARY_INSTRUCTION(StrongPin)
   UNARY_INSTRUCTION(StrongUnpin)
-  UNARY_INSTRUCTION(StrongRetain)
-  UNARY_INSTRUCTION(StrongRelease)
   UNARY_INSTRUCTION(StrongRetainAutoreleased)
   UNARY_INSTRUCTION(AutoreleaseReturn)
   UNARY_INSTRUCTION(StrongRetainUnowned)
@@ -1206,6 +1212,24 @@ bool SILDeserializer::readSILInstruction(SILFunction *Fn, SILBasicBlock *BB,
   UNARY_INSTRUCTION(DebugValueAddr)
 #undef UNARY_INSTRUCTION
 
+  case ValueKind::StrongRetainInst: {
+    auto Ty = MF->getType(TyID);
+    bool NonAtomic = (Attr > 0);
+    ResultVal = Builder.createStrongRetain(Loc,
+        getLocalValue(ValID, ValResNum,
+                      getSILType(Ty, (SILValueCategory)TyCategory)),
+        NonAtomic);
+    break;
+  }
+  case ValueKind::StrongReleaseInst: {
+    auto Ty = MF->getType(TyID);
+    bool NonAtomic = (Attr > 0);
+    ResultVal = Builder.createStrongRelease(Loc,
+        getLocalValue(ValID, ValResNum,
+                      getSILType(Ty, (SILValueCategory)TyCategory)),
+        NonAtomic);
+    break;
+  }
   case ValueKind::LoadWeakInst: {
     auto Ty = MF->getType(TyID);
     bool isTake = (Attr > 0);
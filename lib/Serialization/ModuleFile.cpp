@@ -18,6 +18,7 @@
 #include "swift/AST/NameLookup.h"
 #include "swift/AST/USRGeneration.h"
 #include "swift/Basic/Range.h"
+#include "swift/Basic/TraceEvents.h"
 #include "swift/ClangImporter/ClangImporter.h"
 #include "swift/Serialization/BCReadingExtras.h"
 #include "swift/Serialization/SerializedModuleLoader.h"
@@ -329,6 +330,50 @@ public:
   }
 };
 
+/// Used to deserialize entries in the on-disk member hash table.
+class ModuleFile::DeclMemberTableInfo {
+public:
+  using internal_key_type = std::pair<DeclID, StringRef>;
+  using external_key_type = std::pair<DeclID, Identifier>;
+  using data_type = SmallVector<DeclID, 2>;
+  using hash_value_type = uint32_t;
+  using offset_type = unsigned;
+
+  internal_key_type GetInternalKey(external_key_type key) {
+    return { key.first, key.second.str() };
+  }
+
+  hash_value_type ComputeHash(internal_key_type key) {
+    return llvm::HashString(key.second, key.first);
+  }
+
+  static bool EqualKey(internal_key_type lhs, internal_key_type rhs) {
+    return lhs == rhs;
+  }
+
+  static std::pair<unsigned, unsigned> ReadKeyDataLength(const uint8_t *&data) {
+    unsigned keyLength = endian::readNext<uint16_t, little, unaligned>(data);
+    unsigned dataLength = endian::readNext<uint16_t, little, unaligned>(data);
+    return { keyLength, dataLength };
+  }
+
+  static internal_key_type ReadKey(const uint8_t *data, unsigned length) {
+    DeclID parentID = endian::readNext<uint32_t, little, unaligned>(data);
+    return { parentID, StringRef(reinterpret_cast<const char *>(data),
+                                 length - sizeof(uint32_t)) };
+  }
+
+  static data_type ReadData(internal_key_type key, const uint8_t *data,
+                            unsigned length) {
+    data_type result;
+    while (length > 0) {
+      result.push_back(endian::readNext<uint32_t, little, unaligned>(data));
+      length -= sizeof(uint32_t);
+    }
+    return result;
+  }
+};
+
 /// Used to deserialize entries in the on-disk decl hash table.
 class ModuleFile::LocalDeclTableInfo {
 public:
@@ -378,6 +423,19 @@ ModuleFile::readDeclTable(ArrayRef<uint64_t> fields, StringRef blobData) {
                                                 base + sizeof(uint32_t), base));
 }
 
+std::unique_ptr<ModuleFile::SerializedDeclMemberTable>
+ModuleFile::readDeclMemberTable(ArrayRef<uint64_t> fields,
+                                StringRef blobData) {
+  uint32_t tableOffset;
+  index_block::DeclListLayout::readRecord(fields, tableOffset);
+  auto base = reinterpret_cast<const uint8_t *>(blobData.data());
+
+  using OwnedTable = std::unique_ptr<SerializedDeclMemberTable>;
+  return OwnedTable(SerializedDeclMemberTable::Create(base + tableOffset,
+                                                      base + sizeof(uint32_t),
+                                                      base));
+}
+
 std::unique_ptr<ModuleFile::SerializedLocalDeclTable>
 ModuleFile::readLocalDeclTable(ArrayRef<uint64_t> fields, StringRef blobData) {
   uint32_t tableOffset;
@@ -448,6 +506,15 @@ ModuleFile::readObjCMethodTable(ArrayRef<uint64_t> fields, StringRef blobData) {
                                              base + sizeof(uint32_t), base));
 }
 
+/// Returns the offsets stored in the blob of an index block offsets record.
+static ArrayRef<llvm::support::ulittle32_t> readOffsets(StringRef blobData) {
+  assert(blobData.size() % sizeof(uint32_t) == 0 && "malformed offsets");
+  return {
+    reinterpret_cast<const llvm::support::ulittle32_t *>(blobData.data()),
+    blobData.size() / sizeof(uint32_t)
+  };
+}
+
 bool ModuleFile::readIndexBlock(llvm::BitstreamCursor &cursor) {
   cursor.EnterSubBlock(INDEX_BLOCK_ID);
 
@@ -476,20 +543,16 @@ bool ModuleFile::readIndexBlock(llvm::BitstreamCursor &cursor) {
 
       switch (kind) {
       case index_block::DECL_OFFSETS:
-        assert(blobData.empty());
-        Decls.assign(scratch.begin(), scratch.end());
+        Decls.init(readOffsets(blobData));
         break;
       case index_block::DECL_CONTEXT_OFFSETS:
-        assert(blobData.empty());
-        DeclContexts.assign(scratch.begin(), scratch.end());
+        DeclContexts.init(readOffsets(blobData));
         break;
       case index_block::TYPE_OFFSETS:
-        assert(blobData.empty());
-        Types.assign(scratch.begin(), scratch.end());
+        Types.init(readOffsets(blobData));
         break;
       case index_block::IDENTIFIER_OFFSETS:
-        assert(blobData.empty());
-        Identifiers.assign(scratch.begin(), scratch.end());
+        Identifiers.init(readOffsets(blobData));
         break;
       case index_block::TOP_LEVEL_DECLS:
         TopLevelDecls = readDeclTable(scratch, blobData);
@@ -506,6 +569,13 @@ bool ModuleFile::readIndexBlock(llvm::BitstreamCursor &cursor) {
       case index_block::OPERATOR_METHODS:
         OperatorMethodDecls = readDeclTable(scratch, blobData);
         break;
+      case index_block::DECL_MEMBER_NAMES:
+        MembersByContextAndName = readDeclMemberTable(scratch, blobData);
+        break;
+      case index_block::NAME_FILTER:
+        NameFilterHashCount = scratch.front();
+        NameFilterBits = blobData;
+        break;
       case index_block::OBJC_METHODS:
         ObjCMethods = readObjCMethodTable(scratch, blobData);
         break;
@@ -517,12 +587,10 @@ bool ModuleFile::readIndexBlock(llvm::BitstreamCursor &cursor) {
         LocalTypeDecls = readLocalDeclTable(scratch, blobData);
         break;
       case index_block::LOCAL_DECL_CONTEXT_OFFSETS:
-        assert(blobData.empty());
-        LocalDeclContexts.assign(scratch.begin(), scratch.end());
+        LocalDeclContexts.init(readOffsets(blobData));
         break;
       case index_block::NORMAL_CONFORMANCE_OFFSETS:
-        assert(blobData.empty());
-        NormalConformances.assign(scratch.begin(), scratch.end());
+        NormalConformances.init(readOffsets(blobData));
         break;
 
       default:
@@ -1103,10 +1171,74 @@ Status ModuleFile::associateWithFileContext(FileUnit *file,
 
 ModuleFile::~ModuleFile() = default;
 
+/// The statistics which are currently being charged for time, and when they
+/// started being charged.
+static ModuleFile::Statistics *CurrentStatistics = nullptr;
+static uint64_t CurrentStatisticsStart = 0;
+
+ModuleFile::StatisticsScope::StatisticsScope(Statistics *Stats,
+                                             llvm::BitstreamCursor *Cursor)
+    : Stats(Stats), Cursor(Cursor) {
+  if (!Stats)
+    return;
+  if (Cursor)
+    StartBit = Cursor->GetCurrentBitNo();
+  if (CurrentStatistics == Stats)
+    return;
+
+  // Stop charging the enclosing module file, if any, and start charging this
+  // one.
+  uint64_t now = TraceEventRecorder::now();
+  if (CurrentStatistics)
+    CurrentStatistics->Time += now - CurrentStatisticsStart;
+  Outer = CurrentStatistics;
+  ChargesTime = true;
+  CurrentStatistics = Stats;
+  CurrentStatisticsStart = now;
+}
+
+ModuleFile::StatisticsScope::~StatisticsScope() {
+  if (!Stats)
+    return;
+  if (Cursor) {
+    // The cursor may have been moved backwards by code that doesn't restore
+    // its position; don't count that as reading.
+    uint64_t EndBit = Cursor->GetCurrentBitNo();
+    if (EndBit > StartBit)
+      Stats->NumBitsRead += EndBit - StartBit;
+  }
+  if (!ChargesTime)
+    return;
+
+  uint64_t now = TraceEventRecorder::now();
+  Stats->Time += now - CurrentStatisticsStart;
+  CurrentStatistics = Outer;
+  CurrentStatisticsStart = now;
+}
+
+bool ModuleFile::mayDefineName(Identifier name) const {
+  // Modules without a filter may define anything.
+  if (NameFilterBits.empty() || name.empty())
+    return true;
+
+  uint64_t numBits = NameFilterBits.size() * CHAR_BIT;
+  bool mayDefine = true;
+  index_block::forEachNameFilterBit(name.str(), NameFilterHashCount, numBits,
+                                    [&](uint64_t bit) {
+    auto byte = static_cast<uint8_t>(NameFilterBits[bit / CHAR_BIT]);
+    if (!(byte & (1 << (bit % CHAR_BIT))))
+      mayDefine = false;
+  });
+  return mayDefine;
+}
+
 void ModuleFile::lookupValue(DeclName name,
                              SmallVectorImpl<ValueDecl*> &results) {
   PrettyModuleFileDeserialization stackEntry(*this);
 
+  if (!mayDefineName(name.getBaseName()))
+    return;
+
   if (TopLevelDecls) {
     // Find top-level declarations with the given name.
     // FIXME: As a bit of a hack, do lookup by the simple name, then filter
@@ -1331,7 +1463,7 @@ void ModuleFile::lookupClassMember(Module::AccessPathTy accessPath,
   PrettyModuleFileDeserialization stackEntry(*this);
   assert(accessPath.size() <= 1 && "can only refer to top-level decls");
 
-  if (!ClassMembersByName)
+  if (!ClassMembersByName || !mayDefineName(name.getBaseName()))
     return;
 
   auto iter = ClassMembersByName->find(name.getBaseName());
@@ -1511,9 +1643,10 @@ Identifier ModuleFile::getDiscriminatorForPrivateValue(const ValueDecl *D) {
 void ModuleFile::verify() const {
 #ifndef NDEBUG
   const auto &Context = getContext();
-  for (const Serialized<Decl*> &next : Decls)
+  Decls.forEachAllocated([&](const Serialized<Decl*> &next) {
     if (next.isComplete() && swift::shouldVerify(next, Context))
       swift::verify(next);
+  });
 #endif
 }
 
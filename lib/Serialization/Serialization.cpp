@@ -96,6 +96,46 @@ namespace {
     }
   };
 
+  class DeclMemberTableInfo {
+  public:
+    using key_type = std::pair<DeclID, Identifier>;
+    using key_type_ref = const key_type &;
+    using data_type = SmallVector<DeclID, 2>;
+    using data_type_ref = const data_type &;
+    using hash_value_type = uint32_t;
+    using offset_type = unsigned;
+
+    hash_value_type ComputeHash(key_type_ref key) {
+      assert(!key.second.empty());
+      return llvm::HashString(key.second.str(), key.first);
+    }
+
+    std::pair<unsigned, unsigned> EmitKeyDataLength(raw_ostream &out,
+                                                    key_type_ref key,
+                                                    data_type_ref data) {
+      uint32_t keyLength = sizeof(DeclID) + key.second.str().size();
+      uint32_t dataLength = sizeof(DeclID) * data.size();
+      endian::Writer<little> writer(out);
+      writer.write<uint16_t>(keyLength);
+      writer.write<uint16_t>(dataLength);
+      return { keyLength, dataLength };
+    }
+
+    void EmitKey(raw_ostream &out, key_type_ref key, unsigned len) {
+      static_assert(sizeof(DeclID) <= 4, "DeclID too large");
+      endian::Writer<little> writer(out);
+      writer.write<uint32_t>(key.first);
+      out << key.second.str();
+    }
+
+    void EmitData(raw_ostream &out, key_type_ref key, data_type_ref data,
+                  unsigned len) {
+      endian::Writer<little> writer(out);
+      for (auto entry : data)
+        writer.write<uint32_t>(entry);
+    }
+  };
+
   class LocalDeclTableInfo {
   public:
     using key_type = std::string;
@@ -456,6 +496,8 @@ void Serializer::writeBlockInfoBlock() {
   BLOCK_RECORD(index_block, DECL_CONTEXT_OFFSETS);
   BLOCK_RECORD(index_block, LOCAL_TYPE_DECLS);
   BLOCK_RECORD(index_block, NORMAL_CONFORMANCE_OFFSETS);
+  BLOCK_RECORD(index_block, DECL_MEMBER_NAMES);
+  BLOCK_RECORD(index_block, NAME_FILTER);
 
   BLOCK(SIL_BLOCK);
   BLOCK_RECORD(sil_block, SIL_FUNCTION);
@@ -541,6 +583,16 @@ void Serializer::writeDocBlockInfoBlock() {
 #undef BLOCK_RECORD
 }
 
+/// Replace the first matching prefix of \p path according to the path prefix
+/// map in \p options.
+static std::string remapPath(StringRef path,
+                             const SerializationOptions &options) {
+  for (auto &entry : options.PathPrefixMap)
+    if (path.startswith(entry.first))
+      return entry.second + path.substr(entry.first.size()).str();
+  return path.str();
+}
+
 void Serializer::writeHeader(const SerializationOptions &options) {
   {
     BCBlockRAII restoreBlock(Out, CONTROL_BLOCK_ID, 3);
@@ -577,7 +629,9 @@ void Serializer::writeHeader(const SerializationOptions &options) {
         options_block::SDKPathLayout SDKPath(Out);
         options_block::XCCLayout XCC(Out);
 
-        SDKPath.emit(ScratchRecord, M->getASTContext().SearchPathOpts.SDKPath);
+        SDKPath.emit(ScratchRecord,
+                     remapPath(M->getASTContext().SearchPathOpts.SDKPath,
+                               options));
         for (const std::string &arg : options.ExtraClangOptions) {
           XCC.emit(ScratchRecord, arg);
         }
@@ -677,9 +731,11 @@ void Serializer::writeInputBlock(const SerializationOptions &options) {
     // Put the framework search paths first so that they'll be preferred upon
     // deserialization.
     for (auto &path : searchPathOpts.FrameworkSearchPaths)
-      SearchPath.emit(ScratchRecord, /*framework=*/true, path);
+      SearchPath.emit(ScratchRecord, /*framework=*/true,
+                      remapPath(path, options));
     for (auto &path : searchPathOpts.ImportSearchPaths)
-      SearchPath.emit(ScratchRecord, /*framework=*/false, path);
+      SearchPath.emit(ScratchRecord, /*framework=*/false,
+                      remapPath(path, options));
   }
 
   // FIXME: Having to deal with private imports as a superset of public imports
@@ -713,7 +769,7 @@ void Serializer::writeInputBlock(const SerializationOptions &options) {
             options.ImportedHeader, importedHeaderSize, importedHeaderModTime);
       ImportedHeader.emit(ScratchRecord, publicImportSet.count(import),
                           importedHeaderSize, importedHeaderModTime,
-                          options.ImportedHeader);
+                          remapPath(options.ImportedHeader, options));
       if (!contents.empty()) {
         contents.push_back('\0');
         ImportedHeaderContents.emit(ScratchRecord, contents);
@@ -1215,7 +1271,8 @@ static bool shouldSerializeMember(Decl *D) {
   }
 }
 
-void Serializer::writeMembers(DeclRange members, bool isClass) {
+void Serializer::writeMembers(DeclID parentID, DeclRange members,
+                              bool isClass) {
   using namespace decls_block;
 
   unsigned abbrCode = DeclTypeAbbrCodes[MembersLayout::Code];
@@ -1227,6 +1284,12 @@ void Serializer::writeMembers(DeclRange members, bool isClass) {
     DeclID memberID = addDeclRef(member);
     memberIDs.push_back(memberID);
 
+    if (auto VD = dyn_cast<ValueDecl>(member)) {
+      Identifier baseName = VD->getFullName().getBaseName();
+      if (!baseName.empty())
+        MembersByContextAndName[{parentID, baseName}].push_back(memberID);
+    }
+
     if (isClass) {
       if (auto VD = dyn_cast<ValueDecl>(member)) {
         if (VD->canBeAccessedByDynamicLookup()) {
@@ -1988,7 +2051,7 @@ void Serializer::writeDecl(const Decl *D) {
 
     writeGenericParams(extension->getGenericParams(), DeclTypeAbbrCodes);
     writeRequirements(extension->getGenericRequirements());
-    writeMembers(extension->getMembers(), isClassExtension);
+    writeMembers(addDeclRef(extension), extension->getMembers(), isClassExtension);
     writeConformances(conformances, DeclTypeAbbrCodes);
 
     break;
@@ -2166,7 +2229,7 @@ void Serializer::writeDecl(const Decl *D) {
 
     writeGenericParams(theStruct->getGenericParams(), DeclTypeAbbrCodes);
     writeRequirements(theStruct->getGenericRequirements());
-    writeMembers(theStruct->getMembers(), false);
+    writeMembers(addDeclRef(theStruct), theStruct->getMembers(), false);
     writeConformances(conformances, DeclTypeAbbrCodes);
     break;
   }
@@ -2200,7 +2263,7 @@ void Serializer::writeDecl(const Decl *D) {
 
     writeGenericParams(theEnum->getGenericParams(), DeclTypeAbbrCodes);
     writeRequirements(theEnum->getGenericRequirements());
-    writeMembers(theEnum->getMembers(), false);
+    writeMembers(addDeclRef(theEnum), theEnum->getMembers(), false);
     writeConformances(conformances, DeclTypeAbbrCodes);
     break;
   }
@@ -2237,7 +2300,7 @@ void Serializer::writeDecl(const Decl *D) {
 
     writeGenericParams(theClass->getGenericParams(), DeclTypeAbbrCodes);
     writeRequirements(theClass->getGenericRequirements());
-    writeMembers(theClass->getMembers(), true);
+    writeMembers(addDeclRef(theClass), theClass->getMembers(), true);
     writeConformances(conformances, DeclTypeAbbrCodes);
     break;
   }
@@ -2273,7 +2336,7 @@ void Serializer::writeDecl(const Decl *D) {
 
     writeGenericParams(proto->getGenericParams(), DeclTypeAbbrCodes);
     writeRequirements(proto->getGenericRequirements());
-    writeMembers(proto->getMembers(), true);
+    writeMembers(addDeclRef(proto), proto->getMembers(), true);
     break;
   }
 
@@ -3263,6 +3326,12 @@ void Serializer::writeAllDeclsAndTypes() {
            !NormalConformancesToWrite.empty());
 }
 
+/// Returns true if \p lhs sorts before \p rhs when both are read backwards.
+static bool isReversedLess(StringRef lhs, StringRef rhs) {
+  return std::lexicographical_compare(lhs.rbegin(), lhs.rend(),
+                                      rhs.rbegin(), rhs.rend());
+}
+
 void Serializer::writeAllIdentifiers() {
   BCBlockRAII restoreBlock(Out, IDENTIFIER_DATA_BLOCK_ID, 3);
   identifier_block::IdentifierDataLayout IdentifierData(Out);
@@ -3272,9 +3341,32 @@ void Serializer::writeAllIdentifiers() {
   // Make sure no identifier has an offset of 0.
   stringData.push_back('\0');
 
-  for (Identifier ident : IdentifiersToWrite) {
-    IdentifierOffsets.push_back(stringData.size());
-    stringData.append(ident.get());
+  // Identifiers are read up to their terminating null, so an identifier that
+  // is a suffix of another one (e.g. "Type" and "AnyType") can point into the
+  // other's storage. Sorting by reversed spelling puts every identifier
+  // right after the longest identifier it is a suffix of.
+  std::vector<unsigned> order(IdentifiersToWrite.size());
+  for (unsigned i = 0, e = order.size(); i != e; ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](unsigned lhs, unsigned rhs) {
+    return isReversedLess(IdentifiersToWrite[rhs].str(),
+                          IdentifiersToWrite[lhs].str());
+  });
+
+  IdentifierOffsets.resize(IdentifiersToWrite.size());
+  StringRef prevIdent;
+  CharOffset prevOffset = 0;
+  for (unsigned index : order) {
+    StringRef ident = IdentifiersToWrite[index].str();
+    if (!prevIdent.empty() && prevIdent.endswith(ident)) {
+      IdentifierOffsets[index] = prevOffset + prevIdent.size() - ident.size();
+      continue;
+    }
+
+    prevIdent = ident;
+    prevOffset = stringData.size();
+    IdentifierOffsets[index] = prevOffset;
+    stringData.append(ident);
     stringData.push_back('\0');
   }
 
@@ -3283,7 +3375,14 @@ void Serializer::writeAllIdentifiers() {
 
 void Serializer::writeOffsets(const index_block::OffsetsLayout &Offsets,
                               const std::vector<BitOffset> &values) {
-  Offsets.emit(ScratchRecord, getOffsetRecordCode(values), values);
+  SmallString<256> blob;
+  {
+    llvm::raw_svector_ostream blobStream(blob);
+    endian::Writer<little> writer(blobStream);
+    for (BitOffset offset : values)
+      writer.write<uint32_t>(offset);
+  }
+  Offsets.emit(ScratchRecord, getOffsetRecordCode(values), blob);
 }
 
 /// Writes an in-memory decl table to an on-disk representation, using the
@@ -3311,6 +3410,57 @@ static void writeDeclTable(const index_block::DeclListLayout &DeclList,
   DeclList.emit(scratch, kind, tableOffset, hashTableBlob);
 }
 
+static void
+writeDeclMemberTable(const index_block::DeclListLayout &DeclList,
+                     const Serializer::DeclMemberTable &table) {
+  if (table.empty())
+    return;
+
+  SmallVector<uint64_t, 8> scratch;
+  llvm::SmallString<4096> hashTableBlob;
+  uint32_t tableOffset;
+  {
+    llvm::OnDiskChainedHashTableGenerator<DeclMemberTableInfo> generator;
+    for (auto &entry : table)
+      generator.insert(entry.first, entry.second);
+
+    llvm::raw_svector_ostream blobStream(hashTableBlob);
+    // Make sure that no bucket is at offset 0
+    endian::Writer<little>(blobStream).write<uint32_t>(0);
+    tableOffset = generator.Emit(blobStream);
+  }
+
+  DeclList.emit(scratch, index_block::DECL_MEMBER_NAMES, tableOffset,
+                hashTableBlob);
+}
+
+/// Writes a Bloom filter over the names in the given decl tables.
+static void writeNameFilter(const index_block::NameFilterLayout &NameFilter,
+                            ArrayRef<const Serializer::DeclTable *> tables) {
+  size_t numNames = 0;
+  for (auto table : tables)
+    numNames += table->size();
+  if (numNames == 0)
+    return;
+
+  // About 10 bits per name with 7 hash functions gives a false positive rate
+  // of about 1%.
+  const unsigned numHashes = 7;
+  std::vector<char> bits(std::max<size_t>(8, (numNames * 10 + 7) / CHAR_BIT));
+  uint64_t numBits = bits.size() * CHAR_BIT;
+  for (auto table : tables) {
+    for (auto &entry : *table) {
+      index_block::forEachNameFilterBit(entry.first.str(), numHashes, numBits,
+                                        [&](uint64_t bit) {
+        bits[bit / CHAR_BIT] |= 1 << (bit % CHAR_BIT);
+      });
+    }
+  }
+
+  SmallVector<uint64_t, 8> scratch;
+  NameFilter.emit(scratch, numHashes, StringRef(bits.data(), bits.size()));
+}
+
 static void writeLocalDeclTable(const index_block::DeclListLayout &DeclList,
                                 index_block::RecordKind kind,
                                 LocalTypeHashTableGenerator &generator) {
@@ -3672,6 +3822,11 @@ void Serializer::writeAST(ModuleOrSourceFile DC) {
     writeDeclTable(DeclList, index_block::EXTENSIONS, extensionDecls);
     writeDeclTable(DeclList, index_block::CLASS_MEMBERS, ClassMembersByName);
     writeDeclTable(DeclList, index_block::OPERATOR_METHODS, operatorMethodDecls);
+    writeDeclMemberTable(DeclList, MembersByContextAndName);
+
+    index_block::NameFilterLayout NameFilter(Out);
+    writeNameFilter(NameFilter, { &topLevelDecls, &operatorMethodDecls,
+                                  &ClassMembersByName });
     if (hasLocalTypes)
       writeLocalDeclTable(DeclList, index_block::LOCAL_TYPE_DECLS,
                           localTypeGenerator);
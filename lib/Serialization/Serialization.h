@@ -117,6 +117,11 @@ public:
   /// with.
   const Decl *getGenericContext(const GenericParamList *paramList);
 
+  /// The in-memory representation of what will eventually be an on-disk hash
+  /// table of members, keyed by the ID of their context and their base name.
+  using DeclMemberTable =
+    llvm::MapVector<std::pair<DeclID, Identifier>, SmallVector<DeclID, 2>>;
+
   using ObjCMethodTableData = SmallVector<std::tuple<TypeID, bool, DeclID>, 4>;
 
   // In-memory representation of what will eventually be an on-disk
@@ -129,6 +134,12 @@ private:
   /// This is used for id-style lookup.
   DeclTable ClassMembersByName;
 
+  /// A map from nominal types and extensions and member names to the members
+  /// with the given name.
+  ///
+  /// This is used to load members lazily by name.
+  DeclMemberTable MembersByContextAndName;
+
   /// The queue of types and decls that need to be serialized.
   ///
   /// This is a queue and not simply a vector because serializing one
@@ -247,10 +258,11 @@ private:
 
   /// Writes an array of members for a decl context.
   ///
+  /// \param parentID The ID of the context
   /// \param members The decls within the context
   /// \param isClass True if the context could be a class context (class,
   ///        class extension, or protocol).
-  void writeMembers(DeclRange members, bool isClass);
+  void writeMembers(DeclID parentID, DeclRange members, bool isClass);
 
   /// Check if a decl is cross-referenced.
   bool isDeclXRef(const Decl *D) const;
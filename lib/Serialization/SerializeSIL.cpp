@@ -916,6 +916,10 @@ void SILSerializer::writeSILInstruction(const SILInstruction &SI) {
       Attr = (unsigned)MUI->getKind();
     else if (auto *DRI = dyn_cast<DeallocRefInst>(&SI))
       Attr = (unsigned)DRI->canAllocOnStack();
+    else if (auto *SRI = dyn_cast<StrongRetainInst>(&SI))
+      Attr = (unsigned)SRI->isNonAtomic();
+    else if (auto *SRI = dyn_cast<StrongReleaseInst>(&SI))
+      Attr = (unsigned)SRI->isNonAtomic();
     writeOneOperandLayout(SI.getKind(), Attr, SI.getOperand(0));
     break;
   }
@@ -1623,6 +1627,13 @@ void SILSerializer::writeSILWitnessTable(const SILWitnessTable &wt) {
 }
 
 /// Helper function for whether to emit a function body.
+/// Returns true if \p F is a public function of this module whose effects are
+/// known to be readnone or readonly.
+static bool hasEffectsSummary(const SILFunction &F) {
+  return F.getLinkage() == SILLinkage::Public &&
+         F.getEffectsKind() < EffectsKind::ReadWrite;
+}
+
 bool SILSerializer::shouldEmitFunctionBody(const SILFunction &F) {
   // If F is a declaration, it has no body to emit...
   if (F.isExternalDeclaration())
@@ -1714,9 +1725,13 @@ void SILSerializer::writeSILBlock(const SILModule *SILMod) {
     return;
 
   // Now write function declarations for every function we've
-  // emitted a reference to without emitting a function body for.
+  // emitted a reference to without emitting a function body for. Public
+  // functions with known effects are declared even if they aren't
+  // referenced, so that clients can use the effects without a body.
   for (const SILFunction &F : *SILMod) {
-    if (!shouldEmitFunctionBody(F) && FuncsToDeclare.count(&F))
+    if (shouldEmitFunctionBody(F))
+      continue;
+    if (FuncsToDeclare.count(&F) || hasEffectsSummary(F))
       writeSILFunction(F, true);
   }
 }
@@ -15,6 +15,7 @@
 #include "swift/Strings.h"
 #include "swift/AST/AST.h"
 #include "swift/AST/DiagnosticsSema.h"
+#include "swift/Basic/JSONSerialization.h"
 #include "swift/Basic/STLExtras.h"
 #include "swift/Basic/SourceManager.h"
 #include "llvm/ADT/SmallString.h"
@@ -43,10 +44,15 @@ openModuleFiles(StringRef DirName, StringRef ModuleFilename,
                 llvm::SmallVectorImpl<char> &Scratch) {
   // Try to open the module file first.  If we fail, don't even look for the
   // module documentation file.
+  //
+  // Module files don't need to be null-terminated. Saying so means that they
+  // are always memory-mapped, so that parallel jobs share their pages.
   Scratch.clear();
   llvm::sys::path::append(Scratch, DirName, ModuleFilename);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> ModuleOrErr =
-    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()));
+    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()),
+                                /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
   if (!ModuleOrErr)
     return ModuleOrErr.getError();
 
@@ -55,7 +61,9 @@ openModuleFiles(StringRef DirName, StringRef ModuleFilename,
   Scratch.clear();
   llvm::sys::path::append(Scratch, DirName, ModuleDocFilename);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> ModuleDocOrErr =
-    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()));
+    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()),
+                                /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
   if (!ModuleDocOrErr &&
       ModuleDocOrErr.getError() != std::errc::no_such_file_or_directory) {
     return ModuleDocOrErr.getError();
@@ -162,12 +170,23 @@ FileUnit *SerializedModuleLoader::loadAST(
 
   serialization::ExtendedValidationInfo extendedInfo;
   std::unique_ptr<ModuleFile> loadedModuleFile;
+
+  // The module file is only created by loading it, so start charging its
+  // statistics before handing them over. The scope must end before the
+  // module file (which will own the statistics) is destroyed.
+  std::unique_ptr<ModuleFile::Statistics> stats;
+  if (CollectStatistics)
+    stats.reset(new ModuleFile::Statistics());
+  ModuleFile::StatisticsScope recordStatistics(stats.get(), nullptr);
+
   serialization::Status err = ModuleFile::load(std::move(moduleInputBuffer),
                                                std::move(moduleDocInputBuffer),
                                                isFramework, loadedModuleFile,
                                                &extendedInfo);
   if (err == serialization::Status::Valid) {
     Ctx.bumpGeneration();
+    if (stats)
+      loadedModuleFile->setStatistics(std::move(stats));
 
     // We've loaded the file. Now try to bring it into the AST.
     auto fileUnit = new (Ctx) SerializedASTFile(M, *loadedModuleFile,
@@ -410,6 +429,75 @@ void SerializedModuleLoader::verifyAllModules() {
 #endif
 }
 
+namespace {
+  struct ModuleFileStatisticsEntry {
+    std::string Name;
+    std::string Path;
+    ModuleFile::Statistics Stats;
+    uint64_t NumBytesRead;
+  };
+} // end anonymous namespace
+
+namespace swift {
+namespace json {
+  template<>
+  struct ObjectTraits<std::map<DeclKind, unsigned>> {
+    static void mapping(Output &out, std::map<DeclKind, unsigned> &counts) {
+      for (auto &entry : counts)
+        out.mapRequired(Decl::getKindName(entry.first).data(), entry.second);
+    }
+  };
+
+  template<>
+  struct ObjectTraits<ModuleFileStatisticsEntry> {
+    static void mapping(Output &out, ModuleFileStatisticsEntry &entry) {
+      out.mapRequired("module", entry.Name);
+      out.mapRequired("path", entry.Path);
+      out.mapRequired("time_us", entry.Stats.Time);
+      out.mapRequired("bytes_read", entry.NumBytesRead);
+      out.mapRequired("decls", entry.Stats.NumDecls);
+      out.mapRequired("cross_references", entry.Stats.NumCrossReferences);
+      out.mapRequired("types", entry.Stats.NumTypes);
+      out.mapRequired("conformances", entry.Stats.NumConformances);
+      out.mapRequired("sil_functions", entry.Stats.NumSILFunctions);
+    }
+  };
+
+  template<>
+  struct ArrayTraits<std::vector<ModuleFileStatisticsEntry>> {
+    static size_t size(Output &out,
+                       std::vector<ModuleFileStatisticsEntry> &seq) {
+      return seq.size();
+    }
+
+    static ModuleFileStatisticsEntry &
+    element(Output &out, std::vector<ModuleFileStatisticsEntry> &seq,
+            size_t index) {
+      if (index >= seq.size())
+        seq.resize(index+1);
+      return seq[index];
+    }
+  };
+} // end namespace json
+} // end namespace swift
+
+void SerializedModuleLoader::writeStatistics(raw_ostream &os) const {
+  // json::Output needs mutable values.
+  std::vector<ModuleFileStatisticsEntry> entries;
+  for (const LoadedModulePair &loaded : LoadedModuleFiles) {
+    const ModuleFile::Statistics *stats = loaded.first->getStatistics();
+    if (!stats)
+      continue;
+    entries.push_back({loaded.first->getModuleName().str(),
+                       loaded.first->getModuleFilename().str(), *stats,
+                       (stats->NumBitsRead + CHAR_BIT - 1) / CHAR_BIT});
+  }
+
+  json::Output out(os, /*PrettyPrint=*/false);
+  out << entries;
+  os << "\n";
+}
+
 //-----------------------------------------------------------------------------
 // SerializedASTFile implementation
 //-----------------------------------------------------------------------------
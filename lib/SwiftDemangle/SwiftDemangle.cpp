@@ -17,6 +17,8 @@
 
 #include "swift/Basic/DemangleWrappers.h"
 #include "swift/SwiftDemangle/SwiftDemangle.h"
+#include "llvm/ADT/StringMap.h"
+#include <list>
 
 /// \returns true if \p MangledName starts with Swift prefix, "_T".
 static bool isSwiftPrefixed(const char *MangledName) {
@@ -59,6 +61,90 @@ size_t swift_demangle_getSimplifiedDemangledName(const char *MangledName,
                                                  Length, Opts);
 }
 
+/// The demangling options and the least recently used cache of a
+/// swift_demangle_context_t.
+struct swift_demangle_context {
+  swift::Demangle::DemangleOptions Options;
+  size_t CacheSize;
+
+  /// A demangled name, or the empty string for a name that isn't mangled.
+  struct CacheEntry {
+    std::string MangledName;
+    std::string Result;
+  };
+
+  /// The cached names, most recently used first.
+  std::list<CacheEntry> Entries;
+  llvm::StringMap<std::list<CacheEntry>::iterator> EntriesByName;
+
+  /// Returns the demangling of \p MangledName, or the empty string if it
+  /// isn't a mangled name.
+  const std::string &demangle(const char *MangledName);
+
+private:
+  std::string Uncached;
+};
+
+const std::string &swift_demangle_context::demangle(const char *MangledName) {
+  auto Found = EntriesByName.find(MangledName);
+  if (Found != EntriesByName.end()) {
+    Entries.splice(Entries.begin(), Entries, Found->second);
+    return Found->second->Result;
+  }
+
+  std::string Result;
+  if (isSwiftPrefixed(MangledName)) {
+    Result = swift::demangle_wrappers::demangleSymbolAsString(MangledName,
+                                                              Options);
+    if (Result == MangledName)
+      Result.clear(); // Not a mangled name
+  }
+
+  if (CacheSize == 0) {
+    Uncached = std::move(Result);
+    return Uncached;
+  }
+
+  if (Entries.size() == CacheSize) {
+    EntriesByName.erase(Entries.back().MangledName);
+    Entries.pop_back();
+  }
+  Entries.push_front({MangledName, std::move(Result)});
+  EntriesByName[MangledName] = Entries.begin();
+  return Entries.front().Result;
+}
+
+swift_demangle_context_t swift_demangle_createContext(int Simplified,
+                                                      size_t CacheSize) {
+  auto *Context = new swift_demangle_context();
+  if (Simplified)
+    Context->Options =
+        swift::Demangle::DemangleOptions::SimplifiedUIDemangleOptions();
+  else
+    Context->Options.SynthesizeSugarOnTypes = true;
+  Context->CacheSize = CacheSize;
+  return Context;
+}
+
+void swift_demangle_destroyContext(swift_demangle_context_t Context) {
+  delete Context;
+}
+
+size_t swift_demangle_getDemangledNameWithContext(
+    swift_demangle_context_t Context, const char *MangledName,
+    char *OutputBuffer, size_t Length) {
+  assert(Context != nullptr && "null context");
+  assert(MangledName != nullptr && "null input");
+  assert(OutputBuffer != nullptr || Length == 0);
+
+  const std::string &Result = Context->demangle(MangledName);
+  if (Result.empty())
+    return 0; // Not a mangled name
+
+  // Copy the result to an output buffer.
+  return strlcpy(OutputBuffer, Result.c_str(), Length);
+}
+
 size_t fnd_get_demangled_name(const char *MangledName, char *OutputBuffer,
                               size_t Length) {
   return swift_demangle_getDemangledName(MangledName, OutputBuffer, Length);
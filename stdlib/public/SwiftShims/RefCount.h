@@ -100,6 +100,17 @@ class StrongRefCount {
     __atomic_fetch_add(&refCount, n << RC_FLAGS_COUNT, __ATOMIC_RELAXED);
   }
 
+  // Increment the reference count non-atomically.
+  // The caller must guarantee that no other thread can access the object.
+  void incrementNonAtomic() {
+    refCount += RC_ONE;
+  }
+
+  // Increment the reference count by n non-atomically.
+  void incrementNonAtomic(uint32_t n) {
+    refCount += n << RC_FLAGS_COUNT;
+  }
+
   // Try to simultaneously set the pinned flag and increment the
   // reference count.  If the flag is already set, don't increment the
   // reference count.
@@ -158,6 +169,17 @@ class StrongRefCount {
     return doDecrementShouldDeallocateN<false>(n);
   }
 
+  // Non-atomically decrement the reference count.
+  // Return true if the caller should now deallocate the object.
+  // The caller must guarantee that no other thread can access the object.
+  bool decrementShouldDeallocateNonAtomic() {
+    return doDecrementShouldDeallocateNonAtomic(RC_ONE);
+  }
+
+  bool decrementShouldDeallocateNNonAtomic(uint32_t n) {
+    return doDecrementShouldDeallocateNonAtomic(n << RC_FLAGS_COUNT);
+  }
+
   // Return the reference count.
   // During deallocation the reference count is undefined.
   uint32_t getCount() const {
@@ -230,6 +252,27 @@ private:
                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
   }
 
+  bool doDecrementShouldDeallocateNonAtomic(uint32_t delta) {
+    uint32_t newval = refCount - delta;
+
+    assert(newval + delta >= RC_ONE &&
+           "releasing reference with a refcount of zero");
+
+    // See doDecrementShouldDeallocate() for the masking trick.
+    if ((newval & (RC_COUNT_MASK | RC_PINNED_FLAG | RC_DEALLOCATING_FLAG))
+          != 0) {
+      refCount = newval;
+      return false;
+    }
+
+    // Refcount is now 0 and is not already deallocating. No other thread can
+    // reference the object, so the deallocating flag can be set directly.
+    static_assert(RC_FLAGS_COUNT == 2,
+                  "fix decrementShouldDeallocate() if you add more flags");
+    refCount = RC_DEALLOCATING_FLAG;
+    return true;
+  }
+
   template <bool ClearPinnedFlag>
   bool doDecrementShouldDeallocateN(uint32_t n) {
     // If we're being asked to clear the pinned flag, we can assume
@@ -274,10 +317,11 @@ class WeakRefCount {
   uint32_t refCount;
 
   enum : uint32_t {
-    // There isn't really a flag here.
+    // Set if weak references to the object go through a side table entry.
+    // Only used when the runtime is built with weak reference side tables.
     // Making weak RC_ONE == strong RC_ONE saves an
     // instruction in allocation on arm64.
-    RC_UNUSED_FLAG = 1,
+    RC_SIDE_TABLE_FLAG = 1,
 
     RC_FLAGS_COUNT = 1,
     RC_FLAGS_MASK = 1,
@@ -354,6 +398,16 @@ class WeakRefCount {
   uint32_t getCount() const {
     return __atomic_load_n(&refCount, __ATOMIC_RELAXED) >> RC_FLAGS_COUNT;
   }
+
+  // Mark the object as having a weak reference side table entry.
+  void setHasSideTable() {
+    __atomic_fetch_or(&refCount, RC_SIDE_TABLE_FLAG, __ATOMIC_RELAXED);
+  }
+
+  // Return true if the object has a weak reference side table entry.
+  bool hasSideTable() const {
+    return __atomic_load_n(&refCount, __ATOMIC_RELAXED) & RC_SIDE_TABLE_FLAG;
+  }
 };
 
 static_assert(swift::IsTriviallyConstructible<StrongRefCount>::value,
@@ -70,6 +70,8 @@ func _withUninitializedString<R>(
   return (bodyResult, stringResult)
 }
 
+/// The returned buffer is only guaranteed to be valid until the next call on
+/// the same thread; names past the runtime's cache limit are not kept.
 @_silgen_name("swift_getTypeName")
 public func _getTypeName(type: Any.Type, qualified: Bool)
   -> (UnsafePointer<UInt8>, Int)
@@ -136,6 +136,22 @@ extension String.CharacterView : CollectionType {
       }
 
       let startIndexUTF16 = start._position
+
+      // ASCII fast path: an ASCII scalar that is followed by another ASCII
+      // scalar (or nothing) forms a grapheme cluster of its own, unless the
+      // two are CR-LF.  This avoids the trie lookups for mostly-ASCII text.
+      let cu0 = start._core[startIndexUTF16]
+      if cu0 < 0x80 {
+        let nextUTF16 = startIndexUTF16 + 1
+        if nextUTF16 == end._position {
+          return 1
+        }
+        let cu1 = start._core[nextUTF16]
+        if cu1 < 0x80 {
+          return cu0 == 0x0D && cu1 == 0x0A ? 2 : 1 // CR-LF
+        }
+      }
+
       let unicodeScalars = UnicodeScalarView(start._core)
       let graphemeClusterBreakProperty =
           _UnicodeGraphemeClusterBreakPropertyTrie()
@@ -175,6 +191,17 @@ extension String.CharacterView : CollectionType {
       }
 
       let endIndexUTF16 = end._position
+
+      // ASCII fast path: there is always a boundary before an ASCII scalar,
+      // except for the LF in CR-LF.
+      let cu1 = end._core[endIndexUTF16 - 1]
+      if cu1 < 0x80 {
+        if cu1 != 0x0A || endIndexUTF16 - 1 == start._position {
+          return 1
+        }
+        return end._core[endIndexUTF16 - 2] == 0x0D ? 2 : 1
+      }
+
       let unicodeScalars = UnicodeScalarView(start._core)
       let graphemeClusterBreakProperty =
           _UnicodeGraphemeClusterBreakPropertyTrie()
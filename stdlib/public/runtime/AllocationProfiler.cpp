@@ -0,0 +1,526 @@
+//===--- AllocationProfiler.cpp - Sampling heap profiler ------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// A sampling allocation profiler in the style of tcmalloc's.
+//
+// Every thread counts down the bytes it allocates, and samples the
+// allocation which takes the count below zero. The distance between samples
+// is drawn from an exponential distribution with the requested mean, so that
+// pprof can estimate the unsampled totals from the sampled ones.
+//
+// Samples are grouped into buckets of identical stacks and types. Sampled
+// allocations are remembered until they are freed, which lets the profile
+// show what is in use as well as what was allocated. A small filter of
+// sampled addresses keeps the cost of frees that weren't sampled to one load.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/AllocationProfiler.h"
+#include "swift/Runtime/Metadata.h"
+#include "swift/Basic/Lazy.h"
+#include "Probes.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__APPLE__) || defined(__GLIBC__)
+#include <execinfo.h>
+#define SWIFT_HAVE_BACKTRACE 1
+#endif
+
+using namespace swift;
+using namespace swift::alloc_profiler;
+
+std::atomic<State> swift::alloc_profiler::CurrentState{State::Unknown};
+
+namespace {
+
+/// The mean distance between samples, in bytes, if SWIFT_ALLOCATION_PROFILE
+/// is set to 1.
+const size_t DefaultBytesPerSample = 512 * 1024;
+
+/// The number of frames recorded for each sample.
+const unsigned MaxFrames = 8;
+
+/// The frames of recordSample, noteAllocationSlow and swift_slowAlloc, which
+/// are the same for every sample.
+const unsigned SkippedFrames = 3;
+
+/// The number of bits in the filter of sampled addresses.
+const unsigned FilterBits = 1 << 16;
+
+struct Bucket {
+  void *Frames[MaxFrames];
+  unsigned NumFrames;
+  const void *Type;
+  uint64_t AllocCount = 0;
+  uint64_t AllocBytes = 0;
+  uint64_t InUseCount = 0;
+  uint64_t InUseBytes = 0;
+
+  bool hasSameStack(const Bucket &other) const {
+    return NumFrames == other.NumFrames &&
+           memcmp(Frames, other.Frames, NumFrames * sizeof(void *)) == 0;
+  }
+
+  size_t hash() const {
+    size_t result = std::hash<const void *>()(Type);
+    for (unsigned i = 0; i < NumFrames; ++i)
+      result = result * 31 + std::hash<void *>()(Frames[i]);
+    return result;
+  }
+};
+
+struct LiveSample {
+  unsigned BucketIndex;
+  size_t Bytes;
+};
+
+struct Profiler {
+  std::mutex Lock;
+  std::vector<Bucket> Buckets;
+  std::unordered_multimap<size_t, unsigned> BucketsByHash;
+  std::unordered_map<const void *, LiveSample> LiveSamples;
+
+  /// A bit for every address which might be a live sample.
+  std::atomic<uint64_t> Filter[FilterBits / 64];
+
+  /// The mean distance between samples, or 0 if sampling is stopped.
+  std::atomic<size_t> BytesPerSample{0};
+
+  /// Where the profiles requested by the environment are written.
+  std::string PathPrefix;
+  std::atomic<unsigned> NextDumpIndex{0};
+  int DumpPipe[2] = {-1, -1};
+
+  Profiler() {
+    for (auto &word : Filter)
+      word.store(0, std::memory_order_relaxed);
+  }
+
+  /// Returns the bucket with the same stack as \p prototype and the type
+  /// \p type, creating it if needed. Must be called with Lock held.
+  unsigned getBucket(const Bucket &prototype, const void *type) {
+    Bucket key = prototype;
+    key.Type = type;
+    key.AllocCount = key.AllocBytes = key.InUseCount = key.InUseBytes = 0;
+    size_t hash = key.hash();
+    auto range = BucketsByHash.equal_range(hash);
+    for (auto i = range.first; i != range.second; ++i) {
+      Bucket &bucket = Buckets[i->second];
+      if (bucket.Type == type && bucket.hasSameStack(key))
+        return i->second;
+    }
+    unsigned index = Buckets.size();
+    Buckets.push_back(key);
+    BucketsByHash.insert({hash, index});
+    return index;
+  }
+
+  static unsigned getFilterBit(const void *ptr) {
+    // Allocations are at least 16-byte aligned.
+    return (uintptr_t(ptr) >> 4) % FilterBits;
+  }
+
+  void addToFilter(const void *ptr) {
+    unsigned bit = getFilterBit(ptr);
+    Filter[bit / 64].fetch_or(uint64_t(1) << (bit % 64),
+                              std::memory_order_relaxed);
+  }
+
+  bool mayBeInFilter(const void *ptr) const {
+    unsigned bit = getFilterBit(ptr);
+    return Filter[bit / 64].load(std::memory_order_relaxed) &
+           (uint64_t(1) << (bit % 64));
+  }
+};
+
+} // end anonymous namespace
+
+// Never destroyed: allocations may still be freed after static destructors
+// have run.
+static Lazy<Profiler> TheProfiler;
+
+static Profiler &getProfiler() {
+  return TheProfiler.get();
+}
+
+/// The bytes this thread may still allocate before the next sample, or a
+/// negative value if no distance has been drawn yet.
+static __thread int64_t BytesUntilSample = -1;
+static __thread uint64_t RandomState;
+/// The last allocation of this thread which was sampled, so that its type
+/// can be added once swift_allocObject knows it.
+static __thread const void *LastSample;
+/// Set while the profiler itself runs, so that it never samples itself.
+static __thread bool InProfiler;
+
+/// Draws the distance to the next sample from an exponential distribution
+/// with mean \p mean.
+static int64_t getNextSampleDistance(size_t mean) {
+  if (!RandomState)
+    RandomState = (uint64_t(uintptr_t(&RandomState)) ^
+                   uint64_t(time(nullptr))) | 1;
+  // xorshift64*
+  RandomState ^= RandomState >> 12;
+  RandomState ^= RandomState << 25;
+  RandomState ^= RandomState >> 27;
+  uint64_t random = RandomState * UINT64_C(2685821657736338717);
+  double uniform = (random >> 11) * (1.0 / 9007199254740992.0);
+  return int64_t(-std::log(1.0 - uniform) * mean) + 1;
+}
+
+LLVM_ATTRIBUTE_NOINLINE
+static void recordSample(void *ptr, size_t size) {
+  InProfiler = true;
+
+  Bucket prototype;
+  prototype.NumFrames = 0;
+  prototype.Type = nullptr;
+#if SWIFT_HAVE_BACKTRACE
+  void *frames[MaxFrames + SkippedFrames];
+  int numFrames = backtrace(frames, MaxFrames + SkippedFrames);
+  for (int i = SkippedFrames; i < numFrames; ++i)
+    prototype.Frames[prototype.NumFrames++] = frames[i];
+#endif
+
+  auto &profiler = getProfiler();
+  {
+    std::lock_guard<std::mutex> guard(profiler.Lock);
+    unsigned index = profiler.getBucket(prototype, nullptr);
+    Bucket &bucket = profiler.Buckets[index];
+    bucket.AllocCount += 1;
+    bucket.AllocBytes += size;
+    bucket.InUseCount += 1;
+    bucket.InUseBytes += size;
+    profiler.LiveSamples[ptr] = {index, size};
+  }
+  profiler.addToFilter(ptr);
+  LastSample = ptr;
+
+  InProfiler = false;
+}
+
+static void appendFormat(std::string &out, const char *format, ...)
+  __attribute__((format(printf, 2, 3)));
+
+static void appendFormat(std::string &out, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0)
+    out.append(buffer, std::min(size_t(length), sizeof(buffer) - 1));
+}
+
+/// Returns a readable name for the type of a sampled object.
+static std::string getTypeName(const void *type) {
+  auto metadata = static_cast<const Metadata *>(type);
+  switch (metadata->getKind()) {
+  case MetadataKind::HeapLocalVariable:
+  case MetadataKind::HeapGenericLocalVariable:
+    return "<box>";
+  case MetadataKind::ErrorObject:
+    return "<error>";
+  default:
+    return nameForMetadata(metadata);
+  }
+}
+
+static bool writeAll(int fd, const std::string &data) {
+  const char *next = data.data();
+  size_t remaining = data.size();
+  while (remaining) {
+    ssize_t written = write(fd, next, remaining);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    next += written;
+    remaining -= written;
+  }
+  return true;
+}
+
+bool swift::swift_writeAllocationProfile(int fd) {
+  bool wasInProfiler = InProfiler;
+  InProfiler = true;
+
+  auto &profiler = getProfiler();
+  std::vector<Bucket> buckets;
+  {
+    std::lock_guard<std::mutex> guard(profiler.Lock);
+    buckets = profiler.Buckets;
+  }
+
+  Bucket totals;
+  for (auto &bucket : buckets) {
+    totals.AllocCount += bucket.AllocCount;
+    totals.AllocBytes += bucket.AllocBytes;
+    totals.InUseCount += bucket.InUseCount;
+    totals.InUseBytes += bucket.InUseBytes;
+  }
+
+  // The type of each sample is its innermost frame, so that pprof shows the
+  // types as callees of the allocating functions. Names of the types are
+  // added as comments, which pprof ignores.
+  std::string out;
+  size_t bytesPerSample = profiler.BytesPerSample.load(
+                            std::memory_order_relaxed);
+  if (!bytesPerSample)
+    bytesPerSample = DefaultBytesPerSample;
+  appendFormat(out, "heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%llu\n",
+               (unsigned long long)totals.InUseCount,
+               (unsigned long long)totals.InUseBytes,
+               (unsigned long long)totals.AllocCount,
+               (unsigned long long)totals.AllocBytes,
+               (unsigned long long)bytesPerSample);
+  std::vector<const void *> types;
+  for (auto &bucket : buckets) {
+    if (!bucket.AllocCount)
+      continue;
+    appendFormat(out, "%llu: %llu [%llu: %llu] @",
+                 (unsigned long long)bucket.InUseCount,
+                 (unsigned long long)bucket.InUseBytes,
+                 (unsigned long long)bucket.AllocCount,
+                 (unsigned long long)bucket.AllocBytes);
+    if (bucket.Type) {
+      appendFormat(out, " %p", bucket.Type);
+      if (std::find(types.begin(), types.end(), bucket.Type) == types.end())
+        types.push_back(bucket.Type);
+    }
+    for (unsigned i = 0; i < bucket.NumFrames; ++i)
+      appendFormat(out, " %p", bucket.Frames[i]);
+    out += "\n";
+  }
+  for (const void *type : types) {
+    appendFormat(out, "# type %p: ", type);
+    out += getTypeName(type);
+    out += "\n";
+  }
+
+#if defined(__linux__)
+  // Let pprof map the addresses to the loaded images.
+  out += "\nMAPPED_LIBRARIES:\n";
+  int maps = open("/proc/self/maps", O_RDONLY);
+  if (maps >= 0) {
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(maps, buffer, sizeof(buffer))) > 0)
+      out.append(buffer, length);
+    close(maps);
+  }
+#endif
+
+  bool result = writeAll(fd, out);
+  InProfiler = wasInProfiler;
+  return result;
+}
+
+/// Writes a profile to the next file named by SWIFT_ALLOCATION_PROFILE_PATH.
+static void dumpToFile() {
+  auto &profiler = getProfiler();
+  char path[1024];
+  snprintf(path, sizeof(path), "%s.%d.%u.heap", profiler.PathPrefix.c_str(),
+           int(getpid()), profiler.NextDumpIndex++);
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || !swift_writeAllocationProfile(fd))
+    fprintf(stderr, "swift allocation profiler: cannot write %s: %s\n", path,
+            strerror(errno));
+  else
+    fprintf(stderr, "swift allocation profiler: wrote %s\n", path);
+  if (fd >= 0)
+    close(fd);
+}
+
+/// The signal handler only wakes up the dump thread, because writing a
+/// profile isn't async-signal-safe.
+static void handleDumpSignal(int) {
+  int savedErrno = errno;
+  char c = 0;
+  (void)write(TheProfiler.unsafeGetAlreadyInitialized().DumpPipe[1], &c, 1);
+  errno = savedErrno;
+}
+
+static void *runDumpThread(void *) {
+  auto &profiler = getProfiler();
+  while (true) {
+    char c;
+    ssize_t length = read(profiler.DumpPipe[0], &c, 1);
+    if (length == 1)
+      dumpToFile();
+    else if (length < 0 && errno == EINTR)
+      continue;
+    else
+      return nullptr;
+  }
+}
+
+static void installDumpSignalHandler(int signal) {
+  auto &profiler = getProfiler();
+  if (pipe(profiler.DumpPipe) != 0)
+    return;
+  pthread_t thread;
+  if (pthread_create(&thread, nullptr, runDumpThread, nullptr) != 0)
+    return;
+  pthread_detach(thread);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = handleDumpSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(signal, &action, nullptr);
+}
+
+/// Reads the SWIFT_ALLOCATION_PROFILE variables and starts the profiler if
+/// they ask for it.
+static void initializeFromEnvironment() {
+  State expected = State::Unknown;
+  const char *value = getenv("SWIFT_ALLOCATION_PROFILE");
+  size_t bytesPerSample = value ? strtoull(value, nullptr, 10) : 0;
+  if (!bytesPerSample) {
+    // Don't override an explicit swift_startAllocationProfiler call.
+    CurrentState.compare_exchange_strong(expected, State::Disabled,
+                                         std::memory_order_relaxed);
+    return;
+  }
+  if (bytesPerSample == 1)
+    bytesPerSample = DefaultBytesPerSample;
+
+  auto &profiler = getProfiler();
+  if (!CurrentState.compare_exchange_strong(expected, State::Enabled,
+                                            std::memory_order_relaxed))
+    return;
+  profiler.BytesPerSample.store(bytesPerSample, std::memory_order_relaxed);
+
+  const char *prefix = getenv("SWIFT_ALLOCATION_PROFILE_PATH");
+  profiler.PathPrefix = prefix && *prefix ? prefix : "swift-alloc";
+  atexit(dumpToFile);
+
+  const char *signal = getenv("SWIFT_ALLOCATION_PROFILE_SIGNAL");
+  int signalNumber = signal ? atoi(signal) : SIGUSR2;
+  if (signalNumber > 0)
+    installDumpSignalHandler(signalNumber);
+}
+
+void swift::alloc_profiler::noteAllocationSlow(void *ptr, size_t size) {
+  if (InProfiler)
+    return;
+  if (CurrentState.load(std::memory_order_relaxed) == State::Unknown) {
+    InProfiler = true;
+    initializeFromEnvironment();
+    InProfiler = false;
+  }
+  if (CurrentState.load(std::memory_order_relaxed) != State::Enabled)
+    return;
+
+  size_t bytesPerSample =
+    getProfiler().BytesPerSample.load(std::memory_order_relaxed);
+  if (!bytesPerSample)
+    return;
+
+  if (LLVM_UNLIKELY(BytesUntilSample < 0))
+    BytesUntilSample = getNextSampleDistance(bytesPerSample);
+  BytesUntilSample -= size;
+  if (LLVM_LIKELY(BytesUntilSample > 0))
+    return;
+
+  BytesUntilSample = getNextSampleDistance(bytesPerSample);
+  recordSample(ptr, size);
+}
+
+void swift::alloc_profiler::noteObjectTypeSlow(const void *object,
+                                               const void *type) {
+  if (object != LastSample)
+    return;
+
+  auto &profiler = getProfiler();
+  std::lock_guard<std::mutex> guard(profiler.Lock);
+  auto found = profiler.LiveSamples.find(object);
+  if (found == profiler.LiveSamples.end())
+    return;
+
+  LiveSample &sample = found->second;
+  Bucket &oldBucket = profiler.Buckets[sample.BucketIndex];
+  if (oldBucket.Type == type)
+    return;
+  oldBucket.AllocCount -= 1;
+  oldBucket.AllocBytes -= sample.Bytes;
+  oldBucket.InUseCount -= 1;
+  oldBucket.InUseBytes -= sample.Bytes;
+
+  // Copy the stack first: getBucket may reallocate the buckets.
+  Bucket prototype = oldBucket;
+  sample.BucketIndex = profiler.getBucket(prototype, type);
+  Bucket &newBucket = profiler.Buckets[sample.BucketIndex];
+  newBucket.AllocCount += 1;
+  newBucket.AllocBytes += sample.Bytes;
+  newBucket.InUseCount += 1;
+  newBucket.InUseBytes += sample.Bytes;
+}
+
+void swift::alloc_profiler::noteDeallocationSlow(void *ptr) {
+  auto &profiler = getProfiler();
+  if (!profiler.mayBeInFilter(ptr))
+    return;
+
+  if (ptr == LastSample)
+    LastSample = nullptr;
+  std::lock_guard<std::mutex> guard(profiler.Lock);
+  auto found = profiler.LiveSamples.find(ptr);
+  if (found == profiler.LiveSamples.end())
+    return;
+  Bucket &bucket = profiler.Buckets[found->second.BucketIndex];
+  bucket.InUseCount -= 1;
+  bucket.InUseBytes -= found->second.Bytes;
+  profiler.LiveSamples.erase(found);
+}
+
+void swift::swift_startAllocationProfiler(size_t bytesPerSample) {
+  if (!bytesPerSample)
+    bytesPerSample = DefaultBytesPerSample;
+  getProfiler().BytesPerSample.store(bytesPerSample,
+                                     std::memory_order_relaxed);
+  CurrentState.store(State::Enabled, std::memory_order_relaxed);
+}
+
+void swift::swift_stopAllocationProfiler() {
+  // Stay enabled, so that frees of sampled allocations are still seen.
+  getProfiler().BytesPerSample.store(0, std::memory_order_relaxed);
+}
+
+void swift::swift_resetAllocationProfile() {
+  auto &profiler = getProfiler();
+  std::lock_guard<std::mutex> guard(profiler.Lock);
+  profiler.Buckets.clear();
+  profiler.BucketsByHash.clear();
+  profiler.LiveSamples.clear();
+  for (auto &word : profiler.Filter)
+    word.store(0, std::memory_order_relaxed);
+}
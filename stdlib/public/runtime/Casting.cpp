@@ -25,10 +25,12 @@
 #include "swift/Runtime/Metadata.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PointerIntPair.h"
+#include "llvm/ADT/SmallVector.h"
 #include "swift/Runtime/Debug.h"
 #include "ErrorObject.h"
 #include "ExistentialMetadataImpl.h"
 #include "Private.h"
+#include "Probes.h"
 #include "../SwiftShims/RuntimeShims.h"
 #include "stddef.h"
 
@@ -41,6 +43,7 @@
 #endif
 
 #include <dlfcn.h>
+#include <algorithm>
 #include <cstring>
 #include <mutex>
 #include <atomic>
@@ -351,46 +354,100 @@ std::string swift::nameForMetadata(const Metadata *type,
   return result;
 }
 
+// Type name cache.
+//
+// Names are cached per (metadata, qualified) pair in a concurrent map, so a
+// repeated lookup takes no locks and doesn't rebuild the string. A name, once
+// cached, is never modified or freed. The memory used by cached names is
+// bounded by SWIFT_DEBUG_TYPE_NAME_CACHE_LIMIT bytes (1 MiB by default, 0
+// disables the cache); beyond that, names are built into a per-thread buffer
+// which is reused by the next call on the same thread.
+
+namespace {
+  struct TypeNameCacheEntry {
+    const Metadata *Type;
+    bool Qualified;
+    const char *Name;
+    size_t Length;
+  };
+
+  struct TypeNameCacheState {
+    ConcurrentMap<size_t, TypeNameCacheEntry> Cache;
+
+    /// The number of bytes left for new cache entries.
+    std::atomic<size_t> RemainingBytes;
+
+    /// Holds the per-thread buffer for names which don't fit in the cache.
+    pthread_key_t BufferKey;
+
+    TypeNameCacheState() {
+      size_t limit = 1024 * 1024;
+      if (const char *env = getenv("SWIFT_DEBUG_TYPE_NAME_CACHE_LIMIT"))
+        limit = strtoul(env, nullptr, 10);
+      RemainingBytes.store(limit, std::memory_order_relaxed);
+      pthread_key_create(&BufferKey, destroyThreadBuffer);
+    }
+
+    static void destroyThreadBuffer(void *buffer) {
+      delete static_cast<std::string *>(buffer);
+    }
+
+    /// Reserve \p size bytes of the budget. Returns false if the cache is
+    /// full.
+    bool reserve(size_t size) {
+      auto remaining = RemainingBytes.load(std::memory_order_relaxed);
+      do {
+        if (remaining < size)
+          return false;
+      } while (!RemainingBytes.compare_exchange_weak(
+                 remaining, remaining - size, std::memory_order_relaxed));
+      return true;
+    }
+
+    std::string &getThreadBuffer() {
+      auto buffer = static_cast<std::string *>(pthread_getspecific(BufferKey));
+      if (!buffer) {
+        buffer = new std::string();
+        pthread_setspecific(BufferKey, buffer);
+      }
+      return *buffer;
+    }
+  };
+}
+
+static Lazy<TypeNameCacheState> TypeNameCache;
+
 extern "C"
 TwoWordPair<const char *, uintptr_t>::Return
 swift_getTypeName(const Metadata *type, bool qualified) {
   using Pair = TwoWordPair<const char *, uintptr_t>;
-  using Key = llvm::PointerIntPair<const Metadata *, 1, bool>;
-  
-  static pthread_rwlock_t TypeNameCacheLock = PTHREAD_RWLOCK_INITIALIZER;
-  static Lazy<llvm::DenseMap<Key, std::pair<const char *, size_t>>>
-    TypeNameCache;
-  
-  Key key(type, qualified);
-  auto &cache = TypeNameCache.get();
-  
-  pthread_rwlock_rdlock(&TypeNameCacheLock);
-  auto found = cache.find(key);
-  if (found != cache.end()) {
-    auto result = found->second;
-    pthread_rwlock_unlock(&TypeNameCacheLock);
-    return Pair{result.first, result.second};
-  }
-  
-  pthread_rwlock_unlock(&TypeNameCacheLock);
-  pthread_rwlock_wrlock(&TypeNameCacheLock);
-  // Someone may have beaten us to the write lock.
-  found = cache.find(key);
-  if (found != cache.end()) {
-    auto result = found->second;
-    pthread_rwlock_unlock(&TypeNameCacheLock);
-    return Pair{result.first, result.second};
-  }
-  
+
+  auto &state = TypeNameCache.get();
+  auto &bucket = state.Cache.findOrAllocateNode(
+    ((size_t)type >> 3) ^ (size_t)qualified);
+  for (auto &entry : bucket)
+    if (entry.Type == type && entry.Qualified == qualified)
+      return Pair{entry.Name, entry.Length};
+
   // Build the metadata name.
   auto name = nameForMetadata(type, qualified);
-  // Copy it to memory we can reference forever.
   auto size = name.size();
+
+  // If it doesn't fit in the cache, hand out the per-thread buffer.
+  auto entrySize = sizeof(ConcurrentListNode<TypeNameCacheEntry>) + size + 1;
+  if (!state.reserve(entrySize)) {
+    auto &buffer = state.getThreadBuffer();
+    buffer = std::move(name);
+    return Pair{buffer.c_str(), size};
+  }
+
+  // Copy it to memory we can reference forever. If another thread adds the
+  // same name concurrently, both entries stay valid and the first one in the
+  // bucket is returned from then on.
   auto result = (char*)malloc(size + 1);
   memcpy(result, name.data(), size);
   result[size] = 0;
-  cache.insert({key, {result, size}});
-  pthread_rwlock_unlock(&TypeNameCacheLock);
+  bucket.push_front(TypeNameCacheEntry{type, qualified, result, size});
   return Pair{result, size};
 }
 
@@ -1970,11 +2027,286 @@ static id dynamicCastValueToNSError(OpaqueValue *src,
 #endif
 
 /// Perform a dynamic cast to an arbitrary type.
+// Cast strategy cache.
+//
+// When the source of a cast is a concrete, non-polymorphic value, the
+// outcome of casting it to an existential or to a class type depends only
+// on the pair of types. We resolve such casts once, remember the strategy
+// together with the witness tables it needs, and replay it on later casts
+// of the same pair. The strategy does not depend on the cast flags; they
+// are applied when the strategy is executed.
+
+namespace {
+  enum class CastStrategy : uint8_t {
+    /// The cast always fails. Only valid as long as no new conformances
+    /// have been registered since it was recorded.
+    Fail,
+    /// Wrap the value in an opaque existential with the cached witness
+    /// tables.
+    OpaqueExistential,
+    /// Box the value as an ErrorType with the cached witness table.
+    ErrorExistential,
+#if SWIFT_OBJC_INTEROP
+    /// Bridge the value to a class via its cached _ObjectiveCBridgeable
+    /// witness table.
+    ValueToClassViaBridge,
+#endif
+  };
+
+  struct CastCacheEntry {
+    const Metadata *SrcType;
+    const Metadata *TargetType;
+    CastStrategy Strategy;
+    /// For Fail entries, the conformance generation they were recorded in.
+    unsigned Generation;
+    /// The witness tables used by the strategy.
+    const WitnessTable * const *WitnessTables;
+
+    bool matches(const Metadata *srcType, const Metadata *targetType) const {
+      return SrcType == srcType && TargetType == targetType;
+    }
+  };
+
+  struct CastCacheState {
+    ConcurrentMap<size_t, CastCacheEntry> Cache;
+    MetadataAllocator Allocator;
+
+    std::atomic<uint64_t> Hits{0};
+    std::atomic<uint64_t> Misses{0};
+    std::atomic<uint64_t> Uncacheable{0};
+
+    /// Counting is opt-in through SWIFT_DEBUG_DYNAMIC_CAST_CACHE_STATISTICS,
+    /// so that the shared counters don't add contention by default.
+    bool CountStatistics;
+
+    CastCacheState() {
+      const char *env = getenv("SWIFT_DEBUG_DYNAMIC_CAST_CACHE_STATISTICS");
+      CountStatistics = env && env[0] && env[0] != '0';
+    }
+
+    void count(std::atomic<uint64_t> &counter) {
+      if (LLVM_UNLIKELY(CountStatistics))
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+}
+
+static Lazy<CastCacheState> CastCache;
+
+/// Returns the number of conformance sections registered so far; a cached
+/// negative answer is only valid for the generation it was recorded in.
+static unsigned getConformanceGeneration();
+
+static size_t hashCastTypePair(const Metadata *srcType,
+                               const Metadata *targetType) {
+  return (size_t)srcType ^ ((size_t)targetType >> 3);
+}
+
+/// Whether the dynamic type of a value of this type is always the type
+/// itself.
+static bool isCacheableCastSource(const Metadata *srcType) {
+  switch (srcType->getKind()) {
+  case MetadataKind::Struct:
+  case MetadataKind::Enum:
+  case MetadataKind::Tuple:
+  case MetadataKind::Function:
+  case MetadataKind::Opaque:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Work out how a value of the concrete type \p srcType is cast to
+/// \p targetType. Returns false if the outcome cannot be determined from the
+/// types alone.
+static bool resolveCastStrategy(const Metadata *srcType,
+                                const Metadata *targetType,
+                                CastCacheState &state,
+                                CastCacheEntry &entry) {
+  entry.SrcType = srcType;
+  entry.TargetType = targetType;
+  entry.Generation = getConformanceGeneration();
+  entry.WitnessTables = nullptr;
+
+  switch (targetType->getKind()) {
+  case MetadataKind::Existential: {
+    auto existentialType = cast<ExistentialTypeMetadata>(targetType);
+    auto &protocols = existentialType->Protocols;
+    unsigned numWitnessTables = existentialType->Flags.getNumWitnessTables();
+
+    switch (existentialType->getRepresentation()) {
+    case ExistentialTypeRepresentation::Class:
+#if SWIFT_OBJC_INTEROP
+      // Values may be bridged to class existentials.
+      if (findBridgeWitness(srcType))
+        return false;
+#endif
+      // A value can't conform to a class-bounded protocol.
+      if (_conformsToProtocols(nullptr, srcType, protocols, nullptr))
+        return false;
+      entry.Strategy = CastStrategy::Fail;
+      return true;
+
+    case ExistentialTypeRepresentation::Opaque:
+    case ExistentialTypeRepresentation::ErrorType: {
+      llvm::SmallVector<const WitnessTable *, 4> found(numWitnessTables);
+      if (!_conformsToProtocols(nullptr, srcType, protocols, found.data())) {
+        entry.Strategy = CastStrategy::Fail;
+        return true;
+      }
+      if (numWitnessTables) {
+        auto witnessTables = reinterpret_cast<const WitnessTable **>(
+          state.Allocator.alloc(numWitnessTables
+                                  * sizeof(const WitnessTable *)));
+        std::copy(found.begin(), found.end(), witnessTables);
+        entry.WitnessTables = witnessTables;
+      }
+      entry.Strategy = existentialType->getRepresentation()
+                           == ExistentialTypeRepresentation::Opaque
+        ? CastStrategy::OpaqueExistential
+        : CastStrategy::ErrorExistential;
+      return true;
+    }
+    }
+    return false;
+  }
+
+  case MetadataKind::Class:
+  case MetadataKind::ObjCClassWrapper:
+  case MetadataKind::ForeignClass:
+    // Only values of nominal type may be bridged to classes.
+    if (srcType->getKind() != MetadataKind::Struct &&
+        srcType->getKind() != MetadataKind::Enum) {
+      entry.Strategy = CastStrategy::Fail;
+      return true;
+    }
+#if SWIFT_OBJC_INTEROP
+    // ErrorType values are bridged to NSError by boxing.
+    if (targetType == getNSErrorTypeMetadata())
+      return false;
+    if (auto srcBridgeWitness = findBridgeWitness(srcType)) {
+      auto witnessTables = reinterpret_cast<const WitnessTable **>(
+        state.Allocator.alloc(sizeof(const WitnessTable *)));
+      witnessTables[0] = srcBridgeWitness;
+      entry.WitnessTables = witnessTables;
+      entry.Strategy = CastStrategy::ValueToClassViaBridge;
+      return true;
+    }
+#endif
+    entry.Strategy = CastStrategy::Fail;
+    return true;
+
+  default:
+    // The remaining casts are either cheap or depend on the value itself.
+    return false;
+  }
+}
+
+/// Perform a cast according to a cached strategy.
+static bool performCachedCast(const CastCacheEntry &entry,
+                              OpaqueValue *dest, OpaqueValue *src,
+                              const Metadata *srcType,
+                              const Metadata *targetType,
+                              DynamicCastFlags flags) {
+  switch (entry.Strategy) {
+  case CastStrategy::Fail:
+    return _fail(src, srcType, targetType, flags);
+
+  case CastStrategy::OpaqueExistential: {
+    auto existentialType = cast<ExistentialTypeMetadata>(targetType);
+    auto destExistential = reinterpret_cast<OpaqueExistentialContainer*>(dest);
+    unsigned numWitnessTables = existentialType->Flags.getNumWitnessTables();
+    auto destWitnessTables = destExistential->getWitnessTables();
+    for (unsigned i = 0; i != numWitnessTables; ++i)
+      destWitnessTables[i] = entry.WitnessTables[i];
+
+    destExistential->Type = srcType;
+    if (flags & DynamicCastFlags::TakeOnSuccess)
+      srcType->vw_initializeBufferWithTake(&destExistential->Buffer, src);
+    else
+      srcType->vw_initializeBufferWithCopy(&destExistential->Buffer, src);
+    return true;
+  }
+
+  case CastStrategy::ErrorExistential: {
+    BoxPair destBox = swift_allocError(srcType, entry.WitnessTables[0], src,
+                          /*isTake*/ bool(flags & DynamicCastFlags::TakeOnSuccess));
+    *reinterpret_cast<SwiftError**>(dest) =
+      reinterpret_cast<SwiftError*>(destBox.first);
+    return true;
+  }
+
+#if SWIFT_OBJC_INTEROP
+  case CastStrategy::ValueToClassViaBridge:
+    return _dynamicCastValueToClassViaObjCBridgeable(dest, src, srcType,
+                                                     targetType,
+                                                     entry.WitnessTables[0],
+                                                     flags);
+#endif
+  }
+  _failCorruptType(srcType);
+}
+
+/// Try to perform a cast from a concrete source type using the cast strategy
+/// cache, resolving and caching the strategy if necessary. Returns false if
+/// the cast has to take the general path; otherwise the result of the cast
+/// is stored in \p result.
+static bool tryCachedCast(OpaqueValue *dest, OpaqueValue *src,
+                          const Metadata *srcType,
+                          const Metadata *targetType,
+                          DynamicCastFlags flags, bool &result) {
+  auto &state = CastCache.get();
+  size_t hash = hashCastTypePair(srcType, targetType);
+  ConcurrentList<CastCacheEntry> &Bucket = state.Cache.findOrAllocateNode(hash);
+
+  // The most recently added matching entry is the first one in the bucket.
+  for (auto &Entry : Bucket) {
+    if (!Entry.matches(srcType, targetType)) continue;
+    if (Entry.Strategy == CastStrategy::Fail &&
+        Entry.Generation != getConformanceGeneration())
+      break;
+    state.count(state.Hits);
+    result = performCachedCast(Entry, dest, src, srcType, targetType, flags);
+    return true;
+  }
+
+  CastCacheEntry entry;
+  if (!resolveCastStrategy(srcType, targetType, state, entry)) {
+    state.count(state.Uncacheable);
+    return false;
+  }
+  state.count(state.Misses);
+  Bucket.push_front(entry);
+  result = performCachedCast(entry, dest, src, srcType, targetType, flags);
+  return true;
+}
+
+void swift::swift_getDynamicCastCacheStatistics(uint64_t *hits,
+                                                uint64_t *misses,
+                                                uint64_t *uncacheable) {
+  auto &state = CastCache.get();
+  *hits = state.Hits.load(std::memory_order_relaxed);
+  *misses = state.Misses.load(std::memory_order_relaxed);
+  *uncacheable = state.Uncacheable.load(std::memory_order_relaxed);
+}
+
 bool swift::swift_dynamicCast(OpaqueValue *dest,
                               OpaqueValue *src,
                               const Metadata *srcType,
                               const Metadata *targetType,
                               DynamicCastFlags flags) {
+  SWIFT_DYNAMICCAST((void *)srcType, (void *)targetType);
+  SWIFT_RUNTIME_STATISTIC(DynamicCasts);
+
+  // Casts from concrete values to existentials and classes are resolved
+  // once per type pair.
+  if (isCacheableCastSource(srcType) && srcType != targetType) {
+    bool result;
+    if (tryCachedCast(dest, src, srcType, targetType, flags, result))
+      return result;
+  }
+
   switch (targetType->getKind()) {
 
   // Casts to class type.
@@ -2147,7 +2479,7 @@ void ProtocolConformanceRecord::dump() const {
              kind == ProtocolConformanceTypeKind::UniqueDirectType
              ? "unique" : "nonunique");
       if (auto ntd = getDirectType()->getNominalTypeDescriptor()) {
-        printf("%s", ntd->Name);
+        printf("%s", ntd->Name.get());
       } else {
         printf("<structural type>");
       }
@@ -2236,14 +2568,52 @@ const {
 static std::once_flag InstallProtocolConformanceAddImageCallbackOnce;
 
 namespace {
+  /// An entry in the lookup index of a conformance section. The type is
+  /// either the canonical type metadata or the generic pattern the record
+  /// applies to.
+  struct ConformanceIndexEntry {
+    const ProtocolDescriptor *Protocol;
+    const void *Type;
+    const ProtocolConformanceRecord *Record;
+
+    bool operator<(const ConformanceIndexEntry &other) const {
+      if (Protocol != other.Protocol)
+        return std::less<const ProtocolDescriptor *>()(Protocol,
+                                                       other.Protocol);
+      return std::less<const void *>()(Type, other.Type);
+    }
+  };
+
   struct ConformanceSection {
     const ProtocolConformanceRecord *Begin, *End;
+
+    /// The records of the section that apply to a single type or a unique
+    /// generic pattern, sorted by protocol and type. Built when the section
+    /// is first scanned rather than when the image is registered, because
+    /// resolving the type of a record may require instantiating metadata.
+    std::vector<ConformanceIndexEntry> Index;
+    bool IsIndexed = false;
+
+    ConformanceSection(const ProtocolConformanceRecord *begin,
+                       const ProtocolConformanceRecord *end)
+      : Begin(begin), End(end) {}
+
     const ProtocolConformanceRecord *begin() const {
       return Begin;
     }
     const ProtocolConformanceRecord *end() const {
       return End;
     }
+
+    /// Build the lookup index for this section.
+    void buildIndex();
+
+    /// Find the records for the conformance of \p type to \p protocol.
+    std::pair<const ConformanceIndexEntry *, const ConformanceIndexEntry *>
+    lookup(const ProtocolDescriptor *protocol, const void *type) const {
+      ConformanceIndexEntry key{protocol, type, nullptr};
+      return std::equal_range(Index.data(), Index.data() + Index.size(), key);
+    }
   };
 
   struct ConformanceCacheEntry {
@@ -2332,10 +2702,69 @@ namespace {
 
 // Conformance Cache.
 
+void ConformanceSection::buildIndex() {
+  assert(!IsIndexed);
+  Index.reserve(End - Begin);
+  for (const auto &record : *this) {
+    // If the record applies to a specific type, index it by that type.
+    if (auto metadata = record.getCanonicalTypeMetadata()) {
+      Index.push_back({record.getProtocol(), metadata, &record});
+
+    // If the record provides a nondependent witness table for all instances
+    // of a generic type, index it by the generic pattern.
+    // TODO: "Nondependent witness table" probably deserves its own flag.
+    // An accessor function might still be necessary even if the witness table
+    // can be shared.
+    } else if (record.getTypeKind()
+                 == ProtocolConformanceTypeKind::UniqueGenericPattern
+               && record.getConformanceKind()
+                 == ProtocolConformanceReferenceKind::WitnessTable) {
+      Index.push_back({record.getProtocol(), record.getGenericPattern(),
+                       &record});
+    }
+  }
+  std::sort(Index.begin(), Index.end());
+  IsIndexed = true;
+}
+
 struct ConformanceState {
   ConcurrentMap<size_t, ConformanceCacheEntry> Cache;
   std::vector<ConformanceSection> SectionsToScan;
   pthread_mutex_t SectionsToScanLock;
+
+  /// The number of sections registered so far. Unlike SectionsToScan, this
+  /// can be read without holding the lock.
+  std::atomic<unsigned> NumRegisteredSections{0};
+
+  /// The number of sections at the front of SectionsToScan whose index has
+  /// been built.
+  unsigned NumIndexedSections = 0;
+
+  /// For every protocol, one past the index of the last section that has
+  /// conformances to it. A negative cache entry recorded under generation
+  /// G stays valid as long as this is at most G.
+  llvm::DenseMap<const ProtocolDescriptor *, unsigned> SectionLimitForProtocol;
+
+  /// Index any sections that were registered since the last call.
+  /// Must be called with SectionsToScanLock held.
+  void indexNewSections() {
+    for (; NumIndexedSections < SectionsToScan.size(); ++NumIndexedSections) {
+      auto &section = SectionsToScan[NumIndexedSections];
+      section.buildIndex();
+      for (auto &entry : section.Index)
+        SectionLimitForProtocol[entry.Protocol] = NumIndexedSections + 1;
+    }
+  }
+
+  /// Returns true if any section at or after \p sectionIdx has conformances
+  /// to \p protocol. Must be called with SectionsToScanLock held, after
+  /// indexNewSections.
+  bool hasConformancesSince(const ProtocolDescriptor *protocol,
+                            unsigned sectionIdx) const {
+    auto found = SectionLimitForProtocol.find(protocol);
+    return found != SectionLimitForProtocol.end()
+        && found->second > sectionIdx;
+  }
   
   ConformanceState() {
     SectionsToScan.reserve(16);
@@ -2356,15 +2785,19 @@ swift::swift_registerProtocolConformances(const ProtocolConformanceRecord *begin
 
   pthread_mutex_lock(&C.SectionsToScanLock);
 
-  C.SectionsToScan.push_back(ConformanceSection{begin, end});
+  C.SectionsToScan.push_back(ConformanceSection(begin, end));
+  C.NumRegisteredSections.store(C.SectionsToScan.size(),
+                                std::memory_order_release);
 
   pthread_mutex_unlock(&C.SectionsToScanLock);
 }
 
 static void _addImageProtocolConformancesBlock(const uint8_t *conformances,
-                                               size_t conformancesSize) {
+                                               size_t conformancesSize,
+                                            startup_profile::Timer &timer) {
   assert(conformancesSize % sizeof(ProtocolConformanceRecord) == 0
          && "weird-sized conformances section?!");
+  timer.setCount(conformancesSize / sizeof(ProtocolConformanceRecord));
 
   // If we have a section, enqueue the conformances for lookup.
   auto recordsBegin
@@ -2384,6 +2817,8 @@ static void _addImageProtocolConformances(const mach_header *mh,
 #else
   using mach_header_platform = mach_header;
 #endif
+  startup_profile::Timer timer(startup_profile::Phase::Conformances, mh);
+  timer.setCount(0);
   
   // Look for a __swift2_proto section.
   unsigned long conformancesSize;
@@ -2395,11 +2830,17 @@ static void _addImageProtocolConformances(const mach_header *mh,
   if (!conformances)
     return;
   
-  _addImageProtocolConformancesBlock(conformances, conformancesSize);
+  _addImageProtocolConformancesBlock(conformances, conformancesSize, timer);
 }
 #elif defined(__ELF__)
 static int _addImageProtocolConformances(struct dl_phdr_info *info,
                                           size_t size, void * /*data*/) {
+  // The program headers are mapped from the image itself, so they identify
+  // it even for a non-PIE executable, whose load address is 0.
+  startup_profile::Timer timer(startup_profile::Phase::Conformances,
+                               info->dlpi_phdr);
+  timer.setCount(0);
+
   void *handle;
   if (!info->dlpi_name || info->dlpi_name[0] == '\0') {
     handle = dlopen(nullptr, RTLD_LAZY);
@@ -2418,7 +2859,7 @@ static int _addImageProtocolConformances(struct dl_phdr_info *info,
   auto conformancesSize = *reinterpret_cast<const uint64_t*>(conformances);
   conformances += sizeof(conformancesSize);
 
-  _addImageProtocolConformancesBlock(conformances, conformancesSize);
+  _addImageProtocolConformancesBlock(conformances, conformancesSize, timer);
 
   dlclose(handle);
   return 0;
@@ -2447,6 +2888,13 @@ static void installCallbacksToInspectDylib() {
   SWIFT_ONCE_F(token, callback, nullptr);
 }
 
+static unsigned getConformanceGeneration() {
+  // Make sure the sections of the images loaded so far are registered.
+  installCallbacksToInspectDylib();
+  return Conformances.get().NumRegisteredSections.load(
+                                                   std::memory_order_acquire);
+}
+
 static size_t hashTypeProtocolPair(const void *type,
                                    const ProtocolDescriptor *protocol) {
   // A simple hash function for the conformance pair.
@@ -2526,42 +2974,6 @@ recur_inside_cache_lock:
   return std::make_pair(nullptr, false);
 }
 
-/// Checks if a given candidate is a type itself, one of its
-/// superclasses or a related generic type.
-/// This check is supposed to use the same logic that is used
-/// by searchInConformanceCache.
-static
-bool isRelatedType(const Metadata *type, const void *candidate) {
-
-  while (true) {
-    if (type == candidate)
-      return true;
-
-    // If the type is generic, see if there's a shared nondependent witness table
-    // for its instances.
-    if (auto generic = type->getGenericPattern()) {
-      if (generic == candidate)
-        return true;
-    }
-
-    // If the type is a class, try its superclass.
-    if (const ClassMetadata *classType = type->getClassObject()) {
-      if (auto super = classType->SuperClass) {
-        if (super != getRootSuperclass()) {
-          type = swift_getObjCClassMetadata(super);
-          if (type == candidate)
-            return true;
-          continue;
-        }
-      }
-    }
-
-    break;
-  }
-
-  return false;
-}
-
 const WitnessTable *
 swift::swift_conformsToProtocol(const Metadata *type,
                                 const ProtocolDescriptor *protocol) {
@@ -2587,10 +2999,16 @@ recur:
   // it may mean that all of the superclasses do not have this conformance,
   // but the actual type may still have this conformance.
   if (FoundConformance.second) {
-    if (FoundConformance.first || foundEntry)
+    if (FoundConformance.first || foundEntry) {
+      SWIFT_CONFORMANCECACHEHIT((void *)origType, (void *)protocol);
+      SWIFT_RUNTIME_STATISTIC(ConformanceCacheHits);
       return FoundConformance.first;
+    }
   }
 
+  SWIFT_CONFORMANCECACHEMISS((void *)origType, (void *)protocol);
+  SWIFT_RUNTIME_STATISTIC(ConformanceCacheMisses);
+
   unsigned failedGeneration = ConformanceCacheGeneration;
 
   // If we didn't have an up-to-date cache entry, scan the conformance records.
@@ -2625,60 +3043,69 @@ recur:
   unsigned sectionIdx = foundEntry ? foundEntry->getFailureGeneration() : 0;
   unsigned endSectionIdx = C.SectionsToScan.size();
 
+  C.indexNewSections();
+
+  // If none of the new sections has conformances to this protocol, a
+  // cached negative answer for the type still holds. Refresh it with the
+  // current generation instead of scanning.
+  if (foundEntry && !C.hasConformancesSince(protocol, sectionIdx)) {
+    size_t hash = hashTypeProtocolPair(origType, protocol);
+    ConcurrentList<ConformanceCacheEntry> &Bucket =
+      C.Cache.findOrAllocateNode(hash);
+    Bucket.push_front(ConformanceCacheEntry::createFailure(
+        origType, protocol, endSectionIdx));
+    pthread_mutex_unlock(&C.SectionsToScanLock);
+    return nullptr;
+  }
+
+  // Collect the type, its generic pattern, and its superclasses with
+  // their generic patterns; these are the only keys a relevant record can
+  // have. This mirrors the walk done by searchInConformanceCache.
+  llvm::SmallVector<const void *, 8> relatedTypes;
+  for (auto related = type; ; ) {
+    relatedTypes.push_back(related);
+    if (auto generic = related->getGenericPattern())
+      relatedTypes.push_back(generic);
+
+    const ClassMetadata *classType = related->getClassObject();
+    if (!classType || !classType->SuperClass ||
+        classType->SuperClass == getRootSuperclass())
+      break;
+    related = swift_getObjCClassMetadata(classType->SuperClass);
+  }
+
   for (; sectionIdx < endSectionIdx; ++sectionIdx) {
     auto &section = C.SectionsToScan[sectionIdx];
     // Eagerly pull records for nondependent witnesses into our cache.
-    for (const auto &record : section) {
-      // If the record applies to a specific type, cache it.
-      if (auto metadata = record.getCanonicalTypeMetadata()) {
-        auto P = record.getProtocol();
-
-        // Look for an exact match.
-        if (protocol != P)
-          continue;
-
-        if (!isRelatedType(type, metadata))
-          continue;
+    for (auto relatedType : relatedTypes) {
+      auto range = section.lookup(protocol, relatedType);
+      for (auto entry = range.first; entry != range.second; ++entry) {
+        auto &record = *entry->Record;
 
         // Hash and lookup the type-protocol pair in the cache.
-        size_t hash = hashTypeProtocolPair(metadata, P);
+        size_t hash = hashTypeProtocolPair(relatedType, protocol);
         ConcurrentList<ConformanceCacheEntry> &Bucket =
           C.Cache.findOrAllocateNode(hash);
 
+        // If the record provides a nondependent witness table for all
+        // instances of a generic type, cache it for the generic pattern.
+        if (record.getTypeKind()
+              == ProtocolConformanceTypeKind::UniqueGenericPattern) {
+          Bucket.push_front(ConformanceCacheEntry::createSuccess(
+              relatedType, protocol, record.getStaticWitnessTable()));
+          continue;
+        }
+
+        // Otherwise the record applies to a specific type.
+        auto metadata = static_cast<const Metadata *>(relatedType);
         auto witness = record.getWitnessTable(metadata);
         if (witness)
           Bucket.push_front(
-              ConformanceCacheEntry::createSuccess(metadata, P, witness));
+              ConformanceCacheEntry::createSuccess(metadata, protocol,
+                                                   witness));
         else
           Bucket.push_front(ConformanceCacheEntry::createFailure(
-              metadata, P, C.SectionsToScan.size()));
-
-      // If the record provides a nondependent witness table for all instances
-      // of a generic type, cache it for the generic pattern.
-      // TODO: "Nondependent witness table" probably deserves its own flag.
-      // An accessor function might still be necessary even if the witness table
-      // can be shared.
-      } else if (record.getTypeKind()
-                   == ProtocolConformanceTypeKind::UniqueGenericPattern
-                 && record.getConformanceKind()
-                   == ProtocolConformanceReferenceKind::WitnessTable) {
-
-        auto R = record.getGenericPattern();
-        auto P = record.getProtocol();
-
-        // Look for an exact match.
-        if (protocol != P)
-          continue;
-
-        if (!isRelatedType(type, R))
-          continue;
-
-        // Hash and lookup the type-protocol pair in the cache.
-        size_t hash = hashTypeProtocolPair(R, P);
-        ConcurrentList<ConformanceCacheEntry> &Bucket =
-          C.Cache.findOrAllocateNode(hash);
-          Bucket.push_front(ConformanceCacheEntry::createSuccess(
-              R, P, record.getStaticWitnessTable()));
+              metadata, protocol, C.SectionsToScan.size()));
       }
     }
   }
@@ -74,6 +74,30 @@ static inline void small_memcpy(void *dest, const void *src, unsigned count) {
   }
 }
 
+/// Returns true if the extra inhabitants of values with the witnesses
+/// \p vwtable are those of a heap object pointer, so that they can be read
+/// and written inline instead of through the extra inhabitant witnesses.
+static bool hasHeapObjectExtraInhabitants(const ValueWitnessTable *vwtable) {
+  return vwtable == &_TWVBo || vwtable == &_TWVBb
+#if SWIFT_OBJC_INTEROP
+    || vwtable == &_TWVBO
+#endif
+    ;
+}
+
+/// Returns the value witnesses of the single-refcounted pointer type with
+/// the layout \p payloadLayout, or null if it isn't one.
+static const ValueWitnessTable *
+getRefCountedPointerWitnesses(const TypeLayout *payloadLayout) {
+  if (payloadLayout == _TWVBo.getTypeLayout())
+    return &_TWVBo;
+#if SWIFT_OBJC_INTEROP
+  if (payloadLayout == _TWVBO.getTypeLayout())
+    return &_TWVBO;
+#endif
+  return nullptr;
+}
+
 void
 swift::swift_initEnumValueWitnessTableSinglePayload(ValueWitnessTable *vwtable,
                                                 const TypeLayout *payloadLayout,
@@ -107,28 +131,19 @@ swift::swift_initEnumValueWitnessTableSinglePayload(ValueWitnessTable *vwtable,
   // Substitute in better common value witnesses if we have them.
   // If the payload type is a single-refcounted pointer, and the enum has
   // a single empty case, then we can borrow the witnesses of the single
-  // refcounted pointer type, since swift_retain and objc_retain are both
-  // nil-aware. Most single-refcounted types will use the standard
-  // value witness tables for NativeObject or UnknownObject. This isn't
-  // foolproof but should catch the common case of optional class types.
-#if OPTIONAL_OBJECT_OPTIMIZATION
-  auto payloadVWT = payload->getValueWitnesses();
-  if (emptyCases == 1
-      && (payloadVWT == &_TWVBo
-#if SWIFT_OBJC_INTEROP
-          || payloadVWT == &_TWVBO
-#endif
-          )) {
+  // refcounted pointer type, since swift_retain and swift_unknownRetain are
+  // both nil-aware and the empty case is the null pointer. Most
+  // single-refcounted types will use the standard value witness tables for
+  // NativeObject or UnknownObject. This isn't foolproof but catches the
+  // common case of optional class types.
+  auto payloadVWT = getRefCountedPointerWitnesses(payloadLayout);
+  if (emptyCases == 1 && payloadVWT) {
 #define COPY_PAYLOAD_WITNESS(NAME) vwtable->NAME = payloadVWT->NAME;
     FOR_ALL_FUNCTION_VALUE_WITNESSES(COPY_PAYLOAD_WITNESS)
 #undef COPY_PAYLOAD_WITNESS
   } else {
-#endif
     installCommonValueWitnesses(vwtable);
-#if OPTIONAL_OBJECT_OPTIMIZATION
   }
-#endif
-
 
   // If the payload has extra inhabitants left over after the ones we used,
   // forward them as our own.
@@ -144,6 +159,15 @@ swift::swift_getEnumCaseSinglePayload(const OpaqueValue *value,
                                       const Metadata *payload,
                                       unsigned emptyCases) {
   auto *payloadWitnesses = payload->getValueWitnesses();
+
+  // Optional class references are by far the most common single-payload
+  // enums in generic code. Their empty cases always fit in the pointer's
+  // extra inhabitants, which can be decoded without an indirect call.
+  if (hasHeapObjectExtraInhabitants(payloadWitnesses) &&
+      emptyCases <= swift_getHeapObjectExtraInhabitantCount())
+    return swift_getHeapObjectExtraInhabitantIndex(
+                               reinterpret_cast<HeapObject * const *>(value));
+
   auto payloadSize = payloadWitnesses->getSize();
   auto payloadNumExtraInhabitants = payloadWitnesses->getNumExtraInhabitants();
 
@@ -193,6 +217,17 @@ swift::swift_storeEnumTagSinglePayload(OpaqueValue *value,
                                         const Metadata *payload,
                                         int whichCase, unsigned emptyCases) {
   auto *payloadWitnesses = payload->getValueWitnesses();
+
+  // Store the empty cases of optional class references inline, as above.
+  if (hasHeapObjectExtraInhabitants(payloadWitnesses) &&
+      emptyCases <= swift_getHeapObjectExtraInhabitantCount()) {
+    if (whichCase >= 0)
+      swift_storeHeapObjectExtraInhabitant(
+                              reinterpret_cast<HeapObject **>(value),
+                              whichCase);
+    return;
+  }
+
   auto payloadSize = payloadWitnesses->getSize();
   unsigned payloadNumExtraInhabitants
     = payloadWitnesses->getNumExtraInhabitants();
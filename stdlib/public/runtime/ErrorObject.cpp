@@ -18,6 +18,9 @@
 //===----------------------------------------------------------------------===//
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "swift/Basic/Lazy.h"
 #include "swift/Runtime/Debug.h"
 #include "ErrorObject.h"
 #include "Private.h"
@@ -26,6 +29,64 @@
 
 using namespace swift;
 
+// Freed error boxes are kept in a small per-thread pool for reuse, since
+// code which throws in a loop would otherwise allocate and free a box for
+// every throw. Boxes are binned by size class; a box of a size class is
+// allocated with the size of the class, so that it can be reused for any
+// value whose box falls into the class.
+
+namespace {
+
+/// The sizes of pooled boxes, including the SwiftError header.
+static const size_t PoolSizeClasses[] = { 48, 64, 96, 128 };
+static const unsigned NumPoolSizeClasses =
+  sizeof(PoolSizeClasses) / sizeof(PoolSizeClasses[0]);
+
+/// All pooled boxes are allocated with this alignment.
+static const size_t PoolAlignMask = 15;
+
+/// The number of boxes of each size class a thread keeps.
+static const unsigned MaxPooledBoxes = 8;
+
+struct ErrorBoxPool {
+  SwiftError *Boxes[NumPoolSizeClasses][MaxPooledBoxes];
+  unsigned Counts[NumPoolSizeClasses];
+};
+
+} // end anonymous namespace
+
+/// The size class of a box, or NumPoolSizeClasses if boxes of this size
+/// aren't pooled.
+static unsigned getPoolSizeClass(size_t size, size_t alignMask) {
+  if (alignMask > PoolAlignMask)
+    return NumPoolSizeClasses;
+  unsigned cls = 0;
+  while (cls < NumPoolSizeClasses && PoolSizeClasses[cls] < size)
+    ++cls;
+  return cls;
+}
+
+static void destroyErrorBoxPool(void *pool);
+
+static Lazy<pthread_key_t> ErrorBoxPoolKey;
+
+static pthread_key_t &getErrorBoxPoolKey() {
+  return ErrorBoxPoolKey.get([](void *key) {
+    pthread_key_create(static_cast<pthread_key_t *>(key), destroyErrorBoxPool);
+  });
+}
+
+static ErrorBoxPool *getErrorBoxPool() {
+  auto key = getErrorBoxPoolKey();
+  auto pool = static_cast<ErrorBoxPool *>(pthread_getspecific(key));
+  if (LLVM_UNLIKELY(!pool)) {
+    pool = static_cast<ErrorBoxPool *>(calloc(1, sizeof(ErrorBoxPool)));
+    if (!pool) swift::crash("Could not allocate memory.");
+    pthread_setspecific(key, pool);
+  }
+  return pool;
+}
+
 /// Determine the size and alignment of an ErrorType box containing the given
 /// type.
 static std::pair<size_t, size_t>
@@ -39,10 +100,44 @@ _getErrorAllocatedSizeAndAlignmentMask(const Metadata *type) {
   size += vw->getSize();
   
   size_t alignMask = (alignof(SwiftError) - 1) | valueAlignMask;
+
+  // Pooled boxes are allocated with the size of their class.
+  unsigned cls = getPoolSizeClass(size, alignMask);
+  if (cls < NumPoolSizeClasses)
+    return {PoolSizeClasses[cls], PoolAlignMask};
   
   return {size, alignMask};
 }
 
+static void destroyErrorBoxPool(void *pool) {
+  auto boxPool = static_cast<ErrorBoxPool *>(pool);
+  for (unsigned cls = 0; cls < NumPoolSizeClasses; ++cls) {
+    for (unsigned i = 0; i < boxPool->Counts[cls]; ++i)
+      swift_deallocObject(boxPool->Boxes[cls][i], PoolSizeClasses[cls],
+                          PoolAlignMask);
+  }
+  free(boxPool);
+}
+
+/// Deallocate an ErrorType box whose value has been destroyed, or keep it
+/// for reuse.
+static void _deallocErrorObject(SwiftError *error, const Metadata *type) {
+  auto sizeAndAlign = _getErrorAllocatedSizeAndAlignmentMask(type);
+  unsigned cls = getPoolSizeClass(sizeAndAlign.first, sizeAndAlign.second);
+
+  // Only boxes without outstanding unowned references can be reused right
+  // away; the others are freed by their last unowned release.
+  if (cls < NumPoolSizeClasses && error->weakRefCount.getCount() == 1) {
+    auto pool = getErrorBoxPool();
+    if (pool->Counts[cls] < MaxPooledBoxes) {
+      pool->Boxes[cls][pool->Counts[cls]++] = error;
+      return;
+    }
+  }
+
+  swift_deallocObject(error, sizeAndAlign.first, sizeAndAlign.second);
+}
+
 /// Destructor for an ErrorType box.
 static void _destroyErrorObject(HeapObject *obj) {
   auto error = static_cast<SwiftError *>(obj);
@@ -52,8 +147,7 @@ static void _destroyErrorObject(HeapObject *obj) {
   type->vw_destroy(error->getValue());
   
   // Deallocate the buffer.
-  auto sizeAndAlign = _getErrorAllocatedSizeAndAlignmentMask(type);
-  swift_deallocObject(obj, sizeAndAlign.first, sizeAndAlign.second);
+  _deallocErrorObject(error, type);
 }
 
 /// Heap metadata for ErrorType boxes.
@@ -68,9 +162,21 @@ swift::swift_allocError(const swift::Metadata *type,
                         OpaqueValue *initialValue,
                         bool isTake) {
   auto sizeAndAlign = _getErrorAllocatedSizeAndAlignmentMask(type);
-  
-  auto allocated = swift_allocObject(&ErrorTypeMetadata,
-                                     sizeAndAlign.first, sizeAndAlign.second);
+
+  // Reuse a pooled box if there is one.
+  HeapObject *allocated = nullptr;
+  unsigned cls = getPoolSizeClass(sizeAndAlign.first, sizeAndAlign.second);
+  if (cls < NumPoolSizeClasses) {
+    auto pool = getErrorBoxPool();
+    if (pool->Counts[cls] > 0) {
+      allocated = pool->Boxes[cls][--pool->Counts[cls]];
+      allocated->refCount.init();
+      allocated->weakRefCount.init();
+    }
+  }
+  if (!allocated)
+    allocated = swift_allocObject(&ErrorTypeMetadata,
+                                  sizeAndAlign.first, sizeAndAlign.second);
   
   auto error = reinterpret_cast<SwiftError*>(allocated);
   
@@ -91,8 +197,7 @@ swift::swift_allocError(const swift::Metadata *type,
 
 void
 swift::swift_deallocError(SwiftError *error, const Metadata *type) {
-  auto sizeAndAlign = _getErrorAllocatedSizeAndAlignmentMask(type);
-  swift_deallocObject(error, sizeAndAlign.first, sizeAndAlign.second);
+  _deallocErrorObject(error, type);
 }
 
 void
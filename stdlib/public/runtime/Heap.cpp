@@ -17,18 +17,333 @@
 #include "swift/Runtime/HeapObject.h"
 #include "swift/Runtime/Heap.h"
 #include "Private.h"
+#include "Probes.h"
 #include "swift/Runtime/Debug.h"
 #include <stdlib.h>
 
+#if SWIFT_RUNTIME_ENABLE_SIZE_CLASS_ALLOCATOR
+#include "swift/Basic/Lazy.h"
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
+
 using namespace swift;
 
-void *swift::swift_slowAlloc(size_t size, size_t alignMask) {
-  // FIXME: use posix_memalign if alignMask is larger than the system guarantee.
-  void *p = malloc(size);
+/// The alignment that malloc guarantees for every allocation.
+static const size_t MallocAlignMask = 2 * sizeof(void*) - 1;
+
+static void *allocWithMalloc(size_t size, size_t alignMask) {
+  void *p;
+  if (LLVM_LIKELY(alignMask <= MallocAlignMask)) {
+    p = malloc(size);
+  } else {
+    // posix_memalign requires the alignment to be at least pointer-sized.
+    size_t alignment = alignMask + 1;
+    if (posix_memalign(&p, alignment, size) != 0)
+      p = nullptr;
+  }
   if (!p) swift::crash("Could not allocate memory.");
   return p;
 }
 
-void swift::swift_slowDealloc(void *ptr, size_t bytes, size_t alignMask) {
+#if SWIFT_RUNTIME_ENABLE_SIZE_CLASS_ALLOCATOR
+
+// A size-class allocator for small allocations.
+//
+// Small requests are rounded up to one of a fixed set of size classes and
+// are served from per-thread free lists, so the common alloc/dealloc pair
+// touches no shared state at all. Objects of a size class are carved out of
+// chunks that are committed from a single reserved address range. A pointer
+// handed to swift_slowDealloc is recognized as ours by a range check, and its
+// size class is recorded per chunk, so the allocator stays correct even when
+// a caller deallocates with a smaller size than it allocated with (as happens
+// for objects with tail-allocated storage). Everything else goes to malloc.
+//
+// Thread caches hand batches of objects back to a global per-class free list
+// when they grow too large and when their thread exits.
+
+namespace {
+
+/// The size classes. Every class is a multiple of 16 bytes, so objects in a
+/// chunk are 16-byte aligned; over-aligned requests are served by classes
+/// whose size is a multiple of the requested alignment.
+static const uint16_t SizeClasses[] = {
+  16, 32, 48, 64, 80, 96, 112, 128,
+  160, 192, 224, 256,
+  320, 384, 448, 512,
+  640, 768, 896, 1024
+};
+static const unsigned NumSizeClasses =
+  sizeof(SizeClasses) / sizeof(SizeClasses[0]);
+static const size_t MaxSmallSize = 1024;
+
+/// Chunks are aligned to their size.
+static const unsigned ChunkShift = 16;
+static const size_t ChunkSize = size_t(1) << ChunkShift;
+
+/// The size of the reserved address range. When it is exhausted, new
+/// allocations fall back to malloc.
+static const size_t RegionSize =
+  sizeof(void*) == 8 ? (size_t(1) << 32) : (size_t(1) << 26);
+static const size_t NumChunks = RegionSize >> ChunkShift;
+
+/// The number of objects moved between a thread cache and the global free
+/// list at a time.
+static const unsigned BatchSize = 64;
+
+struct FreeObject {
+  FreeObject *Next;
+};
+
+/// A free list of one size class that is shared by all threads.
+struct GlobalFreeList {
+  std::mutex Lock;
+  FreeObject *Head = nullptr;
+};
+
+struct ThreadCache {
+  FreeObject *Heads[NumSizeClasses];
+  unsigned Counts[NumSizeClasses];
+};
+
+class SizeClassHeap {
+  char *RegionBase = nullptr;
+  std::atomic<size_t> NextChunk{0};
+
+  /// The size class index (plus one) of every chunk. Zero means that the
+  /// chunk has not been handed out.
+  uint8_t ChunkClasses[NumChunks];
+
+  /// Maps (size + 15) / 16 to the smallest size class that fits.
+  uint8_t ClassForSize[MaxSmallSize / 16 + 1];
+
+  GlobalFreeList GlobalLists[NumSizeClasses];
+
+  pthread_key_t CacheKey;
+
+  static void destroyThreadCache(void *cache);
+
+  ThreadCache *getThreadCache() {
+    auto cache = static_cast<ThreadCache*>(pthread_getspecific(CacheKey));
+    if (LLVM_UNLIKELY(!cache)) {
+      cache = static_cast<ThreadCache*>(calloc(1, sizeof(ThreadCache)));
+      if (!cache) swift::crash("Could not allocate memory.");
+      pthread_setspecific(CacheKey, cache);
+    }
+    return cache;
+  }
+
+  /// Fill the thread cache for size class \p cls from the global free list
+  /// or, failing that, from a fresh chunk. Returns false if the region is
+  /// exhausted.
+  bool refill(ThreadCache *cache, unsigned cls);
+
+  /// Move all but \p keep objects of size class \p cls from the thread cache
+  /// to the global free list.
+  void drain(ThreadCache *cache, unsigned cls, unsigned keep);
+
+public:
+  SizeClassHeap() {
+    // Reserve one extra chunk so that the region can be aligned to a chunk
+    // boundary.
+    void *region = mmap(nullptr, RegionSize + ChunkSize, PROT_NONE,
+                        MAP_ANON|MAP_PRIVATE|MAP_NORESERVE, -1, 0);
+    if (region != MAP_FAILED) {
+      uintptr_t base = ((uintptr_t)region + ChunkSize - 1) & ~(ChunkSize - 1);
+      RegionBase = (char*)base;
+    } else {
+      NextChunk = NumChunks;
+    }
+
+    unsigned cls = 0;
+    for (size_t i = 0; i <= MaxSmallSize / 16; ++i) {
+      while (SizeClasses[cls] < i * 16)
+        ++cls;
+      ClassForSize[i] = cls;
+    }
+
+    pthread_key_create(&CacheKey, destroyThreadCache);
+  }
+
+  /// Return the size class for an allocation, or -1 if it has to go to
+  /// malloc.
+  int getSizeClass(size_t size, size_t alignMask) const {
+    if (LLVM_UNLIKELY(alignMask > MallocAlignMask)) {
+      if (alignMask >= ChunkSize)
+        return -1;
+      if (size < alignMask + 1)
+        size = alignMask + 1;
+    }
+    if (size > MaxSmallSize)
+      return -1;
+    unsigned cls = ClassForSize[(size + 15) >> 4];
+    if (LLVM_UNLIKELY(SizeClasses[cls] & alignMask)) {
+      // Find a larger class whose objects all have the requested alignment.
+      while (++cls < NumSizeClasses)
+        if (!(SizeClasses[cls] & alignMask))
+          return cls;
+      return -1;
+    }
+    return cls;
+  }
+
+  /// Return the size class of an object owned by this heap, or -1 if the
+  /// object does not belong to it.
+  int getOwningSizeClass(void *ptr) const {
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)RegionBase;
+    if (!RegionBase || offset >= RegionSize)
+      return -1;
+    return int(ChunkClasses[offset >> ChunkShift]) - 1;
+  }
+
+  void *alloc(unsigned cls) {
+    ThreadCache *cache = getThreadCache();
+    FreeObject *object = cache->Heads[cls];
+    if (LLVM_UNLIKELY(!object)) {
+      if (!refill(cache, cls))
+        return nullptr;
+      object = cache->Heads[cls];
+    }
+    cache->Heads[cls] = object->Next;
+    --cache->Counts[cls];
+    return object;
+  }
+
+  void dealloc(void *ptr, unsigned cls) {
+    ThreadCache *cache = getThreadCache();
+    auto object = static_cast<FreeObject*>(ptr);
+    object->Next = cache->Heads[cls];
+    cache->Heads[cls] = object;
+    if (LLVM_UNLIKELY(++cache->Counts[cls] > 2 * BatchSize))
+      drain(cache, cls, BatchSize);
+  }
+};
+
+} // end anonymous namespace
+
+static Lazy<SizeClassHeap> TheHeap;
+
+void SizeClassHeap::destroyThreadCache(void *ptr) {
+  auto cache = static_cast<ThreadCache*>(ptr);
+  for (unsigned cls = 0; cls != NumSizeClasses; ++cls)
+    TheHeap.unsafeGetAlreadyInitialized().drain(cache, cls, 0);
+  free(cache);
+}
+
+bool SizeClassHeap::refill(ThreadCache *cache, unsigned cls) {
+  assert(!cache->Heads[cls] && cache->Counts[cls] == 0);
+
+  // Take a batch from the global free list.
+  {
+    GlobalFreeList &global = GlobalLists[cls];
+    std::lock_guard<std::mutex> guard(global.Lock);
+    FreeObject *first = global.Head;
+    if (first) {
+      FreeObject *last = first;
+      unsigned count = 1;
+      while (count < BatchSize && last->Next) {
+        last = last->Next;
+        ++count;
+      }
+      global.Head = last->Next;
+      last->Next = nullptr;
+      cache->Heads[cls] = first;
+      cache->Counts[cls] = count;
+      return true;
+    }
+  }
+
+  // Carve a new chunk.
+  size_t chunk = NextChunk.fetch_add(1, std::memory_order_relaxed);
+  if (chunk >= NumChunks)
+    return false;
+  char *base = RegionBase + (chunk << ChunkShift);
+  if (mprotect(base, ChunkSize, PROT_READ|PROT_WRITE) != 0)
+    swift::crash("Could not allocate memory.");
+  ChunkClasses[chunk] = cls + 1;
+
+  size_t objectSize = SizeClasses[cls];
+  unsigned count = ChunkSize / objectSize;
+  FreeObject *head = nullptr;
+  for (unsigned i = count; i != 0; --i) {
+    auto object = reinterpret_cast<FreeObject*>(base + (i - 1) * objectSize);
+    object->Next = head;
+    head = object;
+  }
+  cache->Heads[cls] = head;
+  cache->Counts[cls] = count;
+  return true;
+}
+
+void SizeClassHeap::drain(ThreadCache *cache, unsigned cls, unsigned keep) {
+  if (cache->Counts[cls] <= keep)
+    return;
+
+  // Keep the first 'keep' objects and hand the rest over.
+  FreeObject *first, *last = nullptr;
+  if (keep == 0) {
+    first = cache->Heads[cls];
+    cache->Heads[cls] = nullptr;
+  } else {
+    FreeObject *keptTail = cache->Heads[cls];
+    for (unsigned i = 1; i < keep; ++i)
+      keptTail = keptTail->Next;
+    first = keptTail->Next;
+    keptTail->Next = nullptr;
+  }
+  for (last = first; last->Next; last = last->Next) {}
+  cache->Counts[cls] = keep;
+
+  GlobalFreeList &global = GlobalLists[cls];
+  std::lock_guard<std::mutex> guard(global.Lock);
+  last->Next = global.Head;
+  global.Head = first;
+}
+
+static void *slowAllocImpl(size_t size, size_t alignMask) {
+  SizeClassHeap &heap = TheHeap.get();
+  int cls = heap.getSizeClass(size, alignMask);
+  if (cls >= 0)
+    if (void *p = heap.alloc(cls))
+      return p;
+  return allocWithMalloc(size, alignMask);
+}
+
+static void slowDeallocImpl(void *ptr, size_t bytes, size_t alignMask) {
+  // Ownership is determined from the address rather than from 'bytes':
+  // callers may legitimately pass a size that is smaller than the one they
+  // allocated with.
+  SizeClassHeap &heap = TheHeap.unsafeGetAlreadyInitialized();
+  int cls = heap.getOwningSizeClass(ptr);
+  if (cls >= 0) {
+    assert(bytes <= SizeClasses[cls] && "deallocating more than allocated");
+    heap.dealloc(ptr, cls);
+    return;
+  }
+  free(ptr);
+}
+
+#else
+
+static void *slowAllocImpl(size_t size, size_t alignMask) {
+  return allocWithMalloc(size, alignMask);
+}
+
+static void slowDeallocImpl(void *ptr, size_t bytes, size_t alignMask) {
   free(ptr);
 }
+
+#endif
+
+void *swift::swift_slowAlloc(size_t size, size_t alignMask) {
+  void *p = slowAllocImpl(size, alignMask);
+  alloc_profiler::noteAllocation(p, size);
+  return p;
+}
+
+void swift::swift_slowDealloc(void *ptr, size_t bytes, size_t alignMask) {
+  alloc_profiler::noteDeallocation(ptr);
+  slowDeallocImpl(ptr, bytes, alignMask);
+}
@@ -31,6 +31,15 @@
 #include <cstdlib>
 #include <unistd.h>
 #include "../SwiftShims/RuntimeShims.h"
+#if SWIFT_RUNTIME_ENABLE_WEAK_SIDE_TABLE
+# if SWIFT_OBJC_INTEROP
+#  error "weak reference side tables are not supported with ObjC interop"
+# endif
+# include "llvm/ADT/DenseMap.h"
+# include <atomic>
+# include <mutex>
+# include <sched.h>
+#endif
 #if SWIFT_OBJC_INTEROP
 # include <objc/NSObject.h>
 # include <objc/runtime.h>
@@ -38,15 +47,8 @@
 # include <objc/objc.h>
 #include "swift/Runtime/ObjCBridge.h"
 #endif
-#if SWIFT_RUNTIME_ENABLE_DTRACE
-# include "SwiftRuntimeDTraceProbes.h"
-#else
-# define SWIFT_ALLOCATEOBJECT()
-# define SWIFT_DEALLOCATEOBJECT()
-# define SWIFT_RELEASE()
-# define SWIFT_RETAIN()
-#endif
 #include "Leaks.h"
+#include "Probes.h"
 
 using namespace swift;
 
@@ -55,6 +57,7 @@ swift::swift_allocObject(HeapMetadata const *metadata,
                          size_t requiredSize,
                          size_t requiredAlignmentMask) {
   SWIFT_ALLOCATEOBJECT();
+  SWIFT_RUNTIME_STATISTIC(ObjectAllocations);
   return _swift_allocObject(metadata, requiredSize, requiredAlignmentMask);
 }
 static HeapObject *
@@ -68,6 +71,8 @@ _swift_allocObject_(HeapMetadata const *metadata, size_t requiredSize,
   object->refCount.init();
   object->weakRefCount.init();
 
+  alloc_profiler::noteObjectType(object, metadata);
+
   // If leak tracking is enabled, start tracking this object.
   SWIFT_LEAKS_START_TRACKING_OBJECT(object);
 
@@ -267,6 +272,8 @@ static Lazy<MetadataCache<BoxCacheEntry>> Boxes;
 
 BoxPair::Return
 swift::swift_allocBox(const Metadata *type) {
+  SWIFT_ALLOCATEBOX();
+  SWIFT_RUNTIME_STATISTIC(BoxAllocations);
   return _swift_allocBox(type);
 }
 static BoxPair::Return _swift_allocBox_(const Metadata *type) {
@@ -291,6 +298,9 @@ static BoxPair::Return _swift_allocBox_(const Metadata *type) {
                                       metadata->getAllocAlignMask());
   auto projection = metadata->project(allocation);
 
+  // Attribute sampled boxes to the type they hold.
+  alloc_profiler::noteObjectType(allocation, type);
+
   return BoxPair{allocation, projection};
 }
 auto swift::_swift_allocBox = _swift_allocBox_;
@@ -318,6 +328,7 @@ void _swift_release_dealloc(HeapObject *object)
 
 void swift::swift_retain(HeapObject *object) {
   SWIFT_RETAIN();
+  SWIFT_RUNTIME_STATISTIC(Retains);
   _swift_retain(object);
 }
 static void _swift_retain_(HeapObject *object) {
@@ -327,6 +338,7 @@ auto swift::_swift_retain = _swift_retain_;
 
 void swift::swift_retain_n(HeapObject *object, uint32_t n) {
   SWIFT_RETAIN();
+  SWIFT_RUNTIME_STATISTIC(Retains);
   _swift_retain_n(object, n);
 }
 static void _swift_retain_n_(HeapObject *object, uint32_t n) {
@@ -338,6 +350,7 @@ auto swift::_swift_retain_n = _swift_retain_n_;
 
 void swift::swift_release(HeapObject *object) {
   SWIFT_RELEASE();
+  SWIFT_RUNTIME_STATISTIC(Releases);
   return _swift_release(object);
 }
 static void _swift_release_(HeapObject *object) {
@@ -349,6 +362,7 @@ auto swift::_swift_release = _swift_release_;
 
 void swift::swift_release_n(HeapObject *object, uint32_t n) {
   SWIFT_RELEASE();
+  SWIFT_RUNTIME_STATISTIC(Releases);
   return _swift_release_n(object, n);
 }
 static void _swift_release_n_(HeapObject *object, uint32_t n) {
@@ -358,6 +372,38 @@ static void _swift_release_n_(HeapObject *object, uint32_t n) {
 }
 auto swift::_swift_release_n = _swift_release_n_;
 
+void swift::swift_nonatomic_retain(HeapObject *object) {
+  SWIFT_RETAIN();
+  SWIFT_RUNTIME_STATISTIC(Retains);
+  if (object) {
+    object->refCount.incrementNonAtomic();
+  }
+}
+
+void swift::swift_nonatomic_retain_n(HeapObject *object, uint32_t n) {
+  SWIFT_RETAIN();
+  SWIFT_RUNTIME_STATISTIC(Retains);
+  if (object) {
+    object->refCount.incrementNonAtomic(n);
+  }
+}
+
+void swift::swift_nonatomic_release(HeapObject *object) {
+  SWIFT_RELEASE();
+  SWIFT_RUNTIME_STATISTIC(Releases);
+  if (object && object->refCount.decrementShouldDeallocateNonAtomic()) {
+    _swift_release_dealloc(object);
+  }
+}
+
+void swift::swift_nonatomic_release_n(HeapObject *object, uint32_t n) {
+  SWIFT_RELEASE();
+  SWIFT_RUNTIME_STATISTIC(Releases);
+  if (object && object->refCount.decrementShouldDeallocateNNonAtomic(n)) {
+    _swift_release_dealloc(object);
+  }
+}
+
 size_t swift::swift_retainCount(HeapObject *object) {
   return object->refCount.getCount();
 }
@@ -530,9 +576,14 @@ static inline void memset_pattern8(void *b, const void *pattern8, size_t len) {
 }
 #endif
 
+#if SWIFT_RUNTIME_ENABLE_WEAK_SIDE_TABLE
+static void clearWeakSideTableEntry(HeapObject *object);
+#endif
+
 void swift::swift_deallocObject(HeapObject *object, size_t allocatedSize,
                                 size_t allocatedAlignMask) {
   SWIFT_DEALLOCATEOBJECT();
+  SWIFT_RUNTIME_STATISTIC(ObjectDeallocations);
   assert(isAlignmentMask(allocatedAlignMask));
   assert(object->refCount.isDeallocating());
 #ifdef SWIFT_RUNTIME_CLOBBER_FREED_OBJECTS
@@ -544,6 +595,12 @@ void swift::swift_deallocObject(HeapObject *object, size_t allocatedSize,
   // If we are tracking leaks, stop tracking this object.
   SWIFT_LEAKS_STOP_TRACKING_OBJECT(object);
 
+#if SWIFT_RUNTIME_ENABLE_WEAK_SIDE_TABLE
+  // Detach the object from its weak references before its memory goes away.
+  if (object->weakRefCount.hasSideTable())
+    clearWeakSideTableEntry(object);
+#endif
+
   // Drop the initial weak retain of the object.
   //
   // If the outstanding weak retain count is 1 (i.e. only the initial
@@ -621,6 +678,191 @@ void swift::swift_deallocObject(HeapObject *object, size_t allocatedSize,
 extern "C" void swift_fixLifetime(OpaqueValue *value) {
 }
 
+#if SWIFT_RUNTIME_ENABLE_WEAK_SIDE_TABLE
+
+// Weak reference side table.
+//
+// A native weak reference points to a side table entry instead of the
+// object, and doesn't keep the object's memory alive. The entry is created
+// when the first weak reference to the object is formed and records the
+// object until it is deallocated. Loading a weak reference only reads the
+// entry, plus the object's strong reference count while it is alive.
+//
+// Entries are found from their object through a sharded map; only forming a
+// weak reference from a strong one and deallocating an object which has an
+// entry need to look them up.
+
+namespace {
+
+struct WeakSideTableEntry {
+  /// The referenced object, or null once it has been deallocated.
+  std::atomic<HeapObject *> Object;
+
+  /// The number of weak references to the entry, plus one while the object
+  /// is alive.
+  std::atomic<uint32_t> RefCount;
+
+  /// The number of threads which are currently trying to retain the object.
+  std::atomic<uint32_t> Readers;
+
+  explicit WeakSideTableEntry(HeapObject *object)
+    : Object(object), RefCount(1), Readers(0) {}
+
+  void retain() {
+    RefCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release() {
+    if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+
+  bool isDead() const {
+    return Object.load(std::memory_order_relaxed) == nullptr;
+  }
+
+  /// Return a strong reference to the object, or null if it is being or has
+  /// been deallocated.
+  HeapObject *tryRetainObject() {
+    // Pairs with clearObject: either it sees us as a reader and waits for us
+    // to finish, or we see the cleared object.
+    Readers.fetch_add(1, std::memory_order_seq_cst);
+    HeapObject *object = Object.load(std::memory_order_seq_cst);
+    if (object)
+      object = swift_tryRetain(object);
+    Readers.fetch_sub(1, std::memory_order_release);
+    return object;
+  }
+
+  /// Forget the object, which is about to be deallocated, and drop its
+  /// reference to the entry.
+  void clearObject() {
+    Object.store(nullptr, std::memory_order_seq_cst);
+    // A reader which loaded the object before we cleared it may still be
+    // looking at its reference count. The strong count is already zero, so
+    // it will fail to retain the object shortly.
+    while (Readers.load(std::memory_order_seq_cst) != 0)
+      sched_yield();
+    release();
+  }
+};
+
+struct WeakSideTableShard {
+  std::mutex Lock;
+  llvm::DenseMap<HeapObject *, WeakSideTableEntry *> Entries;
+};
+
+struct WeakSideTable {
+  enum : unsigned { NumShards = 64 };
+  WeakSideTableShard Shards[NumShards];
+
+  WeakSideTableShard &getShard(HeapObject *object) {
+    return Shards[(reinterpret_cast<uintptr_t>(object) >> 4) % NumShards];
+  }
+};
+
+} // end anonymous namespace
+
+static Lazy<WeakSideTable> TheWeakSideTable;
+
+/// Return a retained side table entry for a live object, creating it if
+/// necessary.
+static WeakSideTableEntry *getWeakSideTableEntry(HeapObject *object) {
+  auto &shard = TheWeakSideTable.get().getShard(object);
+  std::lock_guard<std::mutex> guard(shard.Lock);
+  auto &entry = shard.Entries[object];
+  if (!entry) {
+    entry = new WeakSideTableEntry(object);
+    object->weakRefCount.setHasSideTable();
+  }
+  entry->retain();
+  return entry;
+}
+
+static void clearWeakSideTableEntry(HeapObject *object) {
+  auto &shard = TheWeakSideTable.get().getShard(object);
+  WeakSideTableEntry *entry;
+  {
+    std::lock_guard<std::mutex> guard(shard.Lock);
+    auto found = shard.Entries.find(object);
+    assert(found != shard.Entries.end() && "object has no side table entry");
+    entry = found->second;
+    shard.Entries.erase(found);
+  }
+  entry->clearObject();
+}
+
+static WeakSideTableEntry *getEntry(WeakReference *ref) {
+  return reinterpret_cast<WeakSideTableEntry *>(ref->Value);
+}
+
+static void setEntry(WeakReference *ref, WeakSideTableEntry *entry) {
+  ref->Value = reinterpret_cast<HeapObject *>(entry);
+}
+
+void swift::swift_weakInit(WeakReference *ref, HeapObject *value) {
+  setEntry(ref, value ? getWeakSideTableEntry(value) : nullptr);
+}
+
+void swift::swift_weakAssign(WeakReference *ref, HeapObject *newValue) {
+  auto newEntry = newValue ? getWeakSideTableEntry(newValue) : nullptr;
+  auto oldEntry = getEntry(ref);
+  setEntry(ref, newEntry);
+  if (oldEntry)
+    oldEntry->release();
+}
+
+HeapObject *swift::swift_weakLoadStrong(WeakReference *ref) {
+  // Don't clear a dead reference here, so that concurrent loads from the
+  // same reference don't race with each other.
+  auto entry = getEntry(ref);
+  if (entry == nullptr) return nullptr;
+  return entry->tryRetainObject();
+}
+
+HeapObject *swift::swift_weakTakeStrong(WeakReference *ref) {
+  auto result = swift_weakLoadStrong(ref);
+  swift_weakDestroy(ref);
+  return result;
+}
+
+void swift::swift_weakDestroy(WeakReference *ref) {
+  auto entry = getEntry(ref);
+  setEntry(ref, nullptr);
+  if (entry)
+    entry->release();
+}
+
+void swift::swift_weakCopyInit(WeakReference *dest, WeakReference *src) {
+  auto entry = getEntry(src);
+  if (entry == nullptr || entry->isDead()) {
+    setEntry(dest, nullptr);
+  } else {
+    entry->retain();
+    setEntry(dest, entry);
+  }
+}
+
+void swift::swift_weakTakeInit(WeakReference *dest, WeakReference *src) {
+  setEntry(dest, getEntry(src));
+}
+
+void swift::swift_weakCopyAssign(WeakReference *dest, WeakReference *src) {
+  auto oldEntry = getEntry(dest);
+  swift_weakCopyInit(dest, src);
+  if (oldEntry)
+    oldEntry->release();
+}
+
+void swift::swift_weakTakeAssign(WeakReference *dest, WeakReference *src) {
+  auto oldEntry = getEntry(dest);
+  swift_weakTakeInit(dest, src);
+  if (oldEntry)
+    oldEntry->release();
+}
+
+#else
+
 void swift::swift_weakInit(WeakReference *ref, HeapObject *value) {
   ref->Value = value;
   swift_weakRetain(value);
@@ -693,6 +935,8 @@ void swift::swift_weakTakeAssign(WeakReference *dest, WeakReference *src) {
   swift_weakTakeInit(dest, src);
 }
 
+#endif
+
 void swift::_swift_abortRetainUnowned(const void *object) {
   (void)object;
   swift::crash("attempted to retain deallocated object");
@@ -23,6 +23,7 @@
 #include "swift/Runtime/Metadata.h"
 #include "swift/Strings.h"
 #include "MetadataCache.h"
+#include "Probes.h"
 #include <algorithm>
 #include <condition_variable>
 #include <new>
@@ -71,23 +72,33 @@ void *MetadataAllocator::alloc(size_t size) {
     return mem;
   }
   
-  char *end = next + size;
-  
-  // Allocate a new page if we need one.
-  if (LLVM_UNLIKELY(((uintptr_t)next & ~pagesizeMask)
-                      != (((uintptr_t)end & ~pagesizeMask)))){
-    next = (char*)
+  char *addr = next.load(std::memory_order_relaxed);
+  while (true) {
+    char *end = addr + size;
+
+    // Bump the pointer if the allocation fits into the current page.
+    if (LLVM_LIKELY(((uintptr_t)addr & ~pagesizeMask)
+                      == (((uintptr_t)end & ~pagesizeMask)))) {
+      if (next.compare_exchange_weak(addr, end, std::memory_order_relaxed))
+        return addr;
+      continue;
+    }
+
+    // Allocate a new page and try to install it. If another thread installed
+    // a page of its own in the meantime, give ours back and retry there.
+    char *page = (char*)
       mmap(nullptr, pagesizeMask+1, PROT_READ|PROT_WRITE,
            MAP_ANON|MAP_PRIVATE, VM_TAG_FOR_SWIFT_METADATA, 0);
 
-    if (next == MAP_FAILED)
+    if (page == MAP_FAILED)
       crash("unable to allocate memory for metadata cache");
-    end = next + size;
+
+    if (next.compare_exchange_strong(addr, page + size,
+                                     std::memory_order_relaxed))
+      return page;
+
+    munmap(page, pagesizeMask+1);
   }
-  
-  char *addr = next;
-  next = end;
-  return addr;
 }
 
 namespace {
@@ -254,6 +265,9 @@ swift::swift_getGenericMetadata(GenericMetadata *pattern,
 
   auto entry = getCache(pattern).findOrAdd(genericArgs, numGenericArgs,
     [&]() -> GenericCacheEntry* {
+      SWIFT_INSTANTIATEGENERICMETADATA((void *)pattern);
+      SWIFT_RUNTIME_STATISTIC(GenericMetadataInstantiations);
+
       // Create new metadata to cache.
       auto metadata = pattern->CreateFunction(pattern, arguments);
       auto entry = GenericCacheEntry::getFromMetadata(pattern, metadata);
@@ -264,6 +278,27 @@ swift::swift_getGenericMetadata(GenericMetadata *pattern,
   return entry->Value;
 }
 
+const Metadata *
+swift::swift_registerGenericMetadata(GenericMetadata *pattern,
+                                     const void *arguments,
+                                     const Metadata *metadata) {
+  auto genericArgs = (const void * const *) arguments;
+  size_t numGenericArgs = pattern->NumKeyArguments;
+  auto &cache = getCache(pattern);
+
+  // The metadata doesn't live in a cache entry, so allocate an entry which
+  // only holds the key and points at it.
+  auto entry = cache.findOrAdd(genericArgs, numGenericArgs,
+    [&]() -> GenericCacheEntry* {
+      auto entry = GenericCacheEntry::allocate(cache.getAllocator(),
+                                               genericArgs, numGenericArgs, 0);
+      entry->Value = metadata;
+      return entry;
+    });
+
+  return entry->Value;
+}
+
 /// Fast entry points.
 const Metadata *
 swift::swift_getGenericMetadata1(GenericMetadata *pattern, const void*argument){
@@ -570,6 +605,7 @@ static OpaqueValue *tuple_allocateBuffer(ValueBuffer *buffer,
   if (IsInline)
     return reinterpret_cast<OpaqueValue*>(buffer);
 
+  SWIFT_RUNTIME_STATISTIC(ValueBufferAllocations);
   auto wtable = tuple_getValueWitnesses(metatype);
   auto value = (OpaqueValue*) swift_slowAlloc(wtable->size,
                                               wtable->getAlignmentMask());
@@ -1169,6 +1205,7 @@ static void pod_indirect_deallocateBuffer(ValueBuffer *buffer,
 
 static OpaqueValue *pod_indirect_initializeBufferWithCopyOfBuffer(
                     ValueBuffer *dest, ValueBuffer *src, const Metadata *self) {
+  SWIFT_RUNTIME_STATISTIC(ValueBufferAllocations);
   auto wtable = self->getValueWitnesses();
   auto destBuf = (OpaqueValue*)swift_slowAlloc(wtable->size,
                                                wtable->getAlignmentMask());
@@ -1191,6 +1228,7 @@ static OpaqueValue *pod_indirect_projectBuffer(ValueBuffer *buffer,
 
 static OpaqueValue *pod_indirect_allocateBuffer(ValueBuffer *buffer,
                                                 const Metadata *self) {
+  SWIFT_RUNTIME_STATISTIC(ValueBufferAllocations);
   auto wtable = self->getValueWitnesses();
   auto destBuf = (OpaqueValue*)swift_slowAlloc(wtable->size,
                                                wtable->getAlignmentMask());
@@ -1219,6 +1257,7 @@ static void *pod_noop_return(void *object, const Metadata *self) {
 static OpaqueValue *pod_indirect_initializeBufferWithCopy(ValueBuffer *dest,
                                                           OpaqueValue *src,
                                                           const Metadata *self){
+  SWIFT_RUNTIME_STATISTIC(ValueBufferAllocations);
   auto wtable = self->getValueWitnesses();
   auto destBuf = (OpaqueValue*)swift_slowAlloc(wtable->size,
                                                wtable->getAlignmentMask());
@@ -1466,6 +1505,11 @@ void swift::swift_initClassMetadata_UniversalStrategy(ClassMetadata *self,
                                           size_t numFields,
                                           const ClassFieldLayout *fieldLayouts,
                                           size_t *fieldOffsets) {
+  // The nominal type descriptor is emitted into the image of the class even
+  // when the metadata itself was instantiated.
+  startup_profile::Timer timer(startup_profile::Phase::ClassMetadata,
+                               self->getDescription());
+
   // Start layout by appending to a standard heap object header.
   size_t size, alignMask;
 
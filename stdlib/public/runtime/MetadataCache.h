@@ -14,8 +14,10 @@
 
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
 #include "swift/Runtime/Concurrent.h"
 #include "swift/Runtime/Metadata.h"
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 
@@ -53,7 +55,7 @@ public:
     return Entry::fromArgumentsBuffer(args, length);
   }
 
-  bool operator==(EntryRef<Entry>& rhs) const {
+  bool operator==(const EntryRef<Entry> &rhs) const {
     // Compare the sizes.
     unsigned asize = size(), bsize = rhs.size();
     if (asize != bsize) return false;
@@ -65,7 +67,7 @@ public:
     return true;
   }
 
-  size_t hash() {
+  size_t hash() const {
     size_t H = 0x56ba80d1 ^ length ;
     for (unsigned i = 0; i < length; i++) {
       H = (H >> 10) | (H << ((sizeof(size_t) * 8) - 10));
@@ -140,24 +142,125 @@ public:
 
 /// The implementation of a metadata cache.  Note that all-zero must
 /// be a valid state for the cache.
+///
+/// Entries are kept in an open-addressing hash table of atomic node
+/// pointers. Lookups of existing entries never take a lock: they load the
+/// current table, probe it linearly and compare the stored keys. The table
+/// is never more than three-quarters full, so a probe sequence always ends
+/// at an empty slot.
+///
+/// Insertion takes a short-lived lock that only guards the table itself.
+/// A thread that misses publishes a "pending" node for its key, releases
+/// the lock, and then builds the entry without holding any lock. Other
+/// threads asking for the same key wait for that node to be completed;
+/// threads asking for different keys are never blocked by the construction.
+///
+/// When the table grows, the old slot array is retired but not freed, since
+/// concurrent readers may still be probing it. A reader that misses in a
+/// retired table falls into the locked slow path, which re-probes the
+/// current table.
 template <class Entry> class MetadataCache {
 
-  /// This pair ties an EntryRef Key and an Entry Value.
-  struct EntryPair {
-    EntryPair(EntryRef<Entry> K, Entry* V) : Key(K), Value(V) {}
-    EntryRef<Entry> Key;
-    Entry* Value;
+  /// A node in the table, tying a copy of the key arguments to the entry
+  /// that is (or will be) built for them. The key arguments are tail
+  /// allocated.
+  struct Node {
+    Node(size_t hash, unsigned numArguments)
+      : Hash(hash), NumArguments(numArguments), Value(nullptr) {}
+
+    size_t Hash;
+    unsigned NumArguments;
+
+    /// The completed entry, or null while the entry is being constructed.
+    std::atomic<const Entry *> Value;
+
+    const void * const *getArguments() const {
+      return reinterpret_cast<const void * const *>(this + 1);
+    }
+
+    EntryRef<Entry> getKey() const {
+      return EntryRef<Entry>::forArguments(getArguments(), NumArguments);
+    }
+  };
+
+  /// An array of slots. Tables are chained to their predecessors so that
+  /// retired tables can be released when the cache is destroyed.
+  struct Table {
+    size_t Mask;
+    Table *Previous;
+
+    std::atomic<Node *> *getSlots() {
+      return reinterpret_cast<std::atomic<Node *> *>(this + 1);
+    }
+
+    static Table *create(size_t capacity, Table *previous) {
+      assert(llvm::isPowerOf2_64(capacity));
+      void *buffer = malloc(sizeof(Table) +
+                            capacity * sizeof(std::atomic<Node *>));
+      auto table = new (buffer) Table;
+      table->Mask = capacity - 1;
+      table->Previous = previous;
+      for (size_t i = 0; i != capacity; ++i)
+        new (&table->getSlots()[i]) std::atomic<Node *>(nullptr);
+      return table;
+    }
+
+    static void destroy(Table *table) {
+      while (table) {
+        auto previous = table->Previous;
+        free(table);
+        table = previous;
+      }
+    }
+
+    /// Probe the table for the node matching \p key. Returns null if there
+    /// is no such node. Safe to call concurrently with insertion.
+    Node *find(EntryRef<Entry> key, size_t hash) {
+      auto slots = getSlots();
+      for (size_t i = hash & Mask; ; i = (i + 1) & Mask) {
+        Node *node = slots[i].load(std::memory_order_acquire);
+        if (!node)
+          return nullptr;
+        if (node->Hash == hash) {
+          auto nodeKey = node->getKey();
+          if (nodeKey == key)
+            return node;
+        }
+      }
+    }
+
+    /// Place \p node in the first free slot of its probe sequence.
+    /// Must be called with the cache's table lock held.
+    void insert(Node *node) {
+      auto slots = getSlots();
+      for (size_t i = node->Hash & Mask; ; i = (i + 1) & Mask) {
+        if (!slots[i].load(std::memory_order_relaxed)) {
+          slots[i].store(node, std::memory_order_release);
+          return;
+        }
+      }
+    }
   };
 
-  /// This collection maps hash codes to a list of entry pairs.
-  typedef ConcurrentMap<size_t, EntryPair> MDMapTy;
+  /// The synchronization primitives used on the slow path.
+  struct SyncState {
+    /// Guards modifications of the table, the node count and the entry list.
+    std::mutex TableLock;
 
-  /// This map hash codes of entry refs to a list of entry pairs.
-  MDMapTy *Map;
+    /// Used together with the condition below to wait for an entry that is
+    /// being built by another thread.
+    std::mutex ConstructionLock;
+    std::condition_variable ConstructionDone;
+  };
+
+  /// The current table. Null until the first entry is added.
+  std::atomic<Table *> Slots;
+
+  /// The number of nodes in the current table.
+  size_t NumNodes;
+
+  SyncState *Sync;
 
-  /// Synchronization of metadata creation.
-  std::mutex *Lock;
-  
   /// The head of a linked list connecting all the metadata cache entries.
   /// TODO: Remove this when LLDB is able to understand the final data
   /// structure for the metadata cache.
@@ -165,60 +268,120 @@ template <class Entry> class MetadataCache {
 
   /// Allocator for entries of this cache.
   MetadataAllocator Allocator;
-  
+
+  /// Find the node for \p key, or publish a new pending node for it.
+  /// \p isNew is set if the caller is now responsible for building the
+  /// entry.
+  Node *findOrInsertNode(EntryRef<Entry> key, size_t hash, bool &isNew) {
+    std::lock_guard<std::mutex> tableGuard(Sync->TableLock);
+
+    Table *table = Slots.load(std::memory_order_relaxed);
+    if (table) {
+      if (Node *existing = table->find(key, hash)) {
+        isNew = false;
+        return existing;
+      }
+    }
+
+    // Grow the table if adding this node would make it more than
+    // three-quarters full.
+    size_t capacity = table ? table->Mask + 1 : 0;
+    if ((NumNodes + 1) * 4 > capacity * 3) {
+      Table *newTable = Table::create(capacity ? capacity * 2 : 16, table);
+      if (table) {
+        auto oldSlots = table->getSlots();
+        for (size_t i = 0; i != capacity; ++i)
+          if (Node *n = oldSlots[i].load(std::memory_order_relaxed))
+            newTable->insert(n);
+      }
+      Slots.store(newTable, std::memory_order_release);
+      table = newTable;
+    }
+
+    // Publish a pending node carrying a copy of the key.
+    void *buffer = Allocator.alloc(sizeof(Node) +
+                                   key.size() * sizeof(const void *));
+    Node *node = new (buffer) Node(hash, key.size());
+    memcpy(const_cast<const void **>(node->getArguments()), key.begin(),
+           key.size() * sizeof(const void *));
+    table->insert(node);
+    ++NumNodes;
+
+    isNew = true;
+    return node;
+  }
+
+  /// Wait until \p node has been completed by the thread constructing it.
+  const Entry *waitForEntry(Node *node) {
+    if (auto value = node->Value.load(std::memory_order_acquire))
+      return value;
+
+    std::unique_lock<std::mutex> guard(Sync->ConstructionLock);
+    const Entry *value;
+    while (!(value = node->Value.load(std::memory_order_acquire)))
+      Sync->ConstructionDone.wait(guard);
+    return value;
+  }
+
 public:
-  MetadataCache() : Map(new MDMapTy()), Lock(new std::mutex()) {}
-  ~MetadataCache() { delete Map; delete Lock; }
+  MetadataCache()
+    : Slots(nullptr), NumNodes(0), Sync(new SyncState()), Head(nullptr) {}
+  ~MetadataCache() {
+    Table::destroy(Slots.load(std::memory_order_relaxed));
+    delete Sync;
+  }
 
   /// Caches are not copyable.
   MetadataCache(const MetadataCache &other) = delete;
   MetadataCache &operator=(const MetadataCache &other) = delete;
 
   /// Get the allocator for metadata in this cache.
-  /// The allocator can only be safely used while the cache is locked during
-  /// an addMetadataEntry call.
+  /// The allocator is thread-safe, so it can be used by entry builders
+  /// running concurrently for different keys.
   MetadataAllocator &getAllocator() { return Allocator; }
 
   /// Call entryBuilder() and add the generated metadata to the cache.
-  /// \p key is the key used by the cache and \p Bucket is the cache
-  /// entry to place the new metadata entry.
+  /// \p key is the key used by the cache and \p hash is its hash value.
   /// This method is marked as 'noinline' because it is infrequently executed
   /// and marking it as such generates better code that is easier to analyze
   /// and profile.
   __attribute__ ((noinline))
-  const Entry *addMetadataEntry(EntryRef<Entry> key,
-                                ConcurrentList<EntryPair> &Bucket,
+  const Entry *addMetadataEntry(EntryRef<Entry> key, size_t hash,
                                 llvm::function_ref<Entry *()> entryBuilder) {
-    // Hold a lock to prevent the modification of the cache by multiple threads.
-    std::unique_lock<std::mutex> ConstructionGuard(*Lock);
+    bool isNew;
+    Node *node = findOrInsertNode(key, hash, isNew);
 
-    // Some other thread may have setup the value we are about to construct
-    // while we were asleep so do a search before constructing a new value.
-    for (auto &A : Bucket) {
-      if (A.Key == key) return A.Value;
-    }
+    // Some other thread may have set up the value we are about to construct
+    // while we were asleep, or may be constructing it right now.
+    if (!isNew)
+      return waitForEntry(node);
 
-    // Build the new cache entry.
+    // Build the new cache entry without holding any lock, so that the
+    // construction of other keys can proceed in parallel.
     // For some cache types this call may re-entrantly perform additional
     // cache lookups.
-    // Notice that the entry is completly constructed before it is inserted
-    // into the map, and that only one entry can be constructed at once
-    // because of the lock above.
     Entry *entry = entryBuilder();
     assert(entry);
 
     // Update the linked list.
-    entry->Next = Head;
-    Head = entry;
+    {
+      std::lock_guard<std::mutex> tableGuard(Sync->TableLock);
+      entry->Next = Head;
+      Head = entry;
+    }
 
-    key = EntryRef<Entry>::forEntry(entry, entry->getNumArguments());
-    Bucket.push_front(EntryPair(key, entry));
+    // Complete the node and wake up anybody waiting for it.
+    {
+      std::lock_guard<std::mutex> guard(Sync->ConstructionLock);
+      node->Value.store(entry, std::memory_order_release);
+    }
+    Sync->ConstructionDone.notify_all();
 
 #if SWIFT_DEBUG_RUNTIME
     printf("%s(%p): created %p\n",
            Entry::getName(), this, entry);
 #endif
-    return key.getEntry();
+    return entry;
   }
 
   /// Look up a cached metadata entry. If a cache match exists, return it.
@@ -242,16 +405,18 @@ public:
            Entry::getName(), this, hash);
 #endif
 
-    // Look for an existing entry.
-    // Find the bucket for the metadata entry.
-    ConcurrentList<EntryPair> &Bucket = Map->findOrAllocateNode(hash);
-    // Scan the bucket and return the value if we found the key.
-    for (auto &A : Bucket) {
-      if (A.Key == key) return A.Value;
+    // Look for an existing entry without taking any locks.
+    if (Table *table = Slots.load(std::memory_order_acquire)) {
+      if (Node *node = table->find(key, hash)) {
+        if (auto value = node->Value.load(std::memory_order_acquire))
+          return value;
+        // The entry is still being constructed by another thread.
+        return waitForEntry(node);
+      }
     }
 
     // We did not find a key so we will need to create one and store it.
-    return addMetadataEntry(key, Bucket, entryBuilder);
+    return addMetadataEntry(key, hash, entryBuilder);
   }
 };
 
@@ -44,7 +44,10 @@
 #include "swift/Runtime/Config.h"
 #include "swift/Runtime/Metadata.h"
 #include "swift/Runtime/HeapObject.h"
+#include "Probes.h"
+#include <algorithm>
 #include <cstring>
+#include <limits>
 #include <type_traits>
 
 namespace swift {
@@ -200,17 +203,46 @@ template <class Impl, class T> struct RetainableBoxBase {
     return dest;
   }
   
-  static void destroyArray(T *arr, size_t n) {
+  /// Retain a value n times. Boxes with a batched runtime entry point
+  /// override this.
+  static void retainN(T value, int n) {
+    while (n--)
+      Impl::retain(value);
+  }
+
+  /// Release a value n times.
+  static void releaseN(T value, int n) {
     while (n--)
-      Impl::release(*arr++);
+      Impl::release(value);
+  }
+
+  // Arrays often hold long runs of the same reference (e.g. after
+  // Array(count:repeatedValue:)), so the array witnesses adjust the
+  // reference count once per run instead of once per element.
+  static void destroyArray(T *arr, size_t n) {
+    while (n) {
+      int run = countRun(arr, n);
+      if (run == 1)
+        Impl::release(*arr);
+      else
+        Impl::releaseN(*arr, run);
+      arr += run;
+      n -= run;
+    }
   }
   
   static T *initializeArrayWithCopy(T *dest, T *src, size_t n) {
-    T *r = dest;
     memcpy(dest, src, n * sizeof(T));
-    while (n--)
-      Impl::retain(*dest++);
-    return r;
+    while (n) {
+      int run = countRun(src, n);
+      if (run == 1)
+        Impl::retain(*src);
+      else
+        Impl::retainN(*src, run);
+      src += run;
+      n -= run;
+    }
+    return dest;
   }
   
   static T *initializeArrayWithTakeFrontToBack(T *dest, T *src, size_t n) {
@@ -250,6 +282,17 @@ template <class Impl, class T> struct RetainableBoxBase {
   static int getExtraInhabitantIndex(const T *src) {
     return swift_getHeapObjectExtraInhabitantIndex((HeapObject* const *) src);
   }
+
+private:
+  /// Returns the number of leading elements of arr which are equal to the
+  /// first one. The result is at least 1 and fits the _n entry points.
+  static int countRun(const T *arr, size_t n) {
+    size_t limit = std::min(n, size_t(std::numeric_limits<int>::max()));
+    size_t run = 1;
+    while (run < limit && arr[run] == arr[0])
+      ++run;
+    return int(run);
+  }
 };
 
 /// A box implementation class for Swift object pointers.
@@ -263,6 +306,14 @@ struct SwiftRetainableBox :
   static void release(HeapObject *obj) {
     swift_release(obj);
   }
+
+  static void retainN(HeapObject *obj, int n) {
+    swift_retain_n(obj, n);
+  }
+
+  static void releaseN(HeapObject *obj, int n) {
+    swift_release_n(obj, n);
+  }
 };
 
 /// A box implementation class for Swift unowned object pointers.
@@ -276,6 +327,14 @@ struct SwiftUnownedRetainableBox :
   static void release(HeapObject *obj) {
     swift_weakRelease(obj);
   }
+
+  static void retainN(HeapObject *obj, int n) {
+    swift_weakRetain_n(obj, n);
+  }
+
+  static void releaseN(HeapObject *obj, int n) {
+    swift_weakRelease_n(obj, n);
+  }
 };
 
 /// CRTP base class for weak reference boxes.
@@ -440,6 +499,14 @@ struct UnknownRetainableBox : RetainableBoxBase<UnknownRetainableBox, void*> {
     swift_release(static_cast<HeapObject *>(obj));
 #endif
   }
+
+  static void retainN(void *obj, int n) {
+    swift_unknownRetain_n(obj, n);
+  }
+
+  static void releaseN(void *obj, int n) {
+    swift_unknownRelease_n(obj, n);
+  }
 };
 
 /// A box implementation class for BridgeObject.
@@ -455,6 +522,14 @@ struct BridgeObjectBox :
   static void release(void *obj) {
     swift_bridgeObjectRelease(obj);
   }
+
+  static void retainN(void *obj, int n) {
+    swift_bridgeObjectRetain_n(obj, n);
+  }
+
+  static void releaseN(void *obj, int n) {
+    swift_bridgeObjectRelease_n(obj, n);
+  }
       
   static void storeExtraInhabitant(void **dest, int index) {
     *dest = nullptr;
@@ -756,6 +831,7 @@ struct BufferValueWitnesses<Impl, Size, Alignment, FixedPacking::Allocate>
   static constexpr bool isInline = false;
 
   static OpaqueValue *allocateBuffer(ValueBuffer *buffer, const Metadata *self) {
+    SWIFT_RUNTIME_STATISTIC(ValueBufferAllocations);
     OpaqueValue *value =
       static_cast<OpaqueValue*>(SwiftAllocator<Size, Alignment>::alloc());
     buffer->PrivateData[0] = value;
@@ -784,6 +860,7 @@ struct NonFixedBufferValueWitnesses : BufferValueWitnessesBase<Impl> {
     if (!IsKnownAllocated && vwtable->isValueInline()) {
       return reinterpret_cast<OpaqueValue*>(buffer);
     } else {
+      SWIFT_RUNTIME_STATISTIC(ValueBufferAllocations);
       OpaqueValue *value =
         static_cast<OpaqueValue*>(swift_slowAlloc(vwtable->size,
                                                   vwtable->getAlignmentMask()));
@@ -16,6 +16,7 @@
 
 #include "swift/Runtime/Once.h"
 #include "swift/Runtime/Debug.h"
+#include "Probes.h"
 #include <type_traits>
 
 using namespace swift;
@@ -34,11 +35,31 @@ static_assert(std::is_same<swift_once_t, dispatch_once_t>::value,
 static_assert(sizeof(swift_once_t) <= sizeof(void*),
               "swift_once_t must be no larger than the platform word");
 
+/// Runs the initializer \p fn under a timer of the startup profile.
+static void runTimedInitializer(void (*fn)(void *)) {
+  startup_profile::Timer timer(startup_profile::Phase::Once,
+                               reinterpret_cast<const void *>(fn));
+  fn(nullptr);
+}
+
+#if defined(__APPLE__)
+static void runTimedInitializerContext(void *context) {
+  runTimedInitializer(reinterpret_cast<void (*)(void *)>(context));
+}
+#endif
+
 /// Runs the given function with the given context argument exactly once.
 /// The predicate argument must point to a global or static variable of static
 /// extent of type swift_once_t.
 void swift::swift_once(swift_once_t *predicate, void (*fn)(void *)) {
 #if defined(__APPLE__)
+  // Only initializations are timed, so once the predicate is set the profile
+  // isn't checked.
+  if (LLVM_UNLIKELY(*predicate != ~0l && startup_profile::isEnabled())) {
+    dispatch_once_f(predicate, reinterpret_cast<void *>(fn),
+                    runTimedInitializerContext);
+    return;
+  }
   dispatch_once_f(predicate, nullptr, fn);
 #else
   // FIXME: We're relying here on the coincidence that libstdc++ uses pthread's
@@ -47,6 +68,6 @@ void swift::swift_once(swift_once_t *predicate, void (*fn)(void *)) {
   // 1 to 2 during initialization) to work. We should implement our own version
   // that we can rely on to continue to work that way.
   // For more information, see rdar://problem/18499385
-  std::call_once(*predicate, [fn]() { fn(nullptr); });
+  std::call_once(*predicate, [fn]() { runTimedInitializer(fn); });
 #endif
 }
@@ -0,0 +1,197 @@
+//===--- Probes.h - Swift Runtime DTrace probes and counters ----*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Hooks for observing runtime hot paths. Each event can fire a DTrace probe
+// (SWIFT_RUNTIME_ENABLE_DTRACE) and bump a per-thread counter
+// (SWIFT_RUNTIME_ENABLE_STATISTICS). Both compile to nothing by default.
+//
+// Allocations are also reported to the sampling allocation profiler, and
+// startup work to the startup profile. Both are always built in and cost one
+// relaxed load while they are off.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_RUNTIME_PROBES_H
+#define SWIFT_RUNTIME_PROBES_H
+
+#include "llvm/Support/Compiler.h"
+#include <atomic>
+#include <cstddef>
+
+#if SWIFT_RUNTIME_ENABLE_DTRACE
+# include "SwiftRuntimeDTraceProbes.h"
+#else
+# define SWIFT_ALLOCATEOBJECT()
+# define SWIFT_DEALLOCATEOBJECT()
+# define SWIFT_RELEASE()
+# define SWIFT_RETAIN()
+# define SWIFT_ALLOCATEBOX()
+# define SWIFT_INSTANTIATEGENERICMETADATA(pattern)
+# define SWIFT_CONFORMANCECACHEHIT(type, protocol)
+# define SWIFT_CONFORMANCECACHEMISS(type, protocol)
+# define SWIFT_DYNAMICCAST(srcType, targetType)
+#endif
+
+#if SWIFT_RUNTIME_ENABLE_STATISTICS
+
+namespace swift {
+namespace stats {
+
+enum class Counter : unsigned {
+#define RUNTIME_STATISTIC(Name, Description) Name,
+#include "swift/Runtime/RuntimeStatistics.def"
+  NumCounters
+};
+
+enum class State : int {
+  /// The environment has not been checked yet.
+  Unknown,
+  Disabled,
+  Enabled,
+};
+
+extern std::atomic<State> CurrentState;
+
+/// Counts an event on the current thread, or determines whether counting is
+/// enabled at all.
+void countSlow(Counter counter);
+
+static inline void count(Counter counter) {
+  if (LLVM_UNLIKELY(CurrentState.load(std::memory_order_relaxed) !=
+                    State::Disabled))
+    countSlow(counter);
+}
+
+} // end namespace stats
+} // end namespace swift
+
+# define SWIFT_RUNTIME_STATISTIC(Name) \
+  ::swift::stats::count(::swift::stats::Counter::Name)
+#else
+# define SWIFT_RUNTIME_STATISTIC(Name)
+#endif
+
+namespace swift {
+namespace alloc_profiler {
+
+enum class State : int {
+  /// The environment has not been checked yet.
+  Unknown,
+  Disabled,
+  Enabled,
+};
+
+extern std::atomic<State> CurrentState;
+
+void noteAllocationSlow(void *ptr, size_t size);
+void noteObjectTypeSlow(const void *object, const void *type);
+void noteDeallocationSlow(void *ptr);
+
+static inline bool isActive() {
+  return LLVM_UNLIKELY(CurrentState.load(std::memory_order_relaxed) !=
+                       State::Disabled);
+}
+
+/// Reports memory returned by swift_slowAlloc.
+static inline void noteAllocation(void *ptr, size_t size) {
+  if (isActive())
+    noteAllocationSlow(ptr, size);
+}
+
+/// Reports the type of a heap object which was just allocated. For a box,
+/// this is called again with the type of the boxed value.
+static inline void noteObjectType(const void *object, const void *type) {
+  if (isActive())
+    noteObjectTypeSlow(object, type);
+}
+
+/// Reports memory passed to swift_slowDealloc.
+static inline void noteDeallocation(void *ptr) {
+  if (isActive())
+    noteDeallocationSlow(ptr);
+}
+
+} // end namespace alloc_profiler
+
+namespace startup_profile {
+
+/// The kinds of startup work that are timed.
+enum class Phase : unsigned {
+  /// Registering the protocol conformance records of an image.
+  Conformances,
+  /// Running a global initializer through swift_once.
+  Once,
+  /// swift_initClassMetadata_UniversalStrategy.
+  ClassMetadata,
+  NumPhases
+};
+
+enum class State : int {
+  /// The environment has not been checked yet.
+  Unknown,
+  Disabled,
+  Enabled,
+};
+
+extern std::atomic<State> CurrentState;
+
+/// Checks the environment if that hasn't been done yet, and returns whether
+/// the profile is enabled.
+bool isEnabledSlow();
+
+static inline bool isEnabled() {
+  State state = CurrentState.load(std::memory_order_relaxed);
+  if (LLVM_LIKELY(state == State::Disabled))
+    return false;
+  return state == State::Enabled || isEnabledSlow();
+}
+
+/// Times one piece of startup work for as long as it is in scope, and
+/// attributes it to the image which contains \p Address.
+class Timer {
+public:
+  Timer(Phase P, const void *Address)
+    : P(P), Address(Address), Active(isEnabled()) {
+    if (LLVM_UNLIKELY(Active))
+      start();
+  }
+
+  ~Timer() {
+    if (LLVM_UNLIKELY(Active))
+      finish();
+  }
+
+  Timer(const Timer &) = delete;
+  Timer &operator=(const Timer &) = delete;
+
+  /// Counts the work as \p N items, such as conformance records, instead of
+  /// one.
+  void setCount(uint64_t N) { Count = N; }
+
+private:
+  void start();
+  void finish();
+
+  Phase P;
+  const void *Address;
+  bool Active;
+  uint64_t Count = 1;
+  uint64_t Start = 0;
+  /// The time spent in timers nested in this one.
+  uint64_t NestedTime = 0;
+  Timer *Parent = nullptr;
+};
+
+} // end namespace startup_profile
+} // end namespace swift
+
+#endif
@@ -16,6 +16,8 @@
 #include "swift/Runtime/Metadata.h"
 #include "swift/Runtime/Enum.h"
 #include "swift/Basic/Demangle.h"
+#include "swift/Basic/Lazy.h"
+#include "swift/Runtime/Concurrent.h"
 #include "swift/Runtime/Debug.h"
 #include "Private.h"
 #include <cassert>
@@ -496,8 +498,60 @@ StringMirrorTuple swift_TupleMirror_subscript(intptr_t i,
   return result;
 }
   
+// Field names are stored as a doubly-null-terminated list, which has to be
+// scanned from the start to find a name. Mirrors look children up one index
+// at a time, so walking all the children of a type with many fields would be
+// quadratic. The first lookup past the first few names builds a table of
+// pointers to each name; the table is cached forever, keyed by the list.
+namespace {
+  struct FieldNameTable {
+    const char *FieldNames;
+    const char * const *Names;
+    size_t NumNames;
+  };
+
+  struct FieldNameTableCacheState {
+    ConcurrentMap<size_t, FieldNameTable> Cache;
+  };
+}
+
+static Lazy<FieldNameTableCacheState> FieldNameTables;
+
+/// Names before this index are found by scanning, which is cheaper than
+/// the cache lookup.
+static const size_t MinCachedFieldNameIndex = 4;
+
+static const FieldNameTable &getFieldNameTable(const char *fieldNames) {
+  auto &bucket = FieldNameTables.get().Cache.findOrAllocateNode(
+    (size_t)fieldNames >> 3);
+  for (auto &table : bucket)
+    if (table.FieldNames == fieldNames)
+      return table;
+
+  size_t numNames = 0;
+  for (const char *name = fieldNames; *name; name += strlen(name) + 1)
+    ++numNames;
+  auto names = (const char **)malloc(numNames * sizeof(const char *));
+  const char *name = fieldNames;
+  for (size_t i = 0; i < numNames; ++i) {
+    names[i] = name;
+    name += strlen(name) + 1;
+  }
+
+  // If another thread builds the same table concurrently, both stay valid
+  // and the first one in the bucket is found from then on.
+  bucket.push_front(FieldNameTable{fieldNames, names, numNames});
+  return *bucket.begin();
+}
+
 // Get a field name from a doubly-null-terminated list.
 static const char *getFieldName(const char *fieldNames, size_t i) {
+  if (i >= MinCachedFieldNameIndex) {
+    auto &table = getFieldNameTable(fieldNames);
+    assert(i < table.NumNames);
+    return table.Names[i];
+  }
+
   const char *fieldName = fieldNames;
   for (size_t j = 0; j < i; ++j) {
     size_t len = strlen(fieldName);
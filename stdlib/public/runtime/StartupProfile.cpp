@@ -0,0 +1,209 @@
+//===--- StartupProfile.cpp - Runtime startup time breakdown --------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Times are kept per image, keyed by the image's load address as reported by
+// dladdr. A process loads few images, so they are kept in a vector which is
+// searched linearly under a lock; the lock is only taken while the profile
+// is enabled.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/StartupProfile.h"
+#include "swift/Basic/Lazy.h"
+#include "Probes.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace swift;
+using namespace swift::startup_profile;
+
+std::atomic<State> swift::startup_profile::CurrentState{State::Unknown};
+
+namespace {
+
+constexpr unsigned NumPhases = unsigned(Phase::NumPhases);
+
+struct PhaseTotal {
+  uint64_t Count = 0;
+  uint64_t Nanoseconds = 0;
+};
+
+struct Image {
+  /// The load address of the image, or null for addresses outside of any
+  /// image, such as the metadata of generic classes.
+  const void *Base;
+  std::string Path;
+  PhaseTotal Phases[NumPhases];
+};
+
+struct Registry {
+  std::mutex Lock;
+  std::vector<Image> Images;
+};
+
+} // end anonymous namespace
+
+// Never destroyed: initializers may still run after static destructors have.
+static Lazy<Registry> TheRegistry;
+
+/// The innermost timer running on this thread.
+static __thread Timer *CurrentTimer;
+
+static uint64_t now() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(
+      steady_clock::now().time_since_epoch()).count();
+}
+
+static void printProfileAtExit() {
+  swift_writeStartupProfile(STDERR_FILENO);
+}
+
+bool swift::startup_profile::isEnabledSlow() {
+  State state = CurrentState.load(std::memory_order_relaxed);
+  if (state == State::Unknown) {
+    const char *value = getenv("SWIFT_STARTUP_PROFILE");
+    bool enabled = value && strcmp(value, "1") == 0;
+    // Don't override an explicit swift_setStartupProfileEnabled call.
+    if (CurrentState.compare_exchange_strong(
+            state, enabled ? State::Enabled : State::Disabled,
+            std::memory_order_relaxed) &&
+        enabled)
+      atexit(printProfileAtExit);
+    state = CurrentState.load(std::memory_order_relaxed);
+  }
+  return state == State::Enabled;
+}
+
+void Timer::start() {
+  Parent = CurrentTimer;
+  CurrentTimer = this;
+  Start = now();
+}
+
+void Timer::finish() {
+  uint64_t elapsed = now() - Start;
+  CurrentTimer = Parent;
+  if (Parent)
+    Parent->NestedTime += elapsed;
+  uint64_t exclusive = elapsed > NestedTime ? elapsed - NestedTime : 0;
+
+  // Look the image up before taking the lock; dladdr takes the loader's
+  // lock.
+  Dl_info info;
+  const void *base = nullptr;
+  const char *path = "<no image>";
+  if (dladdr(Address, &info) && info.dli_fbase) {
+    base = info.dli_fbase;
+    if (info.dli_fname)
+      path = info.dli_fname;
+  }
+
+  auto &registry = TheRegistry.get();
+  std::lock_guard<std::mutex> guard(registry.Lock);
+  Image *image = nullptr;
+  for (auto &candidate : registry.Images) {
+    if (candidate.Base == base) {
+      image = &candidate;
+      break;
+    }
+  }
+  if (!image) {
+    registry.Images.push_back(Image{base, path, {}});
+    image = &registry.Images.back();
+  }
+
+  PhaseTotal &total = image->Phases[unsigned(P)];
+  total.Count += Count;
+  total.Nanoseconds += exclusive;
+}
+
+void swift::swift_setStartupProfileEnabled(bool enabled) {
+  CurrentState.store(enabled ? State::Enabled : State::Disabled,
+                     std::memory_order_relaxed);
+}
+
+static bool writeString(int fd, const char *string, size_t length) {
+  while (length) {
+    ssize_t written = write(fd, string, length);
+    if (written < 0)
+      return false;
+    string += written;
+    length -= written;
+  }
+  return true;
+}
+
+static void appendPhases(std::string &out, const PhaseTotal *phases) {
+  char buffer[64];
+  for (unsigned i = 0; i < NumPhases; ++i) {
+    snprintf(buffer, sizeof(buffer), "%10llu %10.3f ",
+             (unsigned long long)phases[i].Count,
+             phases[i].Nanoseconds / 1e6);
+    out += buffer;
+  }
+}
+
+bool swift::swift_writeStartupProfile(int fd) {
+  std::vector<Image> images;
+  {
+    auto &registry = TheRegistry.get();
+    std::lock_guard<std::mutex> guard(registry.Lock);
+    images = registry.Images;
+  }
+
+  // Most expensive image first.
+  auto getTotal = [](const Image &image) {
+    uint64_t total = 0;
+    for (auto &phase : image.Phases)
+      total += phase.Nanoseconds;
+    return total;
+  };
+  std::stable_sort(images.begin(), images.end(),
+                   [&](const Image &lhs, const Image &rhs) {
+    return getTotal(lhs) > getTotal(rhs);
+  });
+
+  std::string out;
+  out += "===- Swift runtime startup profile (ms) -===\n";
+  char buffer[128];
+  snprintf(buffer, sizeof(buffer), "%21s %21s %21s  image\n",
+           "conformances", "swift_once", "class metadata");
+  out += buffer;
+  snprintf(buffer, sizeof(buffer), "%10s %10s %10s %10s %10s %10s\n",
+           "records", "time", "inits", "time", "classes", "time");
+  out += buffer;
+
+  PhaseTotal totals[NumPhases];
+  for (const Image &image : images) {
+    for (unsigned i = 0; i < NumPhases; ++i) {
+      totals[i].Count += image.Phases[i].Count;
+      totals[i].Nanoseconds += image.Phases[i].Nanoseconds;
+    }
+    appendPhases(out, image.Phases);
+    out += " ";
+    out += image.Path;
+    out += "\n";
+  }
+  appendPhases(out, totals);
+  out += " (all images)\n";
+
+  return writeString(fd, out.data(), out.size());
+}
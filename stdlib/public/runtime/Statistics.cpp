@@ -0,0 +1,212 @@
+//===--- Statistics.cpp - Swift Runtime event counters --------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Per-thread event counters which are summed up on demand.
+//
+// Every thread owns a block of counters which only it writes, so counting
+// needs no atomic read-modify-write operations. The blocks are linked into a
+// global list for readers. When a thread exits its counts are folded into a
+// global total.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/Statistics.h"
+#include "swift/Basic/Lazy.h"
+#include "Probes.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <pthread.h>
+
+#if SWIFT_RUNTIME_ENABLE_STATISTICS
+
+using namespace swift;
+using namespace swift::stats;
+
+std::atomic<State> swift::stats::CurrentState{State::Unknown};
+
+namespace {
+
+constexpr unsigned NumCounters = unsigned(Counter::NumCounters);
+
+struct ThreadCounters {
+  std::atomic<uint64_t> Values[NumCounters];
+  ThreadCounters *Next = nullptr;
+  ThreadCounters *Prev = nullptr;
+
+  ThreadCounters() {
+    for (auto &value : Values)
+      value.store(0, std::memory_order_relaxed);
+  }
+};
+
+struct Registry {
+  std::mutex Lock;
+  ThreadCounters *Head = nullptr;
+  /// The counts of threads which have exited.
+  uint64_t Retired[NumCounters] = {};
+  pthread_key_t Key;
+
+  Registry() {
+    pthread_key_create(&Key, retireThread);
+  }
+
+  static void retireThread(void *data);
+};
+
+} // end anonymous namespace
+
+// Never destroyed: threads may still exit after static destructors have run.
+static Lazy<Registry> TheRegistry;
+
+static Registry &getRegistry() {
+  return TheRegistry.get();
+}
+
+void Registry::retireThread(void *data) {
+  auto *counters = static_cast<ThreadCounters *>(data);
+  auto &registry = getRegistry();
+  {
+    std::lock_guard<std::mutex> guard(registry.Lock);
+    for (unsigned i = 0; i < NumCounters; ++i)
+      registry.Retired[i] +=
+        counters->Values[i].load(std::memory_order_relaxed);
+    if (counters->Prev)
+      counters->Prev->Next = counters->Next;
+    else
+      registry.Head = counters->Next;
+    if (counters->Next)
+      counters->Next->Prev = counters->Prev;
+  }
+  delete counters;
+}
+
+static __thread ThreadCounters *CurrentThreadCounters;
+
+static ThreadCounters *createThreadCounters() {
+  auto &registry = getRegistry();
+  auto *counters = new ThreadCounters();
+  {
+    std::lock_guard<std::mutex> guard(registry.Lock);
+    counters->Next = registry.Head;
+    if (registry.Head)
+      registry.Head->Prev = counters;
+    registry.Head = counters;
+  }
+  pthread_setspecific(registry.Key, counters);
+  CurrentThreadCounters = counters;
+  return counters;
+}
+
+static void printStatisticsAtExit() {
+  SwiftRuntimeStatistics stats;
+  swift_getRuntimeStatistics(&stats);
+#define RUNTIME_STATISTIC(Name, Description)                                   \
+  fprintf(stderr, "swift runtime statistics: %llu %s\n",                       \
+          (unsigned long long)stats.Name, Description);
+#include "swift/Runtime/RuntimeStatistics.def"
+}
+
+/// Counting is enabled by SWIFT_RUNTIME_STATISTICS=1. With
+/// SWIFT_RUNTIME_STATISTICS=print the totals are also printed to stderr when
+/// the process exits, which is what the benchmark scripts use.
+static bool isEnabledInEnvironment(bool &printAtExit) {
+  const char *value = getenv("SWIFT_RUNTIME_STATISTICS");
+  if (!value)
+    return false;
+  printAtExit = strcmp(value, "print") == 0;
+  return printAtExit || strcmp(value, "1") == 0;
+}
+
+void swift::stats::countSlow(Counter counter) {
+  auto state = CurrentState.load(std::memory_order_relaxed);
+  if (state == State::Unknown) {
+    bool printAtExit = false;
+    auto initial = isEnabledInEnvironment(printAtExit) ? State::Enabled
+                                                       : State::Disabled;
+    // Don't override an explicit swift_setRuntimeStatisticsEnabled call.
+    if (CurrentState.compare_exchange_strong(state, initial,
+                                             std::memory_order_relaxed) &&
+        printAtExit)
+      atexit(printStatisticsAtExit);
+    state = CurrentState.load(std::memory_order_relaxed);
+  }
+  if (state != State::Enabled)
+    return;
+
+  auto *counters = CurrentThreadCounters;
+  if (LLVM_UNLIKELY(!counters))
+    counters = createThreadCounters();
+
+  // Only this thread writes its counters; readers may see stale values.
+  auto &value = counters->Values[unsigned(counter)];
+  value.store(value.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+}
+
+bool swift::swift_runtimeStatisticsAvailable() {
+  return true;
+}
+
+bool swift::swift_setRuntimeStatisticsEnabled(bool enabled) {
+  CurrentState.store(enabled ? State::Enabled : State::Disabled,
+                     std::memory_order_relaxed);
+  return true;
+}
+
+bool swift::swift_getRuntimeStatistics(SwiftRuntimeStatistics *result) {
+  uint64_t totals[NumCounters];
+  auto &registry = getRegistry();
+  {
+    std::lock_guard<std::mutex> guard(registry.Lock);
+    memcpy(totals, registry.Retired, sizeof(totals));
+    for (auto *counters = registry.Head; counters; counters = counters->Next)
+      for (unsigned i = 0; i < NumCounters; ++i)
+        totals[i] += counters->Values[i].load(std::memory_order_relaxed);
+  }
+
+  unsigned i = 0;
+#define RUNTIME_STATISTIC(Name, Description) result->Name = totals[i++];
+#include "swift/Runtime/RuntimeStatistics.def"
+  return true;
+}
+
+void swift::swift_resetRuntimeStatistics() {
+  auto &registry = getRegistry();
+  std::lock_guard<std::mutex> guard(registry.Lock);
+  memset(registry.Retired, 0, sizeof(registry.Retired));
+  for (auto *counters = registry.Head; counters; counters = counters->Next)
+    for (auto &value : counters->Values)
+      value.store(0, std::memory_order_relaxed);
+}
+
+#else
+
+using namespace swift;
+
+bool swift::swift_runtimeStatisticsAvailable() {
+  return false;
+}
+
+bool swift::swift_setRuntimeStatisticsEnabled(bool enabled) {
+  return false;
+}
+
+bool swift::swift_getRuntimeStatistics(SwiftRuntimeStatistics *result) {
+  memset(result, 0, sizeof(*result));
+  return false;
+}
+
+void swift::swift_resetRuntimeStatistics() {}
+
+#endif
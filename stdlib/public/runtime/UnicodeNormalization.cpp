@@ -20,6 +20,11 @@
 #include <algorithm>
 #include <mutex>
 #include <assert.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <unicode/ustring.h>
 #include <unicode/ucol.h>
@@ -230,25 +235,43 @@ static intptr_t hashFinish(intptr_t HashState) {
   return HashState;
 }
 
-extern "C"
-intptr_t _swift_stdlib_unicode_hash(const uint16_t *Str, int32_t Length) {
-  UErrorCode ErrorCode = U_ZERO_ERROR;
-  intptr_t HashState = HASH_SEED;
-  HashState = hashChunk(GetRootCollator(), HashState, Str, Length, &ErrorCode);
-
-  if (U_FAILURE(ErrorCode)) {
-    swift::crash("hashChunk: Unexpected error hashing unicode string.");
+/// Returns true if all code units of the UTF-16 string are ASCII.
+///
+/// Mostly-ASCII text is the common case, so the check looks at 16 bytes at a
+/// time and only falls back to single code units at the end of the string.
+static bool isASCII(const uint16_t *Str, int32_t Length) {
+  int32_t Pos = 0;
+#if defined(__SSE2__)
+  const __m128i Mask = _mm_set1_epi16((short)0xFF80);
+  for (; Pos + 8 <= Length; Pos += 8) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i *)(Str + Pos));
+    if (_mm_movemask_epi8(_mm_and_si128(Chunk, Mask)) != 0)
+      return false;
   }
-  return hashFinish(HashState);
+#else
+  const uint64_t Mask = 0xFF80FF80FF80FF80ULL;
+  for (; Pos + 4 <= Length; Pos += 4) {
+    uint64_t Chunk;
+    memcpy(&Chunk, Str + Pos, sizeof(Chunk));
+    if (Chunk & Mask)
+      return false;
+  }
+#endif
+  for (; Pos < Length; ++Pos)
+    if (Str[Pos] >= 0x80)
+      return false;
+  return true;
 }
 
-extern "C" intptr_t _swift_stdlib_unicode_hash_ascii(const char *Str,
-                                                     int32_t Length) {
+/// Hashes ASCII code units with the precomputed collation table. This
+/// produces the same value as hashing the string's collation elements.
+template <typename CodeUnit>
+static intptr_t hashASCII(const CodeUnit *Str, int32_t Length) {
   const ASCIICollation *Table = ASCIICollation::getTable();
   intptr_t HashState = HASH_SEED;
   int32_t Pos = 0;
   while (Pos < Length) {
-    const char c = Str[Pos++];
+    const CodeUnit c = Str[Pos++];
     assert((c & 0x80) == 0 && "This table only exists for the ASCII subset");
     intptr_t Elem = Table->map(c);
     // Ignore zero valued collation elements. They don't participate in the
@@ -265,6 +288,28 @@ extern "C" intptr_t _swift_stdlib_unicode_hash_ascii(const char *Str,
   return hashFinish(HashState);
 }
 
+extern "C"
+intptr_t _swift_stdlib_unicode_hash(const uint16_t *Str, int32_t Length) {
+  // UTF-16 strings often contain only ASCII, which doesn't need the
+  // collation iterator.
+  if (isASCII(Str, Length))
+    return hashASCII(Str, Length);
+
+  UErrorCode ErrorCode = U_ZERO_ERROR;
+  intptr_t HashState = HASH_SEED;
+  HashState = hashChunk(GetRootCollator(), HashState, Str, Length, &ErrorCode);
+
+  if (U_FAILURE(ErrorCode)) {
+    swift::crash("hashChunk: Unexpected error hashing unicode string.");
+  }
+  return hashFinish(HashState);
+}
+
+extern "C" intptr_t _swift_stdlib_unicode_hash_ascii(const char *Str,
+                                                     int32_t Length) {
+  return hashASCII(Str, Length);
+}
+
 /// Convert the unicode string to uppercase. This function will return the
 /// required buffer length as a result. If this length does not match the
 /// 'DestinationCapacity' this function must be called again with a buffer of
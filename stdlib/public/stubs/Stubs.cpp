@@ -28,38 +28,84 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cmath>
 #include <cstring>
 #include <xlocale.h>
 #include <limits>
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MathExtras.h"
 #include "swift/Runtime/Debug.h"
 #include "swift/Basic/Lazy.h"
 
+/// The decimal digits of 0 through 99, two characters each.
+static const char TwoDigits[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/// Writes the decimal digits of \p Value backwards, ending just before
+/// \p End. Returns the position of the first digit.
+static char *writeDecimalBackwards(char *End, uint64_t Value) {
+  char *P = End;
+  // Two digits per division; the divisions by constants compile to
+  // multiplications.
+  while (Value >= 100) {
+    unsigned Index = unsigned(Value % 100) * 2;
+    Value /= 100;
+    *--P = TwoDigits[Index + 1];
+    *--P = TwoDigits[Index];
+  }
+  if (Value >= 10) {
+    unsigned Index = unsigned(Value) * 2;
+    *--P = TwoDigits[Index + 1];
+    *--P = TwoDigits[Index];
+  } else {
+    *--P = '0' + char(Value);
+  }
+  return P;
+}
+
 static uint64_t uint64ToStringImpl(char *Buffer, uint64_t Value,
                                    int64_t Radix, bool Uppercase,
                                    bool Negative) {
-  char *P = Buffer;
-  uint64_t Y = Value;
-
-  if (Y == 0) {
-    *P++ = '0';
-  } else if (Radix == 10) {
-    while (Y) {
-      *P++ = '0' + char(Y % 10);
-      Y /= 10;
-    }
+  // Digits are produced least significant first, into a scratch buffer that
+  // fits the 64 binary digits and sign of the longest result.
+  char Scratch[65];
+  char *End = Scratch + sizeof(Scratch);
+  char *P;
+
+  if (Radix == 10) {
+    P = writeDecimalBackwards(End, Value);
+  } else if ((Radix & (Radix - 1)) == 0) {
+    // Powers of two take a shift and a mask per digit.
+    unsigned Shift = llvm::countTrailingZeros(uint64_t(Radix));
+    uint64_t Mask = uint64_t(Radix) - 1;
+    P = End;
+    do {
+      *--P = llvm::hexdigit(unsigned(Value & Mask), !Uppercase);
+      Value >>= Shift;
+    } while (Value);
   } else {
     unsigned Radix32 = Radix;
-    while (Y) {
-      *P++ = llvm::hexdigit(Y % Radix32, !Uppercase);
-      Y /= Radix32;
-    }
+    P = End;
+    do {
+      *--P = llvm::hexdigit(Value % Radix32, !Uppercase);
+      Value /= Radix32;
+    } while (Value);
   }
 
   if (Negative)
-    *P++ = '-';
-  std::reverse(Buffer, P);
-  return size_t(P - Buffer);
+    *--P = '-';
+  size_t Length = End - P;
+  memcpy(Buffer, P, Length);
+  return Length;
 }
 
 extern "C" uint64_t swift_int64ToString(char *Buffer, size_t BufferLength,
@@ -139,12 +185,52 @@ static int swift_snprintf_l(char *Str, size_t StrSize, locale_t Locale,
 }
 #endif
 
+/// Formats \p Value like "%.*g" with a precision of digits10 followed by
+/// ".0" if \p Value is an integer which "%g" prints without an exponent,
+/// which are most of the values that are printed. Returns 0 for any other
+/// value.
+template <typename T>
+static uint64_t integralFloatingPointToString(char *Buffer, T Value) {
+  // "%g" switches to an exponent at 10^digits10. That bound is below 2^64
+  // for every supported type.
+  static const T Limit = [] {
+    T Limit = 1;
+    for (int i = 0; i < std::numeric_limits<T>::digits10; ++i)
+      Limit *= 10;
+    return Limit;
+  }();
+
+  T Magnitude = std::signbit(Value) ? -Value : Value;
+  // This is false for NaN.
+  if (!(Magnitude < Limit))
+    return 0;
+  uint64_t Integer = uint64_t(Magnitude);
+  if (T(Integer) != Magnitude)
+    return 0;
+
+  char Digits[32];
+  char *End = Digits + sizeof(Digits);
+  char *P = writeDecimalBackwards(End, Integer);
+  // Negative zero is printed as "-0.0".
+  if (std::signbit(Value))
+    *--P = '-';
+  size_t Length = End - P;
+  memcpy(Buffer, P, Length);
+  Buffer[Length++] = '.';
+  Buffer[Length++] = '0';
+  Buffer[Length] = '\0';
+  return Length;
+}
+
 template <typename T>
 static uint64_t swift_floatingPointToString(char *Buffer, size_t BufferLength,
                                             T Value, const char *Format) {
   if (BufferLength < 32)
     swift::crash("swift_floatingPointToString: insufficient buffer size");
 
+  if (uint64_t Length = integralFloatingPointToString(Buffer, Value))
+    return Length;
+
   const int Precision = std::numeric_limits<T>::digits10;
 
   // Pass a null locale to use the C locale.
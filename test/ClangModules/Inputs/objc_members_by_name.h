@@ -0,0 +1,15 @@
+@import Foundation;
+
+@protocol Named
+- (nonnull NSString *)name;
+@end
+
+@interface Widget : NSObject <Named>
+- (void)activate;
+- (void)activateWithPriority:(int)priority;
+@property (nonatomic) int size;
+@end
+
+@interface Widget (Decoration)
+- (void)decorate;
+@end
@@ -0,0 +1,16 @@
+// RUN: %target-swift-frontend -parse -verify %s -import-objc-header %S/Inputs/objc_members_by_name.h -enable-swift-name-lookup-tables
+
+// REQUIRES: objc_interop
+
+import Foundation
+
+func useWidget(w: Widget) {
+  w.activate()
+  w.activateWithPriority(1)
+  w.size = w.size + 1
+  w.decorate()
+  _ = w.name()
+  _ = Widget()
+
+  w.deactivate() // expected-error{{value of type 'Widget' has no member 'deactivate'}}
+}
@@ -0,0 +1,33 @@
+// RUN: %target-parse-verify-swift
+
+// The solutions for a connected component of the constraint graph may be
+// reused when a choice in another part of the system leaves the component
+// unchanged. Make sure that each branch still ends up with the right types.
+
+func f0(_: Float) -> Float {}
+func f0(_: Int) -> Int {}
+
+func g0(_: Int, _: Double) -> Int {}
+func g0(_: Float, _: Double) -> Float {}
+
+func takeInt(_: Int) {}
+func takeFloat(_: Float) {}
+func takeDouble(_: Double) {}
+
+let t0 = (f0(1), 1.5 * 2.0 + 3.0 - 4.0)
+takeInt(t0.0)
+takeDouble(t0.1)
+
+let t1: (Float, Double) = (f0(1), 1.5 * 2.0 + 3.0 - 4.0)
+takeFloat(t1.0)
+
+takeInt(g0(1 + 2 * 3, 1.5 * 2.0 + 3.0))
+takeFloat(g0(1 + 2 * 3, 1.5 * 2.0 + 3.0))
+
+let t2 = (g0(1, 2.0 * 3.0), f0(1) + f0(2) * f0(3), 7 - 8 + 9)
+takeInt(t2.0)
+takeInt(t2.1)
+takeInt(t2.2)
+
+let t3 = (f0(1) + f0(2), "a" + "b" + "c")
+takeDouble(t3.0) // expected-error{{cannot convert value of type 'Int' to expected argument type 'Double'}}
@@ -0,0 +1,4 @@
+public func lengthSquared(p: Point) -> Int {
+  let q = p
+  return q.x * q.x + q.y * q.y
+}
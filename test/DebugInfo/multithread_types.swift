@@ -0,0 +1,17 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %target-swift-frontend %s %S/Inputs/multithread_types_other.swift -emit-ir -g -num-threads 2 -module-name test -o %t/main.ll -o %t/other.ll
+// RUN: cat %t/main.ll %t/other.ll | FileCheck %s
+
+// Only one of the two LLVM modules defines Point. The other one declares it
+// with the same identifier.
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Point",{{.*}} elements: {{.*}}identifier: "_TtV4test5Point")
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Point",{{.*}} flags: DIFlagFwdDecl,{{.*}} identifier: "_TtV4test5Point")
+public struct Point {
+  public var x: Int
+  public var y: Int
+}
+
+public func makePoint() -> Point {
+  let p = Point(x: 1, y: 2)
+  return p
+}
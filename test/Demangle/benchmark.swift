@@ -0,0 +1,7 @@
+; This is not really a Swift source file: -*- Text -*-
+
+RUN: swift-demangle -benchmark-iterations=3 _TtSi _TtSS | FileCheck %s -check-prefix=ARGS
+ARGS: demangled 6 symbols ({{[0-9]+}} characters) in
+
+RUN: echo "_TtSi junk _TtSb" | swift-demangle -benchmark-iterations=2 | FileCheck %s -check-prefix=STDIN
+STDIN: demangled 4 symbols ({{[0-9]+}} characters) in
@@ -9,6 +9,9 @@ RUN: sed -ne '/--->/s/^.*---> *//p' < %S/Inputs/manglings.txt > %t.check
 RUN: swift-demangle < %t.input > %t.output
 RUN: diff %t.check %t.output
 
+RUN: swift-demangle -num-threads=4 < %t.input > %t.threaded.output
+RUN: diff %t.check %t.threaded.output
+
 ; RUN: swift-demangle __TtSi | FileCheck %s -check-prefix=DOUBLE
 ; DOUBLE: _TtSi ---> Swift.Int
 
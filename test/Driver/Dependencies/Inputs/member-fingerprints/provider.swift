@@ -0,0 +1,5 @@
+# Dependencies after compilation:
+provides-nominal: [a]
+provides-member: [[a, ""], [a, foo, "foo1"], [a, bar, "bar2"]]
+interface-hash: "after"
+interface-hash-excluding-members: "same"
@@ -0,0 +1,4 @@
+# Dependencies after compilation:
+depends-nominal: [a]
+depends-member: [[a, bar]]
+interface-hash: "same"
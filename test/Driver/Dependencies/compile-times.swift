@@ -0,0 +1,32 @@
+// main | other
+
+// RUN: rm -rf %t && cp -r %S/Inputs/independent/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+// RUN: FileCheck -check-prefix=CHECK-RECORD %s < %t/main~buildrecord.swiftdeps
+
+// CHECK-FIRST-NOT: warning
+// CHECK-FIRST: Handled main.swift
+// CHECK-FIRST: Handled other.swift
+
+// CHECK-RECORD: inputs:
+// CHECK-RECORD: compile_times:
+// CHECK-RECORD-NEXT: "./main.swift": [{{[0-9]+}}, {{[0-9]+}}]
+// CHECK-RECORD-NEXT: "./other.swift": [{{[0-9]+}}, {{[0-9]+}}]
+
+// RUN: echo '{version: "'$(%swiftc_driver_plain -version | head -n1)'", inputs: {"./main.swift": !dirty [443865900, 0], "./other.swift": !dirty [443865900, 0]}, compile_times: {"./main.swift": [1, 0], "./other.swift": [5, 0]}, build_time: [443865901, 0]}' > %t/main~buildrecord.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j2 -v 2>&1 | FileCheck -check-prefix=CHECK-OTHER-FIRST %s
+
+// CHECK-OTHER-FIRST: -primary-file ./other.swift
+// CHECK-OTHER-FIRST: -primary-file ./main.swift
+
+// RUN: echo '{version: "'$(%swiftc_driver_plain -version | head -n1)'", inputs: {"./main.swift": !dirty [443865900, 0], "./other.swift": !dirty [443865900, 0]}, compile_times: {"./main.swift": [5, 0], "./other.swift": [1, 0]}, build_time: [443865901, 0]}' > %t/main~buildrecord.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j2 -v 2>&1 | FileCheck -check-prefix=CHECK-MAIN-FIRST %s
+
+// CHECK-MAIN-FIRST: -primary-file ./main.swift
+// CHECK-MAIN-FIRST: -primary-file ./other.swift
+
+// With only one job at a time, inputs are compiled in order.
+// RUN: echo '{version: "'$(%swiftc_driver_plain -version | head -n1)'", inputs: {"./main.swift": !dirty [443865900, 0], "./other.swift": !dirty [443865900, 0]}, compile_times: {"./main.swift": [1, 0], "./other.swift": [5, 0]}, build_time: [443865901, 0]}' > %t/main~buildrecord.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-MAIN-FIRST %s
@@ -0,0 +1,42 @@
+// main | other
+
+// RUN: rm -rf %t && cp -r %S/Inputs/independent/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-incremental-file-hashing ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+// RUN: FileCheck -check-prefix=CHECK-RECORD %s < %t/main~buildrecord.swiftdeps
+
+// CHECK-FIRST-NOT: warning
+// CHECK-FIRST: Handled main.swift
+// CHECK-FIRST: Handled other.swift
+
+// CHECK-RECORD: content_hashes:
+// CHECK-RECORD-NEXT: "./main.swift": "{{[0-9A-F]+}}"
+// CHECK-RECORD-NEXT: "./other.swift": "{{[0-9A-F]+}}"
+
+// Touching a file without changing it doesn't cause a rebuild.
+// RUN: touch -t 201401240006 %t/main.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-incremental-file-hashing ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-NONE %s
+
+// CHECK-NONE-NOT: Handled
+
+// The new modification time is recorded, so nothing needs to be hashed or
+// rebuilt next time.
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-incremental-file-hashing ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-NONE %s
+
+// Without hashing, the touched file is rebuilt as usual.
+// RUN: touch -t 201401240007 %t/main.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-MAIN %s
+
+// CHECK-MAIN-NOT: Handled other.swift
+// CHECK-MAIN: Handled main.swift
+// CHECK-MAIN-NOT: Handled other.swift
+
+// Turning hashing back on doesn't rebuild anything, but records the hashes.
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-incremental-file-hashing ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-NONE %s
+// RUN: FileCheck -check-prefix=CHECK-RECORD %s < %t/main~buildrecord.swiftdeps
+
+// Changing the contents of a file causes a rebuild.
+// RUN: echo "# changed" >> %t/main.swift
+// RUN: touch -t 201401240008 %t/main.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental -enable-incremental-file-hashing ./main.swift ./other.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-MAIN %s
@@ -0,0 +1,32 @@
+/// provider ==> uses-foo, uses-bar | provider +==> uses-bar (only "bar" changes)
+
+// RUN: rm -rf %t && cp -r %S/Inputs/member-fingerprints/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// Generate the build record...
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./provider.swift ./uses-foo.swift ./uses-bar.swift -module-name main -j1 -v
+
+// ...then reset the .swiftdeps files.
+// RUN: cp -r %S/Inputs/member-fingerprints/*.swiftdeps %t
+
+// RUN: touch -t 201401240006 %t/provider.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./provider.swift ./uses-foo.swift ./uses-bar.swift -module-name main -j1 -v > %t/output.txt 2>&1
+// RUN: FileCheck -check-prefix=CHECK-MEMBER-CHANGE %s < %t/output.txt
+// RUN: FileCheck -check-prefix=NEGATIVE-MEMBER-CHANGE %s < %t/output.txt
+
+// CHECK-MEMBER-CHANGE: Handled provider.swift
+// CHECK-MEMBER-CHANGE: Handled uses-bar.swift
+// NEGATIVE-MEMBER-CHANGE-NOT: Handled uses-foo.swift
+
+
+// If anything besides the fingerprinted members changes, every dependent
+// has to be rebuilt.
+// RUN: cp -r %S/Inputs/member-fingerprints/*.swiftdeps %t
+// RUN: sed -E -e 's/"same"/"different"/' -i.prev %t/provider.swiftdeps
+
+// RUN: touch -t 201401240007 %t/provider.swift
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./provider.swift ./uses-foo.swift ./uses-bar.swift -module-name main -j1 -v 2>&1 | FileCheck -check-prefix=CHECK-STRUCTURE-CHANGE %s
+
+// CHECK-STRUCTURE-CHANGE: Handled provider.swift
+// CHECK-STRUCTURE-CHANGE-DAG: Handled uses-foo.swift
+// CHECK-STRUCTURE-CHANGE-DAG: Handled uses-bar.swift
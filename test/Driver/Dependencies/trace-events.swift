@@ -0,0 +1,24 @@
+// main | other
+
+// RUN: rm -rf %t && cp -r %S/Inputs/independent/ %t
+// RUN: touch -t 201401240005 %t/*
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j2 -driver-trace-events-path %t/build.trace -driver-print-jobs 2>&1 | FileCheck -check-prefix=CHECK-JOBS %s
+
+// CHECK-JOBS: -primary-file ./main.swift
+// CHECK-JOBS-SAME: -trace-events-path {{[^ ]*}}main{{[^ ]*}}.trace
+// CHECK-JOBS: -primary-file ./other.swift
+// CHECK-JOBS-SAME: -trace-events-path {{[^ ]*}}other{{[^ ]*}}.trace
+
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j2 -driver-trace-events-path %t/build.trace 2>&1 | FileCheck -check-prefix=CHECK-BUILD %s
+// RUN: FileCheck -check-prefix=CHECK-TRACE %s < %t/build.trace
+
+// CHECK-BUILD-NOT: warning
+// CHECK-BUILD: Handled {{main|other}}.swift
+
+// CHECK-TRACE: {"name":"Load dependencies and schedule jobs","cat":"driver","ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":0,"tid":0}
+// CHECK-TRACE-DAG: {"name":"wait for compile main.swift","cat":"job","ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":1,
+// CHECK-TRACE-DAG: {"name":"wait for compile other.swift","cat":"job","ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":1,
+// CHECK-TRACE-DAG: {"name":"compile main.swift","cat":"job","ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":0,"tid":{{[12]}}}
+// CHECK-TRACE-DAG: {"name":"compile other.swift","cat":"job","ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":0,"tid":{{[12]}}}
+// CHECK-TRACE-DAG: {"name":"handle output of compile main.swift","cat":"driver"
@@ -0,0 +1,4 @@
+import Foo
+import Qux
+
+func otherFunction() {}
@@ -0,0 +1,34 @@
+// RUN: %swiftc_driver -driver-skip-execution -v -enable-batch-mode -module-name ThisModule -c %S/Inputs/main.swift %S/Inputs/lib.swift %s 2>&1 | FileCheck -check-prefix=ONE-BATCH %s
+// RUN: %swiftc_driver -driver-skip-execution -v -enable-batch-mode -j 2 -module-name ThisModule -c %S/Inputs/main.swift %S/Inputs/lib.swift %s 2>&1 | FileCheck -check-prefix=TWO-BATCHES %s
+// RUN: %swiftc_driver -driver-skip-execution -v -module-name ThisModule -c %S/Inputs/main.swift %S/Inputs/lib.swift %s 2>&1 | FileCheck -check-prefix=NO-BATCH %s
+// RUN: %swiftc_driver -driver-skip-execution -v -enable-batch-mode -serialize-diagnostics -module-name ThisModule -c %S/Inputs/main.swift %S/Inputs/lib.swift %s 2>&1 | FileCheck -check-prefix=NO-BATCH %s
+
+// RUN: %target-swift-frontend -c -module-name ThisModule -primary-file %S/Inputs/main.swift -primary-file %S/Inputs/lib.swift %s -o %t.main.o -o %t.lib.o
+// RUN: not %target-swift-frontend -c -module-name ThisModule -primary-file %S/Inputs/main.swift -primary-file %S/Inputs/lib.swift %s -o %t.main.o 2>&1 | FileCheck -check-prefix=OUTPUT-COUNT %s
+// RUN: not %target-swift-frontend -dump-ast -module-name ThisModule -primary-file %S/Inputs/main.swift -primary-file %S/Inputs/lib.swift %s 2>&1 | FileCheck -check-prefix=BAD-MODE %s
+
+// ONE-BATCH: bin/swift
+// ONE-BATCH-SAME: -primary-file {{[^ ]*}}/Inputs/main.swift -primary-file {{[^ ]*}}/Inputs/lib.swift -primary-file {{[^ ]*}}/batch_mode.swift
+// ONE-BATCH-SAME: -o {{[^ ]*}}main{{[^ ]*}}.o -o {{[^ ]*}}lib{{[^ ]*}}.o -o {{[^ ]*}}batch_mode{{[^ ]*}}.o
+// ONE-BATCH-NOT: -primary-file
+
+// TWO-BATCHES: bin/swift
+// TWO-BATCHES-SAME: -primary-file {{[^ ]*}}/Inputs/main.swift {{[^ ]*}}/Inputs/lib.swift
+// TWO-BATCHES: bin/swift
+// TWO-BATCHES-SAME: -primary-file {{[^ ]*}}/Inputs/lib.swift -primary-file {{[^ ]*}}/batch_mode.swift
+
+// NO-BATCH-NOT: -primary-file {{[^ ]*}} -primary-file
+// NO-BATCH: -primary-file {{[^ ]*}}/Inputs/main.swift
+// NO-BATCH-NOT: -primary-file {{[^ ]*}} -primary-file
+// NO-BATCH: -primary-file {{[^ ]*}}/Inputs/lib.swift
+// NO-BATCH-NOT: -primary-file {{[^ ]*}} -primary-file
+// NO-BATCH: -primary-file {{[^ ]*}}/batch_mode.swift
+// NO-BATCH-NOT: -primary-file {{[^ ]*}} -primary-file
+
+// OUTPUT-COUNT: error: -o was specified 1 times for 3 primary files; batch mode requires one per primary file
+
+// BAD-MODE: error: this mode does not support multiple primary files
+
+func libraryFunctionUser() {
+  print("batch mode")
+}
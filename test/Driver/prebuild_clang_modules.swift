@@ -0,0 +1,24 @@
+// RUN: %swiftc_driver -driver-print-jobs -prebuild-clang-modules -module-name ThisModule -c %S/Inputs/prebuild_clang_modules_other.swift %s 2>&1 | FileCheck -check-prefix=ONE-JOB %s
+// RUN: %swiftc_driver -driver-print-jobs -prebuild-clang-modules -j 2 -module-name ThisModule -c %S/Inputs/prebuild_clang_modules_other.swift %s 2>&1 | FileCheck -check-prefix=TWO-JOBS %s
+// RUN: %swiftc_driver -driver-print-jobs -prebuild-clang-modules -module-name ThisModule -c %s 2>&1 | FileCheck -check-prefix=NO-PREBUILD %s
+// RUN: %swiftc_driver -driver-print-jobs -module-name ThisModule -c %S/Inputs/prebuild_clang_modules_other.swift %s 2>&1 | FileCheck -check-prefix=NO-PREBUILD %s
+
+// ONE-JOB: bin/swift -frontend -load-imported-modules
+// ONE-JOB-SAME: -import-module Foo -import-module Qux -import-module Bar -import-module Baz -module-name ThisModule
+// ONE-JOB-NOT: -load-imported-modules
+// ONE-JOB: bin/swift -frontend -c
+
+// TWO-JOBS: bin/swift -frontend -load-imported-modules
+// TWO-JOBS-SAME: -import-module Foo -import-module Bar -module-name ThisModule
+// TWO-JOBS-NEXT: bin/swift -frontend -load-imported-modules
+// TWO-JOBS-SAME: -import-module Qux -import-module Baz -module-name ThisModule
+// TWO-JOBS-NOT: -load-imported-modules
+
+// NO-PREBUILD-NOT: -load-imported-modules
+
+// RUN: %target-swift-frontend -load-imported-modules -import-module Swift
+
+import Foo
+@testable import Bar.Sub
+import struct Baz.Thing
+import ThisModule
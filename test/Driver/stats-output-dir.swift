@@ -0,0 +1,4 @@
+// RUN: %swiftc_driver -driver-print-jobs -c %s -module-name main -stats-output-dir %t/stats 2>&1 | FileCheck %s
+
+// CHECK: -frontend -c
+// CHECK-SAME: -stats-output-dir {{[^ ]*}}stats
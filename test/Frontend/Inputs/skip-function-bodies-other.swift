@@ -0,0 +1,14 @@
+func helper() -> Int {
+  // This body is never parsed when it's skipped.
+  let = 
+  return 0
+}
+
+struct Helper {
+  var value: Int {
+    get { return + }
+    set { let = }
+  }
+
+  func method() { var : }
+}
@@ -0,0 +1,56 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -c -O %s -o %t/main.o -module-name main -code-size-report-path %t/report.json
+// RUN: FileCheck %s < %t/report.json
+// RUN: FileCheck -check-prefix=CHECK-WITNESS %s < %t/report.json
+// RUN: FileCheck -check-prefix=CHECK-ORIGINS %s < %t/report.json
+// RUN: %target-swift-frontend -emit-sil -O %s -o /dev/null -module-name main -code-size-report-path %t/sil.json
+// RUN: FileCheck -check-prefix=CHECK-SIL %s < %t/sil.json
+
+// CHECK: "object_file": "{{.*}}main.o",
+// CHECK: "kinds": {
+// CHECK-DAG: "generic_specialization": {
+// CHECK-DAG: "witness_thunk": {
+// CHECK-DAG: "irgen": {
+// CHECK: "functions": [
+// CHECK: "name": "_TTSg{{.*}}identity
+// CHECK-NEXT: "kind": "generic_specialization",
+// CHECK-NEXT: "origin": "main.identity(_:)",
+// CHECK-NEXT: "location": "{{.*}}code-size-report.swift:[[@LINE+25]]:{{[0-9]+}}",
+// CHECK-NEXT: "sil_instructions": {{[1-9][0-9]*}},
+// CHECK-NEXT: "machine_code_size": {{[1-9][0-9]*}},
+
+// CHECK-WITNESS: "kind": "witness_thunk",
+// CHECK-WITNESS-NEXT: "origin": "main.Counter.count()",
+
+// CHECK-ORIGINS: "origins": [
+// CHECK-ORIGINS: "origin": "main.identity(_:)",
+// CHECK-ORIGINS-NEXT: "location": "{{.*}}code-size-report.swift:[[@LINE+16]]:{{[0-9]+}}",
+// CHECK-ORIGINS-NEXT: "functions": {{[1-9][0-9]*}},
+
+// CHECK-SIL: "object_file": "",
+// CHECK-SIL: "generic_specialization": {
+// CHECK-SIL-NEXT: "functions": 1,
+// CHECK-SIL-NEXT: "sil_instructions": {{[1-9][0-9]*}},
+// CHECK-SIL-NEXT: "machine_code_size": 0
+
+protocol Countable {
+  func count() -> Int
+}
+
+// Keep the declarations below together; the checks above refer to their
+// lines.
+@inline(never)
+func identity<T>(x: T) -> T {
+  return x
+}
+
+struct Counter : Countable {
+  func count() -> Int {
+    return identity(42)
+  }
+}
+
+public func useCountable() -> Int {
+  let values: [Countable] = [Counter()]
+  return values[0].count()
+}
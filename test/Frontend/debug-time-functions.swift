@@ -0,0 +1,24 @@
+// RUN: %target-swift-frontend -c -O %s -o %t.o -debug-time-functions 2>&1 | FileCheck %s
+// RUN: %target-swift-frontend -c %s -o %t.o -debug-time-functions -debug-time-functions-limit 0 2>&1 | FileCheck -check-prefix=CHECK-LIMIT %s
+// RUN: not %target-swift-frontend -parse %s -debug-time-functions-limit many 2>&1 | FileCheck -check-prefix=CHECK-ERROR %s
+
+// CHECK: ===- Compile time per function (ms) -===
+// CHECK-NEXT: total sema silgen silopt irgen llvm function
+// CHECK-DAG: {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{.*}}debug-time-functions.swift:[[@LINE+11]]:13 timed(_:)
+// CHECK-DAG: {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{[0-9.]+}} {{.*}}debug-time-functions.swift:[[@LINE+15]]:21 (closure)
+// CHECK-DAG: SIL passes:
+
+// CHECK-LIMIT: function
+// CHECK-LIMIT-NOT: debug-time-functions.swift:
+
+// CHECK-ERROR: error: invalid value 'many' in '-debug-time-functions-limit many'
+
+// Keep the functions below at the end of the file; the checks above refer to
+// their lines.
+public func timed(x: Int) -> Int {
+  return x * 2 + 1
+}
+
+public func takesClosure(values: [Int]) -> [Int] {
+  return values.map { $0 + 1 }
+}
@@ -0,0 +1,16 @@
+// Function bodies in files other than the primary file are only parsed if
+// something needs them, so the errors in them aren't diagnosed here.
+// RUN: %target-swift-frontend -parse -primary-file %s %S/Inputs/skip-function-bodies-other.swift
+
+// RUN: not %target-swift-frontend -parse -primary-file %s %S/Inputs/skip-function-bodies-other.swift -disable-delayed-non-primary-function-bodies 2>&1 | FileCheck -check-prefix=PARSED %s
+
+// Without -primary-file, every file is compiled, so nothing is delayed.
+// RUN: not %target-swift-frontend -parse %s %S/Inputs/skip-function-bodies-other.swift 2>&1 | FileCheck -check-prefix=PARSED %s
+
+// PARSED: skip-function-bodies-other.swift:3:{{[0-9]+}}: error:
+
+// The signatures in the other file are still available.
+let x: Int = helper()
+var h = Helper()
+h.value = Helper().value
+h.method()
@@ -0,0 +1,26 @@
+// RUN: %target-swift-frontend -parse -print-ast-stats %s 2>&1 | FileCheck %s
+
+// CHECK-LABEL: *** AST Statistics:
+// CHECK:      Decls: {{[0-9]+}} nodes, {{[0-9]+}} bytes
+// CHECK-DAG:    {{[0-9]+}} x {{ *[0-9]+}} = {{ *[0-9]+}} bytes  StructDecl
+// CHECK-DAG:    {{[0-9]+}} x {{ *[0-9]+}} = {{ *[0-9]+}} bytes  FuncDecl
+// CHECK:      Exprs: {{[0-9]+}} nodes, {{[0-9]+}} bytes
+// CHECK:        {{[0-9]+}} x {{ *[0-9]+}} = {{ *[0-9]+}} bytes  IntegerLiteralExpr
+// CHECK:      Types: {{[0-9]+}} nodes, {{[0-9]+}} bytes
+// CHECK:      TypeReprs: {{[0-9]+}} nodes, {{[0-9]+}} bytes
+// CHECK:        {{[0-9]+}} x {{ *[0-9]+}} = {{ *[0-9]+}} bytes  SimpleIdentTypeRepr
+// CHECK:      Type bytes, including trailing storage: {{[0-9]+}} permanent, {{[0-9]+}} constraint solver
+// CHECK-NEXT: Permanent arena: {{[0-9]+}} bytes, {{[0-9]+}} bytes allocated
+// CHECK-NEXT: Peak constraint solver arena: {{[1-9][0-9]*}} bytes, {{[0-9]+}} interned types
+// CHECK-NEXT: Total memory: {{[0-9]+}} bytes
+// CHECK-NEXT: Identifiers: {{[1-9][0-9]*}}
+// CHECK-NEXT: Interned types: {{[1-9][0-9]*}}
+
+struct Point {
+  var x: Int
+  var y: Int
+}
+
+func origin() -> Point {
+  return Point(x: 0, y: 0)
+}
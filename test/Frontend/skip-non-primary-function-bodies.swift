@@ -0,0 +1,13 @@
+// RUN: not %target-swift-frontend -parse -primary-file %s %S/Inputs/skip-function-bodies-other.swift -disable-delayed-non-primary-function-bodies 2>&1 | FileCheck -check-prefix=PARSED %s
+// RUN: %target-swift-frontend -parse -primary-file %s %S/Inputs/skip-function-bodies-other.swift -skip-non-primary-function-bodies
+
+// Without -primary-file, every file is compiled, so nothing is skipped.
+// RUN: not %target-swift-frontend -parse %s %S/Inputs/skip-function-bodies-other.swift -skip-non-primary-function-bodies -disable-delayed-non-primary-function-bodies 2>&1 | FileCheck -check-prefix=PARSED %s
+
+// PARSED: skip-function-bodies-other.swift:3:{{[0-9]+}}: error:
+
+// The signatures in the other file are still available.
+let x: Int = helper()
+var h = Helper()
+h.value = Helper().value
+h.method()
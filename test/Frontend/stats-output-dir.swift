@@ -0,0 +1,30 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -c -primary-file %s -o %t/main.o -module-name main -stats-output-dir %t/stats
+// RUN: cat %t/stats/frontend-main-stats-output-dir.swift-*.json | FileCheck %s
+// RUN: %S/../../utils/process-stats-dir.py --json %t/stats | FileCheck -check-prefix=CHECK-SUMMARY %s
+
+// CHECK: "kind": "frontend",
+// CHECK: "name": "main-stats-output-dir.swift",
+// CHECK: "wall_time": {{[0-9]+}},
+// CHECK: "max_rss": {{[1-9][0-9]*}},
+// CHECK: "phases": {
+// CHECK-DAG: "Parse": {{[0-9]+}}
+// CHECK-DAG: "Type-check": {{[0-9]+}}
+// CHECK-DAG: "SILGen": {{[0-9]+}}
+// CHECK-DAG: "SIL optimization": {{[0-9]+}}
+// CHECK-DAG: "IRGen": {{[0-9]+}}
+// CHECK-DAG: "LLVM": {{[0-9]+}}
+// CHECK: "counters": {
+// CHECK-DAG: "sil.functions": {{[1-9][0-9]*}}
+// CHECK-DAG: "sil.instructions": {{[1-9][0-9]*}}
+// CHECK-DAG: "llvm.functions": {{[1-9][0-9]*}}
+// CHECK-DAG: "llvm.instructions": {{[1-9][0-9]*}}
+// CHECK-DAG: "ast.decls": {{[1-9][0-9]*}}
+// CHECK-DAG: "ast.exprs": {{[1-9][0-9]*}}
+
+// CHECK-SUMMARY: "frontend": {
+// CHECK-SUMMARY: "jobs": 1,
+
+func counted() -> Int {
+  return 42
+}
@@ -0,0 +1,19 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -c %s -o %t/main.o -trace-events-path %t/main.trace
+// RUN: FileCheck %s < %t/main.trace
+
+// RUN: not %target-swift-frontend -parse %s -trace-events-path %t/missing/main.trace 2>&1 | FileCheck -check-prefix=CHECK-ERROR %s
+
+// CHECK: [{"name":"Parse","cat":"frontend","ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":0,"tid":0}
+// CHECK-SAME: {"name":"Type-check"
+// CHECK-SAME: {"name":"SILGen"
+// CHECK-SAME: {"name":"SIL diagnostic passes"
+// CHECK-SAME: {"name":"SIL optimization"
+// CHECK-SAME: {"name":"LLVM"
+// CHECK-SAME: {"name":"IRGen"
+
+// CHECK-ERROR: error: cannot open file '{{.*}}missing/main.trace'
+
+func traced() -> Int {
+  return 42
+}
@@ -0,0 +1,7 @@
+func otherFileValue() -> Int {
+  return privateValue() + 1
+}
+
+private func privateValue() -> Int {
+  return 41
+}
@@ -0,0 +1,22 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -c -incremental-codegen %s -o %t/main.o
+// RUN: test -f %t/main.o.irhash
+
+// An object file generated from the same IR is kept as it is.
+// RUN: echo "reused object file" > %t/main.o
+// RUN: %target-swift-frontend -c -incremental-codegen %s -o %t/main.o
+// RUN: FileCheck -check-prefix=REUSED %s < %t/main.o
+// REUSED: reused object file
+
+// A change in the IR generates the object file again.
+// RUN: %target-swift-frontend -c -incremental-codegen %s -o %t/main.o -module-name other
+// RUN: not grep "reused object file" %t/main.o
+
+// Without the option the object file is always generated.
+// RUN: echo "reused object file" > %t/main.o
+// RUN: %target-swift-frontend -c %s -o %t/main.o -module-name other
+// RUN: not grep "reused object file" %t/main.o
+
+public func foo() -> Int {
+  return 27
+}
@@ -0,0 +1,19 @@
+// RUN: %target-swift-frontend -O -internalize -emit-ir %s | FileCheck %s
+// RUN: %target-swift-frontend -O -internalize -emit-ir %s | FileCheck -check-prefix=UNUSED %s
+// RUN: %target-swift-frontend -O -emit-ir %s | FileCheck -check-prefix=NOINTERNALIZE %s
+
+// Unused public functions of an executable are removed.
+
+// UNUSED-NOT: @_TF11internalize6unusedFT_T_
+// NOINTERNALIZE: define {{.*}}void @_TF11internalize6unusedFT_T_()
+public func unused() {
+}
+
+// Functions with an explicit symbol name are kept.
+
+// CHECK: define {{.*}}void @keepMe()
+@_silgen_name("keepMe")
+public func keepMe() {
+}
+
+print("hello")
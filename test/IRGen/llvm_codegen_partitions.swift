@@ -0,0 +1,25 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-build-swift -Xfrontend -llvm-codegen-partitions -Xfrontend 3 %s %S/Inputs/llvm_codegen_partitions_other.swift -o %t/a.out
+// RUN: %target-run %t/a.out | FileCheck %s
+// RUN: %target-build-swift -O -Xfrontend -llvm-codegen-partitions -Xfrontend 3 %s %S/Inputs/llvm_codegen_partitions_other.swift -o %t/a.out
+// RUN: %target-run %t/a.out | FileCheck %s
+// REQUIRES: executable_test
+
+// Functions of different partitions, and internal functions of other files,
+// still reference each other after the partitions are merged.
+
+struct Counter {
+  var value = 0
+  mutating func bump() { value += otherFileValue() }
+}
+
+private func makeCounter() -> Counter {
+  return Counter()
+}
+
+var c = makeCounter()
+c.bump()
+// CHECK: 42
+print(c.value)
+// CHECK: done
+print("done")
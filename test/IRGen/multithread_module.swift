@@ -7,6 +7,10 @@
 // RUN: %target-swift-frontend -c %S/Inputs/multithread_module/main.swift -o %t/main.o %s -o %t/mt_module.o -num-threads 2 -O -g -module-name test
 // RUN: %target-build-swift %t/main.o %t/mt_module.o -o %t/a.out
 // RUN: %target-run %t/a.out | FileCheck %s
+
+// RUN: %target-swift-frontend -c %S/Inputs/multithread_module/main.swift -o %t/main.o %s -o %t/mt_module.o -num-threads 2 -balance-irgen-partitions -O -g -module-name test
+// RUN: %target-build-swift %t/main.o %t/mt_module.o -o %t/a2.out
+// RUN: %target-run %t/a2.out | FileCheck %s
 // REQUIRES: executable_test
 
 
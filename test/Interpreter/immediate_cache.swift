@@ -0,0 +1,13 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-jit-run -immediate-cache-path %t/cache %s | FileCheck %s
+// RUN: ls %t/cache | FileCheck -check-prefix=CACHE %s
+// RUN: %target-jit-run -immediate-cache-path %t/cache %s | FileCheck %s
+// RUN: ls %t/cache | FileCheck -check-prefix=CACHE %s
+// REQUIRES: swift_interpreter
+
+// The second run reuses the object of the first.
+// CACHE: {{^[0-9a-f]+}}.o
+// CACHE-NOT: .o
+
+// CHECK: Hello from the cache
+print("Hello from the cache")
@@ -0,0 +1,97 @@
+// RUN: %target-run-simple-swift | FileCheck %s
+// REQUIRES: executable_test
+
+// Casts of the same (source type, target type) pair are resolved once and
+// then replayed from the runtime's cast cache. Make sure the replayed casts
+// behave like the first one.
+
+protocol Named {
+  var name: String { get }
+}
+
+protocol Unrelated {}
+
+struct Person : Named {
+  var name: String
+}
+
+struct Point {
+  var x, y: Int
+}
+
+enum Shape : Named {
+  case Circle, Square
+
+  var name: String {
+    switch self {
+    case .Circle: return "circle"
+    case .Square: return "square"
+    }
+  }
+}
+
+enum Failure : ErrorType {
+  case Bad(Int)
+}
+
+func castToNamed<T>(x: T) -> Named? {
+  return x as? Named
+}
+
+func castToUnrelated<T>(x: T) -> Unrelated? {
+  return x as? Unrelated
+}
+
+func castToAnyObject<T>(x: T) -> AnyObject? {
+  return x as? AnyObject
+}
+
+func castToErrorType<T>(x: T) -> ErrorType? {
+  return x as? ErrorType
+}
+
+for i in 0..<3 {
+  // CHECK: alice
+  // CHECK: alice
+  // CHECK: alice
+  print(castToNamed(Person(name: "alice"))!.name)
+}
+
+for shape in [Shape.Circle, Shape.Square, Shape.Circle] {
+  // CHECK: circle
+  // CHECK: square
+  // CHECK: circle
+  print(castToNamed(shape)!.name)
+}
+
+for i in 0..<3 {
+  // CHECK: nil nil nil
+  // CHECK: nil nil nil
+  // CHECK: nil nil nil
+  print(castToNamed(Point(x: i, y: i)) == nil ? "nil" : "value",
+        castToUnrelated(Person(name: "bob")) == nil ? "nil" : "value",
+        castToAnyObject(Point(x: i, y: i)) == nil ? "nil" : "value")
+}
+
+for i in 0..<3 {
+  // CHECK: Bad(0)
+  // CHECK: Bad(1)
+  // CHECK: Bad(2)
+  if case Failure.Bad(let code)? = castToErrorType(Failure.Bad(i)) {
+    print("Bad(\(code))")
+  }
+}
+
+// Casting through an existential reaches the concrete cast of the payload.
+let values: [Any] = [Person(name: "carol"), Point(x: 1, y: 2),
+                     Person(name: "dave")]
+for value in values {
+  // CHECK: carol
+  // CHECK: not named
+  // CHECK: dave
+  if let named = value as? Named {
+    print(named.name)
+  } else {
+    print("not named")
+  }
+}
@@ -572,6 +572,63 @@ bb3:
   ret %swift.bridge* %A
 }
 
+; CHECK-LABEL: define %swift.refcounted* @swift_contractRetainReleaseNStraightLine(%swift.refcounted* %A) {
+; CHECK: entry:
+; CHECK-NEXT: tail call void @swift_retain_n(%swift.refcounted* %A, i32 2)
+; CHECK-NEXT: call void @noread_user(%swift.refcounted* %A)
+; CHECK-NEXT: br label %bb1
+; CHECK: bb1:
+; CHECK-NEXT: call void @noread_user(%swift.refcounted* %A)
+; CHECK-NEXT: br label %bb2
+; CHECK: bb2:
+; CHECK-NEXT: call void @user(%swift.refcounted* %A)
+; CHECK-NEXT: call void @noread_user(%swift.refcounted* %A)
+; CHECK-NEXT: br label %bb3
+; CHECK: bb3:
+; CHECK-NEXT: tail call void @swift_release_n(%swift.refcounted* %A, i32 2)
+; CHECK-NEXT: ret %swift.refcounted* %A
+define %swift.refcounted* @swift_contractRetainReleaseNStraightLine(%swift.refcounted* %A) {
+entry:
+  tail call void @swift_retain(%swift.refcounted* %A)
+  call void @noread_user(%swift.refcounted* %A)
+  br label %bb1
+
+bb1:
+  tail call void @swift_retain(%swift.refcounted* %A)
+  call void @noread_user(%swift.refcounted* %A)
+  br label %bb2
+
+bb2:
+  call void @user(%swift.refcounted* %A)
+  tail call void @swift_release(%swift.refcounted* %A)
+  call void @noread_user(%swift.refcounted* %A)
+  br label %bb3
+
+bb3:
+  tail call void @swift_release(%swift.refcounted* %A)
+  ret %swift.refcounted* %A
+}
+
+; CHECK-LABEL: define %swift.refcounted* @swift_contractRetainNNotAcrossMerge(%swift.refcounted* %A) {
+; CHECK: bb1:
+; CHECK-NEXT: tail call void @swift_retain(%swift.refcounted* %A)
+; CHECK-NEXT: br label %bb3
+; CHECK: bb3:
+; CHECK-NEXT: tail call void @swift_retain(%swift.refcounted* %A)
+; CHECK-NEXT: ret %swift.refcounted* %A
+define %swift.refcounted* @swift_contractRetainNNotAcrossMerge(%swift.refcounted* %A) {
+entry:
+  br i1 undef, label %bb1, label %bb3
+
+bb1:
+  tail call void @swift_retain(%swift.refcounted* %A)
+  br label %bb3
+
+bb3:
+  tail call void @swift_retain(%swift.refcounted* %A)
+  ret %swift.refcounted* %A
+}
+
 !llvm.dbg.cu = !{!1}
 !llvm.module.flags = !{!4}
 
@@ -0,0 +1,15 @@
+// RUN: %target-swift-frontend -parse -debug-time-expression-type-checking %s 2>&1 | FileCheck %s
+// RUN: %target-swift-frontend -parse -solver-expression-time-threshold 60 %s 2>&1 | FileCheck -check-prefix=NO-TIMING %s
+// RUN: not %target-swift-frontend -parse -solver-expression-time-threshold soon %s 2>&1 | FileCheck -check-prefix=INVALID %s
+
+// CHECK-DAG: {{[0-9]+\.[0-9]+}}ms{{.*}}debug_time_expression_type_checking.swift:[[@LINE+1]]:{{[0-9]+}}	{{[0-9]+}} states	{{[0-9]+}} disjunctions	{{[0-9]+}} bytes
+var x = [1, 2, 3, 4.5]
+
+func f(a: Int) -> Int {
+  // CHECK-DAG: debug_time_expression_type_checking.swift:[[@LINE+1]]:{{[0-9]+}}	{{[0-9]+}} states
+  return a * 2 + 1
+}
+
+// NO-TIMING-NOT: states
+
+// INVALID: error: invalid value 'soon' in '-solver-expression-time-threshold soon'
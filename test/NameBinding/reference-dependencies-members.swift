@@ -55,8 +55,8 @@ extension OtherClass : SomeProto {}
 // DEPENDS-NOMINAL-DAG: 11OtherStruct"
 extension OtherStruct {
   // PROVIDES-MEMBER-DAG: - ["{{.+}}11OtherStruct", ""]
-  // PROVIDES-MEMBER-DAG: - ["{{.+}}11OtherStruct", "foo"]
-  // PROVIDES-MEMBER-DAG: - ["{{.+}}11OtherStruct", "bar"]
+  // PROVIDES-MEMBER-DAG: - ["{{.+}}11OtherStruct", "foo", "{{[0-9a-f]+}}"]
+  // PROVIDES-MEMBER-DAG: - ["{{.+}}11OtherStruct", "bar", "{{[0-9a-f]+}}"]
   // PROVIDES-MEMBER-NEGATIVE-NOT: "baz"
   // DEPENDS-MEMBER-DAG: - ["{{.+}}11OtherStruct", "foo"]
   // DEPENDS-MEMBER-DAG: - ["{{.+}}11OtherStruct", "bar"]
@@ -43,9 +43,15 @@
 // CHECK-NEXT: - ["VE4mainSb11InnerToBool", ""]
 // CHECK: - ["V4main9Sentinel1", ""]
 // CHECK-NEXT: - ["V4main9Sentinel2", ""]
-// CHECK: - ["Ps23ArrayLiteralConvertible", "useless"]
-// CHECK-NEXT: - ["Ps23ArrayLiteralConvertible", "useless2"]
+// CHECK: - ["Ps23ArrayLiteralConvertible", "useless", "{{[0-9a-f]+}}"]
+// CHECK-NEXT: - ["Ps23ArrayLiteralConvertible", "useless2", "{{[0-9a-f]+}}"]
 // CHECK-NEXT: - ["Sb", "InnerToBool"]
+// CHECK-NEXT: - ["V4main23TopLevelForMemberLookup", "m1", "{{[0-9a-f]+}}"]
+// CHECK-NEXT: - ["V4main23TopLevelForMemberLookup", "m2", "{{[0-9a-f]+}}"]
+// CHECK-NEXT: - ["V4main23TopLevelForMemberLookup", "m3", "{{[0-9a-f]+}}"]
+// CHECK-NEXT: - ["VV4main5Outer5Inner", "method", "{{[0-9a-f]+}}"]
+// CHECK-NEXT: - ["V4main4Use4", "useTy3", "{{[0-9a-f]+}}"]
+// CHECK-NEXT: - ["V4main28StructForDeclaringProperties", "prop", "{{[0-9a-f]+}}"]
 
 // CHECK-LABEL: {{^depends-top-level:$}}
 
@@ -0,0 +1,10 @@
+public class A {
+  public init() {}
+  public func used() {}
+  public func unused() {}
+}
+
+public class B : A {
+  public override func used() {}
+  public override func unused() {}
+}
@@ -0,0 +1,25 @@
+// RUN: %target-swift-frontend -emit-silgen -enable-guaranteed-normal-arguments %s | FileCheck %s
+
+class C {}
+
+// CHECK-LABEL: sil hidden @_TF{{.*}}3use{{.*}} : $@convention(thin) (@guaranteed C) -> ()
+func use(x: C) {}
+
+// CHECK-LABEL: sil hidden @_TF{{.*}}11useGeneric{{.*}} : $@convention(thin) <T> (@in_guaranteed T) -> ()
+func useGeneric<T>(x: T) {}
+
+class D {
+  var c: C
+
+  // Initializers store their parameters, so they still take them at +1.
+  // CHECK-LABEL: sil hidden @_TFC{{.*}}1DC{{.*}} : $@convention(thin) (@guaranteed C, @thick D.Type) -> @owned D
+  // CHECK-LABEL: sil hidden @_TFC{{.*}}1Dc{{.*}} : $@convention(method) (@owned C, @owned D) -> @owned D
+  init(c: C) {
+    self.c = c
+  }
+
+  // CHECK-LABEL: sil hidden @_TFC{{.*}}1D6method{{.*}} : $@convention(method) (@guaranteed C, @guaranteed D) -> ()
+  func method(x: C) {
+    use(x)
+  }
+}
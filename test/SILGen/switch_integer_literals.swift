@@ -0,0 +1,51 @@
+// RUN: %target-swift-frontend -emit-silgen %s | FileCheck %s
+
+func a() {}
+func b() {}
+func c() {}
+func d() {}
+func e() {}
+
+// A run of integer literal cases is dispatched with a single switch_value.
+// CHECK-LABEL: sil hidden @_TF23switch_integer_literals5test1FSiT_
+func test1(x: Int) {
+  // CHECK: [[VALUE:%.*]] = struct_extract %0 : $Int, #Int._value
+  // CHECK: switch_value [[VALUE]] : $Builtin.Int{{32|64}}, case {{%.*}}: [[BB0:bb[0-9]+]], case {{%.*}}: [[BB1:bb[0-9]+]], case {{%.*}}: [[BB2:bb[0-9]+]], case {{%.*}}: [[BB3:bb[0-9]+]], default [[DEFAULT:bb[0-9]+]]
+  // CHECK-NOT: ~=
+  switch x {
+  case 0: a()
+  case 1: b()
+  case -2: c()
+  case 100, 1: d()
+  default: e()
+  }
+  // CHECK: [[DEFAULT]]:
+  // CHECK: function_ref @_TF23switch_integer_literals1eFT_T_
+}
+
+// Literals are still matched with '~=' when a case has a guard.
+// CHECK-LABEL: sil hidden @_TF23switch_integer_literals5test2FSiT_
+func test2(x: Int) {
+  // CHECK-NOT: switch_value
+  // CHECK: return
+  switch x {
+  case 0: a()
+  case 1 where x > 0: b()
+  case 2: c()
+  case 3: d()
+  default: e()
+  }
+}
+
+// Unsigned types can use the literals which set the top bit.
+// CHECK-LABEL: sil hidden @_TF23switch_integer_literals5test3FVs5UInt8T_
+func test3(x: UInt8) {
+  // CHECK: switch_value {{%.*}} : $Builtin.Int8
+  switch x {
+  case 0: a()
+  case 1: b()
+  case 2: c()
+  case 255: d()
+  default: e()
+  }
+}
@@ -0,0 +1,29 @@
+// RUN: %target-swift-frontend -emit-silgen %s | FileCheck %s
+// RUN: %target-swift-frontend -emit-silgen -print-stats %s -o /dev/null 2>&1 | FileCheck -check-prefix=STATS %s
+// REQUIRES: asserts
+
+// Type lowerings of dependent types are shared by functions with the same
+// generic signature, and kept apart for different signatures.
+
+protocol P {
+  func value() -> Int
+}
+
+// CHECK-LABEL: sil hidden @_TF26type_lowering_generic_cache5first{{.*}} : $@convention(thin) <T> (@out Optional<T>, @in T) -> ()
+func first<T>(x: T) -> T? {
+  return x
+}
+
+// CHECK-LABEL: sil hidden @_TF26type_lowering_generic_cache6second{{.*}} : $@convention(thin) <T> (@out Optional<T>, @in T) -> ()
+func second<T>(x: T) -> T? {
+  return nil
+}
+
+// CHECK-LABEL: sil hidden @_TF26type_lowering_generic_cache11constrained{{.*}} : $@convention(thin) <T where T : P> (@out Optional<T>, @in T) -> ()
+// CHECK: witness_method $T, #P.value!1
+func constrained<T : P>(x: T) -> T? {
+  _ = x.value()
+  return x
+}
+
+// STATS: {{[1-9][0-9]*}} libsil - Number of lowerings of generic types found in the cache
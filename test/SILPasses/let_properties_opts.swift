@@ -170,3 +170,29 @@ public func testStructLet(inout b: Boo) -> Int32 {
 public func testStructPublicLet(b: Boo) -> Int32 {
   return b.Prop0
 }
+
+public struct Boo3 {
+  let Prop1: Int32
+  public init(i:Int32) {
+    Prop1 = 10
+  }
+}
+
+extension Boo3 {
+  public init(i:Int64) {
+    Prop1 = 100
+  }
+}
+
+// Check that Boo3.Prop1 is not constant-folded, because the initializer in
+// the extension initializes it differently.
+
+// CHECK-LABEL: sil @{{.*}}testStructLetWithExtensionInit{{.*}} : $@convention(thin) (Boo3) -> Int32
+// CHECK: struct_extract %0 : $Boo3, #Boo3.Prop1
+// CHECK: return
+// CHECK-WMO-LABEL: sil @{{.*}}testStructLetWithExtensionInit{{.*}} : $@convention(thin) (Boo3) -> Int32
+// CHECK-WMO: struct_extract %0 : $Boo3, #Boo3.Prop1
+// CHECK-WMO: return
+public func testStructLetWithExtensionInit(b: Boo3) -> Int32 {
+  return b.Prop1
+}
@@ -0,0 +1,10 @@
+public func pureAdd(a: Int, _ b: Int) -> Int {
+  return a &+ b
+}
+
+public var globalCounter = 0
+
+public func bumpCounter() -> Int {
+  globalCounter += 1
+  return globalCounter
+}
@@ -0,0 +1,11 @@
+public struct Widget {
+  public init() {}
+  public var size: Int { return 1 }
+}
+
+public struct AnyWidget {
+  public init() {}
+  public var fontSize: Int { return 2 }
+}
+
+public func makeAnyWidget() -> AnyWidget { return AnyWidget() }
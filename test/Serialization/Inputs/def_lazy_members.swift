@@ -0,0 +1,23 @@
+public struct Container {
+  public var count: Int
+  public init(count: Int) { self.count = count }
+  public func describe() -> Int { return count }
+  public func describe(times: Int) -> Int { return count * times }
+  public static var empty: Container { return Container(count: 0) }
+}
+
+public extension Container {
+  func scaled(factor: Int) -> Container {
+    return Container(count: count * factor)
+  }
+}
+
+public class Base {
+  public init() {}
+  public func name() -> Int { return 1 }
+}
+
+public class Derived : Base {
+  public override init() {}
+  public override func name() -> Int { return 2 }
+}
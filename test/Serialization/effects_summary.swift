@@ -0,0 +1,20 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: %target-swift-frontend -emit-module -O -o %t %S/Inputs/def_effects_summary.swift
+// RUN: %target-swift-frontend -emit-sil -O -I %t %s | FileCheck %s
+
+// The effects inferred for public functions are serialized as declarations,
+// so that clients know them without a function body.
+
+import def_effects_summary
+
+public func callPure() -> Int {
+  return pureAdd(1, 2)
+}
+
+public func callImpure() -> Int {
+  return bumpCounter()
+}
+
+// CHECK-DAG: sil [readnone] @_TF19def_effects_summary7pureAddFTSiSi_Si : $@convention(thin) (Int, Int) -> Int
+// CHECK-DAG: sil @_TF19def_effects_summary11bumpCounterFT_Si : $@convention(thin) () -> Int
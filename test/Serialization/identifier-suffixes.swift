@@ -0,0 +1,13 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -emit-module -o %t %S/Inputs/def_identifier_suffixes.swift
+// RUN: llvm-bcanalyzer %t/def_identifier_suffixes.swiftmodule | FileCheck %s
+// RUN: %target-swift-frontend -parse -I %t %s
+
+// CHECK-NOT: UnknownCode
+
+import def_identifier_suffixes
+
+// Identifiers which are suffixes of other identifiers share their storage.
+let w = Widget()
+let a: AnyWidget = makeAnyWidget()
+let sizes = w.size + a.fontSize
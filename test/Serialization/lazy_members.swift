@@ -0,0 +1,25 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: %target-swift-frontend -emit-module -o %t %S/Inputs/def_lazy_members.swift
+// RUN: llvm-bcanalyzer %t/def_lazy_members.swiftmodule | FileCheck -check-prefix=BCANALYZER %s
+// RUN: %target-swift-frontend -parse -I %t %s -verify
+
+// Members of imported types are looked up by name through the member table.
+// BCANALYZER: DECL_MEMBER_NAMES
+
+import def_lazy_members
+
+extension Container {
+  func twice() -> Container { return scaled(2) }
+}
+
+func test(c: Container, d: Derived) {
+  let _: Int = c.describe()
+  let _: Int = c.describe(3)
+  let _: Int = c.count
+  let _: Container = c.scaled(2).twice()
+  let _: Container = Container.empty
+  let _ = Container(count: 1)
+  let _: Int = d.name()
+  c.missing() // expected-error {{value of type 'Container' has no member 'missing'}}
+}
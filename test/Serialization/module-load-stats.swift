@@ -0,0 +1,16 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -emit-module -o %t %S/Inputs/def_struct.swift
+// RUN: %target-swift-frontend -parse -I %t %s -module-load-stats-path %t/stats.json
+// RUN: FileCheck %s < %t/stats.json
+
+// RUN: not %target-swift-frontend -parse -I %t %s -module-load-stats-path %t/missing/stats.json 2>&1 | FileCheck -check-prefix=CHECK-ERROR %s
+
+// CHECK: {"module":"def_struct","path":"{{.*}}def_struct.swiftmodule","time_us":{{[0-9]+}},"bytes_read":{{[1-9][0-9]*}},"decls":{
+// CHECK-SAME: "Struct":{{[1-9][0-9]*}}
+// CHECK-SAME: "types":{{[1-9][0-9]*}}
+
+// CHECK-ERROR: error: cannot open file '{{.*}}missing/stats.json'
+
+import def_struct
+
+var a: TwoInts = TwoInts(x: 1, y: 2)
@@ -0,0 +1,12 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %target-swift-frontend -emit-module -o %t %S/Inputs/def_struct.swift
+// RUN: llvm-bcanalyzer -dump %t/def_struct.swiftmodule | FileCheck %s
+// RUN: %target-swift-frontend -parse -verify -I %t %s
+
+// CHECK: <INDEX_BLOCK
+// CHECK: <NAME_FILTER abbrevid={{[0-9]+}} op0=7/> blob data
+
+import def_struct
+
+var a: TwoInts = TwoInts(x: 1, y: 2)
+var b: ThreeInts // expected-error {{use of undeclared type 'ThreeInts'}}
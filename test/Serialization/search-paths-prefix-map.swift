@@ -0,0 +1,12 @@
+// RUN: rm -rf %t && mkdir -p %t/secret %t/Frameworks
+// RUN: %target-swift-frontend -emit-module -module-name paths -o %t/paths.swiftmodule -I %t/secret -F %t/Frameworks -parse-as-library %S/../Inputs/empty.swift -serialize-debugging-options -serialized-path-prefix-map %t=/REMAPPED
+// RUN: llvm-bcanalyzer -dump %t/paths.swiftmodule | FileCheck %s
+
+// RUN: not %target-swift-frontend -emit-module -module-name bad -o %t/bad.swiftmodule -parse-as-library %S/../Inputs/empty.swift -serialized-path-prefix-map noequals 2>&1 | FileCheck -check-prefix=CHECK-ERROR %s
+
+// CHECK: <INPUT_BLOCK
+// CHECK: <SEARCH_PATH abbrevid={{[0-9]+}} op0=1/> blob data = '/REMAPPED/Frameworks'
+// CHECK: <SEARCH_PATH abbrevid={{[0-9]+}} op0=0/> blob data = '/REMAPPED/secret'
+// CHECK: </INPUT_BLOCK>
+
+// CHECK-ERROR: error: invalid value 'noequals' in '-serialized-path-prefix-map noequals'
@@ -0,0 +1,32 @@
+struct Foo {
+  func fooMethod() {}
+}
+struct Bar {
+  func barMethod() {}
+}
+struct Baz<T> {
+  func test(foo: Foo, value: T) {
+    let bar = Bar()
+    foo.
+    bar.
+    value.
+  }
+}
+
+// The second and third requests only re-parse the body of test(foo:value:).
+
+// RUN: %sourcekitd-test -req=complete -pos=10:9 %s -- %s \
+// RUN:   == -req=complete -pos=11:9 %s -- %s \
+// RUN:   == -req=complete -pos=12:11 %s -- %s > %t.response
+// RUN: FileCheck %s < %t.response
+
+// CHECK-LABEL: key.results: [
+// CHECK: key.name: "fooMethod()"
+// CHECK-NOT: key.name: "barMethod()"
+// CHECK-LABEL: key.results: [
+// CHECK-NOT: key.name: "fooMethod()"
+// CHECK: key.name: "barMethod()"
+// CHECK-LABEL: key.results: [
+// CHECK-NOT: key.name: "fooMethod()"
+// CHECK-NOT: key.name: "barMethod()"
+// CHECK: ]
@@ -0,0 +1,4 @@
+func useShared() -> Int {
+  let s: String = sharedValue()
+  return s.characters.count
+}
@@ -0,0 +1,24 @@
+func sharedValue() -> Int {
+  return 1
+}
+
+let x: String = 1
+
+// Both files of the module are diagnosed, whether the AST of the second one
+// is built separately or shares the compiler instance of the first one.
+
+// RUN: %sourcekitd-test -req=open %s -- %s %S/Inputs/sema_shared_module_ast_other.swift == \
+// RUN:    -req=print-diags %s == \
+// RUN:    -req=open %S/Inputs/sema_shared_module_ast_other.swift -- %s %S/Inputs/sema_shared_module_ast_other.swift == \
+// RUN:    -req=print-diags %S/Inputs/sema_shared_module_ast_other.swift | FileCheck %s
+
+// CHECK: key.line: 5,
+// CHECK: key.filepath: {{.*}}sema_shared_module_ast.swift,
+// CHECK: key.severity: source.diagnostic.severity.error,
+// CHECK: key.description: "cannot convert value of type 'Int' to specified type 'String'"
+
+// CHECK: key.line: 2,
+// CHECK: key.filepath: {{.*}}sema_shared_module_ast_other.swift,
+// CHECK: key.severity: source.diagnostic.severity.error,
+// CHECK: key.description: "cannot convert value of type 'Int' to specified type 'String'"
+// CHECK-NOT: key.line: 5,
@@ -0,0 +1,12 @@
+// RUN: %sourcekitd-test -replay %S/Inputs/recorded_session.yaml | FileCheck %s
+
+// CHECK: ===- Replayed 5 requests (ms) -===
+// CHECK-NEXT: count errors p50 p90 p99 max rec p50 request
+// CHECK-NEXT: 1 1 {{.*}} 0.01 source.request.codecomplete
+// CHECK-NEXT: 1 0 {{.*}} 0.30 source.request.editor.close
+// CHECK-NEXT: 1 0 {{.*}} 2.10 source.request.editor.open
+// CHECK-NEXT: 2 0 {{.*}} 0.80 source.request.editor.replacetext
+// CHECK-NEXT: peak resident set size: {{[0-9]+}} KiB
+
+// RUN: not %sourcekitd-test -replay %S/Inputs/recorded_session_bad.yaml 2>&1 | FileCheck %s -check-prefix=BAD
+// BAD: error: line 1: expected '---' before the first request
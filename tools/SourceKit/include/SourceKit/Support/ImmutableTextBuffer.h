@@ -21,12 +21,18 @@
 #include "llvm/Support/Mutex.h"
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace llvm {
   class MemoryBuffer;
   class SourceMgr;
 }
 
+namespace clang {
+  class RewriteRope;
+}
+
 namespace SourceKit {
 
 class ImmutableTextUpdate;
@@ -73,6 +79,11 @@ class ImmutableTextBuffer : public ImmutableTextUpdate {
   std::unique_ptr<llvm::SourceMgr> SrcMgr;
   unsigned BufId;
 
+  /// Offsets of the start of each line, computed on the first line and
+  /// column query.
+  mutable std::vector<unsigned> LineStarts;
+  mutable std::once_flag LineStartsOnce;
+
 public:
   explicit ImmutableTextBuffer(std::unique_ptr<llvm::MemoryBuffer> MemBuf,
                                uint64_t Stamp);
@@ -156,10 +167,14 @@ class EditableTextBuffer : public ThreadSafeRefCountedBase<EditableTextBuffer> {
   llvm::sys::Mutex EditMtx;
   ImmutableTextBufferRef Root;
   ImmutableTextUpdateRef CurrUpd;
+  /// The text as of \c CurrUpd, updated in place by each edit so that getting
+  /// the buffer of the latest snapshot doesn't replay the update chain.
+  std::unique_ptr<clang::RewriteRope> CurrText;
   std::string Filename;
 
 public:
   explicit EditableTextBuffer(StringRef Filename, StringRef Text = StringRef());
+  ~EditableTextBuffer();
 
   StringRef getFilename() const { return Filename; }
 
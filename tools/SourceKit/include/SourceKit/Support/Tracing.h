@@ -16,6 +16,7 @@
 #include "SourceKit/Support/UIdent.h"
 #include "llvm/ADT/Optional.h"
 
+#include <chrono>
 #include <vector>
 
 namespace SourceKit {
@@ -126,6 +127,59 @@ public:
 
 };
 
+//----------------------------------------------------------------------------//
+// Statistics
+//----------------------------------------------------------------------------//
+
+// Unlike tracing, statistics are always collected. Recording a value is cheap
+// enough to do for every request.
+
+// Record a latency sample, in microseconds, for the histogram \p Name.
+void recordLatency(StringRef Name, uint64_t Microseconds);
+
+// Increment the counter \p Name.
+void incrementCounter(StringRef Name);
+
+struct Statistic {
+  std::string Name;
+  uint64_t Count = 0;
+  bool IsHistogram = false;
+  // Approximate percentiles in microseconds, only set for histograms.
+  uint64_t P50 = 0;
+  uint64_t P90 = 0;
+  uint64_t P99 = 0;
+};
+
+// Returns all counters and histograms recorded so far, sorted by name.
+std::vector<Statistic> getStatistics();
+
+// Records the time from its construction until it is destroyed or finish() is
+// called in the histogram \p Name.
+class LatencyTimer final {
+  std::string Name;
+  std::chrono::steady_clock::time_point Start;
+  bool Finished = false;
+
+public:
+  explicit LatencyTimer(StringRef Name)
+    : Name(Name), Start(std::chrono::steady_clock::now()) {}
+  ~LatencyTimer() {
+    finish();
+  }
+
+  LatencyTimer(const LatencyTimer &) = delete;
+  LatencyTimer &operator=(const LatencyTimer &) = delete;
+
+  void finish() {
+    if (Finished)
+      return;
+    Finished = true;
+    auto Elapsed = std::chrono::steady_clock::now() - Start;
+    recordLatency(Name,
+      std::chrono::duration_cast<std::chrono::microseconds>(Elapsed).count());
+  }
+};
+
 } // namespace sourcekitd
 } // namespace trace
 
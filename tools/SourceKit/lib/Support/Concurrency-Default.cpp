@@ -0,0 +1,315 @@
+//===--- Concurrency-Default.cpp ------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// A WorkQueue implementation for platforms without libdispatch.
+//
+// Work runs on a process-wide pool of threads. The pool picks the oldest item
+// of the highest priority that is ready. Each WorkQueue keeps its own list of
+// pending items and submits one to the pool only when the queue's dequeuing
+// rules allow it: one at a time for serial queues, any number at a time for
+// concurrent queues, and barriers only after everything before them has
+// finished. Synchronous dispatches run on the calling thread once the queue
+// admits them, as they do with libdispatch, so that they never tie up a pool
+// thread while they wait.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SourceKit/Support/Concurrency.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Threading.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace SourceKit;
+
+static const size_t LargeStackSize = 8 << 20; // 8 MB.
+
+namespace {
+
+/// A function to run, and whether it needs a large stack.
+struct WorkItem {
+  void *Context;
+  WorkQueue::DispatchFn Fn;
+  bool IsStackDeep;
+
+  void run() const {
+    if (!IsStackDeep) {
+      Fn(Context);
+      return;
+    }
+    llvm::llvm_execute_on_thread(Fn, Context, LargeStackSize);
+  }
+};
+
+/// The process-wide pool of worker threads, with one FIFO per priority.
+class ThreadPool {
+  std::mutex Mutex;
+  std::condition_variable HasWork;
+  std::deque<WorkItem> Pending[4];
+
+  ThreadPool() {
+    // Requests often block waiting for each other, so don't go below a few
+    // threads even on small machines.
+    unsigned NumThreads = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i != NumThreads; ++i)
+      std::thread([this] { runWorker(); }).detach();
+  }
+
+  void runWorker() {
+    while (true) {
+      WorkItem Item;
+      {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        auto NextQueue = [&]() -> std::deque<WorkItem> * {
+          for (auto &Queue : Pending)
+            if (!Queue.empty())
+              return &Queue;
+          return nullptr;
+        };
+        std::deque<WorkItem> *Queue;
+        HasWork.wait(Lock, [&] { return (Queue = NextQueue()) != nullptr; });
+        Item = Queue->front();
+        Queue->pop_front();
+      }
+      Item.run();
+    }
+  }
+
+public:
+  /// The pool is never destroyed, so that detached workers and work that is
+  /// still queued at exit don't race with static destructors.
+  static ThreadPool &get() {
+    static ThreadPool *Pool = new ThreadPool();
+    return *Pool;
+  }
+
+  void submit(WorkQueue::Priority Prio, const WorkItem &Item) {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Pending[unsigned(Prio)].push_back(Item);
+    }
+    HasWork.notify_one();
+  }
+};
+
+/// The state of one WorkQueue.
+class QueueImpl {
+  /// An item waiting to be admitted by this queue. Synchronous items carry
+  /// the flag their caller waits on instead of being submitted to the pool.
+  struct Entry {
+    WorkItem Item;
+    bool IsBarrier;
+    bool *SyncAdmitted;
+  };
+
+  std::atomic<unsigned> RefCount{1};
+  const WorkQueue::Dequeuing DeqKind;
+  std::atomic<WorkQueue::Priority> Prio;
+  const std::string Label;
+
+  std::mutex Mutex;
+  std::condition_variable SyncAdmission;
+  std::deque<Entry> Pending;
+  unsigned NumRunning = 0;
+  bool BarrierRunning = false;
+  unsigned SuspendCount = 0;
+
+  /// Admits as many pending items as the dequeuing rules allow. Must be
+  /// called with \c Mutex held.
+  void admitPending() {
+    while (!SuspendCount && !Pending.empty() && !BarrierRunning) {
+      const Entry &Next = Pending.front();
+      if (Next.IsBarrier) {
+        if (NumRunning != 0)
+          return;
+        BarrierRunning = true;
+      } else {
+        if (DeqKind == WorkQueue::Dequeuing::Serial && NumRunning != 0)
+          return;
+        ++NumRunning;
+      }
+
+      Entry Admitted = Next;
+      Pending.pop_front();
+      if (Admitted.SyncAdmitted) {
+        *Admitted.SyncAdmitted = true;
+        SyncAdmission.notify_all();
+      } else {
+        submitToPool(Admitted);
+      }
+    }
+  }
+
+  struct PoolTask {
+    QueueImpl *Queue;
+    Entry Admitted;
+  };
+
+  static void runPoolTask(void *Ctx) {
+    PoolTask *Task = static_cast<PoolTask *>(Ctx);
+    Task->Admitted.Item.run();
+    Task->Queue->finished(Task->Admitted.IsBarrier);
+    Task->Queue->release();
+    delete Task;
+  }
+
+  void submitToPool(const Entry &Admitted) {
+    WorkItem Task = { new PoolTask{ this, Admitted }, runPoolTask, false };
+    ThreadPool::get().submit(Prio, Task);
+  }
+
+  void finished(bool WasBarrier) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (WasBarrier)
+      BarrierRunning = false;
+    else
+      --NumRunning;
+    admitPending();
+  }
+
+public:
+  QueueImpl(WorkQueue::Dequeuing DeqKind, WorkQueue::Priority Prio,
+            llvm::StringRef Label)
+    : DeqKind(DeqKind), Prio(Prio), Label(Label.str()) {}
+
+  llvm::StringRef getLabel() const { return Label; }
+
+  void setPriority(WorkQueue::Priority NewPrio) { Prio = NewPrio; }
+
+  void retain() { ++RefCount; }
+  void release() {
+    if (--RefCount == 0)
+      delete this;
+  }
+
+  void dispatch(const WorkItem &Item, bool IsBarrier) {
+    // Like with libdispatch, work keeps its queue alive until it's done.
+    retain();
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Pending.push_back({ Item, IsBarrier, nullptr });
+    admitPending();
+  }
+
+  void dispatchSync(const WorkItem &Item, bool IsBarrier) {
+    bool Admitted = false;
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Pending.push_back({ Item, IsBarrier, &Admitted });
+      admitPending();
+      SyncAdmission.wait(Lock, [&] { return Admitted; });
+    }
+    Item.run();
+    finished(IsBarrier);
+  }
+
+  void suspend() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    ++SuspendCount;
+  }
+
+  void resume() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    assert(SuspendCount && "resuming a queue that isn't suspended");
+    --SuspendCount;
+    admitPending();
+  }
+};
+
+} // end anonymous namespace
+
+static QueueImpl *getImpl(void *Obj) {
+  return static_cast<QueueImpl *>(Obj);
+}
+
+static WorkItem toWorkItem(void *Context, WorkQueue::DispatchFn Fn,
+                           bool IsStackDeep) {
+  return { Context, Fn, IsStackDeep };
+}
+
+/// There is no main run loop to hand work to, so work for the "main" queue
+/// is serialized on a queue of its own.
+static QueueImpl &getMainQueue() {
+  static QueueImpl *Main = new QueueImpl(WorkQueue::Dequeuing::Serial,
+                                         WorkQueue::Priority::High, "main");
+  return *Main;
+}
+
+void *WorkQueue::Impl::create(Dequeuing DeqKind, Priority Prio,
+                              llvm::StringRef Label) {
+  return new QueueImpl(DeqKind, Prio, Label);
+}
+
+void WorkQueue::Impl::dispatch(Ty Obj, const DispatchData &Fn) {
+  getImpl(Obj)->dispatch(toWorkItem(Fn.getContext(), Fn.getFunction(),
+                                    Fn.isStackDeep()),
+                         /*IsBarrier=*/false);
+}
+
+void WorkQueue::Impl::dispatchSync(Ty Obj, const DispatchData &Fn) {
+  getImpl(Obj)->dispatchSync(toWorkItem(Fn.getContext(), Fn.getFunction(),
+                                        Fn.isStackDeep()),
+                             /*IsBarrier=*/false);
+}
+
+void WorkQueue::Impl::dispatchBarrier(Ty Obj, const DispatchData &Fn) {
+  getImpl(Obj)->dispatch(toWorkItem(Fn.getContext(), Fn.getFunction(),
+                                    Fn.isStackDeep()),
+                         /*IsBarrier=*/true);
+}
+
+void WorkQueue::Impl::dispatchBarrierSync(Ty Obj, const DispatchData &Fn) {
+  getImpl(Obj)->dispatchSync(toWorkItem(Fn.getContext(), Fn.getFunction(),
+                                        Fn.isStackDeep()),
+                             /*IsBarrier=*/true);
+}
+
+void WorkQueue::Impl::dispatchOnMain(const DispatchData &Fn) {
+  getMainQueue().dispatch(toWorkItem(Fn.getContext(), Fn.getFunction(),
+                                     Fn.isStackDeep()),
+                          /*IsBarrier=*/false);
+}
+
+void WorkQueue::Impl::dispatchConcurrent(Priority Prio,
+                                         const DispatchData &Fn) {
+  ThreadPool::get().submit(Prio, toWorkItem(Fn.getContext(), Fn.getFunction(),
+                                            Fn.isStackDeep()));
+}
+
+void WorkQueue::Impl::suspend(Ty Obj) {
+  getImpl(Obj)->suspend();
+}
+
+void WorkQueue::Impl::resume(Ty Obj) {
+  getImpl(Obj)->resume();
+}
+
+void WorkQueue::Impl::setPriority(Ty Obj, Priority Prio) {
+  getImpl(Obj)->setPriority(Prio);
+}
+
+llvm::StringRef WorkQueue::Impl::getLabel(const Ty Obj) {
+  return getImpl(Obj)->getLabel();
+}
+
+void WorkQueue::Impl::retain(Ty Obj) {
+  getImpl(Obj)->retain();
+}
+
+void WorkQueue::Impl::release(Ty Obj) {
+  getImpl(Obj)->release();
+}
@@ -14,6 +14,7 @@
 #include "clang/Rewrite/Core/RewriteRope.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
+#include <algorithm>
 
 using namespace SourceKit;
 using namespace llvm;
@@ -51,12 +52,22 @@ const llvm::MemoryBuffer *ImmutableTextBuffer::getInternalBuffer() const {
 
 std::pair<unsigned, unsigned>
 ImmutableTextBuffer::getLineAndColumn(unsigned ByteOffset) const {
-  auto Buf = SrcMgr->getMemoryBuffer(BufId);
-  if (ByteOffset > Buf->getBufferSize())
+  StringRef Text = getText();
+  if (ByteOffset > Text.size())
     return std::make_pair(0, 0);
 
-  SMLoc Loc = SMLoc::getFromPointer(Buf->getBufferStart() + ByteOffset);
-  return SrcMgr->getLineAndColumn(Loc, 0);
+  std::call_once(LineStartsOnce, [&] {
+    LineStarts.push_back(0);
+    for (size_t I = 0, E = Text.size(); I != E; ++I)
+      if (Text[I] == '\n')
+        LineStarts.push_back(I + 1);
+  });
+
+  auto LineStart = std::upper_bound(LineStarts.begin(), LineStarts.end(),
+                                    ByteOffset) - 1;
+  unsigned Line = LineStart - LineStarts.begin() + 1;
+  unsigned Column = ByteOffset - *LineStart + 1;
+  return std::make_pair(Line, Column);
 }
 
 ReplaceImmutableTextUpdate::ReplaceImmutableTextUpdate(
@@ -123,8 +134,12 @@ EditableTextBuffer::EditableTextBuffer(StringRef Filename, StringRef Text) {
   this->Filename = Filename;
   Root = new ImmutableTextBuffer(Filename, Text, ++Generation);
   CurrUpd = Root;
+  CurrText.reset(new RewriteRope());
+  CurrText->assign(Text.begin(), Text.end());
 }
 
+EditableTextBuffer::~EditableTextBuffer() {}
+
 ImmutableTextSnapshotRef EditableTextBuffer::getSnapshot() const {
   return new ImmutableTextSnapshot(const_cast<EditableTextBuffer*>(this), Root,
                                    CurrUpd);
@@ -165,18 +180,18 @@ ImmutableTextSnapshotRef EditableTextBuffer::addAtomicUpdate(
   CurrUpd->Next = NewUpd;
   CurrUpd = NewUpd;
 
+  auto ReplaceUpd = cast<ReplaceImmutableTextUpdate>(NewUpd);
+  CurrText->erase(ReplaceUpd->getByteOffset(), ReplaceUpd->getLength());
+  StringRef Text = ReplaceUpd->getText();
+  CurrText->insert(ReplaceUpd->getByteOffset(), Text.begin(), Text.end());
+
   return new ImmutableTextSnapshot(this, Root, CurrUpd);
 }
 
 static std::unique_ptr<llvm::MemoryBuffer>
 getMemBufferFromRope(StringRef Filename, const RewriteRope &Rope) {
-  size_t Length = 0;
-  for (RewriteRope::iterator I = Rope.begin(), E = Rope.end(); I != E;
-       I.MoveToNextPiece()) {
-    Length += I.piece().size();
-  }
-
-  auto MemBuf = llvm::MemoryBuffer::getNewUninitMemBuffer(Length, Filename);
+  auto MemBuf = llvm::MemoryBuffer::getNewUninitMemBuffer(Rope.size(),
+                                                          Filename);
   char *Ptr = (char*)MemBuf->getBufferStart();
   for (RewriteRope::iterator I = Rope.begin(), E = Rope.end(); I != E;
        I.MoveToNextPiece()) {
@@ -198,6 +213,21 @@ ImmutableTextBufferRef EditableTextBuffer::getBufferForSnapshot(
     if (auto Buf = dyn_cast<ImmutableTextBuffer>(Next))
       return Buf;
 
+  {
+    // The latest snapshot is the common case; its text is already up to date
+    // in CurrText.
+    llvm::sys::ScopedLock L(EditMtx);
+    refresh();
+    if (Snap.DiffEnd == CurrUpd) {
+      auto MemBuf = getMemBufferFromRope(getFilename(), *CurrText);
+      ImmutableTextBufferRef ImmBuf =
+          new ImmutableTextBuffer(std::move(MemBuf), Snap.getStamp());
+      CurrUpd->Next = ImmBuf;
+      refresh();
+      return ImmBuf;
+    }
+  }
+
   // Check if a buffer was created in the middle of the snapshot updates.
   ImmutableTextBufferRef StartBuf = Snap.BufferStart;
   ImmutableTextUpdateRef Upd = StartBuf;  
@@ -14,9 +14,14 @@
 
 #include "swift/Frontend/Frontend.h"
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/YAMLTraits.h"
 
+#include <algorithm>
+
 using namespace SourceKit;
 using namespace llvm;
 
@@ -91,3 +96,106 @@ void trace::registerConsumer(trace::TraceConsumer *Consumer) {
                                            std::memory_order_release,
                                            std::memory_order_relaxed));
 }
+
+//----------------------------------------------------------------------------//
+// Statistics
+//----------------------------------------------------------------------------//
+
+namespace {
+/// A histogram with logarithmic buckets: each power of two is split into four
+/// buckets, so a reported percentile is within 25% of the real value.
+class LatencyHistogram {
+  static const unsigned NumBuckets = 64 * 4;
+  uint64_t Buckets[NumBuckets] = {};
+  uint64_t Count = 0;
+
+  static unsigned getBucket(uint64_t Value) {
+    if (Value < 4)
+      return Value;
+    unsigned Log2 = llvm::Log2_64(Value);
+    return Log2 * 4 + ((Value >> (Log2 - 2)) & 3);
+  }
+
+  static uint64_t getBucketUpperBound(unsigned Bucket) {
+    if (Bucket < 4)
+      return Bucket;
+    unsigned Log2 = Bucket / 4;
+    uint64_t Upper = uint64_t(4 + Bucket % 4 + 1) << (Log2 - 2);
+    return Upper - 1;
+  }
+
+public:
+  void record(uint64_t Value) {
+    ++Buckets[getBucket(Value)];
+    ++Count;
+  }
+
+  uint64_t getCount() const { return Count; }
+
+  uint64_t getPercentile(unsigned Percent) const {
+    uint64_t Rank = (Count * Percent + 99) / 100;
+    uint64_t Seen = 0;
+    for (unsigned I = 0; I != NumBuckets; ++I) {
+      Seen += Buckets[I];
+      if (Seen >= Rank && Seen != 0)
+        return getBucketUpperBound(I);
+    }
+    return 0;
+  }
+};
+
+struct Statistics {
+  llvm::sys::Mutex Mtx;
+  llvm::StringMap<LatencyHistogram> Histograms;
+  llvm::StringMap<uint64_t> Counters;
+};
+} // end anonymous namespace
+
+static Statistics &getStatisticsStorage() {
+  // Never destroyed, so that requests that finish during shutdown can still
+  // record their latency.
+  static Statistics *Stats = new Statistics();
+  return *Stats;
+}
+
+void trace::recordLatency(StringRef Name, uint64_t Microseconds) {
+  Statistics &Stats = getStatisticsStorage();
+  llvm::sys::ScopedLock L(Stats.Mtx);
+  Stats.Histograms[Name].record(Microseconds);
+}
+
+void trace::incrementCounter(StringRef Name) {
+  Statistics &Stats = getStatisticsStorage();
+  llvm::sys::ScopedLock L(Stats.Mtx);
+  ++Stats.Counters[Name];
+}
+
+std::vector<trace::Statistic> trace::getStatistics() {
+  std::vector<Statistic> Result;
+  {
+    Statistics &Stats = getStatisticsStorage();
+    llvm::sys::ScopedLock L(Stats.Mtx);
+    for (auto &Entry : Stats.Counters) {
+      Statistic Stat;
+      Stat.Name = Entry.getKey();
+      Stat.Count = Entry.getValue();
+      Result.push_back(std::move(Stat));
+    }
+    for (auto &Entry : Stats.Histograms) {
+      const LatencyHistogram &Histogram = Entry.getValue();
+      Statistic Stat;
+      Stat.Name = Entry.getKey();
+      Stat.Count = Histogram.getCount();
+      Stat.IsHistogram = true;
+      Stat.P50 = Histogram.getPercentile(50);
+      Stat.P90 = Histogram.getPercentile(90);
+      Stat.P99 = Histogram.getPercentile(99);
+      Result.push_back(std::move(Stat));
+    }
+  }
+  std::sort(Result.begin(), Result.end(),
+            [](const Statistic &LHS, const Statistic &RHS) {
+    return LHS.Name < RHS.Name;
+  });
+  return Result;
+}
@@ -85,6 +85,7 @@ struct InvocationOptions {
 
   void applyTo(CompilerInvocation &CompInvok) const;
   void profile(llvm::FoldingSetNodeID &ID) const;
+  void profileModule(llvm::FoldingSetNodeID &ID) const;
   void raw(std::vector<std::string> &Args, std::string &PrimaryFile) const;
 
 private:
@@ -106,9 +107,12 @@ struct ASTKey {
 struct SwiftInvocation::Implementation {
   InvocationOptions Opts;
   ASTKey Key;
+  /// Identifies the invocations which only differ in their primary file.
+  ASTKey ModuleKey;
 
   explicit Implementation(InvocationOptions opts) : Opts(std::move(opts)) {
     Opts.profile(Key.FSID);
+    Opts.profileModule(ModuleKey.FSID);
   }
 };
 
@@ -144,9 +148,13 @@ void InvocationOptions::profile(llvm::FoldingSetNodeID &ID) const {
   // Possibly have all compiler invocation options auto-generated from a
   // tablegen definition file, thus forcing a decision for each option if it is
   // ok to share ASTs with the option differing.
+  profileModule(ID);
+  ID.AddString(PrimaryFile);
+}
+
+void InvocationOptions::profileModule(llvm::FoldingSetNodeID &ID) const {
   for (auto &Arg : Args)
     ID.AddString(Arg);
-  ID.AddString(PrimaryFile);
 }
 
 //============================================================================//
@@ -154,27 +162,39 @@ void InvocationOptions::profile(llvm::FoldingSetNodeID &ID) const {
 //============================================================================//
 
 namespace SourceKit {
-  struct ASTUnit::Implementation {
-    const uint64_t Generation;
-    SmallVector<ImmutableTextSnapshotRef, 4> Snapshots;
+  /// The compiler instance of one or more ASTUnits, one for each of its
+  /// primary files. Everything that accesses the AST, including
+  /// type-checking another primary file, runs on \c Queue.
+  struct SharedCompilerInstance
+      : public ThreadSafeRefCountedBase<SharedCompilerInstance> {
     EditorDiagConsumer CollectDiagConsumer;
     CompilerInstance CompInst;
     OwnedResolver TypeResolver{ nullptr, nullptr };
     WorkQueue Queue{ WorkQueue::Dequeuing::Serial, "sourcekit.swift.ConsumeAST" };
+  };
+
+  struct ASTUnit::Implementation {
+    const uint64_t Generation;
+    SmallVector<ImmutableTextSnapshotRef, 4> Snapshots;
+    IntrusiveRefCntPtr<SharedCompilerInstance> Shared;
+    SourceFile *PrimarySourceFile = nullptr;
+    llvm::DenseMap<const ValueDecl *, std::unique_ptr<DeclDescription>>
+        DeclDescriptions;
+    llvm::sys::Mutex DeclDescriptionsMtx;
 
-    Implementation(uint64_t Generation) : Generation(Generation) {}
+    Implementation(uint64_t Generation,
+                   IntrusiveRefCntPtr<SharedCompilerInstance> Shared)
+      : Generation(Generation), Shared(std::move(Shared)) {}
 
     void consumeAsync(SwiftASTConsumerRef ASTConsumer, ASTUnitRef ASTRef);
   };
 
   void ASTUnit::Implementation::consumeAsync(SwiftASTConsumerRef ConsumerRef,
                                              ASTUnitRef ASTRef) {
-    Queue.dispatch([ASTRef, ConsumerRef]{
+    Shared->Queue.dispatch([ASTRef, ConsumerRef]{
       SwiftASTConsumer &ASTConsumer = *ConsumerRef;
 
-      CompilerInstance &CI = ASTRef->getCompilerInstance();
-
-      if (CI.getPrimarySourceFile()) {
+      if (ASTRef->Impl.PrimarySourceFile) {
         ASTConsumer.handlePrimaryAST(ASTRef);
       } else {
         LOG_WARN_FUNC("did not find primary SourceFile");
@@ -183,7 +203,13 @@ namespace SourceKit {
     });
   }
 
-  ASTUnit::ASTUnit(uint64_t Generation) : Impl(*new Implementation(Generation)) {
+  ASTUnit::ASTUnit(uint64_t Generation)
+    : Impl(*new Implementation(Generation, new SharedCompilerInstance())) {
+  }
+
+  ASTUnit::ASTUnit(uint64_t Generation, const ASTUnit &Other)
+    : Impl(*new Implementation(Generation, Other.Impl.Shared)) {
+    Impl.Snapshots = Other.Impl.Snapshots;
   }
 
   ASTUnit::~ASTUnit() {
@@ -191,7 +217,7 @@ namespace SourceKit {
   }
 
   swift::CompilerInstance &ASTUnit::getCompilerInstance() const {
-    return Impl.CompInst;
+    return Impl.Shared->CompInst;
   }
 
    uint64_t ASTUnit::getGeneration() const {
@@ -203,11 +229,22 @@ namespace SourceKit {
   }
 
   SourceFile &ASTUnit::getPrimarySourceFile() const {
-    return *Impl.CompInst.getPrimarySourceFile();
+    return *Impl.PrimarySourceFile;
   }
 
   EditorDiagConsumer &ASTUnit::getEditorDiagConsumer() const {
-    return Impl.CollectDiagConsumer;
+    return Impl.Shared->CollectDiagConsumer;
+  }
+
+  const DeclDescription &ASTUnit::getDeclDescription(const ValueDecl *VD,
+                    std::function<void(DeclDescription &)> Compute) const {
+    llvm::sys::ScopedLock L(Impl.DeclDescriptionsMtx);
+    auto &Desc = Impl.DeclDescriptions[VD];
+    if (!Desc) {
+      Desc.reset(new DeclDescription());
+      Compute(*Desc);
+    }
+    return *Desc;
   }
 }
 
@@ -228,11 +265,23 @@ struct FileContent {
       Stamp(Stamp) {}
 };
 
+typedef SmallVector<std::pair<std::string, BufferStamp>, 8> DependencyStamps;
+
+/// The most recently built AST of a module, which ASTs for the other files of
+/// the module share while it's up to date.
+struct ModuleAST {
+  ASTKey ModuleKey;
+  std::string PrimaryFile;
+  ASTUnitRef Unit;
+  SmallVector<BufferStamp, 8> Stamps;
+  DependencyStamps DepStamps;
+};
+
 class ASTProducer : public ThreadSafeRefCountedBase<ASTProducer> {
   SwiftInvocationRef InvokRef;
   SmallVector<BufferStamp, 8> Stamps;
   ThreadSafeRefCntPtr<ASTUnit> AST;
-  SmallVector<std::pair<std::string, BufferStamp>, 8> DependencyStamps;
+  DependencyStamps DepStamps;
   std::vector<std::pair<SwiftASTConsumerRef, const void*>> QueuedConsumers;
   llvm::sys::Mutex Mtx;
 
@@ -257,12 +306,21 @@ public:
 
   size_t getMemoryCost() const {
     // FIXME: Report the memory cost of the overall CompilerInstance.
+    // FIXME: A compiler instance shared with ASTs of other files of the same
+    // module is counted for each of them.
     if (AST && AST->getCompilerInstance().hasASTContext())
-      return AST->Impl.CompInst.getASTContext().getTotalMemory();
+      return AST->getCompilerInstance().getASTContext().getTotalMemory();
     return sizeof(*this) + sizeof(*AST);
   }
 
 private:
+  void getInputStamps(SwiftASTManager::Implementation &MgrImpl,
+                      ArrayRef<ImmutableTextSnapshotRef> Snapshots,
+                      SmallVectorImpl<BufferStamp> &InputStamps);
+
+  ASTUnitRef reuseModuleAST(SwiftASTManager::Implementation &MgrImpl,
+                            ArrayRef<ImmutableTextSnapshotRef> Snapshots);
+
   ASTUnitRef getASTUnitImpl(SwiftASTManager::Implementation &MgrImpl,
                             ArrayRef<ImmutableTextSnapshotRef> Snapshots,
                             std::string &Error);
@@ -313,7 +371,15 @@ struct SwiftASTManager::Implementation {
   WorkQueue ASTBuildQueue{ WorkQueue::Dequeuing::Serial,
                            "sourcekit.swift.ASTBuilding" };
 
+  /// The most recently built AST of each module with open documents.
+  std::vector<ModuleAST> ModuleASTs;
+  llvm::sys::Mutex ModuleASTsMtx;
+
   ASTProducerRef getASTProducer(SwiftInvocationRef InvokRef);
+  llvm::Optional<ModuleAST> findModuleAST(const ASTKey &ModuleKey);
+  void setModuleAST(ModuleAST NewAST);
+  void removeModuleAST(const ASTKey &ModuleKey, StringRef PrimaryFile);
+  bool dependenciesChanged(const DependencyStamps &DepStamps);
   FileContent getFileContent(StringRef FilePath, std::string &Error);
   BufferStamp getBufferStamp(StringRef FilePath);
   std::unique_ptr<llvm::MemoryBuffer> getMemoryBuffer(StringRef Filename,
@@ -493,6 +559,46 @@ void SwiftASTManager::processASTAsync(SwiftInvocationRef InvokRef,
 
 void SwiftASTManager::removeCachedAST(SwiftInvocationRef Invok) {
   Impl.ASTCache.remove(Invok->Impl.Key);
+  Impl.removeModuleAST(Invok->Impl.ModuleKey, Invok->Impl.Opts.PrimaryFile);
+}
+
+llvm::Optional<ModuleAST>
+SwiftASTManager::Implementation::findModuleAST(const ASTKey &ModuleKey) {
+  llvm::sys::ScopedLock L(ModuleASTsMtx);
+  for (auto &Entry : ModuleASTs)
+    if (Entry.ModuleKey.FSID == ModuleKey.FSID)
+      return Entry;
+  return llvm::None;
+}
+
+void SwiftASTManager::Implementation::setModuleAST(ModuleAST NewAST) {
+  llvm::sys::ScopedLock L(ModuleASTsMtx);
+  for (auto &Entry : ModuleASTs) {
+    if (Entry.ModuleKey.FSID == NewAST.ModuleKey.FSID) {
+      Entry = std::move(NewAST);
+      return;
+    }
+  }
+  ModuleASTs.push_back(std::move(NewAST));
+}
+
+void SwiftASTManager::Implementation::removeModuleAST(const ASTKey &ModuleKey,
+                                                      StringRef PrimaryFile) {
+  llvm::sys::ScopedLock L(ModuleASTsMtx);
+  ModuleASTs.erase(std::remove_if(ModuleASTs.begin(), ModuleASTs.end(),
+                                  [&](const ModuleAST &Entry) {
+    return Entry.ModuleKey.FSID == ModuleKey.FSID &&
+           Entry.PrimaryFile == PrimaryFile;
+  }), ModuleASTs.end());
+}
+
+bool SwiftASTManager::Implementation::dependenciesChanged(
+    const DependencyStamps &DepStamps) {
+  for (auto &Dependency : DepStamps) {
+    if (Dependency.second != getBufferStamp(Dependency.first))
+      return true;
+  }
+  return false;
 }
 
 ASTProducerRef
@@ -562,7 +668,12 @@ void ASTProducer::getASTUnitAsync(SwiftASTManager::Implementation &MgrImpl,
   SmallVector<ImmutableTextSnapshotRef, 4> Snapshots;
   Snapshots.append(Snaps.begin(), Snaps.end());
 
-  MgrImpl.ASTBuildQueue.dispatch([ThisProducer, &MgrImpl, Snapshots, Receiver] {
+  // Time spent waiting for the build queue is tracked apart from the build
+  // itself, so that the statistics tell contention from slow builds.
+  auto QueueTimer = std::make_shared<trace::LatencyTimer>("ast.queue");
+  MgrImpl.ASTBuildQueue.dispatch([ThisProducer, &MgrImpl, Snapshots, Receiver,
+                                  QueueTimer] {
+    QueueTimer->finish();
     std::string Error;
     ASTUnitRef Unit = ThisProducer->getASTUnitImpl(MgrImpl, Snapshots, Error);
     Receiver(Unit, Error);
@@ -572,6 +683,15 @@ void ASTProducer::getASTUnitAsync(SwiftASTManager::Implementation &MgrImpl,
 ASTUnitRef ASTProducer::getASTUnitImpl(SwiftASTManager::Implementation &MgrImpl,
                                    ArrayRef<ImmutableTextSnapshotRef> Snapshots,
                                    std::string &Error) {
+  // FIXME: Every edit rebuilds the whole CompilerInstance, even when it only
+  // touched the inside of one function body. Reusing the previous AST for such
+  // edits (found via ImmutableTextSnapshot::foreachReplaceUntil) would need:
+  //   - source locations of everything after the edit to be remapped, since
+  //     the replaced buffer shifts them;
+  //   - a way to re-parse and re-typecheck a single body against an
+  //     ASTContext that has already finished type checking;
+  //   - copy-on-write ASTUnits, because consumers may keep using the previous
+  //     one concurrently.
   if (!AST || shouldRebuild(MgrImpl, Snapshots)) {
     bool IsRebuild = AST != nullptr;
     const InvocationOptions &Opts = InvokRef->Impl.Opts;
@@ -586,7 +706,15 @@ ASTUnitRef ASTProducer::getASTUnitImpl(SwiftASTManager::Implementation &MgrImpl,
       Log->getOS() << Opts.Invok.getModuleName() << '/' << Opts.PrimaryFile;
     }
 
-    auto NewAST = createASTUnit(MgrImpl, Snapshots, Error);
+    trace::incrementCounter("ast.cache.miss");
+    ASTUnitRef NewAST = reuseModuleAST(MgrImpl, Snapshots);
+    if (NewAST) {
+      trace::incrementCounter("ast.module.reuse");
+    } else {
+      trace::LatencyTimer BuildTimer("ast.build");
+      NewAST = createASTUnit(MgrImpl, Snapshots, Error);
+      BuildTimer.finish();
+    }
     {
       // FIXME: ThreadSafeRefCntPtr is racy.
       llvm::sys::ScopedLock L(Mtx);
@@ -599,6 +727,8 @@ ASTUnitRef ASTProducer::getASTUnitImpl(SwiftASTManager::Implementation &MgrImpl,
       ASTProducerRef ThisProducer = this;
       MgrImpl.ASTCache.set(InvokRef->Impl.Key, ThisProducer);
     }
+  } else {
+    trace::incrementCounter("ast.cache.hit");
   }
 
   return AST;
@@ -630,12 +760,13 @@ std::vector<SwiftASTConsumerRef> ASTProducer::popQueuedConsumers() {
   return Consumers;
 }
 
-bool ASTProducer::shouldRebuild(SwiftASTManager::Implementation &MgrImpl,
-                                ArrayRef<ImmutableTextSnapshotRef> Snapshots) {
+static std::atomic<uint64_t> ASTUnitGeneration{ 0 };
+
+void ASTProducer::getInputStamps(SwiftASTManager::Implementation &MgrImpl,
+                                 ArrayRef<ImmutableTextSnapshotRef> Snapshots,
+                                 SmallVectorImpl<BufferStamp> &InputStamps) {
   const SwiftInvocation::Implementation &Invok = InvokRef->Impl;
 
-  // Check if the inputs changed.
-  SmallVector<BufferStamp, 8> InputStamps;
   InputStamps.reserve(Invok.Opts.Invok.getInputFilenames().size());
   for (auto &File : Invok.Opts.Invok.getInputFilenames()) {
     bool FoundSnapshot = false;
@@ -650,15 +781,85 @@ bool ASTProducer::shouldRebuild(SwiftASTManager::Implementation &MgrImpl,
       InputStamps.push_back(MgrImpl.getBufferStamp(File));
   }
   assert(InputStamps.size() == Invok.Opts.Invok.getInputFilenames().size());
+}
+
+bool ASTProducer::shouldRebuild(SwiftASTManager::Implementation &MgrImpl,
+                                ArrayRef<ImmutableTextSnapshotRef> Snapshots) {
+  // Check if the inputs changed.
+  SmallVector<BufferStamp, 8> InputStamps;
+  getInputStamps(MgrImpl, Snapshots, InputStamps);
   if (Stamps != InputStamps)
     return true;
 
-  for (auto &Dependency : DependencyStamps) {
-    if (Dependency.second != MgrImpl.getBufferStamp(Dependency.first))
-      return true;
+  return MgrImpl.dependenciesChanged(DepStamps);
+}
+
+/// Returns the input source file of \p CI with the name \p Filename.
+static SourceFile *findInputSourceFile(CompilerInstance &CI,
+                                       StringRef Filename) {
+  for (auto File : CI.getMainModule()->getFiles()) {
+    auto SF = dyn_cast<SourceFile>(File);
+    if (!SF || !SF->getBufferID().hasValue())
+      continue;
+    if (CI.getSourceMgr().getIdentifierForBuffer(SF->getBufferID().getValue())
+          == Filename)
+      return SF;
   }
+  return nullptr;
+}
 
-  return false;
+ASTUnitRef ASTProducer::reuseModuleAST(SwiftASTManager::Implementation &MgrImpl,
+                                  ArrayRef<ImmutableTextSnapshotRef> Snapshots) {
+  const SwiftInvocation::Implementation &Invok = InvokRef->Impl;
+  llvm::Optional<ModuleAST> Existing = MgrImpl.findModuleAST(Invok.ModuleKey);
+  if (!Existing)
+    return nullptr;
+
+  // The invocations only differ in their primary file, so the other AST was
+  // built from the same inputs if their stamps still match.
+  SmallVector<BufferStamp, 8> InputStamps;
+  getInputStamps(MgrImpl, Snapshots, InputStamps);
+  if (Existing->Stamps != InputStamps ||
+      MgrImpl.dependenciesChanged(Existing->DepStamps))
+    return nullptr;
+
+  ASTUnitRef ASTRef = new ASTUnit(++ASTUnitGeneration, *Existing->Unit);
+  SharedCompilerInstance &Shared = *ASTRef->Impl.Shared;
+
+  // Consumers of the other ASTs may be using the compiler instance, so the
+  // primary file is type-checked on their queue.
+  const std::string &PrimaryFile = Invok.Opts.PrimaryFile;
+  Shared.Queue.dispatchSync([&] {
+    CompilerInstance &CompIns = Shared.CompInst;
+    SourceFile *SF = findInputSourceFile(CompIns, PrimaryFile);
+    if (!SF)
+      return;
+
+    auto PrimaryFiles = CompIns.getPrimarySourceFiles();
+    if (std::find(PrimaryFiles.begin(), PrimaryFiles.end(), SF) ==
+          PrimaryFiles.end()) {
+      // Stop using the lazy resolver while type-checking, as
+      // createASTUnit() does.
+      Shared.TypeResolver.reset();
+      CloseClangModuleFiles scopedCloseFiles(
+          *CompIns.getASTContext().getClangModuleLoader());
+      CompIns.typeCheckAdditionalPrimaryFile(*SF);
+      if (!Shared.CollectDiagConsumer.hadAnyError()) {
+        SILOptions SILOpts;
+        std::unique_ptr<SILModule> SILMod = performSILGeneration(*SF, SILOpts);
+        runSILDiagnosticPasses(*SILMod);
+      }
+      Shared.TypeResolver = createLazyResolver(CompIns.getASTContext());
+    }
+    ASTRef->Impl.PrimarySourceFile = SF;
+  }, /*isStackDeep=*/true);
+
+  if (!ASTRef->Impl.PrimarySourceFile)
+    return nullptr;
+
+  Stamps = Existing->Stamps;
+  DepStamps = Existing->DepStamps;
+  return ASTRef;
 }
 
 static void collectModuleDependencies(Module *TopMod,
@@ -710,13 +911,36 @@ static void collectModuleDependencies(Module *TopMod,
   }
 }
 
-static std::atomic<uint64_t> ASTUnitGeneration{ 0 };
+void SwiftASTManager::getFileStamps(const CompilerInvocation &Invocation,
+                                    Module *MainModule, StringRef PrimaryFile,
+                                    FileStamps &Stamps) {
+  for (auto &File : Invocation.getInputFilenames()) {
+    if (File != PrimaryFile)
+      Stamps.push_back(std::make_pair(File, Impl.getBufferStamp(File)));
+  }
+
+  llvm::SmallPtrSet<Module *, 16> Visited;
+  SmallVector<std::string, 8> Filenames;
+  collectModuleDependencies(MainModule, Visited, Filenames);
+  for (auto &Filename : Filenames) {
+    auto Stamp = Impl.getBufferStamp(Filename);
+    Stamps.push_back(std::make_pair(std::move(Filename), Stamp));
+  }
+}
+
+bool SwiftASTManager::fileStampsChanged(const FileStamps &Stamps) {
+  for (auto &Entry : Stamps) {
+    if (Entry.second != Impl.getBufferStamp(Entry.first))
+      return true;
+  }
+  return false;
+}
 
 ASTUnitRef ASTProducer::createASTUnit(SwiftASTManager::Implementation &MgrImpl,
                                       ArrayRef<ImmutableTextSnapshotRef> Snapshots,
                                       std::string &Error) {
   Stamps.clear();
-  DependencyStamps.clear();
+  DepStamps.clear();
 
   const InvocationOptions &Opts = InvokRef->Impl.Opts;
 
@@ -764,8 +988,8 @@ ASTUnitRef ASTProducer::createASTUnit(SwiftASTManager::Implementation &MgrImpl,
 
     }
   }
-  auto &CompIns = ASTRef->Impl.CompInst;
-  auto &Consumer = ASTRef->Impl.CollectDiagConsumer;
+  auto &CompIns = ASTRef->Impl.Shared->CompInst;
+  auto &Consumer = ASTRef->Impl.Shared->CollectDiagConsumer;
 
   // Display diagnostics to stderr.
   CompIns.addDiagnosticConsumer(&Consumer);
@@ -799,8 +1023,8 @@ ASTUnitRef ASTProducer::createASTUnit(SwiftASTManager::Implementation &MgrImpl,
   // FIXME: There exists a small window where the module file may have been
   // modified after compilation finished and before we get its stamp.
   for (auto &Filename : Filenames) {
-    DependencyStamps.push_back(std::make_pair(Filename,
-                                              MgrImpl.getBufferStamp(Filename)));
+    DepStamps.push_back(std::make_pair(Filename,
+                                       MgrImpl.getBufferStamp(Filename)));
   }
 
   // Since we only typecheck the primary file (plus referenced constructs
@@ -832,7 +1056,15 @@ ASTUnitRef ASTProducer::createASTUnit(SwiftASTManager::Implementation &MgrImpl,
   // We mirror the compiler and don't set the TypeResolver during SIL
   // processing. This is to avoid unnecessary typechecking that can occur if the
   // TypeResolver is set before.
-  ASTRef->Impl.TypeResolver = createLazyResolver(CompIns.getASTContext());
+  ASTRef->Impl.Shared->TypeResolver =
+    createLazyResolver(CompIns.getASTContext());
+  ASTRef->Impl.PrimarySourceFile = CompIns.getPrimarySourceFile();
+
+  // Let the ASTs of the other files of the module share this one.
+  if (ASTRef->Impl.PrimarySourceFile) {
+    MgrImpl.setModuleAST({ InvokRef->Impl.ModuleKey, Opts.PrimaryFile, ASTRef,
+                           Stamps, DepStamps });
+  }
 
   return ASTRef;
 }
@@ -17,7 +17,9 @@
 #include "SourceKit/Core/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace llvm {
   class MemoryBuffer;
@@ -27,8 +29,10 @@ namespace swift {
   class CompilerInstance;
   class CompilerInvocation;
   class DiagnosticEngine;
+  class Module;
   class SourceFile;
   class SourceManager;
+  class ValueDecl;
 }
 
 namespace SourceKit {
@@ -42,12 +46,27 @@ namespace SourceKit {
   typedef RefPtr<SwiftInvocation> SwiftInvocationRef;
   class EditorDiagConsumer;
 
+/// The printed forms of a declaration that cursor info reports. They only
+/// depend on the declaration, so they stay valid for the lifetime of its AST.
+struct DeclDescription {
+  std::string Name;
+  std::string USR;
+  std::string TypeName;
+  std::string DocComment;
+  std::string AnnotatedDeclaration;
+};
+
 class ASTUnit : public SourceKit::ThreadSafeRefCountedBase<ASTUnit> {
 public:
   struct Implementation;
   Implementation &Impl;
 
   explicit ASTUnit(uint64_t Generation);
+
+  /// Creates an AST for another primary file of the module of \p Other,
+  /// which shares its compiler instance. The modules that the file imports
+  /// are then only loaded once for both ASTs.
+  ASTUnit(uint64_t Generation, const ASTUnit &Other);
   ~ASTUnit();
 
   swift::CompilerInstance &getCompilerInstance() const;
@@ -55,6 +74,11 @@ public:
   ArrayRef<ImmutableTextSnapshotRef> getSnapshots() const;
   EditorDiagConsumer &getEditorDiagConsumer() const;
   swift::SourceFile &getPrimarySourceFile() const;
+
+  /// Returns the description of \p VD, a declaration from this AST, calling
+  /// \p Compute to fill it in the first time it is requested.
+  const DeclDescription &getDeclDescription(const swift::ValueDecl *VD,
+                          std::function<void(DeclDescription &)> Compute) const;
 };
 
 typedef IntrusiveRefCntPtr<ASTUnit> ASTUnitRef;
@@ -114,6 +138,19 @@ public:
 
   void removeCachedAST(SwiftInvocationRef Invok);
 
+  typedef std::vector<std::pair<std::string, uint64_t>> FileStamps;
+
+  /// Records the current stamps of the input files of \p Invocation, except
+  /// \p PrimaryFile, and of the non-system modules imported by \p MainModule,
+  /// so that an AST built from them can later be checked for staleness.
+  void getFileStamps(const swift::CompilerInvocation &Invocation,
+                     swift::Module *MainModule, StringRef PrimaryFile,
+                     FileStamps &Stamps);
+
+  /// Returns true if any of the files in \p Stamps changed since they were
+  /// recorded.
+  bool fileStampsChanged(const FileStamps &Stamps);
+
   struct Implementation;
 
 private:
@@ -13,12 +13,14 @@
 #include "CodeCompletionOrganizer.h"
 #include "SwiftASTManager.h"
 #include "SwiftLangSupport.h"
+#include "SourceKit/Support/FuzzyStringMatcher.h"
 #include "SourceKit/Support/Logging.h"
 #include "SourceKit/Support/UIdent.h"
 
 #include "swift/Frontend/Frontend.h"
 #include "swift/Frontend/PrintingDiagnosticConsumer.h"
 #include "swift/IDE/CodeCompletionCache.h"
+#include "swift/Subsystems.h"
 
 #include "llvm/Support/MemoryBuffer.h"
 
@@ -102,6 +104,175 @@ struct SwiftCodeCompletionConsumer
 };
 } // anonymous namespace
 
+/// The compiler instance of a finished code completion request. Its AST stays
+/// valid for a following request in the same function body, as long as
+/// nothing outside of that body changed.
+struct SourceKit::SwiftCompletionInstance {
+  std::vector<std::string> Args;
+  std::string Filename;
+  /// The text of the primary file, without the code completion marker.
+  std::string Text;
+  /// The function whose body contained the completion point.
+  AbstractFunctionDecl *Function = nullptr;
+  /// The offsets of the braces of the function body in \c Text.
+  unsigned LBraceOffset = 0;
+  unsigned RBraceOffset = 0;
+  /// Every reuse adds a buffer with the new body to the source manager, so
+  /// the instance is rebuilt after a while.
+  unsigned NumReuses = 0;
+  SwiftASTManager::FileStamps Stamps;
+
+  PrintingDiagnosticConsumer PrintDiags;
+  CompilerInvocation Invocation;
+  CompilerInstance CI;
+};
+
+static const unsigned MaxCompletionInstanceReuses = 64;
+
+SwiftCompletionInstanceCache::SwiftCompletionInstanceCache() {}
+SwiftCompletionInstanceCache::~SwiftCompletionInstanceCache() {}
+
+std::unique_ptr<SwiftCompletionInstance> SwiftCompletionInstanceCache::take() {
+  llvm::sys::ScopedLock L(Mtx);
+  return std::move(Instance);
+}
+
+void SwiftCompletionInstanceCache::set(
+    std::unique_ptr<SwiftCompletionInstance> NewInstance) {
+  llvm::sys::ScopedLock L(Mtx);
+  Instance = std::move(NewInstance);
+}
+
+/// Returns the function among \p Decls whose body contains \p Loc, if that
+/// body can be replaced without affecting any other declaration.
+template <typename DeclRange>
+static AbstractFunctionDecl *findReplaceableBody(DeclRange Decls,
+                                                 SourceManager &SM,
+                                                 SourceLoc Loc) {
+  for (Decl *D : Decls) {
+    if (D->isImplicit() || !SM.rangeContainsTokenLoc(D->getSourceRange(), Loc))
+      continue;
+
+    if (auto *NTD = dyn_cast<NominalTypeDecl>(D))
+      return findReplaceableBody(NTD->getMembers(), SM, Loc);
+    if (auto *ED = dyn_cast<ExtensionDecl>(D))
+      return findReplaceableBody(ED->getMembers(), SM, Loc);
+
+    // Accessor bodies are parsed as part of their storage declaration.
+    auto *AFD = dyn_cast<AbstractFunctionDecl>(D);
+    if (!AFD || (isa<FuncDecl>(AFD) && cast<FuncDecl>(AFD)->isAccessor()))
+      return nullptr;
+    BraceStmt *Body = AFD->getBody();
+    if (!Body || !SM.rangeContainsTokenLoc(Body->getSourceRange(), Loc))
+      return nullptr;
+    return AFD;
+  }
+  return nullptr;
+}
+
+/// Remembers the function body around the completion point of \p Inst, after
+/// its AST was built.
+static bool initCompletionInstance(SwiftLangSupport &Lang,
+                                   SwiftCompletionInstance &Inst,
+                                   StringRef Text, unsigned Offset,
+                                   ArrayRef<const char *> Args) {
+  SourceFile *SF = Inst.CI.getPrimarySourceFile();
+  // Top-level code in a main file may refer to variables declared before it,
+  // which could not be resolved from a body in a separate buffer.
+  if (!SF || SF->Kind != SourceFileKind::Library)
+    return false;
+
+  SourceManager &SM = Inst.CI.getSourceMgr();
+  unsigned BufferID = SM.getCodeCompletionBufferID();
+  SourceLoc Loc = SM.getCodeCompletionLoc();
+  Inst.Function = findReplaceableBody(SF->Decls, SM, Loc);
+  if (!Inst.Function)
+    return false;
+
+  BraceStmt *Body = Inst.Function->getBody();
+  Inst.LBraceOffset = SM.getLocOffsetInBuffer(Body->getLBraceLoc(), BufferID);
+  // Skip the code completion marker before the '}'.
+  Inst.RBraceOffset =
+      SM.getLocOffsetInBuffer(Body->getRBraceLoc(), BufferID) - 1;
+  if (Inst.LBraceOffset >= Offset || Inst.RBraceOffset < Offset)
+    return false;
+
+  for (auto Arg : Args)
+    Inst.Args.push_back(Arg);
+  Inst.Filename = SF->getFilename();
+  Inst.Text = Text;
+  Lang.getASTManager().getFileStamps(Inst.Invocation, Inst.CI.getMainModule(),
+                                     Inst.Filename, Inst.Stamps);
+  return true;
+}
+
+/// Runs code completion by re-parsing only the function body around the
+/// completion point in the AST of \p Inst.
+///
+/// \returns false if the AST can't be reused, because something outside of
+/// the function body changed.
+static bool
+reuseCompletionInstance(SwiftLangSupport &Lang, SwiftCompletionInstance &Inst,
+                        StringRef Filename, StringRef Text, unsigned Offset,
+                        ArrayRef<const char *> Args,
+                        SwiftCodeCompletionConsumer &SwiftConsumer,
+                        ide::CodeCompletionContext &CompletionContext,
+                        CodeCompletionCallbacksFactory &Factory) {
+  if (Inst.NumReuses >= MaxCompletionInstanceReuses ||
+      Inst.Filename != Filename || Inst.Args.size() != Args.size() ||
+      !std::equal(Args.begin(), Args.end(), Inst.Args.begin()))
+    return false;
+
+  // Everything up to and including the '{', and from the '}' on, has to be
+  // unchanged.
+  StringRef OldText = Inst.Text;
+  StringRef Prefix = OldText.substr(0, Inst.LBraceOffset + 1);
+  StringRef Suffix = OldText.substr(Inst.RBraceOffset);
+  if (Text.size() < Prefix.size() + Suffix.size() ||
+      !Text.startswith(Prefix) || !Text.endswith(Suffix))
+    return false;
+  unsigned RBraceOffset = Text.size() - Suffix.size();
+  if (Offset <= Inst.LBraceOffset || Offset > RBraceOffset)
+    return false;
+
+  if (Lang.getASTManager().fileStampsChanged(Inst.Stamps))
+    return false;
+
+  // Put the new body, with the code completion marker, in a buffer of its
+  // own.
+  StringRef Body = Text.slice(Inst.LBraceOffset, RBraceOffset + 1);
+  unsigned BodyOffset = Offset - Inst.LBraceOffset;
+  std::string BodyText;
+  BodyText.reserve(Body.size() + 1);
+  BodyText.append(Body.data(), BodyOffset);
+  BodyText += '\0';
+  BodyText.append(Body.data() + BodyOffset, Body.size() - BodyOffset);
+
+  SourceManager &SM = Inst.CI.getSourceMgr();
+  unsigned BufferID = SM.addMemBufferCopy(BodyText, Filename);
+  SM.setCodeCompletionPoint(BufferID, BodyOffset);
+  SourceLoc LBraceLoc = SM.getLocForOffset(BufferID, 0);
+  SourceLoc RBraceLoc = SM.getLocForOffset(BufferID, BodyText.size() - 1);
+
+  Inst.Invocation.setCodeCompletionFactory(&Factory);
+  CloseClangModuleFiles scopedCloseFiles(
+      *Inst.CI.getASTContext().getClangModuleLoader());
+  SwiftConsumer.setContext(&Inst.CI.getASTContext(), &Inst.Invocation,
+                           &CompletionContext);
+  bool Failed = reparseFunctionBody(Inst.Function, LBraceLoc, RBraceLoc,
+                                    &Factory);
+  SwiftConsumer.clearContext();
+  Inst.Invocation.setCodeCompletionFactory(nullptr);
+  if (Failed)
+    return false;
+
+  Inst.Text = Text;
+  Inst.RBraceOffset = RBraceOffset;
+  ++Inst.NumReuses;
+  trace::incrementCounter("completion.ast.reuse");
+  return true;
+}
+
 static bool swiftCodeCompleteImpl(SwiftLangSupport &Lang,
                                   llvm::MemoryBuffer *UnresolvedInputFile,
                                   unsigned Offset,
@@ -131,22 +302,6 @@ static bool swiftCodeCompleteImpl(SwiftLangSupport &Lang,
       UnresolvedInputFile->getBuffer(),
       Lang.resolvePathSymlinks(UnresolvedInputFile->getBufferIdentifier()));
 
-  CompilerInstance CI;
-  // Display diagnostics to stderr.
-  PrintingDiagnosticConsumer PrintDiags;
-  CI.addDiagnosticConsumer(&PrintDiags);
-
-  CompilerInvocation Invocation;
-  bool Failed = Lang.getASTManager().initCompilerInvocation(
-      Invocation, Args, CI.getDiags(), InputFile->getBufferIdentifier(), Error);
-  if (Failed) {
-    return false;
-  }
-  if (Invocation.getInputFilenames().empty()) {
-    Error = "no input filenames specified";
-    return false;
-  }
-
   auto origBuffSize = InputFile->getBufferSize();
   unsigned CodeCompletionOffset = Offset;
   if (CodeCompletionOffset > origBuffSize) {
@@ -162,8 +317,6 @@ static bool swiftCodeCompleteImpl(SwiftLangSupport &Lang,
   *NewPos = '\0';
   std::copy(Position, InputFile->getBufferEnd(), NewPos+1);
 
-  Invocation.setCodeCompletionPoint(NewBuffer.get(), CodeCompletionOffset);
-
   auto swiftCache = Lang.getCodeCompletionCache(); // Pin the cache.
   ide::CodeCompletionContext CompletionContext(swiftCache->getCache());
 
@@ -173,6 +326,37 @@ static bool swiftCodeCompleteImpl(SwiftLangSupport &Lang,
       ide::makeCodeCompletionCallbacksFactory(CompletionContext,
                                               SwiftConsumer));
 
+  // If the previous request was in the same function body, and nothing else
+  // changed since, only that body has to be parsed and type-checked again.
+  SwiftCompletionInstanceCache &Instances = Lang.getCodeCompletionInstances();
+  std::unique_ptr<SwiftCompletionInstance> Inst = Instances.take();
+  if (Inst && reuseCompletionInstance(Lang, *Inst,
+                                      InputFile->getBufferIdentifier(),
+                                      InputFile->getBuffer(),
+                                      CodeCompletionOffset, Args,
+                                      SwiftConsumer, CompletionContext,
+                                      *CompletionCallbacksFactory)) {
+    Instances.set(std::move(Inst));
+    return true;
+  }
+
+  Inst.reset(new SwiftCompletionInstance());
+  CompilerInstance &CI = Inst->CI;
+  // Display diagnostics to stderr.
+  CI.addDiagnosticConsumer(&Inst->PrintDiags);
+
+  CompilerInvocation &Invocation = Inst->Invocation;
+  bool Failed = Lang.getASTManager().initCompilerInvocation(
+      Invocation, Args, CI.getDiags(), InputFile->getBufferIdentifier(), Error);
+  if (Failed) {
+    return false;
+  }
+  if (Invocation.getInputFilenames().empty()) {
+    Error = "no input filenames specified";
+    return false;
+  }
+
+  Invocation.setCodeCompletionPoint(NewBuffer.get(), CodeCompletionOffset);
   Invocation.setCodeCompletionFactory(CompletionCallbacksFactory.get());
 
   // FIXME: We need to be passing the buffers from the open documents.
@@ -210,6 +394,11 @@ static bool swiftCodeCompleteImpl(SwiftLangSupport &Lang,
                            &CompletionContext);
   CI.performSema();
   SwiftConsumer.clearContext();
+  Invocation.setCodeCompletionFactory(nullptr);
+
+  if (initCompletionInstance(Lang, *Inst, InputFile->getBuffer(),
+                             CodeCompletionOffset, Args))
+    Instances.set(std::move(Inst));
   return true;
 }
 
@@ -646,6 +835,23 @@ ArrayRef<Completion *> CodeCompletion::SessionCache::getSortedCompletions() {
   llvm::sys::ScopedLock L(mtx);
   return sortedCompletions;
 }
+std::vector<Completion *>
+CodeCompletion::SessionCache::getCompletionsMatching(StringRef filterText) {
+  llvm::sys::ScopedLock L(mtx);
+  ArrayRef<Completion *> candidates = sortedCompletions;
+  if (!lastFilterText.empty() && filterText.startswith_lower(lastFilterText))
+    candidates = lastFilterMatches;
+
+  FuzzyStringMatcher pattern(filterText);
+  std::vector<Completion *> matches;
+  for (Completion *completion : candidates)
+    if (pattern.matchesCandidate(completion->getName()))
+      matches.push_back(completion);
+
+  lastFilterText = filterText;
+  lastFilterMatches = matches;
+  return matches;
+}
 llvm::MemoryBuffer *CodeCompletion::SessionCache::getBuffer() {
   llvm::sys::ScopedLock L(mtx);
   return buffer.get();
@@ -848,8 +1054,13 @@ static void transformAndForwardResults(
       session->getCompletionKind() == CompletionKind::PostfixExpr;
 
   if (!hasEarlyInnerResults) {
-    organizer.addCompletionsWithFilter(session->getSortedCompletions(),
-                                       filterText, exactMatch);
+    if (filterText.empty()) {
+      organizer.addCompletionsWithFilter(session->getSortedCompletions(),
+                                         filterText, exactMatch);
+    } else {
+      organizer.addCompletionsWithFilter(
+          session->getCompletionsMatching(filterText), filterText, exactMatch);
+    }
   }
 
   if (hasEarlyInnerResults &&
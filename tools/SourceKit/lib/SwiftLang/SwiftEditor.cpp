@@ -1351,15 +1351,25 @@ public:
 
     ++NestingLevel;
     SourceLoc StartLoc = Node.Range.getStart();
+    unsigned Offset = SrcManager.getByteDistance(
+                           SrcManager.getLocForBufferStart(BufferID), StartLoc);
+    // Note that the length can span multiple lines.
+    unsigned Length = Node.Range.getByteLength();
+
+    // Most nodes are outside of the affected range after an edit; skip them
+    // before paying for the line and column lookups.
+    if (EditedLineRange.isValid()) {
+      if (Offset + Length <= AffectedRange.first)
+        return true;
+      if (Offset > AffectedRange.first + AffectedRange.second)
+        return true;
+    }
+
     auto StartLineAndColumn = SrcManager.getLineAndColumn(StartLoc);
     auto EndLineAndColumn = SrcManager.getLineAndColumn(Node.Range.getEnd());
     unsigned StartLine = StartLineAndColumn.first;
     unsigned EndLine = EndLineAndColumn.second > 1 ? EndLineAndColumn.first
                                                    : EndLineAndColumn.first - 1;
-    unsigned Offset = SrcManager.getByteDistance(
-                           SrcManager.getLocForBufferStart(BufferID), StartLoc);
-    // Note that the length can span multiple lines.
-    unsigned Length = Node.Range.getByteLength();
 
     SwiftSyntaxToken Token(StartLineAndColumn.second, Length,
                            Node.Kind);
@@ -2846,7 +2856,7 @@ void SwiftLangSupport::editorOpen(StringRef Name, llvm::MemoryBuffer *Buf,
 void SwiftLangSupport::editorClose(StringRef Name, bool RemoveCache) {
   auto Removed = EditorDocuments.remove(Name);
   if (!Removed)
-    IFaceGenContexts.remove(Name);
+    IFaceGenContexts.remove(Name, /*KeepForReuse=*/!RemoveCache);
   if (Removed && RemoveCache)
     Removed->removeCachedAST();
   // FIXME: Report error if Name did not apply to anything ?
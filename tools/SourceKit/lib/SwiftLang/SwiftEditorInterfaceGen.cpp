@@ -23,6 +23,7 @@
 #include "swift/IDE/Utils.h"
 #include "swift/Strings.h"
 
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/ConvertUTF.h"
 
@@ -76,6 +77,9 @@ public:
   PrintingDiagnosticConsumer DiagConsumer;
   CompilerInstance Instance;
   Module *Mod = nullptr;
+  /// The files of Mod with their modification times when the interface was
+  /// generated.
+  std::vector<std::pair<std::string, llvm::sys::TimeValue>> ModuleFiles;
   SourceTextInfo Info;
   // This is the non-typechecked AST for the generated interface source.
   CompilerInstance TextCI;
@@ -280,6 +284,16 @@ static bool getModuleInterfaceInfo(ASTContext &Ctx,
     }
   }
 
+  for (FileUnit *File : Mod->getFiles()) {
+    auto *Loaded = dyn_cast<LoadedFile>(File);
+    if (!Loaded || Loaded->getFilename().empty())
+      continue;
+    llvm::sys::fs::file_status Status;
+    if (!llvm::sys::fs::status(Loaded->getFilename(), Status))
+      Impl.ModuleFiles.emplace_back(Loaded->getFilename(),
+                                    Status.getLastModificationTime());
+  }
+
   PrintOptions Options = PrintOptions::printInterface();
   ModuleTraversalOptions TraversalOptions = None; // Don't print submodules.
   SmallString<128> Text;
@@ -409,6 +423,10 @@ StringRef SwiftInterfaceGenContext::getDocumentName() const {
   return Impl.DocumentName;
 }
 
+void SwiftInterfaceGenContext::setDocumentName(StringRef DocumentName) {
+  Impl.DocumentName = DocumentName;
+}
+
 StringRef SwiftInterfaceGenContext::getModuleOrHeaderName() const {
   return Impl.ModuleOrHeaderName;
 }
@@ -450,6 +468,18 @@ bool SwiftInterfaceGenContext::matches(StringRef ModuleName,
   return true;
 }
 
+bool SwiftInterfaceGenContext::isUpToDate() const {
+  if (!Impl.Mod)
+    return false;
+  for (auto &File : Impl.ModuleFiles) {
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(File.first, Status) ||
+        Status.getLastModificationTime() != File.second)
+      return false;
+  }
+  return true;
+}
+
 void SwiftInterfaceGenContext::reportEditorInfo(EditorConsumer &Consumer) const {
   Consumer.handleSourceText(Impl.Info.Text);
   reportSyntacticAnnotations(Impl.TextCI, Consumer);
@@ -526,9 +556,18 @@ void SwiftInterfaceGenMap::set(StringRef Name,
   IFaceGens[Name] = IFaceGen;
 }
 
-bool SwiftInterfaceGenMap::remove(StringRef Name) {
+bool SwiftInterfaceGenMap::remove(StringRef Name, bool KeepForReuse) {
   llvm::sys::ScopedLock L(Mtx);
-  return IFaceGens.erase(Name);
+  auto It = IFaceGens.find(Name);
+  if (It == IFaceGens.end())
+    return false;
+  if (KeepForReuse && It->second->isUpToDate()) {
+    if (Closed.size() == MaxClosed)
+      Closed.erase(Closed.begin());
+    Closed.push_back(It->second);
+  }
+  IFaceGens.erase(It);
+  return true;
 }
 
 SwiftInterfaceGenContextRef
@@ -542,6 +581,22 @@ SwiftInterfaceGenMap::find(StringRef ModuleName,
   return nullptr;
 }
 
+SwiftInterfaceGenContextRef
+SwiftInterfaceGenMap::takeClosed(StringRef ModuleName,
+                                 const CompilerInvocation &Invok) {
+  llvm::sys::ScopedLock L(Mtx);
+  for (auto It = Closed.rbegin(), End = Closed.rend(); It != End; ++It) {
+    if (!(*It)->matches(ModuleName, Invok))
+      continue;
+    SwiftInterfaceGenContextRef IFaceGen = *It;
+    Closed.erase(std::next(It).base());
+    if (!IFaceGen->isUpToDate())
+      return nullptr;
+    return IFaceGen;
+  }
+  return nullptr;
+}
+
 //============================================================================//
 // EditorOpenInterface
 //============================================================================//
@@ -576,15 +631,22 @@ void SwiftLangSupport::editorOpenInterface(EditorConsumer &Consumer,
 
   Invocation.getClangImporterOptions().ImportForwardDeclarations = true;
 
-  std::string ErrMsg;
-  auto IFaceGenRef = SwiftInterfaceGenContext::create(Name,
-                                                      /*IsModule=*/true,
-                                                      ModuleName,
-                                                      Invocation,
-                                                      ErrMsg);
-  if (!IFaceGenRef) {
-    Consumer.handleRequestError(ErrMsg.c_str());
-    return;
+  // Reopening a module interface which was closed is common, such as when
+  // jumping to definitions in the SDK; reuse it unless the module changed.
+  auto IFaceGenRef = IFaceGenContexts.takeClosed(ModuleName, Invocation);
+  if (IFaceGenRef) {
+    IFaceGenRef->setDocumentName(Name);
+  } else {
+    std::string ErrMsg;
+    IFaceGenRef = SwiftInterfaceGenContext::create(Name,
+                                                   /*IsModule=*/true,
+                                                   ModuleName,
+                                                   Invocation,
+                                                   ErrMsg);
+    if (!IFaceGenRef) {
+      Consumer.handleRequestError(ErrMsg.c_str());
+      return;
+    }
   }
 
   IFaceGenContexts.set(Name, IFaceGenRef);
@@ -26,6 +26,7 @@
 
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -267,6 +268,8 @@ private:
 
   void getModuleHash(SourceFileOrModule SFOrMod, llvm::raw_ostream &OS);
   llvm::hash_code hashModule(llvm::hash_code code, SourceFileOrModule SFOrMod);
+  llvm::hash_code hashFileReference(llvm::hash_code code,
+                                    SourceFileOrModule SFOrMod);
   void getRecursiveModuleImports(Module &Mod,
                                  SmallVectorImpl<Module *> &Imports);
   void collectRecursiveModuleImports(Module &Mod,
@@ -274,6 +277,12 @@ private:
 
   // This maps a module to all its imports, recursively.
   llvm::DenseMap<Module *, llvm::SmallVector<Module *, 4>> ImportsMap;
+
+  // Every dependency's hash covers its own recursive imports, so the same
+  // modules get hashed and their files stat'ed many times per request.
+  llvm::DenseMap<Module *, llvm::hash_code> ModuleHashes;
+  llvm::StringMap<std::pair<std::error_code, llvm::sys::fs::file_status>>
+      FileStatuses;
 };
 } // anonymous namespace
 
@@ -816,16 +825,22 @@ bool IndexSwiftASTWalker::initCallRefEntityInfo(Expr *CurrentE, Expr *ParentE,
   return false;
 }
 
-static llvm::hash_code hashFileReference(llvm::hash_code code,
-                                         SourceFileOrModule SFOrMod) {
+llvm::hash_code
+IndexSwiftASTWalker::hashFileReference(llvm::hash_code code,
+                                       SourceFileOrModule SFOrMod) {
   StringRef Filename = SFOrMod.getFilename();
   if (Filename.empty())
     return code;
 
   // FIXME: FileManager for swift ?
 
-  llvm::sys::fs::file_status Status;
-  if (std::error_code Ret = llvm::sys::fs::status(Filename, Status)) {
+  auto Inserted = FileStatuses.insert({ Filename, {} });
+  auto &StatusEntry = Inserted.first->getValue();
+  if (Inserted.second)
+    StatusEntry.first = llvm::sys::fs::status(Filename, StatusEntry.second);
+
+  const llvm::sys::fs::file_status &Status = StatusEntry.second;
+  if (std::error_code Ret = StatusEntry.first) {
     // Failure to read the file, just use filename to recover.
     LOG_WARN_FUNC("failed to stat file: " << Filename
                   << " (" << Ret.message() << ')');
@@ -950,7 +965,18 @@ void IndexSwiftASTWalker::collectRecursiveModuleImports(
 void IndexSwiftASTWalker::getModuleHash(SourceFileOrModule Mod,
                                         llvm::raw_ostream &OS) {
   // FIXME: Use a longer hash string to minimize possibility for conflicts.
-  llvm::hash_code code = hashModule(0, Mod);
+  llvm::hash_code code;
+  if (Module *M = Mod.getAsModule()) {
+    auto Found = ModuleHashes.find(M);
+    if (Found != ModuleHashes.end()) {
+      code = Found->second;
+    } else {
+      code = hashModule(0, Mod);
+      ModuleHashes.insert({ M, code });
+    }
+  } else {
+    code = hashModule(0, Mod);
+  }
   OS << llvm::APInt(64, code).toString(36, /*Signed=*/false);
 }
 
@@ -47,11 +47,18 @@ public:
   ~SwiftInterfaceGenContext();
 
   StringRef getDocumentName() const;
+  /// Renames the document; only valid while no open document refers to this
+  /// context.
+  void setDocumentName(StringRef DocumentName);
   StringRef getModuleOrHeaderName() const;
   bool isModule() const;
 
   bool matches(StringRef ModuleName, const swift::CompilerInvocation &Invok);
 
+  /// Returns true if the interface was generated for a module, rather than
+  /// a source file or header, and none of the module's files changed since.
+  bool isUpToDate() const;
+
   void reportEditorInfo(EditorConsumer &Consumer) const;
 
   struct ResolvedEntity {
@@ -25,6 +25,7 @@
 #include "llvm/Support/Mutex.h"
 #include <map>
 #include <string>
+#include <vector>
 
 namespace swift {
   class ASTContext;
@@ -137,6 +138,10 @@ class SessionCache : public ThreadSafeRefCountedBase<SessionCache> {
   CompletionSink sink;
   std::vector<Completion *> sortedCompletions;
   CompletionKind completionKind;
+  /// The filter text of the previous \c getCompletionsMatching call and the
+  /// completions that matched it.
+  std::string lastFilterText;
+  std::vector<Completion *> lastFilterMatches;
   llvm::sys::Mutex mtx;
 
 public:
@@ -147,6 +152,11 @@ public:
         completionKind(completionKind) {}
   void setSortedCompletions(std::vector<Completion *> &&completions);
   ArrayRef<Completion *> getSortedCompletions();
+  /// Returns the sorted completions that fuzzily match \p filterText. This is
+  /// a superset of what any filtering mode accepts. Typing more characters
+  /// only narrows the set, so when \p filterText extends the previous filter
+  /// text only the previous matches are checked again.
+  std::vector<Completion *> getCompletionsMatching(StringRef filterText);
   llvm::MemoryBuffer *getBuffer();
   ArrayRef<std::string> getCompilerArgs();
   CompletionKind getCompletionKind();
@@ -173,14 +183,25 @@ public:
 
 class SwiftInterfaceGenMap {
   llvm::StringMap<SwiftInterfaceGenContextRef> IFaceGens;
+  /// Recently closed module interfaces, oldest first, which can be reopened
+  /// without generating them again.
+  std::vector<SwiftInterfaceGenContextRef> Closed;
   mutable llvm::sys::Mutex Mtx;
 
+  static const unsigned MaxClosed = 4;
+
 public:
   SwiftInterfaceGenContextRef get(StringRef Name) const;
   void set(StringRef Name, SwiftInterfaceGenContextRef IFaceGen);
-  bool remove(StringRef Name);
+  /// Removes the document \p Name. If \p KeepForReuse is true and it is an
+  /// up to date module interface, it is kept for takeClosed().
+  bool remove(StringRef Name, bool KeepForReuse = false);
   SwiftInterfaceGenContextRef find(StringRef ModuleName,
                                    const swift::CompilerInvocation &Invok);
+  /// Returns an up to date closed interface of \p ModuleName generated with a
+  /// matching invocation, and forgets it, or null if there is none.
+  SwiftInterfaceGenContextRef takeClosed(StringRef ModuleName,
+                                         const swift::CompilerInvocation &Invok);
 };
 
 struct SwiftCompletionCache
@@ -192,6 +213,25 @@ struct SwiftCompletionCache
   ~SwiftCompletionCache();
 };
 
+struct SwiftCompletionInstance;
+
+/// Keeps the compiler instance of the most recent code completion request, so
+/// that a following request inside the same function body only has to parse
+/// and type-check that body again.
+class SwiftCompletionInstanceCache {
+  llvm::sys::Mutex Mtx;
+  std::unique_ptr<SwiftCompletionInstance> Instance;
+
+public:
+  SwiftCompletionInstanceCache();
+  ~SwiftCompletionInstanceCache();
+
+  /// Takes the cached instance, if any, so that only one request at a time
+  /// uses it.
+  std::unique_ptr<SwiftCompletionInstance> take();
+  void set(std::unique_ptr<SwiftCompletionInstance> NewInstance);
+};
+
 struct SwiftPopularAPI : public ThreadSafeRefCountedBase<SwiftPopularAPI> {
   llvm::StringMap<CodeCompletion::PopularityFactor> nameToFactor;
 };
@@ -208,6 +248,7 @@ class SwiftLangSupport : public LangSupport {
   SwiftEditorDocumentFileMap EditorDocuments;
   SwiftInterfaceGenMap IFaceGenContexts;
   ThreadSafeRefCntPtr<SwiftCompletionCache> CCCache;
+  SwiftCompletionInstanceCache CCInstances;
   ThreadSafeRefCntPtr<SwiftPopularAPI> PopularAPI;
   CodeCompletion::SessionCacheMap CCSessions;
   ThreadSafeRefCntPtr<SwiftCustomCompletions> CustomCompletions;
@@ -227,6 +268,9 @@ public:
   IntrusiveRefCntPtr<SwiftCompletionCache> getCodeCompletionCache() {
     return CCCache;
   }
+  SwiftCompletionInstanceCache &getCodeCompletionInstances() {
+    return CCInstances;
+  }
 
   static SourceKit::UIdent getUIDForDecl(const swift::Decl *D,
                                          bool IsRef = false);
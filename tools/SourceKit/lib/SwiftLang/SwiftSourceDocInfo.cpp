@@ -222,7 +222,11 @@ static bool passCursorInfoForModule(ModuleEntity Mod,
 }
 
 /// Returns true for failure to resolve.
+///
+/// \param AST The AST that \p VD comes from, used to cache its description,
+/// or null if it doesn't come from an ASTUnit.
 static bool passCursorInfoForDecl(const ValueDecl *VD,
+                                  const ASTUnit *AST,
                                   const Module *MainModule,
                                   const Type Ty,
                                   bool IsRef,
@@ -234,42 +238,37 @@ static bool passCursorInfoForDecl(const ValueDecl *VD,
   if (AvailableAttr::isUnavailable(VD))
     return true;
 
-  SmallString<64> SS;
-
-  unsigned NameBegin = SS.size();
-  {
-    llvm::raw_svector_ostream OS(SS);
-    SwiftLangSupport::printDisplayName(VD, OS);
-  }
-  unsigned NameEnd = SS.size();
-
-  unsigned USRBegin = SS.size();
-  {
-    llvm::raw_svector_ostream OS(SS);
-    SwiftLangSupport::printUSR(VD, OS);
-  }
-  unsigned USREnd = SS.size();
-
-  unsigned TypenameBegin = SS.size();
-  if (VD->hasType()) {
-    llvm::raw_svector_ostream OS(SS);
-    VD->getType().print(OS);
-  }
-  unsigned TypenameEnd = SS.size();
+  auto describeDecl = [&](DeclDescription &Desc) {
+    {
+      llvm::raw_string_ostream OS(Desc.Name);
+      SwiftLangSupport::printDisplayName(VD, OS);
+    }
+    {
+      llvm::raw_string_ostream OS(Desc.USR);
+      SwiftLangSupport::printUSR(VD, OS);
+    }
+    if (VD->hasType()) {
+      llvm::raw_string_ostream OS(Desc.TypeName);
+      VD->getType().print(OS);
+    }
+    {
+      llvm::raw_string_ostream OS(Desc.DocComment);
+      ide::getDocumentationCommentAsXML(VD, OS);
+    }
+    {
+      llvm::raw_string_ostream OS(Desc.AnnotatedDeclaration);
+      printAnnotatedDeclaration(VD, OS);
+    }
+  };
 
-  unsigned DocCommentBegin = SS.size();
-  {
-    llvm::raw_svector_ostream OS(SS);
-    ide::getDocumentationCommentAsXML(VD, OS);
-  }
-  unsigned DocCommentEnd = SS.size();
+  DeclDescription UncachedDesc;
+  const DeclDescription *Desc = &UncachedDesc;
+  if (AST)
+    Desc = &AST->getDeclDescription(VD, describeDecl);
+  else
+    describeDecl(UncachedDesc);
 
-  unsigned DeclBegin = SS.size();
-  {
-    llvm::raw_svector_ostream OS(SS);
-    printAnnotatedDeclaration(VD, OS);
-  }
-  unsigned DeclEnd = SS.size();
+  SmallString<64> SS;
 
   SmallVector<std::pair<unsigned, unsigned>, 4> OverUSROffs;
 
@@ -341,14 +340,6 @@ static bool passCursorInfoForDecl(const ValueDecl *VD,
     ModuleInterfaceName = IFaceGenRef->getDocumentName();
 
   UIdent Kind = SwiftLangSupport::getUIDForDecl(VD, IsRef);
-  StringRef Name = StringRef(SS.begin()+NameBegin, NameEnd-NameBegin);
-  StringRef USR = StringRef(SS.begin()+USRBegin, USREnd-USRBegin);
-  StringRef TypeName = StringRef(SS.begin()+TypenameBegin,
-                                 TypenameEnd-TypenameBegin);
-  StringRef DocComment = StringRef(SS.begin()+DocCommentBegin,
-                                   DocCommentEnd-DocCommentBegin);
-  StringRef AnnotatedDecl = StringRef(SS.begin()+DeclBegin,
-                                      DeclEnd-DeclBegin);
 
   llvm::Optional<std::pair<unsigned, unsigned>> DeclarationLoc;
   StringRef Filename;
@@ -379,11 +370,11 @@ static bool passCursorInfoForDecl(const ValueDecl *VD,
 
   CursorInfo Info;
   Info.Kind = Kind;
-  Info.Name = Name;
-  Info.USR = USR;
-  Info.TypeName = TypeName;
-  Info.DocComment = DocComment;
-  Info.AnnotatedDeclaration = AnnotatedDecl;
+  Info.Name = Desc->Name;
+  Info.USR = Desc->USR;
+  Info.TypeName = Desc->TypeName;
+  Info.DocComment = Desc->DocComment;
+  Info.AnnotatedDeclaration = Desc->AnnotatedDeclaration;
   Info.ModuleName = ModuleName;
   Info.ModuleInterfaceName = ModuleInterfaceName;
   Info.DeclarationLoc = DeclarationLoc;
@@ -516,7 +507,8 @@ static void resolveCursor(SwiftLangSupport &Lang,
                                 CompInvok, Receiver);
       } else {
         ValueDecl *VD = SemaTok.CtorTyRef ? SemaTok.CtorTyRef : SemaTok.ValueD;
-        bool Failed = passCursorInfoForDecl(VD, MainModule, SemaTok.Ty,
+        bool Failed = passCursorInfoForDecl(VD, AstUnit.get(), MainModule,
+                                            SemaTok.Ty,
                                             SemaTok.IsRef, BufferID, Lang,
                                             CompInvok, PreviousASTSnaps,
                                             Receiver);
@@ -581,7 +573,8 @@ void SwiftLangSupport::getCursorInfo(
       } else {
         // FIXME: Should pass the main module for the interface but currently
         // it's not necessary.
-        passCursorInfoForDecl(Entity.Dcl, /*MainModule*/nullptr, Type(),
+        passCursorInfoForDecl(Entity.Dcl, /*AST=*/nullptr,
+                              /*MainModule*/nullptr, Type(),
                               Entity.IsRef,
                               /*OrigBufferID=*/None, *this, Invok,
                               {}, Receiver);
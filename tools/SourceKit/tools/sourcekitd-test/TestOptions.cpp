@@ -211,6 +211,10 @@ bool TestOptions::parseArgs(llvm::ArrayRef<const char *> Args) {
       JsonRequestPath = InputArg->getValue();
       break;
 
+    case OPT_replay:
+      ReplayPath = InputArg->getValue();
+      break;
+
     case OPT_UNKNOWN:
       llvm::errs() << "error: unknown argument: "
                    << InputArg->getAsString(ParsedArgs) << '\n';
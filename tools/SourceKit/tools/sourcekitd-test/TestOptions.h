@@ -52,6 +52,7 @@ struct TestOptions {
   std::string SourceFile;
   std::string TextInputFile;
   std::string JsonRequestPath;
+  std::string ReplayPath;
   llvm::Optional<std::string> SourceText;
   unsigned Line = 0;
   unsigned Col = 0;
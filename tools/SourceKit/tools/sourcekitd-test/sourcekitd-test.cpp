@@ -18,13 +18,19 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/FileSystem.h"
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <map>
+#include <tuple>
 #include <unistd.h>
 #include <sys/param.h>
+#include <sys/resource.h>
 
 // FIXME: Platform compatibility.
 #include <dispatch/dispatch.h>
@@ -66,6 +72,10 @@ static void notification_receiver(sourcekitd_response_t resp);
 
 static SourceKitRequest ActiveRequest = SourceKitRequest::None;
 
+/// Set while replaying a recorded session, whose requests already include
+/// the ones that editors send in response to notifications.
+static bool IsReplaying = false;
+
 static sourcekitd_uid_t KeyRequest;
 static sourcekitd_uid_t KeyCompilerArgs;
 static sourcekitd_uid_t KeyOffset;
@@ -307,6 +317,163 @@ static int handleJsonRequestPath(StringRef QueryPath) {
   return Error ? 1 : 0;
 }
 
+namespace {
+/// One request of a session recorded with SOURCEKIT_RECORD_REQUESTS.
+struct RecordedRequest {
+  uint64_t StartUs = 0;
+  uint64_t LatencyUs = 0;
+  /// The request kind, such as "source.request.cursorinfo".
+  std::string Kind;
+  std::string YAML;
+};
+
+/// The latencies of the replayed requests of one kind, in microseconds.
+struct ReplayStats {
+  std::vector<uint64_t> Latencies;
+  std::vector<uint64_t> RecordedLatencies;
+  unsigned Errors = 0;
+};
+} // end anonymous namespace
+
+/// Splits \p Trace into its requests, each of which starts with a line of
+/// the form "--- # start_us: <N> latency_us: <N>", and sorts them by the
+/// time they arrived.
+static bool parseRecordedRequests(StringRef Trace,
+                                  std::vector<RecordedRequest> &Requests) {
+  RecordedRequest *Current = nullptr;
+  unsigned LineNo = 0;
+  while (!Trace.empty()) {
+    StringRef Line;
+    std::tie(Line, Trace) = Trace.split('\n');
+    ++LineNo;
+    if (!Line.startswith("---")) {
+      if (!Current) {
+        if (Line.trim().empty())
+          continue;
+        llvm::errs() << "error: line " << LineNo
+                     << ": expected '---' before the first request\n";
+        return true;
+      }
+      Current->YAML += Line;
+      Current->YAML += '\n';
+
+      StringRef Entry = Line.trim();
+      StringRef RequestKey = "key.request:";
+      if (Entry.startswith(RequestKey))
+        Current->Kind = Entry.drop_front(RequestKey.size()).rtrim(',').trim();
+      continue;
+    }
+
+    Requests.emplace_back();
+    Current = &Requests.back();
+    SmallVector<StringRef, 8> Fields;
+    Line.split(Fields, " ", -1, /*KeepEmpty=*/false);
+    for (unsigned i = 0; i + 1 < Fields.size(); ++i) {
+      if (Fields[i] == "start_us:")
+        Fields[i+1].getAsInteger(10, Current->StartUs);
+      else if (Fields[i] == "latency_us:")
+        Fields[i+1].getAsInteger(10, Current->LatencyUs);
+    }
+  }
+
+  std::stable_sort(Requests.begin(), Requests.end(),
+                   [](const RecordedRequest &LHS, const RecordedRequest &RHS) {
+    return LHS.StartUs < RHS.StartUs;
+  });
+  return false;
+}
+
+/// Returns the \p Percent percentile of \p Sorted, by the nearest-rank
+/// method.
+static uint64_t getPercentile(ArrayRef<uint64_t> Sorted, unsigned Percent) {
+  if (Sorted.empty())
+    return 0;
+  size_t Rank = (Sorted.size() * Percent + 99) / 100;
+  return Sorted[std::max<size_t>(Rank, 1) - 1];
+}
+
+/// Returns the peak resident set size of this process in KiB, which includes
+/// the service when sourcekitd runs in process.
+static uint64_t getPeakMemoryKiB() {
+  struct rusage Usage;
+  if (getrusage(RUSAGE_SELF, &Usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return Usage.ru_maxrss / 1024;
+#else
+  return Usage.ru_maxrss;
+#endif
+}
+
+/// Sends the requests of a recorded session one after another, in the order
+/// they arrived, and prints the latency percentiles of each request kind.
+static int handleReplay(StringRef TracePath) {
+  std::vector<RecordedRequest> Requests;
+  if (parseRecordedRequests(getBufferForFilename(TracePath)->getBuffer(),
+                            Requests))
+    return 1;
+
+  IsReplaying = true;
+  std::map<std::string, ReplayStats> Stats;
+  for (unsigned i = 0, e = Requests.size(); i != e; ++i) {
+    const RecordedRequest &Recorded = Requests[i];
+    char *Err = nullptr;
+    sourcekitd_object_t Req =
+        sourcekitd_request_create_from_yaml(Recorded.YAML.c_str(), &Err);
+    if (!Req) {
+      llvm::errs() << "error: cannot read request " << i << " of '"
+                   << TracePath << "': " << Err << '\n';
+      free(Err);
+      return 1;
+    }
+
+    auto Start = std::chrono::steady_clock::now();
+    sourcekitd_response_t Resp = sourcekitd_send_request_sync(Req);
+    auto Elapsed = std::chrono::steady_clock::now() - Start;
+
+    ReplayStats &KindStats =
+        Stats[Recorded.Kind.empty() ? "<unknown request>" : Recorded.Kind];
+    KindStats.Latencies.push_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(Elapsed)
+            .count());
+    KindStats.RecordedLatencies.push_back(Recorded.LatencyUs);
+    if (sourcekitd_response_is_error(Resp))
+      ++KindStats.Errors;
+    sourcekitd_response_dispose(Resp);
+    sourcekitd_request_release(Req);
+  }
+  IsReplaying = false;
+
+  auto ms = [](uint64_t Microseconds) {
+    return llvm::format("%10.2f", Microseconds / 1000.0);
+  };
+
+  llvm::outs() << "===- Replayed " << Requests.size()
+               << " requests (ms) -===\n";
+  llvm::outs() << llvm::format("%8s%8s", "count", "errors");
+  for (const char *Column : {"p50", "p90", "p99", "max", "rec p50"})
+    llvm::outs() << llvm::format("%10s", Column);
+  llvm::outs() << "  request\n";
+  for (auto &Entry : Stats) {
+    ReplayStats &KindStats = Entry.second;
+    std::sort(KindStats.Latencies.begin(), KindStats.Latencies.end());
+    std::sort(KindStats.RecordedLatencies.begin(),
+              KindStats.RecordedLatencies.end());
+    llvm::outs() << llvm::format("%8u%8u",
+                                 unsigned(KindStats.Latencies.size()),
+                                 KindStats.Errors)
+                 << ms(getPercentile(KindStats.Latencies, 50))
+                 << ms(getPercentile(KindStats.Latencies, 90))
+                 << ms(getPercentile(KindStats.Latencies, 99))
+                 << ms(KindStats.Latencies.back())
+                 << ms(getPercentile(KindStats.RecordedLatencies, 50))
+                 << "  " << Entry.first << '\n';
+  }
+  llvm::outs() << "peak resident set size: " << getPeakMemoryKiB()
+               << " KiB\n";
+  return 0;
+}
+
 static int handleTestInvocation(ArrayRef<const char *> Args,
                                 TestOptions &InitOpts) {
 
@@ -324,6 +491,9 @@ static int handleTestInvocation(ArrayRef<const char *> Args,
   if (!Opts.JsonRequestPath.empty())
     return handleJsonRequestPath(Opts.JsonRequestPath);
 
+  if (!Opts.ReplayPath.empty())
+    return handleReplay(Opts.ReplayPath);
+
   if (Optargc < Args.size())
     Opts.CompilerArgs = Args.slice(Optargc+1);
 
@@ -801,6 +971,9 @@ static void notification_receiver(sourcekitd_response_t resp) {
     exit(1);
   }
 
+  if (IsReplaying)
+    return;
+
   sourcekitd_variant_t payload = sourcekitd_response_get_value(resp);
   sourcekitd_uid_t note =
       sourcekitd_variant_dictionary_get_uid(payload, KeyNotification);
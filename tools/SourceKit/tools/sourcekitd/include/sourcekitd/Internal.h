@@ -138,6 +138,9 @@ typedef std::function<void(sourcekitd_response_t)> ResponseReceiver;
 void handleRequest(sourcekitd_object_t Request, ResponseReceiver Receiver);
 
 void printRequestObject(sourcekitd_object_t Obj, llvm::raw_ostream &OS);
+/// Like printRequestObject, but with strings escaped, so that
+/// sourcekitd_request_create_from_yaml can read the request back.
+void writeRequestYAML(sourcekitd_object_t Obj, llvm::raw_ostream &OS);
 void printResponse(sourcekitd_response_t Resp, llvm::raw_ostream &OS);
 
 sourcekitd_response_t createErrorRequestInvalid(const char *Description);
@@ -93,6 +93,10 @@ extern SourceKit::UIdent KeyCodeCompleteOptions;
 extern SourceKit::UIdent KeyNextRequestStart;
 extern SourceKit::UIdent KeyPopular;
 extern SourceKit::UIdent KeyUnpopular;
+extern SourceKit::UIdent KeyCount;
+extern SourceKit::UIdent KeyLatencyP50;
+extern SourceKit::UIdent KeyLatencyP90;
+extern SourceKit::UIdent KeyLatencyP99;
 
 extern SourceKit::UIdent KeyIsUnavailable;
 extern SourceKit::UIdent KeyIsDeprecated;
@@ -20,15 +20,20 @@
 #include "SourceKit/Core/NotificationCenter.h"
 #include "SourceKit/Support/Concurrency.h"
 #include "SourceKit/Support/Logging.h"
+#include "SourceKit/Support/Tracing.h"
 #include "SourceKit/Support/UIdent.h"
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <cstdlib>
 #include <mutex>
 
 // FIXME: Portability.
@@ -90,6 +95,7 @@ static LazySKDUID RequestEditorFindInterfaceDoc(
     "source.request.editor.find_interface_doc");
 static LazySKDUID RequestBuildSettingsRegister(
     "source.request.buildsettings.register");
+static LazySKDUID RequestStatistics("source.request.statistics");
 
 static LazySKDUID KindExpr("source.lang.swift.expr");
 static LazySKDUID KindStmt("source.lang.swift.stmt");
@@ -213,13 +219,89 @@ static void fillDictionaryForDiagnosticInfo(
 static void handleRequestImpl(sourcekitd_object_t Req,
                               ResponseReceiver Receiver);
 
+namespace {
+/// Writes every request, with the time it arrived and its latency, to the
+/// file named by SOURCEKIT_RECORD_REQUESTS, so that an editor session can be
+/// replayed with 'sourcekitd-test -replay'.
+///
+/// Each request is a YAML document introduced by a line of the form
+/// "--- # start_us: <N> latency_us: <N>". Requests are written when their
+/// response is ready, so they may be out of order by start time.
+class RequestRecorder {
+  llvm::sys::Mutex Mtx;
+  std::unique_ptr<llvm::raw_fd_ostream> OS;
+  std::chrono::steady_clock::time_point Epoch;
+
+  RequestRecorder(std::unique_ptr<llvm::raw_fd_ostream> OS)
+    : OS(std::move(OS)), Epoch(std::chrono::steady_clock::now()) {}
+
+public:
+  /// Returns the recorder, or null if requests aren't recorded.
+  static RequestRecorder *get() {
+    // Never destroyed, so that requests that finish during shutdown can
+    // still be recorded.
+    static RequestRecorder *Recorder = []() -> RequestRecorder * {
+      const char *Path = ::getenv("SOURCEKIT_RECORD_REQUESTS");
+      if (!Path || !*Path)
+        return nullptr;
+      std::error_code EC;
+      std::unique_ptr<llvm::raw_fd_ostream> OS(
+          new llvm::raw_fd_ostream(Path, EC, llvm::sys::fs::F_None));
+      if (EC) {
+        LOG_WARN_FUNC("cannot record requests to '" << Path << "': "
+                      << EC.message());
+        return nullptr;
+      }
+      return new RequestRecorder(std::move(OS));
+    }();
+    return Recorder;
+  }
+
+  /// Writes \p RequestYAML, which arrived at \p Start and whose response is
+  /// ready now.
+  void record(StringRef RequestYAML,
+              std::chrono::steady_clock::time_point Start) {
+    using namespace std::chrono;
+    auto End = steady_clock::now();
+    llvm::sys::ScopedLock L(Mtx);
+    *OS << "--- # start_us: "
+        << duration_cast<microseconds>(Start - Epoch).count()
+        << " latency_us: " << duration_cast<microseconds>(End - Start).count()
+        << "\n" << RequestYAML << "\n";
+    OS->flush();
+  }
+};
+} // end anonymous namespace
+
 void sourcekitd::handleRequest(sourcekitd_object_t Req,
                                ResponseReceiver Receiver) {
   LOG_SECTION("handleRequest-before", InfoHighPrio) {
     sourcekitd::printRequestObject(Req, Log->getOS());
   }
 
-  handleRequestImpl(Req, [Receiver](sourcekitd_response_t Resp) {
+  // The request is printed now; it may be gone once the response is ready.
+  RequestRecorder *Recorder = RequestRecorder::get();
+  std::string RequestYAML;
+  std::chrono::steady_clock::time_point RecordStart;
+  if (Recorder) {
+    llvm::raw_string_ostream OS(RequestYAML);
+    sourcekitd::writeRequestYAML(Req, OS);
+    OS.flush();
+    RecordStart = std::chrono::steady_clock::now();
+  }
+
+  // Keep latency statistics per request kind, from the time the request is
+  // handled until its response is ready.
+  std::string StatName = "<unknown request>";
+  if (sourcekitd_uid_t ReqUID = RequestDict(Req).getUID(KeyRequest))
+    StatName = UIdentFromSKDUID(ReqUID).getName();
+  auto Timer = std::make_shared<trace::LatencyTimer>(StatName);
+
+  handleRequestImpl(Req, [Receiver, Timer, Recorder, RequestYAML,
+                          RecordStart](sourcekitd_response_t Resp) {
+    Timer->finish();
+    if (Recorder)
+      Recorder->record(RequestYAML, RecordStart);
     LOG_SECTION("handleRequest-after", InfoHighPrio) {
       // Responses are big, print them out with info medium priority.
       if (Logger::isLoggingEnabledForLevel(Logger::Level::InfoMediumPrio))
@@ -285,6 +367,22 @@ void handleRequestImpl(sourcekitd_object_t ReqObj, ResponseReceiver Rec) {
     return Rec(ResponseBuilder().createResponse());
   }
 
+  if (ReqUID == RequestStatistics) {
+    ResponseBuilder RespBuilder;
+    auto Results = RespBuilder.getDictionary().setArray(KeyResults);
+    for (const trace::Statistic &Stat : trace::getStatistics()) {
+      auto Elem = Results.appendDictionary();
+      Elem.set(KeyName, Stat.Name);
+      Elem.set(KeyCount, int64_t(Stat.Count));
+      if (Stat.IsHistogram) {
+        Elem.set(KeyLatencyP50, int64_t(Stat.P50));
+        Elem.set(KeyLatencyP90, int64_t(Stat.P90));
+        Elem.set(KeyLatencyP99, int64_t(Stat.P99));
+      }
+    }
+    return Rec(RespBuilder.createResponse());
+  }
+
   Optional<StringRef> SourceFile = Req.getString(KeySourceFile);
   Optional<StringRef> SourceText = Req.getString(KeySourceText);
 
@@ -106,6 +106,10 @@ UIdent sourcekitd::KeyCodeCompleteOptions("key.codecomplete.options");
 UIdent sourcekitd::KeyNextRequestStart("key.nextrequeststart");
 UIdent sourcekitd::KeyPopular("key.popular");
 UIdent sourcekitd::KeyUnpopular("key.unpopular");
+UIdent sourcekitd::KeyCount("key.count");
+UIdent sourcekitd::KeyLatencyP50("key.latency.p50");
+UIdent sourcekitd::KeyLatencyP90("key.latency.p90");
+UIdent sourcekitd::KeyLatencyP99("key.latency.p99");
 
 UIdent sourcekitd::KeyIsDeprecated("key.is_deprecated");
 UIdent sourcekitd::KeyIsUnavailable("key.is_unavailable");
@@ -185,6 +189,10 @@ static UIdent *OrderedKeys[] = {
   &KeyFormatOptions,
   &KeyCodeCompleteOptions,
   &KeyNextRequestStart,
+  &KeyCount,
+  &KeyLatencyP50,
+  &KeyLatencyP90,
+  &KeyLatencyP99,
 
   &KeyPlatform,
   &KeyIsDeprecated,
@@ -20,6 +20,7 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/YAMLParser.h"
 #include <map>
 #include <vector>
 #include <xpc/xpc.h>
@@ -140,9 +141,12 @@ public:
 class SKDObjectPrinter : public SKDObjectVisitor<SKDObjectPrinter> {
   raw_ostream &OS;
   unsigned Indent;
+  /// Whether strings are escaped as YAML double-quoted scalars.
+  bool EscapeStrings;
 public:
-  SKDObjectPrinter(raw_ostream &OS, unsigned Indent = 0)
-    : OS(OS), Indent(Indent) { }
+  SKDObjectPrinter(raw_ostream &OS, unsigned Indent = 0,
+                   bool EscapeStrings = false)
+    : OS(OS), Indent(Indent), EscapeStrings(EscapeStrings) { }
 
   void visitDictionary(const DictMap &Map) {
     OS << "{\n";
@@ -152,7 +156,7 @@ public:
       OS.indent(Indent);
       OSColor(OS, DictKeyColor) << Pair.first.getName();
       OS << ": ";
-      SKDObjectPrinter(OS, Indent).visit(Pair.second);
+      SKDObjectPrinter(OS, Indent, EscapeStrings).visit(Pair.second);
       if (i < e-1)
         OS << ',';
       OS << '\n';
@@ -167,7 +171,7 @@ public:
     for (unsigned i = 0, e = Arr.size(); i != e; ++i) {
       auto Obj = Arr[i];
       OS.indent(Indent);
-      SKDObjectPrinter(OS, Indent).visit(Obj);
+      SKDObjectPrinter(OS, Indent, EscapeStrings).visit(Obj);
       if (i < e-1)
         OS << ',';
       OS << '\n';
@@ -181,7 +185,10 @@ public:
   }
 
   void visitString(StringRef Str) {
-    OS << '\"' << Str << '\"';
+    if (EscapeStrings)
+      OS << '\"' << llvm::yaml::escape(Str) << '\"';
+    else
+      OS << '\"' << Str << '\"';
   }
 
   void visitUID(StringRef UID) {
@@ -200,6 +207,10 @@ void sourcekitd::printRequestObject(sourcekitd_object_t Obj, raw_ostream &OS) {
   SKDObjectPrinter(OS).visit(Obj);
 }
 
+void sourcekitd::writeRequestYAML(sourcekitd_object_t Obj, raw_ostream &OS) {
+  SKDObjectPrinter(OS, /*Indent=*/0, /*EscapeStrings=*/true).visit(Obj);
+}
+
 //============================================================================//
 // Internal API
 //============================================================================//
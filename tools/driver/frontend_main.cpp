@@ -18,8 +18,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "swift/Subsystems.h"
+#include "swift/AST/ASTNodeCounts.h"
 #include "swift/AST/DiagnosticsFrontend.h"
 #include "swift/AST/DiagnosticsSema.h"
+#include "swift/AST/FunctionTimeProfile.h"
 #include "swift/AST/IRGenOptions.h"
 #include "swift/AST/Mangle.h"
 #include "swift/AST/NameLookup.h"
@@ -27,15 +29,21 @@
 #include "swift/AST/TypeRefinementContext.h"
 #include "swift/Basic/Fallthrough.h"
 #include "swift/Basic/FileSystem.h"
+#include "swift/Basic/JobStats.h"
 #include "swift/Basic/SourceManager.h"
+#include "swift/Basic/TraceEvents.h"
+#include "swift/ClangImporter/ClangImporter.h"
 #include "swift/Frontend/DiagnosticVerifier.h"
 #include "swift/Frontend/Frontend.h"
 #include "swift/Frontend/PrintingDiagnosticConsumer.h"
 #include "swift/Frontend/SerializedDiagnosticConsumer.h"
 #include "swift/Immediate/Immediate.h"
 #include "swift/Option/Options.h"
+#include "swift/Parse/Lexer.h"
 #include "swift/PrintAsObjC/PrintAsObjC.h"
 #include "swift/Serialization/SerializationOptions.h"
+#include "swift/Serialization/SerializedModuleLoader.h"
+#include "swift/SILPasses/CodeSizeReport.h"
 #include "swift/SILPasses/Passes.h"
 
 // FIXME: We're just using CompilerInstance::createOutputFile.
@@ -46,6 +54,8 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Object/SymbolSize.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Option/OptTable.h"
 #include "llvm/Support/FileSystem.h"
@@ -128,6 +138,38 @@ static void findNominals(llvm::MapVector<const NominalTypeDecl *, bool> &found,
   }
 }
 
+using ProvidedMemberMap = llvm::MapVector<ReferencedNameTracker::MemberPair,
+                                          SmallVector<StringRef, 1>>;
+
+/// Collects the non-private members of \p nominal found in \p members,
+/// along with their interface hashes.
+///
+/// Members that do not have their own interface hash are only collected if
+/// \p includeUnhashed is set; otherwise they are covered by the entry for the
+/// whole type. Members of nested types are collected as well.
+static void findProvidedMembers(ProvidedMemberMap &found, const SourceFile *SF,
+                                const NominalTypeDecl *nominal,
+                                DeclRange members, bool includeUnhashed) {
+  for (const Decl *D : members) {
+    auto *VD = dyn_cast<ValueDecl>(D);
+    if (!VD || !VD->hasName() ||
+        VD->getFormalAccess() == Accessibility::Private) {
+      continue;
+    }
+
+    StringRef hash = SF->getMemberInterfaceHash(VD);
+    if (!hash.empty())
+      found[{nominal, VD->getName()}].push_back(hash);
+    else if (includeUnhashed)
+      (void)found[{nominal, VD->getName()}];
+
+    if (auto *nestedNominal = dyn_cast<NominalTypeDecl>(VD))
+      findProvidedMembers(found, SF, nestedNominal,
+                          nestedNominal->getMembers(/*forceDelayed=*/false),
+                          /*includeUnhashed=*/false);
+  }
+}
+
 static bool declIsPrivate(const Decl *member) {
   auto *VD = dyn_cast<ValueDecl>(member);
   if (!VD) {
@@ -201,7 +243,7 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
   out << "### Swift dependencies file v0 ###\n";
 
   llvm::MapVector<const NominalTypeDecl *, bool> extendedNominals;
-  llvm::SmallVector<const ExtensionDecl *, 8> extensionsWithJustMembers;
+  ProvidedMemberMap providedMembers;
 
   out << "provides-top-level:\n";
   for (const Decl *D : SF->Decls) {
@@ -230,12 +272,12 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
         if (std::all_of(ED->getMembers().begin(), ED->getMembers().end(),
                         declIsPrivate)) {
           break;
-        } else {
-          extensionsWithJustMembers.push_back(ED);
         }
       }
       extendedNominals[NTD] |= !justMembers;
       findNominals(extendedNominals, ED->getMembers());
+      findProvidedMembers(providedMembers, SF, NTD, ED->getMembers(),
+                          /*includeUnhashed=*/justMembers);
       break;
     }
 
@@ -259,6 +301,8 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
       out << "- \"" << escape(NTD->getName()) << "\"\n";
       extendedNominals[NTD] |= true;
       findNominals(extendedNominals, NTD->getMembers());
+      findProvidedMembers(providedMembers, SF, NTD, NTD->getMembers(),
+                          /*includeUnhashed=*/false);
       break;
     }
 
@@ -310,21 +354,29 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     out << "\", \"\"]\n";
   }
 
-  // This is also part of "provides-member".
-  for (auto *ED : extensionsWithJustMembers) {
-    SmallString<32> mangledName;
-    mangleTypeAsContext(llvm::raw_svector_ostream(mangledName),
-                        ED->getExtendedType()->getAnyNominal());
-
-    for (auto *member : ED->getMembers()) {
-      auto *VD = dyn_cast<ValueDecl>(member);
-      if (!VD || !VD->hasName() ||
-          VD->getFormalAccess() == Accessibility::Private) {
-        continue;
-      }
-      out << "- [\"" << mangledName.str() << "\", \""
-          << escape(VD->getName()) << "\"]\n";
+  // This is also part of "provides-member". Members that were hashed
+  // separately from the rest of the file carry that hash as a fingerprint,
+  // which lets the driver tell which members changed.
+  for (auto &entry : providedMembers) {
+    out << "- [\"";
+    mangleTypeAsContext(out, entry.first.first);
+    out << "\", \"" << escape(entry.first.second) << "\"";
+
+    ArrayRef<StringRef> hashes = entry.second;
+    if (hashes.size() == 1) {
+      out << ", \"" << hashes.front() << "\"";
+    } else if (!hashes.empty()) {
+      // Several declarations share this name; combine their hashes.
+      llvm::MD5 combinedHash;
+      for (StringRef hash : hashes)
+        combinedHash.update(hash);
+      llvm::MD5::MD5Result result;
+      combinedHash.final(result);
+      SmallString<32> fingerprint;
+      llvm::MD5::stringifyResult(result, fingerprint);
+      out << ", \"" << fingerprint << "\"";
     }
+    out << "]\n";
   }
 
   if (SF->getASTContext().LangOpts.EnableObjCInterop) {
@@ -440,6 +492,11 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
   SF->getInterfaceHash(interfaceHash);
   out << "interface-hash: \"" << interfaceHash << "\"\n";
 
+  llvm::SmallString<32> interfaceHashExcludingMembers;
+  SF->getInterfaceHashExcludingMembers(interfaceHashExcludingMembers);
+  out << "interface-hash-excluding-members: \""
+      << interfaceHashExcludingMembers << "\"\n";
+
   return false;
 }
 
@@ -609,116 +666,110 @@ static void debugFailWithCrash() {
   LLVM_BUILTIN_TRAP;
 }
 
-/// Performs the compile requested by the user.
-/// \returns true on error
-static bool performCompile(CompilerInstance &Instance,
-                           CompilerInvocation &Invocation,
-                           ArrayRef<const char *> Args,
-                           int &ReturnValue) {
-  FrontendOptions opts = Invocation.getFrontendOptions();
-  FrontendOptions::ActionType Action = opts.RequestedAction;
-
-  IRGenOptions &IRGenOpts = Invocation.getIRGenOptions();
-
-  bool inputIsLLVMIr = Invocation.getInputKind() == InputFileKind::IFK_LLVM_IR;
-  if (inputIsLLVMIr) {
-    auto &LLVMContext = llvm::getGlobalContext();
-
-    // Load in bitcode file.
-    assert(Invocation.getInputFilenames().size() == 1 &&
-           "We expect a single input for bitcode input!");
-    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileBufOrErr =
-      llvm::MemoryBuffer::getFileOrSTDIN(Invocation.getInputFilenames()[0]);
-    if (!FileBufOrErr) {
-      Instance.getASTContext().Diags.diagnose(SourceLoc(),
-                                              diag::error_open_input_file,
-                                              Invocation.getInputFilenames()[0],
-                                              FileBufOrErr.getError().message());
-      return true;
-    }
-    llvm::MemoryBuffer *MainFile = FileBufOrErr.get().get();
-
-    llvm::SMDiagnostic Err;
-    std::unique_ptr<llvm::Module> Module = llvm::parseIR(
-                                             MainFile->getMemBufferRef(),
-                                             Err, LLVMContext);
-    if (!Module) {
-      // TODO: Translate from the diagnostic info to the SourceManager location
-      // if available.
-      Instance.getASTContext().Diags.diagnose(SourceLoc(),
-                                              diag::error_parse_input_file,
-                                              Invocation.getInputFilenames()[0],
-                                              Err.getMessage());
-      return true;
+/// Adds the number of SIL functions, blocks and instructions in \p SM to
+/// \p Stats.
+static void addSILCounts(const SILModule &SM, JobStats &Stats) {
+  uint64_t NumFunctions = 0, NumBlocks = 0, NumInstructions = 0;
+  for (const SILFunction &F : SM) {
+    if (F.isExternalDeclaration())
+      continue;
+    ++NumFunctions;
+    for (const SILBasicBlock &BB : F) {
+      ++NumBlocks;
+      NumInstructions += std::distance(BB.begin(), BB.end());
     }
-
-    // TODO: remove once the frontend understands what action it should perform
-    IRGenOpts.OutputKind = getOutputKind(Action);
-
-    return performLLVM(IRGenOpts, Instance.getASTContext(), Module.get());
   }
+  Stats.addCounter("sil.functions", NumFunctions);
+  Stats.addCounter("sil.blocks", NumBlocks);
+  Stats.addCounter("sil.instructions", NumInstructions);
+}
 
-  ReferencedNameTracker nameTracker;
-  bool shouldTrackReferences = !opts.ReferenceDependenciesFilePath.empty();
-  if (shouldTrackReferences)
-    Instance.setReferencedNameTracker(&nameTracker);
-
-  if (Action == FrontendOptions::DumpParse ||
-      Action == FrontendOptions::DumpInterfaceHash)
-    Instance.performParseOnly();
-  else
-    Instance.performSema();
-
-  FrontendOptions::DebugCrashMode CrashMode = opts.CrashMode;
-  if (CrashMode == FrontendOptions::DebugCrashMode::AssertAfterParse)
-    debugFailWithAssertion();
-  else if (CrashMode == FrontendOptions::DebugCrashMode::CrashAfterParse)
-    debugFailWithCrash();
+/// Adds the number of LLVM functions and instructions in \p M to \p Stats.
+static void addLLVMCounts(const llvm::Module &M, JobStats &Stats) {
+  uint64_t NumFunctions = 0, NumInstructions = 0;
+  for (const llvm::Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    ++NumFunctions;
+    for (const llvm::BasicBlock &BB : F)
+      NumInstructions += BB.size();
+  }
+  Stats.addCounter("llvm.functions", NumFunctions);
+  Stats.addCounter("llvm.instructions", NumInstructions);
+}
 
-  ASTContext &Context = Instance.getASTContext();
+/// Adds the number of AST nodes created by this process to \p Stats.
+static void addASTCounts(const ASTContext &Context, JobStats &Stats) {
+  Stats.addCounter("ast.decls", ASTNodeCounts::getTotalDecls());
+  Stats.addCounter("ast.exprs", ASTNodeCounts::getTotalExprs());
+  Stats.addCounter("ast.types", ASTNodeCounts::getTotalTypes());
+  Stats.addCounter("ast.type_reprs", ASTNodeCounts::getTotalTypeReprs());
+  Stats.addCounter("ast.type_bytes",
+                   ASTNodeCounts::TypeBytes[0] + ASTNodeCounts::TypeBytes[1]);
+  Stats.addCounter("ast.loaded_modules", Context.LoadedModules.size());
+}
 
-  if (Action == FrontendOptions::REPL) {
-    runREPL(Instance, ProcessCmdLine(Args.begin(), Args.end()),
-            Invocation.getParseStdlib());
-    return false;
+/// Adds the size of each function defined in the object file \p Path to
+/// \p Report.
+static std::error_code addMachineCodeSizes(StringRef Path,
+                                           CodeSizeReport &Report) {
+  auto ObjectOrErr = llvm::object::ObjectFile::createObjectFile(Path);
+  if (!ObjectOrErr)
+    return ObjectOrErr.getError();
+  const llvm::object::ObjectFile &Object = *ObjectOrErr->getBinary();
+
+  for (auto &SymbolAndSize : llvm::object::computeSymbolSizes(Object)) {
+    const llvm::object::SymbolRef &Symbol = SymbolAndSize.first;
+    if (Symbol.getType() != llvm::object::SymbolRef::ST_Function ||
+        (Symbol.getFlags() & llvm::object::SymbolRef::SF_Undefined))
+      continue;
+    ErrorOr<StringRef> Name = Symbol.getName();
+    if (!Name)
+      continue;
+    StringRef SymbolName = *Name;
+    // Mach-O prefixes every symbol with an underscore.
+    if (Object.isMachO() && SymbolName.startswith("_"))
+      SymbolName = SymbolName.drop_front();
+    Report.setMachineCodeSize(SymbolName, SymbolAndSize.second);
   }
+  Report.setObjectFile(Path);
+  return std::error_code();
+}
 
-  SourceFile *PrimarySourceFile = Instance.getPrimarySourceFile();
-
-  // We've been told to dump the AST (either after parsing or type-checking,
-  // which is already differentiated in CompilerInstance::performSema()),
-  // so dump or print the main source file and return.
-  if (Action == FrontendOptions::DumpParse ||
-      Action == FrontendOptions::DumpAST ||
-      Action == FrontendOptions::PrintAST ||
-      Action == FrontendOptions::DumpTypeRefinementContexts ||
-      Action == FrontendOptions::DumpInterfaceHash) {
-    SourceFile *SF = PrimarySourceFile;
-    if (!SF) {
-      SourceFileKind Kind = Invocation.getSourceFileKind();
-      SF = &Instance.getMainModule()->getMainSourceFile(Kind);
-    }
-    if (Action == FrontendOptions::PrintAST)
-      SF->print(llvm::outs(), PrintOptions::printEverything());
-    else if (Action == FrontendOptions::DumpTypeRefinementContexts)
-      SF->getTypeRefinementContext()->dump(llvm::errs(), Context.SourceMgr);
-    else if (Action == FrontendOptions::DumpInterfaceHash)
-      SF->dumpInterfaceHash(llvm::errs());
-    else
-      SF->dump();
-    return false;
+/// Returns a name for the statistics of this job: the module name, followed
+/// by the primary file if there is one.
+static std::string getStatsName(const CompilerInvocation &Invocation) {
+  const FrontendOptions &opts = Invocation.getFrontendOptions();
+  std::string Name = opts.ModuleName;
+  if (opts.PrimaryInput.hasValue() && opts.PrimaryInput->isFilename()) {
+    Name += "-";
+    Name += llvm::sys::path::filename(
+      opts.InputFilenames[opts.PrimaryInput->Index]);
   }
+  return Name;
+}
 
-  // If we were asked to print Clang stats, do so.
-  if (opts.PrintClangStats && Context.getClangModuleLoader())
-    Context.getClangModuleLoader()->printStatistics();
+/// Performs the steps of the compile which come after type checking for a
+/// single primary file, or for the whole module if \p PrimarySourceFile is
+/// null and \p opts has no primary input.
+/// \returns true on error
+static bool performCompileStepsPostSema(CompilerInstance &Instance,
+                                        CompilerInvocation &Invocation,
+                                        const FrontendOptions &opts,
+                                        SourceFile *PrimarySourceFile,
+                                        IRGenOptions IRGenOpts,
+                                        JobStats *Stats,
+                                        CodeSizeReport *SizeReport,
+                                        int &ReturnValue) {
+  FrontendOptions::ActionType Action = opts.RequestedAction;
+  ASTContext &Context = Instance.getASTContext();
 
   if (!opts.DependenciesFilePath.empty())
     (void)emitMakeDependencies(Context.Diags, *Instance.getDependencyTracker(),
                                opts);
 
-  if (shouldTrackReferences)
-    emitReferenceDependencies(Context.Diags, Instance.getPrimarySourceFile(),
+  if (!opts.ReferenceDependenciesFilePath.empty())
+    emitReferenceDependencies(Context.Diags, PrimarySourceFile,
                               *Instance.getDependencyTracker(), opts);
 
   if (Context.hadError())
@@ -744,6 +795,7 @@ static bool performCompile(CompilerInstance &Instance,
 
   std::unique_ptr<SILModule> SM = Instance.takeSILModule();
   if (!SM) {
+    TraceEventScope TraceSILGen("SILGen", "frontend");
     if (opts.PrimaryInput.hasValue() && opts.PrimaryInput.getValue().isFilename()) {
       FileUnit *PrimaryFile = PrimarySourceFile;
       if (!PrimaryFile) {
@@ -787,9 +839,12 @@ static bool performCompile(CompilerInstance &Instance,
   }
 
   // Perform "stable" optimizations that are invariant across compiler versions.
-  if (!Invocation.getDiagnosticOptions().SkipDiagnosticPasses &&
-      runSILDiagnosticPasses(*SM))
-    return true;
+  {
+    TraceEventScope TraceDiagnosticPasses("SIL diagnostic passes", "frontend");
+    if (!Invocation.getDiagnosticOptions().SkipDiagnosticPasses &&
+        runSILDiagnosticPasses(*SM))
+      return true;
+  }
 
   // Now if we are asked to link all, link all.
   if (Invocation.getSILOptions().LinkMode == SILOptions::LinkAll)
@@ -799,23 +854,31 @@ static bool performCompile(CompilerInstance &Instance,
 
   // Perform SIL optimization passes if optimizations haven't been disabled.
   // These may change across compiler versions.
-  if (IRGenOpts.Optimize) {
-    StringRef CustomPipelinePath =
-      Invocation.getSILOptions().ExternalPassPipelineFilename;
-    if (!CustomPipelinePath.empty()) {
-      runSILOptimizationPassesWithFileSpecification(*SM, CustomPipelinePath);
+  {
+    TraceEventScope TraceSILOptimization("SIL optimization", "frontend");
+    if (IRGenOpts.Optimize) {
+      StringRef CustomPipelinePath =
+        Invocation.getSILOptions().ExternalPassPipelineFilename;
+      if (!CustomPipelinePath.empty()) {
+        runSILOptimizationPassesWithFileSpecification(*SM, CustomPipelinePath);
+      } else {
+        runSILOptimizationPasses(*SM);
+      }
     } else {
-      runSILOptimizationPasses(*SM);
+      runSILPassesForOnone(*SM);
     }
-  } else {
-    runSILPassesForOnone(*SM);
   }
   SM->verify();
 
+  if (Stats)
+    addSILCounts(*SM, *Stats);
+
   // Gather instruction counts if we are asked to do so.
   if (SM->getOptions().PrintInstCounts) {
     performSILInstCount(&*SM);
   }
+  if (SizeReport)
+    SizeReport->addSILModule(*SM);
 
   // Get the main source file's private discriminator and attach it to
   // the compile unit's flags.
@@ -857,6 +920,7 @@ static bool performCompile(CompilerInstance &Instance,
       serializationOpts.ModuleLinkName = opts.ModuleLinkName;
       serializationOpts.ExtraClangOptions =
           Invocation.getClangImporterOptions().ExtraArgs;
+      serializationOpts.PathPrefixMap = opts.SerializedPathPrefixMap;
       if (!IRGenOpts.ForceLoadSymbolName.empty())
         serializationOpts.AutolinkForceLoad = true;
 
@@ -911,17 +975,217 @@ static bool performCompile(CompilerInstance &Instance,
   // FIXME: We shouldn't need to use the global context here, but
   // something is persisting across calls to performIRGeneration.
   auto &LLVMContext = llvm::getGlobalContext();
+  TraceEventScope TraceIRGen("IRGen", "frontend");
+  std::unique_ptr<llvm::Module> IRModule;
   if (PrimarySourceFile) {
-    performIRGeneration(IRGenOpts, *PrimarySourceFile, SM.get(),
-                        opts.getSingleOutputFilename(), LLVMContext);
+    IRModule = performIRGeneration(IRGenOpts, *PrimarySourceFile, SM.get(),
+                                   opts.getSingleOutputFilename(),
+                                   LLVMContext);
   } else {
-    performIRGeneration(IRGenOpts, Instance.getMainModule(), SM.get(),
-                        opts.getSingleOutputFilename(), LLVMContext);
+    // IRGen frees the SIL module of a whole-module build before running
+    // LLVM.
+    IRModule = performIRGeneration(IRGenOpts, Instance.getMainModule(),
+                                   std::move(SM),
+                                   opts.getSingleOutputFilename(),
+                                   LLVMContext);
+  }
+
+  // The module has been through the LLVM passes by now. Multi-threaded
+  // IRGen doesn't return its modules, so they aren't counted.
+  if (Stats && IRModule)
+    addLLVMCounts(*IRModule, *Stats);
+
+  // Multi-threaded IRGen writes one object file per thread.
+  if (SizeReport && IRGenOpts.OutputKind == IRGenOutputKind::ObjectFile) {
+    std::vector<std::string> ObjectFiles;
+    if (Invocation.getSILOptions().NumThreads != 0)
+      ObjectFiles = IRGenOpts.OutputFilenames;
+    else
+      ObjectFiles.push_back(IRGenOpts.getSingleOutputFilename());
+    for (const std::string &ObjectFile : ObjectFiles) {
+      if (ObjectFile.empty() || ObjectFile == "-")
+        continue;
+      if (std::error_code EC = addMachineCodeSizes(ObjectFile, *SizeReport)) {
+        Context.Diags.diagnose(SourceLoc(), diag::error_open_input_file,
+                               ObjectFile, EC.message());
+        return true;
+      }
+    }
   }
 
   return false;
 }
 
+/// Performs the compile requested by the user.
+/// \returns true on error
+/// Loads the standard library, the bridging header, the underlying module
+/// and the modules given by -import-module. This makes the Clang importer
+/// build any Clang modules they need into the module cache.
+///
+/// Modules which can't be found are not diagnosed; the compile jobs which
+/// import them report that at the import.
+static bool loadImportedModules(CompilerInstance &Instance,
+                                CompilerInvocation &Invocation) {
+  const FrontendOptions &opts = Invocation.getFrontendOptions();
+  ASTContext &Context = Instance.getASTContext();
+  Module *MainModule = Instance.getMainModule();
+
+  if (!Invocation.getParseStdlib())
+    (void)Context.getStdlibModule(true);
+
+  auto clangImporter =
+    static_cast<ClangImporter *>(Context.getClangModuleLoader());
+  if (!opts.ImplicitObjCHeaderPath.empty())
+    (void)clangImporter->importBridgingHeader(opts.ImplicitObjCHeaderPath,
+                                              MainModule);
+  if (opts.ImportUnderlyingModule)
+    (void)clangImporter->loadModule(SourceLoc(),
+                                    std::make_pair(MainModule->getName(),
+                                                   SourceLoc()));
+
+  for (auto &ModuleName : opts.ImplicitImportModuleNames) {
+    if (!Lexer::isIdentifier(ModuleName))
+      continue;
+    auto ModuleID = Context.getIdentifier(ModuleName);
+    (void)Context.getModule(std::make_pair(ModuleID, SourceLoc()));
+  }
+
+  return Context.hadError();
+}
+
+static bool performCompile(CompilerInstance &Instance,
+                           CompilerInvocation &Invocation,
+                           ArrayRef<const char *> Args,
+                           JobStats *Stats,
+                           CodeSizeReport *SizeReport,
+                           int &ReturnValue) {
+  FrontendOptions opts = Invocation.getFrontendOptions();
+  FrontendOptions::ActionType Action = opts.RequestedAction;
+
+  if (Action == FrontendOptions::LoadImportedModules)
+    return loadImportedModules(Instance, Invocation);
+
+  IRGenOptions &IRGenOpts = Invocation.getIRGenOptions();
+
+  bool inputIsLLVMIr = Invocation.getInputKind() == InputFileKind::IFK_LLVM_IR;
+  if (inputIsLLVMIr) {
+    auto &LLVMContext = llvm::getGlobalContext();
+
+    // Load in bitcode file.
+    assert(Invocation.getInputFilenames().size() == 1 &&
+           "We expect a single input for bitcode input!");
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileBufOrErr =
+      llvm::MemoryBuffer::getFileOrSTDIN(Invocation.getInputFilenames()[0]);
+    if (!FileBufOrErr) {
+      Instance.getASTContext().Diags.diagnose(SourceLoc(),
+                                              diag::error_open_input_file,
+                                              Invocation.getInputFilenames()[0],
+                                              FileBufOrErr.getError().message());
+      return true;
+    }
+    llvm::MemoryBuffer *MainFile = FileBufOrErr.get().get();
+
+    llvm::SMDiagnostic Err;
+    std::unique_ptr<llvm::Module> Module = llvm::parseIR(
+                                             MainFile->getMemBufferRef(),
+                                             Err, LLVMContext);
+    if (!Module) {
+      // TODO: Translate from the diagnostic info to the SourceManager location
+      // if available.
+      Instance.getASTContext().Diags.diagnose(SourceLoc(),
+                                              diag::error_parse_input_file,
+                                              Invocation.getInputFilenames()[0],
+                                              Err.getMessage());
+      return true;
+    }
+
+    // TODO: remove once the frontend understands what action it should perform
+    IRGenOpts.OutputKind = getOutputKind(Action);
+
+    return performLLVM(IRGenOpts, Instance.getASTContext(), Module.get());
+  }
+
+  // Keep one tracker per primary file, so that each of them gets its own
+  // reference dependencies in batch mode.
+  std::vector<ReferencedNameTracker> nameTrackers(
+    std::max(1U, opts.getNumPrimaryInputs()));
+  if (!opts.ReferenceDependenciesFilePath.empty()) {
+    SmallVector<ReferencedNameTracker *, 1> trackerPtrs;
+    for (auto &tracker : nameTrackers)
+      trackerPtrs.push_back(&tracker);
+    Instance.setReferencedNameTrackers(trackerPtrs);
+  }
+
+  if (Action == FrontendOptions::DumpParse ||
+      Action == FrontendOptions::DumpInterfaceHash)
+    Instance.performParseOnly();
+  else
+    Instance.performSema();
+
+  FrontendOptions::DebugCrashMode CrashMode = opts.CrashMode;
+  if (CrashMode == FrontendOptions::DebugCrashMode::AssertAfterParse)
+    debugFailWithAssertion();
+  else if (CrashMode == FrontendOptions::DebugCrashMode::CrashAfterParse)
+    debugFailWithCrash();
+
+  ASTContext &Context = Instance.getASTContext();
+
+  if (Action == FrontendOptions::REPL) {
+    runREPL(Instance, ProcessCmdLine(Args.begin(), Args.end()),
+            Invocation.getParseStdlib());
+    return false;
+  }
+
+  SourceFile *PrimarySourceFile = Instance.getPrimarySourceFile();
+
+  // We've been told to dump the AST (either after parsing or type-checking,
+  // which is already differentiated in CompilerInstance::performSema()),
+  // so dump or print the main source file and return.
+  if (Action == FrontendOptions::DumpParse ||
+      Action == FrontendOptions::DumpAST ||
+      Action == FrontendOptions::PrintAST ||
+      Action == FrontendOptions::DumpTypeRefinementContexts ||
+      Action == FrontendOptions::DumpInterfaceHash) {
+    SourceFile *SF = PrimarySourceFile;
+    if (!SF) {
+      SourceFileKind Kind = Invocation.getSourceFileKind();
+      SF = &Instance.getMainModule()->getMainSourceFile(Kind);
+    }
+    if (Action == FrontendOptions::PrintAST)
+      SF->print(llvm::outs(), PrintOptions::printEverything());
+    else if (Action == FrontendOptions::DumpTypeRefinementContexts)
+      SF->getTypeRefinementContext()->dump(llvm::errs(), Context.SourceMgr);
+    else if (Action == FrontendOptions::DumpInterfaceHash)
+      SF->dumpInterfaceHash(llvm::errs());
+    else
+      SF->dump();
+    return false;
+  }
+
+  // If we were asked to print Clang stats, do so.
+  if (opts.PrintClangStats && Context.getClangModuleLoader())
+    Context.getClangModuleLoader()->printStatistics();
+
+  if (!opts.isBatchMode())
+    return performCompileStepsPostSema(Instance, Invocation, opts,
+                                       PrimarySourceFile, IRGenOpts, Stats,
+                                       SizeReport, ReturnValue);
+
+  // In batch mode, compile each primary file as if it were the only one,
+  // sharing the type-checked AST between them.
+  ArrayRef<SourceFile *> PrimarySourceFiles = Instance.getPrimarySourceFiles();
+  for (unsigned i = 0, e = opts.getNumPrimaryInputs(); i != e; ++i) {
+    FrontendOptions primaryOpts = opts.getOptionsForBatchPrimary(i);
+    SourceFile *SF = i < PrimarySourceFiles.size() ? PrimarySourceFiles[i]
+                                                   : nullptr;
+    if (performCompileStepsPostSema(Instance, Invocation, primaryOpts, SF,
+                                    IRGenOpts, Stats, SizeReport,
+                                    ReturnValue))
+      return true;
+  }
+  return false;
+}
+
 /// Returns true if an error occurred.
 static bool dumpAPI(Module *Mod, StringRef OutDir) {
   using namespace llvm::sys;
@@ -1090,6 +1354,12 @@ int frontend_main(ArrayRef<const char *>Args,
     llvm::EnableStatistics();
   }
 
+  // Count nodes from the start, so that the standard library's are included.
+  const std::string &StatsOutputDir =
+    Invocation.getFrontendOptions().StatsOutputDir;
+  if (Invocation.getFrontendOptions().PrintASTStats || !StatsOutputDir.empty())
+    ASTNodeCounts::Enabled = true;
+
   if (Invocation.getDiagnosticOptions().VerifyDiagnostics) {
     enableDiagnosticVerifier(Instance.getSourceMgr());
   }
@@ -1100,13 +1370,96 @@ int frontend_main(ArrayRef<const char *>Args,
     Instance.setDependencyTracker(&depTracker);
   }
 
+  // Phases deep inside the compiler find the recorder through
+  // TraceEventRecorder::getActive().
+  // The phase times for -stats-output-dir come from the same spans.
+  std::unique_ptr<TraceEventRecorder> TraceEvents;
+  if (!Invocation.getFrontendOptions().TraceEventsPath.empty() ||
+      !StatsOutputDir.empty()) {
+    TraceEvents.reset(new TraceEventRecorder());
+    TraceEventRecorder::setActive(TraceEvents.get());
+  }
+
+  Optional<JobStats> Stats;
+  if (!StatsOutputDir.empty())
+    Stats.emplace("frontend", getStatsName(Invocation));
+
+  std::unique_ptr<FunctionTimeProfile> FunctionTimes;
+  if (Invocation.getFrontendOptions().DebugTimeFunctions) {
+    FunctionTimes.reset(new FunctionTimeProfile());
+    FunctionTimeProfile::setActive(FunctionTimes.get());
+  }
+
+  std::unique_ptr<CodeSizeReport> SizeReport;
+  if (!Invocation.getFrontendOptions().CodeSizeReportPath.empty())
+    SizeReport.reset(new CodeSizeReport());
+
   if (Instance.setup(Invocation)) {
     return 1;
   }
 
   int ReturnValue = 0;
-  bool HadError = performCompile(Instance, Invocation, Args, ReturnValue) ||
-                  Instance.getASTContext().hadError();
+  JobStats *StatsPtr = Stats ? Stats.getPointer() : nullptr;
+  bool HadError =
+    performCompile(Instance, Invocation, Args, StatsPtr, SizeReport.get(),
+                   ReturnValue) ||
+    Instance.getASTContext().hadError();
+
+  if (TraceEvents)
+    TraceEventRecorder::setActive(nullptr);
+
+  if (FunctionTimes) {
+    FunctionTimeProfile::setActive(nullptr);
+    FunctionTimes->print(llvm::errs(),
+      Invocation.getFrontendOptions().DebugTimeFunctionsLimit);
+  }
+
+  const std::string &TraceEventsPath =
+    Invocation.getFrontendOptions().TraceEventsPath;
+  if (!TraceEventsPath.empty()) {
+    if (std::error_code EC = TraceEvents->writeToFile(TraceEventsPath)) {
+      Instance.getDiags().diagnose(SourceLoc(), diag::cannot_open_file,
+                                   TraceEventsPath, EC.message());
+      HadError = true;
+    }
+  }
+
+  if (Stats) {
+    Stats->addPhases(*TraceEvents, "frontend");
+    addASTCounts(Instance.getASTContext(), *Stats);
+    if (std::error_code EC = Stats->writeToDirectory(StatsOutputDir)) {
+      Instance.getDiags().diagnose(SourceLoc(), diag::cannot_open_file,
+                                   StatsOutputDir, EC.message());
+      HadError = true;
+    }
+  }
+
+  const std::string &ModuleLoadStatsPath =
+    Invocation.getFrontendOptions().ModuleLoadStatsPath;
+  if (!ModuleLoadStatsPath.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(ModuleLoadStatsPath, EC, llvm::sys::fs::F_None);
+    if (EC) {
+      Instance.getDiags().diagnose(SourceLoc(), diag::cannot_open_file,
+                                   ModuleLoadStatsPath, EC.message());
+      HadError = true;
+    } else {
+      Instance.getSerializedModuleLoader()->writeStatistics(OS);
+    }
+  }
+
+  const std::string &CodeSizeReportPath =
+    Invocation.getFrontendOptions().CodeSizeReportPath;
+  if (!HadError && SizeReport) {
+    if (std::error_code EC = SizeReport->writeToFile(CodeSizeReportPath)) {
+      Instance.getDiags().diagnose(SourceLoc(), diag::cannot_open_file,
+                                   CodeSizeReportPath, EC.message());
+      HadError = true;
+    }
+  }
+
+  if (Invocation.getFrontendOptions().PrintASTStats)
+    Instance.getASTContext().printStatistics(llvm::errs());
 
   if (!HadError && !Invocation.getFrontendOptions().DumpAPIPath.empty()) {
     HadError = dumpAPI(Instance.getMainModule(),
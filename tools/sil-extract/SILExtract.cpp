@@ -165,6 +165,9 @@ int main(int argc, char **argv) {
   Invocation.getLangOptions().EnableAccessControl = false;
   Invocation.getLangOptions().EnableObjCAttrRequiresFoundation = false;
 
+  // Don't parse the bodies of functions which are going to be removed.
+  Invocation.getSILOptions().ParseOnlyFunctionBody = FunctionName;
+
   // Load the input file.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileBufOrErr =
     llvm::MemoryBuffer::getFileOrSTDIN(InputFilename);
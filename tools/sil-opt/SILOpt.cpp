@@ -19,6 +19,7 @@
 #include "swift/Subsystems.h"
 #include "swift/AST/DiagnosticsFrontend.h"
 #include "swift/AST/SILOptions.h"
+#include "swift/Basic/JobStats.h"
 #include "swift/Basic/LLVMInitialize.h"
 #include "swift/Frontend/DiagnosticVerifier.h"
 #include "swift/Frontend/Frontend.h"
@@ -26,17 +27,23 @@
 #include "swift/SILAnalysis/Analysis.h"
 #include "swift/SILPasses/Passes.h"
 #include "swift/SILPasses/PassManager.h"
+#include "swift/SILPasses/Transforms.h"
 #include "swift/Serialization/SerializedModuleLoader.h"
 #include "swift/Serialization/SerializedSILLoader.h"
 #include "swift/Serialization/SerializationOptions.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include <algorithm>
+#include <chrono>
+#include <tuple>
 using namespace swift;
 
 namespace {
@@ -115,6 +122,20 @@ EnableSILVerifyAll("enable-sil-verify-all",
                    llvm::cl::init(true),
                    llvm::cl::desc("Run sil verifications after every pass."));
 
+static llvm::cl::opt<unsigned>
+SILVerifySampleRate("sil-verify-sample-rate",
+                    llvm::cl::Hidden,
+                    llvm::cl::init(0),
+                    llvm::cl::desc("Only verify about one in this many "
+                                   "functions after every pass."));
+
+static llvm::cl::opt<bool>
+SILVerifyIncremental("sil-verify-incremental",
+                     llvm::cl::Hidden,
+                     llvm::cl::init(false),
+                     llvm::cl::desc("Only verify the functions which a pass "
+                                    "has changed."));
+
 static llvm::cl::opt<bool>
 RemoveRuntimeAsserts("remove-runtime-asserts",
                      llvm::cl::Hidden,
@@ -153,6 +174,152 @@ ASTVerifierProcessId("ast-verifier-process-id", llvm::cl::Hidden,
 static llvm::cl::opt<bool>
 PerformWMO("wmo", llvm::cl::desc("Enable whole-module optimizations"));
 
+static llvm::cl::opt<unsigned>
+BenchIterations("bench-iterations", llvm::cl::init(0),
+                llvm::cl::desc("Parse the input and run the pipeline this "
+                               "many times, and print the median time of "
+                               "each pass"));
+
+static llvm::cl::opt<unsigned>
+BenchWarmup("bench-warmup", llvm::cl::init(1),
+            llvm::cl::desc("The number of unmeasured runs of the pipeline "
+                           "before the -bench-iterations runs"));
+
+namespace {
+
+/// The runs of one pass during one run of the pipeline.
+struct PassIteration {
+  uint64_t Time = 0;
+  unsigned Runs = 0;
+  uint64_t InstructionsAdded = 0;
+  uint64_t InstructionsRemoved = 0;
+};
+
+/// Collects the time and size changes of every pass, for -bench-iterations.
+class PipelineBenchmark : public SILPassRunObserver {
+  /// The passes, in the order that they first ran.
+  std::vector<std::string> PassNames;
+
+  /// The runs of each pass, per iteration.
+  llvm::StringMap<std::vector<PassIteration>> Passes;
+
+  /// The time of the whole pipeline, per iteration.
+  std::vector<uint64_t> PipelineTimes;
+
+  uint64_t FunctionsBefore = 0, FunctionsAfter = 0;
+  uint64_t InstructionsBefore = 0, InstructionsAfter = 0;
+
+  static uint64_t median(std::vector<uint64_t> Values) {
+    if (Values.empty())
+      return 0;
+    std::sort(Values.begin(), Values.end());
+    return Values[Values.size() / 2];
+  }
+
+public:
+  void passDidRun(SILTransform *T, SILFunction *F, uint64_t Nanoseconds,
+                  uint64_t Before, uint64_t After) override {
+    auto &Iterations = Passes[T->getName()];
+    if (Iterations.empty())
+      PassNames.push_back(T->getName());
+    Iterations.resize(PipelineTimes.size() + 1);
+
+    PassIteration &Current = Iterations.back();
+    Current.Time += Nanoseconds;
+    ++Current.Runs;
+    if (After > Before)
+      Current.InstructionsAdded += After - Before;
+    else
+      Current.InstructionsRemoved += Before - After;
+  }
+
+  /// Records the end of one measured run of the pipeline, which took
+  /// \p Nanoseconds and changed the module from \p Before to \p After.
+  void finishIteration(uint64_t Nanoseconds,
+                       std::pair<uint64_t, uint64_t> Before,
+                       std::pair<uint64_t, uint64_t> After) {
+    PipelineTimes.push_back(Nanoseconds);
+    std::tie(FunctionsBefore, InstructionsBefore) = Before;
+    std::tie(FunctionsAfter, InstructionsAfter) = After;
+  }
+
+  /// Prints the median time of each pass, most expensive first, and the
+  /// size changes of the last iteration.
+  void print(raw_ostream &os) const {
+    struct Row {
+      StringRef Name;
+      uint64_t Median, Min, Max;
+      const PassIteration *Last;
+    };
+    std::vector<Row> Rows;
+    for (const std::string &Name : PassNames) {
+      const auto &Iterations = Passes.find(Name)->getValue();
+      std::vector<uint64_t> Times(PipelineTimes.size(), 0);
+      for (unsigned i = 0, e = Iterations.size(); i != e; ++i)
+        Times[i] = Iterations[i].Time;
+      auto MinMax = std::minmax_element(Times.begin(), Times.end());
+      const PassIteration *Last = nullptr;
+      if (Iterations.size() == PipelineTimes.size())
+        Last = &Iterations.back();
+      Rows.push_back({Name, median(Times), *MinMax.first, *MinMax.second,
+                      Last});
+    }
+    std::stable_sort(Rows.begin(), Rows.end(),
+                     [](const Row &LHS, const Row &RHS) {
+      return LHS.Median > RHS.Median;
+    });
+
+    auto ms = [](uint64_t Nanoseconds) {
+      return llvm::format("%10.3f", Nanoseconds / 1e6);
+    };
+
+    os << "===- SIL pipeline benchmark (" << PipelineTimes.size()
+       << " iterations, ms) -===\n";
+    for (const char *Column : {"median", "min", "max"})
+      os << llvm::format("%10s", Column);
+    for (const char *Column : {"runs", "added", "removed"})
+      os << llvm::format("%9s", Column);
+    os << "  pass\n";
+    for (const Row &R : Rows) {
+      os << ms(R.Median) << ms(R.Min) << ms(R.Max);
+      if (R.Last)
+        os << llvm::format("%9u", R.Last->Runs)
+           << llvm::format("%9llu", (unsigned long long)R.Last->InstructionsAdded)
+           << llvm::format("%9llu",
+                           (unsigned long long)R.Last->InstructionsRemoved);
+      else
+        os << llvm::format("%9u%9u%9u", 0, 0, 0);
+      os << "  " << R.Name << "\n";
+    }
+
+    auto MinMax = std::minmax_element(PipelineTimes.begin(),
+                                      PipelineTimes.end());
+    os << ms(median(PipelineTimes)) << ms(*MinMax.first) << ms(*MinMax.second)
+       << "  (whole pipeline)\n";
+    os << "functions: " << FunctionsBefore << " -> " << FunctionsAfter
+       << ", instructions: " << InstructionsBefore << " -> "
+       << InstructionsAfter << "\n";
+    os << "peak resident set size: "
+       << JobStats::getPeakResidentSetSize() / 1024 << " KiB\n";
+  }
+};
+
+} // end anonymous namespace
+
+/// Returns the number of functions with a body, and the number of
+/// instructions, in \p M.
+static std::pair<uint64_t, uint64_t> getModuleSize(SILModule &M) {
+  uint64_t Functions = 0, Instructions = 0;
+  for (auto &F : M) {
+    if (F.empty())
+      continue;
+    ++Functions;
+    for (auto &BB : F)
+      Instructions += std::distance(BB.begin(), BB.end());
+  }
+  return {Functions, Instructions};
+}
+
 static void runCommandLineSelectedPasses(SILModule *Module) {
   SILPassManager PM(Module);
 
@@ -162,6 +329,54 @@ static void runCommandLineSelectedPasses(SILModule *Module) {
   PM.run();
 }
 
+static void runSelectedPipeline(SILModule &Module) {
+  if (OptimizationGroup == OptGroup::Diagnostics) {
+    runSILDiagnosticPasses(Module);
+  } else if (OptimizationGroup == OptGroup::Performance) {
+    runSILOptimizationPasses(Module);
+  } else {
+    runCommandLineSelectedPasses(&Module);
+  }
+}
+
+/// Sets up \p CI for \p Invocation, type checks the input and loads its
+/// SIL. Returns true on error.
+static bool loadInput(CompilerInstance &CI, CompilerInvocation &Invocation,
+                      bool HasSerializedAST,
+                      const serialization::ExtendedValidationInfo &extendedInfo) {
+  if (CI.setup(Invocation))
+    return true;
+
+  CI.performSema();
+
+  // If parsing produced an error, don't run any passes.
+  if (CI.getASTContext().hadError())
+    return true;
+
+  // Load the SIL if we have a module. We have to do this after SILParse
+  // creating the unfortunate double if statement.
+  if (HasSerializedAST) {
+    assert(!CI.hasSILModule() &&
+           "performSema() should not create a SILModule.");
+    CI.setSILModule(SILModule::createEmptyModule(CI.getMainModule(),
+                                                 CI.getSILOptions()));
+    std::unique_ptr<SerializedSILLoader> SL = SerializedSILLoader::create(
+        CI.getASTContext(), CI.getSILModule(), nullptr);
+
+    if (extendedInfo.isSIB())
+      SL->getAllForModule(CI.getMainModule()->getName(), nullptr);
+    else
+      SL->getAll();
+  }
+
+  // If we're in verify mode, install a custom diagnostic handling for
+  // SourceMgr.
+  if (VerifyMode)
+    enableDiagnosticVerifier(CI.getSourceMgr());
+
+  return false;
+}
+
 // This function isn't referenced outside its translation unit, but it
 // can't use the "static" keyword because its address is used for
 // getMainExecutable (since some platforms don't support taking the
@@ -214,6 +429,8 @@ int main(int argc, char **argv) {
   SILOptions &SILOpts = Invocation.getSILOptions();
   SILOpts.InlineThreshold = SILInlineThreshold;
   SILOpts.VerifyAll = EnableSILVerifyAll;
+  SILOpts.VerifySampleRate = SILVerifySampleRate;
+  SILOpts.VerifyIncremental = SILVerifyIncremental;
   SILOpts.RemoveRuntimeAsserts = RemoveRuntimeAsserts;
   SILOpts.AssertConfig = AssertConfId;
   if (OptimizationGroup != OptGroup::Diagnostics)
@@ -249,10 +466,6 @@ int main(int argc, char **argv) {
     Invocation.setInputKind(InputFileKind::IFK_SIL);
   }
 
-  CompilerInstance CI;
-  PrintingDiagnosticConsumer PrintDiags;
-  CI.addDiagnosticConsumer(&PrintDiags);
-
   if (!PerformWMO) {
     auto &FrontendOpts = Invocation.getFrontendOptions();
     if (!InputFilename.empty() && InputFilename != "-") {
@@ -264,43 +477,41 @@ int main(int argc, char **argv) {
     }
   }
 
-  if (CI.setup(Invocation))
-    return 1;
-
-  CI.performSema();
-
-  // If parsing produced an error, don't run any passes.
-  if (CI.getASTContext().hadError())
-    return 1;
-
-  // Load the SIL if we have a module. We have to do this after SILParse
-  // creating the unfortunate double if statement.
-  if (HasSerializedAST) {
-    assert(!CI.hasSILModule() &&
-           "performSema() should not create a SILModule.");
-    CI.setSILModule(SILModule::createEmptyModule(CI.getMainModule(),
-                                                 CI.getSILOptions()));
-    std::unique_ptr<SerializedSILLoader> SL = SerializedSILLoader::create(
-        CI.getASTContext(), CI.getSILModule(), nullptr);
+  PrintingDiagnosticConsumer PrintDiags;
+  std::unique_ptr<CompilerInstance> Instance;
+
+  // When benchmarking, each run of the pipeline starts from a freshly parsed
+  // module, with fresh analyses. The module of the last run is printed.
+  PipelineBenchmark Benchmark;
+  unsigned NumRuns = BenchIterations ? BenchWarmup + BenchIterations : 1;
+  for (unsigned Run = 0; Run != NumRuns; ++Run) {
+    Instance.reset(new CompilerInstance());
+    Instance->addDiagnosticConsumer(&PrintDiags);
+    if (loadInput(*Instance, Invocation, HasSerializedAST, extendedInfo))
+      return 1;
+
+    SILModule &Module = *Instance->getSILModule();
+    bool Measured = BenchIterations && Run >= BenchWarmup;
+    if (!Measured) {
+      runSelectedPipeline(Module);
+      continue;
+    }
 
-    if (extendedInfo.isSIB())
-      SL->getAllForModule(CI.getMainModule()->getName(), nullptr);
-    else
-      SL->getAll();
+    auto SizeBefore = getModuleSize(Module);
+    SILPassRunObserver::setActive(&Benchmark);
+    auto Start = std::chrono::steady_clock::now();
+    runSelectedPipeline(Module);
+    auto Elapsed = std::chrono::steady_clock::now() - Start;
+    SILPassRunObserver::setActive(nullptr);
+    Benchmark.finishIteration(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Elapsed).count(),
+        SizeBefore, getModuleSize(Module));
   }
 
-  // If we're in verify mode, install a custom diagnostic handling for
-  // SourceMgr.
-  if (VerifyMode)
-    enableDiagnosticVerifier(CI.getSourceMgr());
+  if (BenchIterations)
+    Benchmark.print(llvm::errs());
 
-  if (OptimizationGroup == OptGroup::Diagnostics) {
-    runSILDiagnosticPasses(*CI.getSILModule());
-  } else if (OptimizationGroup == OptGroup::Performance) {
-    runSILOptimizationPasses(*CI.getSILModule());
-  } else {
-    runCommandLineSelectedPasses(CI.getSILModule());
-  }
+  CompilerInstance &CI = *Instance;
 
   if (EmitSIB) {
     llvm::SmallString<128> OutputFile;
@@ -15,14 +15,19 @@
 //===----------------------------------------------------------------------===//
 
 #include "swift/Basic/DemangleWrappers.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
-#include "llvm/Support/Regex.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <string>
+#include <thread>
+#include <vector>
 
 static llvm::cl::opt<bool>
 ExpandMode("expand",
@@ -48,6 +53,17 @@ static llvm::cl::opt<bool>
 Simplified("simplified",
            llvm::cl::desc("Don't display module names or implicit self types"));
 
+static llvm::cl::opt<unsigned>
+BenchmarkIterations("benchmark-iterations",
+           llvm::cl::desc("Demangle and print the input names this many times "
+                          "and report the throughput instead of the output"),
+           llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned>
+NumThreads("num-threads",
+           llvm::cl::desc("Demangle standard input on this many threads"),
+           llvm::cl::init(1));
+
 static llvm::cl::list<std::string>
 InputNames(llvm::cl::Positional, llvm::cl::desc("[mangled name...]"),
                llvm::cl::ZeroOrMore);
@@ -62,29 +78,55 @@ static void demangle(llvm::raw_ostream &os, llvm::StringRef name,
   swift::Demangle::NodePointer pointer =
       swift::demangle_wrappers::demangleSymbolAsNode(name);
   if (ExpandMode || TreeOnly) {
-    llvm::outs() << "Demangling for " << name << '\n';
-    swift::demangle_wrappers::NodeDumper(pointer).print(llvm::outs());
+    os << "Demangling for " << name << '\n';
+    swift::demangle_wrappers::NodeDumper(pointer).print(os);
   }
   if (RemangleMode) {
-    if (hadLeadingUnderscore) llvm::outs() << '_';
+    if (hadLeadingUnderscore) os << '_';
     // Just reprint the original mangled name if it didn't demangle.
     // This makes it easier to share the same database between the
     // mangling and demangling tests.
     if (!pointer) {
-      llvm::outs() << name;
+      os << name;
     } else {
-      llvm::outs() << swift::Demangle::mangleNode(pointer);
+      os << swift::Demangle::mangleNode(pointer);
     }
     return;
   }
   if (!TreeOnly) {
     std::string string = swift::Demangle::nodeToString(pointer, options);
     if (!CompactMode)
-      llvm::outs() << name << " ---> ";
-    llvm::outs() << (string.empty() ? name : llvm::StringRef(string));
+      os << name << " ---> ";
+    os << (string.empty() ? name : llvm::StringRef(string));
   }
 }
 
+/// Demangles and prints every name in \p names BenchmarkIterations times,
+/// and reports how long that took.
+static void benchmark(llvm::ArrayRef<llvm::StringRef> names,
+                      const swift::Demangle::DemangleOptions &options) {
+  size_t totalLength = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i != BenchmarkIterations; ++i) {
+    for (llvm::StringRef name : names) {
+      swift::Demangle::NodePointer pointer =
+          swift::demangle_wrappers::demangleSymbolAsNode(name);
+      totalLength += swift::Demangle::nodeToString(pointer, options).size();
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  uint64_t count = uint64_t(names.size()) * BenchmarkIterations;
+  llvm::outs() << "demangled " << count << " symbols ("
+               << totalLength << " characters) in " << elapsed.count()
+               << " s";
+  if (elapsed.count() > 0)
+    llvm::outs() << ", " << uint64_t(count / elapsed.count())
+                 << " symbols/s";
+  llvm::outs() << '\n';
+}
+
 static llvm::StringRef substrBefore(llvm::StringRef whole,
                                     llvm::StringRef part) {
   return whole.slice(0, part.data() - whole.data());
@@ -95,6 +137,110 @@ static llvm::StringRef substrAfter(llvm::StringRef whole,
   return whole.substr((part.data() - whole.data()) + part.size());
 }
 
+static bool isSymbolChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
+
+/// Returns the first "_T" followed by [_a-zA-Z0-9$]+ in \p text, or an empty
+/// string if there is none.
+///
+/// This doesn't handle Unicode symbols, but maybe that's okay.
+static llvm::StringRef findMaybeSymbol(llvm::StringRef text) {
+  size_t start = 0;
+  while ((start = text.find("_T", start)) != llvm::StringRef::npos) {
+    size_t end = start + 2;
+    while (end != text.size() && isSymbolChar(text[end]))
+      ++end;
+    if (end != start + 2)
+      return text.slice(start, end);
+    start = end;
+  }
+  return llvm::StringRef();
+}
+
+/// The most demanglings each thread remembers before starting over.
+static const size_t MaxCachedDemanglings = 1 << 16;
+
+/// Copies \p text to \p os with every symbol in it demangled. Demanglings
+/// are remembered in \p cache, since symbolicated logs and profiles repeat
+/// the same few symbols many times.
+static void demangleText(llvm::raw_ostream &os, llvm::StringRef text,
+                         const swift::Demangle::DemangleOptions &options,
+                         llvm::StringMap<std::string> &cache) {
+  for (llvm::StringRef symbol = findMaybeSymbol(text); !symbol.empty();
+       symbol = findMaybeSymbol(text)) {
+    os << substrBefore(text, symbol);
+    if (cache.size() >= MaxCachedDemanglings)
+      cache.clear();
+    std::string &demangled = cache[symbol];
+    if (demangled.empty()) {
+      llvm::raw_string_ostream demangledOS(demangled);
+      demangle(demangledOS, symbol, options);
+    }
+    os << demangled;
+    text = substrAfter(text, symbol);
+  }
+  os << text;
+}
+
+/// Copies \p input to llvm::outs() with every symbol in it demangled.
+///
+/// The input is read in chunks which end at a line break, so that no symbol
+/// is split between two chunks. With more than one thread, each thread
+/// demangles one of a batch of chunks at a time, and the batch is printed in
+/// order when all of them are done.
+static bool demangleStream(FILE *input,
+                           const swift::Demangle::DemangleOptions &options) {
+  const size_t ChunkSize = 1 << 20;
+  unsigned numChunks = std::max(1u, unsigned(NumThreads));
+  std::vector<std::string> chunks(numChunks);
+  std::vector<std::string> outputs(numChunks);
+  std::vector<llvm::StringMap<std::string>> caches(numChunks);
+  std::string partialLine;
+
+  auto work = [&](unsigned i) {
+    outputs[i].clear();
+    llvm::raw_string_ostream os(outputs[i]);
+    demangleText(os, chunks[i], options, caches[i]);
+  };
+
+  bool atEnd = false;
+  while (!atEnd) {
+    unsigned numFilled = 0;
+    while (numFilled != numChunks && !atEnd) {
+      std::string &chunk = chunks[numFilled++];
+      chunk.swap(partialLine);
+      partialLine.clear();
+      size_t oldSize = chunk.size();
+      chunk.resize(oldSize + ChunkSize);
+      size_t bytesRead = fread(&chunk[oldSize], 1, ChunkSize, input);
+      chunk.resize(oldSize + bytesRead);
+      if (bytesRead != ChunkSize) {
+        if (ferror(input))
+          return false;
+        atEnd = true;
+        break;
+      }
+      size_t end = chunk.rfind('\n');
+      end = (end == std::string::npos) ? 0 : end + 1;
+      partialLine.assign(chunk, end, std::string::npos);
+      chunk.resize(end);
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < numFilled; ++i)
+      workers.emplace_back(work, i);
+    work(0);
+    for (auto &worker : workers)
+      worker.join();
+
+    for (unsigned i = 0; i != numFilled; ++i)
+      llvm::outs() << outputs[i];
+  }
+  return true;
+}
+
 int main(int argc, char **argv) {
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
@@ -105,23 +251,31 @@ int main(int argc, char **argv) {
 
   if (InputNames.empty()) {
     CompactMode = true;
+    if (!BenchmarkIterations) {
+      if (!demangleStream(stdin, options)) {
+        llvm::errs() << "error reading standard input\n";
+        return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+    }
+
     auto input = llvm::MemoryBuffer::getSTDIN();
     if (!input) {
       llvm::errs() << input.getError().message() << '\n';
       return EXIT_FAILURE;
     }
     llvm::StringRef inputContents = input.get()->getBuffer();
-
-    // This doesn't handle Unicode symbols, but maybe that's okay.
-    llvm::Regex maybeSymbol("_T[_a-zA-Z0-9$]+");
-    llvm::SmallVector<llvm::StringRef, 1> matches;
-    while (maybeSymbol.match(inputContents, &matches)) {
-      llvm::outs() << substrBefore(inputContents, matches.front());
-      demangle(llvm::outs(), matches.front(), options);
-      inputContents = substrAfter(inputContents, matches.front());
+    std::vector<llvm::StringRef> names;
+    for (llvm::StringRef symbol = findMaybeSymbol(inputContents);
+         !symbol.empty(); symbol = findMaybeSymbol(inputContents)) {
+      names.push_back(symbol);
+      inputContents = substrAfter(inputContents, symbol);
     }
-    llvm::outs() << inputContents;
+    benchmark(names, options);
 
+  } else if (BenchmarkIterations) {
+    std::vector<llvm::StringRef> names(InputNames.begin(), InputNames.end());
+    benchmark(names, options);
   } else {
     for (llvm::StringRef name : InputNames) {
       demangle(llvm::outs(), name, options);
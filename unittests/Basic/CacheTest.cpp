@@ -0,0 +1,113 @@
+//===- CacheTest.cpp - for swift/Basic/Cache.h ----------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/Cache.h"
+#include "gtest/gtest.h"
+
+using namespace swift::sys;
+
+namespace {
+/// A reference-counted value that records when it's destroyed.
+struct Tracked : llvm::ThreadSafeRefCountedBase<Tracked> {
+  size_t Cost;
+  bool *Destroyed;
+
+  Tracked(size_t Cost, bool *Destroyed) : Cost(Cost), Destroyed(Destroyed) {}
+  ~Tracked() { *Destroyed = true; }
+};
+typedef llvm::IntrusiveRefCntPtr<Tracked> TrackedRef;
+} // end anonymous namespace
+
+namespace swift {
+namespace sys {
+template <>
+struct CacheValueCostInfo<Tracked> {
+  static size_t getCost(const Tracked &Value) { return Value.Cost; }
+};
+} // end namespace sys
+} // end namespace swift
+
+TEST(Cache, SetGetRemove) {
+  Cache<int, TrackedRef> C("test.cache");
+  bool Destroyed = false;
+  C.set(1, new Tracked(10, &Destroyed));
+
+  auto Value = C.get(1);
+  ASSERT_TRUE(Value.hasValue());
+  EXPECT_EQ(10u, (*Value)->Cost);
+  EXPECT_FALSE(C.get(2).hasValue());
+
+  EXPECT_TRUE(C.remove(1));
+  EXPECT_FALSE(C.remove(1));
+  EXPECT_FALSE(C.get(1).hasValue());
+
+  // We still hold a reference.
+  EXPECT_FALSE(Destroyed);
+  Value.reset();
+  EXPECT_TRUE(Destroyed);
+}
+
+#if !defined(__APPLE__)
+// libcache only takes the cost limit as a hint, so these only check the
+// default implementation.
+
+TEST(Cache, EvictsLeastRecentlyUsed) {
+  Cache<int, TrackedRef> C("test.cache");
+  C.setCostLimit(100);
+
+  bool Destroyed[3] = { false, false, false };
+  C.set(0, new Tracked(40, &Destroyed[0]));
+  C.set(1, new Tracked(40, &Destroyed[1]));
+  // Touch 0 so that 1 is the least recently used entry.
+  EXPECT_TRUE(C.get(0).hasValue());
+  C.set(2, new Tracked(40, &Destroyed[2]));
+
+  EXPECT_TRUE(C.get(0).hasValue());
+  EXPECT_FALSE(C.get(1).hasValue());
+  EXPECT_TRUE(C.get(2).hasValue());
+  EXPECT_FALSE(Destroyed[0]);
+  EXPECT_TRUE(Destroyed[1]);
+  EXPECT_FALSE(Destroyed[2]);
+}
+
+TEST(Cache, KeepsNewestEntryOverLimit) {
+  Cache<int, TrackedRef> C("test.cache");
+  C.setCostLimit(10);
+
+  bool Destroyed[2] = { false, false };
+  C.set(0, new Tracked(5, &Destroyed[0]));
+  C.set(1, new Tracked(50, &Destroyed[1]));
+  EXPECT_FALSE(C.get(0).hasValue());
+  EXPECT_TRUE(C.get(1).hasValue());
+  EXPECT_TRUE(Destroyed[0]);
+
+  // Lowering the limit doesn't evict the only entry either.
+  C.setCostLimit(0);
+  EXPECT_TRUE(C.get(1).hasValue());
+  EXPECT_FALSE(Destroyed[1]);
+}
+
+TEST(Cache, ReplacingKeepsCostAccurate) {
+  Cache<int, TrackedRef> C("test.cache");
+  C.setCostLimit(100);
+
+  bool Destroyed[3] = { false, false, false };
+  C.set(0, new Tracked(60, &Destroyed[0]));
+  C.set(0, new Tracked(30, &Destroyed[1]));
+  EXPECT_TRUE(Destroyed[0]);
+
+  // 30 + 60 fits, so replacing the value must have dropped its old cost.
+  C.set(1, new Tracked(60, &Destroyed[2]));
+  EXPECT_TRUE(C.get(0).hasValue());
+  EXPECT_TRUE(C.get(1).hasValue());
+}
+#endif
@@ -1,4 +1,5 @@
 #include "swift/Basic/ClusteredBitVector.h"
+#include "llvm/ADT/APInt.h"
 #include "gtest/gtest.h"
 
 using namespace swift;
@@ -208,3 +209,43 @@ TEST(ClusteredBitVector, FlipAllBig) {
   EXPECT_EQ(true, vec[7]);
   EXPECT_EQ(1u, vec.count());
 }
+
+TEST(ClusteredBitVector, AppendUnaligned) {
+  ClusteredBitVector vec;
+  vec.appendSetBits(3);
+  vec.appendClearBits(130);
+  vec.appendSetBits(200);
+  EXPECT_EQ(333u, vec.size());
+  EXPECT_EQ(203u, vec.count());
+  EXPECT_EQ(true, vec[2]);
+  EXPECT_EQ(false, vec[3]);
+  EXPECT_EQ(false, vec[132]);
+  EXPECT_EQ(true, vec[133]);
+  EXPECT_EQ(true, vec[332]);
+
+  ClusteredBitVector other;
+  other.appendClearBits(64);
+  other.append(vec);
+  EXPECT_EQ(397u, other.size());
+  EXPECT_EQ(203u, other.count());
+  EXPECT_EQ(true, other[66]);
+  EXPECT_EQ(false, other[67]);
+  EXPECT_EQ(true, other[396]);
+}
+
+TEST(ClusteredBitVector, APIntRoundTrip) {
+  llvm::APInt bits(150, 0);
+  EXPECT_EQ(150u, ClusteredBitVector::fromAPInt(bits).size());
+  EXPECT_EQ(0u, ClusteredBitVector::fromAPInt(bits).count());
+
+  bits.setBit(0);
+  bits.setBit(70);
+  bits.setBit(149);
+  ClusteredBitVector vec = ClusteredBitVector::fromAPInt(bits);
+  EXPECT_EQ(150u, vec.size());
+  EXPECT_EQ(3u, vec.count());
+  EXPECT_EQ(true, vec[0]);
+  EXPECT_EQ(true, vec[70]);
+  EXPECT_EQ(true, vec[149]);
+  EXPECT_EQ(bits, vec.asAPInt());
+}
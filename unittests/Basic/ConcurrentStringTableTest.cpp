@@ -0,0 +1,86 @@
+//===- ConcurrentStringTableTest.cpp - for swift/Basic/ConcurrentStringTable.h//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/ConcurrentStringTable.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace swift;
+
+TEST(ConcurrentStringTable, Uniquing) {
+  ConcurrentStringTable Table;
+  std::string Foo = "foo";
+
+  const char *A = Table.intern("foo");
+  const char *B = Table.intern(Foo);
+  const char *C = Table.intern("bar");
+  EXPECT_EQ(A, B);
+  EXPECT_NE(A, C);
+  EXPECT_NE(Foo.data(), A);
+  EXPECT_STREQ("foo", A);
+  EXPECT_STREQ("bar", C);
+  EXPECT_EQ(2U, Table.size());
+
+  // The empty string and strings with embedded NULs are interned too.
+  EXPECT_EQ(Table.intern(""), Table.intern(""));
+  EXPECT_NE(Table.intern(StringRef("a\0b", 3)), Table.intern("a"));
+  EXPECT_EQ(5U, Table.size());
+}
+
+TEST(ConcurrentStringTable, Growth) {
+  ConcurrentStringTable Table;
+  std::vector<const char *> Interned;
+  for (unsigned I = 0; I != 10000; ++I)
+    Interned.push_back(Table.intern("name" + std::to_string(I)));
+
+  EXPECT_EQ(10000U, Table.size());
+  for (unsigned I = 0; I != 10000; ++I) {
+    std::string Name = "name" + std::to_string(I);
+    EXPECT_EQ(Interned[I], Table.intern(Name));
+    EXPECT_EQ(Name, Interned[I]);
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(Interned[I]) % 4);
+  }
+  EXPECT_EQ(10000U, Table.size());
+}
+
+TEST(ConcurrentStringTable, ConcurrentInterning) {
+  ConcurrentStringTable Table;
+  const unsigned NumThreads = 8;
+  const unsigned NumNames = 5000;
+
+  // Every thread interns the same names, in a different order, so that
+  // lookups race with insertions and rehashing.
+  std::vector<std::vector<const char *>> Results(NumThreads);
+  std::vector<std::thread> Threads;
+  for (unsigned T = 0; T != NumThreads; ++T) {
+    Threads.emplace_back([&, T] {
+      auto &Interned = Results[T];
+      Interned.resize(NumNames);
+      for (unsigned I = 0; I != NumNames; ++I) {
+        unsigned Index = (I * 7 + T * 131) % NumNames;
+        Interned[Index] = Table.intern("name" + std::to_string(Index));
+      }
+    });
+  }
+  for (auto &Thread : Threads)
+    Thread.join();
+
+  EXPECT_EQ(NumNames, Table.size());
+  for (unsigned I = 0; I != NumNames; ++I) {
+    EXPECT_EQ("name" + std::to_string(I), Results[0][I]);
+    for (unsigned T = 1; T != NumThreads; ++T)
+      EXPECT_EQ(Results[0][I], Results[T][I]);
+  }
+}
@@ -0,0 +1,206 @@
+//===- TaskQueueTest.cpp - for swift/Basic/TaskQueue.h --------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/TaskQueue.h"
+#include "gtest/gtest.h"
+
+#if LLVM_ON_UNIX
+
+#include <chrono>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace swift;
+using namespace swift::sys;
+
+namespace {
+
+/// Sets MAKEFLAGS to point at a jobserver pipe with the given number of
+/// tokens, and restores it afterwards.
+class FakeJobserver {
+  int Fds[2];
+  std::string OldMakeFlags;
+  bool HadMakeFlags;
+
+public:
+  explicit FakeJobserver(unsigned NumTokens) {
+    EXPECT_EQ(0, pipe(Fds));
+    for (unsigned i = 0; i != NumTokens; ++i)
+      EXPECT_EQ(1, write(Fds[1], "+", 1));
+
+    const char *MakeFlags = getenv("MAKEFLAGS");
+    HadMakeFlags = MakeFlags != nullptr;
+    if (HadMakeFlags)
+      OldMakeFlags = MakeFlags;
+    std::string Flags = "-j --jobserver-auth=" + std::to_string(Fds[0]) +
+                        "," + std::to_string(Fds[1]);
+    setenv("MAKEFLAGS", Flags.c_str(), 1);
+  }
+
+  ~FakeJobserver() {
+    if (HadMakeFlags)
+      setenv("MAKEFLAGS", OldMakeFlags.c_str(), 1);
+    else
+      unsetenv("MAKEFLAGS");
+    close(Fds[0]);
+    close(Fds[1]);
+  }
+
+  /// Returns the number of tokens which are currently in the pipe.
+  unsigned drainTokens() {
+    fcntl(Fds[0], F_SETFL, fcntl(Fds[0], F_GETFL) | O_NONBLOCK);
+    unsigned Count = 0;
+    char Token;
+    while (read(Fds[0], &Token, 1) == 1)
+      ++Count;
+    return Count;
+  }
+};
+
+/// Runs \p NumTasks short tasks and returns the largest number of them which
+/// were executing at the same time.
+unsigned runTasks(unsigned NumberOfParallelTasks, unsigned NumTasks) {
+  TaskQueue TQ(NumberOfParallelTasks);
+  static const char *Args[] = { "-c", "sleep 0.1" };
+  for (unsigned i = 0; i != NumTasks; ++i)
+    TQ.addTask("/bin/sh", Args);
+
+  unsigned Executing = 0, MaxExecuting = 0;
+  TQ.execute(
+    [&](ProcessId Pid, void *Context) {
+      MaxExecuting = std::max(MaxExecuting, ++Executing);
+    },
+    [&](ProcessId Pid, int ReturnCode, StringRef Output, void *Context) {
+      EXPECT_EQ(0, ReturnCode);
+      --Executing;
+      return TaskFinishedResponse::ContinueExecution;
+    });
+  EXPECT_EQ(0U, Executing);
+  return MaxExecuting;
+}
+
+} // end anonymous namespace
+
+TEST(TaskQueueTest, JobserverLimitsParallelism) {
+  FakeJobserver Jobserver(2);
+  // Two tokens plus the implicit one.
+  EXPECT_EQ(3U, runTasks(8, 6));
+  EXPECT_EQ(2U, Jobserver.drainTokens());
+}
+
+TEST(TaskQueueTest, JobserverWithoutTokens) {
+  FakeJobserver Jobserver(0);
+  EXPECT_EQ(1U, runTasks(4, 3));
+  EXPECT_EQ(0U, Jobserver.drainTokens());
+}
+
+TEST(TaskQueueTest, ParallelLimitWithJobserver) {
+  FakeJobserver Jobserver(8);
+  EXPECT_EQ(2U, runTasks(2, 4));
+  EXPECT_EQ(8U, Jobserver.drainTokens());
+}
+
+TEST(TaskQueueTest, SlowCallbackDoesNotDelayNextTask) {
+  char Dir[] = "/tmp/TaskQueueTest.XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(Dir));
+  std::string Marker = std::string(Dir) + "/second";
+  std::string Touch = "touch " + Marker;
+
+  TaskQueue TQ(1);
+  static const char *FirstArgs[] = { "-c", "true" };
+  const char *SecondArgs[] = { "-c", Touch.c_str() };
+  TQ.addTask("/bin/sh", FirstArgs);
+  TQ.addTask("/bin/sh", SecondArgs);
+
+  bool SawSecondTask = false;
+  unsigned NumFinished = 0;
+  bool Failed = TQ.execute(nullptr,
+    [&](ProcessId Pid, int ReturnCode, StringRef Output, void *Context) {
+      if (NumFinished++ == 0) {
+        // The second task should run while this callback is still busy.
+        for (unsigned i = 0; i != 500 && !SawSecondTask; ++i) {
+          SawSecondTask = access(Marker.c_str(), F_OK) == 0;
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      }
+      return TaskFinishedResponse::ContinueExecution;
+    });
+
+  EXPECT_FALSE(Failed);
+  EXPECT_EQ(2U, NumFinished);
+  EXPECT_TRUE(SawSecondTask);
+  unlink(Marker.c_str());
+  rmdir(Dir);
+}
+
+TEST(TaskQueueTest, StopAfterFailure) {
+  TaskQueue TQ(1);
+  static const char *FailArgs[] = { "-c", "exit 3" };
+  static const char *SucceedArgs[] = { "-c", "true" };
+  TQ.addTask("/bin/sh", FailArgs);
+  TQ.addTask("/bin/sh", SucceedArgs);
+
+  unsigned NumBegan = 0;
+  bool Failed = TQ.execute(
+    [&](ProcessId Pid, void *Context) { ++NumBegan; },
+    [&](ProcessId Pid, int ReturnCode, StringRef Output, void *Context) {
+      EXPECT_EQ(3, ReturnCode);
+      return TaskFinishedResponse::StopExecution;
+    });
+
+  EXPECT_TRUE(Failed);
+  EXPECT_EQ(1U, NumBegan);
+}
+
+TEST(TaskQueueTest, ContinueAfterFailure) {
+  TaskQueue TQ(1);
+  static const char *FailArgs[] = { "-c", "exit 3" };
+  static const char *SucceedArgs[] = { "-c", "true" };
+  TQ.addTask("/bin/sh", FailArgs);
+  TQ.addTask("/bin/sh", SucceedArgs);
+
+  unsigned NumFinished = 0;
+  bool Failed = TQ.execute(nullptr,
+    [&](ProcessId Pid, int ReturnCode, StringRef Output, void *Context) {
+      ++NumFinished;
+      return TaskFinishedResponse::ContinueExecution;
+    });
+
+  EXPECT_FALSE(Failed);
+  EXPECT_EQ(2U, NumFinished);
+}
+
+TEST(TaskQueueTest, CallbackAddsTask) {
+  TaskQueue TQ(2);
+  static const char *Args[] = { "-c", "echo hello" };
+  TQ.addTask("/bin/sh", Args);
+
+  std::vector<std::string> Outputs;
+  bool Failed = TQ.execute(nullptr,
+    [&](ProcessId Pid, int ReturnCode, StringRef Output, void *Context) {
+      Outputs.push_back(Output.str());
+      if (Outputs.size() < 3)
+        TQ.addTask("/bin/sh", Args);
+      return TaskFinishedResponse::ContinueExecution;
+    });
+
+  EXPECT_FALSE(Failed);
+  ASSERT_EQ(3U, Outputs.size());
+  for (auto &Output : Outputs)
+    EXPECT_EQ("hello\n", Output);
+}
+
+#endif
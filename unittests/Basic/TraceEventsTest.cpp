@@ -0,0 +1,83 @@
+//===- TraceEventsTest.cpp - for swift/Basic/TraceEvents.h ----------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/TraceEvents.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace swift;
+
+TEST(TraceEvents, Write) {
+  TraceEventRecorder recorder;
+  recorder.addSpan("Parse \"main.swift\"", "frontend", 100, 150, 2, 3);
+
+  std::string buffer;
+  llvm::raw_string_ostream out(buffer);
+  recorder.write(out);
+  out.flush();
+
+  EXPECT_EQ("[{\"name\":\"Parse \\\"main.swift\\\"\",\"cat\":\"frontend\","
+            "\"ph\":\"X\",\"ts\":100,\"dur\":50,\"pid\":2,\"tid\":3}]\n",
+            buffer);
+}
+
+TEST(TraceEvents, RoundTrip) {
+  TraceEventRecorder frontend;
+  frontend.addSpan("Parse", "frontend", 100, 150);
+  frontend.addSpan("IRGen \"main\"", "frontend", 150, 400, 7, 8);
+
+  std::string buffer;
+  llvm::raw_string_ostream out(buffer);
+  frontend.write(out);
+  out.flush();
+
+  TraceEventRecorder driver;
+  driver.addSpan("compile", "driver", 90, 410, 1, 2);
+  EXPECT_FALSE(driver.addEventsFrom(buffer, 1, 2));
+
+  ArrayRef<TraceEvent> events = driver.getEvents();
+  ASSERT_EQ(3u, events.size());
+  EXPECT_EQ("compile", events[0].Name);
+
+  EXPECT_EQ("Parse", events[1].Name);
+  EXPECT_EQ("frontend", events[1].Category);
+  EXPECT_EQ(100u, events[1].Start);
+  EXPECT_EQ(50u, events[1].Duration);
+  EXPECT_EQ(1u, events[1].ProcessID);
+  EXPECT_EQ(2u, events[1].ThreadID);
+
+  EXPECT_EQ("IRGen \"main\"", events[2].Name);
+  EXPECT_EQ(150u, events[2].Start);
+  EXPECT_EQ(250u, events[2].Duration);
+  EXPECT_EQ(1u, events[2].ProcessID);
+  EXPECT_EQ(2u, events[2].ThreadID);
+}
+
+TEST(TraceEvents, Malformed) {
+  TraceEventRecorder recorder;
+  EXPECT_TRUE(recorder.addEventsFrom("", 1, 0));
+  EXPECT_TRUE(recorder.addEventsFrom("{\"name\": \"Parse\"}", 1, 0));
+  EXPECT_TRUE(recorder.addEventsFrom("[{\"ts\": \"soon\"}]", 1, 0));
+  EXPECT_TRUE(recorder.addEventsFrom("[{\"name\": \"Parse\"}, 4]", 1, 0));
+  EXPECT_TRUE(recorder.getEvents().empty());
+}
+
+TEST(TraceEvents, Scope) {
+  TraceEventRecorder recorder;
+  {
+    TraceEventScope scope(&recorder, "SILGen", "frontend");
+    TraceEventScope ignored(nullptr, "IRGen", "frontend");
+  }
+  ASSERT_EQ(1u, recorder.getEvents().size());
+  EXPECT_EQ("SILGen", recorder.getEvents()[0].Name);
+  EXPECT_LE(recorder.getEvents()[0].Start, TraceEventRecorder::now());
+}
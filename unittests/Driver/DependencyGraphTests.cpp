@@ -1,4 +1,7 @@
 #include "swift/Driver/DependencyGraph.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace swift;
@@ -790,3 +793,260 @@ TEST(DependencyGraph, ChainedExternalPreMarked) {
   EXPECT_TRUE(graph.isMarked(0));
   EXPECT_FALSE(graph.isMarked(1));
 }
+
+TEST(DependencyGraph, ChangedMemberFingerprint) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "provides-member: [[a, \"\"], [a, foo, f1], "
+                                                   "[a, bar, b1]]\n"
+                                 "interface-hash: h1\n"
+                                 "interface-hash-excluding-members: x1"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1,
+                                 "depends-nominal: [a]\n"
+                                 "depends-member: [[a, foo]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2,
+                                 "depends-nominal: [a]\n"
+                                 "depends-member: [[a, bar]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(3,
+                                 "depends-member: [[a, \"\"]]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "provides-member: [[a, \"\"], [a, foo, f1], "
+                                                   "[a, bar, b2]]\n"
+                                 "interface-hash: h2\n"
+                                 "interface-hash-excluding-members: x1"),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(2u, marked.size());
+  EXPECT_TRUE(contains(marked, 2));
+  EXPECT_TRUE(contains(marked, 3));
+  EXPECT_FALSE(graph.isMarked(1));
+  EXPECT_TRUE(graph.isMarked(2));
+  EXPECT_TRUE(graph.isMarked(3));
+}
+
+TEST(DependencyGraph, AddedAndRemovedMembers) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-member: [[a, foo, f1], "
+                                                   "[a, bar, b1]]\n"
+                                 "interface-hash: h1\n"
+                                 "interface-hash-excluding-members: x1"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1,
+                                 "depends-member: [[a, foo]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2,
+                                 "depends-member: [[a, bar]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(3,
+                                 "depends-member: [[a, baz]]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-member: [[a, foo, f1], "
+                                                   "[a, baz, z1]]\n"
+                                 "interface-hash: h2\n"
+                                 "interface-hash-excluding-members: x1"),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(2u, marked.size());
+  EXPECT_TRUE(contains(marked, 2));
+  EXPECT_TRUE(contains(marked, 3));
+  EXPECT_FALSE(graph.isMarked(1));
+}
+
+TEST(DependencyGraph, ChangedMembersAndDynamicLookup) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-member: [[a, foo, f1], "
+                                                   "[a, bar, b1]]\n"
+                                 "provides-dynamic-lookup: [foo, bar]\n"
+                                 "interface-hash: h1\n"
+                                 "interface-hash-excluding-members: x1"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1,
+                                 "depends-dynamic-lookup: [foo]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2,
+                                 "depends-dynamic-lookup: [bar]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-member: [[a, foo, f2], "
+                                                   "[a, bar, b1]]\n"
+                                 "provides-dynamic-lookup: [foo, bar]\n"
+                                 "interface-hash: h2\n"
+                                 "interface-hash-excluding-members: x1"),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(1u, marked.size());
+  EXPECT_EQ(1u, marked.front());
+  EXPECT_FALSE(graph.isMarked(2));
+}
+
+TEST(DependencyGraph, ChangedOutsideMembers) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "provides-member: [[a, foo, f1], "
+                                                   "[a, bar, b1]]\n"
+                                 "interface-hash: h1\n"
+                                 "interface-hash-excluding-members: x1"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1,
+                                 "depends-nominal: [a]\n"
+                                 "depends-member: [[a, foo]]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2,
+                                 "depends-nominal: [a]\n"
+                                 "depends-member: [[a, bar]]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "provides-member: [[a, foo, f1], "
+                                                   "[a, bar, b2]]\n"
+                                 "interface-hash: h2\n"
+                                 "interface-hash-excluding-members: x2"),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(2u, marked.size());
+  EXPECT_TRUE(graph.isMarked(1));
+  EXPECT_TRUE(graph.isMarked(2));
+}
+
+TEST(DependencyGraph, ChangedMembersWithoutPartialHash) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "provides-member: [[a, foo, f1], "
+                                                   "[a, bar, b1]]\n"
+                                 "interface-hash: h1"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1,
+                                 "depends-nominal: [a]\n"
+                                 "depends-member: [[a, foo]]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(graph.loadFromString(0,
+                                 "provides-nominal: [a]\n"
+                                 "provides-member: [[a, foo, f1], "
+                                                   "[a, bar, b2]]\n"
+                                 "interface-hash: h2"),
+            LoadResult::AffectsDownstream);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(1u, marked.size());
+  EXPECT_TRUE(graph.isMarked(1));
+}
+
+static void writeFile(StringRef path, StringRef contents) {
+  std::error_code error;
+  llvm::raw_fd_ostream out(path, error, llvm::sys::fs::F_None);
+  ASSERT_FALSE(error);
+  out << contents;
+}
+
+TEST(DependencyGraph, CacheRoundTrip) {
+  SmallString<128> dirPath;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("DependencyGraph-test",
+                                                    dirPath));
+  SmallString<128> depsPath = dirPath;
+  llvm::sys::path::append(depsPath, "a.swiftdeps");
+  SmallString<128> cachePath = dirPath;
+  llvm::sys::path::append(cachePath, "main.depgraph");
+
+  writeFile(depsPath, "provides-top-level: [a]\n"
+                      "provides-member: [[b, bb, fingerprint]]\n"
+                      "interface-hash: h1");
+
+  {
+    DependencyGraph<uintptr_t> graph;
+    EXPECT_EQ(graph.loadFromPath(0, depsPath), LoadResult::UpToDate);
+    EXPECT_FALSE(graph.writeCache(cachePath));
+  }
+
+  {
+    DependencyGraph<uintptr_t> graph;
+    EXPECT_FALSE(graph.loadCache(cachePath));
+    EXPECT_EQ(graph.loadFromPath(0, depsPath), LoadResult::UpToDate);
+    EXPECT_EQ(graph.loadFromString(1, "depends-top-level: [a]"),
+              LoadResult::UpToDate);
+    EXPECT_EQ(graph.loadFromString(2, "depends-member: [[b, bb]]"),
+              LoadResult::UpToDate);
+
+    SmallVector<uintptr_t, 4> marked;
+    graph.markTransitive(marked, 0);
+    EXPECT_EQ(2u, marked.size());
+    EXPECT_TRUE(graph.isMarked(1));
+    EXPECT_TRUE(graph.isMarked(2));
+  }
+
+  // A modified file is parsed again.
+  writeFile(depsPath, "provides-top-level: [c]\n"
+                      "interface-hash: h2");
+  {
+    DependencyGraph<uintptr_t> graph;
+    EXPECT_FALSE(graph.loadCache(cachePath));
+    EXPECT_EQ(graph.loadFromPath(0, depsPath), LoadResult::UpToDate);
+    EXPECT_EQ(graph.loadFromString(1, "depends-top-level: [a]"),
+              LoadResult::UpToDate);
+    EXPECT_EQ(graph.loadFromString(2, "depends-top-level: [c]"),
+              LoadResult::UpToDate);
+
+    SmallVector<uintptr_t, 4> marked;
+    graph.markTransitive(marked, 0);
+    EXPECT_EQ(1u, marked.size());
+    EXPECT_EQ(2u, marked.front());
+  }
+
+  llvm::sys::fs::remove(depsPath);
+  llvm::sys::fs::remove(cachePath);
+  llvm::sys::fs::remove(dirPath);
+}
+
+TEST(DependencyGraph, CorruptCache) {
+  SmallString<128> dirPath;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("DependencyGraph-test",
+                                                    dirPath));
+  SmallString<128> cachePath = dirPath;
+  llvm::sys::path::append(cachePath, "main.depgraph");
+
+  DependencyGraph<uintptr_t> graph;
+  EXPECT_TRUE(graph.loadCache(cachePath));
+
+  writeFile(cachePath, "provides-top-level: [a]");
+  EXPECT_TRUE(graph.loadCache(cachePath));
+
+  // A valid header followed by a truncated file entry.
+  writeFile(cachePath, StringRef("SDGC\x01\0\0\0\x01\0\0\0\x10\0", 14));
+  EXPECT_TRUE(graph.loadCache(cachePath));
+
+  // The graph can still load files.
+  EXPECT_EQ(graph.loadFromString(0, "provides-top-level: [a]"),
+            LoadResult::UpToDate);
+
+  llvm::sys::fs::remove(cachePath);
+  llvm::sys::fs::remove(dirPath);
+}
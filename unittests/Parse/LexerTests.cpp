@@ -352,3 +352,91 @@ TEST_F(LexerTest, NestedPlaceholder) {
   std::vector<Token> Toks = checkLex(Source, ExpectedTokens);
   EXPECT_EQ("<#aa#>", Toks[2].getText());
 }
+
+TEST_F(LexerTest, LongComments) {
+  const char *Source =
+      "// A line comment that is longer than a few words\n"
+      "a /* A block comment /* with a nested one */ and more text */ b\n"
+      "/* A block comment with a star * and a slash / inside it */ c\n"
+      "// Non-ASCII text in a comment: caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9\n"
+      "d /* unterminated block comment with a long body";
+  std::vector<tok> ExpectedTokens{
+    tok::comment, tok::identifier, tok::comment, tok::identifier,
+    tok::comment, tok::identifier, tok::comment, tok::identifier,
+    tok::comment
+  };
+  std::vector<Token> Toks = checkLex(Source, ExpectedTokens,
+                                     /*KeepComments=*/true);
+  EXPECT_EQ("// A line comment that is longer than a few words\n",
+            Toks[0].getText());
+  EXPECT_EQ("/* A block comment /* with a nested one */ and more text */",
+            Toks[2].getText());
+  EXPECT_EQ("/* A block comment with a star * and a slash / inside it */",
+            Toks[4].getText());
+  EXPECT_EQ("d", Toks[7].getText());
+}
+
+TEST_F(LexerTest, LongStringLiterals) {
+  const char *Source =
+      "\"a string literal that is longer than a few words\"\n"
+      "\"an escaped quote \\\" after a run of plain text\"\n"
+      "\"an interpolation \\(x + \"nested\") after a run of plain text\"\n"
+      "\"a single quote ' and a question mark ? inside a long literal\"\n"
+      "\"non-ASCII text in a literal: caf\xC3\xA9 na\xC3\xAFve\"\n"
+      "\"an unterminated literal with a long body\n";
+  std::vector<tok> ExpectedTokens{
+    tok::string_literal, tok::string_literal, tok::string_literal,
+    tok::string_literal, tok::string_literal, tok::unknown
+  };
+  std::vector<Token> Toks = checkLex(Source, ExpectedTokens);
+  EXPECT_EQ("\"a string literal that is longer than a few words\"",
+            Toks[0].getText());
+  EXPECT_EQ("\"an escaped quote \\\" after a run of plain text\"",
+            Toks[1].getText());
+  EXPECT_EQ("\"an interpolation \\(x + \"nested\") after a run of plain text\"",
+            Toks[2].getText());
+  EXPECT_EQ("\"an unterminated literal with a long body", Toks[5].getText());
+}
+
+TEST_F(LexerTest, LongIdentifiersAndIndentation) {
+  const char *Source =
+      "aVeryLongIdentifierName_with$Digits0123456789\n"
+      "                                another\n"
+      "\t\t  \t  mixedIndentation caf\xC3\xA9Latte";
+  std::vector<tok> ExpectedTokens{
+    tok::identifier, tok::identifier, tok::identifier, tok::identifier
+  };
+  std::vector<Token> Toks = checkLex(Source, ExpectedTokens);
+  EXPECT_EQ("aVeryLongIdentifierName_with$Digits0123456789",
+            Toks[0].getText());
+  EXPECT_EQ("another", Toks[1].getText());
+  EXPECT_TRUE(Toks[1].isAtStartOfLine());
+  EXPECT_EQ("mixedIndentation", Toks[2].getText());
+  EXPECT_TRUE(Toks[2].isAtStartOfLine());
+  EXPECT_EQ("caf\xC3\xA9Latte", Toks[3].getText());
+  EXPECT_FALSE(Toks[3].isAtStartOfLine());
+}
+
+TEST_F(LexerTest, LexLargeBuffer) {
+  // Lex a large buffer in which every token is preceded by enough text for the
+  // word-at-a-time scanning to kick in, with the interesting bytes at every
+  // possible offset within a word.
+  std::string Source;
+  for (unsigned Pad = 0; Pad != 64; ++Pad) {
+    std::string Text(Pad, 'x');
+    Source += "    // " + Text + "\n";
+    Source += "    /* " + Text + " */ ident" + Text + " = \"" + Text + "\"\n";
+  }
+  unsigned BufID = SourceMgr.addMemBufferCopy(Source);
+  std::vector<Token> Toks = tokenize(LangOpts, SourceMgr, BufID, 0, 0,
+                                     /*KeepComments=*/true);
+  ASSERT_EQ(64U * 5, Toks.size());
+  for (unsigned i = 0, e = Toks.size(); i != e; i += 5) {
+    std::string Text(i / 5, 'x');
+    EXPECT_EQ("// " + Text + "\n", Toks[i].getText());
+    EXPECT_EQ("/* " + Text + " */", Toks[i+1].getText());
+    EXPECT_EQ("ident" + Text, Toks[i+2].getText());
+    EXPECT_EQ(tok::equal, Toks[i+3].getKind());
+    EXPECT_EQ("\"" + Text + "\"", Toks[i+4].getText());
+  }
+}
@@ -60,3 +60,51 @@ TEST(FunctionNameDemangleTests, IgnoresNonMangledInputs) {
   EXPECT_STREQ("0123456789abcdef", OutputBuffer);
 }
 
+
+TEST(FunctionNameDemangleTests, DemanglesWithContext) {
+  char OutputBuffer[128];
+  const char *FunctionName = "_TFC3foo3bar3basfT3zimCS_3zim_T_";
+  const char *DemangledName = "foo.bar.bas (zim : foo.zim) -> ()";
+  const char *FunctionNameWithSugar = "_TF4main3fooFT3argGSqGSaSi___T_";
+  const char *DemangledNameWithSugar = "main.foo (arg : [Swift.Int]?) -> ()";
+
+  // A cache of one is evicted by every other name.
+  for (size_t CacheSize : {0, 1, 16}) {
+    swift_demangle_context_t Context =
+        swift_demangle_createContext(/*Simplified=*/0, CacheSize);
+    for (unsigned i = 0; i != 3; ++i) {
+      size_t Result = swift_demangle_getDemangledNameWithContext(
+          Context, FunctionName, OutputBuffer, sizeof(OutputBuffer));
+      EXPECT_STREQ(DemangledName, OutputBuffer);
+      EXPECT_EQ(Result, strlen(DemangledName));
+
+      Result = swift_demangle_getDemangledNameWithContext(
+          Context, FunctionNameWithSugar, OutputBuffer, sizeof(OutputBuffer));
+      EXPECT_STREQ(DemangledNameWithSugar, OutputBuffer);
+      EXPECT_EQ(Result, strlen(DemangledNameWithSugar));
+
+      char Untouched[] = "0123456789abcdef";
+      Result = swift_demangle_getDemangledNameWithContext(
+          Context, "printf", Untouched, sizeof(Untouched));
+      EXPECT_EQ(0U, Result);
+      EXPECT_STREQ("0123456789abcdef", Untouched);
+    }
+    swift_demangle_destroyContext(Context);
+  }
+}
+
+TEST(FunctionNameDemangleTests, SimplifiedContext) {
+  const char *FunctionName = "_TFC3foo3bar3basfT3zimCS_3zim_T_";
+  char Expected[128], OutputBuffer[128];
+  size_t ExpectedLength = swift_demangle_getSimplifiedDemangledName(
+      FunctionName, Expected, sizeof(Expected));
+
+  swift_demangle_context_t Context =
+      swift_demangle_createContext(/*Simplified=*/1, 16);
+  size_t Result = swift_demangle_getDemangledNameWithContext(
+      Context, FunctionName, OutputBuffer, sizeof(OutputBuffer));
+  swift_demangle_destroyContext(Context);
+
+  EXPECT_STREQ(Expected, OutputBuffer);
+  EXPECT_EQ(ExpectedLength, Result);
+}
@@ -0,0 +1,76 @@
+//===--- AllocationProfiler.cpp - Sampling heap profiler tests ------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/AllocationProfiler.h"
+#include "swift/Runtime/HeapObject.h"
+#include "swift/Runtime/Metadata.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <string>
+
+using namespace swift;
+
+static std::string readProfile() {
+  FILE *file = tmpfile();
+  EXPECT_TRUE(swift_writeAllocationProfile(fileno(file)));
+  rewind(file);
+
+  std::string profile;
+  char buffer[4096];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    profile.append(buffer, length);
+  fclose(file);
+  return profile;
+}
+
+TEST(AllocationProfilerTest, sampled_box) {
+  const Metadata *boxedType = &_TMBi64_.base;
+
+  // Create the box metadata before sampling starts.
+  BoxPair warmup = swift_allocBox(boxedType);
+  swift_deallocBox(warmup.first);
+
+  // With an average of one byte between samples every allocation is sampled.
+  swift_startAllocationProfiler(1);
+  swift_resetAllocationProfile();
+  BoxPair box = swift_allocBox(boxedType);
+  swift_stopAllocationProfiler();
+
+  std::string profile = readProfile();
+  EXPECT_EQ(0u, profile.find("heap profile: 1: "));
+  EXPECT_NE(std::string::npos, profile.find("@ heap_v2/"));
+
+  // The box is attributed to the type it holds.
+  char typeComment[64];
+  snprintf(typeComment, sizeof(typeComment), "# type %p: ",
+           static_cast<const void *>(boxedType));
+  EXPECT_NE(std::string::npos, profile.find(typeComment));
+
+  // Once the box is freed it is still allocated, but no longer in use.
+  swift_deallocBox(box.first);
+  profile = readProfile();
+  EXPECT_EQ(0u, profile.find("heap profile: 0: 0 [1: "));
+
+  swift_resetAllocationProfile();
+  profile = readProfile();
+  EXPECT_EQ(0u, profile.find("heap profile: 0: 0 [0: 0]"));
+}
+
+TEST(AllocationProfilerTest, stopped) {
+  swift_stopAllocationProfiler();
+  swift_resetAllocationProfile();
+  BoxPair box = swift_allocBox(&_TMBi64_.base);
+  swift_deallocBox(box.first);
+
+  EXPECT_EQ(0u, readProfile().find("heap profile: 0: 0 [0: 0]"));
+}
@@ -0,0 +1,413 @@
+//===- swift/unittests/runtime/Benchmarks.cpp - Runtime benchmarks --------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Not correctness tests: these measure how runtime entry points scale as the
+// number of threads calling them grows. Each benchmark is run with 1, 2,
+// 4, ... threads, up to SWIFT_RUNTIME_BENCHMARK_MAX_THREADS (by default the
+// number of hardware threads), and prints the time per operation of each
+// thread and the aggregate throughput.
+//
+// The binary isn't named like a unit test, so lit doesn't run it. Use
+// --gtest_filter to run single benchmarks.
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/HeapObject.h"
+#include "swift/Runtime/Metadata.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace swift;
+
+static unsigned getMaxThreads() {
+  if (const char *env = getenv("SWIFT_RUNTIME_BENCHMARK_MAX_THREADS"))
+    return std::max(1, atoi(env));
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Runs \p body(threadIndex) on \p numThreads threads which all start at the
+/// same time, and returns the elapsed time in nanoseconds.
+template <typename Fn>
+static uint64_t timeThreads(unsigned numThreads, const Fn &body) {
+  std::atomic<unsigned> ready{0};
+  std::atomic<bool> go{false};
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t != numThreads; ++t) {
+    threads.emplace_back([&, t] {
+      ++ready;
+      while (!go)
+        std::this_thread::yield();
+      body(t);
+    });
+  }
+  while (ready != numThreads)
+    std::this_thread::yield();
+
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  for (auto &thread : threads)
+    thread.join();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - start).count();
+}
+
+/// Runs \p body(threadIndex, numThreads) with a growing number of threads,
+/// where each call performs \p opsPerThread operations, and prints the
+/// results. \p prepare(numThreads) is called before each timed run.
+template <typename PrepareFn, typename BodyFn>
+static void runScaling(const char *name, unsigned opsPerThread,
+                       const PrepareFn &prepare, const BodyFn &body) {
+  unsigned maxThreads = getMaxThreads();
+  for (unsigned numThreads = 1; ; numThreads *= 2) {
+    numThreads = std::min(numThreads, maxThreads);
+    prepare(numThreads);
+    uint64_t elapsed = timeThreads(numThreads, [&](unsigned t) {
+      body(t, numThreads);
+    });
+    double totalOps = double(numThreads) * opsPerThread;
+    printf("%-36s %3u threads %9.1f ns/op %9.2f Mops/s\n", name, numThreads,
+           double(elapsed) / opsPerThread, totalOps * 1000.0 / elapsed);
+    if (numThreads == maxThreads)
+      break;
+  }
+}
+
+template <typename BodyFn>
+static void runScaling(const char *name, unsigned opsPerThread,
+                       const BodyFn &body) {
+  runScaling(name, opsPerThread, [](unsigned) {}, body);
+}
+
+//===----------------------------------------------------------------------===//
+// Heap objects
+//===----------------------------------------------------------------------===//
+
+/// An object which remembers its own allocation size, so that objects of
+/// every size can share one metadata.
+struct BenchObject : HeapObject {
+  size_t Size;
+};
+
+static void destroyBenchObject(HeapObject *object) {
+  swift_deallocObject(object, static_cast<BenchObject *>(object)->Size,
+                      alignof(BenchObject) - 1);
+}
+
+static const FullMetadata<ClassMetadata> BenchBaseMetadata = {
+  { { &destroyBenchObject }, { &_TWVBo } },
+  { { { MetadataKind::Class } }, nullptr, /*rodata*/ 1,
+  ClassFlags::UsesSwift1Refcounting, nullptr, nullptr, 0, 0, 0, 0, 0 }
+};
+
+static const FullMetadata<ClassMetadata> BenchDerivedMetadata = {
+  { { &destroyBenchObject }, { &_TWVBo } },
+  { { { MetadataKind::Class } }, &BenchBaseMetadata, /*rodata*/ 1,
+  ClassFlags::UsesSwift1Refcounting, nullptr, nullptr, 0, 0, 0, 0, 0 }
+};
+
+static BenchObject *allocBenchObject(const HeapMetadata *metadata,
+                                     size_t size = sizeof(BenchObject)) {
+  auto object = static_cast<BenchObject *>(
+    swift_allocObject(metadata, size, alignof(BenchObject) - 1));
+  object->Size = size;
+  return object;
+}
+
+TEST(RuntimeBenchmark, retainRelease_shared) {
+  auto object = allocBenchObject(&BenchBaseMetadata);
+  const unsigned ops = 1000000;
+  runScaling("retain/release, shared object", ops, [&](unsigned, unsigned) {
+    for (unsigned i = 0; i != ops; ++i) {
+      swift_retain(object);
+      swift_release(object);
+    }
+  });
+  swift_release(object);
+}
+
+TEST(RuntimeBenchmark, retainRelease_private) {
+  const unsigned ops = 1000000;
+  runScaling("retain/release, private objects", ops, [&](unsigned, unsigned) {
+    auto object = allocBenchObject(&BenchBaseMetadata);
+    for (unsigned i = 0; i != ops; ++i) {
+      swift_retain(object);
+      swift_release(object);
+    }
+    swift_release(object);
+  });
+}
+
+TEST(RuntimeBenchmark, allocDealloc) {
+  const unsigned ops = 200000;
+  static const size_t sizes[] = { 32, 128, 512, 4096 };
+  for (size_t size : sizes) {
+    char name[64];
+    snprintf(name, sizeof(name), "allocObject/release, %zu bytes", size);
+    runScaling(name, ops, [&](unsigned, unsigned) {
+      for (unsigned i = 0; i != ops; ++i)
+        swift_release(allocBenchObject(&BenchBaseMetadata, size));
+    });
+  }
+}
+
+TEST(RuntimeBenchmark, weakLoadStrong) {
+  const unsigned ops = 500000;
+  auto object = allocBenchObject(&BenchBaseMetadata);
+  WeakReference shared;
+  swift_weakInit(&shared, object);
+
+  runScaling("weakLoadStrong, shared reference", ops, [&](unsigned, unsigned) {
+    for (unsigned i = 0; i != ops; ++i)
+      swift_release(swift_weakLoadStrong(&shared));
+  });
+
+  runScaling("weakLoadStrong, private references", ops,
+             [&](unsigned, unsigned) {
+    WeakReference ref;
+    swift_weakInit(&ref, object);
+    for (unsigned i = 0; i != ops; ++i)
+      swift_release(swift_weakLoadStrong(&ref));
+    swift_weakDestroy(&ref);
+  });
+
+  swift_weakDestroy(&shared);
+  swift_release(object);
+}
+
+TEST(RuntimeBenchmark, dynamicCast_class) {
+  const unsigned ops = 500000;
+  auto object = allocBenchObject(&BenchDerivedMetadata);
+  runScaling("dynamicCast, base to derived class", ops,
+             [&](unsigned, unsigned) {
+    for (unsigned i = 0; i != ops; ++i) {
+      HeapObject *src = object;
+      HeapObject *dest = nullptr;
+      bool succeeded = swift_dynamicCast(
+        reinterpret_cast<OpaqueValue *>(&dest),
+        reinterpret_cast<OpaqueValue *>(&src),
+        &BenchBaseMetadata, &BenchDerivedMetadata,
+        DynamicCastFlags::Default);
+      if (!succeeded)
+        abort();
+      swift_release(dest);
+    }
+  });
+  swift_release(object);
+}
+
+//===----------------------------------------------------------------------===//
+// Generic metadata and conformances
+//===----------------------------------------------------------------------===//
+
+/// The same generic struct pattern as in Metadata.cpp: one argument, which
+/// is stored in the last field.
+template <unsigned NumFields>
+struct BenchGenericMetadata {
+  GenericMetadata Header;
+  void *Fields[NumFields];
+};
+
+static char BenchGlobal = 0;
+
+static BenchGenericMetadata<3> BenchPattern = {
+  {
+    [](GenericMetadata *pattern, const void *args) {
+      auto metadata = swift_allocateGenericValueMetadata(pattern, args);
+      auto metadataWords = reinterpret_cast<const void**>(metadata);
+      auto argsWords = reinterpret_cast<const void* const*>(args);
+      metadataWords[2] = argsWords[0];
+      return metadata;
+    },
+    3 * sizeof(void*), // metadata size
+    1, // num arguments
+    0, // address point
+    {} // private data
+  },
+  {
+    (void*) MetadataKind::Struct,
+    &BenchGlobal,
+    nullptr
+  }
+};
+
+/// Keys for instantiations that have never been requested before. The
+/// pattern only stores its argument, so the keys don't have to point to
+/// anything.
+static void *getFreshKey() {
+  static std::atomic<uintptr_t> nextKey{1};
+  return reinterpret_cast<void *>((nextKey++) * alignof(void *));
+}
+
+static ProtocolDescriptor BenchProto = { "BenchProto", nullptr,
+  ProtocolDescriptorFlags().withSwift(true)
+                          .withDispatchStrategy(ProtocolDispatchStrategy::Swift)
+                          .withClassConstraint(ProtocolClassConstraint::Any)
+};
+
+TEST(RuntimeBenchmark, getGenericMetadata_hit) {
+  auto pattern = (GenericMetadata *) &BenchPattern;
+  const unsigned numKeys = 64;
+  const unsigned ops = 500000;
+  std::vector<void *> keys;
+  for (unsigned i = 0; i != numKeys; ++i) {
+    keys.push_back(getFreshKey());
+    swift_getGenericMetadata(pattern, &keys.back());
+  }
+
+  runScaling("getGenericMetadata, cache hit", ops, [&](unsigned t, unsigned) {
+    for (unsigned i = 0; i != ops; ++i) {
+      void *args[] = { keys[(i + t) % numKeys] };
+      swift_getGenericMetadata(pattern, args);
+    }
+  });
+}
+
+TEST(RuntimeBenchmark, getGenericMetadata_miss) {
+  auto pattern = (GenericMetadata *) &BenchPattern;
+  const unsigned ops = 20000;
+  runScaling("getGenericMetadata, cache miss", ops, [&](unsigned, unsigned) {
+    for (unsigned i = 0; i != ops; ++i) {
+      void *args[] = { getFreshKey() };
+      swift_getGenericMetadata(pattern, args);
+    }
+  });
+}
+
+TEST(RuntimeBenchmark, conformsToProtocol_warm) {
+  auto pattern = (GenericMetadata *) &BenchPattern;
+  void *args[] = { getFreshKey() };
+  auto type = swift_getGenericMetadata(pattern, args);
+  swift_conformsToProtocol(type, &BenchProto);
+
+  const unsigned ops = 500000;
+  runScaling("conformsToProtocol, warm", ops, [&](unsigned, unsigned) {
+    for (unsigned i = 0; i != ops; ++i)
+      swift_conformsToProtocol(type, &BenchProto);
+  });
+}
+
+TEST(RuntimeBenchmark, conformsToProtocol_cold) {
+  // Every lookup is for a type that has never been looked up, so none of
+  // them are answered by the conformance cache. The types are instantiated
+  // before the timed runs.
+  auto pattern = (GenericMetadata *) &BenchPattern;
+  const unsigned ops = 2000;
+  std::vector<std::vector<const Metadata *>> types;
+  runScaling("conformsToProtocol, cold", ops,
+             [&](unsigned numThreads) {
+    types.assign(numThreads, {});
+    for (auto &threadTypes : types) {
+      for (unsigned i = 0; i != ops; ++i) {
+        void *args[] = { getFreshKey() };
+        threadTypes.push_back(swift_getGenericMetadata(pattern, args));
+      }
+    }
+  }, [&](unsigned t, unsigned) {
+    for (auto type : types[t])
+      swift_conformsToProtocol(type, &BenchProto);
+  });
+}
+
+//===----------------------------------------------------------------------===//
+// Number formatting
+//===----------------------------------------------------------------------===//
+
+extern "C" uint64_t swift_int64ToString(char *Buffer, size_t BufferLength,
+                                        int64_t Value, int64_t Radix,
+                                        bool Uppercase);
+extern "C" uint64_t swift_float64ToString(char *Buffer, size_t BufferLength,
+                                          double Value);
+
+/// The digit-at-a-time decimal formatting the stubs used before, as the
+/// baseline for swift_int64ToString.
+static size_t formatDecimalBaseline(char *buffer, uint64_t value) {
+  char *p = buffer;
+  do {
+    *p++ = '0' + char(value % 10);
+    value /= 10;
+  } while (value);
+  std::reverse(buffer, p);
+  return p - buffer;
+}
+
+/// Values with 1 to 19 digits, like the ones printed by logging.
+static std::vector<int64_t> getFormattingValues() {
+  std::vector<int64_t> values;
+  uint64_t state = 88172645463325252ull;
+  for (unsigned i = 0; i != 1024; ++i) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    values.push_back(int64_t(state >> (state % 63)));
+  }
+  return values;
+}
+
+TEST(RuntimeBenchmark, int64ToString) {
+  const unsigned ops = 1000000;
+  auto values = getFormattingValues();
+  std::atomic<size_t> sink{0};
+  runScaling("int64ToString, digit loop", ops, [&](unsigned, unsigned) {
+    char buffer[32];
+    size_t length = 0;
+    for (unsigned i = 0; i != ops; ++i)
+      length += formatDecimalBaseline(buffer, values[i % values.size()]);
+    sink += length;
+  });
+  runScaling("int64ToString", ops, [&](unsigned, unsigned) {
+    char buffer[32];
+    size_t length = 0;
+    for (unsigned i = 0; i != ops; ++i)
+      length += swift_int64ToString(buffer, sizeof(buffer),
+                                    values[i % values.size()], 10, false);
+    sink += length;
+  });
+  EXPECT_NE(0u, sink);
+}
+
+TEST(RuntimeBenchmark, float64ToString) {
+  const unsigned ops = 200000;
+  auto values = getFormattingValues();
+  std::vector<double> integers, fractions;
+  for (int64_t value : values) {
+    integers.push_back(double(value % 1000000));
+    fractions.push_back(double(value % 1000000) / 1024);
+  }
+  std::atomic<size_t> sink{0};
+  auto run = [&](const char *name, const std::vector<double> &inputs,
+                 bool baseline) {
+    runScaling(name, ops, [&](unsigned, unsigned) {
+      char buffer[32];
+      size_t length = 0;
+      for (unsigned i = 0; i != ops; ++i) {
+        double value = inputs[i % inputs.size()];
+        if (baseline)
+          length += snprintf(buffer, sizeof(buffer), "%0.*g", 15, value);
+        else
+          length += swift_float64ToString(buffer, sizeof(buffer), value);
+      }
+      sink += length;
+    });
+  };
+  run("float64ToString, snprintf, integers", integers, true);
+  run("float64ToString, integers", integers, false);
+  run("float64ToString, snprintf, fractions", fractions, true);
+  run("float64ToString, fractions", fractions, false);
+  EXPECT_NE(0u, sink);
+}
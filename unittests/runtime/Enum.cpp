@@ -153,3 +153,47 @@ TEST(EnumTest, storeEnumTagSinglePayload) {
   ASSERT_TRUE(test_storeEnumTagSinglePayload({1, 1}, {219, 123},
                                               XI_TMBi8_, 3, 4));
 }
+
+TEST(EnumTest, singlePayloadHeapObject) {
+  // Empty cases of optional object references are stored as extra
+  // inhabitants of the pointer.
+  HeapObject *object = nullptr;
+  ASSERT_EQ(0, swift_getEnumCaseSinglePayload(asOpaque(&object),
+                                              &_TMBo.base, 1));
+  swift_storeHeapObjectExtraInhabitant(&object, 2);
+  ASSERT_EQ(2, swift_getEnumCaseSinglePayload(asOpaque(&object),
+                                              &_TMBo.base, 3));
+
+  alignas(16) char storage[16];
+  object = reinterpret_cast<HeapObject *>(storage);
+  ASSERT_EQ(-1, swift_getEnumCaseSinglePayload(asOpaque(&object),
+                                               &_TMBo.base, 1));
+
+  // Storing the payload case leaves the pointer alone.
+  swift_storeEnumTagSinglePayload(asOpaque(&object), &_TMBo.base, -1, 1);
+  ASSERT_EQ(reinterpret_cast<HeapObject *>(storage), object);
+
+  swift_storeEnumTagSinglePayload(asOpaque(&object), &_TMBo.base, 0, 1);
+  ASSERT_EQ(nullptr, object);
+  swift_storeEnumTagSinglePayload(asOpaque(&object), &_TMBo.base, 1, 2);
+  ASSERT_EQ(1, swift_getEnumCaseSinglePayload(asOpaque(&object),
+                                              &_TMBo.base, 2));
+}
+
+TEST(EnumTest, initEnumValueWitnessTableSinglePayloadHeapObject) {
+  // An optional object reference borrows the witnesses of the reference.
+  EnumValueWitnessTable vwtable;
+  swift_initEnumValueWitnessTableSinglePayload(&vwtable,
+                                               _TWVBo.getTypeLayout(), 1);
+  ASSERT_EQ(_TWVBo.size, vwtable.size);
+  ASSERT_EQ(_TWVBo.destroy, vwtable.destroy);
+  ASSERT_EQ(_TWVBo.initializeWithCopy, vwtable.initializeWithCopy);
+  ASSERT_EQ(_TWVBo.getNumExtraInhabitants() - 1,
+            vwtable.getNumExtraInhabitants());
+
+  // With more empty cases, the common witnesses are used instead.
+  EnumValueWitnessTable vwtable2;
+  swift_initEnumValueWitnessTableSinglePayload(&vwtable2,
+                                               _TWVBo.getTypeLayout(), 2);
+  ASSERT_NE(_TWVBo.destroy, vwtable2.destroy);
+}
@@ -11,11 +11,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "swift/Runtime/Metadata.h"
+#include "swift/Runtime/HeapObject.h"
 #include "swift/Runtime/Concurrent.h"
 #include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
 #include <iterator>
 #include <functional>
 #include <sys/mman.h>
+#include <thread>
 #include <vector>
 #include <pthread.h>
 
@@ -232,6 +236,30 @@ TEST(MetadataAllocator, alloc_firstAllocationMoreThanPageSized) {
   munmap(page, pagesize);
 }
 
+TEST(MetadataAllocator, alloc_concurrent) {
+  using swift::MetadataAllocator;
+  MetadataAllocator allocator;
+  const unsigned allocationsPerThread = 1000;
+
+  // Every thread stamps its allocations; overlapping allocations would
+  // clobber each other's stamps.
+  auto results = RaceTest<uintptr_t *>(
+    [&]() -> uintptr_t * {
+      auto blocks = new uintptr_t*[allocationsPerThread];
+      for (unsigned i = 0; i != allocationsPerThread; ++i) {
+        blocks[i] = static_cast<uintptr_t *>(
+                                  allocator.alloc(3 * sizeof(uintptr_t)));
+        for (unsigned j = 0; j != 3; ++j)
+          blocks[i][j] = uintptr_t(blocks);
+      }
+      for (unsigned i = 0; i != allocationsPerThread; ++i)
+        for (unsigned j = 0; j != 3; ++j)
+          EXPECT_EQ(uintptr_t(blocks), blocks[i][j]);
+      delete [] blocks;
+      return nullptr;
+    });
+}
+
 TEST(MetadataTest, getGenericMetadata) {
   auto metadataTemplate = (GenericMetadata*) &MetadataTest1;
 
@@ -265,6 +293,97 @@ TEST(MetadataTest, getGenericMetadata) {
     });
 }
 
+TEST(MetadataTest, registerGenericMetadata) {
+  auto metadataTemplate = (GenericMetadata*) &MetadataTest1;
+  static char Registered = 0;
+  static char Instantiated = 0;
+
+  // Metadata registered for fresh arguments is what lookups return.
+  static const void *Prespecialized[] = {
+    (void*) MetadataKind::Struct, &Global1, &Registered
+  };
+  auto prespecialized = reinterpret_cast<const Metadata *>(Prespecialized);
+  void *args[] = { &Registered };
+  EXPECT_EQ(prespecialized,
+            swift_registerGenericMetadata(metadataTemplate, args,
+                                          prespecialized));
+  EXPECT_EQ(prespecialized, swift_getGenericMetadata(metadataTemplate, args));
+
+  // Arguments which already have metadata keep it.
+  args[0] = &Instantiated;
+  auto inst = swift_getGenericMetadata(metadataTemplate, args);
+  EXPECT_NE(prespecialized, inst);
+  EXPECT_EQ(inst, swift_registerGenericMetadata(metadataTemplate, args,
+                                                prespecialized));
+  EXPECT_EQ(inst, swift_getGenericMetadata(metadataTemplate, args));
+}
+
+/// Distinct keys used by the concurrency tests below.
+static char KeyGlobals[256];
+
+TEST(MetadataTest, getGenericMetadata_distinctKeysInParallel) {
+  auto metadataTemplate = (GenericMetadata*) &MetadataTest1;
+  std::atomic<unsigned> nextKey{0};
+
+  // Every thread instantiates its own key, so the instantiations must not
+  // be serialized behind each other and must not be confused.
+  auto results = RaceTest<const Metadata *>(
+    [&]() -> const Metadata * {
+      unsigned key = nextKey.fetch_add(1);
+      void *args[] = { &KeyGlobals[key] };
+      auto inst = swift_getGenericMetadata(metadataTemplate, args);
+
+      auto fields = reinterpret_cast<void * const *>(inst);
+      EXPECT_EQ(&KeyGlobals[key], fields[2]);
+      return inst;
+    });
+
+  // Looking the keys up again must produce the same metadata.
+  for (auto inst : results) {
+    auto fields = reinterpret_cast<void * const *>(inst);
+    void *args[] = { fields[2] };
+    EXPECT_EQ(inst, swift_getGenericMetadata(metadataTemplate, args));
+  }
+}
+
+TEST(MetadataTest, getGenericMetadata_lookupScaling) {
+  // Not a correctness test: report how cached lookups scale with the number
+  // of threads hammering the same cache.
+  auto metadataTemplate = (GenericMetadata*) &MetadataTest1;
+  const unsigned numKeys = 32;
+  const unsigned lookupsPerThread = 200000;
+
+  for (unsigned i = 0; i != numKeys; ++i) {
+    void *args[] = { &KeyGlobals[i] };
+    swift_getGenericMetadata(metadataTemplate, args);
+  }
+
+  for (unsigned numThreads = 1; numThreads <= 64; numThreads *= 2) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t != numThreads; ++t) {
+      threads.emplace_back([=] {
+        for (unsigned i = 0; i != lookupsPerThread; ++i) {
+          void *args[] = { &KeyGlobals[(i + t) % numKeys] };
+          auto inst = swift_getGenericMetadata(metadataTemplate, args);
+          EXPECT_NE(inst, nullptr);
+        }
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start).count();
+    double totalLookups = double(numThreads) * lookupsPerThread;
+    printf("getGenericMetadata: %2u threads, %6.1f ns/lookup, "
+           "%8.2f Mlookups/s aggregate\n",
+           numThreads, double(elapsed) * numThreads / totalLookups,
+           totalLookups * 1000.0 / double(elapsed));
+  }
+}
+
 FullMetadata<ClassMetadata> MetadataTest2 = {
   { { nullptr }, { &_TWVBo } },
   { { { MetadataKind::Class } }, nullptr, 0, ClassFlags(), nullptr, nullptr, 0, 0, 0, 0, 0 }
@@ -317,6 +436,41 @@ TEST(MetadataTest, getMetatypeMetadata) {
   ASSERT_EQ(inst1, inst5->InstanceType);
 }
 
+extern "C" TwoWordPair<const char *, uintptr_t>::Return
+swift_getTypeName(const Metadata *type, bool qualified);
+
+TEST(MetadataTest, getTypeName) {
+  auto metatype = swift_getMetatypeMetadata(&_TMBi64_.base);
+
+  // Look the name up from many threads at once, while it is being cached.
+  std::atomic<unsigned> mismatches(0);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < 16; ++i) {
+    threads.emplace_back([&] {
+      for (unsigned j = 0; j < 1000; ++j) {
+        TwoWordPair<const char *, uintptr_t> result
+          = swift_getTypeName(metatype, true);
+        if (std::string(result.first, result.second)
+              != "<<<opaque type>>>.Type")
+          ++mismatches;
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(0u, mismatches.load());
+
+  // Once cached, a name is returned without being rebuilt.
+  TwoWordPair<const char *, uintptr_t> first
+    = swift_getTypeName(metatype, false);
+  TwoWordPair<const char *, uintptr_t> second
+    = swift_getTypeName(metatype, false);
+  EXPECT_EQ(first.first, second.first);
+  EXPECT_EQ(first.second, second.second);
+  EXPECT_EQ("<<<opaque type>>>.Type",
+            std::string(first.first, first.second));
+}
+
 ProtocolDescriptor ProtocolA{
   "_TMp8Metadata9ProtocolA",
   nullptr,
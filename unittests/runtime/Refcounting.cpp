@@ -13,6 +13,11 @@
 #include "swift/Runtime/HeapObject.h"
 #include "swift/Runtime/Metadata.h"
 #include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
 
 using namespace swift;
 
@@ -119,6 +124,38 @@ TEST(RefcountingTest, retain_release_n) {
   EXPECT_EQ(1u, value);
 }
 
+TEST(RefcountingTest, nonatomic_retain_release) {
+  size_t value = 0;
+  auto object = allocTestObject(&value, 1);
+  EXPECT_EQ(0u, value);
+  swift_nonatomic_retain(object);
+  EXPECT_EQ(0u, value);
+  EXPECT_EQ(2u, swift_retainCount(object));
+  swift_nonatomic_release(object);
+  EXPECT_EQ(0u, value);
+  EXPECT_EQ(1u, swift_retainCount(object));
+  swift_nonatomic_release(object);
+  EXPECT_EQ(1u, value);
+}
+
+TEST(RefcountingTest, nonatomic_retain_release_n) {
+  size_t value = 0;
+  auto object = allocTestObject(&value, 1);
+  EXPECT_EQ(0u, value);
+  swift_nonatomic_retain_n(object, 32);
+  swift_retain(object);
+  EXPECT_EQ(0u, value);
+  EXPECT_EQ(34u, swift_retainCount(object));
+  swift_nonatomic_release_n(object, 31);
+  EXPECT_EQ(0u, value);
+  EXPECT_EQ(3u, swift_retainCount(object));
+  swift_release_n(object, 2);
+  EXPECT_EQ(0u, value);
+  EXPECT_EQ(1u, swift_retainCount(object));
+  swift_nonatomic_release_n(object, 1);
+  EXPECT_EQ(1u, value);
+}
+
 TEST(RefcountingTest, unknown_retain_release_n) {
   size_t value = 0;
   auto object = allocTestObject(&value, 1);
@@ -156,3 +193,168 @@ TEST(RefcountingTest, unowned_retain_release_n) {
   swift_release(object);
   EXPECT_EQ(1u, value);
 }
+
+TEST(RefcountingTest, array_witnesses_runs) {
+  size_t value1 = 0, value2 = 0;
+  auto object1 = allocTestObject(&value1, 1);
+  auto object2 = allocTestObject(&value2, 1);
+  HeapObject *src[] = { object1, object1, object1, nullptr, object2, object1 };
+  HeapObject *dest[6];
+  auto *witnesses = &_TWVBo;
+  witnesses->initializeArrayWithCopy((OpaqueValue *) dest, (OpaqueValue *) src,
+                                     6, &_TMBo);
+  for (unsigned i = 0; i < 6; ++i)
+    EXPECT_EQ(src[i], dest[i]);
+  EXPECT_EQ(5u, swift_retainCount(object1));
+  EXPECT_EQ(2u, swift_retainCount(object2));
+
+  witnesses->destroyArray((OpaqueValue *) dest, 6, &_TMBo);
+  EXPECT_EQ(1u, swift_retainCount(object1));
+  EXPECT_EQ(1u, swift_retainCount(object2));
+  EXPECT_EQ(0u, value1);
+  EXPECT_EQ(0u, value2);
+
+  swift_release(object1);
+  swift_release(object2);
+  EXPECT_EQ(1u, value1);
+  EXPECT_EQ(1u, value2);
+}
+
+template <class T>
+static void reportArrayWitnessThroughput(const char *name,
+                                         const ValueWitnessTable *witnesses,
+                                         const Metadata *type,
+                                         std::vector<T> &src) {
+  const unsigned numRounds = 100;
+  std::vector<T> dest(src.size());
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i != numRounds; ++i) {
+    witnesses->initializeArrayWithCopy((OpaqueValue *) dest.data(),
+                                       (OpaqueValue *) src.data(),
+                                       src.size(), type);
+    witnesses->destroyArray((OpaqueValue *) dest.data(), dest.size(), type);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start).count();
+  double elements = double(numRounds) * src.size();
+  printf("%s: %8.2f Melements/s (copy + destroy)\n", name,
+         elements * 1000.0 / double(elapsed));
+}
+
+TEST(RefcountingTest, array_witnesses_throughput) {
+  // Not a correctness test: report elements per second for the bulk array
+  // witnesses of a POD type and of a single reference.
+  const size_t numElements = 1 << 16;
+  size_t value = 0;
+  auto object = allocTestObject(&value, 1);
+  auto other = allocTestObject(&value, 1);
+
+  std::vector<uint64_t> pod(numElements, 42);
+  reportArrayWitnessThroughput("Builtin.Int64 (memcpy)", &_TWVBi64_,
+                               &_TMBi64_, pod);
+
+  std::vector<HeapObject *> sameRef(numElements, object);
+  reportArrayWitnessThroughput("Builtin.NativeObject, one reference",
+                               &_TWVBo, &_TMBo, sameRef);
+
+  std::vector<HeapObject *> distinctRefs(numElements);
+  for (size_t i = 0; i != numElements; ++i)
+    distinctRefs[i] = (i & 1) ? object : other;
+  reportArrayWitnessThroughput("Builtin.NativeObject, alternating references",
+                               &_TWVBo, &_TMBo, distinctRefs);
+
+  EXPECT_EQ(1u, swift_retainCount(object));
+  EXPECT_EQ(1u, swift_retainCount(other));
+  swift_release(object);
+  swift_release(other);
+}
+
+TEST(RefcountingTest, weak_load_after_release) {
+  size_t value = 0;
+  auto object = allocTestObject(&value, 1);
+  WeakReference ref;
+  swift_weakInit(&ref, object);
+
+  auto loaded = swift_weakLoadStrong(&ref);
+  EXPECT_EQ(object, loaded);
+  EXPECT_EQ(2u, swift_retainCount(object));
+  swift_release(loaded);
+
+  // The weak reference doesn't keep the object alive.
+  swift_release(object);
+  EXPECT_EQ(1u, value);
+  EXPECT_EQ(nullptr, swift_weakLoadStrong(&ref));
+  EXPECT_EQ(nullptr, swift_weakLoadStrong(&ref));
+  swift_weakDestroy(&ref);
+}
+
+TEST(RefcountingTest, weak_copy_take_assign) {
+  size_t value1 = 0, value2 = 0;
+  auto object1 = allocTestObject(&value1, 1);
+  auto object2 = allocTestObject(&value2, 1);
+  WeakReference ref1, ref2, ref3;
+  swift_weakInit(&ref1, object1);
+  swift_weakCopyInit(&ref2, &ref1);
+  swift_weakTakeInit(&ref3, &ref2);
+
+  auto loaded = swift_weakTakeStrong(&ref3);
+  EXPECT_EQ(object1, loaded);
+  swift_release(loaded);
+
+  swift_weakInit(&ref2, object2);
+  swift_weakCopyAssign(&ref2, &ref1);
+  loaded = swift_weakLoadStrong(&ref2);
+  EXPECT_EQ(object1, loaded);
+  swift_release(loaded);
+
+  swift_weakAssign(&ref1, object2);
+  swift_weakTakeAssign(&ref2, &ref1);
+  loaded = swift_weakLoadStrong(&ref2);
+  EXPECT_EQ(object2, loaded);
+  swift_release(loaded);
+
+  swift_release(object1);
+  EXPECT_EQ(1u, value1);
+  swift_release(object2);
+  EXPECT_EQ(1u, value2);
+  EXPECT_EQ(nullptr, swift_weakLoadStrong(&ref2));
+  swift_weakDestroy(&ref2);
+}
+
+TEST(RefcountingTest, weak_load_contention) {
+  // Not a correctness test: report weak loads per second with several
+  // threads loading from the same weak reference.
+  const unsigned numLoads = 1 << 18;
+  size_t value = 0;
+  auto object = allocTestObject(&value, 1);
+  WeakReference ref;
+  swift_weakInit(&ref, object);
+
+  for (unsigned numThreads = 1; numThreads <= 8; numThreads *= 2) {
+    std::atomic<unsigned> failures(0);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i != numThreads; ++i) {
+      threads.emplace_back([&] {
+        for (unsigned j = 0; j != numLoads; ++j) {
+          auto loaded = swift_weakLoadStrong(&ref);
+          if (loaded != object)
+            ++failures;
+          swift_release(loaded);
+        }
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(0u, failures.load());
+    printf("%u thread(s): %8.2f Mloads/s\n", numThreads,
+           double(numLoads) * numThreads * 1000.0 / double(elapsed));
+  }
+
+  EXPECT_EQ(1u, swift_retainCount(object));
+  swift_release(object);
+  EXPECT_EQ(1u, value);
+  swift_weakDestroy(&ref);
+}
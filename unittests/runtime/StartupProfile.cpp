@@ -0,0 +1,83 @@
+//===--- StartupProfile.cpp - Runtime startup profile tests ---------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/StartupProfile.h"
+#include "swift/Runtime/Once.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <string>
+
+using namespace swift;
+
+static std::string readProfile() {
+  FILE *file = tmpfile();
+  EXPECT_TRUE(swift_writeStartupProfile(fileno(file)));
+  rewind(file);
+
+  std::string profile;
+  char buffer[4096];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    profile.append(buffer, length);
+  fclose(file);
+  return profile;
+}
+
+/// Returns the number of swift_once initializations in the row of \p profile
+/// which ends in \p image.
+static unsigned long long getOnceCount(const std::string &profile,
+                                       const char *image) {
+  size_t pos = profile.find(image);
+  if (pos == std::string::npos)
+    return 0;
+  size_t lineStart = profile.rfind('\n', pos) + 1;
+  unsigned long long records = 0, inits = 0;
+  double time;
+  if (sscanf(profile.c_str() + lineStart, "%llu %lf %llu", &records, &time,
+             &inits) != 3)
+    return 0;
+  return inits;
+}
+
+static unsigned NumInitializations = 0;
+
+static void initialize(void *) {
+  ++NumInitializations;
+}
+
+TEST(StartupProfileTest, once) {
+  std::string before = readProfile();
+  unsigned long long initsBefore = getOnceCount(before, "(all images)");
+
+  swift_setStartupProfileEnabled(true);
+  static swift_once_t token;
+  swift_once(&token, initialize);
+  swift_once(&token, initialize);
+  swift_setStartupProfileEnabled(false);
+  EXPECT_EQ(1u, NumInitializations);
+
+  // Only the initialization itself is counted.
+  std::string after = readProfile();
+  EXPECT_EQ(0u, after.find("===- Swift runtime startup profile (ms) -===\n"));
+  EXPECT_EQ(initsBefore + 1, getOnceCount(after, "(all images)"));
+  EXPECT_NE(std::string::npos, after.find("SwiftRuntimeTests"));
+}
+
+TEST(StartupProfileTest, disabled) {
+  std::string before = readProfile();
+
+  static swift_once_t token;
+  swift_once(&token, initialize);
+
+  EXPECT_EQ(getOnceCount(before, "(all images)"),
+            getOnceCount(readProfile(), "(all images)"));
+}
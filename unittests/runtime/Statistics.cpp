@@ -0,0 +1,107 @@
+//===--- Statistics.cpp - Runtime event counter tests ---------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/HeapObject.h"
+#include "swift/Runtime/Metadata.h"
+#include "swift/Runtime/Statistics.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace swift;
+
+static const FullMetadata<ClassMetadata> StatsClassMetadata = {
+  { { nullptr }, { &_TWVBo } },
+  { { { MetadataKind::Class } }, 0, /*rodata*/ 1,
+  ClassFlags::UsesSwift1Refcounting, nullptr, nullptr, 0, 0, 0, 0, 0 }
+};
+
+TEST(RuntimeStatisticsTest, unavailable) {
+  if (swift_runtimeStatisticsAvailable())
+    return;
+
+  SwiftRuntimeStatistics stats;
+  stats.Retains = 42;
+  EXPECT_FALSE(swift_setRuntimeStatisticsEnabled(true));
+  EXPECT_FALSE(swift_getRuntimeStatistics(&stats));
+  EXPECT_EQ(0u, stats.Retains);
+}
+
+TEST(RuntimeStatisticsTest, retain_release) {
+  if (!swift_runtimeStatisticsAvailable())
+    return;
+
+  EXPECT_TRUE(swift_setRuntimeStatisticsEnabled(true));
+  swift_resetRuntimeStatistics();
+
+  auto object = swift_allocObject(&StatsClassMetadata, sizeof(HeapObject),
+                                  alignof(HeapObject) - 1);
+  const unsigned NumThreads = 8;
+  const unsigned NumIterations = 1000;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < NumThreads; ++i) {
+    threads.push_back(std::thread([&] {
+      for (unsigned j = 0; j < NumIterations; ++j) {
+        swift_retain(object);
+        swift_release(object);
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  SwiftRuntimeStatistics stats;
+  EXPECT_TRUE(swift_getRuntimeStatistics(&stats));
+  EXPECT_EQ(NumThreads * NumIterations, stats.Retains);
+  EXPECT_EQ(NumThreads * NumIterations, stats.Releases);
+  EXPECT_EQ(1u, stats.ObjectAllocations);
+
+  // Counting stops when statistics are disabled.
+  swift_setRuntimeStatisticsEnabled(false);
+  swift_retain(object);
+  swift_release(object);
+  EXPECT_TRUE(swift_getRuntimeStatistics(&stats));
+  EXPECT_EQ(NumThreads * NumIterations, stats.Retains);
+
+  swift_resetRuntimeStatistics();
+  EXPECT_TRUE(swift_getRuntimeStatistics(&stats));
+  EXPECT_EQ(0u, stats.Retains);
+}
+
+TEST(RuntimeStatisticsTest, value_buffer_allocations) {
+  if (!swift_runtimeStatisticsAvailable())
+    return;
+
+  // A tuple of four words doesn't fit in a value buffer.
+  const Metadata *elements[] = {
+    &_TMBi64_.base, &_TMBi64_.base, &_TMBi64_.base, &_TMBi64_.base
+  };
+  auto tuple = swift_getTupleTypeMetadata(4, elements, nullptr, nullptr);
+  auto vwt = tuple->getValueWitnesses();
+  ASSERT_FALSE(vwt->isValueInline());
+
+  EXPECT_TRUE(swift_setRuntimeStatisticsEnabled(true));
+  swift_resetRuntimeStatistics();
+
+  ValueBuffer buffer, copy;
+  auto value = vwt->allocateBuffer(&buffer, tuple);
+  memset(value, 0, vwt->size);
+  vwt->initializeBufferWithCopyOfBuffer(&copy, &buffer, tuple);
+  vwt->destroyBuffer(&copy, tuple);
+  vwt->destroyBuffer(&buffer, tuple);
+
+  SwiftRuntimeStatistics stats;
+  EXPECT_TRUE(swift_getRuntimeStatistics(&stats));
+  EXPECT_EQ(2u, stats.ValueBufferAllocations);
+  swift_setRuntimeStatisticsEnabled(false);
+}
@@ -0,0 +1,32 @@
+// Walks a linked list of class instances. Each step has to retain the next
+// node, so this measures the retain/release pairs which cannot be removed.
+
+final class Node {
+  var next: Node?
+  var value: Int
+  init(_ value: Int, _ next: Node?) {
+    self.value = value
+    self.next = next
+  }
+}
+
+@inline(never)
+func walk(head: Node?) -> Int {
+  var sum = 0
+  var node = head
+  while let n = node {
+    sum = sum &+ n.value
+    node = n.next
+  }
+  return sum
+}
+
+var head: Node? = nil
+for i in 0..<1000 {
+  head = Node(i, head)
+}
+var result = 0
+for _ in 0..<100 {
+  result = result &+ walk(head)
+}
+print(result)
@@ -0,0 +1,26 @@
+// Reads a property of every element of an array of class instances.
+// Ideally the loop needs no retain/release per iteration.
+
+final class Item {
+  var value: Int
+  init(_ value: Int) { self.value = value }
+}
+
+@inline(never)
+func sum(items: [Item]) -> Int {
+  var total = 0
+  for item in items {
+    total = total &+ item.value
+  }
+  return total
+}
+
+var items = [Item]()
+for i in 0..<1000 {
+  items.append(Item(i))
+}
+var result = 0
+for _ in 0..<1000 {
+  result = result &+ sum(items)
+}
+print(result)
@@ -0,0 +1,29 @@
+// Reads a class reference that is invariant in two nested loops.
+// The retain/release pair should be hoisted out of both loops.
+
+final class Matrix {
+  var width: Int
+  var data: [Int]
+  init(width: Int, height: Int) {
+    self.width = width
+    self.data = [Int](count: width * height, repeatedValue: 1)
+  }
+}
+
+@inline(never)
+func total(m: Matrix, height: Int) -> Int {
+  var sum = 0
+  for i in 0..<height {
+    for j in 0..<m.width {
+      sum = sum &+ m.data[i * m.width + j]
+    }
+  }
+  return sum
+}
+
+let m = Matrix(width: 100, height: 100)
+var result = 0
+for _ in 0..<100 {
+  result = result &+ total(m, height: 100)
+}
+print(result)
@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+#
+# Counts the dynamic retains and releases of each ARC benchmark.
+#
+# The runtime must be built with SWIFT_RUNTIME_ENABLE_STATISTICS. The counts
+# are printed by the runtime at exit if SWIFT_RUNTIME_STATISTICS=print is set.
+#
+# Usage: BUILD_DIR=<swift build dir> ./run.sh [extra swiftc flags]
+
+if [[ -z "$BUILD_DIR" ]]; then
+    echo "Error! BUILD_DIR not set! Don't know how to find swiftc binary."
+    exit 1
+fi
+
+SWIFTC="$BUILD_DIR/bin/swiftc"
+cd "$(dirname "$0")" || exit 1
+
+printf "%-24s %12s %12s\n" "Benchmark" "Retains" "Releases"
+for SOURCE in *.swift; do
+    NAME="${SOURCE%.swift}"
+    "$SWIFTC" -O "$@" "$SOURCE" -o "$NAME.bin" || exit 1
+    STATS=$(SWIFT_RUNTIME_STATISTICS=print "./$NAME.bin" 2>&1 >/dev/null)
+    RETAINS=$(echo "$STATS" | sed -n 's/^swift runtime statistics: \([0-9]*\) strong retains$/\1/p')
+    RELEASES=$(echo "$STATS" | sed -n 's/^swift runtime statistics: \([0-9]*\) strong releases$/\1/p')
+    printf "%-24s %12s %12s\n" "$NAME" "${RETAINS:-n/a}" "${RELEASES:-n/a}"
+    rm -f "$NAME.bin"
+done
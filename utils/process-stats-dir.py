@@ -0,0 +1,106 @@
+#!/usr/bin/env python
+
+#===--- process-stats-dir.py - Summarize a -stats-output-dir -------------===#
+#
+# This source file is part of the Swift.org open source project
+#
+# Copyright (c) 2014 - 2015 Apple Inc. and the Swift project authors
+# Licensed under Apache License v2.0 with Runtime Library Exception
+#
+# See http://swift.org/LICENSE.txt for license information
+# See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+#
+#===------------------------------------------------------------------------===#
+
+# Combines the JSON files that the driver and frontend jobs of a build wrote
+# to a -stats-output-dir into one summary of the whole build:
+#   o the number of jobs of each kind;
+#   o the time spent in each phase and every counter, summed over the jobs
+#     of each kind;
+#   o the largest peak resident set size of any job of each kind;
+#   o the slowest frontend jobs.
+#
+# Times are in microseconds and sizes in bytes.
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import sys
+
+
+def load_stats(path):
+    for root, dirs, files in os.walk(path):
+        for filename in sorted(files):
+            if not filename.endswith('.json'):
+                continue
+            with open(os.path.join(root, filename)) as f:
+                yield json.load(f)
+
+
+def add_values(totals, values):
+    for name, value in values.items():
+        totals[name] = totals.get(name, 0) + value
+
+
+def summarize(jobs, num_slowest):
+    kinds = {}
+    for job in jobs:
+        summary = kinds.setdefault(job['kind'], {
+            'jobs': 0,
+            'wall_time': 0,
+            'max_rss': 0,
+            'phases': {},
+            'counters': {},
+        })
+        summary['jobs'] += 1
+        summary['wall_time'] += job['wall_time']
+        summary['max_rss'] = max(summary['max_rss'], job['max_rss'])
+        add_values(summary['phases'], job['phases'])
+        add_values(summary['counters'], job['counters'])
+
+    frontend_jobs = [j for j in jobs if j['kind'] == 'frontend']
+    frontend_jobs.sort(key=lambda j: j['wall_time'], reverse=True)
+    slowest = [{'name': j['name'], 'wall_time': j['wall_time']}
+               for j in frontend_jobs[:num_slowest]]
+    return {'kinds': kinds, 'slowest': slowest}
+
+
+def print_table(summary):
+    for kind in sorted(summary['kinds']):
+        data = summary['kinds'][kind]
+        print('%s: %d jobs, %d us, max RSS %d bytes' %
+              (kind, data['jobs'], data['wall_time'], data['max_rss']))
+        for title in ('phases', 'counters'):
+            for name in sorted(data[title]):
+                print('  %-40s %16d' % (name, data[title][name]))
+        print()
+
+    if summary['slowest']:
+        print('slowest frontend jobs:')
+        for job in summary['slowest']:
+            print('  %-40s %16d' % (job['name'], job['wall_time']))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Summarize the statistics written to a -stats-output-dir.')
+    parser.add_argument('dir', help='the -stats-output-dir of a build')
+    parser.add_argument('--json', action='store_true',
+                        help='print the summary as JSON')
+    parser.add_argument('--slowest', type=int, default=10,
+                        help='the number of slowest frontend jobs to list '
+                             '(default: 10)')
+    args = parser.parse_args()
+
+    summary = summarize(list(load_stats(args.dir)), args.slowest)
+    if args.json:
+        print(json.dumps(summary, indent=2, sort_keys=True))
+    else:
+        print_table(summary)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,74 @@
+#include "swift/Basic/ClusteredBitVector.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+
+using namespace swift;
+
+/// Run the given operation N times, a few rounds over, and print the time
+/// per iteration of the fastest round.
+template <class Fn>
+static void measure(const char *name, unsigned n, Fn &&fn) {
+  double best = 0;
+  size_t sink = 0;
+  for (unsigned round = 0; round != 5; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i != n; ++i)
+      sink += fn(i);
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+    if (round == 0 || elapsed.count() < best)
+      best = elapsed.count();
+  }
+  llvm::outs() << name << ": " << best * 1e9 / n << " ns/iter"
+               << " (checksum " << sink << ")\n";
+}
+
+int main() {
+  const unsigned N = 200000;
+
+  // Layouts of enum payloads: runs of spare and occupied bits.
+  measure("append constant runs", N, [](unsigned i) {
+    ClusteredBitVector vec;
+    for (unsigned j = 0; j != 16; ++j) {
+      vec.appendClearBits(8 + (i + j) % 57);
+      vec.appendSetBits(3 + (i * j) % 29);
+    }
+    return vec.count();
+  });
+
+  ClusteredBitVector pattern;
+  for (unsigned j = 0; j != 32; ++j) {
+    pattern.appendClearBits(j + 1);
+    pattern.appendSetBits(33 - j);
+  }
+
+  measure("append vector", N, [&](unsigned i) {
+    ClusteredBitVector vec;
+    vec.appendClearBits(i % 64);
+    vec.append(pattern);
+    vec.append(pattern);
+    return vec.size();
+  });
+
+  measure("and/or/==", N, [&](unsigned i) {
+    ClusteredBitVector vec = pattern;
+    vec.flipAll();
+    vec |= pattern;
+    vec &= pattern;
+    return size_t(vec == pattern);
+  });
+
+  llvm::APInt bits = pattern.asAPInt();
+  measure("fromAPInt", N, [&](unsigned i) {
+    return ClusteredBitVector::fromAPInt(bits).count();
+  });
+
+  measure("enumerate set bits", N, [&](unsigned i) {
+    size_t sum = 0;
+    auto enumerator = pattern.enumerateSetBits();
+    while (auto next = enumerator.findNext())
+      sum += *next;
+    return sum;
+  });
+}